@@ -0,0 +1,54 @@
+// $geoNear over a 2dsphere index streams its results in batches rather than taking them from one
+// geoNear command reply, so it isn't limited to what fits in 16MB.  A $match right after it is
+// applied by the $geoNear, after its limit, as before.
+
+var t = db.jstests_aggregation_geonear_streaming;
+t.drop();
+
+var padding = new Array(1024).join("x");
+for (var i = 0; i < 20000; i++) {
+    t.insert({_id: i, loc: [(i % 200) / 10, Math.floor(i / 200) / 10], b: i % 3, pad: padding});
+}
+t.ensureIndex({loc: "2dsphere"});
+assert.eq(null, db.getLastError());
+
+function explain(pipeline) {
+    var explained = t.runCommand("aggregate", {pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    return explained.stages;
+}
+
+function stageNames(stages) {
+    return stages.map(function(stage) { return Object.keySet(stage)[0]; });
+}
+
+var geoNear = {$geoNear: {near: [0, 0], distanceField: "dis", spherical: true, limit: 20000}};
+
+// about 20MB of documents, nearest first across the batches
+var res = t.aggregate([geoNear, {$project: {_id: 0, dis: 1}}]);
+assert.commandWorked(res);
+assert.eq(20000, res.result.length);
+for (var i = 1; i < res.result.length; i++) {
+    assert.lte(res.result[i - 1].dis, res.result[i].dis, "out of order at " + i);
+}
+
+// the limit still applies before the $match, which the $geoNear takes over
+geoNear.$geoNear.limit = 100;
+var pipeline = [geoNear, {$match: {b: 1}}, {$project: {_id: 1}}];
+var stages = explain(pipeline);
+assert.eq(["$geoNear", "$project"], stageNames(stages));
+assert.eq({b: 1}, stages[0].$geoNear.filter);
+
+var expected = [];
+t.runCommand("geoNear", {near: [0, 0], spherical: true, num: 100}).results.forEach(function(r) {
+    if (r.obj.b == 1)
+        expected.push({_id: r.obj._id});
+});
+assert.eq(expected, t.aggregate(pipeline).result);
+
+// a $match on the distance stays a stage of its own
+pipeline = [geoNear, {$match: {b: 1, dis: {$lt: 0.01}}}, {$project: {_id: 1}}];
+assert.eq(["$geoNear", "$match", "$project"], stageNames(explain(pipeline)));
+assert.gt(t.aggregate(pipeline).result.length, 0);
+
+t.drop();
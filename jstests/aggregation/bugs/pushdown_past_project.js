@@ -0,0 +1,75 @@
+// $match, $sort, $skip and $limit move ahead of $project, and $match ahead of $unwind, so that
+// they can reach the query of the initial $cursor.
+
+var t = db.jstests_aggregation_pushdown_past_project;
+t.drop();
+
+for (var i = 0; i < 20; i++) {
+    t.save({_id: i, a: i % 5, b: i, c: [i, i + 1], d: {e: i}});
+}
+t.ensureIndex({b: 1});
+
+function explain(pipeline) {
+    var explained = t.runCommand("aggregate", {pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    return explained.stages;
+}
+
+function stageNames(stages) {
+    return stages.map(function(stage) { return Object.keySet(stage)[0]; });
+}
+
+// nothing moves past a $redact, and this one passes its input through unchanged, so putting it
+// after the first stage gives the results of the pipeline as written
+function assertSameResults(pipeline) {
+    var plain = [pipeline[0], {$redact: "$$DESCEND"}].concat(pipeline.slice(1));
+    assert.eq(t.aggregate(plain).result, t.aggregate(pipeline).result, tojson(pipeline));
+}
+
+// a $match on included and renamed fields reaches the query, renamed
+var pipeline = [{$project: {x: "$a", b: 1}}, {$match: {x: 2, b: {$gt: 5}}}];
+var stages = explain(pipeline);
+assert.eq(["$cursor", "$project"], stageNames(stages));
+assert.eq({a: 2, b: {$gt: 5}}, stages[0].$cursor.query);
+assertSameResults(pipeline);
+
+// a $match on a computed field stays behind the $project; the rest moves
+pipeline = [{$project: {b: 1, y: {$add: ["$a", 1]}}}, {$match: {y: 3, b: {$lt: 10}}}];
+stages = explain(pipeline);
+assert.eq(["$cursor", "$project", "$match"], stageNames(stages));
+assert.eq({b: {$lt: 10}}, stages[0].$cursor.query);
+assert.eq({y: 3}, stages[2].$match);
+assertSameResults(pipeline);
+
+// a $match on a field the $project drops can't move: it would see a different document
+pipeline = [{$project: {b: 1}}, {$match: {a: null}}];
+stages = explain(pipeline);
+assert.eq(["$cursor", "$project", "$match"], stageNames(stages));
+assertSameResults(pipeline);
+
+// a renamed dotted path is not an exact copy
+pipeline = [{$project: {e: "$d.e"}}, {$match: {e: 4}}];
+stages = explain(pipeline);
+assert.eq(["$cursor", "$project", "$match"], stageNames(stages));
+assertSameResults(pipeline);
+
+// $skip and $limit move ahead of the $project, and the $limit into the cursor
+pipeline = [{$project: {b: 1}}, {$skip: 3}, {$limit: 4}];
+stages = explain(pipeline);
+assert.eq(["$cursor", "$skip", "$project"], stageNames(stages));
+assert.eq(7, stages[0].$cursor.limit);
+assertSameResults(pipeline);
+
+// a $sort on a renamed field moves ahead of the $project and into the query
+pipeline = [{$project: {x: "$b"}}, {$sort: {x: -1}}, {$limit: 3}];
+stages = explain(pipeline);
+assert.eq({b: -1}, stages[0].$cursor.sort);
+assertSameResults(pipeline);
+
+// a $match moves ahead of an $unwind, except for predicates on the unwound field
+pipeline = [{$unwind: "$c"}, {$match: {a: 1, c: {$gt: 10}}}];
+stages = explain(pipeline);
+assert.eq(["$cursor", "$unwind", "$match"], stageNames(stages));
+assert.eq({a: 1}, stages[0].$cursor.query);
+assert.eq({c: {$gt: 10}}, stages[2].$match);
+assertSameResults(pipeline);
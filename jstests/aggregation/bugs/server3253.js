@@ -35,6 +35,14 @@ test([{$project: {a: {$multiply: ['$_id', '$_id']}}}],
      [{_id:1, a:1},{_id:2, a:4},{_id:3, a:9}]);
 assert.eq(output.getIndexes().length, 2);
 
+// indexes are built after the data is loaded, so a unique index violation fails the index copy
+// and leaves the old output in place
+output.dropIndex({a:1});
+output.ensureIndex({a:1}, {unique: true});
+assertErrorCode(input, [{$project: {a: {$literal: 1}}}, {$out: output.getName()}], 16995);
+assert.eq(output.find().toArray(), [{_id:1, a:1},{_id:2, a:4},{_id:3, a:9}]);
+assert.eq(output.getIndexes().length, 2);
+
 // test with capped collection
 output.drop();
 db.createCollection(output.getName(), {capped: true, size: 2});
@@ -194,6 +194,22 @@ testSortLimit(10, -1);
 testSortLimit(100,  1);
 testSortLimit(100, -1);
 
+// test sort without a limit: each shard sorts and the merger only merges the sorted results
+function testSortMerge(direction) {
+    var pipeline = [{$project: {random:1, _id:0}}, {$sort: {random: direction}}];
+    var explained = db.runCommand({aggregate: "ts1", pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    var shardsPart = explained.splitPipeline.shardsPart;
+    assert.eq({random: direction}, shardsPart[shardsPart.length - 1].$sort.sortKey);
+    assert.eq(true, explained.splitPipeline.mergerPart[0].$sort.mergePresorted);
+
+    var from_cursor = db.ts1.find({},{random:1, _id:0}).sort({random: direction}).toArray();
+    var from_agg = db.ts1.aggregate(pipeline).result;
+    assert.eq(from_cursor, from_agg);
+}
+testSortMerge(1);
+testSortMerge(-1);
+
 // test $out by copying source collection verbatim to output
 var outCollection = db.ts1_out;
 var res = db.ts1.aggregate({$out: outCollection.getName()});
@@ -0,0 +1,28 @@
+// Tests the flush and writeback histograms in serverStatus.backgroundFlushing and that paced
+// background flushing can be switched off at runtime.
+
+var adminDB = db.getSiblingDB("admin");
+
+var bf = adminDB.runCommand({serverStatus: 1}).backgroundFlushing;
+assert(bf, "no backgroundFlushing section");
+
+["flush_ms", "writeBack_ms"].forEach(function(name) {
+    var h = bf[name];
+    assert(h, name + " missing: " + tojson(bf));
+    assert(h["0-10"] !== undefined, tojson(h));
+    assert(h["10241+"] !== undefined, tojson(h));
+
+    var total = 0;
+    for (var bucket in h) {
+        total += h[bucket];
+    }
+    if (name == "flush_ms") {
+        assert.eq(bf.flushes, total, tojson(bf));
+    }
+});
+assert(bf.writeBack_bytes !== undefined, tojson(bf));
+
+var old = adminDB.runCommand({setParameter: 1, pacedBackgroundFlush: false});
+assert.commandWorked(old);
+assert.eq(true, old.was);
+assert.commandWorked(adminDB.runCommand({setParameter: 1, pacedBackgroundFlush: old.was}));
@@ -82,9 +82,21 @@ var doTest = function () {
         // Check that we get both workingSet and indexCounters and that all expected
         // fields are present with no unexpected fields
         //
+        // The recency windows are cumulative and the last one covers every tracked page
+        var recency = workingSet_1.recency;
+        assert.gt(recency.length, 0, tojson(workingSet_1));
+        for (var i = 1; i < recency.length; ++i) {
+            assert.gt(recency[i].seconds, recency[i - 1].seconds, tojson(recency));
+            assert.gte(recency[i].pages, recency[i - 1].pages, tojson(recency));
+        }
+        assert.eq(workingSet_1.pagesInMemory, recency[recency.length - 1].pages,
+                  tojson(workingSet_1));
+        assert.eq('object', typeof workingSet_1.pagesByDatabase, tojson(workingSet_1));
+
         testExpectedFields('db.serverStatus({workingSet:1}).workingSet',
                            workingSet_1,
-                           ['note', 'pagesInMemory', 'computationTimeMicros', 'overSeconds']);
+                           ['note', 'pagesInMemory', 'recency', 'pagesByDatabase',
+                            'computationTimeMicros', 'overSeconds']);
         testExpectedFields('db.serverStatus().indexCounters',
                            indexCounters_1,
                            ['accesses', 'hits', 'misses', 'resets', 'missRatio']);
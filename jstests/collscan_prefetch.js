@@ -0,0 +1,25 @@
+// Collection scans that prefetch the extents ahead of them return the same documents.
+
+t = db.jstests_collscan_prefetch;
+t.drop();
+
+var s = new Array(512).join("x");
+for (var i = 0; i < 20000; i++) {
+    t.insert({_id: i, s: s});
+}
+assert.isnull(db.getLastError());
+assert.gt(t.stats().numExtents, 3);
+
+assert.eq(20000, t.find().addSpecial("$prefetchExtents", 2).itcount());
+assert.eq(20000, t.find().sort({$natural: -1}).addSpecial("$prefetchExtents", 3).itcount());
+assert.eq(1, t.find({_id: 19999}).addSpecial("$prefetchExtents", 1).itcount());
+
+var old = db.adminCommand({getParameter: 1, collectionScanPrefetchExtents: 1});
+assert.commandWorked(old);
+assert.commandWorked(db.adminCommand({setParameter: 1, collectionScanPrefetchExtents: 2}));
+assert.eq(20000, t.find().itcount());
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      collectionScanPrefetchExtents:
+                                          old.collectionScanPrefetchExtents}));
+
+assert.throws(function() { t.find().addSpecial("$prefetchExtents", -1).itcount(); });
@@ -0,0 +1,39 @@
+// Incremental compaction moves the records out of the sparsest extents and frees them, leaving
+// the documents and their index entries intact.
+
+t = db.jstests_compact_incremental;
+t.drop();
+t.ensureIndex({x: 1});
+
+var big = new Array(1000).join("a");
+for (var i = 0; i < 20000; i++) {
+    t.insert({_id: i, x: i % 100, s: big});
+}
+// thin out the collection, leaving most extents sparse
+t.remove({_id: {$mod: [10, 1]}});
+t.remove({_id: {$mod: [10, 2]}});
+t.remove({_id: {$mod: [10, 3]}});
+t.remove({_id: {$mod: [10, 4]}});
+t.remove({_id: {$mod: [10, 5]}});
+t.remove({_id: {$mod: [10, 6]}});
+t.remove({_id: {$mod: [10, 7]}});
+assert.isnull(db.getLastError());
+var count = t.count();
+var before = t.stats();
+
+var res = db.runCommand({incrementalCompact: t.getName(), maxFill: 0.5, batchSize: 50});
+assert.commandWorked(res);
+assert.gt(res.extentsDrained, 0, tojson(res));
+assert.gt(res.extentsFreed, 0, tojson(res));
+assert.gt(res.recordsMoved, 0, tojson(res));
+
+var after = t.stats();
+assert.eq(count, after.count);
+assert.gt(before.numExtents, after.numExtents);
+assert.eq(count, t.find().hint({_id: 1}).itcount());
+assert.eq(count, t.find({x: {$gte: 0}}).hint({x: 1}).itcount());
+assert.eq(count / 100, t.find({x: 10}).itcount());
+assert(t.validate(true).valid);
+
+assert.commandFailed(db.runCommand({incrementalCompact: t.getName(), maxFill: 2}));
+assert.commandFailed(db.runCommand({incrementalCompact: "jstests_compact_incremental_missing"}));
@@ -0,0 +1,49 @@
+// Tests that dbhash caches the hash of every collection until a document of it is written.
+
+var mydb = db.getSisterDB( "dbhash_cache" );
+mydb.dropDatabase();
+
+var a = mydb.a;
+var b = mydb.b;
+a.insert( { _id : 1, x : 1 } );
+b.insert( { _id : 1, x : 1 } );
+assert.eq( null, mydb.getLastError() );
+
+var res1 = mydb.runCommand( "dbhash" );
+assert.commandWorked( res1 );
+assert.eq( -1, res1.fromCache.indexOf( "dbhash_cache.a" ), tojson( res1 ) );
+
+var res2 = mydb.runCommand( "dbhash" );
+assert.neq( -1, res2.fromCache.indexOf( "dbhash_cache.a" ), tojson( res2 ) );
+assert.neq( -1, res2.fromCache.indexOf( "dbhash_cache.b" ), tojson( res2 ) );
+assert.eq( res1.md5, res2.md5 );
+
+// an in place update invalidates only its own collection
+a.update( { _id : 1 }, { $inc : { x : 1 } } );
+assert.eq( null, mydb.getLastError() );
+var res3 = mydb.runCommand( "dbhash" );
+assert.eq( -1, res3.fromCache.indexOf( "dbhash_cache.a" ), tojson( res3 ) );
+assert.neq( -1, res3.fromCache.indexOf( "dbhash_cache.b" ), tojson( res3 ) );
+assert.neq( res1.collections.a, res3.collections.a );
+assert.eq( res1.collections.b, res3.collections.b );
+
+b.remove( { _id : 1 } );
+assert.eq( null, mydb.getLastError() );
+var res4 = mydb.runCommand( "dbhash" );
+assert.eq( -1, res4.fromCache.indexOf( "dbhash_cache.b" ), tojson( res4 ) );
+assert.neq( res1.collections.b, res4.collections.b );
+
+// a collection recreated with the same documents is hashed again
+b.drop();
+b.insert( { _id : 1, x : 1 } );
+assert.eq( null, mydb.getLastError() );
+var res5 = mydb.runCommand( "dbhash" );
+assert.eq( -1, res5.fromCache.indexOf( "dbhash_cache.b" ), tojson( res5 ) );
+assert.eq( res1.collections.b, res5.collections.b );
+
+// only the listed collections
+var res6 = mydb.runCommand( { dbhash : 1, collections : [ "a" ] } );
+assert.eq( res3.collections.a, res6.collections.a );
+assert.eq( undefined, res6.collections.b );
+
+mydb.dropDatabase();
@@ -0,0 +1,29 @@
+// Tests that mongod records its working set at shutdown and warms it up after a restart.
+
+var baseName = "jstests_disk_warm_up";
+var dbpath = "/data/db/" + baseName;
+
+var m = startMongod( "--port", "27018", "--dbpath", dbpath, "--nohttpinterface" );
+var t = m.getDB( baseName ).t;
+for ( var i = 0; i < 1000; i++ ) {
+    t.insert( { _id : i, x : new Array( 1000 ).join( "x" ) } );
+}
+assert.eq( null, t.getDB().getLastError() );
+assert.eq( 1000, t.find().itcount() );
+stopMongod( 27018 );
+
+var snapshot = listFiles( dbpath ).filter( function( f ) {
+    return f.name.indexOf( "workingSet.bson" ) != -1 && f.name.indexOf( ".tmp" ) == -1;
+} );
+assert.eq( 1, snapshot.length, tojson( listFiles( dbpath ) ) );
+assert.gt( snapshot[0].size, 0 );
+
+// the warm-up opens the database without being asked to
+m = startMongoProgram( "mongod", "--port", "27018", "--dbpath", dbpath, "--nohttpinterface" );
+assert.soon( function() {
+    var log = m.getDB( "admin" ).runCommand( { getLog : "global" } ).log;
+    return log.some( function( line ) { return line.indexOf( "warm-up read" ) != -1; } );
+}, "warm-up didn't finish" );
+assert.eq( 1000, m.getDB( baseName ).t.count() );
+
+stopMongod( 27018 );
@@ -0,0 +1,35 @@
+// Distinct over an index led by the distinct key skips past all of the keys of each value.
+
+t = db.jstests_distinct_skip_scan;
+t.drop();
+
+for ( var i = 0; i < 3000; i++ ) {
+    t.save( { a : i % 3 , b : i % 7 , c : i } );
+}
+t.ensureIndex( { a : 1 , b : 1 } );
+
+function d( k , q ) {
+    var res = t.runCommand( "distinct" , { key : k , query : q || {} } );
+    assert.commandWorked( res );
+    return res;
+}
+
+x = d( "a" );
+assert.eq( [ 0 , 1 , 2 ] , x.values.sort() , "A1" );
+assert.eq( 3 , x.stats.nscanned , "A2" );
+assert.eq( 0 , x.stats.nscannedObjects , "A3" );
+
+// With a query, each value is skipped past once its first matching key is found.
+x = d( "a" , { a : { $gte : 1 } , b : 5 } );
+assert.eq( [ 1 , 2 ] , x.values.sort() , "B1" );
+assert.gt( 1000 , x.stats.nscanned , "B2" );
+
+// The distinct key is not the leading index field, so no keys are skipped.
+x = d( "b" );
+assert.eq( [ 0 , 1 , 2 , 3 , 4 , 5 , 6 ] , x.values.sort() , "C1" );
+assert.eq( 3000 , x.stats.nscanned , "C2" );
+
+// A multikey index is not skip scanned.
+t.save( { a : [ 0 , 3 ] , b : 0 } );
+x = d( "a" , { a : { $gte : 0 } } );
+assert.eq( [ 0 , 1 , 2 , 3 ] , x.values.sort() , "D1" );
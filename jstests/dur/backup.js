@@ -0,0 +1,57 @@
+// fsync with backup copies the data files while writes go on, then the journal written meanwhile.
+// A mongod started on the copy recovers it to a consistent state holding every write acknowledged
+// before the backup returned.
+
+var path = "/data/db/dur_backup";
+var backupPath = "/data/db/dur_backup_copy";
+resetDbpath(backupPath);
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles");
+var t = conn.getDB("test").foo;
+
+var x = new Array(1024).join("x");
+for (var i = 0; i < 20000; i++) {
+    t.insert({ _id : i, x : x });
+}
+t.ensureIndex({ a : 1 });
+assert.eq(null, t.getDB().getLastError());
+
+// keep writing until told to stop
+var writer = startParallelShell(
+    "var t = db.getSiblingDB('test').foo;" +
+    "for (var i = 100000; !db.getSiblingDB('test').stop.findOne(); i++) {" +
+    "    t.insert({ _id : i, a : i });" +
+    "    t.update({ _id : i - 100000 }, { $set : { a : i } });" +
+    "}", 30001);
+
+// wait for the writer to get going
+assert.soon(function() { return t.count() > 20100; });
+
+var admin = conn.getDB("admin");
+assert.commandFailed(admin.runCommand({ fsync : 1, backup : path + "/inside" }));
+assert.commandFailed(admin.runCommand({ fsync : 1, backup : backupPath, lock : true }));
+
+var res = admin.runCommand({ fsync : 1, backup : backupPath });
+assert.commandWorked(res);
+assert.gt(res.numFiles, 0);
+assert.gt(res.journalFiles, 0);
+var countAfter = t.count();
+
+// a backup directory is only written once
+assert.commandFailed(admin.runCommand({ fsync : 1, backup : backupPath }));
+
+t.getDB().stop.insert({});
+writer();
+stopMongod(30001);
+
+var copy = startMongodNoReset("--port", 30002, "--dbpath", backupPath, "--dur", "--smallfiles");
+var c = copy.getDB("test").foo;
+assert.gte(c.count(), 20100);
+assert.lte(c.count(), countAfter);
+for (var i = 0; i < 20000; i += 997) {
+    assert.eq(x, c.findOne({ _id : i }).x, "document " + i);
+}
+var v = c.validate(true);
+assert(v.valid, tojson(v));
+assert.eq(c.count(), c.find().hint({ a : 1 }).itcount());
+stopMongod(30002);
@@ -0,0 +1,42 @@
+// Tests that getLastError j:true commits the journal on demand rather than waiting for the
+// journal commit interval, and that concurrent j:true writers share commits.
+
+var mongo = MongoRunner.runMongod({journal: "", smallfiles: "", journalCommitInterval: 300});
+var testDB = mongo.getDB("test");
+
+function avgJournaledWriteMillis(n) {
+    var start = new Date();
+    for (var i = 0; i < n; i++) {
+        testDB.group_commit.insert({i: i});
+        assert.isnull(testDB.getLastErrorObj(1, 0, true).err);
+    }
+    return (new Date() - start) / n;
+}
+
+// one waiter is enough to commit at once, well within a third of the interval
+var millis = avgJournaledWriteMillis(50);
+print("group_commit.js: " + millis + "ms per j:true write");
+assert.lt(millis, 60, "j:true waited for the commit interval");
+
+// several writers committing together
+var joins = [];
+for (var t = 0; t < 4; t++) {
+    joins.push(startParallelShell(
+        "var testDB = db.getSiblingDB('test');" +
+        "for (var i = 0; i < 50; i++) {" +
+        "    testDB.group_commit.insert({t: " + t + ", i: i});" +
+        "    assert.isnull(testDB.getLastErrorObj(1, 0, true).err);" +
+        "}",
+        mongo.port));
+}
+joins.forEach(function(join) { join(); });
+assert.eq(250, testDB.group_commit.count());
+
+// with more waiters required than there are writers, j:true falls back to waiting a third of the
+// interval
+assert.commandWorked(testDB.adminCommand({setParameter: 1, journalCommitWaiters: 100}));
+millis = avgJournaledWriteMillis(5);
+assert.gte(millis, 60, "j:true did not wait for the commit interval");
+assert.commandWorked(testDB.adminCommand({setParameter: 1, journalCommitWaiters: 1}));
+
+MongoRunner.stopMongod(mongo);
@@ -0,0 +1,34 @@
+// Tests recovering a journal holding writes to several databases with journalRecoveryThreads,
+// so that the writes to different data files are applied in parallel.
+
+var path = "/data/db/parallel_recover";
+var numDBs = 4;
+var numDocs = 2000;
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--journal", "--smallfiles",
+                            "--journalOptions", 8 /*DurParanoid*/);
+for (var d = 0; d < numDBs; d++) {
+    var testDB = conn.getDB("parallel_recover" + d);
+    for (var i = 0; i < numDocs; i++) {
+        testDB.foo.insert({_id: i, d: d, s: "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"});
+        if (i % 10 == 0) {
+            testDB.foo.update({_id: i}, {$set: {u: i}});
+        }
+    }
+    testDB.foo.ensureIndex({u: 1});
+    assert.isnull(testDB.getLastError());
+}
+printjson(conn.getDB("admin").runCommand({getlasterror: 1, j: true}));
+
+// kill the process hard so that recovery has work to do
+stopMongod(30001, /*signal*/9);
+
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--journal", "--smallfiles",
+                          "--setParameter", "journalRecoveryThreads=4");
+for (var d = 0; d < numDBs; d++) {
+    var coll = conn.getDB("parallel_recover" + d).foo;
+    assert.eq(numDocs, coll.count(), "db " + d);
+    assert.eq(numDocs / 10, coll.find({u: {$exists: true}}).hint({u: 1}).itcount(), "db " + d);
+    assert(coll.validate().valid, "db " + d);
+}
+stopMongod(30002);
@@ -0,0 +1,22 @@
+// Tests the fileAllocator section of serverStatus.
+
+var testDB = db.getSiblingDB("file_allocator_stats");
+testDB.dropDatabase();
+
+var before = testDB.serverStatus().fileAllocator;
+assert(before, "no fileAllocator section in serverStatus");
+["allocations", "bytesAllocated", "allocationMillis", "pending", "waits", "waitMillis"].forEach(
+    function(field) {
+        assert.gte(before[field], 0, field + " missing: " + tojson(before));
+    });
+
+// creating a database allocates at least its .0 file, for which the writer waited
+testDB.foo.insert({x: 1});
+assert.isnull(testDB.getLastError());
+
+var after = testDB.serverStatus().fileAllocator;
+assert.gt(after.allocations, before.allocations, tojson(after));
+assert.gt(after.bytesAllocated, before.bytesAllocated, tojson(after));
+assert.gte(after.waits, before.waits, tojson(after));
+
+testDB.dropDatabase();
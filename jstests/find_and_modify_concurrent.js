@@ -0,0 +1,42 @@
+// findAndModify finds its document under a read lock and re-checks it under the write lock.
+// Concurrent callers claiming from the same queue must each get a different document.
+
+t = db.jstests_find_and_modify_concurrent;
+t.drop();
+
+for( i = 0; i < 400; ++i ) {
+    t.save( { _id:i, state:'ready', pri:i % 7 } );
+}
+db.getLastError();
+
+claim = 'var claimed = 0;                                                                ' +
+        'while( 1 ) {                                                                    ' +
+        '    var doc = db.jstests_find_and_modify_concurrent.findAndModify(              ' +
+        '        { query:{ state:"ready" }, update:{ $set:{ state:"taken" },             ' +
+        '                                            $inc:{ claims:1 } } } );            ' +
+        '    if ( !doc ) break;                                                          ' +
+        '    assert.eq( "ready", doc.state );                                            ' +
+        '    ++claimed;                                                                  ' +
+        '}                                                                               ' +
+        'print( "claimed " + claimed );                                                  ';
+sortedClaim = claim.replace( '{ query:{ state:"ready" },', '{ query:{ state:"ready" }, sort:{ pri:-1 },' );
+
+p1 = startParallelShell( claim );
+p2 = startParallelShell( sortedClaim );
+p3 = startParallelShell( claim );
+p4 = startParallelShell( sortedClaim );
+p1(); p2(); p3(); p4();
+
+assert.eq( 0, t.count( { state:'ready' } ) );
+assert.eq( 400, t.count( { state:'taken', claims:1 } ) );
+
+// nothing left to claim, with and without a sort
+assert.isnull( t.findAndModify( { query:{ state:'ready' }, update:{ $set:{ state:'taken' } } } ) );
+assert.isnull( t.findAndModify( { query:{ state:'ready' }, sort:{ pri:1 }, remove:true } ) );
+
+// removal of claimed documents
+p1 = startParallelShell( 'while( db.jstests_find_and_modify_concurrent.findAndModify( ' +
+                         '    { query:{ state:"taken" }, remove:true } ) );' );
+while( t.findAndModify( { query:{ state:'taken' }, sort:{ pri:1 }, remove:true } ) );
+p1();
+assert.eq( 0, t.count() );
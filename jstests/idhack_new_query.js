@@ -0,0 +1,40 @@
+// Exact _id matches are answered by the new query framework's _id fast path, with or without a
+// projection, and anything more than that goes through the planner.
+
+var t = db.idhack_new_query;
+t.drop();
+
+t.insert({ _id : 1, a : 1, b : 1 });
+t.insert({ _id : { x : 2 }, a : 2, b : 2 });
+t.ensureIndex({ a : 1 });
+
+var old = db.adminCommand({ setParameter : 1, newQueryFrameworkEnabled : true });
+assert.commandWorked(old);
+
+var idhackCount = function() {
+    return db.serverStatus().metrics.operation.idhack;
+};
+
+try {
+    var before = idhackCount();
+    assert.eq({ _id : 1, a : 1, b : 1 }, t.findOne({ _id : 1 }));
+    assert.eq({ _id : { x : 2 }, a : 2, b : 2 }, t.findOne({ _id : { x : 2 } }));
+    assert.eq(null, t.findOne({ _id : 3 }));
+    assert.eq(before + 3, idhackCount());
+
+    // projections are applied to the fetched document
+    assert.eq({ _id : 1, a : 1 }, t.findOne({ _id : 1 }, { a : 1 }));
+    assert.eq({ a : 1 }, t.findOne({ _id : 1 }, { _id : 0, a : 1 }));
+    assert.eq({ _id : 1, a : 1 }, t.findOne({ _id : 1 }, { b : 0 }));
+    assert.eq(1, t.find({ _id : 1 }).itcount());
+
+    // skip, explain and ranges on _id take the regular path
+    before = idhackCount();
+    assert.eq(0, t.find({ _id : 1 }).skip(1).itcount());
+    assert.eq(1, t.find({ _id : 1 }).explain().n);
+    assert.eq(1, t.find({ _id : { $gte : 1 } }).itcount());
+    assert.eq(before, idhackCount());
+}
+finally {
+    db.adminCommand({ setParameter : 1, newQueryFrameworkEnabled : old.was });
+}
@@ -0,0 +1,56 @@
+// A large $in on an indexed field gives the same results as without the index, including
+// with duplicate values, null, a descending index and a compound index.
+
+var t = db.jstests_in_large_list;
+var u = db.jstests_in_large_list_noindex;
+t.drop();
+u.drop();
+
+for (var i = 0; i < 2000; i++) {
+    var doc = { a : i, b : i % 7 };
+    t.insert(doc);
+    u.insert(doc);
+}
+t.insert({ b : 1 });
+u.insert({ b : 1 });
+t.insert({ a : null, b : 2 });
+u.insert({ a : null, b : 2 });
+
+var values = [];
+for (var i = 4000; i >= 0; i -= 3) {
+    values.push(i);
+    values.push(i); // duplicates
+}
+values.push("x");
+
+function check(query, sort) {
+    var expected = u.find(query).sort(sort).toArray();
+    var actual = t.find(query).sort(sort).toArray();
+    assert.eq(expected.length, actual.length, tojson(query));
+    for (var i = 0; i < expected.length; i++) {
+        assert.eq(expected[i]._id, actual[i]._id, tojson(query));
+    }
+}
+
+function checkAll() {
+    check({ a : { $in : values } }, { _id : 1 });
+    check({ a : { $in : values } }, { a : 1, _id : 1 });
+    check({ a : { $in : values }, b : { $in : [ 1, 3, 5 ] } }, { _id : 1 });
+    check({ a : { $in : values.concat([ null ]) } }, { _id : 1 });
+    check({ a : { $in : [] } }, { _id : 1 });
+}
+
+t.ensureIndex({ a : 1 });
+checkAll();
+t.dropIndexes();
+
+t.ensureIndex({ a : -1 });
+checkAll();
+t.dropIndexes();
+
+t.ensureIndex({ a : 1, b : 1 });
+checkAll();
+t.dropIndexes();
+
+t.ensureIndex({ b : 1, a : -1 });
+checkAll();
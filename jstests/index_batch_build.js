@@ -0,0 +1,40 @@
+// Index specs inserted into system.indexes together are built together, from one collection scan.
+
+var t = db.index_batch_build;
+t.drop();
+
+for (var i = 0; i < 1000; i++) {
+    t.insert({ a : i, b : -i, c : [ i, i + 1 ], d : i % 10 });
+}
+assert.eq(null, db.getLastError());
+
+var spec = function(key, name, extra) {
+    return Object.extend({ ns : t.getFullName(), key : key, name : name }, extra || {});
+};
+
+db.system.indexes.insert([ spec({ a : 1 }, "a_1"),
+                           spec({ b : -1 }, "b_-1"),
+                           spec({ c : 1 }, "c_1"),
+                           spec({ a : 1, d : 1 }, "a_1_d_1") ]);
+assert.eq(null, db.getLastError());
+assert.eq(5, t.getIndexes().length, tojson(t.getIndexes()));
+
+assert.eq(1000, t.find().hint({ a : 1 }).itcount());
+assert.eq(1000, t.find().hint({ b : -1 }).itcount());
+assert.eq(1000, t.find().hint({ a : 1, d : 1 }).itcount());
+// the multikey index has a key per array element
+assert.eq(2, t.find({ c : 5 }).hint({ c : 1 }).itcount());
+assert(t.find({ c : 5 }).hint({ c : 1 }).explain().isMultiKey);
+assert(!t.find({ a : 5 }).hint({ a : 1 }).explain().isMultiKey);
+
+// a unique index that can't be built takes the rest of its batch with it
+db.system.indexes.insert([ spec({ e : 1 }, "e_1"),
+                           spec({ d : 1 }, "d_1", { unique : true }) ]);
+assert.neq(null, db.getLastError());
+assert.eq(5, t.getIndexes().length, tojson(t.getIndexes()));
+
+// new documents are indexed by all of them
+t.insert({ a : 2000, b : -2000, c : [ 2000 ], d : 0 });
+assert.eq(1001, t.find().hint({ b : -1 }).itcount());
+
+t.drop();
@@ -0,0 +1,42 @@
+// Tests resizing the read and write ticket pools which admit operations to the locks, and that
+// the pools are reported in serverStatus.
+
+var admin = db.getSiblingDB("admin");
+var old = admin.runCommand({getParameter: 1, readTickets: 1, writeTickets: 1});
+assert.commandWorked(old);
+
+var tickets = db.serverStatus().globalLock.tickets;
+assert.eq(old.readTickets, tickets.read.totalTickets, tojson(tickets));
+assert.eq(old.writeTickets, tickets.write.totalTickets, tojson(tickets));
+// this very command holds a read ticket while it reports
+assert.gte(tickets.read.out, 1, tojson(tickets));
+assert.eq(0, tickets.read.queued, tojson(tickets));
+
+assert.commandFailed(admin.runCommand({setParameter: 1, writeTickets: 0}));
+assert.commandFailed(admin.runCommand({setParameter: 1, readTickets: "a lot"}));
+
+// a single ticket serializes operations but still lets each of them through
+assert.commandWorked(admin.runCommand({setParameter: 1, readTickets: 1, writeTickets: 1}));
+var t = db.lock_tickets;
+t.drop();
+var join = startParallelShell("for (var i = 0; i < 200; i++) {" +
+                              "    db.lock_tickets.insert({i: i});" +
+                              "    db.lock_tickets.findOne({i: i});" +
+                              "}" +
+                              "db.getLastError();");
+for (var i = 0; i < 200; i++) {
+    t.insert({j: i});
+    t.find({j: i}).itcount();
+}
+db.getLastError();
+join();
+assert.eq(400, t.count());
+
+tickets = db.serverStatus().globalLock.tickets;
+assert.eq(1, tickets.read.totalTickets, tojson(tickets));
+assert.eq(1, tickets.write.totalTickets, tojson(tickets));
+
+assert.commandWorked(admin.runCommand({setParameter: 1,
+                                       readTickets: old.readTickets,
+                                       writeTickets: old.writeTickets}));
+t.drop();
@@ -0,0 +1,56 @@
+// Map and reduce functions of the forms mapReduce runs without javascript give the same
+// results as equivalent functions that run in javascript.
+
+t = db.mr_native;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ ) {
+    t.save( { a : i % 17 , b : i , c : NumberInt( i % 5 ) } );
+}
+// values the native map hands to javascript
+t.save( { a : [ 1 , 2 ] , b : 1 } );
+t.save( { a : { x : 1 } , b : 2 } );
+t.save( { a : 3 , b : "str" } );
+t.save( { a : 4 } );
+t.save( { b : 5 } );
+
+function nativeMap() { emit( this.a , this.b ); }
+function jsMap() { var a = this.a; emit( a , this.b ); }
+
+function nativeConstMap() { emit( this.c , 1 ); }
+function jsConstMap() { var c = this.c; emit( c , 1 ); }
+
+function nativeReduce( key , values ) { return Array.sum( values ); }
+function jsReduce( key , values ) { var s = Array.sum( values ); return s; }
+
+function results( map , reduce , extra ) {
+    var cmd = { mapreduce : "mr_native" , map : map , reduce : reduce , out : { inline : 1 } };
+    Object.extend( cmd , extra || {} );
+    var res = db.runCommand( cmd );
+    assert.commandWorked( res );
+    return byKey( res.results );
+}
+
+function byKey( results ) {
+    var x = {};
+    results.forEach( function( z ) { x[ tojson( z._id ) ] = z.value; } );
+    return x;
+}
+
+assert.eq( results( jsMap , jsReduce ) , results( nativeMap , nativeReduce ) );
+assert.eq( results( jsConstMap , jsReduce ) , results( nativeConstMap , nativeReduce ) );
+assert.eq( results( jsMap , jsReduce , { jsMode : true } ) ,
+           results( nativeMap , nativeReduce , { jsMode : true } ) );
+
+// with a finalize and an output collection
+function finalize( key , value ) { return { total : value }; }
+var out = db.mr_native_out;
+out.drop();
+var res = t.mapReduce( nativeMap , nativeReduce , { out : "mr_native_out" , finalize : finalize } );
+assert.commandWorked( res );
+assert.eq( results( jsMap , jsReduce , { finalize : finalize } ) , byKey( out.find().toArray() ) );
+
+// the native functions can be turned off
+assert.commandWorked( db.adminCommand( { setParameter : 1 , mapReduceNativeFunctions : false } ) );
+assert.eq( results( jsMap , jsReduce ) , results( nativeMap , nativeReduce ) );
+assert.commandWorked( db.adminCommand( { setParameter : 1 , mapReduceNativeFunctions : true } ) );
@@ -0,0 +1,43 @@
+// mapReduce with the js map function on several threads gives the same results as on one.
+
+t = db.mr_parallel_map;
+t.drop();
+
+for ( var i = 0; i < 25000; i++ ) {
+    t.save( { a : i % 101 , b : i } );
+}
+t.getDB().getLastError();
+
+function m() { emit( this.a , { count : 1 , total : this.b } ); }
+function r( key , values ) {
+    var res = { count : 0 , total : 0 };
+    values.forEach( function( v ) { res.count += v.count; res.total += v.total; } );
+    return res;
+}
+
+function results( out ) {
+    var res = t.mapReduce( m , r , { out : out } );
+    assert.commandWorked( res );
+    var x = {};
+    ( out.inline ? res.results : res.find().toArray() ).forEach(
+        function( z ) { x[ tojson( z._id ) ] = z.value; } );
+    return x;
+}
+
+var serialInline = results( { inline : 1 } );
+var serialOut = results( "mr_parallel_map_out" );
+
+assert.commandWorked( db.adminCommand( { setParameter : 1 , mapReduceMapThreads : 4 } ) );
+try {
+    assert.eq( serialInline , results( { inline : 1 } ) );
+    assert.eq( serialOut , results( "mr_parallel_map_out" ) );
+
+    // the parallel map can't touch the db
+    var res = db.runCommand( { mapreduce : "mr_parallel_map" ,
+                               map : function() { db.foo.findOne(); emit( this.a , 1 ); } ,
+                               reduce : r , out : { inline : 1 } } );
+    assert.commandFailed( res );
+}
+finally {
+    assert.commandWorked( db.adminCommand( { setParameter : 1 , mapReduceMapThreads : 1 } ) );
+}
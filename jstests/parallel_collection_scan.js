@@ -0,0 +1,60 @@
+// Tests the parallelCollectionScan command, which splits a collection scan into several cursors.
+
+var t = db.parallel_collection_scan;
+t.drop();
+
+assert.commandFailed(t.runCommand("parallelCollectionScan", {numCursors: 2}));
+
+// Several extents worth of documents.
+var numDocs = 20000;
+var pad = new Array(500).join("x");
+for (var i = 0; i < numDocs; i++) {
+    t.insert({_id: i, pad: pad});
+}
+assert.isnull(db.getLastError());
+
+assert.commandFailed(t.runCommand("parallelCollectionScan", {numCursors: 0}));
+assert.commandFailed(t.runCommand("parallelCollectionScan", {numCursors: "a"}));
+
+function checkAllOnce(cursors) {
+    var seen = {};
+    var n = 0;
+    cursors.forEach(function(cursor) {
+        while (cursor.hasNext()) {
+            var doc = cursor.next();
+            assert(!seen[doc._id], "seen twice " + doc._id);
+            seen[doc._id] = true;
+            n++;
+        }
+    });
+    assert.eq(numDocs, n);
+}
+
+[1, 3, 8, 1000].forEach(function(numCursors) {
+    var cursors = t.parallelScan(numCursors);
+    assert.gte(numCursors, cursors.length);
+    assert.lte(1, cursors.length);
+    checkAllOnce(cursors);
+});
+assert.lt(1, t.parallelScan(8).length, "collection has only one extent");
+
+// Reading the cursors alternately, i.e. concurrently.
+var cursors = t.parallelScan(4);
+var n = 0;
+while (cursors.some(function(c) { return c.hasNext(); })) {
+    cursors.forEach(function(c) {
+        if (c.hasNext()) {
+            c.next();
+            n++;
+        }
+    });
+}
+assert.eq(numDocs, n);
+
+// Capped collections aren't supported.
+db.parallel_collection_scan_capped.drop();
+db.createCollection("parallel_collection_scan_capped", {capped: true, size: 4096});
+assert.commandFailed(db.parallel_collection_scan_capped.runCommand("parallelCollectionScan",
+                                                                   {numCursors: 2}));
+db.parallel_collection_scan_capped.drop();
+t.drop();
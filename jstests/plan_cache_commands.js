@@ -0,0 +1,72 @@
+// Tests the planCache* commands for inspecting and manipulating the plan cache of the new query
+// framework.
+
+t = db.jstests_plan_cache_commands;
+t.drop();
+
+for (var i = 0; i < 200; ++i) {
+    t.save({a: i, b: i % 7});
+}
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+
+var old = db.adminCommand({setParameter: 1, newQueryFrameworkEnabled: true});
+assert.commandWorked(old);
+
+try {
+    // Nothing is cached for a fresh collection.
+    var res = db.runCommand({planCacheListShapes: t.getName()});
+    assert.commandWorked(res);
+    assert.eq(0, res.shapes.length, tojson(res));
+
+    // A query with more than one candidate plan is raced and its shape cached.
+    assert.eq(4, t.find({a: {$gte: 3, $lte: 30}, b: 3}).itcount());
+    res = db.runCommand({planCacheListShapes: t.getName()});
+    assert.commandWorked(res);
+    assert.eq(1, res.shapes.length, tojson(res));
+
+    // The cached plan is listed for any query of the same shape.
+    res = db.runCommand({planCacheListPlans: t.getName(), query: {a: {$gte: 0, $lte: 1}, b: 0}});
+    assert.commandWorked(res);
+    assert(res.solution, tojson(res));
+    assert(res.decision.statsOfWinner, tojson(res));
+    assert(!res.pinnedIndex, tojson(res));
+
+    // Unknown shapes are an error.
+    assert.commandFailed(db.runCommand({planCacheListPlans: t.getName(), query: {c: 1}}));
+    assert.commandFailed(db.runCommand({planCacheListPlans: t.getName()}));
+
+    // Pinning an index forces its use, even for explain.
+    assert.commandWorked(db.runCommand({planCachePin: t.getName(),
+                                        query: {a: {$gte: 1, $lte: 2}, b: 1},
+                                        index: {b: 1}}));
+    var explain = t.find({a: {$gte: 3, $lte: 30}, b: 3}).explain();
+    assert.eq("BtreeCursor b_1", explain.cursor, tojson(explain));
+    assert.eq(4, t.find({a: {$gte: 3, $lte: 30}, b: 3}).itcount());
+
+    res = db.runCommand({planCacheListPlans: t.getName(), query: {a: {$gte: 0, $lte: 1}, b: 0}});
+    assert.commandWorked(res);
+    assert.eq({b: 1}, res.pinnedIndex, tojson(res));
+
+    // Pins survive clearing the cache.
+    assert.commandWorked(db.runCommand({planCacheClear: t.getName()}));
+    res = db.runCommand({planCacheListShapes: t.getName()});
+    assert.eq(1, res.shapes.length, tojson(res));
+
+    assert.commandWorked(db.runCommand({planCacheUnpin: t.getName(),
+                                        query: {a: {$gte: 1, $lte: 2}, b: 1}}));
+    assert.commandFailed(db.runCommand({planCacheUnpin: t.getName(),
+                                        query: {a: {$gte: 1, $lte: 2}, b: 1}}));
+    res = db.runCommand({planCacheListShapes: t.getName()});
+    assert.eq(0, res.shapes.length, tojson(res));
+
+    // Clearing a single shape.
+    assert.eq(4, t.find({a: {$gte: 3, $lte: 30}, b: 3}).itcount());
+    assert.commandWorked(db.runCommand({planCacheClear: t.getName(),
+                                        query: {a: {$gte: 1, $lte: 2}, b: 1}}));
+    res = db.runCommand({planCacheListShapes: t.getName()});
+    assert.eq(0, res.shapes.length, tojson(res));
+}
+finally {
+    db.adminCommand({setParameter: 1, newQueryFrameworkEnabled: old.was});
+}
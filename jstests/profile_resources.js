@@ -0,0 +1,32 @@
+// Tests the resource usage fields of system.profile entries.
+
+var stddb = db;
+var db = db.getSisterDB("profile_resources");
+db.dropDatabase();
+var t = db.foo;
+
+db.setProfilingLevel(2);
+t.insert({a: 1});
+db.getLastError();
+t.find({a: 1}).itcount();
+db.setProfilingLevel(0);
+
+var insert = db.system.profile.findOne({op: "insert", ns: t.getFullName()});
+var query = db.system.profile.findOne({op: "query", ns: t.getFullName()});
+assert(insert, "no insert entry");
+assert(query, "no query entry");
+
+if (db.hostInfo().os.type == "Linux") {
+    // measured on the op's thread
+    assert.lte(0, query.cpuMicros, tojson(query));
+    assert.lte(0, query.diskPageFaults, tojson(query));
+}
+
+if (db.serverStatus().dur) {
+    // the document is written through the journal
+    assert.lt(0, insert.journalBytes, tojson(insert));
+}
+assert.eq(undefined, query.journalBytes, tojson(query));
+
+db.dropDatabase();
+db = stddb;
@@ -0,0 +1,47 @@
+/**
+ * Test that a secondary applying a batch split across writers by document _id ends up with the
+ * same data as the primary, including collections which must stay with a single writer (capped
+ * collections and collections with a unique secondary index).
+ */
+
+var replTest = new ReplSetTest( {name: "apply_split_by_document", nodes: 2} );
+var nodes = replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster().getDB("test");
+var slave = replTest.liveNodes.slaves[0].getDB("test");
+slave.getMongo().setSlaveOk();
+
+master.createCollection("capped", {capped: true, size: 1024 * 1024});
+master.unique.ensureIndex({u: 1}, {unique: true});
+replTest.awaitReplication();
+
+// Many interleaved writes to a small set of documents, so that each writer sees several ops on
+// the same document within one batch.
+for (var i = 0; i < 2000; i++) {
+    var id = i % 37;
+    master.plain.update({_id: id}, {$inc: {n: 1}, $push: {seq: i}}, true);
+    if (i % 11 == 0) {
+        master.plain.remove({_id: (id + 1) % 37});
+    }
+    master.capped.insert({_id: i, x: i});
+    // Moving a unique key from one document to another is only valid in oplog order.
+    master.unique.remove({_id: id});
+    master.unique.insert({_id: id + 37, u: i % 5});
+    master.unique.remove({_id: id + 37});
+}
+master.getLastError();
+replTest.awaitReplication();
+
+["plain", "capped", "unique"].forEach(function(coll) {
+    var onMaster = master[coll].find().sort({$natural: 1}).toArray();
+    var onSlave = slave[coll].find().sort({$natural: 1}).toArray();
+    if (coll != "capped") {
+        var byId = function(a, b) { return a._id - b._id; };
+        onMaster.sort(byId);
+        onSlave.sort(byId);
+    }
+    assert.eq(tojson(onMaster), tojson(onSlave), "collection " + coll + " differs");
+});
+
+replTest.stopSet();
@@ -0,0 +1,47 @@
+/**
+ * Test that with replBatchInsertOplogEntries a multi-document insert is logged as one "bi" oplog
+ * entry, and that secondaries apply it.
+ */
+
+var replTest = new ReplSetTest( {name: "batched_insert_oplog", nodes: 2} );
+replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+var slave = replTest.liveNodes.slaves[0];
+slave.setSlaveOk();
+
+assert.commandWorked(master.getDB("admin").runCommand({setParameter: 1,
+                                                       replBatchInsertOplogEntries: true}));
+
+var coll = master.getDB("test").batched;
+var docs = [];
+for (var i = 0; i < 100; i++) {
+    docs.push({_id: i, x: i});
+}
+coll.insert(docs);
+assert.eq(null, master.getDB("test").getLastError());
+
+var oplog = master.getDB("local").oplog.rs;
+var entry = oplog.find({ns: "test.batched"}).sort({$natural: -1}).next();
+assert.eq("bi", entry.op, tojson(entry));
+assert.eq(100, entry.o.docs.length, tojson(entry));
+assert.eq(0, oplog.find({ns: "test.batched", op: "i"}).count());
+
+// a single document is still logged as a plain insert
+coll.insert({_id: 100, x: 100});
+assert.eq(null, master.getDB("test").getLastError());
+assert.eq("i", oplog.find({ns: "test.batched"}).sort({$natural: -1}).next().op);
+
+// ops on documents of the batch apply after it
+coll.update({_id: 5}, {$set: {x: -5}});
+coll.remove({_id: 6});
+assert.eq(null, master.getDB("test").getLastError());
+
+replTest.awaitReplication();
+var onSlave = slave.getDB("test").batched;
+assert.eq(100, onSlave.count());
+assert.eq(-5, onSlave.findOne({_id: 5}).x);
+assert.eq(null, onSlave.findOne({_id: 6}));
+
+replTest.stopSet();
@@ -0,0 +1,44 @@
+// A foreground index build replicated to a secondary is built there in the background, while the
+// secondary goes on applying the oplog.  The index spec is the same on both members.
+
+var replTest = new ReplSetTest({ name : 'indexBuildSecondaryBackground', nodes : 2 });
+replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+replTest.awaitSecondaryNodes();
+var slave = replTest.liveNodes.slaves[0];
+slave.setSlaveOk();
+
+var masterDB = master.getDB("test");
+var slaveDB = slave.getDB("test");
+
+for (var i = 0; i < 10000; i++) {
+    masterDB.foo.insert({ a : i, b : i % 7 });
+}
+assert.eq(null, masterDB.getLastError());
+replTest.awaitReplication();
+
+masterDB.foo.ensureIndex({ a : 1 });
+assert.eq(null, masterDB.getLastError());
+// written while the secondary may still be building the index
+for (var i = 10000; i < 11000; i++) {
+    masterDB.foo.insert({ a : i, b : i % 7 });
+}
+assert.eq(null, masterDB.getLastErrorObj(2, 60 * 1000).err);
+
+assert.soon(function() { return slaveDB.system.indexes.count({ name : "a_1" }) == 1; },
+            "index wasn't built on the secondary");
+var spec = slaveDB.system.indexes.findOne({ name : "a_1" });
+assert.eq(undefined, spec.background, tojson(spec));
+assert.eq(11000, slaveDB.foo.find().hint({ a : 1 }).itcount());
+
+// with the parameter off a replicated foreground build is applied in place, as before
+assert.commandWorked(slave.getDB("admin").runCommand({ setParameter : 1,
+                                                       replIndexBuildsInBackground : false }));
+masterDB.foo.ensureIndex({ b : 1 });
+assert.eq(null, masterDB.getLastErrorObj(2, 60 * 1000).err);
+assert.eq(1, slaveDB.system.indexes.count({ name : "b_1" }));
+assert.eq(11000, slaveDB.foo.find().hint({ b : 1 }).itcount());
+
+replTest.stopSet();
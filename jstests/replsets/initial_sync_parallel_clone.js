@@ -0,0 +1,41 @@
+/**
+ * Test that initial sync copying several collections of a database at once
+ * (initialSyncCloneThreads > 1) clones every collection, with its options and indexes.
+ */
+
+var replTest = new ReplSetTest( {name: "initial_sync_parallel_clone", nodes: 1} );
+replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster().getDB("test");
+
+var numColls = 6;
+for (var c = 0; c < numColls; c++) {
+    var coll = master["coll" + c];
+    coll.ensureIndex({x: 1});
+    for (var i = 0; i < 1000 * (c + 1); i++) {
+        coll.insert({_id: i, x: i % 17});
+    }
+}
+master.createCollection("capped", {capped: true, size: 64 * 1024});
+master.capped.insert({_id: 0});
+master.getLastError();
+
+var slaveConn = replTest.add({setParameter: "initialSyncCloneThreads=3"});
+replTest.reInitiate();
+replTest.awaitSecondaryNodes();
+replTest.awaitReplication();
+
+var slave = slaveConn.getDB("test");
+slaveConn.setSlaveOk();
+
+for (var c = 0; c < numColls; c++) {
+    var name = "coll" + c;
+    assert.eq(master[name].count(), slave[name].count(), name + " count differs");
+    assert.eq(master[name].getIndexes().length, slave[name].getIndexes().length,
+              name + " indexes differ");
+}
+assert(slave.capped.isCapped(), "capped option was not cloned");
+assert.eq(1, slave.capped.count());
+
+replTest.stopSet();
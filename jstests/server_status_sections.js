@@ -0,0 +1,33 @@
+// Tests serverStatus with a "sections" list, which computes only the named sections.
+
+var adminDB = db.getSiblingDB("admin");
+
+var full = adminDB.runCommand({serverStatus: 1});
+assert.commandWorked(full);
+assert(full.opcounters, tojson(full));
+assert(full.mem, tojson(full));
+assert(full.connections, tojson(full));
+
+var res = adminDB.runCommand({serverStatus: 1, sections: ["opcounters", "mem"]});
+assert.commandWorked(res);
+assert(res.opcounters, tojson(res));
+assert(res.mem, "top level metrics can be selected: " + tojson(res));
+assert.eq(undefined, res.connections, tojson(res));
+assert.eq(undefined, res.metrics, tojson(res));
+assert.eq(undefined, res.asserts, tojson(res));
+
+// the basic fields are always there
+assert(res.uptimeMillis !== undefined, tojson(res));
+assert.eq(full.process, res.process);
+
+// sections which are off by default can be listed too
+res = adminDB.runCommand({serverStatus: 1, sections: ["workingSet"]});
+assert.commandWorked(res);
+assert(res.workingSet, tojson(res));
+assert.eq(undefined, res.opcounters, tojson(res));
+
+// an empty list leaves only the basic fields
+res = adminDB.runCommand({serverStatus: 1, sections: []});
+assert.commandWorked(res);
+assert.eq(undefined, res.opcounters, tojson(res));
+assert.eq(undefined, res.mem, tojson(res));
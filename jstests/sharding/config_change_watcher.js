@@ -0,0 +1,32 @@
+// Tests that a mongos picks up chunk changes made through another mongos from the config
+// changelog, without a request of its own hitting a stale version.
+
+var st = new ShardingTest({ shards: 2, mongos: 2 });
+
+var admin0 = st.s0.getDB('admin');
+var admin1 = st.s1.getDB('admin');
+
+assert.commandWorked(admin0.runCommand({ enableSharding: 'test' }));
+assert.commandWorked(admin0.runCommand({ shardCollection: 'test.user', key: { x: 1 }}));
+
+// Load test.user on mongos 1
+st.s1.getDB('test').user.findOne();
+
+var versionOn = function(admin) {
+    var res = admin.runCommand({ getShardVersion: 'test.user' });
+    assert.commandWorked(res);
+    return res.version;
+};
+
+assert.commandWorked(admin0.runCommand({ split: 'test.user', middle: { x: 0 }}));
+var configDB = st.s0.getDB('config');
+var chunkToMove = configDB.chunks.findOne({ ns: 'test.user', min: { x: 0 }});
+var toShard = configDB.shards.findOne({ _id: { $ne: chunkToMove.shard }})._id;
+assert.commandWorked(admin0.runCommand({ moveChunk: 'test.user', find: { x: 0 },
+                                         to: toShard }));
+
+var expected = versionOn(admin0);
+assert.soon(function() { return bsonWoCompare(versionOn(admin1), expected) == 0; },
+            "mongos 1 didn't reload after the migration", 30 * 1000);
+
+st.stop();
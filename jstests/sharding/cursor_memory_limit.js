@@ -0,0 +1,51 @@
+// Tests that mongos accounts for the shard replies its sharded cursors hold, and kills idle
+// cursors once they hold more than shardedCursorBufferLimitMB.
+
+var st = new ShardingTest({ shards : 2, mongos : 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var coll = mongos.getCollection( "foo.bar" );
+var shards = mongos.getDB( "config" ).shards.find().toArray();
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+assert.commandWorked(admin.runCommand({ split : coll + "", middle : { _id : 0 } }));
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : 0 },
+                                        to : shards[1]._id }));
+
+// each shard's first reply holds at least one of these, over 1MB between them
+var big = new Array(600 * 1024).join("x");
+for (var i = -5; i < 5; i++) {
+    coll.insert({ _id : i, big : big });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var metrics = function() {
+    return admin.runCommand({ serverStatus : 1 }).metrics.cursor.sharded;
+};
+
+var killedBefore = metrics().killedForMemory;
+
+var cursor = coll.find().batchSize(2);
+assert.neq(null, cursor.next());
+assert.eq(1, admin.runCommand({ cursorInfo : 1 }).sharded);
+assert.gt(metrics().bufferedBytes, 1024 * 1024, tojson(metrics()));
+
+// no limit by default
+sleep(5000);
+assert.eq(1, admin.runCommand({ cursorInfo : 1 }).sharded);
+
+assert.commandWorked(admin.runCommand({ setParameter : 1, shardedCursorBufferLimitMB : 1 }));
+assert.soon(function() { return admin.runCommand({ cursorInfo : 1 }).sharded == 0; },
+            "cursor over the buffer limit wasn't killed", 30 * 1000);
+assert.eq(killedBefore + 1, metrics().killedForMemory);
+assert.eq(0, metrics().bufferedBytes);
+
+assert.throws(function() { cursor.itcount(); });
+
+assert.commandWorked(admin.runCommand({ setParameter : 1, shardedCursorBufferLimitMB : 0 }));
+
+st.stop();
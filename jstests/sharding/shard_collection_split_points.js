@@ -0,0 +1,41 @@
+// Pre-split and distribute a new range-sharded collection from given split points.
+
+var s = new ShardingTest({ shards : 3, mongos : 1 });
+var dbname = "test";
+var db = s.getDB(dbname);
+db.adminCommand({ enablesharding : dbname });
+
+// for simplicity turn off balancer
+s.stopBalancer();
+
+var splitPoints = [];
+for (var i = 1; i < 30; i++) {
+    splitPoints.push({ a : i * 100 });
+}
+
+var res = db.adminCommand({ shardcollection : dbname + ".foo",
+                            key : { a : 1 },
+                            initialSplitPoints : splitPoints });
+assert.commandWorked(res);
+assert.eq(30, s.config.chunks.count({ ns : dbname + ".foo" }), "should be exactly 30 chunks");
+
+s.config.shards.find().forEach(function(shard) {
+    assert.eq(10, s.config.chunks.count({ ns : dbname + ".foo", shard : shard._id }),
+              "chunks not distributed evenly to " + shard._id);
+});
+
+// the collection must be empty
+db.bar.insert({ a : 1 });
+assert.eq(null, db.getLastError());
+res = db.adminCommand({ shardcollection : dbname + ".bar",
+                        key : { a : 1 },
+                        initialSplitPoints : splitPoints });
+assert.commandFailed(res);
+
+// the split points must match the shard key
+res = db.adminCommand({ shardcollection : dbname + ".baz",
+                        key : { a : 1 },
+                        initialSplitPoints : [{ b : 1 }] });
+assert.commandFailed(res);
+
+s.stop();
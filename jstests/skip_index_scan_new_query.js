@@ -0,0 +1,39 @@
+// With the new query framework a skip over an index scan whose results all match is applied by the
+// scan, so the skipped documents are never fetched.
+
+var t = db.skip_index_scan_new_query;
+t.drop();
+
+for (var i = 0; i < 1000; i++) {
+    t.insert({ a : i, b : i % 2, c : [ i, i + 1 ] });
+}
+t.ensureIndex({ a : 1 });
+t.ensureIndex({ c : 1 });
+assert.eq(null, db.getLastError());
+
+var old = db.adminCommand({ setParameter : 1, newQueryFrameworkEnabled : true });
+assert.commandWorked(old);
+
+try {
+    var cursor = t.find({ a : { $gte : 100 } }).hint({ a : 1 }).skip(850);
+    assert.eq(50, cursor.itcount());
+    assert.eq(950, t.find({ a : { $gte : 100 } }).hint({ a : 1 }).skip(850).next().a);
+    var explain = t.find({ a : { $gte : 100 } }).hint({ a : 1 }).skip(850).explain();
+    assert.eq(50, explain.n, tojson(explain));
+    assert.eq(50, explain.nscannedObjects, tojson(explain));
+
+    // a covered scan skips the same way
+    assert.eq({ a : 990 }, t.find({ a : { $gte : 0 } }, { _id : 0, a : 1 }).hint({ a : 1 })
+                            .skip(990).next());
+
+    // the fetch filters on b, so the skip has to count what's left after it
+    assert.eq(25, t.find({ a : { $gte : 100 }, b : 1 }).hint({ a : 1 }).skip(425).itcount());
+
+    // a document is skipped once however many of its keys the multikey index holds
+    assert.eq(10, t.find({ c : { $gte : 0 } }).hint({ c : 1 }).skip(990).itcount());
+}
+finally {
+    db.adminCommand({ setParameter : 1, newQueryFrameworkEnabled : old.was });
+}
+
+t.drop();
@@ -0,0 +1,68 @@
+// Tests $group with aggregationGroupThreads > 1, which accumulates the groups on several threads
+// split by the hash of _id.  The results must match the serial $group, including the order in
+// which each group sees its documents.
+
+var mongo = MongoRunner.runMongod({setParameter: "aggregationGroupThreads=4"});
+var testDB = mongo.getDB("test");
+var t = testDB.agg_group_parallel;
+
+function setThreads(n) {
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, aggregationGroupThreads: n}));
+}
+
+function sortedResults(pipeline, options) {
+    var results = t.aggregateCursor(pipeline, options || {}).toArray();
+    results.sort(function(a, b) { return bsonWoCompare({x: a._id}, {x: b._id}); });
+    return results;
+}
+
+function assertSameAsSerial(pipeline, options) {
+    var parallel = sortedResults(pipeline, options);
+    setThreads(1);
+    var serial = sortedResults(pipeline, options);
+    setThreads(4);
+    assert.eq(serial, parallel, tojson(pipeline));
+    return parallel;
+}
+
+for (var i = 0; i < 20000; i++) {
+    t.insert({_id: i, a: i % 97, b: (i % 3 == 0) ? null : "s" + (i % 5), c: i % 7});
+}
+t.insert({_id: "noA"});
+testDB.getLastError();
+
+var res = assertSameAsSerial([{$group: {_id: "$a", n: {$sum: 1}, min: {$min: "$_id"},
+                                        first: {$first: "$_id"}, last: {$last: "$_id"},
+                                        all: {$push: "$c"}, uniq: {$addToSet: "$c"}}}]);
+assert.eq(98, res.length);
+assert.eq(null, res[0]._id); // the missing a is grouped as null
+
+assertSameAsSerial([{$group: {_id: {b: "$b", c: "$c"}, avg: {$avg: "$a"}}}]);
+assertSameAsSerial([{$group: {_id: null, n: {$sum: 1}}}]);
+assertSameAsSerial([{$group: {_id: "$b"}}]); // no accumulators
+assertSameAsSerial([{$match: {_id: {$lt: 0}}}, {$group: {_id: "$a"}}]); // no input
+
+// Groups that exceed the memory limit spill to disk in each partition and are merged from there.
+t.drop();
+var bigStr = Array(1024 * 1024 + 1).toString(); // 1MB of ','
+for (var i = 0; i < 120; i++) {
+    t.insert({_id: i, k: i % 60, bigStr: i + bigStr});
+}
+testDB.getLastError();
+
+// Every group holds 2MB, 120MB in all, more than the 100MB $group may use in memory.
+var pipeline = [{$group: {_id: "$k", n: {$sum: 1}, s: {$push: "$bigStr"}}},
+                {$project: {n: 1, pushed: {$size: "$s"}}}];
+var res = t.runCommand("aggregate", {pipeline: pipeline});
+assert.commandFailed(res);
+assert.eq(16945, res.code);
+
+res = assertSameAsSerial(pipeline, {allowDiskUsage: true});
+assert.eq(60, res.length);
+res.forEach(function(group) {
+    assert.eq(2, group.n, tojson(group));
+    assert.eq(2, group.pushed, tojson(group));
+});
+
+t.drop();
+MongoRunner.stopMongod(mongo);
@@ -0,0 +1,54 @@
+// Tests that background index builds, which bulk build the btree and apply the writes made
+// meanwhile at the end, end up with the same keys as the documents, for plain and unique indexes.
+
+var t = db.bulk_bgindex;
+t.drop();
+
+var numDocs = 50000;
+for (var i = 0; i < numDocs; i++) {
+    t.insert({_id: i, x: i % 1000, u: i, pad: "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"});
+}
+db.getLastError();
+
+// Concurrent writes: change indexed values (moving unique values between documents), grow
+// documents so that they move, remove and insert.
+var writer = startParallelShell(
+    "var t = db.bulk_bgindex;" +
+    "for (var i = 0; i < 5000; i++) {" +
+    "    var id = Random.randInt(" + numDocs + ");" +
+    "    t.update({_id: id}, {$inc: {x: 1}, $set: {pad: new Array(200).join('b')}});" +
+    "    t.remove({_id: id + 1});" +
+    "    t.update({_id: id + 2}, {$set: {u: -1 - i}});" +
+    "    t.insert({_id: " + numDocs + " + i, x: i, u: id + 2});" +
+    "}" +
+    "db.getLastError();");
+
+t.ensureIndex({x: 1}, {background: true});
+assert.isnull(db.getLastError());
+t.ensureIndex({u: 1}, {background: true, unique: true});
+assert.isnull(db.getLastError());
+writer();
+
+function checkIndex(field) {
+    var docs = t.find({}, {_id: 1}).sort({_id: 1}).toArray().length;
+    var hint = {};
+    hint[field] = 1;
+    assert.eq(docs, t.find().hint(hint).itcount(), "keys of " + field);
+    t.find().forEach(function(doc) {
+        var query = {};
+        query[field] = doc[field];
+        assert.eq(1, t.find(query, {_id: 1}).hint(hint).toArray().filter(function(d) {
+            return d._id == doc._id;
+        }).length, "no key for " + tojson(doc));
+    });
+}
+checkIndex("x");
+checkIndex("u");
+assert(t.validate().valid);
+
+// A unique index over duplicates fails.
+t.insert({_id: "dup1", d: 1});
+t.insert({_id: "dup2", d: 1});
+t.ensureIndex({d: 1}, {background: true, unique: true, sparse: true});
+assert.eq(11000, db.getLastErrorObj().code);
+assert.eq(3, t.getIndexes().length);
@@ -0,0 +1,35 @@
+// Tests that databases idle for closeIdleDatabasesSecs are closed, unless a cursor is open on
+// them, and that they reopen transparently.
+
+var m = startMongod( "--port", "27018", "--dbpath", "/data/db/close_idle_databases",
+                     "--nohttpinterface" );
+var admin = m.getDB( "admin" );
+
+var idle = m.getDB( "close_idle_a" );
+var busy = m.getDB( "close_idle_b" );
+for ( var i = 0; i < 100; i++ ) {
+    idle.c.insert( { _id : i } );
+    busy.c.insert( { _id : i } );
+}
+assert.eq( null, busy.getLastError() );
+
+// an open cursor keeps its database open
+var cursor = busy.c.find().batchSize( 2 );
+assert.eq( 0, cursor.next()._id );
+
+assert.commandWorked( admin.runCommand( { setParameter : 1, closeIdleDatabasesSecs : 1 } ) );
+
+var closedLines = function() {
+    return admin.runCommand( { getLog : "global" } ).log.filter( function( line ) {
+        return /closed \d+ idle databases/.test( line );
+    } );
+};
+assert.soon( function() { return closedLines().length > 0; },
+             "idle databases weren't closed", 3 * 60 * 1000 );
+assert.commandWorked( admin.runCommand( { setParameter : 1, closeIdleDatabasesSecs : 0 } ) );
+
+assert.eq( 100, cursor.itcount() + 1 );
+assert.eq( 100, idle.c.count() );
+assert.eq( 50, idle.c.findOne( { _id : 50 } )._id );
+
+stopMongod( 27018 );
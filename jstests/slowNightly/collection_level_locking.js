@@ -0,0 +1,52 @@
+// Tests writing to several collections of one database at once with collectionLevelLocking on,
+// and that the collection locks are reported in serverStatus.
+
+var mongo = MongoRunner.runMongod({setParameter: "collectionLevelLocking=true"});
+var testDB = mongo.getDB("test");
+
+var numColls = 4;
+var numDocs = 5000;
+for (var c = 0; c < numColls; c++) {
+    testDB["coll" + c].insert({_id: -1});
+}
+testDB.getLastError();
+
+var joins = [];
+for (var c = 0; c < numColls; c++) {
+    joins.push(startParallelShell(
+        "var coll = db.getSiblingDB('test').coll" + c + ";" +
+        "for (var i = 0; i < " + numDocs + "; i++) {" +
+        "    coll.insert({_id: i, x: 'abcdefghijklmnopqrstuvwxyz'});" +
+        "    if (i % 100 == 0) coll.update({_id: i}, {$set: {y: i}});" +
+        "    if (i % 10 == 0) coll.remove({_id: i - 5});" +
+        "}" +
+        "assert.isnull(db.getLastError());",
+        mongo.port));
+}
+
+// Whole-database operations and new collections still work meanwhile.
+for (var i = 0; i < 20; i++) {
+    testDB["created" + i].insert({i: i});
+    assert.gte(testDB.getCollectionNames().length, numColls);
+    assert.commandWorked(testDB.runCommand({dbStats: 1}));
+}
+testDB.getLastError();
+
+joins.forEach(function(join) { join(); });
+
+for (var c = 0; c < numColls; c++) {
+    var coll = testDB["coll" + c];
+    // every tenth insert removes an earlier document, except for the first
+    assert.eq(numDocs + 1 - (numDocs / 10 - 1), coll.count(), "coll" + c);
+    assert(coll.validate().valid, "coll" + c + " is not valid");
+}
+
+var locks = testDB.serverStatus().locks.test;
+assert(locks.collections, tojson(locks));
+for (var c = 0; c < numColls; c++) {
+    var stats = locks.collections["coll" + c];
+    assert(stats, "no lock stats for coll" + c + ": " + tojson(locks));
+    assert.gt(stats.timeLockedMicros.W, 0, tojson(stats));
+}
+
+MongoRunner.stopMongod(mongo);
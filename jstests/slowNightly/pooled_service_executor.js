@@ -0,0 +1,71 @@
+// Tests serving many connections, more than there are worker threads, with
+// --serviceExecutor pooled.  Each connection keeps its own state (last error, cursors) as it moves
+// between the workers.
+
+if (db.hostInfo().os.type == "Linux") {
+    var mongo = MongoRunner.runMongod({serviceExecutor: "pooled", serviceExecutorThreads: 2});
+    var coll = mongo.getDB("test").pooled;
+
+    for (var i = 0; i < 100; i++) {
+        coll.insert({_id: i});
+    }
+    assert.eq(100, coll.count());
+
+    var conns = [];
+    for (var i = 0; i < 20; i++) {
+        conns.push(new Mongo(mongo.host));
+    }
+
+    // Interleave requests from all of the connections so that consecutive requests of one
+    // connection are served by different workers.
+    var cursors = conns.map(function(conn) {
+        return conn.getDB("test").pooled.find().sort({_id: 1}).batchSize(10);
+    });
+    for (var n = 0; n < 100; n++) {
+        cursors.forEach(function(cursor) {
+            assert.eq(n, cursor.next()._id);
+        });
+    }
+
+    conns.forEach(function(conn, i) {
+        var testDB = conn.getDB("test");
+        testDB.pooled.insert({_id: i});
+        assert.eq(11000, testDB.getLastErrorObj().code);
+    });
+    conns.forEach(function(conn) {
+        assert.eq(11000, conn.getDB("test").getLastErrorObj().code);
+    });
+
+    // Parallel shells come and go while the pool stays the same size.
+    for (var i = 0; i < 5; i++) {
+        var join = startParallelShell("db.getSiblingDB('test').pooled.find().itcount();",
+                                      mongo.port);
+        join();
+    }
+    assert.eq(100, coll.count());
+
+    // Tailing awaitData cursors wait for data on the server.  Their connections move off the
+    // pool, so more tailers than workers don't hold up other clients.
+    var testDB = mongo.getDB("test");
+    testDB.createCollection("capped", {capped: true, size: 4096});
+    testDB.capped.insert({_id: 0});
+    assert.eq(null, testDB.getLastError());
+    var tailers = [];
+    for (var i = 0; i < 4; i++) {
+        tailers.push(startParallelShell(
+            "var cursor = db.getSiblingDB('test').capped.find()" +
+            "    .addOption(DBQuery.Option.tailable).addOption(DBQuery.Option.awaitData);" +
+            "var start = new Date();" +
+            "while (new Date() - start < 10 * 1000) { cursor.hasNext() && cursor.next(); }",
+            mongo.port));
+    }
+    sleep(2000);
+    for (var i = 0; i < 20; i++) {
+        var start = new Date();
+        assert.eq(100, coll.find().itcount());
+        assert.lt(new Date() - start, 1000, "request stuck behind the tailers");
+    }
+    tailers.forEach(function(join) { join(); });
+
+    MongoRunner.stopMongod(mongo);
+}
@@ -0,0 +1,30 @@
+// Tests that with profileAsync the profiled operations reach system.profile through the
+// background writer.
+
+var mongo = MongoRunner.runMongod({setParameter: "profileAsync=true"});
+var testDB = mongo.getDB("profile_async");
+var t = testDB.foo;
+
+var status = testDB.serverStatus();
+assert.eq(0, status.metrics.profiler.dropped, tojson(status.metrics));
+
+testDB.setProfilingLevel(2);
+for (var i = 0; i < 50; i++) {
+    t.insert({_id: i});
+    t.findOne({_id: i});
+}
+testDB.setProfilingLevel(0);
+
+assert.soon(function() {
+    return testDB.system.profile.find({op: "query", ns: t.getFullName()}).itcount() == 50;
+}, "profile entries weren't written");
+assert.eq(50, testDB.system.profile.find({op: "insert", ns: t.getFullName()}).itcount());
+
+// switching back writes entries synchronously again
+assert.commandWorked(testDB.adminCommand({setParameter: 1, profileAsync: false}));
+testDB.setProfilingLevel(2);
+t.findOne({_id: "sync"});
+testDB.setProfilingLevel(0);
+assert.eq(51, testDB.system.profile.find({op: "query", ns: t.getFullName()}).itcount());
+
+MongoRunner.stopMongod(mongo);
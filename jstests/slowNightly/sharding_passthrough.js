@@ -115,6 +115,7 @@ files.forEach(function(x) {
         'mr_auth|' +
         'queryoptimizera|' +
         'indexStatsCommand|' +
+        'plan_cache_commands|' +
         'reversecursor|' +
         'block_check_supported|' +
         'batch_write_protocol|' +
@@ -0,0 +1,33 @@
+/**
+ * Test that the TTL monitor deletes expired documents a batch at a time: with a batch size
+ * smaller than the number of expired documents, all of them are still deleted in one pass, and
+ * serverStatus reports the backlog.
+ */
+
+var conn = MongoRunner.runMongod( { setParameter : "ttlDeleteBatchSize=7" } );
+var t = conn.getDB( "test" ).ttl_batched;
+t.drop();
+
+var now = (new Date()).getTime();
+for ( var i = 0; i < 100; i++ ) {
+    t.insert( { x : new Date( now - ( 3600 * 1000 ) ) } );
+}
+for ( var i = 0; i < 10; i++ ) {
+    t.insert( { x : new Date( now ) } );
+}
+t.getDB().getLastError();
+assert.eq( 110 , t.count() );
+
+t.ensureIndex( { x : 1 } , { expireAfterSeconds : 600 } );
+
+assert.soon(
+    function() {
+        return t.count() == 10;
+    }, "TTL index on x didn't delete the expired documents" , 70 * 1000
+);
+
+var ttl = t.getDB().serverStatus().metrics.ttl;
+assert.lte( 100 , ttl.deletedDocuments );
+assert.eq( 0 , ttl.backlog );
+
+MongoRunner.stopMongod( conn );
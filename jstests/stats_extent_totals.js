@@ -0,0 +1,42 @@
+// collStats and dbStats keep extent totals current as extents are added and freed, and agree
+// with a walk of the extents (scanExtents:true).
+
+t = db.jstests_stats_extent_totals;
+t.drop();
+
+function check() {
+    var kept = t.stats();
+    var walked = db.runCommand( { collStats:t.getName(), scanExtents:true } );
+    assert.eq( walked.storageSize, kept.storageSize, tojson( kept ) );
+    assert.eq( walked.numExtents, kept.numExtents, tojson( kept ) );
+
+    kept = db.stats();
+    walked = db.runCommand( { dbStats:1, scanExtents:true } );
+    assert.eq( walked.storageSize, kept.storageSize, tojson( kept ) );
+    assert.eq( walked.numExtents, kept.numExtents, tojson( kept ) );
+}
+
+t.save( { a:1 } );
+check();
+
+// new extents are appended to the collection and its index
+var big = new Array( 4096 ).join( 'x' );
+for( i = 0; i < 2000; ++i ) {
+    t.save( { a:i, big:big } );
+}
+db.getLastError();
+var before = t.stats();
+check();
+assert.gt( t.stats().numExtents, 1 );
+
+// compact frees extents
+t.remove( { a:{ $gt:10 } } );
+assert.commandWorked( t.runCommand( "compact" ) );
+check();
+assert.lt( t.stats().storageSize, before.storageSize );
+
+// a dropped and recreated collection starts over
+t.drop();
+t.save( { a:1 } );
+check();
+assert.eq( 1, t.stats().numExtents );
@@ -67,6 +67,22 @@ function test() {
         }
     }
 
+    t.remove({d: 0});
+    result = db.runCommand({storageDetails: t.getName(), analyze: 'freeLists'});
+    assert.commandWorked(result);
+    assert(result.buckets instanceof Array);
+    var freeRecords = 0;
+    result.buckets.forEach(function(bucket) {
+        assert(isNumber(bucket.maxBytes));
+        freeRecords += bucket.freeRecords;
+    });
+    assert.eq(result.freeRecords, freeRecords);
+    assert.gte(result.freeRecords, 1);
+    assert.lte(result.freeBytes, result.storageBytes);
+    assert.lte(result.unusableFreeBytes, result.freeBytes);
+    assert(isNumber(result.freeRatio));
+    assert.eq(typeof result.compactionRecommended, "boolean");
+
     function checkErrorConditions(helper) {
         var result = helper.apply(t, [{extent: 'a'}]);
         assert.commandFailed(result);
@@ -0,0 +1,42 @@
+// validate with background:true yields while scanning records and checks the indexes from worker
+// threads, reporting the same counts as a foreground validate.
+
+var t = db.validate_background;
+t.drop();
+
+for (var i = 0; i < 5000; i++) {
+    t.insert({ a : i, b : i % 10, c : [ i, -i ] });
+}
+t.ensureIndex({ a : 1 });
+t.ensureIndex({ b : 1 });
+t.ensureIndex({ c : 1 });
+assert.eq(null, db.getLastError());
+
+var fg = t.runCommand("validate", { full : true });
+assert.commandWorked(fg);
+assert(fg.valid, tojson(fg));
+
+var bg = t.runCommand("validate", { full : true, background : true });
+assert.commandWorked(bg);
+assert(bg.valid, tojson(bg));
+assert.eq(fg.nrecords, bg.nrecords);
+assert.eq(fg.objectsFound, bg.objectsFound);
+assert.eq(fg.nIndexes, bg.nIndexes);
+assert.eq(fg.keysPerIndex, bg.keysPerIndex);
+
+// a single worker thread gets through every index too
+var old = db.adminCommand({ setParameter : 1, validateIndexThreads : 1 });
+assert.commandWorked(old);
+try {
+    bg = t.runCommand("validate", { background : true });
+    assert.commandWorked(bg);
+    assert.eq(fg.keysPerIndex, bg.keysPerIndex);
+}
+finally {
+    db.adminCommand({ setParameter : 1, validateIndexThreads : old.was });
+}
+
+assert.commandFailed(db.validate_background_missing.runCommand("validate",
+                                                                { background : true }));
+
+t.drop();
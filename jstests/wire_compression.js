@@ -0,0 +1,28 @@
+// Asking for compression in isMaster makes the server compress large replies on this connection.
+
+var res = db.adminCommand({isMaster: 1, compression: ["snappy"]});
+assert.commandWorked(res);
+assert.eq(["snappy"], res.compression, tojson(res));
+assert.gte(res.maxWireVersion, 2, tojson(res));
+
+// unknown compressors are not accepted
+res = db.adminCommand({isMaster: 1, compression: ["zlib"]});
+assert.eq(undefined, res.compression, tojson(res));
+
+var t = db.wire_compression;
+t.drop();
+
+var big = new Array(1024).join("compressible ");
+for (var i = 0; i < 1000; i++) {
+    t.insert({_id: i, big: big});
+}
+assert.eq(null, db.getLastError());
+
+// replies now come back compressed and must decode to the same documents
+var n = 0;
+t.find().sort({_id: 1}).forEach(function(doc) {
+    assert.eq(n, doc._id);
+    assert.eq(big, doc.big);
+    n++;
+});
+assert.eq(1000, n);
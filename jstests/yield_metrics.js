@@ -0,0 +1,23 @@
+// Tests the yield counters in serverStatus metrics.
+
+var yields = db.serverStatus().metrics.yields;
+assert(yields, "no yields metrics");
+assert.lte(0, yields.useful, tojson(yields));
+assert.lte(0, yields.useless, tojson(yields));
+assert.lte(0, yields.skipped, tojson(yields));
+
+// a yield with nobody waiting for the lock doesn't release it
+var t = db.yield_metrics;
+t.drop();
+for (var i = 0; i < 1000; i++) {
+    t.insert({a: i});
+}
+db.getLastError();
+var before = db.serverStatus().metrics.yields;
+t.remove({a: {$gte: 0}});
+db.getLastError();
+var after = db.serverStatus().metrics.yields;
+assert.lte(before.skipped + before.useful + before.useless,
+           after.skipped + after.useful + after.useless);
+
+t.drop();
@@ -15,7 +15,7 @@
  *    limitations under the License.
  */
 
-#include <deque>
+#include <vector>
 
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
@@ -127,6 +127,42 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The frames of the objects enclosing the current element.  Nearly all documents nest
+         * only a few levels deep, so the first frames are kept inline and validating them
+         * doesn't allocate; deeper frames spill to the heap.
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size( 0 ) {}
+
+            bool empty() const { return _size == 0; }
+
+            ValidationObjectFrame& back() {
+                return _size <= kInlineFrames ? _inline[_size - 1] : _overflow.back();
+            }
+
+            void push_back( const ValidationObjectFrame& frame ) {
+                if ( _size < kInlineFrames )
+                    _inline[_size] = frame;
+                else
+                    _overflow.push_back( frame );
+                _size++;
+            }
+
+            void pop_back() {
+                if ( _size > kInlineFrames )
+                    _overflow.pop_back();
+                _size--;
+            }
+
+        private:
+            static const size_t kInlineFrames = 16;
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::vector<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState) {
             Status status = Status::OK();
 
@@ -222,7 +258,7 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
@@ -213,4 +213,14 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    TEST(BSONValidateFast, DeeplyNestedObject) {
+        // Deeper than the validator keeps inline, so its frames spill to the heap.
+        BSONObj x = BSON("a" << 1);
+        for (int i = 0; i < 40; i++) {
+            x = BSON("a" << x << "b" << i);
+        }
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+        ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
+    }
+
 }
@@ -973,19 +973,28 @@ namespace mutablebson {
             }
         }
 
-        // Not all types are currently permitted to be updated in-place.
+        // Not all types are currently permitted to be updated in-place. Those that are have no
+        // child elements, so a size compatible replacement is a straight copy of the bytes.
         bool canUpdateInPlace(const ElementRep& rep) {
             const BSONType type = getType(rep);
             switch(type) {
             case mongo::NumberDouble:
             case mongo::String:
             case mongo::BinData:
+            case mongo::Undefined:
             case mongo::jstOID:
             case mongo::Bool:
             case mongo::Date:
+            case mongo::jstNULL:
+            case mongo::RegEx:
+            case mongo::DBRef:
+            case mongo::Code:
+            case mongo::Symbol:
             case mongo::NumberInt:
             case mongo::Timestamp:
             case mongo::NumberLong:
+            case mongo::MinKey:
+            case mongo::MaxKey:
                 return true;
             default:
                 return false;
@@ -2602,6 +2602,31 @@ namespace {
         ASSERT_FALSE(doc.isInPlaceModeEnabled());
     }
 
+    TEST(DocumentInPlace, SizeCompatibleSetValueOfOtherScalarTypesIsInPlace) {
+        mongo::BSONObj obj(mongo::fromjson("{ foo : 'abc', bar : null }"));
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::Element foo = doc.root().leftChild();
+        ASSERT_TRUE(foo.ok());
+        ASSERT_OK(foo.setValueCode("xyz"));
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::Element bar = doc.root().rightChild();
+        ASSERT_TRUE(bar.ok());
+        ASSERT_OK(bar.setValueMinKey());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        ASSERT_FALSE(damages.empty());
+        apply(&obj, damages, source);
+        ASSERT_EQUALS(mongo::BSONType(mongo::Code), obj["foo"].type());
+        ASSERT_EQUALS("xyz", obj["foo"]._asCode());
+        ASSERT_EQUALS(mongo::BSONType(mongo::MinKey), obj["bar"].type());
+    }
+
     TEST(DocumentInPlace, DisablingInPlaceDoesNotDiscardUpdates) {
         mongo::BSONObj obj(mongo::fromjson("{ foo : false, bar : true }"));
         mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
@@ -119,7 +119,8 @@ namespace mongo {
             }
         }
 
-        for ( vector<StoredConnection>::iterator i=all.begin(); i != all.end(); ++i ) {
+        // push back in reverse so the most recently used connection stays on top
+        for ( vector<StoredConnection>::reverse_iterator i=all.rbegin(); i != all.rend(); ++i ) {
             _pool.push( *i );
         }
     }
@@ -131,15 +132,18 @@ namespace mongo {
         while ( ! _pool.empty() ) {
             StoredConnection c = _pool.top();
             _pool.pop();
-            
-            if ( c.ok( now ) )
+
+            // the stack is ordered most recently used first, so the connections kept
+            // regardless of idle time are the ones most likely to be used again soon
+            bool keepIdle = static_cast<int>( all.size() ) < minIdlePerHost;
+            if ( c.ok( now ) && ( keepIdle || ! c.idleTooLong( now ) ) )
                 all.push_back( c );
             else
                 stale.push_back( c.conn );
         }
 
-        for ( size_t i=0; i<all.size(); i++ ) {
-            _pool.push( all[i] );
+        for ( vector<StoredConnection>::reverse_iterator i=all.rbegin(); i != all.rend(); ++i ) {
+            _pool.push( *i );
         }
     }
 
@@ -154,10 +158,15 @@ namespace mongo {
         return conn->isStillConnected();
     }
 
-    void PoolForHost::createdOne( DBClientBase * base) {
+    bool PoolForHost::StoredConnection::idleTooLong( time_t now ) const {
+        return maxIdleSecs > 0 && now - when > maxIdleSecs;
+    }
+
+    void PoolForHost::createdOne( DBClientBase * base, long long connectMicros ) {
         if ( _created == 0 )
             _type = base->type();
         _created++;
+        _connectMicros += connectMicros;
     }
 
     void PoolForHost::initializeHostName(const std::string& hostName) {
@@ -167,6 +176,8 @@ namespace mongo {
     }
 
     unsigned PoolForHost::_maxPerHost = 50;
+    int PoolForHost::maxIdleSecs = 0;
+    int PoolForHost::minIdlePerHost = 0;
 
     // ------ DBConnectionPool ------
 
@@ -186,16 +197,24 @@ namespace mongo {
         return p.get( this , socketTimeout );
     }
 
-    DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
+    DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout ,
+                                                   DBClientBase* conn , const Timer& connectTimer ) {
+        try {
+            onCreate( conn );
+        }
+        catch ( std::exception & ) {
+            delete conn;
+            throw;
+        }
+
         {
             scoped_lock L(_mutex);
             PoolForHost& p = _pools[PoolKey(host,socketTimeout)];
             p.initializeHostName(host);
-            p.createdOne( conn );
+            p.createdOne( conn, connectTimer.micros() );
         }
-        
+
         try {
-            onCreate( conn );
             onHandedOut( conn );
         }
         catch ( std::exception & ) {
@@ -219,11 +238,12 @@ namespace mongo {
             return c;
         }
 
+        Timer connectTimer;
         string errmsg;
         c = url.connect( errmsg, socketTimeout );
         uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
 
-        return _finishCreate( url.toString() , socketTimeout , c );
+        return _finishCreate( url.toString() , socketTimeout , c , connectTimer );
     }
 
     DBClientBase* DBConnectionPool::get(const string& host, double socketTimeout) {
@@ -239,6 +259,7 @@ namespace mongo {
             return c;
         }
 
+        Timer connectTimer;
         string errmsg;
         ConnectionString cs = ConnectionString::parse( host , errmsg );
         uassert( 13071 , (string)"invalid hostname [" + host + "]" + errmsg , cs.isValid() );
@@ -246,7 +267,7 @@ namespace mongo {
         c = cs.connect( errmsg, socketTimeout );
         if ( ! c )
             throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
-        return _finishCreate( host , socketTimeout , c );
+        return _finishCreate( host , socketTimeout , c , connectTimer );
     }
 
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
@@ -322,6 +343,7 @@ namespace mongo {
 
         int avail = 0;
         long long created = 0;
+        long long connectMicros = 0;
 
 
         map<ConnectionString::ConnectionType,long long> createdByType;
@@ -340,10 +362,12 @@ namespace mongo {
                 BSONObjBuilder temp( bb.subobjStart( s ) );
                 temp.append( "available" , i->second.numAvailable() );
                 temp.appendNumber( "created" , i->second.numCreated() );
+                temp.appendNumber( "connectMillis" , i->second.connectMicros() / 1000 );
                 temp.done();
 
                 avail += i->second.numAvailable();
                 created += i->second.numCreated();
+                connectMicros += i->second.connectMicros();
 
                 long long& x = createdByType[i->second.type()];
                 x += i->second.numCreated();
@@ -379,6 +403,7 @@ namespace mongo {
 
         b.append( "totalAvailable" , avail );
         b.appendNumber( "totalCreated" , created );
+        b.appendNumber( "totalConnectMillis" , connectMicros / 1000 );
     }
 
     bool DBConnectionPool::serverNameCompare::operator()( const string& a , const string& b ) const{
@@ -22,6 +22,7 @@
 #include "mongo/util/background.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/platform/cstdint.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -35,11 +36,12 @@ namespace mongo {
     class PoolForHost {
     public:
         PoolForHost()
-            : _created(0), _minValidCreationTimeMicroSec(0) {}
+            : _created(0), _connectMicros(0), _minValidCreationTimeMicroSec(0) {}
 
         PoolForHost( const PoolForHost& other ) {
             verify(other._pool.size() == 0);
             _created = other._created;
+            _connectMicros = other._connectMicros;
             _minValidCreationTimeMicroSec = other._minValidCreationTimeMicroSec;
             verify( _created == 0 );
         }
@@ -48,8 +50,13 @@ namespace mongo {
 
         int numAvailable() const { return (int)_pool.size(); }
 
-        void createdOne( DBClientBase * base );
+        /**
+         * @param connectMicros time spent connecting and running the onCreate hooks
+         *     (e.g. authentication) for 'base'
+         */
+        void createdOne( DBClientBase * base, long long connectMicros );
         long long numCreated() const { return _created; }
+        long long connectMicros() const { return _connectMicros; }
 
         ConnectionString::ConnectionType type() const { verify(_created); return _type; }
 
@@ -86,12 +93,21 @@ namespace mongo {
 
         static void setMaxPerHost( unsigned max ) { _maxPerHost = max; }
         static unsigned getMaxPerHost() { return _maxPerHost; }
+
+        /**
+         * Pooled connections left unused for more than this many seconds are closed by the
+         * pool cleaner, except for the minIdlePerHost most recently used ones of each host.
+         * 0 (the default) never closes a connection for being idle.
+         */
+        static int maxIdleSecs;
+        static int minIdlePerHost;
     private:
 
         struct StoredConnection {
             StoredConnection( DBClientBase * c );
 
             bool ok( time_t now );
+            bool idleTooLong( time_t now ) const;
 
             DBClientBase* conn;
             time_t when;
@@ -101,6 +117,7 @@ namespace mongo {
         std::stack<StoredConnection> _pool;
         
         int64_t _created;
+        int64_t _connectMicros;
         uint64_t _minValidCreationTimeMicroSec;
         ConnectionString::ConnectionType _type;
 
@@ -186,7 +203,8 @@ namespace mongo {
         
         DBClientBase* _get( const string& ident , double socketTimeout );
 
-        DBClientBase* _finishCreate( const string& ident , double socketTimeout, DBClientBase* conn );
+        DBClientBase* _finishCreate( const string& ident , double socketTimeout, DBClientBase* conn,
+                                     const Timer& connectTimer );
         
         struct PoolKey {
             PoolKey( const std::string& i , double t ) : ident( i ) , timeout( t ) {}
@@ -31,6 +31,7 @@
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/md5.hpp"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 
@@ -892,11 +893,37 @@ namespace mongo {
         }
 
 #ifdef MONGO_SSL
-        if (sslGlobalParams.sslOnNormalPorts) {
-            return p->secure( sslManager() );
+        if (sslGlobalParams.sslOnNormalPorts && !p->secure( sslManager() )) {
+            return false;
         }
 #endif
 
+        if (isWireCompressionEnabled()) {
+            return _negotiateCompression( errmsg );
+        }
+
+        return true;
+    }
+
+    bool DBClientConnection::_negotiateCompression( string& errmsg ) {
+        BSONObjBuilder cmd;
+        cmd.append( "isMaster", 1 );
+        appendWireCompressionRequest( &cmd );
+
+        try {
+            BSONObj info;
+            // servers that do not know about compression ignore the extra field
+            if ( DBClientWithCommands::runCommand( "admin", cmd.obj(), info ) &&
+                 acceptsWireCompression( info ) ) {
+                p->setCompressionEnabled( true );
+            }
+        }
+        catch ( const DBException& e ) {
+            errmsg = str::stream() << "couldn't negotiate compression with "
+                                   << _server.toString() << causedBy( e );
+            _failed = true;
+            return false;
+        }
         return true;
     }
 
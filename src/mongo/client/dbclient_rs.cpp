@@ -19,6 +19,7 @@
 
 #include "mongo/client/dbclient_rs.h"
 
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <memory>
 
@@ -32,6 +33,7 @@
 #include "mongo/db/json.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/mutex.h" // for StaticObserver
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/timer.h"
 
@@ -96,6 +98,19 @@ namespace mongo {
             go();
         }
 
+        /**
+         * Asks for the named set to be checked now rather than at the next sweep.
+         */
+        void requestCheck( const string& setName ) {
+            if ( StaticObserver::_destroyingStatics ) {
+                return;
+            }
+
+            scoped_lock sl( _monitorMutex );
+            _checkRequested.insert( setName );
+            _stopRequestedCV.notify_one();
+        }
+
         /**
          * Stops monitoring the sets and wait for the monitoring thread to terminate.
          */
@@ -118,17 +133,25 @@ namespace mongo {
                 _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
             }
 
+            boost::system_time nextSweep;
             while ( !inShutdown() &&
                     !StaticObserver::_destroyingStatics ) {
+                set<string> checkRequested;
                 {
                     scoped_lock sl( _monitorMutex );
                     if (_stopRequested) {
                         break;
                     }
+                    checkRequested.swap( _checkRequested );
                 }
 
                 try {
-                    ReplicaSetMonitor::checkAll();
+                    if ( checkRequested.empty() ) {
+                        ReplicaSetMonitor::checkAll();
+                    }
+                    else {
+                        ReplicaSetMonitor::checkSets( checkRequested );
+                    }
                 }
                 catch ( std::exception& e ) {
                     error() << "check failed: " << e.what() << endl;
@@ -142,7 +165,14 @@ namespace mongo {
                     break;
                 }
 
-                _stopRequestedCV.timed_wait(sl.boost(), boost::posix_time::seconds(10));
+                // sleep until the next sweep, unless a set asks to be checked first
+                if ( checkRequested.empty() ) {
+                    nextSweep = boost::get_system_time() + boost::posix_time::seconds(10);
+                }
+                while ( _checkRequested.empty() && !_stopRequested &&
+                        boost::get_system_time() < nextSweep ) {
+                    _stopRequestedCV.timed_wait(sl.boost(), nextSweep);
+                }
             }
 
             scoped_lock sl( _monitorMutex );
@@ -156,6 +186,9 @@ namespace mongo {
         boost::condition _stopRequestedCV;
         bool _stopRequested;
 
+        // sets to check before the next sweep, protected by _monitorMutex
+        set<string> _checkRequested;
+
     } replicaSetMonitorWatcher;
 
     static StaticObserver staticObserver;
@@ -527,38 +560,101 @@ namespace mongo {
     }
 
     void ReplicaSetMonitor::checkAll() {
-        set<string> seen;
+        vector<ReplicaSetMonitorPtr> monitors;
+        {
+            scoped_lock lk( _setsLock );
+            for ( map<string,ReplicaSetMonitorPtr>::iterator i=_sets.begin(); i!=_sets.end(); ++i ) {
+                monitors.push_back( i->second );
+            }
+        }
 
-        while ( true ) {
-            ReplicaSetMonitorPtr m;
-            {
-                scoped_lock lk( _setsLock );
-                for ( map<string,ReplicaSetMonitorPtr>::iterator i=_sets.begin(); i!=_sets.end(); ++i ) {
-                    string name = i->first;
-                    if ( seen.count( name ) )
-                        continue;
-                    LOG(1) << "checking replica set: " << name << endl;
-                    seen.insert( name );
-                    m = i->second;
-                    break;
+        _checkConcurrently( monitors );
+    }
+
+    void ReplicaSetMonitor::checkSets( const set<string>& setNames ) {
+        vector<ReplicaSetMonitorPtr> monitors;
+        {
+            scoped_lock lk( _setsLock );
+            for ( set<string>::const_iterator i = setNames.begin(); i != setNames.end(); ++i ) {
+                map<string,ReplicaSetMonitorPtr>::iterator it = _sets.find( *i );
+                if ( it != _sets.end() ) {
+                    monitors.push_back( it->second );
                 }
             }
+        }
 
-            if ( ! m )
-                break;
+        _checkConcurrently( monitors );
+    }
 
-            m->check();
-            {
-                scoped_lock lk( _setsLock );
-                if ( m->_failedChecks >= _maxFailedChecks ) {
-                    log() << "Replica set " << m->getName() << " was down for " << m->_failedChecks
-                          << " checks in a row. Stopping polled monitoring of the set." << endl;
-                    _remove_inlock( m->getName() );
+    namespace {
+        /** hands the monitors of one pass out to the checking threads */
+        class MonitorQueue {
+        public:
+            MonitorQueue( const vector<ReplicaSetMonitorPtr>& monitors ) :
+                _mutex( "ReplicaSetMonitor::MonitorQueue" ),
+                _monitors( monitors ),
+                _next( 0 ) {
+            }
+
+            ReplicaSetMonitorPtr next() {
+                scoped_lock lk( _mutex );
+                if ( _next == _monitors.size() ) {
+                    return ReplicaSetMonitorPtr();
                 }
+                return _monitors[_next++];
+            }
+
+        private:
+            mongo::mutex _mutex;
+            const vector<ReplicaSetMonitorPtr>& _monitors;
+            size_t _next; // protected by _mutex
+        };
+
+        void checkQueued( MonitorQueue* queue, void (*checkOne)( const ReplicaSetMonitorPtr& ) ) {
+            setThreadName( "ReplicaSetMonitorCheck" );
+            while ( ReplicaSetMonitorPtr m = queue->next() ) {
+                checkOne( m );
             }
         }
+    }
 
+    void ReplicaSetMonitor::_checkConcurrently( const vector<ReplicaSetMonitorPtr>& monitors ) {
+        size_t numThreads = std::min( monitors.size(),
+                                      static_cast<size_t>( std::max( _maxConcurrentChecks, 1 ) ) );
+        if ( numThreads <= 1 ) {
+            for ( size_t i = 0; i < monitors.size(); i++ ) {
+                _checkAndReap( monitors[i] );
+            }
+            return;
+        }
 
+        MonitorQueue queue( monitors );
+        boost::thread_group threads;
+        for ( size_t i = 0; i < numThreads; i++ ) {
+            threads.create_thread( boost::bind( checkQueued, &queue, &_checkAndReap ) );
+        }
+        threads.join_all();
+    }
+
+    void ReplicaSetMonitor::_checkAndReap( const ReplicaSetMonitorPtr& m ) {
+        LOG(1) << "checking replica set: " << m->getName() << endl;
+
+        try {
+            m->check();
+        }
+        catch ( std::exception& e ) {
+            error() << "check of replica set " << m->getName() << " failed: " << e.what() << endl;
+        }
+        catch ( ... ) {
+            error() << "check of replica set " << m->getName() << " failed: unknown error" << endl;
+        }
+
+        scoped_lock lk( _setsLock );
+        if ( m->_failedChecks >= _maxFailedChecks ) {
+            log() << "Replica set " << m->getName() << " was down for " << m->_failedChecks
+                  << " checks in a row. Stopping polled monitoring of the set." << endl;
+            _remove_inlock( m->getName() );
+        }
     }
 
     void ReplicaSetMonitor::remove( const string& name, bool clearSeedCache ) {
@@ -614,14 +710,19 @@ namespace mongo {
     
 
     void ReplicaSetMonitor::notifyFailure( const HostAndPort& server ) {
-        scoped_lock lk( _lock );
-        
-        if ( _master >= 0 && _master < (int)_nodes.size() ) {
-            if ( server == _nodes[_master].addr ) {
-                _nodes[_master].ok = false; 
-                _master = -1;
+        {
+            scoped_lock lk( _lock );
+
+            if ( _master < 0 || _master >= (int)_nodes.size() ||
+                 server != _nodes[_master].addr ) {
+                return;
             }
+
+            _nodes[_master].ok = false;
+            _master = -1;
         }
+
+        replicaSetMonitorWatcher.requestCheck( _name );
     }
 
 
@@ -724,11 +825,16 @@ namespace mongo {
      * notify the monitor that server has failed
      */
     void ReplicaSetMonitor::notifySlaveFailure( const HostAndPort& server ) {
-        scoped_lock lk( _lock );
-        int x = _find_inlock( server );
-        if ( x >= 0 ) {
+        {
+            scoped_lock lk( _lock );
+            int x = _find_inlock( server );
+            if ( x < 0 || !_nodes[x].ok ) {
+                return;
+            }
             _nodes[x].ok = false;
         }
+
+        replicaSetMonitorWatcher.requestCheck( _name );
     }
 
     NodeDiff ReplicaSetMonitor::_getHostDiff_inlock( const BSONObj& hostList ){
@@ -1407,6 +1513,7 @@ namespace mongo {
 
     ReplicaSetMonitor::ConfigChangeHook ReplicaSetMonitor::_hook;
     int ReplicaSetMonitor::_maxFailedChecks = 30; // At 1 check every 10 seconds, 30 checks takes 5 minutes
+    int ReplicaSetMonitor::_maxConcurrentChecks = 16;
 
     // --------------------------------
     // ----- DBClientReplicaSet ---------
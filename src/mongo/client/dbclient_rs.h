@@ -199,10 +199,21 @@ namespace mongo {
 
         /**
          * checks all sets for current master and new secondaries
+         * up to getMaxConcurrentChecks() sets are checked at once, so a set with unreachable
+         * members doesn't hold up failover detection for the others
          * usually only called from a BackgroundJob
          */
         static void checkAll();
 
+        /**
+         * like checkAll(), for the named sets only
+         * used for the re-checks requested by notifyFailure() and notifySlaveFailure()
+         */
+        static void checkSets( const set<string>& setNames );
+
+        static int getMaxConcurrentChecks() { return _maxConcurrentChecks; }
+        static void setMaxConcurrentChecks(int numChecks) { _maxConcurrentChecks = numChecks; }
+
         /**
          * Removes the ReplicaSetMonitor for the given set name from _sets, which will delete it.
          * If clearSeedCache is true, then the cached seed string for this Replica Set will be removed
@@ -241,6 +252,7 @@ namespace mongo {
 
         /**
          * notify the monitor that server has faild
+         * if it was the master, the set is re-checked right away instead of at the next sweep
          */
         void notifyFailure( const HostAndPort& server );
 
@@ -259,6 +271,7 @@ namespace mongo {
 
         /**
          * notify the monitor that server has faild
+         * if it was considered up, the set is re-checked right away instead of at the next sweep
          */
         void notifySlaveFailure( const HostAndPort& server );
 
@@ -306,6 +319,12 @@ namespace mongo {
 
         static void _remove_inlock( const string& name, bool clearSeedCache = false );
 
+        /** checks the monitors on up to _maxConcurrentChecks threads */
+        static void _checkConcurrently( const vector<ReplicaSetMonitorPtr>& monitors );
+
+        /** checks one set and stops monitoring it if it has been down for too long */
+        static void _checkAndReap( const ReplicaSetMonitorPtr& monitor );
+
         /**
          * Checks all connections from the host list and sets the current
          * master.
@@ -412,6 +431,7 @@ namespace mongo {
         int _localThresholdMillis; // local ping latency threshold (protected by _lock)
 
         static int _maxFailedChecks;
+        static int _maxConcurrentChecks;
     };
 
     /** Use this class to connect to a replica set of servers.  The class will manage
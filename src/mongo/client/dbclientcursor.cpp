@@ -31,6 +31,7 @@ namespace mongo {
 
     void DBClientCursor::_finishConsInit() {
         _originalHost = _client->toString();
+        _prefetchConn = NULL;
     }
 
     int DBClientCursor::nextBatchSize() {
@@ -118,18 +119,8 @@ namespace mongo {
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
-        if (haveLimit) {
-            nToReturn -= batch.nReturned;
-            verify(nToReturn > 0);
-        }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
-
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -149,6 +140,67 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        if (haveLimit) {
+            nToReturn -= batch.nReturned;
+            verify(nToReturn > 0);
+        }
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    void DBClientCursor::prefetchMore() {
+        if ( _prefetchConn || _client || _scopedHost.empty() )
+            return;
+
+        if ( !_putBack.empty() || batch.pos < batch.nReturned || cursorId == 0 )
+            return;
+
+        if (haveLimit && batch.pos >= nToReturn)
+            return;
+
+        auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+        if ( !conn->get()->lazySupported() ) {
+            // can't split the call, leave the getMore to more()
+            conn->done();
+            return;
+        }
+
+        Message toSend;
+        _assembleGetMore( toSend );
+        conn->get()->say( toSend );
+        _prefetchConn = conn.release();
+    }
+
+    void DBClientCursor::receivePrefetched() {
+        verify( _prefetchConn );
+        scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+        _prefetchConn = NULL;
+
+        auto_ptr<Message> response(new Message());
+        if ( !conn->get()->recv( *response ) ) {
+            // conn is not done(), so the half-used connection is not returned to the pool
+            uasserted(17200, "recv failed while receiving prefetched getMore");
+        }
+
+        _client = conn->get();
+        this->batch.m = response;
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _client = 0;
+            throw;
+        }
+        _client = 0;
+        conn->done();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -209,6 +261,11 @@ namespace mongo {
         if ( !_putBack.empty() )
             return true;
 
+        if ( _prefetchConn ) {
+            receivePrefetched();
+            return batch.pos < batch.nReturned;
+        }
+
         if (haveLimit && batch.pos >= nToReturn)
             return false;
 
@@ -313,6 +370,11 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        // an unanswered getMore leaves the connection unusable; dropping it without done()
+        // closes it
+        delete _prefetchConn;
+        _prefetchConn = NULL;
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
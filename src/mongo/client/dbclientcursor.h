@@ -29,6 +29,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here 
         @see DBClientMockCursor
@@ -57,6 +58,9 @@ namespace mongo {
         int objsLeftInBatch() const { _assertIfNull(); return _putBack.size() + batch.nReturned - batch.pos; }
         bool moreInCurrentBatch() { return objsLeftInBatch() > 0; }
 
+        /** @return the size of the reply this cursor is holding, read or not */
+        int bufferedBytes() const { return batch.m->empty() ? 0 : batch.m->size(); }
+
         /** next
            @return next object in the result cursor.
            on an error at the remote server, you will get back:
@@ -177,6 +181,14 @@ namespace mongo {
 
         void attach( AScopedConnection * conn );
 
+        /**
+         * Once the current batch is used up, sends the getMore for the next one without waiting
+         * for the reply, so the server builds it while the caller works on something else.  The
+         * next more() receives it.  Only a cursor attach()ed to a pooled connection prefetches;
+         * for any other cursor this does nothing.
+         */
+        void prefetchMore();
+
         string originalHost() const { return _originalHost; }
 
         string getns() const { return ns; }
@@ -241,6 +253,10 @@ namespace mongo {
         void dataReceived( bool& retry, string& lazyHost );
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
+        void receivePrefetched();
+
+        // holds the pooled connection while a getMore sent by prefetchMore() is unanswered
+        ScopedDbConnection* _prefetchConn;
 
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
@@ -251,6 +267,7 @@ namespace mongo {
 
         // init pieces
         void _assembleInit( Message& toSend );
+        void _assembleGetMore( Message& toSend );
     };
 
     /** iterate over objects in current batch only - will not cause a network call
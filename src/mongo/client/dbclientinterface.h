@@ -1292,6 +1292,8 @@ namespace mongo {
         map<string, BSONObj> authCache;
         double _so_timeout;
         bool _connect( string& errmsg );
+        // asks the server, via isMaster, to exchange compressed messages on this connection
+        bool _negotiateCompression( string& errmsg );
 
         static AtomicUInt _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
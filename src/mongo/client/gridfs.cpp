@@ -40,6 +40,9 @@ namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 256 * 1024;
 
+    // chunks are inserted in batches of about this many bytes, rather than one round trip each
+    const int CHUNK_INSERT_BATCH_BYTES = 8 * 1024 * 1024;
+
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
     }
@@ -82,15 +85,18 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        vector<BSONObj> chunks;
+        int bytes = 0;
         int chunkNumber = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            queueChunk( &chunks , &bytes , c );
 
             chunkNumber++;
             data += chunkLen;
         }
+        insertChunks( &chunks , &bytes );
 
         return insertFile(remoteName, id, length, contentType);
     }
@@ -110,6 +116,8 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        vector<BSONObj> chunks;
+        int bytes = 0;
         int chunkNumber = 0;
         gridfs_offset length = 0;
         while (!feof(fd)) {
@@ -126,12 +134,13 @@ namespace mongo {
             }
 
             GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            queueChunk( &chunks , &bytes , c );
 
             length += chunkLen;
             chunkNumber++;
             delete[] buf;
         }
+        insertChunks( &chunks , &bytes );
 
         if (fd != stdin)
             fclose( fd );
@@ -139,6 +148,20 @@ namespace mongo {
         return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
     }
 
+    void GridFS::queueChunk( vector<BSONObj>* chunks , int* bytes , const GridFSChunk& chunk ) {
+        chunks->push_back( chunk._data );
+        *bytes += chunk._data.objsize();
+        if ( *bytes >= CHUNK_INSERT_BATCH_BYTES )
+            insertChunks( chunks , bytes );
+    }
+
+    void GridFS::insertChunks( vector<BSONObj>* chunks , int* bytes ) {
+        if ( ! chunks->empty() )
+            _client.insert( _chunksNS , *chunks );
+        chunks->clear();
+        *bytes = 0;
+    }
+
     BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType) {
         // Wait for any pending writebacks to finish
         BSONObj errObj = _client.getLastErrorDetailed();
@@ -229,18 +252,51 @@ namespace mongo {
 
     gridfs_offset GridFile::write( ostream & out ) const {
         _exists();
+        writeRange( out , 0 , getContentLength() );
+        return getContentLength();
+    }
+
+    gridfs_offset GridFile::writeRange( ostream & out , gridfs_offset offset , gridfs_offset length ) const {
+        _exists();
+
+        const gridfs_offset contentLength = getContentLength();
+        if ( offset >= contentLength || length == 0 )
+            return 0;
+        length = std::min( length , contentLength - offset );
+
+        const gridfs_offset chunkSize = getChunkSize();
+        const int firstChunk = (int)( offset / chunkSize );
+        const int lastChunk = (int)( ( offset + length - 1 ) / chunkSize );
+
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        b.append( "n" , BSON( "$gte" << firstChunk << "$lte" << lastChunk ) );
+        Query query = Query( b.obj() ).sort( BSON( "files_id" << 1 << "n" << 1 ) );
 
-        const int num = getNumChunks();
+        auto_ptr<DBClientCursor> cursor = _grid->_client.query( _grid->_chunksNS , query );
+        uassert( 17321 , "couldn't query chunks" , cursor.get() );
 
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        gridfs_offset written = 0;
+        for ( int n = firstChunk; n <= lastChunk; n++ ) {
+            uassert( 10014 , "chunk is empty!" , cursor->more() );
+            GridFSChunk c( cursor->nextSafe() );
+            uassert( 17322 , str::stream() << "missing chunk " << n ,
+                     c._data["n"].numberInt() == n );
 
             int len;
             const char * data = c.data( len );
-            out.write( data , len );
+
+            // only the first and last chunks can be partly in the range
+            gridfs_offset chunkStart = (gridfs_offset)n * chunkSize;
+            gridfs_offset skip = offset > chunkStart ? offset - chunkStart : 0;
+            if ( skip >= (gridfs_offset)len )
+                continue;
+            gridfs_offset toWrite = std::min( (gridfs_offset)len - skip , length - written );
+            out.write( data + skip , toWrite );
+            written += toWrite;
         }
 
-        return getContentLength();
+        return written;
     }
 
     gridfs_offset GridFile::write( const string& where ) const {
@@ -46,6 +46,7 @@ namespace mongo {
     private:
         BSONObj _data;
         friend class GridFS;
+        friend class GridFile;
     };
 
 
@@ -131,6 +132,10 @@ namespace mongo {
         // insert fileobject. All chunks must be in DB.
         BSONObj insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType);
 
+        // queue a chunk for insertion, inserting the queued chunks once they are big enough
+        void queueChunk( vector<BSONObj>* chunks , int* bytes , const GridFSChunk& chunk );
+        void insertChunks( vector<BSONObj>* chunks , int* bytes );
+
         friend class GridFile;
     };
 
@@ -188,6 +193,13 @@ namespace mongo {
          */
         gridfs_offset write( ostream & out ) const;
 
+        /**
+           write "length" bytes of the file, starting at byte "offset", to the output stream.
+           the chunks are read with one query, in batches.
+           @return the number of bytes written, less than "length" at the end of the file
+         */
+        gridfs_offset writeRange( ostream & out , gridfs_offset offset , gridfs_offset length ) const;
+
         /**
            write the file to this filename
          */
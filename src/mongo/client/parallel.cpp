@@ -341,6 +341,17 @@ namespace mongo {
         _done = cursor == 0;
     }
 
+    void FilteringClientCursor::setOwnershipFilter( ChunkManagerPtr manager, const Shard& shard ) {
+        _ownerManager = manager;
+        _owner = shard;
+    }
+
+    bool FilteringClientCursor::_isOwned( const BSONObj& doc ) const {
+        if ( ! _ownerManager->hasShardKey( doc ) )
+            return true;
+
+        return _ownerManager->findChunkForDoc( doc )->getShard() == _owner;
+    }
 
     bool FilteringClientCursor::more() {
         if ( ! _next.isEmpty() )
@@ -376,9 +387,13 @@ namespace mongo {
 
         while ( _cursor->more() ) {
             _next = _cursor->next();
-            if ( _matcher.matches( _next ) ) {
-                if ( ! _cursor->moreInCurrentBatch() )
+            if ( _matcher.matches( _next ) &&
+                 ( ! _ownerManager || _isOwned( _next ) ) ) {
+                if ( ! _cursor->moreInCurrentBatch() ) {
                     _next = _next.getOwned();
+                    // start fetching the next batch while the other shards are read
+                    _cursor->prefetchMore();
+                }
                 return;
             }
             _next = BSONObj();
@@ -624,6 +639,18 @@ namespace mongo {
                      "errored" << errored );
     }
 
+    long long ParallelSortClusteredCursor::bufferedBytes() {
+        if ( ! _cursors )
+            return 0;
+
+        long long bytes = 0;
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _cursors[i].raw() )
+                bytes += _cursors[i].raw()->bufferedBytes();
+        }
+        return bytes;
+    }
+
     BSONObj ParallelSortClusteredCursor::toBSON() const {
 
         BSONObjBuilder b;
@@ -1259,6 +1286,13 @@ namespace mongo {
             PCMData& mdata = i->second;
 
             _cursors[ index ].reset( mdata.pcState->cursor.get(), &mdata );
+
+            // Secondaries don't track chunk ownership, so orphans and documents of chunks
+            // migrated away may come back from them; drop those here instead
+            if ( ( _qSpec.options() & QueryOption_SlaveOk ) &&
+                 mdata.pcState->manager && ! isCommand() && ! isExplain() ) {
+                _cursors[ index ].setOwnershipFilter( mdata.pcState->manager, i->first );
+            }
             _servers.insert( ServerAndQuery( i->first.getConnString(), BSONObj() ) );
 
             index++;
@@ -90,6 +90,9 @@ namespace mongo {
 
         virtual void explain(BSONObjBuilder& b) = 0;
 
+        /** @return the bytes of shard replies this cursor is holding */
+        virtual long long bufferedBytes() { return 0; }
+
     protected:
 
         virtual void _init() = 0;
@@ -134,6 +137,14 @@ namespace mongo {
         void reset( auto_ptr<DBClientCursor> cursor );
         void reset( DBClientCursor* cursor, ParallelConnectionMetadata* _pcmData = NULL );
 
+        /**
+         * Only return documents whose shard key falls in a chunk that 'manager' places on
+         * 'shard'.  Used for slaveOk reads, since secondaries do not filter out orphaned
+         * documents themselves.  Documents without the full shard key (e.g. projected
+         * away) are returned unfiltered.
+         */
+        void setOwnershipFilter( ChunkManagerPtr manager, const Shard& shard );
+
         bool more();
         BSONObj next();
 
@@ -150,8 +161,11 @@ namespace mongo {
 
     private:
         void _advance();
+        bool _isOwned( const BSONObj& doc ) const;
 
         Matcher _matcher;
+        ChunkManagerPtr _ownerManager;
+        Shard _owner;
         auto_ptr<DBClientCursor> _cursor;
         ParallelConnectionMetadata* _pcmData;
 
@@ -363,6 +377,8 @@ namespace mongo {
 
         virtual void explain(BSONObjBuilder& b);
 
+        virtual long long bufferedBytes();
+
     protected:
         void _finishCons();
         void _init();
@@ -218,6 +218,8 @@ namespace mongo_test {
             delete _dummyServer;
 
             mongo::PoolForHost::setMaxPerHost(_maxPoolSizePerHost);
+            mongo::PoolForHost::maxIdleSecs = 0;
+            mongo::PoolForHost::minIdlePerHost = 0;
         }
 
     protected:
@@ -402,4 +404,34 @@ namespace mongo_test {
 
         conn1Again.done();
     }
+
+    TEST_F(DummyServerFixture, PruneIdleConnsKeepingMostRecent) {
+        mongo::PoolForHost::maxIdleSecs = 1;
+        mongo::PoolForHost::minIdlePerHost = 1;
+
+        ScopedDbConnection conn1(TARGET_HOST);
+        ScopedDbConnection conn2(TARGET_HOST);
+        ScopedDbConnection conn3(TARGET_HOST);
+
+        const uint64_t conn3CreationTime = conn3->getSockCreationMicroSec();
+
+        conn1.done();
+        conn2.done();
+        conn3.done();
+
+        mongo::sleepsecs(3);
+        mongo::pool.taskDoWork();
+
+        const uint64_t afterPruneTime = mongo::curTimeMicros64();
+
+        // only the most recently returned connection survives
+        ScopedDbConnection conn3Again(TARGET_HOST);
+        ASSERT_EQUALS(conn3CreationTime, conn3Again->getSockCreationMicroSec());
+
+        ScopedDbConnection newConn(TARGET_HOST);
+        ASSERT_GREATER_THAN(newConn->getSockCreationMicroSec(), afterPruneTime);
+
+        conn3Again.done();
+        newConn.done();
+    }
 }
@@ -30,6 +30,7 @@
 
 #include "mongo/db/auth/authorization_manager.h"
 
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <memory>
 #include <string>
@@ -347,39 +348,73 @@ namespace mongo {
     }
 
     Status AuthorizationManager::acquireUser(const UserName& userName, User** acquiredUser) {
-        boost::lock_guard<boost::mutex> lk(_lock);
-        unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
-        if (it != _userCache.end()) {
-            fassert(16914, it->second);
-            fassert(17003, it->second->isValid());
-            fassert(17008, it->second->getRefCount() > 0);
-            it->second->incrementRefCount();
-            *acquiredUser = it->second;
-            return Status::OK();
-        }
+        boost::unique_lock<boost::mutex> lk(_lock);
+        while (true) {
+            unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
+            if (it != _userCache.end()) {
+                fassert(16914, it->second);
+                fassert(17003, it->second->isValid());
+                fassert(17008, it->second->getRefCount() > 0);
+                it->second->incrementRefCount();
+                *acquiredUser = it->second;
+                return Status::OK();
+            }
+
+            if (_getVersion_inlock() != 2) {
+                return Status(ErrorCodes::UserNotFound, mongoutils::str::stream() <<
+                              "User " << userName.getFullName() << " not found.");
+            }
+
+            if (!_usersBeingFetched.count(userName))
+                break;
 
-        if (_getVersion_inlock() != 2) {
-            return Status(ErrorCodes::UserNotFound, mongoutils::str::stream() <<
-                          "User " << userName.getFullName() << " not found.");
+            // Another thread is reading this user's privilege documents; use its result.
+            _fetchedUserCondition.wait(lk);
         }
 
+        // Read the privilege documents without holding _lock, so that one slow read (from the
+        // config servers, on mongos) doesn't hold up acquiring every other user.
+        _usersBeingFetched.insert(userName);
+        const unsigned long long generation = _cacheGeneration.load();
+        lk.unlock();
+
         // Put the new user into an auto_ptr temporarily in case there's an error while
         // initializing the user.
         auto_ptr<User> userHolder(new User(userName));
         User* user = userHolder.get();
 
-        BSONObj userObj;
-        Status status = getUserDescription(userName, &userObj);
-        if (!status.isOK()) {
-            return status;
+        Status status = Status::OK();
+        try {
+            BSONObj userObj;
+            status = getUserDescription(userName, &userObj);
+            if (status.isOK()) {
+                status = _initializeUserFromPrivilegeDocument(user, userObj);
+            }
+        }
+        catch (...) {
+            lk.lock();
+            _usersBeingFetched.erase(userName);
+            _fetchedUserCondition.notify_all();
+            throw;
         }
 
-        status = _initializeUserFromPrivilegeDocument(user, userObj);
+        lk.lock();
+        _usersBeingFetched.erase(userName);
+        _fetchedUserCondition.notify_all();
         if (!status.isOK()) {
             return status;
         }
 
         user->incrementRefCount();
+        if (_cacheGeneration.load() != generation) {
+            // The user cache was invalidated while we read the documents, which may predate the
+            // change.  Hand out the user without caching it, already marked out of date, so the
+            // caller's next check acquires it again.
+            user->invalidate();
+            *acquiredUser = userHolder.release();
+            return Status::OK();
+        }
+
         _userCache.insert(make_pair(userName, userHolder.release()));
         *acquiredUser = user;
         return Status::OK();
@@ -416,6 +451,7 @@ namespace mongo {
                 it != _userCache.end() && it->second == user);
         _userCache.erase(it);
         user->invalidate();
+        _cacheGeneration.fetchAndAdd(1);
     }
 
     void AuthorizationManager::invalidateUserByName(const UserName& userName) {
@@ -429,6 +465,7 @@ namespace mongo {
         User* user = it->second;
         _userCache.erase(it);
         user->invalidate();
+        _cacheGeneration.fetchAndAdd(1);
     }
 
     void AuthorizationManager::invalidateUsersFromDB(const std::string& dbname) {
@@ -444,6 +481,7 @@ namespace mongo {
                 ++it;
             }
         }
+        _cacheGeneration.fetchAndAdd(1);
     }
 
 
@@ -474,6 +512,7 @@ namespace mongo {
             //     delete it->second;
         }
         _userCache.clear();
+        _cacheGeneration.fetchAndAdd(1);
         // Make sure the internal user stays in the cache.
         _userCache.insert(make_pair(internalSecurity.user->getName(), internalSecurity.user));
     }
@@ -30,6 +30,7 @@
 
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <string>
 
@@ -44,7 +45,9 @@
 #include "mongo/db/auth/user_name_hash.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/platform/unordered_set.h"
 
 namespace mongo {
 
@@ -142,6 +145,12 @@ namespace mongo {
         // Returns true if there exists at least one privilege document in the system.
         bool hasAnyPrivilegeDocuments() const;
 
+        /**
+         * Returns a number that changes whenever a cached User is invalidated.  Authorization
+         * decisions derived from User objects stay good for as long as it is unchanged.
+         */
+        unsigned long long getCacheGeneration() const { return _cacheGeneration.load(); }
+
         /**
          * Creates the given user object in the given database.
          * 'writeConcern' contains the arguments to be passed to getLastError to block for
@@ -410,7 +419,20 @@ namespace mongo {
         unordered_map<UserName, User*> _userCache;
 
         /**
-         * Protects _userCache and _version.
+         * Incremented every time a User is invalidated.  Read without _lock.
+         */
+        AtomicUInt64 _cacheGeneration;
+
+        /**
+         * Users whose privilege documents some thread is reading, with _lock released.  Other
+         * threads acquiring the same user wait on _fetchedUserCondition rather than read them
+         * too.
+         */
+        unordered_set<UserName> _usersBeingFetched;
+        boost::condition_variable _fetchedUserCondition;
+
+        /**
+         * Protects _userCache, _usersBeingFetched and _version.
          */
         boost::mutex _lock;
     };
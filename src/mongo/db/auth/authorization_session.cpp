@@ -49,9 +49,13 @@ namespace mongo {
 
 namespace {
     const std::string ADMIN_DBNAME = "admin";
+
+    // Bound on the number of resources whose granted actions a session remembers.
+    const size_t maxGrantedActionsCacheSize = 1000;
 }  // namespace
 
-    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) {
+    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) :
+        _grantedActionsGeneration(0) {
         _externalState.reset(externalState);
     }
 
@@ -83,6 +87,7 @@ namespace {
         if (replacedUser) {
             getAuthorizationManager().releaseUser(replacedUser);
         }
+        _clearGrantedActionsCache();
 
         return Status::OK();
     }
@@ -96,6 +101,7 @@ namespace {
         if (removedUser) {
             getAuthorizationManager().releaseUser(removedUser);
         }
+        _clearGrantedActionsCache();
     }
 
     UserSet::NameIterator AuthorizationSession::getAuthenticatedUserNames() {
@@ -116,6 +122,7 @@ namespace {
 
     void AuthorizationSession::grantInternalAuthorization() {
         _authenticatedUsers.add(internalSecurity.user);
+        _clearGrantedActionsCache();
     }
 
     Status AuthorizationSession::checkAuthForQuery(const NamespaceString& ns,
@@ -287,13 +294,38 @@ namespace {
     }
 
     bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
-        AuthorizationManager& authMan = getAuthorizationManager();
         const ResourcePattern& target(privilege.getResourcePattern());
 
+        // Read the generation before computing anything, so that an invalidation racing with
+        // _getGrantedActions() discards what it computed.
+        const unsigned long long generation = getAuthorizationManager().getCacheGeneration();
+        if (generation != _grantedActionsGeneration) {
+            _clearGrantedActionsCache();
+            _grantedActionsGeneration = generation;
+        }
+
+        GrantedActionsCache::const_iterator cached = _grantedActionsCache.find(target);
+        if (cached != _grantedActionsCache.end())
+            return cached->second.isSupersetOf(privilege.getActions());
+
+        bool cacheable = true;
+        ActionSet granted = _getGrantedActions(target, &cacheable);
+        if (cacheable && getAuthorizationManager().getCacheGeneration() == generation) {
+            if (_grantedActionsCache.size() >= maxGrantedActionsCacheSize)
+                _grantedActionsCache.clear();
+            _grantedActionsCache[target] = granted;
+        }
+        return granted.isSupersetOf(privilege.getActions());
+    }
+
+    ActionSet AuthorizationSession::_getGrantedActions(const ResourcePattern& target,
+                                                       bool* cacheable) {
+        AuthorizationManager& authMan = getAuthorizationManager();
+
         ResourcePattern resourceSearchList[resourceSearchListCapacity];
         const int resourceSearchListLength = buildResourceSearchList(target, resourceSearchList);
 
-        ActionSet unmetRequirements = privilege.getActions();
+        ActionSet granted;
         UserSet::iterator it = _authenticatedUsers.begin();
         while (it != _authenticatedUsers.end()) {
             User* user = *it;
@@ -327,21 +359,22 @@ namespace {
                     // out-of-date privilege data.
                     warning() << "Could not fetch updated user privilege information for " <<
                         name << "; continuing to use old information.  Reason is " << status;
+                    *cacheable = false;
                     break;
                 }
             }
 
             for (int i = 0; i < resourceSearchListLength; ++i) {
-                ActionSet userActions = user->getActionsForResource(resourceSearchList[i]);
-                unmetRequirements.removeAllActionsFromSet(userActions);
-
-                if (unmetRequirements.empty())
-                    return true;
+                granted.addAllActionsFromSet(user->getActionsForResource(resourceSearchList[i]));
             }
             ++it;
         }
 
-        return false;
+        return granted;
+    }
+
+    void AuthorizationSession::_clearGrantedActionsCache() {
+        _grantedActionsCache.clear();
     }
 
 } // namespace mongo
@@ -41,6 +41,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
@@ -152,10 +153,25 @@ namespace mongo {
         // lock on the admin database (to update out-of-date user privilege information).
         bool _isAuthorizedForPrivilege(const Privilege& privilege);
 
+        // Returns the union of the actions the authenticated users may perform on "target",
+        // refreshing out-of-date User objects along the way.  Sets *cacheable to false if an
+        // out-of-date User couldn't be refreshed, so the result shouldn't be remembered.
+        ActionSet _getGrantedActions(const ResourcePattern& target, bool* cacheable);
+
+        // Forgets all cached authorization decisions.
+        void _clearGrantedActionsCache();
+
         scoped_ptr<AuthzSessionExternalState> _externalState;
 
         // All Users who have been authenticated on this connection
         UserSet _authenticatedUsers;
+
+        // Actions granted on each resource recently checked, so that steady-state checks cost a
+        // hash lookup.  Valid while the AuthorizationManager's cache generation stays at
+        // _grantedActionsGeneration and _authenticatedUsers is unchanged.
+        typedef unordered_map<ResourcePattern, ActionSet> GrantedActionsCache;
+        GrantedActionsCache _grantedActionsCache;
+        unsigned long long _grantedActionsGeneration;
     };
 
 } // namespace mongo
@@ -362,6 +362,46 @@ namespace {
         ASSERT_FALSE(authzSession->lookupUser(UserName("spencer", "test")));
     }
 
+    TEST_F(AuthorizationSessionTest, InvalidateUserCacheDiscardsCachedDecisions) {
+        ASSERT_OK(managerState->insertPrivilegeDocument("admin",
+                BSON("name" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("name" << "read" <<
+                                                "db" << "test" <<
+                                                "hasRole" << true <<
+                                                "canDelegate" << false))),
+                BSONObj()));
+        ASSERT_OK(authzSession->addAndAuthorizeUser(UserName("spencer", "test")));
+
+        // The second check on each resource is answered from the session's cache.
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                                testFooCollResource, ActionType::find));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                testFooCollResource, ActionType::insert));
+        }
+
+        // Make the user read-write; dropping the whole user cache must reach the session.
+        managerState->clearPrivilegeDocuments();
+        ASSERT_OK(managerState->insertPrivilegeDocument("admin",
+                BSON("name" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("name" << "readWrite" <<
+                                                "db" << "test" <<
+                                                "hasRole" << true <<
+                                                "canDelegate" << false))),
+                BSONObj()));
+        authzManager->invalidateUserCache();
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                            testFooCollResource, ActionType::insert));
+
+        authzSession->logoutDatabase("test");
+        ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                            testFooCollResource, ActionType::find));
+    }
+
     TEST_F(AuthorizationSessionTest, UseOldUserInfoInFaceOfConnectivityProblems) {
         // Add a readWrite user
         ASSERT_OK(managerState->insertPrivilegeDocument("admin",
@@ -89,7 +89,8 @@ namespace {
             << ActionType::dbHash
             << ActionType::dbStats
             << ActionType::find
-            << ActionType::killCursors;
+            << ActionType::killCursors
+            << ActionType::planCacheRead;
 
         // Read-write role
         readWriteRoleActions += readRoleActions;
@@ -124,6 +125,8 @@ namespace {
             << ActionType::dropIndexes
             << ActionType::ensureIndex
             << ActionType::indexStats
+            << ActionType::planCacheRead
+            << ActionType::planCacheWrite
             << ActionType::profileEnable
             << ActionType::reIndex
             << ActionType::renameCollectionSameDB // read_write gets this also
@@ -468,19 +468,48 @@ namespace mongo {
 
         VERIFYTHISLOC
 
-        /** TODO perhaps this can be optimized.  for example if packing does no write, we can skip intent decl.
-                 an empirical approach is probably best than just adding new code : perhaps the bucket would need
-                 declaration anyway within the group commit interval, in which case we would just be adding
-                 code and complexity without benefit.
-        */
-        thisLoc.btreemod<V>()->_packReadyForMod(order, refPos);
+        // pack a copy and write back only what packing changed, rather than declaring (and so
+        // journaling) the whole bucket.  keys that don't move and the header are often unchanged.
+        char image[V::BucketSize];
+        memcpy(image, this, V::BucketSize);
+        reinterpret_cast<BucketBasics*>(image)->_doPack(order, refPos);
+        _writeChangedRuns(image);
+    }
+
+    template< class V >
+    void BucketBasics<V>::_writeChangedRuns(const char *image) const {
+        // each declaration costs a journal entry header, so runs separated by fewer unchanged
+        // bytes than that are declared together
+        const int MergeGap = 16;
+
+        const char *cur = (const char *) this;
+        int i = 0;
+        while ( i < V::BucketSize ) {
+            if ( cur[i] == image[i] ) {
+                i++;
+                continue;
+            }
+            int start = i;
+            int end = i + 1;
+            for ( int j = end; j < V::BucketSize && j - end < MergeGap; j++ ) {
+                if ( cur[j] != image[j] )
+                    end = j + 1;
+            }
+            char *b = (char *) getDur().writingAtOffset((void *) this, start, end - start);
+            memcpy(b + start, image + start, end - start);
+            i = end;
+        }
     }
 
     /** version when write intent already declared */
     template< class V >
     void BucketBasics<V>::_packReadyForMod( const Ordering &order, int &refPos ) {
         assertWritable();
+        _doPack( order, refPos );
+    }
 
+    template< class V >
+    void BucketBasics<V>::_doPack( const Ordering &order, int &refPos ) {
         if ( this->flags & Packed )
             return;
 
@@ -687,29 +716,9 @@ namespace mongo {
     }
 
     template< class V >
-    bool BtreeBucket<V>::exists(const IndexDetails& idx, const DiskLoc &thisLoc, const Key& key, const Ordering& order) const {
-            int pos;
-            bool found;
-            DiskLoc b = locate(idx, thisLoc, key, order, pos, found, minDiskLoc);
-
-            // skip unused keys
-            while ( 1 ) {
-                if( b.isNull() )
-                    break;
-                const BtreeBucket *bucket = b.btree<V>();
-                const _KeyNode& kn = bucket->k(pos);
-                if ( kn.isUsed() )
-                    return bucket->keyAt(pos).woEqual(key);
-            b = bucket->advance(b, pos, 1, "BtreeBucket<V>::exists");
-        }
-        return false;
-    }
-
-    template< class V >
-    bool BtreeBucket<V>::wouldCreateDup(
-        const IndexDetails& idx, const DiskLoc &thisLoc,
-        const Key& key, const Ordering& order,
-        const DiskLoc &self) const {
+    bool BtreeBucket<V>::findUsedKey(const IndexDetails& idx, const DiskLoc &thisLoc,
+                                     const Key& key, const Ordering& order,
+                                     DiskLoc& recordLoc) const {
         int pos;
         bool found;
         DiskLoc b = locate(idx, thisLoc, key, order, pos, found, minDiskLoc);
@@ -719,16 +728,26 @@ namespace mongo {
             const BtreeBucket *bucket = b.btree<V>();
             const _KeyNode& kn = bucket->k(pos);
             if ( kn.isUsed() ) {
-                if( bucket->keyAt(pos).woEqual(key) )
-                    return kn.recordLoc != self;
-                break;
+                if( !bucket->keyAt(pos).woEqual(key) )
+                    return false;
+                recordLoc = kn.recordLoc;
+                return true;
             }
-            b = bucket->advance(b, pos, 1, "BtreeBucket<V>::dupCheck");
+            b = bucket->advance(b, pos, 1, "BtreeBucket<V>::findUsedKey");
         }
 
         return false;
     }
 
+    template< class V >
+    bool BtreeBucket<V>::wouldCreateDup(
+        const IndexDetails& idx, const DiskLoc &thisLoc,
+        const Key& key, const Ordering& order,
+        const DiskLoc &self) const {
+        DiskLoc existing;
+        return findUsedKey(idx, thisLoc, key, order, existing) && existing != self;
+    }
+
     template< class V >
     string BtreeBucket<V>::dupKeyError( const IndexDetails& idx , const Key& key ) {
         stringstream ss;
@@ -770,21 +789,23 @@ namespace mongo {
             m = h;
         }
         while ( l <= h ) {
+            this->prefetchKey( (l+m-1)/2 );
+            this->prefetchKey( (m+1+h)/2 );
             KeyNode M = this->keyNode(m);
             int x = key.woCompare(M.key, order);
             if ( x == 0 ) {
                 if( assertIfDup ) {
                     if( k(m).isUnused() ) {
                         // ok that key is there if unused.  but we need to check that there aren't other
-                        // entries for the key then.  as it is very rare that we get here, we don't put any
-                        // coding effort in here to make this particularly fast
+                        // entries for the key then.  one descent finds the first used entry for the key,
+                        // if any, and tells us whether it is ours.
                         if( !dupsChecked ) {
                             dupsChecked = true;
-                            if( idx.head.btree<V>()->exists(idx, idx.head, key, order) ) {
-                                if( idx.head.btree<V>()->wouldCreateDup(idx, idx.head, key, order, recordLoc) )
-                                    uasserted( ASSERT_ID_DUPKEY , dupKeyError( idx , key ) );
-                                else
+                            DiskLoc existing;
+                            if( idx.head.btree<V>()->findUsedKey(idx, idx.head, key, order, existing) ) {
+                                if( existing == recordLoc )
                                     alreadyInIndex();
+                                uasserted( ASSERT_ID_DUPKEY , dupKeyError( idx , key ) );
                             }
                         }
                     }
@@ -894,6 +915,28 @@ namespace mongo {
         }
     }
 
+    template< class V >
+    bool BtreeBucket<V>::_delKeyAtPosInLeaf( int p ) const {
+        verify( p >= 0 && p < this->n );
+        if ( this->n == 1 || !this->childForPos( p ).isNull() ) {
+            return false;
+        }
+
+        // remove the key from a copy, which is all delKeyAtPos() does in this case unless the
+        // bucket then has to balance with its neighbors
+        char image[V::BucketSize];
+        memcpy(image, this, V::BucketSize);
+        BtreeBucket *b = reinterpret_cast<BtreeBucket*>(image);
+        b->_delKeyAtPos(p);
+        if ( !b->parent.isNull() && b->packedDataSize( 0 ) < b->lowWaterMark() ) {
+            return false;
+        }
+
+        // typically just the header and the key nodes after p change
+        this->_writeChangedRuns(image);
+        return true;
+    }
+
     /**
      * This function replaces the specified key (k) by either the prev or next
      * key in the btree (k').  We require that k have either a left or right
@@ -1256,12 +1299,53 @@ namespace mongo {
             if ( key.objsize() > this->KeyMax ) {
                 OCCASIONALLY problem() << "unindex: key too large to index but was found for " << id.indexNamespace() << " reIndex suggested" << endl;
             }            
-            loc.btreemod<V>()->delKeyAtPos(loc, id, pos, ord);            
+            if ( !loc.btree<V>()->_delKeyAtPosInLeaf(pos) ) {
+                loc.btreemod<V>()->delKeyAtPos(loc, id, pos, ord);
+            }
             return true;
         }
         return false;
     }
 
+    template< class V >
+    bool BtreeBucket<V>::relocate(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key,
+                                  const DiskLoc oldLoc, const DiskLoc newLoc) const {
+        int pos;
+        bool found;
+        const Ordering ord = Ordering::make(id.keyPattern());
+        DiskLoc loc = locate(id, thisLoc, key, ord, pos, found, oldLoc, 1);
+        if ( !found )
+            return false;
+
+        const BtreeBucket<V> *b = loc.btree<V>();
+
+        // Both neighbours must be keys of this bucket rather than in a child or the parent.
+        if ( pos == 0 || pos >= b->n - 1 )
+            return false;
+        if ( !b->k(pos).prevChildBucket.isNull() || !b->k(pos+1).prevChildBucket.isNull() )
+            return false;
+
+        // Entries with equal keys are ordered by recordLoc, and must stay that way.
+        const KeyOwned k(key);
+        KeyNode left = b->keyNode(pos-1);
+        if ( left.key.woCompare(k, ord) == 0 ) {
+            DiskLoc leftLoc = left.recordLoc;
+            leftLoc.GETOFS() &= ~1;
+            if ( !( leftLoc < newLoc ) )
+                return false;
+        }
+        KeyNode right = b->keyNode(pos+1);
+        if ( right.key.woCompare(k, ord) == 0 ) {
+            DiskLoc rightLoc = right.recordLoc;
+            rightLoc.GETOFS() &= ~1;
+            if ( !( newLoc < rightLoc ) )
+                return false;
+        }
+
+        loc.btreemod<V>()->k(pos).recordLoc.writing() = newLoc;
+        return true;
+    }
+
     template< class V >
     inline void BtreeBucket<V>::fix(const DiskLoc thisLoc, const DiskLoc child) {
         if ( !child.isNull() ) {
@@ -1565,6 +1649,8 @@ namespace mongo {
                 }
             }
             int m = l + ( h - l ) / 2;
+            bucket->prefetchKey( l + ( m - l ) / 2 );
+            bucket->prefetchKey( m + ( h - m ) / 2 );
             int cmp = customBSONCmp( bucket->keyNode( m ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             if ( cmp < 0 ) {
                 l = m;
@@ -383,6 +383,15 @@ namespace mongo {
             return KeyNode(*this, k(i));
         }
 
+        /**
+         * Hint that the key data for index i will be compared soon.  Binary searches call this for
+         * both possible next probes so the key body load overlaps the current comparison.
+         */
+        void prefetchKey(int i) const {
+            if ( i >= 0 && i < this->n )
+                prefetch( const_cast<char*>( this->data ) + k(i).keyDataOfs() );
+        }
+
         static int headerSize() {
             const BucketBasics *d = 0;
             return (char*)&(d->data) - (char*)&(d->parent);
@@ -514,6 +523,14 @@ namespace mongo {
         void _pack(const DiskLoc thisLoc, const Ordering &order, int &refPos) const;
         /** Pack when already writable */
         void _packReadyForMod(const Ordering &order, int &refPos);
+        /** Pack without checking write intent, e.g. a copy of the bucket */
+        void _doPack(const Ordering &order, int &refPos);
+
+        /**
+         * Copy 'image', a modified copy of this bucket, over the bucket.  Write intent is
+         * declared only for the runs of bytes that differ, so that is all that gets journaled.
+         */
+        void _writeChangedRuns(const char *image) const;
 
         /** @return the size the bucket's body would have if we were to call pack() */
         int packedDataSize( int refPos ) const;
@@ -649,6 +666,7 @@ namespace mongo {
         _KeyNode& k(int i)                 { return static_cast< BucketBasics<V> * >(this)->_k(i); }
     public:
         const KeyNode keyNode(int i) const { return static_cast< const BucketBasics<V> * >(this)->keyNode(i); }
+        void prefetchKey(int i) const      { static_cast< const BucketBasics<V> * >(this)->prefetchKey(i); }
 
         bool isHead() const { return this->parent.isNull(); }
         void dumpTree(const DiskLoc &thisLoc, const BSONObj &order) const;
@@ -659,14 +677,16 @@ namespace mongo {
         void dump(unsigned depth=0) const;
 
         /**
-         * @return true if key exists in index
+         * Finds the first used (not deleted) entry for key, in one descent from thisLoc.
+         * @return true if key exists in index; recordLoc is then set to that entry's record
          *
          * @order - indicates order of keys in the index.  this is basically the index's key pattern, e.g.:
          *    BSONObj order = ((IndexDetails&)idx).keyPattern();
          * likewise below in bt_insert() etc.
          */
     private:
-        bool exists(const IndexDetails& idx, const DiskLoc &thisLoc, const Key& key, const Ordering& order) const;
+        bool findUsedKey(const IndexDetails& idx, const DiskLoc &thisLoc,
+                         const Key& key, const Ordering& order, DiskLoc& recordLoc) const;
     public:
 
         /**
@@ -724,6 +744,15 @@ namespace mongo {
          */
         bool unindex(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key, const DiskLoc recordLoc) const;
 
+        /**
+         * Points the entry for key / oldLoc at newLoc without moving it, for a record that has
+         * moved on disk.  Only done when the entry's in-order neighbours are in the same bucket
+         * and stay on the same side of newLoc; otherwise the caller must unindex and reinsert.
+         * @return true if the entry was relocated.
+         */
+        bool relocate(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key,
+                      const DiskLoc oldLoc, const DiskLoc newLoc) const;
+
         /**
          * locate may return an "unused" key that is just a marker.  so be careful.
          *   looks for a key:recordloc pair.
@@ -799,6 +828,16 @@ namespace mongo {
          */
         void delKeyAtPos(const DiskLoc thisLoc, IndexDetails& id, int p, const Ordering &order);
 
+        /**
+         * Preconditions: 0 <= p < n
+         * Postconditions:
+         *  - If the key at index p is in a leaf position, is not the last key in the bucket and
+         *    removing it leaves the bucket with no need to balance with its neighbors, the key is
+         *    removed with write intent declared only for the changed bytes, and true is returned.
+         *  - Otherwise, return false and do nothing; delKeyAtPos() is needed.
+         */
+        bool _delKeyAtPosInLeaf(int p) const;
+
         /**
          * Preconditions:
          *  - n == 0 is ok
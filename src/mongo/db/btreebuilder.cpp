@@ -51,18 +51,18 @@ namespace mongo {
     template<class V>
     BtreeBuilder<V>::BtreeBuilder(bool _dupsAllowed, IndexDetails& _idx) :
         dupsAllowed(_dupsAllowed),
-        idx(_idx),
+        idx(&_idx),
         n(0),
-        order( idx.keyPattern() ),
-        ordering( Ordering::make(idx.keyPattern()) ) {
-        first = cur = BtreeBucket<V>::addBucket(idx);
+        order( idx->keyPattern() ),
+        ordering( Ordering::make(idx->keyPattern()) ) {
+        first = cur = BtreeBucket<V>::addBucket(*idx);
         b = cur.btreemod<V>();
         committed = false;
     }
 
     template<class V>
     void BtreeBuilder<V>::newBucket() {
-        DiskLoc L = BtreeBucket<V>::addBucket(idx);
+        DiskLoc L = BtreeBucket<V>::addBucket(*idx);
         b->setTempNext(L);
         cur = L;
         b = cur.btreemod<V>();
@@ -80,7 +80,7 @@ namespace mongo {
 
         auto_ptr< KeyOwned > key( new KeyOwned(_key) );
         if ( key->dataSize() > BtreeBucket<V>::KeyMax ) {
-            problem() << "Btree::insert: key too large to index, skipping " << idx.indexNamespace() 
+            problem() << "Btree::insert: key too large to index, skipping " << idx->indexNamespace() 
                       << ' ' << key->dataSize() << ' ' << key->toString() << endl;
             return;
         }
@@ -91,7 +91,7 @@ namespace mongo {
                 massert( 10288 ,  "bad key order in BtreeBuilder - server internal error", cmp <= 0 );
                 if( cmp == 0 ) {
                     //if( !dupsAllowed )
-                    uasserted( ASSERT_ID_DUPKEY , BtreeBucket<V>::dupKeyError( idx , *keyLast ) );
+                    uasserted( ASSERT_ID_DUPKEY , BtreeBucket<V>::dupKeyError( *idx , *keyLast ) );
                 }
             }
         }
@@ -112,12 +112,12 @@ namespace mongo {
         while( 1 ) {
             if( loc.btree<V>()->tempNext().isNull() ) {
                 // only 1 bucket at this level. we are done.
-                getDur().writingDiskLoc(idx.head) = loc;
+                getDur().writingDiskLoc(idx->head) = loc;
                 break;
             }
             levels++;
 
-            DiskLoc upLoc = BtreeBucket<V>::addBucket(idx);
+            DiskLoc upLoc = BtreeBucket<V>::addBucket(*idx);
             DiskLoc upStart = upLoc;
             BtreeBucket<V> *up = upLoc.btreemod<V>();
 
@@ -139,7 +139,7 @@ namespace mongo {
 
                 if ( ! up->_pushBack(r, k, ordering, keepLoc) ) {
                     // current bucket full
-                    DiskLoc n = BtreeBucket<V>::addBucket(idx);
+                    DiskLoc n = BtreeBucket<V>::addBucket(*idx);
                     up->setTempNext(n);
                     upLoc = n;
                     up = upLoc.btreemod<V>();
@@ -156,7 +156,7 @@ namespace mongo {
                         ll.btreemod<V>()->parent = upLoc;
                         //(x->nextChild.btreemod<V>())->parent = upLoc;
                     }
-                    x->deallocBucket( xloc, idx );
+                    x->deallocBucket( xloc, *idx );
                 }
                 xloc = nextLoc;
             }
@@ -170,6 +170,12 @@ namespace mongo {
         }
     }
 
+    template<class V>
+    void BtreeBuilder<V>::relocked(IndexDetails& _idx) {
+        idx = &_idx;
+        b = cur.btreemod<V>();
+    }
+
     /** when all addKeys are done, we then build the higher levels of the tree */
     template<class V>
     void BtreeBuilder<V>::commit(bool mayInterrupt) {
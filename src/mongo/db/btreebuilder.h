@@ -41,7 +41,7 @@ namespace mongo {
         typedef typename V::Key Key;
         
         bool dupsAllowed;
-        IndexDetails& idx;
+        IndexDetails* idx;
         /** Number of keys added to btree. */
         unsigned long long n;
         /** Last key passed to addKey(). */
@@ -67,6 +67,12 @@ namespace mongo {
          */
         void addKey(BSONObj& key, DiskLoc loc);
 
+        /**
+         * For builds which release the lock between addKey()s: call once locked again, with the
+         * index looked up anew as it may have moved among the collection's indexes meanwhile.
+         */
+        void relocked(IndexDetails& idx);
+
         /**
          * commit work.  if not called, destructor will clean up partially completed work
          *  (in case exception has happened).
@@ -268,6 +268,41 @@ namespace mongo {
         return ok();
     }
 
+    bool BtreeCursor::advancePastPrefix( int prefixLen ) {
+        _boundsMustMatch = true;
+
+        killCurrentOp.checkForInterrupt();
+        if (!ok()) {
+            return false;
+        }
+
+        // Only the first prefixLen fields are compared when seeking past a key, but the end key
+        // fields must still be supplied for the remaining fields.
+        BSONObj key = currKey().getOwned();
+        vector<BSONElement> keyElements;
+        key.elems( keyElements );
+        vector<const BSONElement*> keyEnd;
+        vector<bool> keyEndInclusive;
+        for( vector<BSONElement>::const_iterator i = keyElements.begin();
+             i != keyElements.end(); ++i ) {
+            keyEnd.push_back( &*i );
+            keyEndInclusive.push_back( true );
+        }
+        advanceTo( key, prefixLen, true, keyEnd, keyEndInclusive );
+
+        if ( !_independentFieldRanges ) {
+            checkEnd();
+            if ( ok() ) {
+                ++_nscanned;
+            }
+        }
+        else {
+            skipAndCheck();
+        }
+
+        return ok();
+    }
+
     void BtreeCursor::noteLocation() {
         if (!eof()) { _indexCursor->savePosition(); }
     }
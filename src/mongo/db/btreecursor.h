@@ -94,6 +94,15 @@ namespace mongo {
 
         virtual bool ok();
         virtual bool advance();
+
+        /**
+         * Advance to the first key whose first 'prefixLen' fields differ from those of the current
+         * key, reseeking the btree past every key that shares them rather than iterating over
+         * those keys.  Used to skip scan an index for the distinct values of a key prefix.
+         * @return ok().
+         */
+        bool advancePastPrefix( int prefixLen );
+
         virtual void noteLocation();
         virtual void checkLocation();
         virtual bool supportGetMore() { return true; }
@@ -32,6 +32,7 @@
 #include "mongo/pch.h"
 
 #include <algorithm>
+#include <boost/thread/condition.hpp>
 #include <list>
 
 #include "mongo/db/clientcursor.h"
@@ -213,6 +214,44 @@ namespace mongo {
         return ret;
     }
 
+    /* total size of the deleted records in the cap extent.  no record larger than this can be
+       allocated there without deleting more, however the free space is merged.
+    */
+    long long NamespaceDetails::cappedFreeBytesInCurExtent() {
+        long long total = 0;
+        for ( DiskLoc i = cappedFirstDeletedInCurExtent();
+              !i.isNull() && inCapExtent( i ); i = i.drec()->nextDeleted() )
+            total += i.drec()->lengthWithHeaders();
+        return total;
+    }
+
+    namespace {
+        mongo::mutex cappedInsertMutex("cappedInsert");
+        boost::condition cappedInserted;
+        unsigned long long cappedInserts = 0;
+
+        void notifyCappedInsert() {
+            scoped_lock lk(cappedInsertMutex);
+            cappedInserts++;
+            cappedInserted.notify_all();
+        }
+    }
+
+    unsigned long long NamespaceDetails::cappedInsertCount() {
+        scoped_lock lk(cappedInsertMutex);
+        return cappedInserts;
+    }
+
+    void NamespaceDetails::waitForCappedInsert( unsigned long long lastSeen, int maxMillis ) {
+        boost::system_time deadline =
+            boost::get_system_time() + boost::posix_time::milliseconds(maxMillis);
+        scoped_lock lk(cappedInsertMutex);
+        while ( cappedInserts == lastSeen ) {
+            if ( !cappedInserted.timed_wait(lk.boost(), deadline) )
+                return;
+        }
+    }
+
     DiskLoc NamespaceDetails::cappedAlloc(const char *ns, int len) {
         
         if ( len > theCapExtent()->length ) {
@@ -277,25 +316,39 @@ namespace mongo {
                 continue;
             }
 
-            DiskLoc fr = theCapExtent()->firstRecord;
-            theDataFileMgr.deleteRecord(this, ns, fr.rec(), fr, true); // ZZZZZZZZZZZZ
+            // Delete the oldest records of the extent until there could be room, then merge the
+            // freed space once.  Compacting and searching after every single delete made a large
+            // insert into a full collection (the oplog, say) cost O(n^2) in the records it evicts.
+            long long freeBytes = cappedFreeBytesInCurExtent();
+            do {
+                DiskLoc fr = theCapExtent()->firstRecord;
+                freeBytes += fr.rec()->lengthWithHeaders();
+                theDataFileMgr.deleteRecord(this, ns, fr.rec(), fr, true); // ZZZZZZZZZZZZ
+                if( ++passes > maxPasses ) {
+                    compact();
+                    StringBuilder sb;
+                    sb << "passes >= maxPasses in NamespaceDetails::cappedAlloc: ns: " << ns
+                       << ", len: " << len
+                       << ", maxPasses: " << maxPasses
+                       << ", _maxDocsInCapped: " << _maxDocsInCapped
+                       << ", nrecords: " << _stats.nrecords
+                       << ", datasize: " << _stats.datasize;
+                    msgasserted(10345, sb.str());
+                }
+            } while ( ( freeBytes < len + 24 || _stats.nrecords >= maxCappedDocs() ) &&
+                      !theCapExtent()->firstRecord.isNull() &&
+                      theCapExtent()->firstRecord != _capFirstNewRecord );
             compact();
-            if( ++passes > maxPasses ) {
-                StringBuilder sb;
-                sb << "passes >= maxPasses in NamespaceDetails::cappedAlloc: ns: " << ns
-                   << ", len: " << len
-                   << ", maxPasses: " << maxPasses
-                   << ", _maxDocsInCapped: " << _maxDocsInCapped
-                   << ", nrecords: " << _stats.nrecords
-                   << ", datasize: " << _stats.datasize;
-                msgasserted(10345, sb.str());
-            }
         }
 
         // Remember first record allocated on this iteration through capExtent.
         if ( _capFirstNewRecord.isValid() && _capFirstNewRecord.isNull() )
             getDur().writingDiskLoc(_capFirstNewRecord) = loc;
 
+        // the record is written before the caller's write lock is released, which a woken
+        // awaitData getmore has to wait for
+        notifyCappedInsert();
+
         return loc;
     }
 
@@ -261,6 +261,8 @@ namespace mongo {
         _db(db)
     {
         verify( db == 0 || db->isOk() );
+        if ( db )
+            db->noteUsed();
         _client->_context = this;
     }
 
@@ -353,6 +355,7 @@ namespace mongo {
         _db(db)
     {
         verify(_db);
+        _db->noteUsed();
         checkNotStale();
         _client->_context = this;
         _client->_curOp->enter( this );
@@ -367,6 +370,7 @@ namespace mongo {
         
         _db = dbHolderUnchecked().getOrCreate( _ns , _path , _justCreated );
         verify(_db);
+        _db->noteUsed();
         if( _doVersion ) checkNotStale();
         massert( 16107 , str::stream() << "Don't have a lock on: " << _ns , Lock::atLeastReadLocked( _ns ) );
         _client->_context = this;
@@ -581,6 +585,13 @@ namespace mongo {
         executionTime = 0;
         nreturned = -1;
         responseLength = -1;
+
+        cpuMicros = -1;
+        diskPageFaults = -1;
+        blocksRead = -1;
+        pageFaultRetries = 0;
+        pageFaultMicros = 0;
+        journalBytes = 0;
     }
 
 
@@ -638,6 +649,17 @@ namespace mongo {
         
         s << " ";
         curop.lockStat().report( s );
+
+        OPDEBUG_TOSTRING_HELP( cpuMicros );
+        if ( diskPageFaults > 0 )
+            s << " diskPageFaults:" << diskPageFaults;
+        if ( blocksRead > 0 )
+            s << " blocksRead:" << blocksRead;
+        if ( pageFaultRetries > 0 )
+            s << " pageFaultRetries:" << pageFaultRetries
+              << " pageFaultMicros:" << pageFaultMicros;
+        if ( journalBytes > 0 )
+            s << " journalBytes:" << journalBytes;
         
         OPDEBUG_TOSTRING_HELP( nreturned );
         if ( responseLength > 0 )
@@ -720,6 +742,16 @@ namespace mongo {
         b.appendNumber( "numYield" , curop.numYields() );
         b.append( "lockStats" , curop.lockStat().report() );
 
+        OPDEBUG_APPEND_NUMBER( cpuMicros );
+        OPDEBUG_APPEND_NUMBER( diskPageFaults );
+        OPDEBUG_APPEND_NUMBER( blocksRead );
+        if ( pageFaultRetries > 0 ) {
+            b.append( "pageFaultRetries" , pageFaultRetries );
+            b.appendNumber( "pageFaultMicros" , pageFaultMicros );
+        }
+        if ( journalBytes > 0 )
+            b.appendNumber( "journalBytes" , journalBytes );
+
         if ( ! exceptionInfo.empty() )
             exceptionInfo.append( b , "exception" , "exceptionCode" );
 
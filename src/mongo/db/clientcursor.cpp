@@ -34,6 +34,7 @@
 #include <time.h>
 #include <vector>
 
+#include "mongo/base/counter.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_set.h"
@@ -46,6 +47,7 @@
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/lockstate.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/repl/rs.h"
@@ -58,6 +60,7 @@
 namespace mongo {
 
     ClientCursor::CCById ClientCursor::clientCursorsById;
+    ClientCursor::CCByNs ClientCursor::runnerCursorsByNs;
     boost::recursive_mutex& ClientCursor::ccmutex( *(new boost::recursive_mutex()) );
     long long ClientCursor::numberTimedOut = 0;
     set<Runner*> ClientCursor::nonCachedRunners;
@@ -107,6 +110,9 @@ namespace mongo {
         recursive_scoped_lock lock(ccmutex);
         _cursorid = allocCursorId_inlock();
         clientCursorsById.insert( make_pair(_cursorid, this) );
+        if (NULL != _runner.get()) {
+            runnerCursorsByNs[_ns].insert(this);
+        }
     }
 
     ClientCursor::~ClientCursor() {
@@ -124,6 +130,15 @@ namespace mongo {
             }
 
             clientCursorsById.erase(_cursorid);
+            if (NULL != _runner.get()) {
+                CCByNs::iterator it = runnerCursorsByNs.find(_ns);
+                if (it != runnerCursorsByNs.end()) {
+                    it->second.erase(this);
+                    if (it->second.empty()) {
+                        runnerCursorsByNs.erase(it);
+                    }
+                }
+            }
 
             // defensive:
             _cursorid = INVALID_CURSOR_ID;
@@ -140,6 +155,7 @@ namespace mongo {
             ClientCursor *cc = clientCursorsById.begin()->second;
             log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
             clientCursorsById.clear();
+            runnerCursorsByNs.clear();
             verify(false);
         }
     }
@@ -259,21 +275,13 @@ namespace mongo {
             }
         }
 
-        // TODO: This requires optimization.  We walk through *all* CCs and send the delete to every
-        // CC open on the db we're deleting from.  We could:
-        // 1. Map from ns to open runners,
-        // 2. Map from ns -> (a map of DiskLoc -> runners who care about that DL)
-        //
-        // We could also queue invalidations somehow and have them processed later in the runner's
-        // read locks.
-        for (CCById::const_iterator it = clientCursorsById.begin(); it != clientCursorsById.end();
-             ++it) {
-
-            ClientCursor* cc = it->second;
-            // We're only interested in cursors over one db.
-            if (cc->_db != db) { continue; }
-            if (NULL == cc->_runner.get()) { continue; }
-            cc->_runner->invalidate(dl);
+        // Only the runners over the collection being deleted from can be positioned on 'dl'.
+        CCByNs::const_iterator byNs = runnerCursorsByNs.find(ns.toString());
+        if (byNs != runnerCursorsByNs.end()) {
+            for (set<ClientCursor*>::const_iterator it = byNs->second.begin();
+                 it != byNs->second.end(); ++it) {
+                (*it)->_runner->invalidate(dl);
+            }
         }
 
         // Begin cursor-only
@@ -374,45 +382,64 @@ namespace mongo {
     }
 
     void ClientCursor::staticYield(int micros, const StringData& ns, Record* rec) {
-        bool haveReadLock = Lock::isReadLocked();
+        vector<Record*> recs;
+        if ( rec )
+            recs.push_back( rec );
+        staticYield( micros, ns, recs );
+    }
 
+    // Yields that released the lock and someone else got a lock meanwhile, that released it and
+    // nobody did, and that didn't release it because nobody was waiting and nothing needed
+    // paging in.
+    static Counter64 yieldsUseful;
+    static Counter64 yieldsUseless;
+    static Counter64 yieldsSkipped;
+    static ServerStatusMetricField<Counter64> displayYieldsUseful( "yields.useful",
+                                                                  &yieldsUseful );
+    static ServerStatusMetricField<Counter64> displayYieldsUseless( "yields.useless",
+                                                                   &yieldsUseless );
+    static ServerStatusMetricField<Counter64> displayYieldsSkipped( "yields.skipped",
+                                                                   &yieldsSkipped );
+
+    // Longest a yielding op waits, unlocked, for a waiting op to take a lock.
+    static const int maxYieldHandOffMicros = 1000;
+
+    void ClientCursor::staticYield(int micros, const StringData& ns,
+                                   const vector<Record*>& recs) {
         killCurrentOp.checkForInterrupt( false );
+
+        if ( recs.empty() && numLockWaiters() == 0 ) {
+            yieldsSkipped.increment();
+            return;
+        }
+
         {
             auto_ptr<LockMongoFilesShared> lk;
-            if ( rec ) {
+            if ( !recs.empty() ) {
                 // need to lock this else rec->touch won't be safe file could disappear
                 lk.reset( new LockMongoFilesShared() );
             }
 
+            unsigned long long acquisitions = numLockAcquisitions();
             dbtempreleasecond unlock;
             if ( unlock.unlocked() ) {
-                if ( haveReadLock ) {
-                    // This sleep helps reader threads yield to writer threads.
-                    // Without this, the underlying reader/writer lock implementations
-                    // are not sufficiently writer-greedy.
+                // Hand the lock off: rather than sleeping for a guessed time, wait until one of
+                // the waiting ops has got a lock, or nobody is waiting any more.
+                Timer t;
+                int maxMicros = std::max( micros, maxYieldHandOffMicros );
+                while ( numLockAcquisitions() == acquisitions && numLockWaiters() > 0 &&
+                        t.micros() < maxMicros ) {
 #ifdef _WIN32
                     SwitchToThread();
 #else
-                    if ( micros == 0 ) {
-                        yieldOrSleepFor1Microsecond();
-                    }
-                    else {
-                        sleepmicros(1);
-                    }
+                    yieldOrSleepFor1Microsecond();
 #endif
                 }
-                else {
-                    if ( micros == -1 ) {
-                        sleepmicros(Client::recommendedYieldMicros());
-                    }
-                    else if ( micros == 0 ) {
-                        yieldOrSleepFor1Microsecond();
-                    }
-                    else if ( micros > 0 ) {
-                        sleepmicros( micros );
-                    }
-                }
 
+                if ( numLockAcquisitions() != acquisitions )
+                    yieldsUseful.increment();
+                else
+                    yieldsUseless.increment();
             }
             else if ( Listener::getTimeTracker() == 0 ) {
                 // we aren't running a server, so likely a repair, so don't complain
@@ -427,8 +454,8 @@ namespace mongo {
                           << endl;
             }
 
-            if ( rec )
-                rec->touch();
+            for ( size_t i = 0; i < recs.size(); i++ )
+                recs[i]->touch();
 
             lk.reset(0); // need to release this before dbtempreleasecond
         }
@@ -582,6 +609,16 @@ namespace mongo {
         return it->second;
     }
 
+    bool ClientCursor::haveCursorsOn(const Database* db) {
+        recursive_scoped_lock lock(ccmutex);
+        for (CCById::const_iterator i = clientCursorsById.begin(); i != clientCursorsById.end();
+             ++i) {
+            if (i->second->_db == db)
+                return true;
+        }
+        return false;
+    }
+
     void ClientCursor::find( const string& ns , set<CursorId>& all ) {
         recursive_scoped_lock lock(ccmutex);
 
@@ -71,6 +71,9 @@ namespace mongo {
          */
         static void assertNoCursors();
 
+        /** @return true if any cursor is open over a collection of db */
+        static bool haveCursorsOn(const Database* db);
+
         //
         // Basic accessors
         //
@@ -115,6 +118,9 @@ namespace mongo {
 
         static void staticYield(int micros, const StringData& ns, Record* rec);
 
+        /** Like staticYield() above, but pages in all of 'recs' while unlocked. */
+        static void staticYield(int micros, const StringData& ns, const vector<Record*>& recs);
+
         //
         // Static methods about all ClientCursors  TODO: Document.
         //
@@ -277,6 +283,11 @@ namespace mongo {
         typedef map<CursorId, ClientCursor*> CCById;
         static CCById clientCursorsById;
 
+        // The runner-backed ClientCursors in clientCursorsById, by ns, so that a delete only
+        // notifies the cursors over the collection it deletes from.
+        typedef map<string, set<ClientCursor*> > CCByNs;
+        static CCByNs runnerCursorsByNs;
+
         // A list of NON-CACHED runners.  Any runner that yields must be put into this map before
         // yielding in order to be notified of invalidation and namespace deletion.  Before the
         // runner is deleted, it must be removed from this map.
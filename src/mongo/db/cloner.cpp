@@ -30,6 +30,8 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
@@ -39,6 +41,7 @@
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/index_builder.h"
+#include "mongo/db/index_update.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
@@ -220,6 +223,10 @@ namespace mongo {
         }
 
         if ( storedForLater.size() ) {
+            // The indexes of each collection are built together, from one scan of it, once all
+            // their specs are in.  The specs are logged after that.
+            IndexBuildBatch indexBuilds;
+            vector<BSONObj> inserted;
             for (list<BSONObj>::const_iterator i = storedForLater.begin();
                  i != storedForLater.end();
                  ++i) {
@@ -228,9 +235,7 @@ namespace mongo {
                 try {
                     theDataFileMgr.insertWithObjMod(to_collection, js);
                     theDataFileMgr.setPrecalced(NULL);
-
-                    if ( logForRepl )
-                        logOp("i", to_collection, js);
+                    inserted.push_back(js);
 
                     getDur().commitIfNeeded();
                 }
@@ -244,6 +249,13 @@ namespace mongo {
                     throw;
                 }
             }
+
+            indexBuilds.finish();
+            if ( logForRepl ) {
+                for (size_t i = 0; i < inserted.size(); ++i) {
+                    logOp("i", to_collection, inserted[i]);
+                }
+            }
         }
     }
 
@@ -328,6 +340,131 @@ namespace mongo {
 
     }
 
+    void Cloner::cloneCollection(const BSONObj& collection, const string& todb,
+                                 const CloneOptions& opts, bool masterSameProcess) {
+        LOG(2) << "  really will clone: " << collection << endl;
+        const char * from_name = collection["name"].valuestr();
+        BSONObj options = collection.getObjectField("options");
+
+        /* change name "<fromdb>.collection" -> <todb>.collection */
+        const char *p = strchr(from_name, '.');
+        verify(p);
+        string to_name = todb + p;
+
+        bool wantIdIndex = false;
+        {
+            string err;
+            const char *toname = to_name.c_str();
+            /* we defer building id index for performance - building it in batch is much faster */
+            userCreateNS(toname, options, err, opts.logForRepl, &wantIdIndex);
+        }
+        LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+        Query q;
+        if( opts.snapshot )
+            q.snapshot();
+        copy(from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
+
+        if( wantIdIndex ) {
+            /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
+               that occur during the initial sync.  inDBRepair makes dropDups be true.
+               */
+            bool old = inDBRepair;
+            try {
+                inDBRepair = true;
+                ensureIdIndexForNewNs(to_name.c_str());
+                inDBRepair = old;
+            }
+            catch(...) {
+                inDBRepair = old;
+                throw;
+            }
+        }
+    }
+
+    struct Cloner::ParallelClone {
+        ParallelClone(const string& masterHost, const CloneOptions& opts, const string& todb,
+                      const list<BSONObj>& toClone)
+            : masterHost(masterHost), opts(opts), todb(todb), _remaining(toClone) {
+        }
+
+        /** @return false once the collections are used up or a worker has failed */
+        bool take(BSONObj* collection) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (!_error.empty() || _remaining.empty())
+                return false;
+            *collection = _remaining.front();
+            _remaining.pop_front();
+            return true;
+        }
+
+        void fail(const string& error) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_error.empty())
+                _error = error;
+        }
+
+        string error() {
+            boost::mutex::scoped_lock lk(_mutex);
+            return _error;
+        }
+
+        const string masterHost;
+        const CloneOptions opts;
+        const string todb;
+
+    private:
+        boost::mutex _mutex;
+        list<BSONObj> _remaining;
+        string _error;
+    };
+
+    void Cloner::parallelCloneWorker(ParallelClone* clone) {
+        Client::initThread("clonecollection");
+        try {
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse(clone->masterHost, errmsg);
+            auto_ptr<DBClientBase> con(cs.connect(errmsg));
+            uassert(17317, str::stream() << "couldn't connect to " << clone->masterHost << ": "
+                                         << errmsg,
+                    con.get());
+            uassert(17318, "couldn't authenticate to " + clone->masterHost,
+                    replAuthenticate(con.get()));
+
+            Cloner cloner;
+            cloner._conn = con;
+            BSONObj collection;
+            while (clone->take(&collection)) {
+                Client::WriteContext ctx(clone->todb);
+                cloner.cloneCollection(collection, clone->todb, clone->opts, false);
+            }
+        }
+        catch (const DBException& e) {
+            clone->fail(e.toString());
+        }
+        catch (const std::exception& e) {
+            clone->fail(e.what());
+        }
+        cc().shutdown();
+    }
+
+    bool Cloner::cloneCollectionsInParallel(const char *masterHost, const CloneOptions& opts,
+                                            const string& todb, const list<BSONObj>& toClone,
+                                            string& errmsg) {
+        ParallelClone clone(masterHost, opts, todb, toClone);
+        {
+            // the workers take the write lock themselves, a batch of documents at a time
+            dbtemprelease r;
+            boost::thread_group threads;
+            size_t numThreads = std::min<size_t>(opts.parallelCollections, toClone.size());
+            for (size_t i = 0; i < numThreads; i++)
+                threads.create_thread(boost::bind(&Cloner::parallelCloneWorker, &clone));
+            threads.join_all();
+        }
+
+        errmsg = clone.error();
+        return errmsg.empty();
+    }
+
     bool Cloner::go(const char *masterHost, const CloneOptions& opts, set<string>& clonedColls,
                     string& errmsg, int* errCode) {
         if ( errCode ) {
@@ -435,48 +572,18 @@ namespace mongo {
             }
         }
 
-        for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
-            {
-                mayInterrupt( opts.mayBeInterrupted );
-                dbtempreleaseif r( opts.mayYield );
-            }
-            BSONObj collection = *i;
-            LOG(2) << "  really will clone: " << collection << endl;
-            const char * from_name = collection["name"].valuestr();
-            BSONObj options = collection.getObjectField("options");
-
-            /* change name "<fromdb>.collection" -> <todb>.collection */
-            const char *p = strchr(from_name, '.');
-            verify(p);
-            string to_name = todb + p;
-
-            bool wantIdIndex = false;
-            {
-                string err;
-                const char *toname = to_name.c_str();
-                /* we defer building id index for performance - building it in batch is much faster */
-                userCreateNS(toname, options, err, opts.logForRepl, &wantIdIndex);
-            }
-            LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( opts.snapshot )
-                q.snapshot();
-            copy(from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
-
-            if( wantIdIndex ) {
-                /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
-                   that occur during the initial sync.  inDBRepair makes dropDups be true.
-                   */
-                bool old = inDBRepair;
-                try {
-                    inDBRepair = true;
-                    ensureIdIndexForNewNs(to_name.c_str());
-                    inDBRepair = old;
-                }
-                catch(...) {
-                    inDBRepair = old;
-                    throw;
+        if ( opts.parallelCollections > 1 && toClone.size() > 1 && opts.mayYield &&
+             !masterSameProcess ) {
+            if ( !cloneCollectionsInParallel( masterHost, opts, todb, toClone, errmsg ) )
+                return false;
+        }
+        else {
+            for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+                {
+                    mayInterrupt( opts.mayBeInterrupted );
+                    dbtempreleaseif r( opts.mayYield );
                 }
+                cloneCollection( *i, todb, opts, masterSameProcess );
             }
         }
 
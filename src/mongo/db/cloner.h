@@ -104,7 +104,26 @@ namespace mongo {
                   bool masterSameProcess, bool slaveOk, bool mayYield, bool mayBeInterrupted,
                   Query q);
 
+        /**
+         * Creates and copies the collection described by the system.namespaces entry
+         * 'collection' into 'todb', then builds its _id index.  Caller holds the write lock.
+         */
+        void cloneCollection(const BSONObj& collection, const string& todb,
+                             const CloneOptions& opts, bool masterSameProcess);
+
+        /**
+         * Clones the collections in 'toClone' on up to opts.parallelCollections threads, each
+         * with its own connection to 'masterHost'.  Caller holds the write lock, which is
+         * released while the threads run.
+         */
+        bool cloneCollectionsInParallel(const char *masterHost, const CloneOptions& opts,
+                                        const string& todb, const list<BSONObj>& toClone,
+                                        string& errmsg);
+
         struct Fun;
+        struct ParallelClone;
+        static void parallelCloneWorker(ParallelClone* clone);
+
         auto_ptr<DBClientBase> _conn;
     };
 
@@ -120,6 +139,8 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+
+            parallelCollections = 1;
         }
             
         string fromDB;
@@ -134,6 +155,10 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // Number of collections copied at once, each over its own connection.  Only used when
+        // mayYield is set and the source is another process.
+        int parallelCollections;
     };
 
 } // namespace mongo
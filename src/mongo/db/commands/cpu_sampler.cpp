@@ -0,0 +1,250 @@
+// @file cpu_sampler.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+/**
+ * A sampling cpu profiler cheap enough to leave running in production.  Unlike the
+ * commands in cpuprofile.cpp it needs no build option and writes no files.
+ *
+ * Setting the cpuSamplingHz server parameter above 0, at startup or with setParameter,
+ * samples the process's cpu time that many times a second (ITIMER_PROF).  The stack of the
+ * thread that was running is kept in a fixed-size in-memory ring, so the most recent samples
+ * are always available.  0 stops sampling.
+ *
+ * The following command returns the samples in the ring as a profile in the pprof (legacy
+ * cpu profile) format, in the binary field "profile":
+ *     { _cpuSamplerProfile: 1 }
+ * Saved to a file, it is read with "pprof /path/to/mongod saved.prof".
+ *
+ * Sampling uses SIGPROF, so it can't be combined with the gperftools profiler.  Linux only.
+ */
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/authorization_manager.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    namespace {
+
+        const int kMaxSampleDepth = 48;
+        const unsigned kRingSamples = 8192;
+
+        // frames of the signal handler and the kernel's signal trampoline atop every sample
+        const int kHandlerFrames = 2;
+
+        struct Sample {
+            // 0 while the sample is being written
+            volatile int depth;
+            void* pcs[kMaxSampleDepth];
+        };
+
+        Sample samples[kRingSamples];
+        AtomicUInt32 nextSample;
+
+        void onSigprof( int ) {
+            int savedErrno = errno;
+            Sample& s = samples[ nextSample.fetchAndAdd( 1 ) % kRingSamples ];
+            s.depth = 0;
+            int depth = backtrace( s.pcs, kMaxSampleDepth );
+            s.depth = depth > kHandlerFrames ? depth : 0;
+            errno = savedErrno;
+        }
+
+        Status setSamplingHz( int hz ) {
+            if ( hz < 0 || hz > 1000 )
+                return Status( ErrorCodes::BadValue, "cpuSamplingHz must be between 0 and 1000" );
+
+            if ( hz > 0 ) {
+                // backtrace() allocates on first use, which must not happen in the handler
+                void* warmup[1];
+                backtrace( warmup, 1 );
+
+                struct sigaction sa;
+                memset( &sa, 0, sizeof(sa) );
+                sa.sa_handler = onSigprof;
+                sa.sa_flags = SA_RESTART;
+                sigemptyset( &sa.sa_mask );
+                if ( sigaction( SIGPROF, &sa, NULL ) != 0 )
+                    return Status( ErrorCodes::InternalError, "couldn't install SIGPROF handler" );
+            }
+
+            struct itimerval timer;
+            memset( &timer, 0, sizeof(timer) );
+            if ( hz > 0 ) {
+                timer.it_interval.tv_sec = 0;
+                timer.it_interval.tv_usec = 1000000 / hz;
+                timer.it_value = timer.it_interval;
+            }
+            if ( setitimer( ITIMER_PROF, &timer, NULL ) != 0 )
+                return Status( ErrorCodes::InternalError, "couldn't set the profiling timer" );
+            return Status::OK();
+        }
+
+        class CpuSamplingHz : public ServerParameter {
+        public:
+            CpuSamplingHz()
+                : ServerParameter( ServerParameterSet::getGlobal(), "cpuSamplingHz" ),
+                  _value( 0 ) {
+            }
+
+            int get() const { return _value; }
+
+            virtual void append( BSONObjBuilder& b, const string& name ) {
+                b.append( name, _value );
+            }
+
+            virtual Status set( const BSONElement& newValueElement ) {
+                return set( newValueElement.numberInt() );
+            }
+
+            Status set( int hz ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                Status status = setSamplingHz( hz );
+                if ( status.isOK() )
+                    _value = hz;
+                return status;
+            }
+
+            virtual Status setFromString( const string& str ) {
+                return set( atoi( str.c_str() ) );
+            }
+
+        private:
+            SimpleMutex _mutex;
+            int _value;
+        };
+
+        CpuSamplingHz cpuSamplingHz;
+
+        /**
+         * Appends 'word' in the native word size and byte order, as the legacy pprof format
+         * expects.
+         */
+        void appendWord( std::string* out, uintptr_t word ) {
+            out->append( reinterpret_cast<const char*>( &word ), sizeof(word) );
+        }
+
+        /** @return the samples now in the ring as a legacy-format pprof cpu profile */
+        std::string buildProfile( int hz ) {
+            typedef std::map< std::vector<void*>, uintptr_t > StackCounts;
+            StackCounts counts;
+            for ( unsigned i = 0; i < kRingSamples; i++ ) {
+                int depth = samples[i].depth;
+                if ( depth <= kHandlerFrames )
+                    continue;
+                std::vector<void*> stack( samples[i].pcs + kHandlerFrames,
+                                          samples[i].pcs + depth );
+                counts[stack]++;
+            }
+
+            std::string out;
+            // header: header words, version, sampling period in micros, padding
+            appendWord( &out, 0 );
+            appendWord( &out, 3 );
+            appendWord( &out, 0 );
+            appendWord( &out, hz > 0 ? 1000000 / hz : 0 );
+            appendWord( &out, 0 );
+
+            for ( StackCounts::const_iterator i = counts.begin(); i != counts.end(); ++i ) {
+                appendWord( &out, i->second );
+                appendWord( &out, i->first.size() );
+                for ( size_t j = 0; j < i->first.size(); j++ )
+                    appendWord( &out, reinterpret_cast<uintptr_t>( i->first[j] ) );
+            }
+
+            // trailer
+            appendWord( &out, 0 );
+            appendWord( &out, 1 );
+            appendWord( &out, 0 );
+
+            // pprof maps the addresses to symbols with the process's mappings
+            std::ifstream maps( "/proc/self/maps" );
+            std::string line;
+            while ( std::getline( maps, line ) ) {
+                out += line;
+                out += '\n';
+            }
+            return out;
+        }
+
+        class CpuSamplerProfileCommand : public Command {
+        public:
+            CpuSamplerProfileCommand() : Command( "_cpuSamplerProfile" ) {}
+            virtual bool slaveOk() const { return true; }
+            virtual bool adminOnly() const { return true; }
+            virtual bool localHostOnlyIfNoAuth( const BSONObj& cmdObj ) { return true; }
+            virtual LockType locktype() const { return NONE; }
+            virtual void help( stringstream& help ) const {
+                help << "returns the cpu samples taken while cpuSamplingHz > 0, in pprof format";
+            }
+            virtual void addRequiredPrivileges(const std::string& dbname,
+                                               const BSONObj& cmdObj,
+                                               std::vector<Privilege>* out) {
+                ActionSet actions;
+                actions.addAction(ActionType::cpuProfiler);
+                out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+            }
+
+            virtual bool run( string const &db,
+                              BSONObj &cmdObj,
+                              int options,
+                              string &errmsg,
+                              BSONObjBuilder &result,
+                              bool fromRepl ) {
+                std::string profile = buildProfile( cpuSamplingHz.get() );
+                result.append( "samplingHz", cpuSamplingHz.get() );
+                result.appendBinData( "profile", profile.size(), BinDataGeneral, profile.data() );
+                return true;
+            }
+        } cpuSamplerProfileCommand;
+
+    }  // namespace
+
+}  // namespace mongo
+
+#endif  // defined(__linux__)
@@ -30,10 +30,14 @@
 
 #include "mongo/db/commands/dbhash.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/database.h"
+#include "mongo/db/database_holder.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/timer.h"
 
@@ -41,6 +45,13 @@ namespace mongo {
 
     DBHashCmd dbhashCmd;
 
+    // threads hashing the collections of one dbHash command; no more than the cores
+    MONGO_EXPORT_SERVER_PARAMETER(dbHashThreads, int, 4);
+
+    static unsigned hashThreads() {
+        unsigned cores = std::max(boost::thread::hardware_concurrency(), 1U);
+        return std::min(static_cast<unsigned>(std::max(dbHashThreads, 1)), cores);
+    }
 
     void logOpForDbHash( const char* opstr,
                          const char* ns,
@@ -48,7 +59,10 @@ namespace mongo {
                          BSONObj* patt,
                          const BSONObj* fullObj,
                          bool forMigrateCleanup ) {
-        dbhashCmd.wipeCacheForCollection( ns );
+        // document writes move the collection's write stamp, which is what invalidates its
+        // cached hash; commands may have dropped collections, so forget what they hashed to
+        if ( *opstr == 'c' )
+            dbhashCmd.wipeCacheForDatabase( nsToDatabaseSubstring( ns ) );
     }
 
     // ----
@@ -68,21 +82,22 @@ namespace mongo {
 
     string DBHashCmd::hashCollection( const string& fullCollectionName, bool* fromCache ) {
 
-        scoped_ptr<scoped_lock> cachedHashedLock;
-
-        if ( isCachable( fullCollectionName ) ) {
-            cachedHashedLock.reset( new scoped_lock( _cachedHashedMutex ) );
-            string hash = _cachedHashed[fullCollectionName];
-            if ( hash.size() > 0 ) {
+        *fromCache = false;
+        NamespaceDetails * nsd = nsdetails( fullCollectionName );
+        if ( !nsd )
+            return "";
+
+        NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get( fullCollectionName.c_str() );
+        const unsigned long long writeStamp = nsdt.writeStamp();
+        {
+            scoped_lock lk( _cachedHashedMutex );
+            map<string,CachedHash>::const_iterator i = _cachedHashed.find( fullCollectionName );
+            if ( i != _cachedHashed.end() && i->second.writeStamp == writeStamp ) {
                 *fromCache = true;
-                return hash;
+                return i->second.hash;
             }
         }
 
-        *fromCache = false;
-        NamespaceDetails * nsd = nsdetails( fullCollectionName );
-        verify( nsd );
-
         // debug SERVER-761
         NamespaceDetails::IndexIterator ii = nsd->ii();
         while( ii.more() ) {
@@ -133,13 +148,86 @@ namespace mongo {
         md5_finish(&st, d);
         string hash = digestToString( d );
 
-        if ( cachedHashedLock.get() ) {
-            _cachedHashed[fullCollectionName] = hash;
+        // only a complete scan of documents no one wrote to meanwhile is worth keeping
+        if ( Runner::RUNNER_EOF == state && nsdt.writeStamp() == writeStamp ) {
+            scoped_lock lk( _cachedHashedMutex );
+            CachedHash& cached = _cachedHashed[fullCollectionName];
+            cached.writeStamp = writeStamp;
+            cached.hash = hash;
         }
 
         return hash;
     }
 
+    struct DBHashCmd::ParallelHash {
+        ParallelHash( const vector<string>& collections )
+            : collections( collections ),
+              hashes( collections.size() ),
+              fromCache( collections.size(), false ),
+              _next( 0 ) {
+        }
+
+        /** @return false once the collections are used up or a worker has failed */
+        bool take( size_t* i ) {
+            boost::mutex::scoped_lock lk( _mutex );
+            if ( !_error.empty() || _next == collections.size() )
+                return false;
+            *i = _next++;
+            return true;
+        }
+
+        void fail( const string& error ) {
+            boost::mutex::scoped_lock lk( _mutex );
+            if ( _error.empty() )
+                _error = error;
+        }
+
+        string error() {
+            boost::mutex::scoped_lock lk( _mutex );
+            return _error;
+        }
+
+        const vector<string> collections;
+        // each written only by the worker which took that collection
+        vector<string> hashes;
+        vector<bool> fromCache;
+
+    private:
+        boost::mutex _mutex;
+        size_t _next;
+        string _error;
+    };
+
+    void DBHashCmd::hashCollections( ParallelHash* hash ) {
+        try {
+            size_t i;
+            while ( hash->take( &i ) ) {
+                const string& ns = hash->collections[i];
+                Lock::DBRead lk( ns );
+                // don't reopen a database dropped since the collections were listed
+                Database* db = dbHolder().get( ns, storageGlobalParams.dbpath );
+                if ( !db )
+                    continue;
+                Client::Context ctx( ns, db );
+                bool fromCache = false;
+                hash->hashes[i] = hashCollection( ns, &fromCache );
+                hash->fromCache[i] = fromCache;
+            }
+        }
+        catch ( const DBException& e ) {
+            hash->fail( e.toString() );
+        }
+        catch ( const std::exception& e ) {
+            hash->fail( e.what() );
+        }
+    }
+
+    void DBHashCmd::hashWorker( ParallelHash* hash ) {
+        Client::initThread( "dbHash" );
+        hashCollections( hash );
+        cc().shutdown();
+    }
+
     bool DBHashCmd::run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
         Timer timer;
 
@@ -157,20 +245,18 @@ namespace mongo {
         }
 
         list<string> colls;
-        Database* db = cc().database();
-        if ( db )
-            db->namespaceIndex().getNamespaces( colls );
+        {
+            Client::ReadContext ctx( dbname );
+            Database* db = cc().database();
+            if ( db )
+                db->namespaceIndex().getNamespaces( colls );
+        }
         colls.sort();
 
         result.appendNumber( "numCollections" , (long long)colls.size() );
         result.append( "host" , prettyHostName() );
 
-        md5_state_t globalState;
-        md5_init(&globalState);
-
-        vector<string> cached;
-
-        BSONObjBuilder bb( result.subobjStart( "collections" ) );
+        vector<string> toHash;
         for ( list<string>::iterator i=colls.begin(); i != colls.end(); i++ ) {
             string fullCollectionName = *i;
             string shortCollectionName = fullCollectionName.substr( dbname.size() + 1 );
@@ -182,22 +268,52 @@ namespace mongo {
                  desiredCollections.count( shortCollectionName ) == 0 )
                 continue;
 
-            bool fromCache = false;
-            string hash = hashCollection( fullCollectionName, &fromCache );
+            toHash.push_back( fullCollectionName );
+        }
+
+        ParallelHash hash( toHash );
+        size_t numThreads = std::min<size_t>( hashThreads(), toHash.size() );
+        if ( numThreads <= 1 ) {
+            hashCollections( &hash );
+        }
+        else {
+            boost::thread_group threads;
+            for ( size_t i = 0; i < numThreads; i++ )
+                threads.create_thread( boost::bind( &DBHashCmd::hashWorker, this, &hash ) );
+            threads.join_all();
+        }
 
-            bb.append( shortCollectionName, hash );
+        errmsg = hash.error();
+        if ( !errmsg.empty() )
+            return false;
 
-            md5_append( &globalState , (const md5_byte_t*)hash.c_str() , hash.size() );
-            if ( fromCache )
+        md5_state_t globalState;
+        md5_init(&globalState);
+
+        vector<string> cached;
+
+        BSONObjBuilder bb( result.subobjStart( "collections" ) );
+        for ( size_t i = 0; i < toHash.size(); i++ ) {
+            const string& fullCollectionName = toHash[i];
+            const string& collectionHash = hash.hashes[i];
+
+            // dropped while the others were hashed
+            if ( collectionHash.empty() )
+                continue;
+
+            bb.append( fullCollectionName.substr( dbname.size() + 1 ), collectionHash );
+
+            md5_append( &globalState , (const md5_byte_t*)collectionHash.c_str() , collectionHash.size() );
+            if ( hash.fromCache[i] )
                 cached.push_back( fullCollectionName );
         }
         bb.done();
 
         md5digest d;
         md5_finish(&globalState, d);
-        string hash = digestToString( d );
+        string globalHash = digestToString( d );
 
-        result.append( "md5" , hash );
+        result.append( "md5" , globalHash );
         result.appendNumber( "timeMillis", timer.millis() );
 
         result.append( "fromCache", cached );
@@ -205,15 +321,12 @@ namespace mongo {
         return 1;
     }
 
-    void DBHashCmd::wipeCacheForCollection( const StringData& ns ) {
-        if ( !isCachable( ns ) )
-            return;
+    void DBHashCmd::wipeCacheForDatabase( const StringData& dbname ) {
+        const string prefix = dbname.toString() + ".";
         scoped_lock lk( _cachedHashedMutex );
-        _cachedHashed.erase( ns.toString() );
-    }
-
-    bool DBHashCmd::isCachable( const StringData& ns ) const {
-        return ns.startsWith( "config." );
+        map<string,CachedHash>::iterator i = _cachedHashed.lower_bound( prefix );
+        while ( i != _cachedHashed.end() && StringData( i->first ).startsWith( prefix ) )
+            _cachedHashed.erase( i++ );
     }
 
 }
@@ -46,22 +46,32 @@ namespace mongo {
         DBHashCmd();
 
         virtual bool slaveOk() const { return true; }
-        virtual LockType locktype() const { return READ; }
+        // the collections are hashed on worker threads, each taking its own read lock
+        virtual LockType locktype() const { return NONE; }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out);
 
         virtual bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool);
 
-        void wipeCacheForCollection( const StringData& ns );
+        void wipeCacheForDatabase( const StringData& dbname );
 
     private:
 
-        bool isCachable( const StringData& ns ) const;
+        struct ParallelHash;
+        void hashCollections( ParallelHash* hash );
+        void hashWorker( ParallelHash* hash );
 
+        /** @return "" if the collection no longer exists */
         string hashCollection( const string& fullCollectionName, bool* fromCache );
 
-        map<string,string> _cachedHashed;
+        // a hash stays good for as long as the collection's write stamp is the one it was
+        // computed at
+        struct CachedHash {
+            unsigned long long writeStamp;
+            string hash;
+        };
+        map<string,CachedHash> _cachedHashed;
         mutex _cachedHashedMutex;
 
     };
@@ -34,6 +34,7 @@
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/btreecursor.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
@@ -97,7 +98,8 @@ namespace mongo {
             else {
 
                 // query is empty, so lets see if we can find an index
-                // with the key so we don't have to hit the raw data
+                // with the key so we don't have to hit the raw data.  prefer an
+                // index led by the key, which can be skip scanned
                 NamespaceDetails::IndexIterator ii = d->ii();
                 while ( ii.more() ) {
                     IndexDetails& idx = ii.next();
@@ -106,8 +108,14 @@ namespace mongo {
                         continue;
 
                     if ( idx.inKeyPattern( key ) ) {
-                        cursor = getBestGuessCursor( ns.c_str(), BSONObj(), idx.keyPattern() );
-                        if( cursor.get() ) break;
+                        bool leading = idx.keyPattern().firstElementFieldName() == key;
+                        if ( cursor.get() && !leading )
+                            continue;
+                        shared_ptr<Cursor> c =
+                            getBestGuessCursor( ns.c_str(), BSONObj(), idx.keyPattern() );
+                        if ( c.get() )
+                            cursor = c;
+                        if ( cursor.get() && leading ) break;
                     }
 
                 }
@@ -141,9 +149,18 @@ namespace mongo {
                 }
             }
 
+            // When the distinct key leads the index, only the first key of each distinct value
+            // needs to be examined.
+            BtreeCursor* skipScan = NULL;
+            BSONElement firstIndexField = cursor->indexKeyPattern().firstElement();
+            if ( firstIndexField.isNumber() && firstIndexField.fieldName() == key ) {
+                skipScan = dynamic_cast<BtreeCursor*>( cursor.get() );
+            }
+
             while ( cursor->ok() ) {
                 nscanned++;
                 bool loadedRecord = false;
+                long long nBeforeKey = n;
 
                 if ( cursor->currentMatches( &md ) && !cursor->getsetdup( cursor->currLoc() ) ) {
                     n++;
@@ -172,7 +189,14 @@ namespace mongo {
                 if ( loadedRecord || md.hasLoadedRecord() )
                     nscannedObjects++;
 
-                cursor->advance();
+                if ( skipScan && n > nBeforeKey && !cursor->isMultiKey() ) {
+                    // Every other key with the same leading value holds the same distinct value,
+                    // so reseek past all of them.
+                    skipScan->advancePastPrefix( 1 );
+                }
+                else {
+                    cursor->advance();
+                }
 
                 if (!cc->yieldSometimes( ClientCursor::MaybeCovered )) {
                     cc.release();
@@ -57,7 +57,8 @@ namespace mongo {
         CmdFindAndModify() : Command("findAndModify", false, "findandmodify") { }
         virtual bool logTheOp() { return false; } // the modifications will be logged directly
         virtual bool slaveOk() const { return false; }
-        virtual LockType locktype() const { return WRITE; }
+        // the candidate document is found under a read lock, see candidateQuery()
+        virtual LockType locktype() const { return NONE; }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out) {
@@ -92,13 +93,18 @@ namespace mongo {
                 return false;
             }
             
+            // no lock is held here, so a page fault can restart the attempt; each attempt builds
+            // its own reply so a restarted one doesn't leave fields behind
             PageFaultRetryableSection s;
             while ( 1 ) {
                 try {
-                    return runNoDirectClient( ns , 
-                                              query , fields , update , 
-                                              upsert , returnNew , remove , 
-                                              result , errmsg );
+                    BSONObjBuilder attempt;
+                    bool ok = runNoDirectClient( ns , 
+                                                 query , fields , update , 
+                                                 upsert , returnNew , remove , 
+                                                 attempt , errmsg );
+                    result.appendElements( attempt.done() );
+                    return ok;
                 }
                 catch ( PageFaultException& e ) {
                     e.touch();
@@ -125,18 +131,77 @@ namespace mongo {
                 
         }
 
+        /**
+         * The query (and sort) phase runs under a read lock and only yields the _id of a
+         * candidate document.  Once the write lock is held the candidate is looked up again by
+         * _id together with the rest of the original query.  If it no longer matches, another
+         * writer got there first and the read phase is retried.  After maxCandidateConflicts
+         * such misses the query runs under the write lock, so a hot queue still makes progress.
+         *
+         * @return the query to run under the write lock: query itself, or _id and query together
+         */
+        static BSONObj candidateQuery( const BSONObj& query , const BSONObj& candidate ) {
+            if ( candidate.isEmpty() )
+                return query;
+
+            BSONObjBuilder b( query.objsize() + candidate.objsize() );
+            b.append( candidate["_id"] );
+            b.appendElements( query );
+            return b.obj();
+        }
+
+        /** @return true if a candidate from the read phase can be re-verified by _id */
+        static bool canUseCandidate( const BSONObj& query , const BSONObj& doc ) {
+            return doc["_id"].type() && query["_id"].eoo();
+        }
+
+        static const int maxCandidateConflicts = 3;
+
         bool runNoDirectClient( const string& ns , 
                                 const BSONObj& queryOriginal , const BSONObj& fields , const BSONObj& update , 
                                 bool upsert , bool returnNew , bool remove ,
                                 BSONObjBuilder& result , string& errmsg ) {
             
-            
-            Lock::DBWrite lk( ns );
-            Client::Context cx( ns );
+            int conflicts = 0;
+            while ( 1 ) {
+                BSONObj candidate;
+                if ( conflicts < maxCandidateConflicts ) {
+                    Client::ReadContext ctx( ns );
+                    BSONObj doc;
+                    if ( ! Helpers::findOne( ns.c_str() , queryOriginal , doc ) ) {
+                        if ( ! upsert ) {
+                            // nothing to modify, so no write lock needed
+                            _appendHelper( result , doc , false , fields );
+                            return true;
+                        }
+                    }
+                    else if ( canUseCandidate( queryOriginal , doc ) ) {
+                        candidate = doc["_id"].wrap();
+                    }
+                }
 
-            BSONObj doc;
-            
-            bool found = Helpers::findOne( ns.c_str() , queryOriginal , doc );
+                Lock::DBWrite lk( ns );
+                Client::Context cx( ns );
+
+                BSONObj doc;
+                bool found = Helpers::findOne( ns.c_str() , candidateQuery( queryOriginal , candidate ) , doc );
+                if ( ! found && ! candidate.isEmpty() ) {
+                    // modified or removed since the read phase
+                    conflicts++;
+                    continue;
+                }
+
+                return modifyLocked( ns , queryOriginal , fields , update ,
+                                     upsert , returnNew , remove ,
+                                     doc , found , result , errmsg );
+            }
+        }
+
+        bool modifyLocked( const string& ns , 
+                           const BSONObj& queryOriginal , const BSONObj& fields , const BSONObj& update , 
+                           bool upsert , bool returnNew , bool remove ,
+                           BSONObj& doc , bool found ,
+                           BSONObjBuilder& result , string& errmsg ) {
 
             BSONObj queryModified = queryOriginal;
             if ( found && doc["_id"].type() && ! isSimpleIdQuery( queryOriginal ) ) {
@@ -261,21 +326,58 @@ namespace mongo {
         }
         
         virtual bool run(const string& dbname, BSONObj& cmdObj, int x, string& errmsg, BSONObjBuilder& result, bool y) {
-            static DBDirectClient db;
-
             if ( cmdObj["sort"].eoo() )
                 return runNoDirectClient( dbname , cmdObj , x, errmsg , result, y );
 
+            DBDirectClient db;
+
             string ns = dbname + '.' + cmdObj.firstElement().valuestr();
 
             BSONObj origQuery = cmdObj.getObjectField("query"); // defaults to {}
-            Query q (origQuery);
+            Query sortedQuery (origQuery);
             BSONElement sort = cmdObj["sort"];
             if (!sort.eoo())
-                q.sort(sort.embeddedObjectUserCheck());
+                sortedQuery.sort(sort.embeddedObjectUserCheck());
 
             bool upsert = cmdObj["upsert"].trueValue();
 
+            // see candidateQuery()
+            int conflicts = 0;
+            while ( 1 ) {
+                BSONObj candidate;
+                if ( conflicts < maxCandidateConflicts ) {
+                    BSONObj idField = BSON( "_id" << 1 );
+                    BSONObj doc = db.findOne(ns, sortedQuery, &idField);
+                    if (doc.isEmpty() && !upsert) {
+                        result.appendNull("value");
+                        return true;
+                    }
+                    if (!doc.isEmpty() && canUseCandidate(origQuery, doc))
+                        candidate = doc.getOwned();
+                }
+
+                Lock::DBWrite lk( ns );
+                Client::Context cx( ns );
+
+                Query q = candidate.isEmpty() ? sortedQuery : Query(candidateQuery(origQuery, candidate));
+                if (runSortedLocked(db, dbname, ns, cmdObj, origQuery, q, upsert,
+                                    !candidate.isEmpty(), errmsg, result))
+                    return true;
+                if (!errmsg.empty())
+                    return false;
+                conflicts++;
+            }
+        }
+
+        /**
+         * @return false with an empty errmsg if the candidate from the read phase no longer
+         * matches the query
+         */
+        bool runSortedLocked(DBDirectClient& db, const string& dbname, const string& ns,
+                             const BSONObj& cmdObj, const BSONObj& origQuery, Query q,
+                             bool upsert, bool haveCandidate,
+                             string& errmsg, BSONObjBuilder& result) {
+
             BSONObj fieldsHolder (cmdObj.getObjectField("fields"));
             const BSONObj* fields = (fieldsHolder.isEmpty() ? NULL : &fieldsHolder);
 
@@ -288,6 +390,9 @@ namespace mongo {
 
             BSONObj out = db.findOne(ns, q, fields);
             if (out.isEmpty()) {
+                if (haveCandidate)
+                    return false;
+
                 if (!upsert) {
                     result.appendNull("value");
                     return true;
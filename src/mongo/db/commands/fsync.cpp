@@ -32,6 +32,7 @@
 
 #include "mongo/db/commands/fsync.h"
 
+#include <boost/filesystem/operations.hpp>
 #include <string>
 #include <vector>
 
@@ -41,13 +42,62 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/dur.h"
+#include "mongo/db/dur_journal.h"
 #include "mongo/db/client.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/kill_current_op.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/util/background.h"
 
 namespace mongo {
-    
+
+    namespace dur {
+        boost::filesystem::path getJournalDir();
+    }
+
+    namespace {
+
+        /** old journal files are kept while one of these is held, see dur::journalPin() */
+        class JournalPin : boost::noncopyable {
+        public:
+            JournalPin() : _held(true) { dur::journalPin(); }
+            ~JournalPin() {
+                if ( _held )
+                    dur::journalUnpin();
+            }
+
+            /** @return false if the journal was truncated while pinned */
+            bool release() {
+                _held = false;
+                return dur::journalUnpin();
+            }
+
+        private:
+            bool _held;
+        };
+
+        /** appends the files under root/dir, relative to root, leaving out the journal and lock */
+        void listDataFiles(const boost::filesystem::path& root,
+                           const boost::filesystem::path& dir,
+                           vector<boost::filesystem::path>* files) {
+            for ( boost::filesystem::directory_iterator i( root / dir );
+                    i != boost::filesystem::directory_iterator();
+                    ++i ) {
+                boost::filesystem::path p = dir / boost::filesystem::path(*i).leaf();
+                if ( boost::filesystem::is_directory( *i ) ) {
+                    if ( p != "journal" )
+                        listDataFiles( root, p, files );
+                }
+                else if ( p != "mongod.lock" ) {
+                    files->push_back( p );
+                }
+            }
+        }
+
+    }
+
     class FSyncLockThread : public BackgroundJob {
         void doRealWork();
     public:
@@ -99,6 +149,14 @@ namespace mongo {
                 return false;
             }
 
+            if ( cmdObj["backup"].type() == String ) {
+                if ( cmdObj["lock"].trueValue() ) {
+                    errmsg = "fsync: backup can't be combined with lock";
+                    return false;
+                }
+                return backup( cmdObj["backup"].String(), errmsg, result );
+            }
+
             bool sync = !cmdObj["async"].trueValue(); // async means do an fsync, but return immediately
             bool lock = cmdObj["lock"].trueValue();
             log() << "CMD fsync: sync:" << sync << " lock:" << lock << endl;
@@ -139,6 +197,94 @@ namespace mongo {
             }
             return 1;
         }
+
+        /**
+         * Copies the data files to 'to' while writes go on, then the journal files written since
+         * the lsn the copy started at.  Starting a mongod on the copy recovers it from that
+         * journal to a consistent state as of the end of the backup.
+         */
+        bool backup(const string& to, string& errmsg, BSONObjBuilder& result) {
+            if ( !storageGlobalParams.dur ) {
+                errmsg = "fsync: backup needs journaling";
+                return false;
+            }
+
+            boost::filesystem::path dbpath =
+                boost::filesystem::system_complete( storageGlobalParams.dbpath );
+            boost::filesystem::path target = boost::filesystem::system_complete( to );
+            for ( boost::filesystem::path p = target; !p.empty(); p = p.parent_path() ) {
+                if ( boost::filesystem::exists( p ) && boost::filesystem::equivalent( p, dbpath ) ) {
+                    errmsg = "fsync: can't back up into the dbpath";
+                    return false;
+                }
+            }
+            if ( boost::filesystem::exists( target ) && !boost::filesystem::is_empty( target ) ) {
+                errmsg = "fsync: backup directory must be empty";
+                return false;
+            }
+
+            log() << "fsync: backing up " << dbpath.string() << " to " << target.string() << endl;
+
+            vector<boost::filesystem::path> files;
+            long long bytes = 0;
+            int journalFiles = 0;
+            try {
+                boost::filesystem::create_directories( target / "journal" );
+
+                JournalPin pin;
+
+                // recovery of the copy starts from this lsn.  everything journaled before it was
+                // in the data files when it was written, so before they are copied.  a torn read
+                // fails the lsn's check and recovery starts from the first journal file instead.
+                boost::filesystem::path lsn = dur::getJournalDir() / "lsn";
+                if ( boost::filesystem::exists( lsn ) )
+                    boost::filesystem::copy_file( lsn, target / "journal" / "lsn" );
+
+                listDataFiles( dbpath, boost::filesystem::path(), &files );
+                ProgressMeterHolder pm( cc().curop()->setMessage( "fsync backup",
+                                                                  "Backup: Data Files Copied",
+                                                                  files.size() ) );
+                for ( vector<boost::filesystem::path>::const_iterator i = files.begin();
+                        i != files.end(); ++i ) {
+                    boost::filesystem::create_directories( ( target / *i ).parent_path() );
+                    boost::filesystem::copy_file( dbpath / *i, target / *i );
+                    bytes += boost::filesystem::file_size( target / *i );
+                    pm.hit();
+                    killCurrentOp.checkForInterrupt();
+                }
+                pm.finished();
+
+                // writes acknowledged by now are in the journal files copied below
+                getDur().awaitCommit();
+
+                for ( boost::filesystem::directory_iterator i( dur::getJournalDir() );
+                        i != boost::filesystem::directory_iterator();
+                        ++i ) {
+                    string name = boost::filesystem::path(*i).leaf().string();
+                    if ( !str::startsWith( name, "j._" ) )
+                        continue;
+                    boost::filesystem::copy_file( *i, target / "journal" / name );
+                    journalFiles++;
+                }
+
+                if ( !pin.release() ) {
+                    errmsg = "fsync: the journal was truncated during the backup, by a "
+                             "dropDatabase, repairDatabase or fsync lock; back up again";
+                    return false;
+                }
+            }
+            catch ( const boost::filesystem::filesystem_error& e ) {
+                errmsg = str::stream() << "fsync: backup failed: " << e.what();
+                return false;
+            }
+
+            log() << "fsync: backed up " << files.size() << " data files and " << journalFiles
+                  << " journal files to " << target.string() << endl;
+            result.append( "numFiles", static_cast<int>( files.size() ) );
+            result.appendNumber( "bytes", bytes );
+            result.append( "journalFiles", journalFiles );
+            return true;
+        }
     } fsyncCmd;
 
     SimpleMutex filesLockedFsync("filesLockedFsync");
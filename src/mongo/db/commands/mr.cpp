@@ -30,6 +30,10 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <pcrecpp.h>
+
 #include "mongo/db/commands/mr.h"
 
 #include "mongo/client/connpool.h"
@@ -43,6 +47,7 @@
 #include "mongo/db/matcher.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/repl/is_master.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/s/collection_metadata.h"
@@ -66,7 +71,11 @@ namespace mongo {
         }
 
         void JSFunction::init( State * state ) {
-            _scope = state->scope();
+            init( state->scope() );
+        }
+
+        void JSFunction::init( Scope * scope ) {
+            _scope = scope;
             verify( _scope );
             _scope->init( &_wantedScope );
 
@@ -234,6 +243,263 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        namespace {
+            // function() { emit(this.<field>, this.<field> or <number>); }
+            const pcrecpp::RE nativeMapForm(
+                    "\\s*function(?:\\s+[A-Za-z_$][A-Za-z0-9_$]*)?\\s*\\(\\s*\\)\\s*\\{"
+                    "\\s*emit\\s*\\(\\s*this\\.([A-Za-z_$][A-Za-z0-9_$]*)\\s*,"
+                    "\\s*(?:this\\.([A-Za-z_$][A-Za-z0-9_$]*)|(-?[0-9]+(?:\\.[0-9]+)?))\\s*\\)"
+                    "\\s*;?\\s*\\}\\s*;?\\s*" );
+
+            // function(<key>, <values>) { return Array.sum(<values>); }
+            const pcrecpp::RE nativeReduceForm(
+                    "\\s*function(?:\\s+[A-Za-z_$][A-Za-z0-9_$]*)?\\s*\\("
+                    "\\s*[A-Za-z_$][A-Za-z0-9_$]*\\s*,"
+                    "\\s*([A-Za-z_$][A-Za-z0-9_$]*)\\s*\\)"
+                    "\\s*\\{\\s*return\\s+Array\\.sum\\s*\\(\\s*([A-Za-z_$][A-Za-z0-9_$]*)\\s*\\)"
+                    "\\s*;?\\s*\\}\\s*;?\\s*" );
+
+            bool isCode( const BSONElement& code ) {
+                return code.type() == Code || code.type() == String;
+            }
+
+            /**
+             * @return true if javascript would emit 'e' unchanged but for NumberInt, which it
+             * emits as a double.  Missing fields aren't covered, as javascript emits undefined.
+             */
+            bool emitsAsIs( const BSONElement& e ) {
+                switch ( e.type() ) {
+                case NumberDouble:
+                case NumberInt:
+                case String:
+                case jstOID:
+                case Bool:
+                case Date:
+                case jstNULL:
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            void appendEmitted( BSONObjBuilder& b , const StringData& name ,
+                                const BSONElement& e ) {
+                if ( e.type() == NumberInt )
+                    b.append( name , e.numberDouble() );
+                else
+                    b.appendAs( e , name );
+            }
+        }
+
+        NativeMapper* NativeMapper::make( const BSONElement& code ) {
+            if ( !isCode( code ) )
+                return NULL;
+
+            string keyField;
+            string valueField;
+            string valueConstant;
+            if ( !nativeMapForm.FullMatch( code._asCode() , &keyField , &valueField ,
+                                           &valueConstant ) )
+                return NULL;
+            return new NativeMapper( code , keyField , valueField ,
+                                     valueField.empty() ? atof( valueConstant.c_str() ) : 0 );
+        }
+
+        NativeMapper::NativeMapper( const BSONElement& code , const string& keyField ,
+                                    const string& valueField , double valueConstant )
+            : _js( code ), _state( 0 ), _keyField( keyField ), _valueField( valueField ),
+              _valueConstant( valueConstant ) {
+        }
+
+        void NativeMapper::init( State * state ) {
+            _js.init( state );
+            _state = state;
+        }
+
+        void NativeMapper::map( const BSONObj& o ) {
+            if ( _state->jsMode() ) {
+                // emits have to go to the js map
+                _js.map( o );
+                return;
+            }
+
+            BSONElement key = o[_keyField];
+            BSONElement value;
+            if ( !_valueField.empty() ) {
+                value = o[_valueField];
+                if ( !emitsAsIs( value ) ) {
+                    _js.map( o );
+                    return;
+                }
+            }
+            if ( !key.eoo() && !emitsAsIs( key ) ) {
+                _js.map( o );
+                return;
+            }
+
+            BSONObjBuilder b;
+            if ( key.eoo() )
+                b.appendNull( "0" ); // an undefined key is emitted as null
+            else
+                appendEmitted( b , "0" , key );
+            if ( _valueField.empty() )
+                b.append( "1" , _valueConstant );
+            else
+                appendEmitted( b , "1" , value );
+            BSONObj tuple = b.obj();
+            uassert( 13069 , "an emit can't be more than half max bson size" ,
+                     tuple.objsize() < ( BSONObjMaxUserSize / 2 ) );
+            _state->emit( tuple );
+        }
+
+        NativeReducer* NativeReducer::make( const BSONElement& code ) {
+            if ( !isCode( code ) )
+                return NULL;
+
+            string valuesParam;
+            string summed;
+            if ( !nativeReduceForm.FullMatch( code._asCode() , &valuesParam , &summed ) ||
+                 valuesParam != summed )
+                return NULL;
+            return new NativeReducer( code );
+        }
+
+        bool NativeReducer::sum( const BSONList& tuples , double* total ) {
+            // in order, as Array.sum adds
+            double s = 0;
+            for ( unsigned i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator j( tuples[i] );
+                j.next();
+                BSONElement value = j.next();
+                if ( value.type() != NumberDouble && value.type() != NumberInt )
+                    return false;
+                s = i == 0 ? value.numberDouble() : s + value.numberDouble();
+            }
+            *total = s;
+            return true;
+        }
+
+        BSONObj NativeReducer::reduce( const BSONList& tuples ) {
+            if ( tuples.size() <= 1 )
+                return tuples[0];
+
+            double total;
+            if ( !sum( tuples , &total ) ) {
+                BSONObj res = _js.reduce( tuples );
+                ++numReduces;
+                return res;
+            }
+            ++numReduces;
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            b.append( "1" , total );
+            return b.obj();
+        }
+
+        BSONObj NativeReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            double total;
+            if ( tuples.size() == 1 || !sum( tuples , &total ) ) {
+                if ( tuples.size() > 1 )
+                    ++numReduces;
+                return _js.finalReduce( tuples , finalizer );
+            }
+            ++numReduces;
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "_id" );
+            b.append( "value" , total );
+            BSONObj res = b.obj();
+            if ( finalizer )
+                res = finalizer->finalize( res );
+            return res;
+        }
+
+        /**
+         * @return the (key, value) tuple staged for the arguments of an emit() call; an
+         * undefined key is staged as null
+         */
+        static BSONObj emittedTuple( const BSONObj& args ) {
+            uassert( 10077 , "fast_emit takes 2 args" , args.nFields() == 2 );
+            uassert( 13069 , "an emit can't be more than half max bson size" ,
+                     args.objsize() < ( BSONObjMaxUserSize / 2 ) );
+
+            if ( args.firstElement().type() != Undefined )
+                return args;
+
+            BSONObjBuilder b( args.objsize() );
+            b.appendNull( "" );
+            BSONObjIterator i( args );
+            i.next();
+            b.append( i.next() );
+            return b.obj();
+        }
+
+        /**
+         * Runs the js map function in a scope of its own, on a thread of its own, collecting
+         * the emits for State::mapInParallel() to stage.
+         */
+        class MapWorker : boost::noncopyable {
+        public:
+            MapWorker( const Config& config , const string& userToken )
+                : _func( "_map" , config.mapFunction.firstElement() ),
+                  _params( config.mapParams ) {
+                _scope.reset( globalScriptEngine->getPooledScope(
+                                  config.dbname , "mapreduce" + userToken ).release() );
+                if ( ! config.scopeSetup.isEmpty() )
+                    _scope->init( &config.scopeSetup );
+                _func.init( _scope.get() );
+                _scope->injectNative( "emit" , emit , this );
+            }
+
+            /** Maps docs[begin, end), catching any error for error(). */
+            void map( const BSONList* docs , size_t begin , size_t end ) {
+                Client::initThread( "mrMapWorker" );
+                _error.clear();
+                try {
+                    Scope::NoDBAccess no =
+                            _scope->disableDBAccess( "can't access db inside a parallel map" );
+                    for ( size_t i = begin; i < end; i++ ) {
+                        if ( _scope->invoke( _func.func() , &_params , &(*docs)[i] , 0 , true ) )
+                            uasserted( 9014 , str::stream() << "map invoke failed: "
+                                                            << _scope->getError() );
+                    }
+                }
+                catch ( const DBException& e ) {
+                    _error = e.toString();
+                }
+                cc().shutdown();
+            }
+
+            BSONList& emitted() { return _emitted; }
+
+            /** @return the error that stopped the last map(), or empty */
+            const string& error() const { return _error; }
+
+        private:
+            static BSONObj emit( const BSONObj& args , void* data ) {
+                MapWorker* worker = static_cast<MapWorker*>( data );
+                worker->_emitted.push_back( emittedTuple( args ).getOwned() );
+                return BSONObj();
+            }
+
+            JSFunction _func;
+            BSONObj _params;
+            scoped_ptr<Scope> _scope;
+            BSONList _emitted;
+            string _error;
+        };
+
+        // Recognized map and reduce functions run without javascript when set.
+        MONGO_EXPORT_SERVER_PARAMETER( mapReduceNativeFunctions, bool, true );
+
+        // Threads that run the js map function of a mapReduce not in jsMode.  The map function
+        // can't access the db when this is above 1.
+        MONGO_EXPORT_SERVER_PARAMETER( mapReduceMapThreads, int, 1 );
+
+        // documents handed to the parallel map workers at a time
+        static const size_t parallelMapBatchSize = 10000;
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj )
         {
             dbname = _dbname;
@@ -277,8 +543,19 @@ namespace mongo {
                 if ( cmdObj["scope"].type() == Object )
                     scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
 
-                mapper.reset( new JSMapper( cmdObj["map"] ) );
-                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                // common map and reduce functions run natively, unless a scope or map params
+                // could change what they do
+                Mapper* nativeMapper = NULL;
+                Reducer* nativeReducer = NULL;
+                if ( mapReduceNativeFunctions && scopeSetup.isEmpty() ) {
+                    if ( cmdObj["mapparams"].type() != Array )
+                        nativeMapper = NativeMapper::make( cmdObj["map"] );
+                    nativeReducer = NativeReducer::make( cmdObj["reduce"] );
+                }
+                mapper.reset( nativeMapper ? nativeMapper : new JSMapper( cmdObj["map"] ) );
+                mapFunction = cmdObj["map"].wrap();
+                reducer.reset( nativeReducer ? nativeReducer
+                                             : new JSReducer( cmdObj["reduce"] ) );
                 if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
                     finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
 
@@ -658,6 +935,13 @@ namespace mongo {
 
             switchMode(_config.jsMode); // set up js-mode based on Config
 
+            if ( ! _config.jsMode && mapReduceMapThreads > 1 &&
+                 dynamic_cast<JSMapper*>( _config.mapper.get() ) ) {
+                for ( int i = 0; i < mapReduceMapThreads; i++ ) {
+                    _mapWorkers.mutableVector().push_back( new MapWorker( _config, userToken ) );
+                }
+            }
+
             // global JS map/reduce hashmap
             // we use a standard JS object which means keys are only simple types
             // we could also add a real hashmap from a library and object comparison methods
@@ -1016,6 +1300,29 @@ namespace mongo {
             _add( _temp.get() , a , _size );
         }
 
+        void State::mapInParallel( const BSONList& docs ) {
+            const vector<MapWorker*>& workers = _mapWorkers.vector();
+            const size_t perWorker = ( docs.size() + workers.size() - 1 ) / workers.size();
+            {
+                boost::thread_group threads;
+                for ( size_t i = 0; i < workers.size() && i * perWorker < docs.size(); i++ ) {
+                    size_t end = min( docs.size() , ( i + 1 ) * perWorker );
+                    threads.create_thread( boost::bind( &MapWorker::map , workers[i] , &docs ,
+                                                        i * perWorker , end ) );
+                }
+                threads.join_all();
+            }
+
+            for ( size_t i = 0; i < workers.size(); i++ ) {
+                uassert( 17320 , workers[i]->error() , workers[i]->error().empty() );
+                BSONList& emitted = workers[i]->emitted();
+                for ( size_t j = 0; j < emitted.size(); j++ ) {
+                    emit( emitted[j] );
+                }
+                emitted.clear();
+            }
+        }
+
         void State::_add( InMemory* im, const BSONObj& a , long& size ) {
             BSONList& all = (*im)[a];
             all.push_back( a );
@@ -1069,21 +1376,8 @@ namespace mongo {
          * emit that will be called by js function
          */
         BSONObj fast_emit( const BSONObj& args, void* data ) {
-            uassert( 10077 , "fast_emit takes 2 args" , args.nFields() == 2 );
-            uassert( 13069 , "an emit can't be more than half max bson size" , args.objsize() < ( BSONObjMaxUserSize / 2 ) );
-            
             State* state = (State*) data;
-            if ( args.firstElement().type() == Undefined ) {
-                BSONObjBuilder b( args.objsize() );
-                b.appendNull( "" );
-                BSONObjIterator i( args );
-                i.next();
-                b.append( i.next() );
-                state->emit( b.obj() );
-            }
-            else {
-                state->emit( args );
-            }
+            state->emit( emittedTuple( args ) );
             return BSONObj();
         }
 
@@ -1209,6 +1503,9 @@ namespace mongo {
 
                     wassert( config.limit < 0x4000000 ); // see case on next line to 32 bit unsigned
                     long long mapTime = 0;
+                    // documents waiting for the parallel map workers
+                    BSONList toMap;
+                    Timer mt;
                     {
                         // We've got a cursor preventing migrations off, now re-establish our useful cursor
 
@@ -1228,7 +1525,6 @@ namespace mongo {
                                                                      config.ns.c_str()));
                         uassert( 16053, str::stream() << "could not create client cursor over " << config.ns << " for query : " << config.filter << " sort : " << config.sort, cursor.get() );
 
-                        Timer mt;
                         // go through each doc
                         while ( cursor->ok() ) {
                             if ( ! cursor->yieldSometimes( ClientCursor::WillNeed ) ) {
@@ -1261,14 +1557,28 @@ namespace mongo {
                             }
 
                             // do map
-                            if ( config.verbose ) mt.reset();
-                            config.mapper->map( o );
-                            if ( config.verbose ) mapTime += mt.micros();
+                            if ( state.mapsInParallel() ) {
+                                toMap.push_back( o.getOwned() );
+                            }
+                            else {
+                                if ( config.verbose ) mt.reset();
+                                config.mapper->map( o );
+                                if ( config.verbose ) mapTime += mt.micros();
+                            }
 
                             num++;
                             if ( num % 100 == 0 ) {
                                 // try to yield lock regularly
                                 ClientCursorYieldLock yield (cursor.get());
+
+                                // map a full batch on the worker threads while the lock is yielded
+                                if ( toMap.size() >= parallelMapBatchSize ) {
+                                    if ( config.verbose ) mt.reset();
+                                    state.mapInParallel( toMap );
+                                    toMap.clear();
+                                    if ( config.verbose ) mapTime += mt.micros();
+                                }
+
                                 Timer t;
                                 // check if map needs to be dumped to disk
                                 state.checkSize();
@@ -1286,6 +1596,12 @@ namespace mongo {
                                 break;
                         }
                     }
+                    if ( ! toMap.empty() ) {
+                        if ( config.verbose ) mt.reset();
+                        state.mapInParallel( toMap );
+                        toMap.clear();
+                        if ( config.verbose ) mapTime += mt.micros();
+                    }
                     pm.finished();
 
                     killCurrentOp.checkForInterrupt();
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/instance.h"
@@ -47,6 +48,7 @@ namespace mongo {
         typedef vector<BSONObj> BSONList;
 
         class State;
+        class MapWorker;
 
         // ------------  function interfaces -----------
 
@@ -97,6 +99,7 @@ namespace mongo {
             virtual ~JSFunction() {}
 
             virtual void init( State * state );
+            void init( Scope * scope );
 
             Scope * scope() const { return _scope; }
             ScriptingFunction func() const { return _func; }
@@ -151,6 +154,59 @@ namespace mongo {
 
         };
 
+        // ------------  native implementations of common js functions -----------
+
+        /**
+         * Runs map functions of the form
+         *     function() { emit(this.<field>, this.<field> or <number>); }
+         * without calling into javascript, emitting what the js function would.  Documents with
+         * values that javascript would convert in ways not reproduced here, and maps in jsMode,
+         * go to the js function.
+         */
+        class NativeMapper : public Mapper {
+        public:
+            /** @return a NativeMapper if 'code' has the form above, otherwise NULL */
+            static NativeMapper* make( const BSONElement& code );
+
+            virtual void map( const BSONObj& o );
+            virtual void init( State * state );
+
+        private:
+            NativeMapper( const BSONElement& code , const string& keyField ,
+                          const string& valueField , double valueConstant );
+
+            JSMapper _js;
+            State * _state;
+            string _keyField;
+            string _valueField; // empty if every value is _valueConstant
+            double _valueConstant;
+        };
+
+        /**
+         * Runs reduce functions of the form
+         *     function(key, values) { return Array.sum(values); }
+         * without calling into javascript, when all the values are numbers javascript would
+         * add as doubles.  Other values go to the js function.
+         */
+        class NativeReducer : public Reducer {
+        public:
+            /** @return a NativeReducer if 'code' has the form above, otherwise NULL */
+            static NativeReducer* make( const BSONElement& code );
+
+            virtual void init( State * state ) { _js.init( state ); }
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+
+        private:
+            explicit NativeReducer( const BSONElement& code ) : _js( code ) {}
+
+            /** @return false if a value isn't a number javascript adds as a double */
+            static bool sum( const BSONList& tuples , double* total );
+
+            JSReducer _js;
+        };
+
         // -----------------
 
 
@@ -193,6 +249,7 @@ namespace mongo {
 
             BSONObj mapParams;
             BSONObj scopeSetup;
+            BSONObj mapFunction; // { map: <the map function> }, for the parallel map workers
 
             // output tables
             string incLong;
@@ -251,6 +308,15 @@ namespace mongo {
              */
             void emit( const BSONObj& a );
 
+            /** @return true if the js map function runs on several threads, in mapInParallel() */
+            bool mapsInParallel() const { return !_mapWorkers.empty(); }
+
+            /**
+             * Maps 'docs' with the js map function, each map worker taking a contiguous part,
+             * then stages the emits in document order, as mapping them one by one would.
+             */
+            void mapInParallel( const BSONList& docs );
+
             /**
              * if size is big, run a reduce
              * if its still big, dump to temp collection
@@ -342,6 +408,8 @@ namespace mongo {
             ScriptingFunction _reduceAndEmit;
             ScriptingFunction _reduceAndFinalize;
             ScriptingFunction _reduceAndFinalizeAndInsert;
+
+            OwnedPointerVector<MapWorker> _mapWorkers;
         };
 
         BSONObj fast_emit( const BSONObj& args, void* data );
@@ -0,0 +1,149 @@
+// parallel_collection_scan.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/query/internal_runner.h"
+#include "mongo/db/storage/extent.h"
+
+namespace mongo {
+
+    /**
+     * Splits a collection into ranges of its extents and returns a cursor over each, so that
+     * clients can read the collection over several connections at once.
+     */
+    class ParallelCollectionScanCommand : public Command {
+    public:
+        ParallelCollectionScanCommand() : Command("parallelCollectionScan") {}
+        virtual bool slaveOk() const { return false; }
+        virtual bool slaveOverrideOk() const { return true; }
+        virtual LockType locktype() const { return READ; }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::find);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+        virtual void help( stringstream &help ) const {
+            help << "{ parallelCollectionScan : 'collection name' , numCursors : <n> }\n"
+                    "returns up to n cursors which together return every document of the "
+                    "collection once, like a single collection scan would";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            string ns = dbname + '.' + cmdObj.firstElement().valuestr();
+
+            BSONElement numCursorsElt = cmdObj["numCursors"];
+            uassert(17192, "numCursors must be a number", numCursorsElt.isNumber());
+            long long numCursors = numCursorsElt.numberLong();
+            uassert(17193, "numCursors must be between 1 and 10000",
+                    numCursors >= 1 && numCursors <= 10000);
+
+            NamespaceDetails* d = nsdetails(ns);
+            if ( !d ) {
+                errmsg = "ns does not exist";
+                return false;
+            }
+            if ( d->isCapped() ) {
+                errmsg = "can't scan a capped collection in parallel";
+                return false;
+            }
+
+            vector<DiskLoc> extents;
+            vector<long long> sizes;
+            long long total = 0;
+            for ( DiskLoc e = d->firstExtent(); !e.isNull(); e = e.ext()->xnext ) {
+                extents.push_back( e );
+                sizes.push_back( e.ext()->length );
+                total += sizes.back();
+            }
+            if ( numCursors > static_cast<long long>( extents.size() ) )
+                numCursors = extents.size();
+
+            BSONArrayBuilder cursors( result.subarrayStart( "cursors" ) );
+            size_t begin = 0;
+            long long covered = 0;
+            for ( long long i = 0; i < numCursors; i++ ) {
+                // give each cursor about as many bytes of extents, but at least one extent
+                const long long goal = total * ( i + 1 ) / numCursors;
+                const size_t maxEnd = extents.size() - ( numCursors - i );
+                size_t end = begin;
+                covered += sizes[end];
+                while ( end < maxEnd && covered < goal ) {
+                    covered += sizes[++end];
+                }
+
+                CollectionScanParams params;
+                params.ns = ns;
+                params.firstExtent = extents[begin];
+                // the last cursor also sees extents which are added meanwhile
+                if ( i + 1 < numCursors )
+                    params.lastExtent = extents[end];
+                WorkingSet* ws = new WorkingSet();
+                CollectionScan* scan = new CollectionScan( params, ws, NULL );
+                auto_ptr<Runner> runner( new InternalRunner( ns, scan, ws ) );
+                runner->setYieldPolicy( Runner::YIELD_AUTO );
+                // We won't use the runner until it's getMore'd.
+                runner->saveState();
+
+                // ClientCursor takes ownership of the runner and registers itself.
+                ClientCursor* cc = new ClientCursor( runner.release() );
+
+                BSONObjBuilder next( cursors.subobjStart() );
+                {
+                    BSONObjBuilder cursor( next.subobjStart( "cursor" ) );
+                    cursor.append( "id", cc->cursorid() );
+                    cursor.append( "ns", ns );
+                    cursor.appendArray( "firstBatch", BSONObj() );
+                    cursor.done();
+                }
+                next.append( "ok", true );
+                next.done();
+
+                begin = end + 1;
+            }
+            cursors.done();
+
+            return true;
+        }
+    } parallelCollectionScanCmd;
+
+}  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message_compression.h"
 
 namespace mongo {
 
@@ -88,6 +89,10 @@ namespace mongo {
                 result.append("replMonitorMaxFailedChecks",
                               ReplicaSetMonitor::getMaxFailedChecks());
             }
+            if( all || cmdObj.hasElement( "replMonitorMaxConcurrentChecks" ) ) {
+                result.append("replMonitorMaxConcurrentChecks",
+                              ReplicaSetMonitor::getMaxConcurrentChecks());
+            }
 
             const ServerParameter::Map& m = ServerParameterSet::getGlobal()->getMap();
             for ( ServerParameter::Map::const_iterator i = m.begin(); i != m.end(); ++i ) {
@@ -154,6 +159,12 @@ namespace mongo {
                         cmdObj["replMonitorMaxFailedChecks"].numberInt() );
                 s++;
             }
+            if( cmdObj.hasElement( "replMonitorMaxConcurrentChecks" ) ) {
+                if( s == 0 ) result.append( "was", ReplicaSetMonitor::getMaxConcurrentChecks() );
+                ReplicaSetMonitor::setMaxConcurrentChecks(
+                        cmdObj["replMonitorMaxConcurrentChecks"].numberInt() );
+                s++;
+            }
 
             const ServerParameter::Map& m = ServerParameterSet::getGlobal()->getMap();
             BSONObjIterator i( cmdObj );
@@ -231,6 +242,42 @@ namespace mongo {
             }
         } logLevelSetting;
 
+        class WireCompressionSetting : public ServerParameter {
+        public:
+            WireCompressionSetting() :
+                ServerParameter(ServerParameterSet::getGlobal(), "wireCompression") {
+                // servers compress traffic with peers that support it unless told otherwise
+                setWireCompressionEnabled(true);
+            }
+
+            virtual void append(BSONObjBuilder& b, const std::string& name) {
+                b << name << isWireCompressionEnabled();
+            }
+
+            virtual Status set(const BSONElement& newValueElement) {
+                bool newValue;
+                if (!newValueElement.coerce(&newValue))
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for wireCompression: " << newValueElement);
+                setWireCompressionEnabled(newValue);
+                return Status::OK();
+            }
+
+            virtual Status setFromString(const std::string& str) {
+                if (str == "true" || str == "1") {
+                    setWireCompressionEnabled(true);
+                }
+                else if (str == "false" || str == "0") {
+                    setWireCompressionEnabled(false);
+                }
+                else {
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for wireCompression: " << str);
+                }
+                return Status::OK();
+            }
+        } wireCompressionSetting;
+
         ExportedServerParameter<bool> QuietSetting( ServerParameterSet::getGlobal(),
                                                     "quiet",
                                                     &serverGlobalParams.quiet,
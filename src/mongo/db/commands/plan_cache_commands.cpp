@@ -0,0 +1,295 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_cache.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Builds a CanonicalQuery of the shape described by the 'query', 'sort' and 'projection'
+     * fields of a planCache command.  Only 'query' is required.  Caller owns '*out'.
+     */
+    Status canonicalizeShape(const std::string& ns, const BSONObj& cmdObj, CanonicalQuery** out) {
+        BSONElement queryElt = cmdObj["query"];
+        if (Object != queryElt.type()) {
+            return Status(ErrorCodes::BadValue, "required field query must be an object");
+        }
+
+        BSONObj sort;
+        BSONElement sortElt = cmdObj["sort"];
+        if (!sortElt.eoo()) {
+            if (Object != sortElt.type()) {
+                return Status(ErrorCodes::BadValue, "optional field sort must be an object");
+            }
+            sort = sortElt.embeddedObject();
+        }
+
+        BSONObj projection;
+        BSONElement projElt = cmdObj["projection"];
+        if (!projElt.eoo()) {
+            if (Object != projElt.type()) {
+                return Status(ErrorCodes::BadValue,
+                              "optional field projection must be an object");
+            }
+            projection = projElt.embeddedObject();
+        }
+
+        return CanonicalQuery::canonicalize(ns, queryElt.embeddedObject(), sort, projection, out);
+    }
+
+}  // namespace
+
+namespace mongo {
+
+    /**
+     * Base class for the commands that inspect and manipulate a collection's PlanCache.  The
+     * first field of the command names the collection.
+     *
+     * The cache does its own locking, so a read lock on the database is enough for all of them,
+     * and none of them are replicated: each member of a replica set plans its own queries.
+     */
+    class PlanCacheCommand : public Command {
+    public:
+        PlanCacheCommand(const char* name, const char* helpText, ActionType actionType)
+            : Command(name), _helpText(helpText), _actionType(actionType) { }
+
+        virtual LockType locktype() const { return READ; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool logTheOp() { return false; }
+
+        virtual void help(stringstream& help) const {
+            help << _helpText;
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(_actionType);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        virtual bool run(const string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            if (String != cmdObj.firstElement().type()) {
+                appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                                                   "first field must be a collection name"));
+                return false;
+            }
+
+            string ns = parseNs(dbname, cmdObj);
+            PlanCache& cache = NamespaceDetailsTransient::get(ns.c_str()).getPlanCache();
+            Status status = runOnCache(ns, cmdObj, &cache, &result);
+            if (!status.isOK()) {
+                appendCommandStatus(result, status);
+                return false;
+            }
+            return true;
+        }
+
+    protected:
+        /**
+         * Does the work of the command against the PlanCache of 'ns'.
+         */
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) = 0;
+
+    private:
+        const char* _helpText;
+        ActionType _actionType;
+    };
+
+    /**
+     * { planCacheListShapes: <collection> }
+     */
+    class PlanCacheListShapes : public PlanCacheCommand {
+    public:
+        PlanCacheListShapes()
+            : PlanCacheCommand("planCacheListShapes",
+                               "Lists an example of every query shape in the plan cache.\n"
+                               "{ planCacheListShapes: <collection> }",
+                               ActionType::planCacheRead) { }
+
+    protected:
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) {
+            BSONArrayBuilder shapesBab(result->subarrayStart("shapes"));
+            cache->appendShapes(&shapesBab);
+            shapesBab.doneFast();
+            return Status::OK();
+        }
+    };
+
+    /**
+     * { planCacheListPlans: <collection>, query: <query>, [sort: <sort>],
+     *   [projection: <projection>] }
+     */
+    class PlanCacheListPlans : public PlanCacheCommand {
+    public:
+        PlanCacheListPlans()
+            : PlanCacheCommand("planCacheListPlans",
+                               "Shows the cached plan for a query shape, why it was picked and how "
+                               "it performed since.\n"
+                               "{ planCacheListPlans: <collection>, query: <query>, "
+                               "[sort: <sort>], [projection: <projection>] }",
+                               ActionType::planCacheRead) { }
+
+    protected:
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) {
+            CanonicalQuery* rawQuery;
+            Status status = canonicalizeShape(ns, cmdObj, &rawQuery);
+            if (!status.isOK()) { return status; }
+            scoped_ptr<CanonicalQuery> query(rawQuery);
+
+            if (!cache->appendShapeDetails(*query, result)) {
+                return Status(ErrorCodes::BadValue, "query shape not found in the plan cache");
+            }
+            return Status::OK();
+        }
+    };
+
+    /**
+     * { planCacheClear: <collection>, [query: <query>, [sort: <sort>],
+     *   [projection: <projection>]] }
+     */
+    class PlanCacheClear : public PlanCacheCommand {
+    public:
+        PlanCacheClear()
+            : PlanCacheCommand("planCacheClear",
+                               "Drops one query shape, or all of them, from the plan cache.  "
+                               "Pinned indices are not affected.\n"
+                               "{ planCacheClear: <collection>, [query: <query>, "
+                               "[sort: <sort>], [projection: <projection>]] }",
+                               ActionType::planCacheWrite) { }
+
+    protected:
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) {
+            if (!cmdObj.hasField("query")) {
+                cache->clear();
+                return Status::OK();
+            }
+
+            CanonicalQuery* rawQuery;
+            Status status = canonicalizeShape(ns, cmdObj, &rawQuery);
+            if (!status.isOK()) { return status; }
+            scoped_ptr<CanonicalQuery> query(rawQuery);
+
+            if (!cache->remove(*query)) {
+                return Status(ErrorCodes::BadValue, "query shape not found in the plan cache");
+            }
+            return Status::OK();
+        }
+    };
+
+    /**
+     * { planCachePin: <collection>, query: <query>, [sort: <sort>], [projection: <projection>],
+     *   index: <key pattern> }
+     */
+    class PlanCachePin : public PlanCacheCommand {
+    public:
+        PlanCachePin()
+            : PlanCacheCommand("planCachePin",
+                               "Forces queries of a shape to use an index, as if hinted.  "
+                               "Use index: {$natural: 1} to force a collection scan.\n"
+                               "{ planCachePin: <collection>, query: <query>, [sort: <sort>], "
+                               "[projection: <projection>], index: <key pattern> }",
+                               ActionType::planCacheWrite) { }
+
+    protected:
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) {
+            BSONElement indexElt = cmdObj["index"];
+            if (Object != indexElt.type() || indexElt.embeddedObject().isEmpty()) {
+                return Status(ErrorCodes::BadValue,
+                              "required field index must be a non-empty key pattern");
+            }
+
+            CanonicalQuery* rawQuery;
+            Status status = canonicalizeShape(ns, cmdObj, &rawQuery);
+            if (!status.isOK()) { return status; }
+            scoped_ptr<CanonicalQuery> query(rawQuery);
+
+            cache->pin(*query, indexElt.embeddedObject());
+            return Status::OK();
+        }
+    };
+
+    /**
+     * { planCacheUnpin: <collection>, query: <query>, [sort: <sort>],
+     *   [projection: <projection>] }
+     */
+    class PlanCacheUnpin : public PlanCacheCommand {
+    public:
+        PlanCacheUnpin()
+            : PlanCacheCommand("planCacheUnpin",
+                               "Removes the index pinned for a query shape.\n"
+                               "{ planCacheUnpin: <collection>, query: <query>, "
+                               "[sort: <sort>], [projection: <projection>] }",
+                               ActionType::planCacheWrite) { }
+
+    protected:
+        virtual Status runOnCache(const std::string& ns, const BSONObj& cmdObj, PlanCache* cache,
+                                  BSONObjBuilder* result) {
+            CanonicalQuery* rawQuery;
+            Status status = canonicalizeShape(ns, cmdObj, &rawQuery);
+            if (!status.isOK()) { return status; }
+            scoped_ptr<CanonicalQuery> query(rawQuery);
+
+            if (!cache->unpin(*query)) {
+                return Status(ErrorCodes::BadValue, "query shape is not pinned");
+            }
+            return Status::OK();
+        }
+    };
+
+    static PlanCacheListShapes planCacheListShapes;
+    static PlanCacheListPlans planCacheListPlans;
+    static PlanCacheClear planCacheClear;
+    static PlanCachePin planCachePin;
+    static PlanCacheUnpin planCacheUnpin;
+
+}  // namespace mongo
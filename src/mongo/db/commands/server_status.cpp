@@ -53,6 +53,9 @@ namespace mongo {
             void add( ServerStatusMetric* metric );
             
             void appendTo( BSONObjBuilder& b ) const;
+
+            /** Appends only the top level metrics and subtrees named in "only". */
+            void appendTo( BSONObjBuilder& b, const set<string>& only ) const;
             
             static MetricTree* theMetricTree;
         private:
@@ -79,7 +82,9 @@ namespace mongo {
         virtual bool slaveOk() const { return true; }
 
         virtual void help( stringstream& help ) const {
-            help << "returns lots of administrative server statistics";
+            help << "returns lots of administrative server statistics\n"
+                    "{ serverStatus : 1, sections : [ <name>, ... ] } computes only the listed "
+                    "sections and top level metrics (e.g. \"mem\"), for frequent polling";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
@@ -111,6 +116,16 @@ namespace mongo {
 
             timeBuilder.appendNumber( "after basic" , Listener::getElapsedTimeMillis() - start );
             
+            // With a "sections" array only what it names is computed; some sections, such as
+            // "locks", cost time proportional to the number of databases or namespaces.
+            const bool exclusive = cmdObj["sections"].type() == Array;
+            set<string> only;
+            if ( exclusive ) {
+                BSONForEach( e, cmdObj["sections"].Obj() ) {
+                    only.insert( e.str() );
+                }
+            }
+
             // --- all sections
             
             for ( SectionMap::const_iterator i = _sections->begin(); i != _sections->end(); ++i ) {
@@ -124,7 +139,10 @@ namespace mongo {
                 bool include = section->includeByDefault();
                 
                 BSONElement e = cmdObj[section->getSectionName()];
-                if ( e.type() ) {
+                if ( exclusive ) {
+                    include = only.count( section->getSectionName() ) > 0;
+                }
+                else if ( e.type() ) {
                     include = e.trueValue();
                 }
                 
@@ -145,13 +163,16 @@ namespace mongo {
             if ( cmdObj["metrics"].type() && !cmdObj["metrics"].trueValue() )
                 includeMetricTree = false;
 
-            if ( includeMetricTree ) {
+            if ( includeMetricTree && exclusive ) {
+                MetricTree::theMetricTree->appendTo( result, only );
+            }
+            else if ( includeMetricTree ) {
                 MetricTree::theMetricTree->appendTo( result );
             }
 
             // --- some hard coded global things hard to pull out
 
-            {
+            if ( !exclusive || only.count( "warnings" ) ) {
                 RamLog::LineIterator rl(RamLog::get("warnings"));
                 if (rl.lastWrite() >= time(0)-(10*60)){  // only show warnings from last 10 minutes
                     BSONArrayBuilder arr(result.subarrayStart("warnings"));
@@ -245,6 +266,21 @@ namespace mongo {
         }
     }
 
+    void MetricTree::appendTo( BSONObjBuilder& b, const set<string>& only ) const {
+        for ( map<string,ServerStatusMetric*>::const_iterator i = _metrics.begin(); i != _metrics.end(); ++i ) {
+            if ( only.count( i->first ) )
+                i->second->appendAtLeaf( b );
+        }
+
+        for ( map<string,MetricTree*>::const_iterator i = _subtrees.begin(); i != _subtrees.end(); ++i ) {
+            if ( ! only.count( i->first ) )
+                continue;
+            BSONObjBuilder bb( b.subobjStart( i->first ) );
+            i->second->appendTo( bb );
+            bb.done();
+        }
+    }
+
     ServerStatusMetric::ServerStatusMetric(const string& nameIn)
         : _name( nameIn ),
           _leafName( _parseLeafName( nameIn ) ) {
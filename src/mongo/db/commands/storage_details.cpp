@@ -41,7 +41,8 @@ namespace {
      */
     enum SubCommand {
         SUBCMD_DISK_STORAGE,
-        SUBCMD_PAGES_IN_RAM
+        SUBCMD_PAGES_IN_RAM,
+        SUBCMD_FREE_LISTS
     };
 
     /**
@@ -295,7 +296,10 @@ namespace {
               << "Provides detailed and aggregate information regarding record and deleted record "
               << "layout in storage files ({analyze: 'diskStorage'}) and percentage of pages "
               << "currently in RAM ({analyze: 'pagesInRAM'}). Slow if run on large collections. "
-              << "Select the desired subcommand with {analyze: 'diskStorage' | 'pagesInRAM'}; "
+              << "{analyze: 'freeLists'} summarizes the collection's deleted record lists, to "
+              << "tell how fragmented it is and whether it is worth compacting. "
+              << "Select the desired subcommand with "
+              << "{analyze: 'diskStorage' | 'pagesInRAM' | 'freeLists'}; "
               << "specify {extent: num_} and, optionally, {range: [start, end]} to restrict "
               << "processing to a single extent (start and end are offsets from the beginning of "
               << "the extent. {granularity: bytes} or {numberOfSlices: num_} enable aggregation of "
@@ -671,6 +675,72 @@ namespace {
         return true;
     }
 
+    /**
+     * Summarizes the deleted lists of the entire collection.  Free space is only worth compacting
+     * away when it is not going to be reused: free records smaller than the collection's average
+     * record cannot hold a typical new or moved document.
+     *
+     * The output has the form:
+     *     { storageBytes: <bytes in the collection's extents>,
+     *       dataBytes: <bytes in records, without headers>,
+     *       freeRecords: <number of deleted records>,
+     *       freeBytes: <bytes in deleted records>,
+     *       unusableFreeBytes: <bytes in deleted records smaller than the average record>,
+     *       freeRatio: freeBytes / storageBytes,
+     *       compactionRecommended: <whether unusable free space is over a quarter of storage>,
+     *       buckets: [ { maxBytes: <size bound of the bucket>,
+     *                    freeRecords: <number of deleted records in the bucket>,
+     *                    freeBytes: <bytes in them> }, ... (one element per bucket) ] }
+     *
+     * @return true on success, false on failure (partial output may still be present)
+     */
+    bool analyzeFreeLists(const NamespaceDetails* nsd, string& errmsg, BSONObjBuilder& result) {
+        if (nsd->isCapped()) {
+            errmsg = "capped collections do not keep free lists by size";
+            return false;
+        }
+
+        const long long storageBytes = nsd->storageSize(NULL, NULL);
+        const long long avgRecBytes = nsd->numRecords() == 0 ? 0 :
+                nsd->dataSize() / nsd->numRecords() + Record::HeaderSize;
+
+        long long freeRecords = 0;
+        long long freeBytes = 0;
+        long long unusableFreeBytes = 0;
+        BSONArrayBuilder bucketsArrayBuilder(result.subarrayStart("buckets"));
+        for (int bucketNum = 0; bucketNum < mongo::Buckets; bucketNum++) {
+            long long bucketRecords = 0;
+            long long bucketBytes = 0;
+            for (DiskLoc dl = nsd->deletedListEntry(bucketNum); !dl.isNull(); ) {
+                killCurrentOp.checkForInterrupt();
+                DeletedRecord* dr = dl.drec();
+                bucketRecords++;
+                bucketBytes += dr->lengthWithHeaders();
+                if (dr->lengthWithHeaders() < avgRecBytes) {
+                    unusableFreeBytes += dr->lengthWithHeaders();
+                }
+                dl = dr->nextDeleted();
+            }
+            BSONObjBuilder(bucketsArrayBuilder.subobjStart())
+                .append("maxBytes", bucketSizes[bucketNum])
+                .append("freeRecords", bucketRecords)
+                .append("freeBytes", bucketBytes);
+            freeRecords += bucketRecords;
+            freeBytes += bucketBytes;
+        }
+        bucketsArrayBuilder.doneFast();
+
+        result.append("storageBytes", storageBytes);
+        result.append("dataBytes", nsd->dataSize());
+        result.append("freeRecords", freeRecords);
+        result.append("freeBytes", freeBytes);
+        result.append("unusableFreeBytes", unusableFreeBytes);
+        result.append("freeRatio", storageBytes == 0 ? 0.0 :
+                                   static_cast<double>(freeBytes) / storageBytes);
+        result.append("compactionRecommended", unusableFreeBytes * 4 > storageBytes);
+        return true;
+    }
+
     /**
      * Analyze a single extent.
      * @param params analysis parameters, will be updated with computed number of slices or
@@ -700,6 +770,8 @@ namespace {
                 return analyzeDiskStorage(nsd, ex, params, errmsg, outputBuilder);
             case SUBCMD_PAGES_IN_RAM:
                 return analyzePagesInRAM(ex, params, errmsg, outputBuilder);
+            case SUBCMD_FREE_LISTS:
+                break; // not per extent, see run()
         }
         verify(false && "unreachable");
     }
@@ -751,7 +823,8 @@ namespace {
         return true;
     }
 
-    static const char* USE_ANALYZE_STR = "use {analyze: 'diskStorage' | 'pagesInRAM'}";
+    static const char* USE_ANALYZE_STR =
+        "use {analyze: 'diskStorage' | 'pagesInRAM' | 'freeLists'}";
 
     bool StorageDetailsCmd::run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
                                 BSONObjBuilder& result, bool fromRepl) {
@@ -771,6 +844,9 @@ namespace {
         else if (str::equals(subCommandStr, "pagesInRAM")) {
             subCommand = SUBCMD_PAGES_IN_RAM;
         }
+        else if (str::equals(subCommandStr, "freeLists")) {
+            subCommand = SUBCMD_FREE_LISTS;
+        }
         else {
             errmsg = str::stream() << subCommandStr << " is not a valid subcommand, "
                                                     << USE_ANALYZE_STR;
@@ -787,6 +863,16 @@ namespace {
             return false;
         }
 
+        if (subCommand == SUBCMD_FREE_LISTS) {
+            // the free lists are per collection: none of the options below apply
+            BSONObjBuilder outputBuilder;
+            if (!analyzeFreeLists(nsd, errmsg, outputBuilder)) {
+                return false;
+            }
+            result.appendElements(outputBuilder.obj());
+            return true;
+        }
+
         const Extent* extent = NULL;
 
         // { extent: num }
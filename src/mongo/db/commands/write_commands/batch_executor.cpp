@@ -43,6 +43,14 @@ namespace mongo {
 
     using std::auto_ptr;
 
+    namespace {
+
+        // How long executeBatch() applies consecutive items under one write lock before
+        // releasing it to let other operations run.
+        const long long writeLockMicros = 10 * 1000;
+
+    } // namespace
+
     WriteBatchExecutor::WriteBatchExecutor( Client* client, OpCounters* opCounters, LastError* le ) :
             _client( client ), _opCounters( opCounters ), _le( le ) {
     }
@@ -56,19 +64,37 @@ namespace mongo {
         auto_ptr<BatchedErrorDetail> error( new BatchedErrorDetail );
         bool batchSuccess = true;
 
-        // Apply batch ops
+        // Apply batch ops.  Consecutive items share one write lock, which is given up once it has
+        // been held for writeLockMicros so that other operations can get in.  A page fault gives
+        // up the lock early; the page is touched unlocked and the faulting item is retried.
         size_t numBatchOps = request.sizeWriteOps();
-        for ( size_t i = 0; i < numBatchOps; i++ ) {
-            if ( !applyWriteItem( request, i, &stats, error.get() ) ) {
-
-                // Batch item failed
-                error->setIndex( static_cast<int>( i ) );
-                response->addToErrDetails( error.release() );
-                batchSuccess = false;
-
-                if ( !request.getContinueOnError() ) break;
-
-                error.reset( new BatchedErrorDetail );
+        size_t i = 0;
+        bool stopped = false;
+        PageFaultRetryableSection s;
+        while ( i < numBatchOps && !stopped ) {
+            try {
+                Client::WriteContext ctx( request.getNS() );
+                Timer lockTimer;
+                while ( i < numBatchOps && lockTimer.micros() < writeLockMicros ) {
+                    if ( !applyWriteItem( request, i, &stats, error.get() ) ) {
+
+                        // Batch item failed
+                        error->setIndex( static_cast<int>( i ) );
+                        response->addToErrDetails( error.release() );
+                        batchSuccess = false;
+
+                        if ( !request.getContinueOnError() ) {
+                            stopped = true;
+                            break;
+                        }
+
+                        error.reset( new BatchedErrorDetail );
+                    }
+                    i++;
+                }
+            }
+            catch ( PageFaultException& e ) {
+                e.touch();
             }
         }
 
@@ -142,78 +168,67 @@ namespace mongo {
         //uint64_t itemTimeMicros = 0;
         bool opSuccess = true;
 
-        // Each write operation executes in its own PageFaultRetryableSection.  This means that
-        // a single batch can throw multiple PageFaultException's, which is not the case for
-        // other operations.
-        PageFaultRetryableSection s;
-        while ( true ) {
-            try {
-                // Execute the write item as a child operation of the current operation.
-                CurOp childOp( _client, _client->curop() );
-
-                // TODO Modify CurOp "wrapped" constructor to take an opcode, so calling .reset()
-                // is unneeded
-                childOp.reset( _client->getRemote(), getOpCode( request.getBatchType() ) );
-
-                childOp.ensureStarted();
-                OpDebug& opDebug = childOp.debug();
-                opDebug.ns = ns;
-                {
-                    Client::WriteContext ctx( ns );
-
-                    switch ( request.getBatchType() ) {
-                    case BatchedCommandRequest::BatchType_Insert:
-                        opSuccess =
-                                applyInsert( ns,
-                                             request.getInsertRequest()->getDocumentsAt( index ),
-                                             &childOp,
-                                             stats,
-                                             error );
-                        break;
-                    case BatchedCommandRequest::BatchType_Update:
-                        opSuccess = applyUpdate( ns,
-                                                 *request.getUpdateRequest()->getUpdatesAt( index ),
-                                                 &childOp,
-                                                 stats,
-                                                 error );
-                        break;
-                    default:
-                        dassert( request.getBatchType() ==
-                                BatchedCommandRequest::BatchType_Delete );
-                        opSuccess = applyDelete( ns,
-                                                 *request.getDeleteRequest()->getDeletesAt( index ),
-                                                 &childOp,
-                                                 stats,
-                                                 error );
-                        break;
-                    }
-                }
-                childOp.done();
-                //itemTimeMicros = childOp.totalTimeMicros();
+        // The caller holds the write lock and the PageFaultRetryableSection; a
+        // PageFaultException thrown here unwinds to executeBatch(), which retries this item.
+
+        // Execute the write item as a child operation of the current operation.
+        CurOp childOp( _client, _client->curop() );
+
+        // TODO Modify CurOp "wrapped" constructor to take an opcode, so calling .reset()
+        // is unneeded
+        childOp.reset( _client->getRemote(), getOpCode( request.getBatchType() ) );
+
+        childOp.ensureStarted();
+        OpDebug& opDebug = childOp.debug();
+        opDebug.ns = ns;
+
+        switch ( request.getBatchType() ) {
+        case BatchedCommandRequest::BatchType_Insert:
+            opSuccess =
+                    applyInsert( ns,
+                                 request.getInsertRequest()->getDocumentsAt( index ),
+                                 &childOp,
+                                 stats,
+                                 error );
+            break;
+        case BatchedCommandRequest::BatchType_Update:
+            opSuccess = applyUpdate( ns,
+                                     *request.getUpdateRequest()->getUpdatesAt( index ),
+                                     &childOp,
+                                     stats,
+                                     error );
+            break;
+        default:
+            dassert( request.getBatchType() ==
+                    BatchedCommandRequest::BatchType_Delete );
+            opSuccess = applyDelete( ns,
+                                     *request.getDeleteRequest()->getDeletesAt( index ),
+                                     &childOp,
+                                     stats,
+                                     error );
+            break;
+        }
 
-                opDebug.executionTime = childOp.totalTimeMillis();
-                opDebug.recordStats();
+        childOp.done();
+        //itemTimeMicros = childOp.totalTimeMicros();
 
-                // Log operation if running with at least "-v", or if exceeds slow threshold.
-                if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))
-                     || opDebug.executionTime >
-                        serverGlobalParams.slowMS + childOp.getExpectedLatencyMs()) {
+        opDebug.executionTime = childOp.totalTimeMillis();
+        opDebug.recordStats();
 
-                    MONGO_TLOG(1) << opDebug.report( childOp ) << endl;
-                }
+        // Log operation if running with at least "-v", or if exceeds slow threshold.
+        if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))
+             || opDebug.executionTime >
+                serverGlobalParams.slowMS + childOp.getExpectedLatencyMs()) {
 
-                // TODO Log operation if logLevel >= 3 and assertion thrown (as assembleResponse()
-                // does).
+            MONGO_TLOG(1) << opDebug.report( childOp ) << endl;
+        }
 
-                // Save operation to system.profile if shouldDBProfile().
-                if ( childOp.shouldDBProfile( opDebug.executionTime ) ) {
-                    profile( *_client, getOpCode( request.getBatchType() ), childOp );
-                }
-                break;
-            }
-            catch ( PageFaultException& e ) {
-                e.touch();
-            }
+        // TODO Log operation if logLevel >= 3 and assertion thrown (as assembleResponse()
+        // does).
+
+        // Save operation to system.profile if shouldDBProfile().
+        if ( childOp.shouldDBProfile( opDebug.executionTime ) ) {
+            profile( *_client, getOpCode( request.getBatchType() ), childOp );
         }
 
         return opSuccess;
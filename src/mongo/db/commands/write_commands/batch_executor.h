@@ -78,6 +78,9 @@ namespace mongo {
          * Issues a single write.  Fills "results" with write result.
          * Returns true iff write item was issued sucessfully and increments stats, populates error
          * if not successful.
+         *
+         * Must be called with the write lock for the batch namespace held.  May throw
+         * PageFaultException, in which case the item should be retried after touching the page.
          */
         bool applyWriteItem( const BatchedCommandRequest& request,
                              int index,
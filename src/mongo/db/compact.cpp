@@ -48,6 +48,7 @@
 #include "mongo/db/index_update.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/pagefault.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/timer.h"
@@ -165,6 +166,7 @@ namespace mongo {
             newFirst.ext()->xprev.writing().Null();
             getDur().writing(e)->markEmpty();
             cc().database()->getExtentManager().freeExtents( diskloc, diskloc );
+            NamespaceDetailsTransient::extentsFreed( ns );
 
             // update datasize/record count for this namespace's extent
             d->incrementStats( datasize, nrecords );
@@ -282,6 +284,374 @@ namespace mongo {
         return true;
     }
 
+    namespace {
+
+        // records surveyed per read lock when measuring extents' fill, finishing the extent
+        const long long surveyRecordsPerLock = 10000;
+
+        // deleted records looked at per write lock when taking an extent off the deleted lists
+        const int deletedRecordsPerLock = 1000;
+
+        /** one extent's share of live records, for picking the sparsest to drain */
+        struct ExtentFill {
+            DiskLoc loc;
+            double fill;
+            bool operator<( const ExtentFill& rhs ) const { return fill < rhs.fill; }
+        };
+
+        double extentFill( const Extent* e, long long* recordsSeen ) {
+            ExtentManager& em = cc().database()->getExtentManager();
+            long long recBytes = 0;
+            for ( DiskLoc L = e->firstRecord; !L.isNull(); L = em.getNextRecordInExtent( L ) ) {
+                recBytes += L.rec()->lengthWithHeaders();
+                ++*recordsSeen;
+            }
+            return static_cast<double>( recBytes ) / e->length;
+        }
+
+        bool hasExtent( const NamespaceDetails* d, const DiskLoc& extLoc ) {
+            for ( DiskLoc L = d->firstExtent(); !L.isNull(); L = L.ext()->xnext ) {
+                if ( L == extLoc )
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+         * Fills *candidates with the extents of ns that are at most maxFill full.  The read lock
+         * is released every surveyRecordsPerLock records, between extents.
+         */
+        void surveyExtents( const char* ns, double maxFill, vector<ExtentFill>* candidates,
+                            int* nExtents ) {
+            DiskLoc next;
+            for ( bool first = true; first || !next.isNull(); first = false ) {
+                Client::ReadContext ctx( ns );
+                NamespaceDetails* d = nsdetails( ns );
+                if ( first ) {
+                    uassert( 17195, str::stream() << "namespace " << ns << " does not exist", d );
+                    next = d->firstExtent();
+                }
+                else if ( !d || !hasExtent( d, next ) ) {
+                    // changed while unlocked; drain what was surveyed
+                    return;
+                }
+
+                long long recordsSeen = 0;
+                while ( !next.isNull() && recordsSeen < surveyRecordsPerLock ) {
+                    ExtentFill f;
+                    f.loc = next;
+                    f.fill = extentFill( next.ext(), &recordsSeen );
+                    if ( f.fill <= maxFill )
+                        candidates->push_back( f );
+                    ++*nExtents;
+                    next = next.ext()->xnext;
+                }
+                killCurrentOp.checkForInterrupt();
+            }
+        }
+
+        /** unlinks the empty extent at extLoc from d's extents and frees it to the database */
+        void freeEmptyExtent( const char* ns, NamespaceDetails* d, const DiskLoc& extLoc ) {
+            Extent* e = getDur().writing( extLoc.ext() );
+            verify( e->firstRecord.isNull() );
+            if ( e->xprev.isNull() )
+                d->firstExtent().writing() = e->xnext;
+            else
+                e->xprev.ext()->xnext.writing() = e->xnext;
+            if ( e->xnext.isNull() )
+                d->lastExtent().writing() = e->xprev;
+            else
+                e->xnext.ext()->xprev.writing() = e->xprev;
+            e->xprev.Null();
+            e->xnext.Null();
+            e->markEmpty();
+            cc().database()->getExtentManager().freeExtents( extLoc, extLoc );
+            NamespaceDetailsTransient::extentsFreed( ns );
+        }
+
+        struct IncrementalCompactStats {
+            IncrementalCompactStats() : extentsFreed( 0 ), recordsMoved( 0 ), bytesFreed( 0 ) {}
+            int extentsFreed;
+            long long recordsMoved;
+            long long bytesFreed;
+        };
+
+        /**
+         * Moves the records out of one extent and frees it, a few records per write lock.
+         *
+         * Neither the extent's free space nor the space its records leave may be on the deleted
+         * lists while it drains, or moved records land in it again, and none may be left on them
+         * once it is freed.  Rather than search the lists under one lock, all of them are
+         * detached at once and then walked a bounded number of records per lock, putting back
+         * all but the extent's records.  While detached the lists can't hand out any of the
+         * extent's space, so an empty extent stays empty until it is freed.
+         *
+         * The free space held off the lists goes back on them if the drain is interrupted or
+         * gives up.
+         */
+        class ExtentDrainer {
+        public:
+            ExtentDrainer( const char* ns, const DiskLoc& extLoc, int batchSize,
+                           IncrementalCompactStats* stats )
+                : _ns( ns ), _extLoc( extLoc ), _batchSize( batchSize ), _stats( stats ),
+                  _details( NULL ), _drained( false ), _detaching( false ), _bucket( Buckets ) {
+            }
+
+            /** drains and frees the extent, or gives up if the collection changes under it */
+            void run() {
+                while ( true ) {
+                    // Take the extent's free space off the lists.  Once it is drained this also
+                    // takes off what was deleted from it meanwhile, and frees it.
+                    if ( !step( &ExtentDrainer::detachLists ) )
+                        return;
+                    while ( _bucket < Buckets ) {
+                        killCurrentOp.checkForInterrupt();
+                        if ( !step( &ExtentDrainer::scrubLists ) )
+                            return;
+                    }
+
+                    // move the records
+                    while ( true ) {
+                        killCurrentOp.checkForInterrupt();
+                        prefetchBatch();
+                        bool more;
+                        {
+                            PageFaultRetryableSection pfrs;
+                            while ( 1 ) {
+                                try {
+                                    if ( !step( &ExtentDrainer::moveRecords ) )
+                                        return;
+                                    more = !_drained;
+                                    break;
+                                }
+                                catch ( PageFaultException& e ) {
+                                    e.touch();
+                                }
+                            }
+                        }
+                        if ( !more )
+                            break;
+                    }
+                }
+            }
+
+            /**
+             * Puts the free space still held off the deleted lists back on them, after run()
+             * threw or gave up on the extent.
+             */
+            void putBack() {
+                if ( _bucket == Buckets && _orphaned.empty() )
+                    return;
+                Client::WriteContext ctx( _ns );
+                NamespaceDetails* d = lockedDetails();
+                if ( !d )
+                    return; // the space went away with the collection
+                for ( ; _bucket < Buckets; _bucket++ ) {
+                    while ( !_cur.isNull() ) {
+                        DeletedRecord* r = _cur.drec();
+                        DiskLoc next = r->nextDeleted();
+                        d->addDeletedRec( r, _cur );
+                        _cur = next;
+                    }
+                    if ( _bucket + 1 < Buckets )
+                        _cur = _detached[_bucket + 1];
+                }
+                for ( size_t i = 0; i < _orphaned.size(); i++ ) {
+                    d->addDeletedRec( _orphaned[i].drec(), _orphaned[i] );
+                }
+                _orphaned.clear();
+            }
+
+        private:
+            typedef bool (ExtentDrainer::*Step)( NamespaceDetails* d );
+
+            /** runs one step under the write lock; false once the extent is gone */
+            bool step( Step s ) {
+                Client::WriteContext ctx( _ns );
+                BackgroundOperation::assertNoBgOpInProgForNs( _ns );
+                NamespaceDetails* d = lockedDetails();
+                if ( !d )
+                    return false;
+                return (this->*s)( d );
+            }
+
+            /** the collection's details if it is still the one holding our extent */
+            NamespaceDetails* lockedDetails() {
+                NamespaceDetails* d = nsdetails( _ns );
+                if ( !d || d->isCapped() || ( _details && d != _details ) )
+                    return NULL;
+                // it may have been dropped, recreated or compacted while unlocked
+                if ( !hasExtent( d, _extLoc ) )
+                    return NULL;
+                _details = d;
+                return d;
+            }
+
+            /**
+             * Reads the next batch's records in under a read lock, so that the write lock isn't
+             * held while they come from disk.
+             */
+            void prefetchBatch() {
+                Client::ReadContext ctx( _ns );
+                NamespaceDetails* d = nsdetails( _ns );
+                if ( !d || d != _details || !hasExtent( d, _extLoc ) )
+                    return;
+                ExtentManager& em = cc().database()->getExtentManager();
+                int n = 0;
+                for ( DiskLoc L = _extLoc.ext()->firstRecord; !L.isNull() && n < _batchSize;
+                      L = em.getNextRecordInExtent( L ), n++ ) {
+                    L.rec()->touch( true );
+                }
+            }
+
+            bool detachLists( NamespaceDetails* d ) {
+                if ( d->firstExtent() == d->lastExtent() )
+                    return false;
+                // once drained, nothing may be allocated in the extent until it is freed
+                _detaching = _extLoc.ext()->firstRecord.isNull();
+                for ( int b = 0; b < Buckets; b++ ) {
+                    _detached[b] = d->deletedListEntry( b );
+                    if ( !_detached[b].isNull() )
+                        getDur().writingDiskLoc( d->deletedListEntry( b ) ).Null();
+                }
+                _bucket = 0;
+                _cur = _detached[0];
+                return true;
+            }
+
+            bool scrubLists( NamespaceDetails* d ) {
+                for ( int n = 0; _bucket < Buckets && n < deletedRecordsPerLock; ) {
+                    if ( _cur.isNull() ) {
+                        if ( ++_bucket < Buckets )
+                            _cur = _detached[_bucket];
+                        continue;
+                    }
+                    DeletedRecord* r = _cur.drec();
+                    DiskLoc next = r->nextDeleted();
+                    if ( _cur.a() == _extLoc.a() && r->extentOfs() == _extLoc.getOfs() )
+                        _orphaned.push_back( _cur );
+                    else
+                        d->addDeletedRec( r, _cur );
+                    _cur = next;
+                    n++;
+                }
+                if ( _bucket < Buckets || !_detaching )
+                    return true;
+
+                verify( _extLoc.ext()->firstRecord.isNull() );
+                _stats->bytesFreed += _extLoc.ext()->length;
+                _stats->extentsFreed++;
+                freeEmptyExtent( _ns, d, _extLoc );
+                _orphaned.clear(); // freed with the extent
+                return false;
+            }
+
+            /**
+             * Moves up to a batch of records the way an update that outgrows its record moves
+             * them: deleted, which also takes them out of the indexes and moves cursors past
+             * them, then inserted again.  The space they leave is kept off the deleted lists.
+             */
+            bool moveRecords( NamespaceDetails* d ) {
+                if ( d->firstExtent() == d->lastExtent() )
+                    return false;
+
+                // prefetchBatch() read the batch in, but it may have been paged out or changed
+                // since.  A PageFaultException can only be thrown before this lock's first
+                // write, and not once the command has written or run for a while, so check the
+                // whole batch here.
+                ExtentManager& em = cc().database()->getExtentManager();
+                Client& client = cc();
+                Extent* e = _extLoc.ext();
+                int n = 0;
+                for ( DiskLoc L = e->firstRecord; !L.isNull() && n < _batchSize;
+                      L = em.getNextRecordInExtent( L ), n++ ) {
+                    Record* r = L.rec()->accessed();
+                    if ( client.allowedToThrowPageFaultException() &&
+                         !r->likelyInPhysicalMemory() ) {
+                        throw PageFaultException( r );
+                    }
+                }
+
+                for ( int i = 0; i < _batchSize && !e->firstRecord.isNull(); i++ ) {
+                    DiskLoc L = e->firstRecord;
+                    Record* r = L.rec();
+                    BSONObj obj = BSONObj::make( r ).getOwned();
+
+                    theDataFileMgr.deleteRecord( d, _ns, r, L, false, true );
+                    int b = NamespaceDetails::bucket( r->lengthWithHeaders() );
+                    if ( d->deletedListEntry( b ) == L ) {
+                        getDur().writingDiskLoc( d->deletedListEntry( b ) ) =
+                            L.drec()->nextDeleted();
+                        _orphaned.push_back( L );
+                    }
+
+                    theDataFileMgr.insert( _ns, obj.objdata(), obj.objsize() );
+                    _stats->recordsMoved++;
+                }
+                _drained = e->firstRecord.isNull();
+                return true;
+            }
+
+            const char* _ns;
+            const DiskLoc _extLoc;
+            const int _batchSize;
+            IncrementalCompactStats* _stats;
+            NamespaceDetails* _details;
+            bool _drained; // as of the last moveRecords()
+
+            // the deleted lists as detached, walked up to (_bucket, _cur)
+            DiskLoc _detached[Buckets];
+            bool _detaching; // the walk frees the extent when done
+            int _bucket;
+            DiskLoc _cur;
+
+            // the extent's free space, held off the deleted lists
+            vector<DiskLoc> _orphaned;
+        };
+
+    }
+
+    /**
+     * Compacts ns a few records at a time, only locking it for one batch of records at a time:
+     * records are moved out of the extents that are at most maxFill full, sparsest first, and the
+     * emptied extents are freed to the database's free list.
+     */
+    void incrementalCompact( const char* ns, double maxFill, int maxExtents, int batchSize,
+                             BSONObjBuilder& result ) {
+        vector<ExtentFill> candidates;
+        int nExtents = 0;
+        surveyExtents( ns, maxFill, &candidates, &nExtents );
+        std::sort( candidates.begin(), candidates.end() );
+        if ( static_cast<int>( candidates.size() ) > maxExtents )
+            candidates.resize( maxExtents );
+        log() << "compact incremental " << ns << ": draining " << candidates.size() << " of "
+              << nExtents << " extents" << endl;
+
+        ProgressMeterHolder pm( cc().curop()->setMessage( "compact incremental",
+                                                          "Incremental Compact Progress",
+                                                          candidates.size() ) );
+        IncrementalCompactStats stats;
+        for ( vector<ExtentFill>::const_iterator i = candidates.begin();
+              i != candidates.end(); ++i ) {
+            ExtentDrainer drainer( ns, i->loc, batchSize, &stats );
+            try {
+                drainer.run();
+            }
+            catch ( ... ) {
+                drainer.putBack();
+                throw;
+            }
+            drainer.putBack();
+            pm.hit();
+        }
+        pm.finished();
+
+        result.append( "extentsDrained", static_cast<int>( candidates.size() ) );
+        result.append( "extentsFreed", stats.extentsFreed );
+        result.append( "recordsMoved", stats.recordsMoved );
+        result.append( "bytesFreed", stats.bytesFreed );
+    }
+
     bool isCurrentlyAReplSetPrimary();
 
     class CompactCmd : public Command {
@@ -405,4 +775,83 @@ namespace mongo {
     };
     static CompactCmd compactCmd;
 
+    /**
+     * Compacts a collection without blocking it for the whole run, so it can be used on a
+     * primary: see incrementalCompact().  Unlike compact it only frees the sparsest extents and
+     * leaves the indexes in place.
+     */
+    class IncrementalCompactCmd : public Command {
+    public:
+        virtual LockType locktype() const { return NONE; }
+        virtual bool adminOnly() const { return false; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool logTheOp() { return false; }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::compact);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+        virtual void help( stringstream& help ) const {
+            help << "compact a collection a few records at a time, releasing the lock in between\n"
+                "{ incrementalCompact : <collection_name>, [maxFill:<num>], [maxExtents:<num>],\n"
+                "  [batchSize:<num>] }\n"
+                "  maxFill - only drain extents at most this full (0 to 1, default 0.5)\n"
+                "  maxExtents - drain at most this many extents, sparsest first\n"
+                "  batchSize - records moved per lock acquisition (default 100)\n";
+        }
+        IncrementalCompactCmd() : Command("incrementalCompact") { }
+
+        virtual bool run(const string& db, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            string coll = cmdObj.firstElement().valuestrsafe();
+            if( coll.empty() || db.empty() ) {
+                errmsg = "no collection name specified";
+                return false;
+            }
+
+            string ns = db + '.' + coll;
+            if ( ! NamespaceString::normal(ns.c_str()) || str::contains(ns, ".system.") ) {
+                errmsg = "can't compact a system namespace";
+                return false;
+            }
+
+            double maxFill = 0.5;
+            if( cmdObj.hasElement("maxFill") ) {
+                maxFill = cmdObj["maxFill"].numberDouble();
+                if( maxFill < 0 || maxFill > 1 ) {
+                    errmsg = "maxFill must be between 0 and 1";
+                    return false;
+                }
+            }
+            int maxExtents = INT_MAX;
+            if( cmdObj.hasElement("maxExtents") )
+                maxExtents = cmdObj["maxExtents"].numberInt();
+            int batchSize = 100;
+            if( cmdObj.hasElement("batchSize") )
+                batchSize = cmdObj["batchSize"].numberInt();
+            if( maxExtents < 0 || batchSize <= 0 ) {
+                errmsg = "maxExtents and batchSize must be positive";
+                return false;
+            }
+
+            {
+                Client::ReadContext ctx(ns);
+                NamespaceDetails *d = nsdetails(ns);
+                if( ! d ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+                if ( d->isCapped() ) {
+                    errmsg = "cannot compact a capped collection";
+                    return false;
+                }
+            }
+
+            incrementalCompact(ns.c_str(), maxFill, maxExtents, batchSize, result);
+            return true;
+        }
+    };
+    static IncrementalCompactCmd incrementalCompactCmd;
+
 }
@@ -28,6 +28,10 @@
 
 #include "mongo/pch.h"
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 #include "mongo/base/counter.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
@@ -82,6 +86,9 @@ namespace mongo {
         _numYields = 0;
         _expectedLatencyMs = 0;
         _lockStat.reset();
+        _startCpuMicros = -1;
+        _startDiskPageFaults = -1;
+        _startBlocksRead = -1;
     }
 
     void CurOp::reset() {
@@ -170,9 +177,48 @@ namespace mongo {
         _client = 0;
     }
 
+namespace {
+    /**
+     * Gets the calling thread's cpu time, major page faults and filesystem blocks read.
+     * @return false where per-thread usage isn't available
+     */
+    bool getThreadUsage( long long* cpuMicros, long long* diskPageFaults, long long* blocksRead ) {
+#if defined(RUSAGE_THREAD)
+        struct rusage usage;
+        if ( getrusage( RUSAGE_THREAD, &usage ) != 0 )
+            return false;
+        *cpuMicros = ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000000LL +
+                     usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        *diskPageFaults = usage.ru_majflt;
+        *blocksRead = usage.ru_inblock;
+        return true;
+#else
+        return false;
+#endif
+    }
+} // namespace
+
     void CurOp::ensureStarted() {
-        if ( _start == 0 )
+        if ( _start == 0 ) {
             _start = curTimeMicros64();
+            // usage can only be measured on the op's own thread
+            if ( haveClient() && &cc() == _client &&
+                 ! getThreadUsage( &_startCpuMicros, &_startDiskPageFaults, &_startBlocksRead ) )
+                _startCpuMicros = -1;
+        }
+    }
+
+    void CurOp::done() {
+        _active = false;
+        _end = curTimeMicros64();
+
+        long long cpuMicros, diskPageFaults, blocksRead;
+        if ( _startCpuMicros >= 0 && haveClient() && &cc() == _client &&
+             getThreadUsage( &cpuMicros, &diskPageFaults, &blocksRead ) ) {
+            _debug.cpuMicros = cpuMicros - _startCpuMicros;
+            _debug.diskPageFaults = diskPageFaults - _startDiskPageFaults;
+            _debug.blocksRead = blocksRead - _startBlocksRead;
+        }
     }
 
     void CurOp::enter( Client::Context * context ) {
@@ -249,6 +295,12 @@ namespace mongo {
 
         b.append( "numYields" , _numYields );
         b.append( "lockStats" , _lockStat.report() );
+        if ( _debug.pageFaultRetries > 0 ) {
+            b.append( "pageFaultRetries" , _debug.pageFaultRetries );
+            b.appendNumber( "pageFaultMicros" , _debug.pageFaultMicros );
+        }
+        if ( _debug.journalBytes > 0 )
+            b.appendNumber( "journalBytes" , _debug.journalBytes );
 
         return b.obj();
     }
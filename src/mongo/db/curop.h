@@ -109,6 +109,14 @@ namespace mongo {
         int executionTime;
         int nreturned;
         int responseLength;
+
+        // resources used, to explain why an operation was slow
+        long long cpuMicros;       // cpu time of the op's thread, -1 if not measured
+        long long diskPageFaults;  // major page faults, -1 if not measured
+        long long blocksRead;      // filesystem blocks read, -1 if not measured
+        int pageFaultRetries;      // PageFaultExceptions touched before retrying
+        long long pageFaultMicros; // time spent touching pages for those retries
+        long long journalBytes;    // bytes of write intents declared for the journal
     };
 
     /**
@@ -250,10 +258,7 @@ namespace mongo {
             ensureStarted();
             return _start;
         }
-        void done() {
-            _active = false;
-            _end = curTimeMicros64();
-        }
+        void done();
 
         unsigned long long totalTimeMicros() {
             massert( 12601 , "CurOp not marked done yet" , ! _active );
@@ -333,6 +338,10 @@ namespace mongo {
         AtomicInt32 _killPending;
         int _numYields;
         LockStat _lockStat;
+        // thread resource usage when the op started, -1 if not measured
+        long long _startCpuMicros;
+        long long _startDiskPageFaults;
+        long long _startBlocksRead;
         // _notifyList is protected by the global killCurrentOp's mtx.
         std::vector<bool*> _notifyList;
         
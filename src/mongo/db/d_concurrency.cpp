@@ -32,20 +32,27 @@
 
 #include "mongo/db/d_concurrency.h"
 
+#include "mongo/base/parse_number.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/d_globals.h"
+#include "mongo/db/database_holder.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/lockstat.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/logger/ramlog.h"
 #include "mongo/server.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mapsf.h"
 #include "mongo/util/concurrency/qlock.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/stacktrace.h"
+#include "mongo/util/time_support.h"
 
 // oplog locking
 // no top level read locks
@@ -65,10 +72,52 @@ namespace mongo {
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
 
+    // When on, DBWrite and DBRead of an ordinary collection take an intent lock on the database
+    // and lock just the collection, so writers to different collections of a database run
+    // concurrently.  Creating, dropping or renaming collections, opening databases and system
+    // collections still lock the whole database.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(collectionLevelLocking, bool, false);
+
+    // Lock acquisitions that wait at least this many micros are recorded in the "lockWaits"
+    // ramlog (see getLog), with the waiting op and the last op to take a lock exclusively,
+    // which is the likeliest one it queued behind.  0 turns the sampling off.
+    MONGO_EXPORT_SERVER_PARAMETER(lockWaitSampleMicros, int, 100 * 1000);
+
     inline LockState& lockState() { 
         return cc().lockState();
     }
 
+    namespace {
+
+        RamLog* lockWaitLog = RamLog::get("lockWaits");
+
+        // opNum of the op that most recently acquired a 'W' or 'w' lock
+        AtomicUInt lastExclusiveOp;
+
+        /** @return the currentOp description of op 'opNum', if it is still running */
+        string describeOp( unsigned opNum ) {
+            scoped_lock bl( Client::clientsMutex );
+            for ( set<Client*>::const_iterator i = Client::clients.begin();
+                  i != Client::clients.end(); ++i ) {
+                CurOp* co = (*i)->curop();
+                if ( co && co->opNum().get() == opNum )
+                    return co->info().toString();
+            }
+            return "(finished)";
+        }
+
+        void recordLockWait( char type , long long micros ) {
+            CurOp* waiter = cc().curop();
+            unsigned holder = lastExclusiveOp.get();
+            StringBuilder sb;
+            sb << dateToISOStringLocal( jsTime() ) << " waited " << micros << " micros for "
+               << type << " lock on " << waiter->getNS() << ", op: " << waiter->info().toString()
+               << " last exclusive op " << holder << ": " << describeOp( holder );
+            lockWaitLog->write( sb.str() );
+        }
+
+    } // namespace
+
     char threadState() { 
         return lockState().threadState();
     }
@@ -100,6 +149,11 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* full ns->lock, for collection level locking.  never deleted either; a dropped and recreated
+       collection gets its old lock back.
+    */
+    static DBLocksMap collectionLocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -276,6 +330,10 @@ namespace mongo {
         return DB_LEVEL_LOCKING_ENABLED;
     }
 
+    bool Lock::collectionLevelLockingEnabled() {
+        return DB_LEVEL_LOCKING_ENABLED && collectionLevelLocking;
+    }
+
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
         lockState()._batchWriter = true;
@@ -298,8 +356,87 @@ namespace mongo {
     }
 
 
+    // admission control, see Lock::TicketSupport
+    static TicketHolder readTickets( 128 );
+    static TicketHolder writeTickets( 128 );
+
+    /**
+     * the readTickets and writeTickets parameters, which resize the pools at runtime.  A pool
+     * may shrink below the tickets in use; it then admits nobody until enough are released.
+     */
+    class TicketsSetting : public ServerParameter {
+    public:
+        TicketsSetting( const std::string& name, TicketHolder* holder )
+            : ServerParameter( ServerParameterSet::getGlobal(), name ), _holder( holder ) { }
+
+        virtual void append( BSONObjBuilder& b, const std::string& name ) {
+            b.append( name, _holder->outof() );
+        }
+
+        virtual Status set( const BSONElement& newValueElement ) {
+            int newValue;
+            if ( !newValueElement.coerce( &newValue ) )
+                return Status( ErrorCodes::BadValue,
+                               mongoutils::str::stream() << "Invalid value for " << name()
+                                                         << ": " << newValueElement );
+            return _set( newValue );
+        }
+
+        virtual Status setFromString( const std::string& str ) {
+            int newValue;
+            Status status = parseNumberFromString( str, &newValue );
+            if ( !status.isOK() )
+                return status;
+            return _set( newValue );
+        }
+
+    private:
+        Status _set( int newValue ) {
+            if ( newValue < 1 )
+                return Status( ErrorCodes::BadValue,
+                               mongoutils::str::stream() << name() << " must be at least 1" );
+            _holder->resizeAllowingOverCommit( newValue );
+            return Status::OK();
+        }
+
+        TicketHolder* _holder;
+    };
+    TicketsSetting readTicketsSetting( "readTickets", &readTickets );
+    TicketsSetting writeTicketsSetting( "writeTickets", &writeTickets );
+
+    Lock::TicketSupport::TicketSupport( char type )
+        : _holder( 0 ), _write( type == 'w' || type == 'W' ) {
+        relock();
+    }
+
+    Lock::TicketSupport::~TicketSupport() {
+        tempRelease();
+    }
+
+    void Lock::TicketSupport::tempRelease() {
+        if ( _holder ) {
+            lockState()._hasTicket = false;
+            _holder->release();
+            _holder = 0;
+        }
+    }
+
+    void Lock::TicketSupport::relock() {
+        LockState& ls = lockState();
+        // nested locks are covered by the outer one's ticket.  internal threads (replication,
+        // journaling, background jobs) are never held back behind client operations.
+        if ( ls._hasTicket || ls._batchWriter || !cc().port() )
+            return;
+        _holder = _write ? &writeTickets : &readTickets;
+        {
+            Acquiring a( 0, ls );
+            _holder->waitForTicket();
+        }
+        ls._hasTicket = true;
+    }
+
     Lock::ScopedLock::ScopedLock( char type ) 
-        : _type(type), _stat(0) {
+        : _ticket(type), _type(type), _stat(0), _collectionStat(0), _collectionType(0) {
         LockState& ls = lockState();
         ls.enterScopedLock( this );
     }
@@ -310,17 +447,24 @@ namespace mongo {
         fassert( 16171 , prevCount != 1 || what == this );
     }
     
-    long long Lock::ScopedLock::acquireFinished( LockStat* stat ) {
+    long long Lock::ScopedLock::acquireFinished( LockStat* stat, LockStat* collectionStat ) {
         long long acquisitionTime = _timer.micros();
         _timer.reset();
         _stat = stat;
+        _collectionStat = collectionStat;
+        _collectionType = ( _type == 'w' ) ? 'W' : 'R';
         cc().curop()->lockStat().recordAcquireTimeMicros( _type , acquisitionTime );
+        if ( lockWaitSampleMicros > 0 && acquisitionTime >= lockWaitSampleMicros )
+            recordLockWait( _type , acquisitionTime );
+        if ( _type == 'W' || _type == 'w' )
+            lastExclusiveOp.set( cc().curop()->opNum().get() );
         return acquisitionTime;
     }
 
     void Lock::ScopedLock::tempRelease() {
         long long micros = _timer.micros();
         _tempRelease();
+        _ticket.tempRelease();
         _pbws_lk.tempRelease();
         _recordTime( micros ); // might as well do after we unlock
     }
@@ -328,6 +472,8 @@ namespace mongo {
     void Lock::ScopedLock::_recordTime( long long micros ) {
         if ( _stat )
             _stat->recordLockTimeMicros( _type , micros );
+        if ( _collectionStat )
+            _collectionStat->recordLockTimeMicros( _collectionType , micros );
         cc().curop()->lockStat().recordLockTimeMicros( _type , micros );
     }
 
@@ -341,6 +487,7 @@ namespace mongo {
     
     void Lock::ScopedLock::relock() {
         _pbws_lk.relock();
+        _ticket.relock();
         _relock();
         resetTime();
     }
@@ -522,6 +669,59 @@ namespace mongo {
         }
     }
 
+    /** records in ls that we are locking db with the given type, and returns db's lock */
+    static WrapperForRWLock* lockedOther(LockState& ls, const StringData& db, int type) {
+        if( db != ls.otherName() )
+        {
+            DBLocksMap::ref r(dblocks);
+            WrapperForRWLock*& lock = r[db];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(db);
+            ls.lockedOther( db , type , lock );
+        }
+        else { 
+            DEV OCCASIONALLY { dassert( dblocks.get(db) == ls.otherLock() ); }
+            ls.lockedOther(type);
+        }
+        return ls.otherLock();
+    }
+
+    /** records in ls that we are locking collection ns with the given type, and returns its lock */
+    static WrapperForRWLock* lockedCollection(LockState& ls, const StringData& ns, int type) {
+        WrapperForRWLock* lock;
+        {
+            DBLocksMap::ref r(collectionLocks);
+            WrapperForRWLock*& l = r[ns];
+            if( l == 0 )
+                l = new WrapperForRWLock(ns);
+            lock = l;
+        }
+        ls.lockedCollection( ns , type , lock );
+        return lock;
+    }
+
+    /** @return true if DBWrite and DBRead may lock just collection ns rather than its database */
+    static bool collectionLockable(const StringData& ns) {
+        if( !Lock::collectionLevelLockingEnabled() )
+            return false;
+        size_t dot = ns.find( '.' );
+        if( dot == string::npos || dot + 1 == ns.size() )
+            return false;
+        // system collections and $ namespaces (indexes, the free list) belong to the whole db
+        return !NamespaceString::special( ns );
+    }
+
+    /**
+     * @return true if ns is an existing collection of an open database, i.e. one which can be
+     * written with just its own lock.  must be at least intent locked on the database.
+     */
+    static bool collectionExists(const string& ns) {
+        Database* database = dbHolder().get( ns, storageGlobalParams.dbpath );
+        if( !database )
+            return false; // opening a database changes the global catalog
+        return database->namespaceIndex().details( ns ) != NULL;
+    }
+
     void Lock::DBWrite::lockOther(const StringData& db) {
         fassert( 16252, !db.empty() );
         LockState& ls = lockState();
@@ -537,24 +737,52 @@ namespace mongo {
         // first lock for this db. check consistent order with local db lock so we never deadlock. local always comes last
         massert(16098, str::stream() << "can't dblock:" << db << " when local or admin is already locked", ls.nestableCount() == 0);
 
-        if( db != ls.otherName() )
-        {
-            DBLocksMap::ref r(dblocks);
-            WrapperForRWLock*& lock = r[db];
-            if( lock == 0 )
-                lock = new WrapperForRWLock(db);
-            ls.lockedOther( db , 1 , lock );
-        }
-        else { 
-            DEV OCCASIONALLY { dassert( dblocks.get(db) == ls.otherLock() ); }
-            ls.lockedOther(1);
-        }
+        lockedOther( ls, db, 1 );
         
         fassert(16134,_weLocked==0);
         ls.otherLock()->lock();
         _weLocked = ls.otherLock();
     }
 
+    /**
+     * intent lock the database, then lock the collection, then the top level.  like lockOther()
+     * we don't lock the top level before waiting for the finer lock, see lockTop().
+     * @return false, having unlocked again, if ns has to be locked at the database level
+     */
+    bool Lock::DBWrite::lockCollection(const string& ns, LockState& ls) {
+        if( ls.otherCount() || ls.nestableCount() )
+            return false; // lockOther() reports or nests these
+
+        StringData db = nsToDatabaseSubstring( ns );
+        fassert(17187, _weLocked == 0 && _weLockedCollection == 0);
+        _weLocked = lockedOther( ls, db, 1 );
+        _weLocked->lock_intent();
+        _weLockedCollection = lockedCollection( ls, ns, 1 );
+        _weLockedCollection->lock();
+        lockTop(ls);
+
+        if( !collectionExists(ns) ) {
+            // creating the collection (or opening the database) is done with the db locked
+            unlockDB();
+            return false;
+        }
+        return true;
+    }
+
+    bool Lock::DBRead::lockCollection(const string& ns, LockState& ls) {
+        if( ls.otherCount() || ls.nestableCount() )
+            return false; // lockOther() reports or nests these
+
+        StringData db = nsToDatabaseSubstring( ns );
+        fassert(17188, _weLocked == 0 && _weLockedCollection == 0);
+        _weLocked = lockedOther( ls, db, -1 );
+        _weLocked->lock_intent_shared();
+        _weLockedCollection = lockedCollection( ls, ns, -1 );
+        _weLockedCollection->lock_shared();
+        lockTop(ls);
+        return true;
+    }
+
     static Lock::Nestable n(const StringData& db) { 
         if( db == "local" )
             return Lock::local;
@@ -571,6 +799,7 @@ namespace mongo {
         _locked_W=false;
         _locked_w=false; 
         _weLocked=0;
+        _weLockedCollection=0;
 
 
         massert( 16186 , "can't get a DBWrite while having a read lock" , ! ls.hasAnyReadLock() );
@@ -580,12 +809,19 @@ namespace mongo {
         if (DB_LEVEL_LOCKING_ENABLED) {
             StringData db = nsToDatabaseSubstring( ns );
             Nestable nested = n(db);
+            if( ls.collectionCount() && db == ls.otherName() ) {
+                // nested in a lock on just one collection, which we can't widen
+                massert(17189, str::stream() << "can't lock " << ns << " while only " << ls.collectionName() << " is locked", ls.isCollectionLocked(ns));
+                return;
+            }
             if( nested == admin ) { 
                 // we can't nestedly lock both admin and local as implemented. so lock_W.
                 qlk.lock_W();
                 _locked_W = true;
                 return;
             } 
+            if( !nested && collectionLockable(ns) && lockCollection(ns, ls) )
+                return;
             if( !nested )
                 lockOther(db);
             lockTop(ls);
@@ -605,12 +841,20 @@ namespace mongo {
         Acquiring a(this,ls);
         _locked_r=false; 
         _weLocked=0; 
+        _weLockedCollection=0;
 
         if ( ls.isRW() )
             return;
         if (DB_LEVEL_LOCKING_ENABLED) {
             StringData db = nsToDatabaseSubstring(ns);
             Nestable nested = n(db);
+            if( ls.collectionCount() && db == ls.otherName() ) {
+                // nested in a lock on just one collection, which we can't widen
+                massert(17190, str::stream() << "can't lock " << ns << " while only " << ls.collectionName() << " is locked", ls.isCollectionLocked(ns));
+                return;
+            }
+            if( !nested && collectionLockable(ns) && lockCollection(ns, ls) )
+                return;
             if( !nested )
                 lockOther(db);
             lockTop(ls);
@@ -624,12 +868,12 @@ namespace mongo {
     }
 
     Lock::DBWrite::DBWrite( const StringData& ns )
-        : ScopedLock( 'w' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock( 'w' ), _weLocked(0), _weLockedCollection(0), _what(ns.toString()), _nested(false) {
         lockDB( _what );
     }
 
     Lock::DBRead::DBRead( const StringData& ns )
-        : ScopedLock( 'r' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock( 'r' ), _weLocked(0), _weLockedCollection(0), _what(ns.toString()), _nested(false) {
         lockDB( _what );
     }
 
@@ -641,6 +885,11 @@ namespace mongo {
     }
 
     void Lock::DBWrite::unlockDB() {
+        if( _weLockedCollection ) {
+            lockState().unlockedCollection();
+            _weLockedCollection->unlock();
+        }
+
         if( _weLocked ) {
             recordTime();  // for lock stats
         
@@ -649,7 +898,10 @@ namespace mongo {
             else
                 lockState().unlockedOther();
     
-            _weLocked->unlock();
+            if( _weLockedCollection )
+                _weLocked->unlock_intent();
+            else
+                _weLocked->unlock();
         }
 
         if( _locked_w ) {
@@ -663,9 +915,15 @@ namespace mongo {
             qlk.unlock_W();
         }
         _weLocked = 0;
+        _weLockedCollection = 0;
         _locked_W = _locked_w = false;
     }
     void Lock::DBRead::unlockDB() {
+        if( _weLockedCollection ) {
+            lockState().unlockedCollection();
+            _weLockedCollection->unlock_shared();
+        }
+
         if( _weLocked ) {
             recordTime();  // for lock stats
         
@@ -674,7 +932,10 @@ namespace mongo {
             else
                 lockState().unlockedOther();
 
-            _weLocked->unlock_shared();
+            if( _weLockedCollection )
+                _weLocked->unlock_intent_shared();
+            else
+                _weLocked->unlock_shared();
         }
 
         if( _locked_r ) {
@@ -685,6 +946,7 @@ namespace mongo {
             }
         }
         _weLocked = 0;
+        _weLockedCollection = 0;
         _locked_r = false;
     }
 
@@ -727,18 +989,7 @@ namespace mongo {
         // first lock for this db. check consistent order with local db lock so we never deadlock. local always comes last
         massert(16100, str::stream() << "can't dblock:" << db << " when local or admin is already locked", ls.nestableCount() == 0);
 
-        if( db != ls.otherName() )
-        {
-            DBLocksMap::ref r(dblocks);
-            WrapperForRWLock*& lock = r[db];
-            if( lock == 0 )
-                lock = new WrapperForRWLock(db);
-            ls.lockedOther( db , -1 , lock );
-        }
-        else { 
-            DEV OCCASIONALLY { dassert( dblocks.get(db) == ls.otherLock() ); }
-            ls.lockedOther(-1);
-        }
+        lockedOther( ls, db, -1 );
         fassert(16135,_weLocked==0);
         ls.otherLock()->lock_shared();
         _weLocked = ls.otherLock();
@@ -847,10 +1098,26 @@ namespace mongo {
                 ttt.done();
             }
 
+            {
+                BSONObjBuilder ttt( t.subobjStart( "tickets" ) );
+                appendTickets( ttt, "read", readTickets );
+                appendTickets( ttt, "write", writeTickets );
+                ttt.done();
+            }
+
             return t.obj();
         }
 
     private:
+        static void appendTickets( BSONObjBuilder& b, const char* name, const TicketHolder& holder ) {
+            BSONObjBuilder bb( b.subobjStart( name ) );
+            bb.append( "out" , holder.used() );
+            bb.append( "available" , std::max( 0, holder.available() ) );
+            bb.append( "totalTickets" , holder.outof() );
+            bb.append( "queued" , holder.waiting() );
+            bb.done();
+        }
+
         unsigned long long _started;
 
     } globalLockServerStatusSection;
@@ -865,10 +1132,35 @@ namespace mongo {
             b.append(".", qlk.stats.report());
             b.append("admin", nestableLocks[Lock::admin]->stats.report());
             b.append("local", nestableLocks[Lock::local]->stats.report());
+
+            // collection locks, reported within their database's entry
+            typedef map< string, vector< pair<string, BSONObj> > > CollectionStats;
+            CollectionStats collections;
+            {
+                DBLocksMap::ref r(collectionLocks);
+                for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                    const string& ns = i->first;
+                    collections[nsToDatabase(ns)].push_back(
+                            make_pair(nsToCollectionSubstring(ns).toString(),
+                                      i->second->stats.report()));
+                }
+            }
             {
                 DBLocksMap::ref r(dblocks);
                 for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
-                    b.append(i->first, i->second->stats.report());
+                    CollectionStats::const_iterator c = collections.find(i->first);
+                    if( c == collections.end() ) {
+                        b.append(i->first, i->second->stats.report());
+                        continue;
+                    }
+                    BSONObjBuilder db(b.subobjStart(i->first));
+                    db.appendElements(i->second->stats.report());
+                    BSONObjBuilder coll(db.subobjStart("collections"));
+                    for( size_t j = 0; j < c->second.size(); j++ ) {
+                        coll.append(c->second[j].first, c->second[j].second);
+                    }
+                    coll.done();
+                    db.done();
                 }
             }
             return b.obj();
@@ -44,6 +44,7 @@ namespace mongo {
 
     class WrapperForRWLock;
     class LockState;
+    class TicketHolder;
 
     class Lock : boost::noncopyable { 
     public:
@@ -61,6 +62,12 @@ namespace mongo {
         static void assertWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+
+        /**
+         * true if DBWrite and DBRead on an existing, ordinary collection lock just that
+         * collection (and intent lock its database).  see the collectionLevelLocking parameter.
+         */
+        static bool collectionLevelLockingEnabled();
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
@@ -101,13 +108,35 @@ namespace mongo {
             friend class ScopedLock;
         };
 
+        /**
+         * Admission control: the outermost lock of an operation on a client connection holds a
+         * read ticket ('r', 'R') or a write ticket ('w', 'W') while it is locked, so that at most
+         * readTickets readers and writeTickets writers queue on or contend for the locks at once.
+         */
+        class TicketSupport : boost::noncopyable {
+        public:
+            TicketSupport( char type );
+            ~TicketSupport();
+
+        private:
+            void tempRelease();
+            void relock();
+
+            TicketHolder* _holder; // the pool we hold a ticket of, if any
+            const bool _write;
+            friend class ScopedLock;
+        };
+
     public:
         class ScopedLock : boost::noncopyable {
         public:
             virtual ~ScopedLock();
 
-            /** @return micros since we started acquiring */
-            long long acquireFinished( LockStat* stat );
+            /**
+             * @param collectionStat stat of the collection lock, if we locked just a collection
+             * @return micros since we started acquiring
+             */
+            long long acquireFinished( LockStat* stat, LockStat* collectionStat = 0 );
 
             // Accrue elapsed lock time since last we called reset
             void recordTime();
@@ -128,11 +157,14 @@ namespace mongo {
 
         private:
             ParallelBatchWriterSupport _pbws_lk;
+            TicketSupport _ticket;
 
             void _recordTime( long long micros );
             Timer _timer;
             char _type;      // 'r','w','R','W'
             LockStat* _stat; // the stat for the relevant lock to increment when we're done
+            LockStat* _collectionStat; // and for the collection lock, if any
+            char _collectionType; // 'R' or 'W'
         };
 
         // note that for these classes recursive locking is ok if the recursive locking "makes sense"
@@ -164,18 +196,21 @@ namespace mongo {
         };
 
         // lock this database. do not shared_lock globally first, that is handledin herein. 
+        // with collection level locking, an existing ordinary collection is locked on its own
+        // and its database only intent locked.
         class DBWrite : public ScopedLock {
             /**
              * flow
              *   1) lockDB
              *      a) lockTop
-             *      b) lockNestable or lockOther
+             *      b) lockNestable or lockOther or lockCollection
              *   2) unlockDB
              */
 
             void lockTop(LockState&);
             void lockNestable(Nestable db);
             void lockOther(const StringData& db);
+            bool lockCollection(const string& ns, LockState&);
             void lockDB(const string& ns);
             void unlockDB();
 
@@ -201,15 +236,18 @@ namespace mongo {
             bool _locked_w;
             bool _locked_W;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_weLockedCollection; // if set, _weLocked is an intent lock
             const string _what;
             bool _nested;
         };
 
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
+        // (or just the collection, as for DBWrite)
         class DBRead : public ScopedLock {
             void lockTop(LockState&);
             void lockNestable(Nestable db);
             void lockOther(const StringData& db);
+            bool lockCollection(const string& ns, LockState&);
             void lockDB(const string& ns);
             void unlockDB();
 
@@ -224,6 +262,7 @@ namespace mongo {
         private:
             bool _locked_r;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_weLockedCollection; // if set, _weLocked is an intent lock
             string _what;
             bool _nested;
             
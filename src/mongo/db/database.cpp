@@ -109,8 +109,10 @@ namespace mongo {
           _profileName(_name + ".system.profile"),
           _namespacesName(_name + ".system.namespaces"),
           _extentFreelistName( _name + ".$freelist" ),
-          _collectionLock( "Database::_collectionLock" )
+          _collectionLock( "Database::_collectionLock" ),
+          _extentAllocationLock( "Database::_extentAllocationLock" )
     {
+        noteUsed();
         Status status = validateDBName( _name );
         if ( !status.isOK() ) {
             warning() << "tried to open invalid db: " << _name << endl;
@@ -242,6 +244,7 @@ namespace mongo {
     }
 
     Extent* Database::allocExtent( const char *ns, int size, bool capped, bool enforceQuota ) {
+        scoped_lock lk( _extentAllocationLock );
         bool fromFreeList = true;
         Extent *e = _extentManager.allocFromFreeList( ns, size, capped );
         if( e == 0 ) {
@@ -35,6 +35,8 @@
 #include "mongo/db/storage/extent_manager.h"
 #include "mongo/db/storage/record.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/coarse_clock.h"
 
 namespace mongo {
 
@@ -96,6 +98,10 @@ namespace mongo {
          */
         void preallocateAFile() { _extentManager.preallocateAFile(); }
 
+        /**
+         * Writers holding only a collection lock may call this concurrently; the free list and
+         * the data files are shared by the whole database, so this is serialized.
+         */
         Extent* allocExtent( const char *ns, int size, bool capped, bool enforceQuota );
 
         /**
@@ -118,6 +124,10 @@ namespace mongo {
         const RecordStats& recordStats() const { return _recordStats; }
         RecordStats& recordStats() { return _recordStats; }
 
+        /** called whenever a Client::Context enters the database; see DatabaseHolder::closeIdle() */
+        void noteUsed() { _lastUsedMillis.store( coarseTimeMillis64() ); }
+        long long lastUsedMillis() const { return _lastUsedMillis.load(); }
+
         int getProfilingLevel() const { return _profile; }
         const char* getProfilingNS() const { return _profileName.c_str(); }
 
@@ -189,6 +199,7 @@ namespace mongo {
         CCByLoc _ccByLoc; // use by ClientCursor
 
         RecordStats _recordStats;
+        AtomicInt64 _lastUsedMillis;
         int _profile; // 0=off.
 
         int _magic; // used for making sure the object is still loaded in memory
@@ -201,6 +212,8 @@ namespace mongo {
         CollectionMap _collections;
         mutex _collectionLock;
 
+        mutex _extentAllocationLock;
+
     };
 
 } // namespace mongo
@@ -31,11 +31,20 @@
 #include "mongo/pch.h"
 
 #include "mongo/db/auth/auth_index_d.h"
+#include "mongo/db/background.h"
 #include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/database_holder.h"
+#include "mongo/db/dur.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/coarse_clock.h"
 
 namespace mongo {
 
+    // databases unused for this long are closed and their files unmapped; 0 for never
+    MONGO_EXPORT_SERVER_PARAMETER(closeIdleDatabasesSecs, int, 0);
+
     Database* DatabaseHolder::getOrCreate( const string& ns, const string& path, bool& justCreated ) {
         string dbname = _todb( ns );
         {
@@ -84,4 +93,80 @@ namespace mongo {
 
         return db;
     }
+
+    int DatabaseHolder::closeIdle( long long idleMillis ) {
+        const long long now = coarseTimeMillis64();
+
+        vector< pair<string, string> > idle; // path, db
+        {
+            SimpleMutex::scoped_lock lk(_m);
+            for ( Paths::const_iterator i = _paths.begin(); i != _paths.end(); ++i ) {
+                for ( DBs::const_iterator j = i->second.begin(); j != i->second.end(); ++j ) {
+                    if ( j->first == "local" || j->first == "admin" || j->first == "config" )
+                        continue;
+                    if ( now - j->second->lastUsedMillis() >= idleMillis )
+                        idle.push_back( make_pair( i->first, j->first ) );
+                }
+            }
+        }
+        if ( idle.empty() )
+            return 0;
+
+        writelocktry lk( 1000 );
+        if ( !lk.got() )
+            return 0;
+        getDur().commitNow(); // bad things happen if we close a DB with outstanding writes
+
+        int closed = 0;
+        for ( size_t i = 0; i < idle.size(); i++ ) {
+            const string& path = idle[i].first;
+            const string& name = idle[i].second;
+
+            // used, closed or dropped since we looked
+            Database* db = get( name, path );
+            if ( !db || now - db->lastUsedMillis() < idleMillis )
+                continue;
+            if ( BackgroundOperation::inProgForDb( name ) || ClientCursor::haveCursorsOn( db ) )
+                continue;
+
+            LOG(1) << "closing idle database " << name << endl;
+            Client::Context ctx( name, path );
+            Database::closeDatabase( name, path );
+            closed++;
+        }
+        return closed;
+    }
+
+    namespace {
+
+        class IdleDatabaseCloser : public BackgroundJob {
+        public:
+            virtual string name() const { return "IdleDatabaseCloser"; }
+
+            virtual void run() {
+                Client::initThread( name().c_str() );
+                while ( !inShutdown() ) {
+                    sleepsecs( 60 );
+                    int idleSecs = closeIdleDatabasesSecs;
+                    if ( idleSecs <= 0 || inShutdown() )
+                        continue;
+                    try {
+                        int closed = dbHolderUnchecked().closeIdle( idleSecs * 1000LL );
+                        if ( closed )
+                            log() << "closed " << closed << " idle databases" << endl;
+                    }
+                    catch ( const DBException& e ) {
+                        warning() << "couldn't close idle databases: " << e.toString() << endl;
+                    }
+                }
+                cc().shutdown();
+            }
+        };
+
+    }
+
+    void startIdleDatabaseCloser() {
+        IdleDatabaseCloser* closer = new IdleDatabaseCloser();
+        closer->go();
+    }
 }
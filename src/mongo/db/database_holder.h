@@ -93,6 +93,15 @@ namespace mongo {
         /** @param force - force close even if something underway - use at shutdown */
         bool closeAll( const string& path , BSONObjBuilder& result, bool force );
 
+        /**
+         * closes, unmapping their files, the databases no Client::Context has entered for
+         * idleMillis, unless they have open cursors or a background operation.  local, admin and
+         * config are always kept open.  takes the global write lock, but only when there's
+         * something to close and only if it can get it within a second.
+         * @return the number of databases closed
+         */
+        int closeIdle( long long idleMillis );
+
         // "info" as this is informational only could change on you if you are not write locked
         int sizeInfo() const { return _size; }
 
@@ -128,6 +137,9 @@ namespace mongo {
     };
 
     DatabaseHolder& dbHolderUnchecked();
+
+    /** starts the thread closing databases idle for closeIdleDatabasesSecs */
+    void startIdleDatabaseCloser();
     inline const DatabaseHolder& dbHolder() { 
         dassert( Lock::isLocked() );
         return dbHolderUnchecked();
@@ -45,6 +45,7 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/d_globals.h"
+#include "mongo/db/database_holder.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/dbwebserver.h"
@@ -66,20 +67,25 @@
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/restapi.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/startup_warnings.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/snapshots.h"
+#include "mongo/db/storage/warm_up.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
+#include "mongo/util/coarse_clock.h"
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exception_filter_win32.h"
 #include "mongo/util/file_allocator.h"
+#include "mongo/util/histogram.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/ntservice.h"
@@ -96,6 +102,11 @@
 # include <sys/file.h>
 #endif
 
+#ifdef __linux__
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
 namespace mongo {
 
     /* only off if --nohints */
@@ -240,6 +251,37 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual bool supportsParking() const { return true; }
+
+        virtual ParkedConnectionState* park( AbstractMessagingPort* p ) {
+            return new ParkedClient();
+        }
+
+    private:
+        /** A connection's Client and sharding info while no thread is serving it. */
+        class ParkedClient : public ParkedConnectionState {
+        public:
+            ParkedClient() :
+                _client( currentClient.release() ),
+                _shardedInfo( ShardedConnectionInfo::release() ) {
+            }
+
+            virtual ~ParkedClient() {
+                delete _shardedInfo;
+                delete _client;
+            }
+
+            virtual void resume() {
+                currentClient.reset( _client );
+                _client = NULL;
+                ShardedConnectionInfo::install( _shardedInfo );
+                _shardedInfo = NULL;
+            }
+
+        private:
+            Client* _client;
+            ShardedConnectionInfo* _shardedInfo;
+        };
     };
 
     void logStartup() {
@@ -275,6 +317,8 @@ namespace mongo {
         MessageServer::Options options;
         options.port = port;
         options.ipList = serverGlobalParams.bind_ip;
+        options.pooled = serverGlobalParams.pooledServiceExecutor;
+        options.poolThreads = serverGlobalParams.serviceExecutorThreads;
 
         MessageServer * server = createServer( options , new MyMessageHandler() );
         server->setAsTimeTracker();
@@ -480,6 +524,10 @@ namespace mongo {
         return 0;
     }
 
+    // Spread the writes of each --syncdelay period's flush over the period, by starting
+    // writeback of the mapped files a slice at a time before the flush at the end of it.
+    MONGO_EXPORT_SERVER_PARAMETER(pacedBackgroundFlush, bool, true);
+
     /**
      * does background async flushes of mmapped files
      */
@@ -489,7 +537,11 @@ namespace mongo {
             : ServerStatusSection( "backgroundFlushing" ),
               _total_time( 0 ),
               _flushes( 0 ),
-              _last() {
+              _last(),
+              _histogramMutex( "backgroundFlushing" ),
+              _flushHistogram( histogramOptions() ),
+              _writeBackHistogram( histogramOptions() ),
+              _writeBackBytes( 0 ) {
         }
 
         virtual bool includeByDefault() const { return true; }
@@ -516,7 +568,11 @@ namespace mongo {
                     continue;
                 }
 
-                sleepmillis((long long) std::max(0.0, (storageGlobalParams.syncdelay * 1000) - time_flushing));
+                long long millis = (long long) std::max(0.0, (storageGlobalParams.syncdelay * 1000) - time_flushing);
+                if ( pacedBackgroundFlush )
+                    writeBackPaced( millis );
+                else
+                    sleepmillis( millis );
 
                 if ( inShutdown() ) {
                     // occasional issue trying to flush during shutdown when sleep interrupted
@@ -542,16 +598,91 @@ namespace mongo {
             b.appendNumber( "average_ms" , (_flushes ? (_total_time / double(_flushes)) : 0.0) );
             b.appendNumber( "last_ms" , _last_time );
             b.append("last_finished", _last);
+
+            SimpleMutex::scoped_lock lk( _histogramMutex );
+            appendHistogram( b, "flush_ms", _flushHistogram );
+            appendHistogram( b, "writeBack_ms", _writeBackHistogram );
+            b.appendNumber( "writeBack_bytes" , _writeBackBytes );
             return b.obj();
         }
 
     private:
 
+        /** how often writeBackPaced() wakes up to start writeback of the next slice */
+        static const long long WriteBackIntervalMillis = 1000;
+
+        /** slices are whole multiples of this, which keeps them page aligned */
+        static const unsigned long long WriteBackUnit = 1024 * 1024;
+
+        /**
+         * Sleeps for 'millis', meanwhile sweeping over all the mapped data once and starting
+         * writeback of its dirty pages.  Each wakeup covers an equal share of what is left of the
+         * sweep, so the writes follow the dirty data over the time left before the deadline
+         * instead of piling up in the flushAll() at the end.
+         */
+        void writeBackPaced( long long millis ) {
+            Date_t deadline = jsTime() + millis;
+            unsigned long long total = MemoryMappedFile::totalMappedLength();
+            unsigned long long covered = 0;
+            MongoFile::WriteBackCursor cursor;
+
+            while ( ! inShutdown() ) {
+                long long left = (long long) (deadline - jsTime());
+                if ( left <= 0 )
+                    break;
+
+                if ( ! cursor.done && total > covered ) {
+                    long long wakeupsLeft = ( left + WriteBackIntervalMillis - 1 ) / WriteBackIntervalMillis;
+                    unsigned long long slice = ( total - covered ) / wakeupsLeft;
+                    slice = ( slice / WriteBackUnit + 1 ) * WriteBackUnit;
+
+                    Date_t start = jsTime();
+                    unsigned long long n = MemoryMappedFile::writeBackSome( &cursor, slice );
+                    covered += n;
+                    _wroteBack( (int) (jsTime() - start), n );
+                }
+
+                sleepmillis( std::min( WriteBackIntervalMillis, (long long) (deadline - jsTime()) ) );
+            }
+        }
+
+        static Histogram::Options histogramOptions() {
+            // [0..10],[11..20],[21..40],...,[5121..10240],[10241..max] ms
+            Histogram::Options opts;
+            opts.numBuckets = 12;
+            opts.bucketSize = 10;
+            opts.exponential = true;
+            return opts;
+        }
+
+        static void appendHistogram( BSONObjBuilder& b, const StringData& name, const Histogram& h ) {
+            BSONObjBuilder sub( b.subobjStart( name ) );
+            uint32_t lower = 0;
+            for ( uint32_t i = 0; i < h.getBucketsNum(); i++ ) {
+                uint32_t upper = h.getBoundary( i );
+                string bucket = i + 1 < h.getBucketsNum()
+                    ? str::stream() << lower << "-" << upper
+                    : str::stream() << lower << "+";
+                sub.appendNumber( bucket, static_cast<long long>( h.getCount( i ) ) );
+                lower = upper + 1;
+            }
+            sub.done();
+        }
+
         void _flushed(int ms) {
             _flushes++;
             _total_time += ms;
             _last_time = ms;
             _last = jsTime();
+
+            SimpleMutex::scoped_lock lk( _histogramMutex );
+            _flushHistogram.insert( ms );
+        }
+
+        void _wroteBack(int ms, unsigned long long bytes) {
+            SimpleMutex::scoped_lock lk( _histogramMutex );
+            _writeBackHistogram.insert( ms );
+            _writeBackBytes += bytes;
         }
 
         long long _total_time;
@@ -559,6 +690,11 @@ namespace mongo {
         int _last_time;
         Date_t _last;
 
+        // Histogram isn't thread safe, and serverStatus reads these from another thread
+        mutable SimpleMutex _histogramMutex;
+        Histogram _flushHistogram;
+        Histogram _writeBackHistogram;
+        long long _writeBackBytes;
 
     } dataFileSync;
 
@@ -589,6 +725,39 @@ namespace mongo {
         return cc().curop()->opNum();
     }
 
+    // Interleave the process's memory across all NUMA nodes, as "numactl --interleave=all"
+    // would.  Startup only: threads inherit the policy when they are created.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaInterleave, bool, false);
+
+    static void setNumaInterleave() {
+#ifdef __linux__
+        if (!numaInterleave)
+            return;
+
+        unsigned long nodes = 0;
+        for (size_t i = 0; i < sizeof(nodes) * 8; i++) {
+            if (boost::filesystem::exists(str::stream() << "/sys/devices/system/node/node" << i))
+                nodes |= 1UL << i;
+        }
+        if (!(nodes & (nodes - 1))) {
+            log() << "numaInterleave: fewer than two NUMA nodes, nothing to interleave" << endl;
+            return;
+        }
+
+        const int mpolInterleave = 3; // MPOL_INTERLEAVE from <numaif.h>
+        // the kernel reads maxnode - 1 bits of the mask
+        if (syscall(SYS_set_mempolicy, mpolInterleave, &nodes, sizeof(nodes) * 8 + 1) != 0) {
+            warning() << "numaInterleave: set_mempolicy failed: " << errnoWithDescription()
+                      << endl;
+            return;
+        }
+        log() << "interleaving memory across NUMA nodes" << endl;
+#else
+        if (numaInterleave)
+            warning() << "numaInterleave is only supported on Linux" << endl;
+#endif // __linux__
+    }
+
     /// warn if readahead > 256KB (gridfs chunk size)
     static void checkReadAhead(const string& dir) {
 #ifdef __linux__
@@ -645,6 +814,7 @@ namespace mongo {
             l << ( is32bit ? " 32" : " 64" ) << "-bit host=" << getHostNameCached() << endl;
         }
         DEV log() << "_DEBUG build (which is slower)" << endl;
+        setNumaInterleave();
         logStartupWarnings();
 #if defined(_WIN32)
         printTargetMinOS();
@@ -712,9 +882,12 @@ namespace mongo {
         /* this is for security on certain platforms (nonce generation) */
         srand((unsigned) (curTimeMicros() ^ startupSrandTimer.micros()));
 
+        startCoarseClock();
         snapshotThread.go();
         d.clientCursorMonitor.go();
         PeriodicTask::theRunner->go();
+        startWorkingSetWarmUp();
+        startIdleDatabaseCloser();
         if (missingRepl) {
             // a warning was logged earlier
         }
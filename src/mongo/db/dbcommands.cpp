@@ -1224,7 +1224,8 @@ namespace mongo {
         virtual LockType locktype() const { return READ; }
         virtual void help( stringstream &help ) const {
             help << "{ collStats:\"blog.posts\" , scale : 1 } scale divides sizes e.g. for KB use 1024\n"
-                    "    avgObjSize - in bytes";
+                    "    avgObjSize - in bytes\n"
+                    "    scanExtents:true walks the extents instead of using the maintained totals";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
@@ -1268,8 +1269,13 @@ namespace mongo {
 
             int numExtents;
             BSONArrayBuilder extents;
+            long long storageSize;
+            if ( verbose || jsobj["scanExtents"].trueValue() )
+                storageSize = nsd->storageSize( &numExtents , verbose ? &extents : 0  );
+            else
+                storageSize = NamespaceDetailsTransient::storageSize( ns , nsd , &numExtents );
 
-            result.appendNumber( "storageSize" , nsd->storageSize( &numExtents , verbose ? &extents : 0  ) / scale );
+            result.appendNumber( "storageSize" , storageSize / scale );
             result.append( "numExtents" , numExtents );
             result.append( "nindexes" , nsd->getCompletedIndexCount() );
             result.append( "lastExtentSize" , nsd->lastExtentSize() / scale );
@@ -1410,7 +1416,8 @@ namespace mongo {
         virtual void help( stringstream &help ) const {
             help << 
                 "Get stats on a database. Not instantaneous. Slower for databases with large .ns files.\n" << 
-                "Example: { dbStats:1, scale:1 }";
+                "Example: { dbStats:1, scale:1 }\n" <<
+                "scanExtents:true walks the extents instead of using the maintained totals";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
@@ -1445,6 +1452,7 @@ namespace mongo {
             long long numExtents = 0;
             long long indexes = 0;
             long long indexSize = 0;
+            bool scanExtents = jsobj["scanExtents"].trueValue();
 
             for (list<string>::const_iterator it = collections.begin(); it != collections.end(); ++it) {
                 const string ns = *it;
@@ -1461,7 +1469,8 @@ namespace mongo {
                 size += nsd->dataSize();
 
                 int temp;
-                storageSize += nsd->storageSize( &temp );
+                storageSize += scanExtents ? nsd->storageSize( &temp ) :
+                                             NamespaceDetailsTransient::storageSize( ns, nsd, &temp );
                 numExtents += temp;
 
                 indexes += nsd->getCompletedIndexCount();
@@ -39,6 +39,8 @@
 
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 #include <string>
 #include <vector>
 
@@ -49,6 +51,7 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/curop-inl.h"
+#include "mongo/db/database_holder.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -56,6 +59,8 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/runner_yield_policy.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/alignedbuilder.h"
@@ -152,6 +157,9 @@ namespace mongo {
         return Status::OK();
     }
 
+    // threads checking the indexes of one background validate; no more than the cores
+    MONGO_EXPORT_SERVER_PARAMETER(validateIndexThreads, int, 4);
+
     class ValidateCmd : public Command {
     public:
         ValidateCmd() : Command( "validate" ) {}
@@ -161,9 +169,11 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check\n"
+                                                        "Add background:true to yield while scanning records and check indexes in parallel"; }
 
-        virtual LockType locktype() const { return READ; }
+        // takes its own locks, so a background validate can give them up
+        virtual LockType locktype() const { return NONE; }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
                                            std::vector<Privilege>* out) {
@@ -171,32 +181,199 @@ namespace mongo {
             actions.addAction(ActionType::validate);
             out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
         }
-        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool> } */
+        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool>]
+        //  [, background: <bool>] } */
 
         bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
-            NamespaceDetails * d = nsdetails( ns );
             if (!serverGlobalParams.quiet) {
                 MONGO_TLOG(0) << "CMD: validate " << ns << endl;
             }
 
+            // the index checks of a background validate lock from other threads, which would wait
+            // forever on a lock this thread already held
+            if ( cmdObj["background"].trueValue() && Lock::isLocked() ) {
+                errmsg = "can't validate in the background while holding a lock";
+                return false;
+            }
+
+            scoped_ptr<Client::ReadContext> ctx(new Client::ReadContext(ns,
+                                                                        storageGlobalParams.dbpath));
+            NamespaceDetails * d = nsdetails( ns );
             if ( ! d ) {
                 errmsg = "ns not found";
                 return false;
             }
 
             result.append( "ns", ns );
-            validateNS( ns.c_str() , d, cmdObj, result);
+            validateNS( ns.c_str() , d, cmdObj, result, ctx);
             return true;
         }
 
     private:
+        /**
+         * The indexes of a background validate, handed out to worker threads which each lock
+         * the database only while checking one btree.
+         */
+        struct ParallelIndexValidate {
+            ParallelIndexValidate(const string& ns, const vector<string>& names, size_t workers)
+                : ns(ns), names(names), keys(names.size(), -1), errors(names.size()),
+                  _next(0), _done(0), _running(workers), _stopped(false) {
+            }
+
+            /** @return false once the indexes are used up or the command was interrupted */
+            bool take(size_t* i) {
+                boost::mutex::scoped_lock lk(_mutex);
+                if (_stopped || _next == names.size())
+                    return false;
+                *i = _next++;
+                return true;
+            }
+
+            void checked() {
+                boost::mutex::scoped_lock lk(_mutex);
+                _done++;
+                _changed.notify_all();
+            }
+
+            void exited() {
+                boost::mutex::scoped_lock lk(_mutex);
+                _running--;
+                _changed.notify_all();
+            }
+
+            void stop() {
+                boost::mutex::scoped_lock lk(_mutex);
+                _stopped = true;
+            }
+
+            /**
+             * Waits a little for an index to be checked.
+             * @return false once every worker has exited
+             */
+            bool wait(size_t* done) {
+                boost::mutex::scoped_lock lk(_mutex);
+                if (_running > 0)
+                    _changed.timed_wait(lk, boost::posix_time::milliseconds(100));
+                *done = _done;
+                return _running > 0;
+            }
+
+            const string ns;
+            const vector<string> names;
+            // each written only by the worker which took that index; -1 keys if it was dropped
+            vector<long long> keys;
+            vector<string> errors;
+
+        private:
+            boost::mutex _mutex;
+            boost::condition _changed;
+            size_t _next;
+            size_t _done;
+            size_t _running;
+            bool _stopped;
+        };
+
+        static void validateIndexes(ParallelIndexValidate* v) {
+            size_t i;
+            while (v->take(&i)) {
+                try {
+                    Lock::DBRead lk(v->ns);
+                    // don't reopen a database dropped since the indexes were listed
+                    Database* db = dbHolder().get(v->ns, storageGlobalParams.dbpath);
+                    NamespaceDetails* d = NULL;
+                    if (db) {
+                        Client::Context ctx(v->ns, db);
+                        d = nsdetails(v->ns);
+                        int idxNo = d ? d->findIndexByName(v->names[i]) : -1;
+                        if (idxNo >= 0) {
+                            auto_ptr<IndexDescriptor> descriptor(
+                                    CatalogHack::getDescriptor(d, idxNo));
+                            auto_ptr<IndexAccessMethod> iam(
+                                    CatalogHack::getIndex(descriptor.get()));
+                            int64_t keys;
+                            iam->validate(&keys);
+                            v->keys[i] = keys;
+                        }
+                    }
+                }
+                catch (const DBException& e) {
+                    v->errors[i] = e.toString();
+                }
+                catch (const std::exception& e) {
+                    v->errors[i] = e.what();
+                }
+                v->checked();
+            }
+            v->exited();
+        }
+
+        static void indexWorker(ParallelIndexValidate* v) {
+            Client::initThread("validate");
+            validateIndexes(v);
+            cc().shutdown();
+        }
+
+        /**
+         * Checks the btrees of the named indexes from worker threads, with no lock held here.
+         * Indexes dropped meanwhile are left out.
+         * @return false if any check failed
+         */
+        bool validateIndexesInBackground(const char* ns,
+                                         const vector<string>& names,
+                                         BSONObjBuilder& result,
+                                         BSONArrayBuilder& errors) {
+            unsigned cores = std::max(boost::thread::hardware_concurrency(), 1U);
+            size_t numThreads = std::min(static_cast<unsigned>(std::max(validateIndexThreads, 1)),
+                                         cores);
+            numThreads = std::min(numThreads, names.size());
+
+            ProgressMeterHolder pm(cc().curop()->setMessage("validate indexes",
+                                                            "Validate: Indexes Checked",
+                                                            names.size()));
+            ParallelIndexValidate v(ns, names, numThreads);
+            boost::thread_group threads;
+            for (size_t i = 0; i < numThreads; i++)
+                threads.create_thread(boost::bind(&ValidateCmd::indexWorker, &v));
+
+            size_t seen = 0;
+            size_t done;
+            while (v.wait(&done)) {
+                pm.hit(done - seen);
+                seen = done;
+                if (*killCurrentOp.checkForInterruptNoAssert())
+                    v.stop();
+            }
+            threads.join_all();
+            pm.finished();
+            killCurrentOp.checkForInterrupt();
+
+            bool ok = true;
+            BSONObjBuilder indexes;
+            for (size_t i = 0; i < names.size(); i++) {
+                if (!v.errors[i].empty()) {
+                    errors << string(str::stream() << "exception during index validate "
+                                                   << names[i] << ": " << v.errors[i]);
+                    ok = false;
+                }
+                else if (v.keys[i] >= 0) {
+                    indexes.appendNumber(string(str::stream() << ns << ".$" << names[i]),
+                                         v.keys[i]);
+                }
+            }
+            result.append("keysPerIndex", indexes.obj());
+            return ok;
+        }
+
         void validateNS(const char *ns,
                         NamespaceDetails *d,
                         const BSONObj& cmdObj,
-                        BSONObjBuilder& result) {
+                        BSONObjBuilder& result,
+                        scoped_ptr<Client::ReadContext>& ctx) {
             const bool full = cmdObj["full"].trueValue();
             const bool scanData = full || cmdObj["scandata"].trueValue();
+            // yields while scanning records and gives up the read lock for the index checks
+            const bool background = cmdObj["background"].trueValue();
 
             bool valid = true;
             BSONArrayBuilder errors; // explanation(s) for why valid = false
@@ -323,13 +500,20 @@ namespace mongo {
                     int outOfOrder = 0;
                     DiskLoc cl_last;
 
+                    ProgressMeterHolder pm(cc().curop()->setMessage("validate",
+                                                                    "Validate: Records Scanned",
+                                                                    d->numRecords()));
+                    RunnerYieldPolicy yieldPolicy;
+
                     DiskLoc cl;
                     Runner::RunnerState state;
                     auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
                     while (Runner::RUNNER_ADVANCED == (state = runner->getNext(NULL, &cl))) {
                         n++;
+                        pm.hit();
 
-                        if ( n < 1000000 )
+                        // records freed while we yield may be in the deleted lists by the end
+                        if ( n < 1000000 && !background )
                             recs.insert(cl);
                         if ( d->isCapped() ) {
                             if ( cl < cl_last )
@@ -385,7 +569,15 @@ namespace mongo {
                                 bsonLen += obj.objsize();
                             }
                         }
+
+                        if ( background && yieldPolicy.shouldYield() ) {
+                            uassert(17328, str::stream() << ns << " dropped during validate",
+                                    yieldPolicy.yieldAndCheckIfOK(runner.get())
+                                    && NULL != (d = nsdetails(ns)));
+                            pm->setTotalWhileRunning(d->numRecords());
+                        }
                     }
+                    pm.finished();
                     if (Runner::RUNNER_EOF != state) {
                         // TODO: more descriptive logging.
                         warning() << "Internal error while reading collection " << ns << endl;
@@ -472,30 +664,49 @@ namespace mongo {
                     valid = false;
                 }
 
-                int idxn = 0;
-                try  {
+                if ( background ) {
                     result.append("nIndexes", d->getCompletedIndexCount());
-                    BSONObjBuilder indexes; // not using subObjStart to be exception safe
+                    vector<string> names;
                     NamespaceDetails::IndexIterator i = d->ii();
-                    while( i.more() ) {
-                        IndexDetails& id = i.next();
-                        log() << "validating index " << idxn << ": " << id.indexNamespace() << endl;
-                        auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(d, idxn));
-                        auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(descriptor.get()));
-                        int64_t keys;
-                        iam->validate(&keys);
-                        indexes.appendNumber(id.indexNamespace(), static_cast<long long>(keys));
-                        idxn++;
-                    }
-                    result.append("keysPerIndex", indexes.done());
+                    while( i.more() )
+                        names.push_back(i.next().indexName());
+
+                    // the btrees are checked by worker threads which lock one at a time
+                    ctx.reset();
+                    d = NULL;
+                    if ( !validateIndexesInBackground(ns, names, result, errors) )
+                        valid = false;
                 }
-                catch (...) {
-                    errors << ("exception during index validate idxn " + BSONObjBuilder::numStr(idxn));
-                    valid=false;
+                else {
+                    int idxn = 0;
+                    try  {
+                        result.append("nIndexes", d->getCompletedIndexCount());
+                        BSONObjBuilder indexes; // not using subObjStart to be exception safe
+                        NamespaceDetails::IndexIterator i = d->ii();
+                        while( i.more() ) {
+                            IndexDetails& id = i.next();
+                            log() << "validating index " << idxn << ": " << id.indexNamespace() << endl;
+                            auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(d, idxn));
+                            auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(descriptor.get()));
+                            int64_t keys;
+                            iam->validate(&keys);
+                            indexes.appendNumber(id.indexNamespace(), static_cast<long long>(keys));
+                            idxn++;
+                        }
+                        result.append("keysPerIndex", indexes.done());
+                    }
+                    catch (...) {
+                        errors << ("exception during index validate idxn " + BSONObjBuilder::numStr(idxn));
+                        valid=false;
+                    }
                 }
 
             }
-            catch (AssertionException) {
+            catch (AssertionException& e) {
+                // the collection went away or the op was killed while a background validate
+                // had yielded
+                if (e.getCode() == 17328 || e.interrupted())
+                    throw;
                 errors << "exception during validate";
                 valid = false;
             }
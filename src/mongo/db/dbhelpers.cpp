@@ -336,7 +336,14 @@ namespace mongo {
         
         long long millisWaitingForReplication = 0;
 
+        // Each pass of the loop below deletes a batch of documents under one write lock. The
+        // batch is bounded by the bytes it removes, so each pass costs roughly the same I/O
+        // whatever the document size, and at least one document is always deleted.
+        const int maxBatchBytes = 1024 * 1024;
+
         while ( 1 ) {
+            Timer batchTime;
+
             // Scoping for write lock.
             {
                 Client::WriteContext ctx(ns);
@@ -345,21 +352,29 @@ namespace mongo {
                 if (NULL == nsd) { break; }
                 int ii = nsd->findIndexByKeyPattern( indexKeyPattern.toBSON() );
 
+                // Collect the batch from the shard key index. The runner doesn't yield, since the
+                // locations must stay valid until they are deleted under this same lock.
                 auto_ptr<Runner> runner(InternalPlanner::indexScan(ns, nsd, ii, min, max,
                                                                    maxInclusive,
                                                                    InternalPlanner::FORWARD,
                                                                    InternalPlanner::IXSCAN_FETCH));
 
-                runner->setYieldPolicy(Runner::YIELD_AUTO);
-
+                vector<pair<DiskLoc, BSONObj> > batch;
+                int batchBytes = 0;
                 DiskLoc rloc;
                 BSONObj obj;
-                Runner::RunnerState state;
-                // This may yield so we cannot touch nsd after this.
-                state = runner->getNext(&obj, &rloc);
+                while ( batchBytes < maxBatchBytes &&
+                        Runner::RUNNER_ADVANCED == runner->getNext(&obj, &rloc) ) {
+                    batch.push_back( make_pair( rloc, obj ) );
+                    batchBytes += obj.objsize();
+                }
                 runner.reset();
-                if (Runner::RUNNER_EOF == state) { break; }
+                if ( batch.empty() ) { break; }
+
+                // Delete in disk order rather than shard key order, for sequential I/O.
+                sort( batch.begin(), batch.end() );
 
+                CollectionMetadataPtr metadataNow;
                 if ( onlyRemoveOrphanedDocs ) {
                     // Do a final check in the write lock to make absolutely sure that our
                     // collection hasn't been modified in a way that invalidates our migration
@@ -370,35 +385,47 @@ namespace mongo {
                     verify(shardingState.enabled());
 
                     // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
-
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        KeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractSingleKey( obj );
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
-                    }
-                    else {
-                        docIsOrphan = false;
-                    }
+                    metadataNow = shardingState.getCollectionMetadata( ns );
+                }
 
-                    if ( !docIsOrphan ) {
-                        warning() << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
+                CollectionTemp* collection = c.database()->getCollectionTemp( ns );
+                bool collectionChanged = false;
+                for ( size_t i = 0; i < batch.size(); i++ ) {
+                    const BSONObj& doc = batch[i].second;
+
+                    if ( onlyRemoveOrphanedDocs ) {
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            KeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractSingleKey( doc );
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning() << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + doc.toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            collectionChanged = true;
+                            break;
+                        }
                     }
-                }
 
-                if ( callback )
-                    callback->goingToDelete( obj );
+                    if ( callback )
+                        callback->goingToDelete( doc );
+
+                    logOp("d", ns.c_str(), doc["_id"].wrap(), 0, 0, fromMigrate);
+                    collection->deleteDocument( batch[i].first );
+                    numDeleted++;
+                }
 
-                logOp("d", ns.c_str(), obj["_id"].wrap(), 0, 0, fromMigrate);
-                c.database()->getCollectionTemp( ns )->deleteDocument( rloc );
-                numDeleted++;
+                if ( collectionChanged ) { break; }
             }
 
+            const long long batchMicros = batchTime.micros();
             Timer secondaryThrottleTime;
 
             if ( secondaryThrottle && numDeleted > 0 ) {
@@ -409,7 +436,11 @@ namespace mongo {
             }
             
             if ( ! Lock::isLocked() ) {
-                int micros = ( 2 * Client::recommendedYieldMicros() ) - secondaryThrottleTime.micros();
+                // Rest at least as long as the batch held the lock, so that cleanup takes at most
+                // half of the time, and so roughly half of the I/O, it could.
+                long long micros = std::max<long long>( 2 * Client::recommendedYieldMicros(),
+                                                        batchMicros )
+                                   - secondaryThrottleTime.micros();
                 if ( micros > 0 ) {
                     LOG(1) << "Helpers::removeRangeUnlocked going to sleep for " << micros << " micros" << endl;
                     sleepmicros( micros );
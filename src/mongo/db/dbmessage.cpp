@@ -60,7 +60,9 @@ namespace mongo {
                       int nReturned, int startingFrom,
                       long long cursorId 
                       ) {
-        BufBuilder b(32768);
+        // The reply is handed off to the Message below, so size it exactly rather than
+        // reserving room it will never use.
+        BufBuilder b(sizeof(QueryResult) + size);
         b.skip(sizeof(QueryResult));
         b.appendBuf(data, size);
         QueryResult *qr = (QueryResult *) b.buf();
@@ -179,6 +179,9 @@ namespace mongo {
             vector<string>& headers, // if completely empty, content-type: text/html will be added
             const SockAddr &from
         ) {
+            // requests are served from MiniWebServer's worker threads
+            Client::initThreadIfNotAlready("websvr");
+
             if ( url.size() > 1 ) {
 
                 if ( ! allowed( rq , headers, from ) ) {
@@ -500,7 +503,11 @@ namespace mongo {
 
     class CommandsHandler : public DbWebHandler {
     public:
-        CommandsHandler() : DbWebHandler( "DUMMY COMMANDS" , 2 , true ) {}
+        CommandsHandler() : DbWebHandler( "DUMMY COMMANDS" , 2 , true ),
+                            _cacheMutex( "CommandsHandler" ), _serverStatusTime( 0 ) {}
+
+        // several monitoring systems polling serverStatus share one result this long
+        static const unsigned long long serverStatusCacheMillis = 1000;
 
         bool _cmd( const string& url , string& cmd , bool& text, bo params ) const {
             cmd = str::after(url, '/');
@@ -540,12 +547,19 @@ namespace mongo {
             BSONObj cmdObj = BSON( cmd << 1 );
             Client& client = cc();
 
-            BSONObjBuilder result;
-            Command::execCommand(c, client, 0, "admin.", cmdObj , result, false);
+            BSONObj result;
+            if ( cmd == "serverStatus" ) {
+                result = _runServerStatus( c, client, cmdObj );
+            }
+            else {
+                BSONObjBuilder b;
+                Command::execCommand(c, client, 0, "admin.", cmdObj , b, false);
+                result = b.obj();
+            }
 
             responseCode = 200;
 
-            string j = result.done().jsonString(Strict, text );
+            string j = result.jsonString(Strict, text );
             responseMsg = j;
 
             if( text ) {
@@ -558,6 +572,32 @@ namespace mongo {
 
         }
 
+    private:
+        BSONObj _runServerStatus( Command* c, Client& client, BSONObj& cmdObj ) {
+            // the cached result is only for clients that could have run the command
+            if ( c->checkAuthForCommand( &client, "admin", cmdObj ).isOK() ) {
+                scoped_lock lk( _cacheMutex );
+                if ( ! _serverStatusResult.isEmpty() &&
+                     curTimeMillis64() - _serverStatusTime < serverStatusCacheMillis ) {
+                    return _serverStatusResult;
+                }
+            }
+
+            BSONObjBuilder b;
+            Command::execCommand(c, client, 0, "admin.", cmdObj , b, false);
+            BSONObj result = b.obj();
+
+            if ( result["ok"].trueValue() ) {
+                scoped_lock lk( _cacheMutex );
+                _serverStatusResult = result;
+                _serverStatusTime = curTimeMillis64();
+            }
+            return result;
+        }
+
+        mongo::mutex _cacheMutex;
+        BSONObj _serverStatusResult;
+        unsigned long long _serverStatusTime;
     } commandsHandler;
 
     // --- external ----
@@ -57,7 +57,8 @@
        commitJob.reset()
      UNLOCK dbMutex                                     // now other threads can write
        WRITETOJOURNAL()
-       WRITETODATAFILES()
+       wait for the previous group's WRITETODATAFILES
+       hand this group to the DataFileWriter thread    // WRITETODATAFILES() in READLOCK mmmutex
      UNLOCK mmmutex
      UNLOCK groupCommitMutex
 
@@ -79,6 +80,7 @@
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/server.h"
 #include "mongo/util/concurrency/race.h"
@@ -216,7 +218,7 @@ namespace mongo {
         }
 
         bool DurableImpl::awaitCommit() {
-            commitJob._notify.awaitBeyondNow();
+            commitJob.awaitCommit();
             return true;
         }
 
@@ -509,36 +511,51 @@ namespace mongo {
                 privateMapBytes = 0;
             }
 
-            unsigned ntodo = (unsigned) (sz * fraction);
+            // only the regions of the private views that were written need remapping.  we do a
+            // fraction of them each pass, so each pass (which holds the global write lock) stays
+            // short, and so the copy on write faults that follow a remap are spread out too.
+            unsigned nwritten = 0;
+            for( set<MongoFile*>::iterator i = files.begin(); i != files.end(); i++ ) {
+                if( (*i)->isDurableMappedFile() )
+                    nwritten += ((DurableMappedFile*) *i)->writtenChunks();
+            }
+            if( nwritten == 0 )
+                return;
+
+            unsigned ntodo = (unsigned) (nwritten * fraction);
             if( ntodo < 1 ) ntodo = 1;
-            if( ntodo > sz ) ntodo = sz;
+            if( ntodo > nwritten ) ntodo = nwritten;
 
             const set<MongoFile*>::iterator b = files.begin();
             const set<MongoFile*>::iterator e = files.end();
             set<MongoFile*>::iterator i = b;
             // skip to our starting position
+            startAt %= sz;
             for( unsigned x = 0; x < startAt; x++ ) {
                 i++;
-                if( i == e ) i = b;
             }
             unsigned startedAt = startAt;
-            startAt = (startAt + ntodo) % sz; // mark where to start next time
 
             Timer t;
-            for( unsigned x = 0; x < ntodo; x++ ) {
+            unsigned ndone = 0;
+            for( unsigned x = 0; x < sz && ndone < ntodo; x++ ) {
                 dassert( i != e );
                 if( (*i)->isDurableMappedFile() ) {
                     DurableMappedFile *mmf = (DurableMappedFile*) *i;
                     verify(mmf);
                     if( mmf->willNeedRemap() ) {
-                        mmf->willNeedRemap() = false;
-                        mmf->remapThePrivateView();
+                        ndone += mmf->remapThePrivateView(ntodo - ndone);
+                        if( mmf->willNeedRemap() ) {
+                            // out of budget part way through this file, start with it next time
+                            break;
+                        }
                     }
-                    i++;
-                    if( i == e ) i = b;
                 }
+                i++;
+                if( i == e ) i = b;
+                startAt = (startAt + 1) % sz; // mark where to start next time
             }
-            LOG(2) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << ntodo << ' ' << t.millis() << "ms" << endl;
+            LOG(2) << "journal REMAPPRIVATEVIEW done startedAt: " << startedAt << " n:" << ndone << '/' << nwritten << ' ' << t.millis() << "ms" << endl;
         }
 
         /** We need to remap the private views periodically. otherwise they would become very large.
@@ -550,14 +567,94 @@ namespace mongo {
             stats.curr->_remapPrivateViewMicros += t.micros();
         }
 
-        // this is a pseudo-local variable in the groupcommit functions 
+        // these are pseudo-local variables in the groupcommit functions 
         // below.  however we don't truly do that so that we don't have to 
-        // reallocate, and more importantly regrow it, on every single commit.
+        // reallocate, and more importantly regrow them, on every single commit.
+        // there are two so that a group can be prepared and journaled while the 
+        // previous one is still being applied to the data files.
         static AlignedBuilder __theBuilder(4 * 1024 * 1024);
+        static AlignedBuilder __theOtherBuilder(4 * 1024 * 1024);
+
+        /** call within groupCommitMutex */
+        static AlignedBuilder& nextBuilder() {
+            static unsigned n;
+            return ++n % 2 ? __theBuilder : __theOtherBuilder;
+        }
+
+        /** applies a journaled group to the data files on its own thread, so that the durThread 
+            can prepare and journal the next group meanwhile.  at most one group is outstanding: 
+            wait() before handing it another one, and before anything which expects the data 
+            files to be current (REMAPPRIVATEVIEW, a flush that will advance the lsn).
+        */
+        class DataFileWriter : boost::noncopyable {
+        public:
+            DataFileWriter() : _m("dataFileWriter"), _ab(0), _started(false) { }
+
+            /** @param ab must not be touched by the caller until wait() returns. */
+            void start(const JSectHeader& h, AlignedBuilder *ab) {
+                SimpleMutex::scoped_lock lk(_m);
+                verify( _ab == 0 );
+                if( !_started ) {
+                    boost::thread t(boost::bind(&DataFileWriter::run, this));
+                    _started = true;
+                }
+                _h = h;
+                _ab = ab;
+                _cond.notify_all();
+            }
+
+            void wait() {
+                SimpleMutex::scoped_lock lk(_m);
+                while( _ab )
+                    _cond.wait(_m);
+            }
+
+        private:
+            void run() {
+                Client::initThread("journalDataFiles");
+                while( 1 ) {
+                    JSectHeader h;
+                    AlignedBuilder *ab;
+                    {
+                        SimpleMutex::scoped_lock lk(_m);
+                        while( _ab == 0 )
+                            _cond.wait(_m);
+                        h = _h;
+                        ab = _ab;
+                    }
+
+                    unsigned abLen = ab->len();
+                    try {
+                        // processSection holds LockMongoFilesShared, so the files can't go 
+                        // away under us; closing one commits (and so waits for us) first.
+                        WRITETODATAFILES(h, *ab);
+                    }
+                    catch(std::exception& e) {
+                        log() << "exception in dur::DataFileWriter causing immediate shutdown: " << e.what() << endl;
+                        mongoAbort("dur5");
+                    }
+                    verify( abLen == ab->len() ); // check no one touched the builder meanwhile
+                    ab->reset();
+
+                    SimpleMutex::scoped_lock lk(_m);
+                    _ab = 0;
+                    _cond.notify_all();
+                }
+            }
+
+            SimpleMutex _m; // protects _h, _ab
+            boost::condition _cond;
+            JSectHeader _h;
+            AlignedBuilder *_ab; // the group being written, or 0 if idle
+            bool _started;
+        } dataFileWriter;
+
+        void waitForDataFileWrites() {
+            dataFileWriter.wait();
+        }
 
         static bool _groupCommitWithLimitedLocks() {
             unspoolWriteIntents(); // in case we were doing some writing ourself (likely impossible with limitedlocks version)
-            AlignedBuilder &ab = __theBuilder;
 
             verify( ! Lock::isLocked() );
 
@@ -577,6 +674,8 @@ namespace mongo {
                 return true;
             }
 
+            // the other builder may still be being written to the data files
+            AlignedBuilder &ab = nextBuilder();
             JSectHeader h;
             PREPLOGBUFFER(h,ab); // need to be in readlock (writes excluded) for this
 
@@ -598,13 +697,15 @@ namespace mongo {
             // (ok to crash after that)
             commitJob.committingNotifyCommitted();
 
-            // note the higher-up-the-chain locking of filesLockedFsync is important here, 
-            // as we are not in Lock::GlobalRead anymore. private view readers won't see 
-            // anything as we do this, but external viewers of the datafiles will see them 
-            // mutating.
-            WRITETODATAFILES(h, ab);
-            verify( abLen == ab.len() ); // check again wasn't modded
-            ab.reset();
+            // the previous group has to be in the data files before this one is applied 
+            // over it.  then let the DataFileWriter apply this one while we go on to prepare 
+            // and journal the next.  note the higher-up-the-chain locking of filesLockedFsync 
+            // is important here, as we are not in Lock::GlobalRead anymore. private view 
+            // readers won't see anything as that happens, but external viewers of the 
+            // datafiles will see them mutating.  (an fsync lock waits for the DataFileWriter 
+            // in syncDataAndTruncateJournal.)
+            dataFileWriter.wait();
+            dataFileWriter.start(h, &ab);
 
             // can't : d.dbMutex._remapPrivateViewRequested = true;
             // (writes have happened we released)
@@ -645,12 +746,15 @@ namespace mongo {
             unspoolWriteIntents(); // in case we were doing some writing ourself
 
             {
-                AlignedBuilder &ab = __theBuilder;
-
                 // we need to make sure two group commits aren't running at the same time
                 // (and we are only read locked in the dbMutex, so it could happen)
                 SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
 
+                // a group from groupCommitWithLimitedLocks may still be going to the data 
+                // files; it must be there before we write over it or remap
+                dataFileWriter.wait();
+                AlignedBuilder &ab = nextBuilder();
+
                 commitJob.commitingBegin();
 
                 if( !commitJob.hasWritten() ) {
@@ -786,6 +890,10 @@ namespace mongo {
         extern int groupCommitIntervalMs;
         boost::filesystem::path getJournalDir();
 
+        // getLastError j:true waiters for which the journal is committed at once rather than at
+        // the end of the commit interval's first third
+        MONGO_EXPORT_SERVER_PARAMETER(journalCommitWaiters, int, 1);
+
         void durThread() {
             Client::initThread("journal");
 
@@ -808,20 +916,20 @@ namespace mongo {
                 }
 
                 unsigned oneThird = (ms / 3) + 1; // +1 so never zero
+                unsigned minWaiters = std::max(journalCommitWaiters, 1);
 
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
-                            break;
-                        if( commitJob.bytes() > UncommittedBytesLimit / 2  )
-                            break;
-                        sleepmillis(oneThird);
-                    }
-                                        
+                    // commit at once when enough getLastError j:true are pending or a lot has been
+                    // written; otherwise commit after a third of the interval if any j:true is
+                    // pending
+                    unsigned waiters = commitJob.waitForCommitRequest(oneThird, minWaiters);
+                    if( waiters == 0 && commitJob.bytes() <= UncommittedBytesLimit / 2 )
+                        waiters = commitJob.waitForCommitRequest(ms - oneThird, minWaiters);
+                    if( waiters >= minWaiters || commitJob.bytes() > UncommittedBytesLimit / 2 )
+                        stats.curr->_earlyCommits++;
+
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
 
                     durThreadGroupCommit();
@@ -831,6 +939,7 @@ namespace mongo {
                     mongoAbort("exception in durThread");
                 }
             }
+            dataFileWriter.wait();
             cc().shutdown();
         }
 
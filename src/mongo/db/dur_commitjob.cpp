@@ -33,6 +33,7 @@
 #include "mongo/db/dur_commitjob.h"
 
 #include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/dur_stats.h"
 #include "mongo/db/taskqueue.h"
 #include "mongo/util/concurrency/threadlocal.h"
@@ -46,66 +47,97 @@ namespace mongo {
 
     namespace dur {
 
+        /** the arenas of all threads, and the intents of threads which exited before their
+            intents were harvested.  locked after groupCommitMutex.
+        */
+        static SimpleMutex threadIntentsMutex("threadIntents");
+        static std::set<ThreadLocalIntents*> threadIntents;
+        static vector<WriteIntent> orphanedIntents;
+
+        ThreadLocalIntents::ThreadLocalIntents() :
+            _nChunksUsed(0), _nInLast(0), _lastPage(0), _bytes(0) { 
+            SimpleMutex::scoped_lock lk(threadIntentsMutex);
+            threadIntents.insert(this);
+        }
+
         ThreadLocalIntents::~ThreadLocalIntents() {
-            fassert( 16731, intents.size() == 0 );
+            {
+                SimpleMutex::scoped_lock lk(threadIntentsMutex);
+                threadIntents.erase(this);
+                // our writes may not have been committed yet
+                harvest(orphanedIntents);
+            }
+            unspool();
+            for( unsigned i = 0; i < _chunks.size(); i++ )
+                delete _chunks[i];
         }
 
         void ThreadLocalIntents::push(const WriteIntent& x) {
             if( !commitJob._hasWritten )
                 commitJob._hasWritten = true;
 
-            if( intents.size() == N ) {
-                if ( !condense() ) {
-                    unspool();
-                }
+            if( _alreadyNoted.checkAndSet(x.start(), x.length()) )
+                return;
+
+            if( _nChunksUsed == 0 || _nInLast == ChunkSize ) {
+                if( _nChunksUsed == _chunks.size() )
+                    _chunks.push_back(new Chunk());
+                _nChunksUsed++;
+                _nInLast = 0;
             }
+            _chunks[_nChunksUsed-1]->intents[_nInLast++] = x;
 
-            intents.push_back( x );
+            // a bit over conservative in counting pagebytes used
+            size_t page = ((size_t) x.start()) & ~0xfff; // round off to page address (4KB)
+            if( page != _lastPage ) {
+                _lastPage = page;
+                _bytes += (x.length()+4095) & ~0xfff;
+            }
 #if( CHECK_SPOOLING )
             nSpooled++;
 #endif
         }
-        void ThreadLocalIntents::_unspool() {
-            if ( intents.size() == 0 )
-                return;
 
-            for( unsigned j = 0; j < intents.size(); j++ ) {
-                commitJob.note(intents[j].start(), intents[j].length());
+        void ThreadLocalIntents::unspool() {
+            if( _bytes ) {
+                commitJob.noteBytes(_bytes);
+                _bytes = 0;
             }
-
-#if( CHECK_SPOOLING )
-            nSpooled.signedAdd( -1 * static_cast<int>(intents.size()) );
-#endif
-
-            intents.clear();
         }
 
-        bool ThreadLocalIntents::condense() {
-            std::sort( intents.begin(), intents.end() );
+        void ThreadLocalIntents::harvest(vector<WriteIntent>& v) {
+            if( _nChunksUsed == 0 )
+                return;
 
-            bool didAnything = false;
+            unsigned n = n_informational();
+            v.reserve(v.size() + n);
+            for( unsigned i = 0; i + 1 < _nChunksUsed; i++ )
+                v.insert(v.end(), _chunks[i]->intents, _chunks[i]->intents + ChunkSize);
+            Chunk* last = _chunks[_nChunksUsed-1];
+            v.insert(v.end(), last->intents, last->intents + _nInLast);
 
-            for ( unsigned x = 0; x < intents.size() - 1 ; x++ ) {
-                if ( intents[x].overlaps( intents[x+1] ) ) {
-                    intents[x].absorb( intents[x+1] );
-                    intents.erase( intents.begin() + x + 1 );
-                    x--;
-                    didAnything = true;
 #if( CHECK_SPOOLING )
-                    nSpooled.signedAdd(-1);
+            nSpooled.signedAdd( -1 * static_cast<int>(n) );
 #endif
-                }
-            }
 
-            return didAnything;
+            // after a burst of writing don't hold on to more memory than we usually need
+            while( _chunks.size() > KeepChunks ) {
+                delete _chunks.back();
+                _chunks.pop_back();
+            }
+            _nChunksUsed = 0;
+            _nInLast = 0;
+            _alreadyNoted.clear();
+            // these bytes are in the commit harvesting us
+            _bytes = 0;
         }
 
-        void ThreadLocalIntents::unspool() {
-            if ( intents.size() ) {
-                SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
-                _unspool();
-            }
+        unsigned ThreadLocalIntents::n_informational() const {
+            if( _nChunksUsed == 0 )
+                return 0;
+            return (_nChunksUsed - 1) * ChunkSize + _nInLast;
         }
+
         AtomicUInt ThreadLocalIntents::nSpooled;
     }
 
@@ -134,9 +166,12 @@ namespace mongo {
         }
 
         /** base declare write intent function that all the helpers call. */
-        /** we batch up our write intents so that we do not have to synchronize too often */
+        /** intents go to a per-thread arena so that writers do not synchronize with each other */
         void DurableImpl::declareWriteIntent(void *p, unsigned len) {
-            cc().writeHappened();
+            Client& c = cc();
+            c.writeHappened();
+            if ( c.curop() )
+                c.curop()->debug().journalBytes += len;
             MemoryMappedFile::makeWritable(p, len);
             ThreadLocalIntents *t = tlIntents.getMake();
             t->push(WriteIntent(p,len));
@@ -158,7 +193,6 @@ namespace mongo {
         void IntentsAndDurOps::clear() {
             assertLockedForCommitting();
             commitJob.groupCommitMutex.dassertLocked();
-            _alreadyNoted.clear();
             _intents.clear();
             _durOps.clear();
 #if defined(DEBUG_WRITE_INTENT)
@@ -191,15 +225,54 @@ namespace mongo {
 
         void CommitJob::commitingBegin() { 
             assertLockedForCommitting();
-            _commitNumber = _notify.now();
+            {
+                boost::mutex::scoped_lock lk(_commitRequestMutex);
+                _commitNumber = _notify.now();
+                _nCommitWaiters = 0;
+                _bytesCommitRequested = false;
+            }
+            _harvestThreadIntents();
             stats.curr->_commits++;
         }
 
+        void CommitJob::_harvestThreadIntents() {
+            groupCommitMutex.dassertLocked();
+            vector<WriteIntent>& v = _intentsAndDurOps._intents;
+            SimpleMutex::scoped_lock lk(threadIntentsMutex);
+            v.insert(v.end(), orphanedIntents.begin(), orphanedIntents.end());
+            orphanedIntents.clear();
+            for( std::set<ThreadLocalIntents*>::iterator i = threadIntents.begin(); i != threadIntents.end(); i++ )
+                (*i)->harvest(v);
+            wassert( v.size() < 2000000 );
+        }
+
+        void CommitJob::awaitCommit() {
+            NotifyAll::When when;
+            {
+                boost::mutex::scoped_lock lk(_commitRequestMutex);
+                // a commit begun before this point might not include our writes
+                when = _notify.now();
+                _nCommitWaiters++;
+            }
+            _commitRequested.notify_one();
+            _notify.waitFor(when);
+        }
+
+        unsigned CommitJob::waitForCommitRequest(unsigned ms, unsigned minWaiters) {
+            boost::mutex::scoped_lock lk(_commitRequestMutex);
+            boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(ms);
+            while( _nCommitWaiters < minWaiters && !_bytesCommitRequested ) {
+                if( !_commitRequested.timed_wait(lk, deadline) )
+                    break;
+            }
+            return _nCommitWaiters;
+        }
+
         void CommitJob::_committingReset() {
             _hasWritten = false;
             _intentsAndDurOps.clear();
-            privateMapBytes += _bytes;
-            _bytes = 0;
+            privateMapBytes += _bytes.load();
+            _bytes.store(0);
             _nSinceCommitIfNeededCall = 0;
         }
 
@@ -208,82 +281,45 @@ namespace mongo {
             _hasWritten(false)
         { 
             _commitNumber = 0;
-            _bytes = 0;
+            _nCommitWaiters = 0;
+            _bytesCommitRequested = false;
             _nSinceCommitIfNeededCall = 0;
         }
 
-        void CommitJob::note(void* p, int len) {
-            groupCommitMutex.dassertLocked();
-
+        void CommitJob::noteBytes(size_t b) {
             dassert( _hasWritten );
 
-            // from the point of view of the dur module, it would be fine (i think) to only
-            // be read locked here.  but must be at least read locked to avoid race with
-            // remapprivateview
-
-            if( !_intentsAndDurOps._alreadyNoted.checkAndSet(p, len) ) {
-
-                /** tips for debugging:
-                        if you have an incorrect diff between data files in different folders
-                        (see jstests/dur/quick.js for example),
-                        turn this on and see what is logged.  if you have a copy of its output from before the
-                        regression, a simple diff of these lines would tell you a lot likely.
-                */
-#if 0 && defined(_DEBUG)
+            size_t bytes = _bytes.fetchAndAdd(b) + b;
+            if( bytes > UncommittedBytesLimit / 2 && !_bytesCommitRequested ) {
+                // no need to wait for the durThread's next round
                 {
-                    static int n;
-                    if( ++n < 10000 ) {
-                        size_t ofs;
-                        DurableMappedFile *mmf = privateViews._find(w.p, ofs);
-                        if( mmf ) {
-                            log() << "DEBUG note write intent " << w.p << ' ' << mmf->filename() << " ofs:" << hex << ofs << " len:" << w.len << endl;
-                        }
-                        else {
-                            log() << "DEBUG note write intent " << w.p << ' ' << w.len << " NOT FOUND IN privateViews" << endl;
-                        }
-                    }
-                    else if( n == 10000 ) {
-                        log() << "DEBUG stopping write intent logging, too much to log" << endl;
-                    }
+                    boost::mutex::scoped_lock lk(_commitRequestMutex);
+                    _bytesCommitRequested = true;
                 }
-#endif
-
-                // remember intent. we will journal it in a bit
-                _intentsAndDurOps.insertWriteIntent(p, len);
-
-                {
-                    // a bit over conservative in counting pagebytes used
-                    static size_t lastPos; // note this doesn't reset with each commit, but that is ok we aren't being that precise
-                    size_t x = ((size_t) p) & ~0xfff; // round off to page address (4KB)
-                    if( x != lastPos ) { 
-                        lastPos = x;
-                        unsigned b = (len+4095) & ~0xfff;
-                        _bytes += b;
+                _commitRequested.notify_one();
+            }
 #if defined(_DEBUG)
-                        _nSinceCommitIfNeededCall++;
-                        if( _nSinceCommitIfNeededCall >= 80 ) {
-                            if( _nSinceCommitIfNeededCall % 40 == 0 ) {
-                                log() << "debug nsincecommitifneeded:" << _nSinceCommitIfNeededCall << " bytes:" << _bytes << endl;
-                                if( _nSinceCommitIfNeededCall == 240 || _nSinceCommitIfNeededCall == 1200 ) {
-                                    log() << "_DEBUG printing stack given high nsinccommitifneeded number" << endl;
-                                    printStackTrace();
-                                }
-                            }
-                        }
+            _nSinceCommitIfNeededCall++;
+            if( _nSinceCommitIfNeededCall >= 80 ) {
+                if( _nSinceCommitIfNeededCall % 40 == 0 ) {
+                    log() << "debug nsincecommitifneeded:" << _nSinceCommitIfNeededCall << " bytes:" << bytes << endl;
+                    if( _nSinceCommitIfNeededCall == 240 || _nSinceCommitIfNeededCall == 1200 ) {
+                        log() << "_DEBUG printing stack given high nsinccommitifneeded number" << endl;
+                        printStackTrace();
+                    }
+                }
+            }
 #endif
-                        if (_bytes > UncommittedBytesLimit * 3) {
-                            static time_t lastComplain;
-                            static unsigned nComplains;
-                            // throttle logging
-                            if( ++nComplains < 100 || time(0) - lastComplain >= 60 ) {
-                                lastComplain = time(0);
-                                warning() << "DR102 too much data written uncommitted " << _bytes/1000000.0 << "MB" << endl;
-                                if( nComplains < 10 || nComplains % 10 == 0 ) {
-                                    // wassert makes getLastError show an error, so we just print stack trace
-                                    printStackTrace();
-                                }
-                            }
-                        }
+            if (bytes > UncommittedBytesLimit * 3) {
+                static time_t lastComplain;
+                static unsigned nComplains;
+                // throttle logging
+                if( ++nComplains < 100 || time(0) - lastComplain >= 60 ) {
+                    lastComplain = time(0);
+                    warning() << "DR102 too much data written uncommitted " << bytes/1000000.0 << "MB" << endl;
+                    if( nComplains < 10 || nComplains % 10 == 0 ) {
+                        // wassert makes getLastError show an error, so we just print stack trace
+                        printStackTrace();
                     }
                 }
             }
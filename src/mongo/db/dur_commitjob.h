@@ -30,10 +30,14 @@
 
 #pragma once
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/durop.h"
 #include "mongo/db/taskqueue.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/mongoutils/hash.h"
@@ -101,33 +105,40 @@ namespace mongo {
         class IntentsAndDurOps : boost::noncopyable {
         public:
             vector<WriteIntent> _intents;
-            Already<127> _alreadyNoted;
             vector< shared_ptr<DurOp> > _durOps; // all the ops other than basic writes
 
             /** reset the IntentsAndDurOps structure (empties all the above) */
             void clear();
 
-            void insertWriteIntent(void* p, int len) {
-                _intents.push_back(WriteIntent(p,len));
-                wassert( _intents.size() < 2000000 );
-            }
             #if defined(DEBUG_WRITE_INTENT)
             map<void*,int> _debug;
             #endif
         };
 
-        /** so we don't have to lock the groupCommitMutex too often */
-        class ThreadLocalIntents {
-            enum { N = 21 };
-            std::vector<dur::WriteIntent> intents;
-            bool condense();
+        /** each writing thread appends its write intents to a chunked arena of its own, without
+            locking.  the arenas are harvested into the CommitJob at commit time, when writers are
+            excluded by the committer's R or W lock.
+        */
+        class ThreadLocalIntents : boost::noncopyable {
+            enum { ChunkSize = 1024, KeepChunks = 4 };
+            struct Chunk {
+                WriteIntent intents[ChunkSize];
+            };
+            std::vector<Chunk*> _chunks; // chunks past _nChunksUsed are kept for reuse
+            unsigned _nChunksUsed;
+            unsigned _nInLast;           // intents in _chunks[_nChunksUsed-1]
+            Already<127> _alreadyNoted;
+            size_t _lastPage;
+            size_t _bytes;               // not yet added to commitJob.bytes()
         public:
-            ThreadLocalIntents() : intents(N) { intents.clear(); }
+            ThreadLocalIntents();
             ~ThreadLocalIntents();
-            void _unspool();
-            void unspool();
             void push(const WriteIntent& i);
-            int n_informational() const { return intents.size(); }
+            /** adds what we wrote to commitJob.bytes().  called as we release a write lock. */
+            void unspool();
+            /** moves our intents to v and empties the arena.  writers must be excluded. */
+            void harvest(vector<WriteIntent>& v);
+            unsigned n_informational() const;
             static AtomicUInt nSpooled;
         };
 
@@ -141,8 +152,11 @@ namespace mongo {
             void _committingReset();
             ~CommitJob(){ verify(!"shouldn't destroy CommitJob!"); }
 
-            /** record/note an intent to write */
-            void note(void* p, int len);
+            /** moves the intents of every thread to _intentsAndDurOps */
+            void _harvestThreadIntents();
+
+            /** account for bytes written by a thread */
+            void noteBytes(size_t b);
             // only called by : 
             friend class ThreadLocalIntents;
 
@@ -180,7 +194,18 @@ namespace mongo {
 
         public:
             /** we check how much written and if it is getting to be a lot, we commit sooner. */
-            size_t bytes() const { return _bytes; }
+            size_t bytes() const { return _bytes.load(); }
+
+            /** waits until what was written so far is in the journal, asking for an early commit.
+                for getlasterror j:true.  threadsafe.
+            */
+            void awaitCommit();
+
+            /** for the durThread: waits up to ms milliseconds for minWaiters awaitCommit() callers
+                or for half of UncommittedBytesLimit to be written.
+                @return the number of awaitCommit() callers the next commit will release
+            */
+            unsigned waitForCommitRequest(unsigned ms, unsigned minWaiters);
 
             /** used in prepbasicwrites. sorted so that overlapping and duplicate items 
              * can be merged.  we sort here so the caller receives something they must 
@@ -196,7 +221,14 @@ namespace mongo {
         private:
             NotifyAll::When _commitNumber;
             IntentsAndDurOps _intentsAndDurOps;
-            size_t _bytes;
+            AtomicUInt64 _bytes;
+
+            // awaitCommit() callers register here.  the count is reset when a commit begins, which
+            // releases all of them.
+            boost::mutex _commitRequestMutex;
+            boost::condition_variable _commitRequested;
+            unsigned _nCommitWaiters;
+            bool _bytesCommitRequested;
         public:
             NotifyAll _notify;                  // for getlasterror fsync:true acknowledgements
             unsigned _nSinceCommitIfNeededCall; // for asserts and debugging
@@ -190,6 +190,8 @@ namespace mongo {
             _preFlushTime = 0;
             _lastFlushTime = 0;
             _writeToLSNNeeded = false;
+            _pins = 0;
+            _truncatedWhilePinned = false;
         }
 
         boost::filesystem::path Journal::getFilePathFor(int filenumber) const {
@@ -272,6 +274,10 @@ namespace mongo {
                 log() << "journalCleanup..." << endl;
             try {
                 SimpleMutex::scoped_lock lk(_curLogFileMutex);
+                // the data files are synced first, so this is still safe for us, but not for a
+                // copy of them a pin is being held for
+                if( _pins )
+                    _truncatedWhilePinned = true;
                 closeCurrentJournalFile();
                 removeJournalFiles();
             }
@@ -282,6 +288,22 @@ namespace mongo {
         }
         void journalCleanup(bool log) { j.cleanup(log); }
 
+        void Journal::pin() {
+            SimpleMutex::scoped_lock lk(_curLogFileMutex);
+            if( _pins++ == 0 )
+                _truncatedWhilePinned = false;
+        }
+
+        bool Journal::unpin() {
+            SimpleMutex::scoped_lock lk(_curLogFileMutex);
+            verify( _pins > 0 );
+            _pins--;
+            return !_truncatedWhilePinned;
+        }
+
+        void journalPin() { j.pin(); }
+        bool journalUnpin() { return j.unpin(); }
+
         bool _preallocateIsFaster() {
             bool faster = false;
             boost::filesystem::path p = getJournalDir() / "tempLatencyTest";
@@ -639,6 +661,9 @@ namespace mongo {
         }
 
         void Journal::preFlush() {
+            // what has been journaled must be in the files we are about to flush before the 
+            // lsn may move past it
+            waitForDataFileWrites();
             j._preFlushTime = Listener::getElapsedTimeMillis();
         }
 
@@ -666,6 +691,9 @@ namespace mongo {
             be in _curLogFileMutex but not dbMutex when calling
         */
         void Journal::removeUnneededJournalFiles() {
+            if( _pins )
+                return;
+
             while( !_oldJournalFiles.empty() ) {
                 JFile f = _oldJournalFiles.front();
 
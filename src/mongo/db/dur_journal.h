@@ -66,6 +66,20 @@ namespace mongo {
 
         unsigned long long getLastDataFileFlushTime();
 
+        /** keep every journal file until unpinned, so that data files copied meanwhile can be
+            brought up to date by replaying them.  pins nest.
+        */
+        void journalPin();
+
+        /** @return false if the journal was truncated while pinned (see journalCleanup()), in
+            which case files the pin was meant to keep may be gone
+        */
+        bool journalUnpin();
+
+        /** wait until the last group commit has been applied to the data files (they are 
+            written on a thread of their own while the next group is journaled) */
+        void waitForDataFileWrites();
+
         /** never throws.
             @param anyFiles by default we only look at j._* files. If anyFiles is true, return true
                    if there are any files in the journal directory. acquirePathLock() uses this to
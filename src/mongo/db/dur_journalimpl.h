@@ -73,6 +73,9 @@ namespace mongo {
             /** open a journal file to journal operations to. */
             void open();
 
+            void pin();
+            bool unpin();
+
         private:
             /** check if time to rotate files.  assure a file is open.
              *  internally called with every commit
@@ -100,6 +103,9 @@ namespace mongo {
             // ordered oldest to newest
             list<JFile> _oldJournalFiles; // use _curLogFileMutex
 
+            unsigned _pins; // while nonzero no old journal file is removed; use _curLogFileMutex
+            bool _truncatedWhilePinned; // use _curLogFileMutex
+
             // lsn related
             static void preFlush();
             static void postFlush();
@@ -33,6 +33,8 @@
 #include "mongo/db/dur_recover.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -48,12 +50,14 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
@@ -196,6 +200,93 @@ namespace mongo {
 
         };
 
+        // threads applying the journal at startup.  1 applies it on the starting thread only.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalRecoveryThreads, int, 4);
+
+        /** asserts that footer 'f' matches the section at 'h' with 'len' bytes after its header */
+        static void checkSectionHash(const JSectHeader *h, unsigned len, const JSectFooter *f) {
+            if( !f->checkHash(h, len + sizeof(JSectHeader)) ) {
+                msgasserted(13594, "journal checksum doesn't match");
+            }
+        }
+
+        /** sections decompressed and checksummed ahead of the one being applied */
+        static const size_t PrepareAhead = 4;
+
+        /** a journal section decompressed, parsed and checksummed by a _prep thread */
+        struct PreparedSection : boost::noncopyable {
+            PreparedSection(const JSectHeader *h, const void *data, unsigned len, const JSectFooter *f) :
+                h(h), data(data), len(len), f(f), eof(false), errCode(0), _ready(false) { }
+
+            const JSectHeader *h;
+            const void *data;
+            unsigned len;
+            const JSectFooter *f;
+
+            auto_ptr<JournalSectionIterator> i; // owns the uncompressed data entries point into
+            vector<ParsedJournalEntry> entries;
+
+            // what went wrong preparing, thrown again when the section is applied
+            bool eof;
+            int errCode;
+            string errMsg;
+
+            void prepare(unsigned long long lastDataSyncedFromLastRun);
+
+            void waitReady() {
+                boost::mutex::scoped_lock lk(_m);
+                while( !_ready )
+                    _c.wait(lk);
+            }
+        private:
+            boost::mutex _m;
+            boost::condition_variable _c;
+            bool _ready;
+        };
+
+        void PreparedSection::prepare(unsigned long long lastDataSyncedFromLastRun) {
+            try {
+                // no need to decompress what skipSection() will skip
+                if( lastDataSyncedFromLastRun <= h->seqNumber + ExtraKeepTimeMs ) {
+                    i.reset(new JournalSectionIterator(*h, data, len, true));
+                    while( !i->atEof() ) {
+                        ParsedJournalEntry e;
+                        i->next(e);
+                        entries.push_back(e);
+                    }
+                    checkSectionHash(h, len, f);
+                }
+            }
+            catch( BufReader::eof& ) {
+                eof = true;
+            }
+            catch( DBException& e ) {
+                errCode = e.getCode();
+                errMsg = e.what();
+            }
+            catch( std::exception& e ) {
+                errCode = 17194;
+                errMsg = e.what();
+            }
+
+            boost::mutex::scoped_lock lk(_m);
+            _ready = true;
+            _c.notify_all();
+        }
+
+        static void prepareSection(boost::shared_ptr<PreparedSection> s, unsigned long long lastDataSyncedFromLastRun) {
+            s->prepare(lastDataSyncedFromLastRun);
+        }
+
+        /** applies basic writes to one file, in journal order */
+        static void applyWritesToFile(DurableMappedFile *mmf, const vector<const ParsedJournalEntry*> *writes) {
+            char *view = (char *) mmf->view_write();
+            for( vector<const ParsedJournalEntry*>::const_iterator i = writes->begin(); i != writes->end(); ++i ) {
+                const JEntry *e = (*i)->e;
+                memcpy(view + e->ofs, e->srcData(), e->len);
+            }
+        }
+
         static string fileName(const char* dbName, int fileNo) {
             stringstream ss;
             ss << dbName << '.';
@@ -357,19 +448,66 @@ namespace mongo {
                 log() << "BEGIN section" << endl;
 
             Last last;
-            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
-                applyEntry(last, *i, apply, dump);
+            if( apply && !dump && _writers ) {
+                applyEntriesInParallel(last, entries);
+            }
+            else {
+                for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                    applyEntry(last, *i, apply, dump);
+                }
             }
 
             if( dump )
                 log() << "END section" << endl;
         }
 
-        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
-            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
-            scoped_lock lk(_mx);
-            RACECHECK
+        /** writes to different files go to the _writers, each file's writes in journal order.
+            DurOps, which come first in a section, are applied on this thread between batches.
+        */
+        void RecoveryJob::applyEntriesInParallel(Last& last, const vector<ParsedJournalEntry> &entries) {
+            typedef map<DurableMappedFile*, vector<const ParsedJournalEntry*> > WritesByFile;
+            WritesByFile byFile;
+            unsigned long long bytes = 0;
+
+            vector<ParsedJournalEntry>::const_iterator i = entries.begin();
+            while( true ) {
+                for( ; i != entries.end() && i->e; ++i ) {
+                    verify(i->dbName);
+                    verify((size_t)strnlen(i->dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+                    DurableMappedFile *mmf = last.newEntry(*i, *this);
+                    if( i->e->ofs + i->e->len > mmf->length() ) {
+                        // as in write(), which allows this when recovering
+                        continue;
+                    }
+                    verify(mmf->view_write());
+                    verify(i->e->srcData());
+                    byFile[mmf].push_back(&*i);
+                    bytes += i->e->len;
+                }
 
+                if( byFile.size() == 1 ) {
+                    applyWritesToFile(byFile.begin()->first, &byFile.begin()->second);
+                }
+                else if( !byFile.empty() ) {
+                    for( WritesByFile::const_iterator f = byFile.begin(); f != byFile.end(); ++f )
+                        _writers->schedule(&applyWritesToFile, f->first, &f->second);
+                    _writers->join();
+                }
+                stats.curr->_writeToDataFilesBytes += bytes;
+                byFile.clear();
+                bytes = 0;
+
+                if( i == entries.end() )
+                    break;
+
+                applyEntry(last, *i, true, false);
+                // the op may have closed the files last refers to
+                last = Last();
+                ++i;
+            }
+        }
+
+        bool RecoveryJob::skipSection(const JSectHeader *h) {
             /** todo: we should really verify the checksum to see that seqNumber is ok?
                       that is expensive maybe there is some sort of checksum of just the header 
                       within the header itself
@@ -385,8 +523,18 @@ namespace mongo {
                     }
                     _lastSeqMentionedInConsoleLog = h->seqNumber;
                 }
-                return;
+                return true;
             }
+            return false;
+        }
+
+        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            RACECHECK
+
+            if( skipSection(h) )
+                return;
 
             auto_ptr<JournalSectionIterator> i;
             if( _recovering ) {
@@ -419,15 +567,46 @@ namespace mongo {
             // after the entries check the footer checksum
             if( _recovering ) {
                 verify( ((const char *)h) + sizeof(JSectHeader) == p );
-                if( !f->checkHash(h, len + sizeof(JSectHeader)) ) { 
-                    msgasserted(13594, "journal checksum doesn't match");
-                }
+                checkSectionHash(h, len, f);
             }
 
             // got all the entries for one group commit.  apply them:
             applyEntries(entries);
         }
 
+        void RecoveryJob::applyPrepared(std::deque< boost::shared_ptr<PreparedSection> >& inFlight, size_t keep) {
+            try {
+                while( inFlight.size() > keep ) {
+                    boost::shared_ptr<PreparedSection> s = inFlight.front();
+                    inFlight.pop_front();
+                    s->waitReady();
+
+                    LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+                    scoped_lock lk(_mx);
+                    RACECHECK
+
+                    if( skipSection(s->h) )
+                        continue;
+                    if( s->eof )
+                        throw BufReader::eof();
+                    if( s->errCode )
+                        msgasserted(s->errCode, s->errMsg);
+
+                    applyEntries(s->entries);
+
+                    // ctrl c check
+                    killCurrentOp.checkForInterrupt(false);
+                }
+            }
+            catch( ... ) {
+                // nothing after a bad section is applied, and the journal file is unmapped once
+                // the exception reaches processFile()
+                inFlight.clear();
+                _prep->join();
+                throw;
+            }
+        }
+
         /** apply a specific journal file, that is already mmap'd
             @param p start of the memory mapped file
             @return true if this is detected to be the last file (ends abruptly)
@@ -465,27 +644,48 @@ namespace mongo {
                     }
                 }
 
-                // read sections
-                while ( !br.atEof() ) {
-                    JSectHeader h;
-                    br.peek(h);
-                    if( h.fileId != fileId ) {
-                        if (debug || (storageGlobalParams.durOptions &
-                                      StorageGlobalParams::DurDumpJournal)) {
-                            log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
-                            log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
+                // read sections.  with _prep, the sections following the one being applied are
+                // decompressed and checksummed meanwhile.
+                std::deque< boost::shared_ptr<PreparedSection> > inFlight;
+                try {
+                    while ( !br.atEof() ) {
+                        JSectHeader h;
+                        br.peek(h);
+                        if( h.fileId != fileId ) {
+                            if (debug || (storageGlobalParams.durOptions &
+                                          StorageGlobalParams::DurDumpJournal)) {
+                                log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
+                                log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
+                            }
+                            applyPrepared(inFlight, 0);
+                            return true;
+                        }
+                        unsigned slen = h.sectionLen();
+                        unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
+                        const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
+                        const char *data = hdr + sizeof(JSectHeader);
+                        const char *footer = data + dataLen;
+
+                        if( _prep ) {
+                            boost::shared_ptr<PreparedSection> s(
+                                new PreparedSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer));
+                            _prep->schedule(&prepareSection, s, _lastDataSyncedFromLastRun);
+                            inFlight.push_back(s);
+                            applyPrepared(inFlight, PrepareAhead);
+                            continue;
                         }
-                        return true;
-                    }
-                    unsigned slen = h.sectionLen();
-                    unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
-                    const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
-                    const char *data = hdr + sizeof(JSectHeader);
-                    const char *footer = data + dataLen;
-                    processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
 
-                    // ctrl c check
-                    killCurrentOp.checkForInterrupt(false);
+                        processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+
+                        // ctrl c check
+                        killCurrentOp.checkForInterrupt(false);
+                    }
+                    applyPrepared(inFlight, 0);
+                }
+                catch( BufReader::eof& ) {
+                    // the sections before the abrupt end still apply
+                    applyPrepared(inFlight, 0);
+                    throw;
                 }
             }
             catch( BufReader::eof& ) {
@@ -517,6 +717,11 @@ namespace mongo {
             return processFileBuffer(p, (unsigned) f.length());
         }
 
+        void RecoveryJob::stopThreads() {
+            _prep.reset();
+            _writers.reset();
+        }
+
         /** @param files all the j._0 style files we need to apply for recovery */
         void RecoveryJob::go(vector<boost::filesystem::path>& files) {
             log() << "recover begin" << endl;
@@ -527,6 +732,12 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+            if( journalRecoveryThreads > 1 ) {
+                _prep.reset(new ThreadPool(2));
+                _writers.reset(new ThreadPool(journalRecoveryThreads));
+            }
+            ON_BLOCK_EXIT_OBJ(*this, &RecoveryJob::stopThreads);
+
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
                 if( abruptEnd && i+1 < files.size() ) {
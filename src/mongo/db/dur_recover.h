@@ -31,10 +31,13 @@
 #pragma once
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <deque>
 #include <list>
 
 #include "mongo/db/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
@@ -42,6 +45,7 @@ namespace mongo {
 
     namespace dur {
         struct ParsedJournalEntry;
+        struct PreparedSection;
 
         /** call go() to execute a recovery from existing journal files.
          */
@@ -71,9 +75,14 @@ namespace mongo {
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const vector<ParsedJournalEntry> &entries);
+            void applyEntriesInParallel(Last& last, const vector<ParsedJournalEntry> &entries);
+            bool skipSection(const JSectHeader *h);
+            /** applies prepared sections from the front of inFlight until at most keep are left */
+            void applyPrepared(std::deque< boost::shared_ptr<PreparedSection> >& inFlight, size_t keep);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
+            void stopThreads();
             DurableMappedFile* getDurableMappedFile(const ParsedJournalEntry& entry);
 
             list<boost::shared_ptr<DurableMappedFile> > _mmfs;
@@ -85,6 +94,11 @@ namespace mongo {
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
 
+            // while recovering with journalRecoveryThreads > 1: _prep decompresses and checksums
+            // sections ahead of their application, _writers apply writes to different files
+            boost::scoped_ptr<ThreadPool> _prep;
+            boost::scoped_ptr<ThreadPool> _writers;
+
             static RecoveryJob &_instance;
         };
     }
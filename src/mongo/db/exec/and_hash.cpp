@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/and_hash.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -36,7 +38,13 @@ namespace mongo {
 
     AndHashStage::AndHashStage(WorkingSet* ws, const MatchExpression* filter)
         : _ws(ws), _filter(filter), _resultIterator(_dataMap.end()),
-          _shouldScanChildren(true), _currentChild(0) {}
+          _shouldScanChildren(true), _currentChild(0),
+          _maxMemUsage(kDefaultMaxMemUsageBytes), _memUsage(0) {}
+
+    AndHashStage::AndHashStage(WorkingSet* ws, const MatchExpression* filter, size_t maxMemUsage)
+        : _ws(ws), _filter(filter), _resultIterator(_dataMap.end()),
+          _shouldScanChildren(true), _currentChild(0),
+          _maxMemUsage(maxMemUsage), _memUsage(0) {}
 
     AndHashStage::~AndHashStage() {
         for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
@@ -77,6 +85,7 @@ namespace mongo {
         WorkingSetID idToReturn = returnedIt->second;
         _dataMap.erase(returnedIt);
         WorkingSetMember* member = _ws->get(idToReturn);
+        _memUsage -= memUsage(*member);
 
         // We should check for matching at the end so the matcher can use information in the
         // indices of all our children.
@@ -106,6 +115,16 @@ namespace mongo {
             verify(_dataMap.end() == _dataMap.find(member->loc));
 
             _dataMap[member->loc] = id;
+
+            _memUsage += memUsage(*member);
+            _specificStats.memUsage = std::max(_specificStats.memUsage, _memUsage);
+            if (_memUsage > _maxMemUsage) {
+                // The first child isn't selective enough for us to hold on to all of it.
+                _shouldScanChildren = false;
+                _resultIterator = _dataMap.end();
+                return PlanStage::FAILURE;
+            }
+
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
         }
@@ -153,7 +172,10 @@ namespace mongo {
                 // We have a hit.  Copy data into the WSM we already have.
                 _seenMap.insert(member->loc);
                 WorkingSetMember* olderMember = _ws->get(_dataMap[member->loc]);
+                _memUsage -= memUsage(*olderMember);
                 AndCommon::mergeFrom(olderMember, member);
+                _memUsage += memUsage(*olderMember);
+                _specificStats.memUsage = std::max(_specificStats.memUsage, _memUsage);
             }
             _ws->free(id);
             ++_commonStats.needTime;
@@ -169,7 +191,7 @@ namespace mongo {
                 if (_seenMap.end() == _seenMap.find(it->first)) {
                     DataMap::iterator toErase = it;
                     ++it;
-                    _ws->free(toErase->second);
+                    freeHashed(toErase->second);
                     _dataMap.erase(toErase);
                 }
                 else { ++it; }
@@ -254,6 +276,9 @@ namespace mongo {
                 ++_specificStats.flaggedButPassed;
             }
 
+            // The member is leaving the hash table.
+            _memUsage -= memUsage(*member);
+
             // The loc is about to be invalidated.  Fetch it and clear the loc.
             WorkingSetCommon::fetchAndInvalidateLoc(member);
 
@@ -263,8 +288,27 @@ namespace mongo {
         }
     }
 
+    // static
+    size_t AndHashStage::memUsage(const WorkingSetMember& member) {
+        size_t usage = sizeof(WorkingSetMember) + sizeof(DataMap::value_type);
+        // The key patterns and any unowned object belong to someone else.
+        for (size_t i = 0; i < member.keyData.size(); ++i) {
+            usage += sizeof(IndexKeyDatum) + member.keyData[i].keyData.objsize();
+        }
+        if (member.hasOwnedObj()) {
+            usage += member.obj.objsize();
+        }
+        return usage;
+    }
+
+    void AndHashStage::freeHashed(WorkingSetID id) {
+        _memUsage -= memUsage(*_ws->get(id));
+        _ws->free(id);
+    }
+
     PlanStageStats* AndHashStage::getStats() {
         _commonStats.isEOF = isEOF();
+        _specificStats.memLimit = _maxMemUsage;
 
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_AND_HASH));
         ret->specific.reset(new AndHashStats(_specificStats));
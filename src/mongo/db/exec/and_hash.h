@@ -49,10 +49,14 @@ namespace mongo {
      * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
      * operates with DiskLocs, we are unable to evaluate the AND for the invalidated DiskLoc, and it
      * must be fully matched later.
+     *
+     * The hash table is limited to 'maxMemUsage' bytes.  If the first child produces more than
+     * that the stage fails, and the plan should lose to one that doesn't intersect.
      */
     class AndHashStage : public PlanStage {
     public:
         AndHashStage(WorkingSet* ws, const MatchExpression* filter);
+        AndHashStage(WorkingSet* ws, const MatchExpression* filter, size_t maxMemUsage);
         virtual ~AndHashStage();
 
         void addChild(PlanStage* child);
@@ -66,10 +70,23 @@ namespace mongo {
 
         virtual PlanStageStats* getStats();
 
+        // The hash table limit used unless one is provided.
+        static const size_t kDefaultMaxMemUsageBytes = 32 * 1024 * 1024;
+
     private:
         StageState readFirstChild(WorkingSetID* out);
         StageState hashOtherChildren(WorkingSetID* out);
 
+        /**
+         * How many bytes does the hash table spend on 'member'?
+         */
+        static size_t memUsage(const WorkingSetMember& member);
+
+        /**
+         * Frees the hashed member 'id', which is no longer referenced by _dataMap.
+         */
+        void freeHashed(WorkingSetID id);
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -96,6 +113,10 @@ namespace mongo {
         // Which child are we currently working on?
         size_t _currentChild;
 
+        // How many bytes the members in _dataMap may take up, and how many they do.
+        size_t _maxMemUsage;
+        size_t _memUsage;
+
         // Stats
         CommonStats _commonStats;
         AndHashStats _specificStats;
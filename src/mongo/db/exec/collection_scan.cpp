@@ -30,20 +30,36 @@
 
 #include "mongo/db/database.h"
 #include "mongo/db/exec/collection_scan_common.h"
-#include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/extent.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/db/structure/collection_iterator.h"
 
 #include "mongo/db/client.h" // XXX-ERH
 #include "mongo/db/pdfile.h" // XXX-ERH/ACM
+#include "mongo/util/mmap.h"
 
 namespace mongo {
 
+    // How many extents ahead a collection scan asks the OS to read in, unless the query says.
+    MONGO_EXPORT_SERVER_PARAMETER(collectionScanPrefetchExtents, int, 0);
+
+    namespace {
+        // Large extents are only prefetched in part, which is plenty to get the reads going.
+        const unsigned MaxPrefetchBytesPerExtent = 16 * 1024 * 1024;
+    }
+
     CollectionScan::CollectionScan(const CollectionScanParams& params,
                                    WorkingSet* workingSet,
                                    const MatchExpression* filter)
-        : _workingSet(workingSet), _filter(filter), _params(params), _nsDropped(false) { }
+        : _workingSet(workingSet), _filter(filter), _params(params), _nsDropped(false) {
+        _prefetchExtents = params.prefetchExtents >= 0 ? params.prefetchExtents
+                                                       : collectionScanPrefetchExtents;
+        if (NULL != _filter) {
+            _compiledFilter.reset(new CompiledMatchExpression(_filter));
+        }
+    }
 
     PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
         ++_commonStats.works;
@@ -56,9 +72,15 @@ namespace mongo {
                 return PlanStage::IS_EOF;
             }
 
-            _iter.reset( collection->getIterator( _params.start,
-                                                  _params.tailable,
-                                                  _params.direction ) );
+            if ( _params.firstExtent.isNull() ) {
+                _iter.reset( collection->getIterator( _params.start,
+                                                      _params.tailable,
+                                                      _params.direction ) );
+            }
+            else {
+                _iter.reset( collection->getExtentRangeIterator( _params.firstExtent,
+                                                                 _params.lastExtent ) );
+            }
 
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
@@ -84,13 +106,18 @@ namespace mongo {
             nextLoc = _iter->getNext();
         }
 
+        if (_prefetchExtents > 0) {
+            prefetchAhead(nextLoc);
+        }
+
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
         member->loc = nextLoc;
         member->obj = member->loc.obj();
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
 
-        if (Filter::passes(member, _filter)) {
+        // The member holds the whole document, so the compiled filter can match it directly.
+        if (NULL == _compiledFilter || _compiledFilter->matchesBSON(member->obj)) {
             *out = id;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -102,6 +129,44 @@ namespace mongo {
         }
     }
 
+    void CollectionScan::prefetchAhead(const DiskLoc& loc) {
+        DiskLoc extentLoc(loc.a(), loc.rec()->extentOfs());
+        if (extentLoc == _currentExtent) {
+            return;
+        }
+        _currentExtent = extentLoc;
+
+        // The extents between this one and _prefetchedThrough were prefetched when the scan
+        // entered the extents before.  If _prefetchedThrough is not among the next ones, all of
+        // them are new: the scan skipped past it (e.g. over empty extents) or just started.
+        vector<Extent*> ahead;
+        size_t firstNew = 0;
+        Extent* e = extentLoc.ext();
+        for (int i = 0; i < _prefetchExtents; i++) {
+            if (!_params.lastExtent.isNull() && e->myLoc == _params.lastExtent) {
+                break;
+            }
+            e = CollectionScanParams::FORWARD == _params.direction ? e->getNextExtent()
+                                                                    : e->getPrevExtent();
+            if (NULL == e) {
+                break;
+            }
+            ahead.push_back(e);
+            if (e->myLoc == _prefetchedThrough) {
+                firstNew = ahead.size();
+            }
+        }
+
+        for (size_t i = firstNew; i < ahead.size(); i++) {
+            unsigned len = std::min(static_cast<unsigned>(ahead[i]->length),
+                                    MaxPrefetchBytesPerExtent);
+            MAdvise::willNeed(ahead[i], len);
+            ++_specificStats.extentsPrefetched;
+            _specificStats.bytesPrefetched += len;
+            _prefetchedThrough = ahead[i]->myLoc;
+        }
+    }
+
     bool CollectionScan::isEOF() {
         if (_nsDropped) { return true; }
         if (NULL == _iter) { return false; }
@@ -115,6 +180,11 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                                    WorkingSetID* fetchOut) {
+        return workBatchInline(this, maxWorks, out, fetchOut);
+    }
+
     void CollectionScan::prepareToYield() {
         ++_commonStats.yields;
         if (NULL != _iter) {
@@ -134,6 +204,7 @@ namespace mongo {
     PlanStageStats* CollectionScan::getStats() {
         _commonStats.isEOF = isEOF();
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COLLSCAN));
+        ret->specific.reset(new CollectionScanStats(_specificStats));
         return ret.release();
     }
 
@@ -32,6 +32,7 @@
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/structure/collection_iterator.h"
 
 namespace mongo {
@@ -50,6 +51,8 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                     WorkingSetID* fetchOut);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl);
@@ -59,12 +62,21 @@ namespace mongo {
         virtual PlanStageStats* getStats();
 
     private:
+        /**
+         * When the scan enters a new extent with loc, asks the OS to read in the extents up to
+         * _prefetchExtents ahead that it was not asked for yet.
+         */
+        void prefetchAhead(const DiskLoc& loc);
+
         // WorkingSet is not owned by us.
         WorkingSet* _workingSet;
 
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // A compiled form of _filter for matching each document we scan.  NULL if no filter.
+        scoped_ptr<CompiledMatchExpression> _compiledFilter;
+
         scoped_ptr<CollectionIterator> _iter;
 
         CollectionScanParams _params;
@@ -72,8 +84,15 @@ namespace mongo {
         // True if nsdetails(_ns) == NULL on our first call to work.
         bool _nsDropped;
 
+        // How many extents ahead to prefetch, the extent being scanned and the farthest one
+        // prefetched.
+        int _prefetchExtents;
+        DiskLoc _currentExtent;
+        DiskLoc _prefetchedThrough;
+
         // Stats
         CommonStats _commonStats;
+        CollectionScanStats _specificStats;
     };
 
 }  // namespace mongo
@@ -40,7 +40,8 @@ namespace mongo {
 
         CollectionScanParams() : start(DiskLoc()),
                                  direction(FORWARD),
-                                 tailable(false) { }
+                                 tailable(false),
+                                 prefetchExtents(-1) { }
 
         // What collection?
         string ns;
@@ -53,6 +54,16 @@ namespace mongo {
 
         // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
         bool tailable;
+
+        // If firstExtent is not isNull, only the records of the extents firstExtent through
+        // lastExtent (the collection's last extent if isNull) are scanned, forward.  Not for
+        // capped collections.  Ignores start.
+        DiskLoc firstExtent;
+        DiskLoc lastExtent;
+
+        // How many extents ahead of the one being scanned to ask the OS to read in.  -1 means the
+        // collectionScanPrefetchExtents server parameter, 0 leaves readahead to the OS.
+        int prefetchExtents;
     };
 
 }  // namespace mongo
@@ -51,6 +51,9 @@ namespace mongo {
             return false;
         }
 
+        // We still have results from our child's last batch.
+        if (!_pending.empty()) { return false; }
+
         return _child->isEOF();
     }
 
@@ -77,42 +80,20 @@ namespace mongo {
             return fetchCompleted(out);
         }
 
+        // Results left over from our child's last batch come before anything new.
+        if (!_pending.empty()) {
+            WorkingSetID id = _pending.front();
+            _pending.pop_front();
+            return fetchOrReturn(id, out);
+        }
+
         // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another to-be-fetched
         // result from our child.
         WorkingSetID id;
         StageState status = _child->work(&id);
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
-                return returnIfMatches(member, id, out);
-            }
-
-            // We need a valid loc to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::LOC_AND_IDX == member->state);
-            verify(member->hasLoc());
-
-            Record* record = member->loc.rec();
-            const char* data = record->dataNoThrowing();
-
-            if (!recordInMemory(data)) {
-                // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
-                verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
-                _idBeingPagedIn = id;
-                *out = id;
-                ++_commonStats.needFetch;
-                return PlanStage::NEED_FETCH;
-            }
-            else {
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = BSONObj(data);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-                return returnIfMatches(member, id, out);
-            }
+            return fetchOrReturn(id, out);
         }
         else {
             if (PlanStage::NEED_FETCH == status) {
@@ -126,6 +107,67 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                                WorkingSetID* fetchOut) {
+        // Finish a page-in and whatever was left of the last batch one result at a time.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn || !_pending.empty()) {
+            return PlanStage::workBatch(maxWorks, out, fetchOut);
+        }
+
+        ++_commonStats.works;
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        _childBatch.clear();
+        WorkingSetID childFetch = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(maxWorks, &_childBatch, &childFetch);
+
+        for (size_t i = 0; i < _childBatch.size(); ++i) {
+            if (PlanStage::NEED_FETCH == status && !_ws->get(_childBatch[i])->hasObj()) {
+                // Our child is already waiting on a fetch and we can only ask for one.  The rest
+                // of the batch waits until after it.
+                _pending.insert(_pending.end(), _childBatch.begin() + i, _childBatch.end());
+                break;
+            }
+
+            // One work per member fetched, as if we had been called once for each.  The first is
+            // the work counted above.
+            if (i > 0) {
+                ++_commonStats.works;
+            }
+
+            WorkingSetID id;
+            StageState fetchStatus = fetchOrReturn(_childBatch[i], &id);
+            if (PlanStage::ADVANCED == fetchStatus) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_FETCH == fetchStatus) {
+                // The rest of the batch waits until the page-in is done.  Those of its records
+                // that aren't in memory either are paged in along with this one, rather than
+                // costing a yield each.
+                for (size_t j = i + 1; j < _childBatch.size(); ++j) {
+                    WorkingSetMember* member = _ws->get(_childBatch[j]);
+                    if (!member->hasObj() && member->hasLoc() &&
+                        !recordInMemory(member->loc.rec()->dataNoThrowing())) {
+                        _ws->addPrefetch(_childBatch[j]);
+                    }
+                }
+                _pending.insert(_pending.end(), _childBatch.begin() + i + 1, _childBatch.end());
+                *fetchOut = id;
+                return PlanStage::NEED_FETCH;
+            }
+        }
+
+        if (PlanStage::NEED_FETCH == status) {
+            *fetchOut = childFetch;
+            ++_commonStats.needFetch;
+        }
+        else if (PlanStage::NEED_TIME == status) {
+            ++_commonStats.needTime;
+        }
+        return status;
+    }
+
     void FetchStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -153,6 +195,48 @@ namespace mongo {
                 ++_specificStats.forcedFetches;
             }
         }
+
+        // Results from our child's last batch are ours to take care of until we return them.
+        for (deque<WorkingSetID>::const_iterator it = _pending.begin(); it != _pending.end(); ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+                ++_specificStats.forcedFetches;
+            }
+        }
+    }
+
+    PlanStage::StageState FetchStage::fetchOrReturn(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+            return returnIfMatches(member, id, out);
+        }
+
+        // We need a valid loc to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::LOC_AND_IDX == member->state);
+        verify(member->hasLoc());
+
+        Record* record = member->loc.rec();
+        const char* data = record->dataNoThrowing();
+
+        if (!recordInMemory(data)) {
+            // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
+            verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+            _idBeingPagedIn = id;
+            *out = id;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+        else {
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = BSONObj(data);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            return returnIfMatches(member, id, out);
+        }
     }
 
     PlanStage::StageState FetchStage::fetchCompleted(WorkingSetID* out) {
@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <deque>
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -50,6 +53,8 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                     WorkingSetID* fetchOut);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -70,6 +75,12 @@ namespace mongo {
          */
         StageState fetchCompleted(WorkingSetID* out);
 
+        /**
+         * Fetch the member 'id' our child returned and pass it to returnIfMatches, or if it's not
+         * in memory, request a page-in of it.
+         */
+        StageState fetchOrReturn(WorkingSetID id, WorkingSetID* out);
+
         // _ws is not owned by us.
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
@@ -81,6 +92,13 @@ namespace mongo {
         // a "please page this in" result and hold on to the WSID until the next call to work(...).
         WorkingSetID _idBeingPagedIn;
 
+        // Results of our child's last workBatch(...) that we haven't gotten to because we had to
+        // ask for a page-in.  They're returned before we go back to our child.
+        std::deque<WorkingSetID> _pending;
+
+        // Reused by workBatch(...) for our child's results.
+        std::vector<WorkingSetID> _childBatch;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
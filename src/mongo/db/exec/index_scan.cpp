@@ -50,8 +50,9 @@ namespace mongo {
     IndexScan::IndexScan(const IndexScanParams& params, WorkingSet* workingSet,
                          const MatchExpression* filter)
         : _workingSet(workingSet), _descriptor(params.descriptor), _hitEnd(false), _filter(filter), 
-          _shouldDedup(params.descriptor->isMultikey()), _yieldMovedCursor(false), _params(params),
-          _btreeCursor(NULL) {
+          _shouldDedup(params.descriptor->isMultikey()), _toSkip(params.skip),
+          _yieldBtreeCursor(NULL),
+          _yieldMovedCursor(false), _params(params), _btreeCursor(NULL) {
 
         string amName;
 
@@ -100,6 +101,7 @@ namespace mongo {
             _iam->newCursor(&cursor);
             _indexCursor.reset(cursor);
             _indexCursor->setOptions(cursorOptions);
+            _yieldBtreeCursor = dynamic_cast<BtreeIndexCursor*>(cursor);
 
             if (_params.bounds.isSimpleRange) {
                 // Start at one key, end at another.
@@ -162,6 +164,15 @@ namespace mongo {
             }
         }
 
+        // Without a filter every entry past the dedup is a result, so a skipped one can be
+        // dropped before we copy its key out.
+        if (_toSkip > 0 && NULL == _filter) {
+            --_toSkip;
+            ++_specificStats.keysSkipped;
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
         member->loc = loc;
@@ -173,6 +184,13 @@ namespace mongo {
             if (NULL != _filter) {
                 ++_specificStats.matchTested;
             }
+            if (_toSkip > 0) {
+                --_toSkip;
+                ++_specificStats.keysSkipped;
+                _workingSet->free(id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
             *out = id;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -183,6 +201,11 @@ namespace mongo {
         return PlanStage::NEED_TIME;
     }
 
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                               WorkingSetID* fetchOut) {
+        return workBatchInline(this, maxWorks, out, fetchOut);
+    }
+
     bool IndexScan::isEOF() {
         if (NULL == _indexCursor.get()) {
             // Have to call work() at least once.
@@ -196,8 +219,10 @@ namespace mongo {
         ++_commonStats.yields;
 
         if (isEOF() || (NULL == _indexCursor.get())) { return; }
-        _savedKey = _indexCursor->getKey().getOwned();
-        _savedLoc = _indexCursor->getValue();
+        if (NULL == _yieldBtreeCursor) {
+            _savedKey = _indexCursor->getKey().getOwned();
+            _savedLoc = _indexCursor->getValue();
+        }
         _indexCursor->savePosition();
     }
 
@@ -213,8 +238,12 @@ namespace mongo {
             return;
         }
 
-        if (!_savedKey.binaryEqual(_indexCursor->getKey())
-            || _savedLoc != _indexCursor->getValue()) {
+        bool moved = (NULL != _yieldBtreeCursor)
+            ? !_yieldBtreeCursor->restoredToSavedPosition()
+            : (_savedLoc != _indexCursor->getValue()
+               || !_savedKey.binaryEqual(_indexCursor->getKey()));
+
+        if (moved) {
             // Our restored position isn't the same as the saved position.  When we call work()
             // again we want to return where we currently point, not past it.
             _yieldMovedCursor = true;
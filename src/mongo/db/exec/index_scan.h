@@ -46,7 +46,7 @@ namespace mongo {
 
     struct IndexScanParams {
         IndexScanParams() : descriptor(NULL), direction(1), limit(0),
-                            forceBtreeAccessMethod(false) { }
+                            forceBtreeAccessMethod(false), skip(0) { }
 
         IndexDescriptor* descriptor;
 
@@ -59,11 +59,16 @@ namespace mongo {
 
         // Special indices internally open an IndexCursor over themselves but as a straight Btree.
         bool forceBtreeAccessMethod;
+
+        // Drop this many results before returning any.  A skipped entry is never made into a
+        // WorkingSetMember unless the filter has to look at it.
+        int skip;
     };
 
     /**
      * Stage scans over an index from startKey to endKey, returning results that pass the provided
-     * filter.  Internally dedups on DiskLoc.
+     * filter.  Internally dedups on DiskLoc.  Can drop the first results itself, see
+     * IndexScanParams::skip.
      *
      * Sub-stage preconditions: None.  Is a leaf and consumes no stage data.
      */
@@ -75,6 +80,8 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                     WorkingSetID* fetchOut);
         virtual bool isEOF();
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -106,7 +113,12 @@ namespace mongo {
         bool _shouldDedup;
         unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
 
-        // For yielding.
+        // How many more results we drop before returning any.
+        int _toSkip;
+
+        // For yielding.  A btree cursor tracks whether a yield moved it, so these are only saved
+        // for other cursors.
+        BtreeIndexCursor* _yieldBtreeCursor;
         BSONObj _savedKey;
         DiskLoc _savedLoc;
 
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/limit.h"
 
+#include <algorithm>
+
 namespace mongo {
 
     LimitStage::LimitStage(int limit, WorkingSet* ws, PlanStage* child)
@@ -64,6 +66,35 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                                WorkingSetID* fetchOut) {
+        ++_commonStats.works;
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // Each unit of work produces at most one result, so we never get more than we may return.
+        const size_t before = out->size();
+        StageState status = _child->workBatch(std::min(maxWorks, static_cast<size_t>(_numToReturn)),
+                                              out, fetchOut);
+        const size_t produced = out->size() - before;
+
+        _numToReturn -= static_cast<int>(produced);
+        _commonStats.advanced += produced;
+
+        // One work per result passed through, as if we had been called once for each.  The
+        // first is the work counted above.
+        if (produced > 1) {
+            _commonStats.works += produced - 1;
+        }
+        if (PlanStage::NEED_FETCH == status) {
+            ++_commonStats.needFetch;
+        }
+        else if (PlanStage::NEED_TIME == status) {
+            ++_commonStats.needTime;
+        }
+        return status;
+    }
+
     void LimitStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -163,6 +163,33 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Perform up to 'maxWorks' units of work on the query, appending every result produced to
+         * 'out'.  This is the same as calling work(...) up to 'maxWorks' times, stopping early at
+         * the first call that returns something other than ADVANCED or NEED_TIME.  Returns what
+         * the last call returned.  If that's NEED_FETCH, *fetchOut is set to the WSID to fetch
+         * just as work(...) sets its out parameter; the results in 'out' are still valid.
+         *
+         * Stages that pass many results through cheaply override this so that a batch of results
+         * costs one call per stage rather than one call per stage per result.
+         */
+        virtual StageState workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                     WorkingSetID* fetchOut) {
+            StageState state = NEED_TIME;
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID id;
+                state = work(&id);
+                if (ADVANCED == state) {
+                    out->push_back(id);
+                }
+                else if (NEED_TIME != state) {
+                    if (NEED_FETCH == state) { *fetchOut = id; }
+                    break;
+                }
+            }
+            return state;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -214,4 +241,27 @@ namespace mongo {
         virtual PlanStageStats* getStats() = 0;
     };
 
+    /**
+     * The default PlanStage::workBatch(...), but calling 'stage's own work(...) directly rather
+     * than through the vtable, so that it can be inlined into the loop.  For leaf stages whose
+     * work(...) is cheap.
+     */
+    template <typename Stage>
+    PlanStage::StageState workBatchInline(Stage* stage, size_t maxWorks,
+                                          vector<WorkingSetID>* out, WorkingSetID* fetchOut) {
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        for (size_t i = 0; i < maxWorks; ++i) {
+            WorkingSetID id;
+            state = stage->Stage::work(&id);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                if (PlanStage::NEED_FETCH == state) { *fetchOut = id; }
+                break;
+            }
+        }
+        return state;
+    }
+
 }  // namespace mongo
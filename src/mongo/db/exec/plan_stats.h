@@ -51,6 +51,7 @@ namespace mongo {
                         advanced(0),
                         needTime(0),
                         needFetch(0),
+                        executionTimeMicros(0),
                         isEOF(false) { }
 
         // Count calls into the stage.
@@ -67,8 +68,10 @@ namespace mongo {
         // TODO: have some way of tracking WSM sizes (or really any series of #s).  We can measure
         // the size of our inputs and the size of our outputs.  We can do a lot with the WS here.
 
-        // TODO: once we've picked a plan, collect different (or additional) stats for display to
-        // the user, eg. time_t totalTimeSpent;
+        // Wall time spent working the stage, including its children.  Timing every work() call
+        // of every stage is too costly, so this is only filled in for the root of a candidate
+        // plan by the MultiPlanRunner, covering the plan's trial period.  Zero otherwise.
+        uint64_t executionTimeMicros;
 
         // TODO: keep track of total yield time / fetch time for a plan (done by runner)
 
@@ -110,7 +113,9 @@ namespace mongo {
 
     struct AndHashStats : public SpecificStats {
         AndHashStats() : flaggedButPassed(0),
-                         flaggedInProgress(0) { }
+                         flaggedInProgress(0),
+                         memUsage(0),
+                         memLimit(0) { }
 
         virtual ~AndHashStats() { }
 
@@ -128,6 +133,11 @@ namespace mongo {
 
         // mapAfterChild[mapAfterChild.size() - 1] WSMswere match tested.
         // commonstats.advanced is how many passed.
+
+        // The most bytes the hash table held, and how many it was allowed.  The stage fails if
+        // memUsage goes over memLimit.
+        size_t memUsage;
+        size_t memLimit;
     };
 
     struct AndSortedStats : public SpecificStats {
@@ -146,6 +156,18 @@ namespace mongo {
         uint64_t matchTested;
     };
 
+    struct CollectionScanStats : public SpecificStats {
+        CollectionScanStats() : extentsPrefetched(0),
+                                bytesPrefetched(0) { }
+
+        virtual ~CollectionScanStats() { }
+
+        // How many extents ahead of the scan did we ask the OS to read in, and how many bytes of
+        // them?
+        uint64_t extentsPrefetched;
+        uint64_t bytesPrefetched;
+    };
+
     struct FetchStats : public SpecificStats {
         FetchStats() : alreadyHasObj(0),
                        forcedFetches(0),
@@ -174,7 +196,8 @@ namespace mongo {
                            dupsDropped(0),
                            seenInvalidated(0),
                            matchTested(0),
-                           keysExamined(0) { }
+                           keysExamined(0),
+                           keysSkipped(0) { }
 
         virtual ~IndexScanStats() { }
 
@@ -204,6 +227,9 @@ namespace mongo {
         // Number of entries retrieved from the index during the scan.
         uint64_t keysExamined;
 
+        // Number of results dropped by the scan's own skip, see IndexScanParams::skip.
+        uint64_t keysSkipped;
+
     };
 
     struct OrStats : public SpecificStats {
@@ -224,12 +250,15 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0) { }
+        SortStats() : forcedFetches(0), spilledFiles(0) { }
 
         virtual ~SortStats() { }
 
         // How many records were we forced to fetch as the result of an invalidation?
         uint64_t forcedFetches;
+
+        // How many sorted files did we write to disk?  Only external sorts spill.
+        uint64_t spilledFiles;
     };
 
     struct MergeSortStats : public SpecificStats {
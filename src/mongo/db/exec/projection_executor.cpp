@@ -47,6 +47,12 @@ namespace mongo {
 
     // static
     Status ProjectionExecutor::applyFindSyntax(const FindProjection* proj, WorkingSetMember* wsm) {
+        // An inclusion of top-level fields from a whole document is the common case.  It's done
+        // in one pass over the document, copying the fields that are in the projection.
+        if (wsm->hasObj() && proj->_includedTopLevelOnly && !proj->_includedFieldSet.empty()) {
+            return applyTopLevelInclusion(proj, wsm);
+        }
+
         BSONObjBuilder bob;
         if (proj->_includeID) {
             BSONElement elt;
@@ -102,4 +108,32 @@ namespace mongo {
         return Status::OK();
     }
 
+    // static
+    Status ProjectionExecutor::applyTopLevelInclusion(const FindProjection* proj,
+                                                      WorkingSetMember* wsm) {
+        const StringMap<bool>& fields = proj->_includedFieldSet;
+
+        // The output can't be bigger than the document.
+        BSONObjBuilder bob(wsm->obj.objsize());
+        BSONObjIterator it(wsm->obj);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            StringData name = elt.fieldNameStringData();
+            if ("_id" == name) {
+                if (proj->_includeID) {
+                    bob.append(elt);
+                }
+            }
+            else if (fields.end() != fields.find(name)) {
+                bob.append(elt);
+            }
+        }
+
+        wsm->state = WorkingSetMember::OWNED_OBJ;
+        wsm->obj = bob.obj();
+        wsm->keyData.clear();
+        wsm->loc = DiskLoc();
+        return Status::OK();
+    }
+
 }  // namespace mongo
@@ -48,6 +48,11 @@ namespace mongo {
 
     private:
         static Status applyFindSyntax(const FindProjection* proj, WorkingSetMember* wsm);
+
+        /**
+         * applyFindSyntax() for an inclusion of only top-level fields, from a WSM with an obj.
+         */
+        static Status applyTopLevelInclusion(const FindProjection* proj, WorkingSetMember* wsm);
     };
 
 }  // namespace mongo
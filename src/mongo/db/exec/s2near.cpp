@@ -38,6 +38,77 @@
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * Passes through the results of its child, dropping any whose loc is in 'returned'.  Sits
+         * between the ixscan and the fetch of an annulus so already-returned documents aren't
+         * fetched again.
+         */
+        class SkipReturnedStage : public PlanStage {
+        public:
+            SkipReturnedStage(WorkingSet* ws, PlanStage* child,
+                              const unordered_set<DiskLoc, DiskLoc::Hasher>* returned)
+                : _ws(ws), _child(child), _returned(returned) { }
+
+            virtual bool isEOF() { return _child->isEOF(); }
+
+            virtual StageState work(WorkingSetID* out) {
+                ++_commonStats.works;
+
+                StageState state = _child->work(out);
+
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = _ws->get(*out);
+                    if (member->hasLoc() && _returned->end() != _returned->find(member->loc)) {
+                        _ws->free(*out);
+                        ++_commonStats.needTime;
+                        return PlanStage::NEED_TIME;
+                    }
+                    ++_commonStats.advanced;
+                }
+                else if (PlanStage::NEED_FETCH == state) {
+                    ++_commonStats.needFetch;
+                }
+                else if (PlanStage::NEED_TIME == state) {
+                    ++_commonStats.needTime;
+                }
+                return state;
+            }
+
+            virtual void prepareToYield() {
+                ++_commonStats.yields;
+                _child->prepareToYield();
+            }
+
+            virtual void recoverFromYield() {
+                ++_commonStats.unyields;
+                _child->recoverFromYield();
+            }
+
+            virtual void invalidate(const DiskLoc& dl) {
+                ++_commonStats.invalidates;
+                _child->invalidate(dl);
+            }
+
+            virtual PlanStageStats* getStats() {
+                _commonStats.isEOF = isEOF();
+                auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats,
+                                                                STAGE_GEO_NEAR_2DSPHERE));
+                ret->children.push_back(_child->getStats());
+                return ret.release();
+            }
+
+        private:
+            WorkingSet* _ws;
+            scoped_ptr<PlanStage> _child;
+            // Owned by the S2NearStage.
+            const unordered_set<DiskLoc, DiskLoc::Hasher>* _returned;
+            CommonStats _commonStats;
+        };
+
+    }  // namespace
+
     S2NearStage::S2NearStage(const string& ns, const BSONObj& indexKeyPattern,
                              const NearQuery& nearQuery, const IndexBounds& baseBounds,
                              MatchExpression* filter, WorkingSet* ws) {
@@ -119,6 +190,7 @@ namespace mongo {
                 unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher>::iterator it = _invalidationMap.find(member->loc);
                 verify(_invalidationMap.end() != it);
                 _invalidationMap.erase(it);
+                _returned.insert(member->loc);
             }
 
             ++_commonStats.advanced;
@@ -177,7 +249,10 @@ namespace mongo {
         IndexScan* scan = new IndexScan(params, _ws, NULL);
 
         // Owns 'scan'.
-        _child.reset(new FetchStage(_ws, scan, _filter));
+        SkipReturnedStage* skip = new SkipReturnedStage(_ws, scan, &_returned);
+
+        // Owns 'skip'.
+        _child.reset(new FetchStage(_ws, skip, _filter));
     }
 
     PlanStage::StageState S2NearStage::addResultToQueue(WorkingSetID* out) {
@@ -208,8 +283,6 @@ namespace mongo {
         // 0. Modify fetch to preserve key data and test for intersection w/annulus.
         //
         // 1. keep track of what we've seen in this scan and possibly ignore it.
-        //
-        // 2. keep track of results we've returned before and ignore them.
 
         WorkingSetMember* member = _ws->get(*out);
         // Must have an object in order to get geometry out of it.
@@ -266,6 +339,9 @@ namespace mongo {
         unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher>::iterator it
             = _invalidationMap.find(dl);
 
+        // A new document may be written at this loc; it hasn't been returned.
+        _returned.erase(dl);
+
         if (it != _invalidationMap.end()) {
             WorkingSetMember* member = _ws->get(it->second);
             verify(member->hasLoc());
@@ -118,6 +118,11 @@ namespace mongo {
         // For fast invalidation.  Perhaps not worth it.
         unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> _invalidationMap;
 
+        // Locs of every result we've returned.  The covering of each new annulus overlaps the
+        // cells of the previous ones, so the ixscan sees these documents again; we drop them
+        // before the fetch instead of reading them only to find they're too close.
+        unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
+
         // Geo-related variables.
         // At what min distance (arc length) do we start looking for results?
         double _minDistance;
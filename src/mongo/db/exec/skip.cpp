@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/skip.h"
 
+#include <algorithm>
+
 namespace mongo {
 
     SkipStage::SkipStage(int toSkip, WorkingSet* ws, PlanStage* child)
@@ -72,6 +74,41 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState SkipStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out,
+                                               WorkingSetID* fetchOut) {
+        ++_commonStats.works;
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        const size_t before = out->size();
+        StageState status = _child->workBatch(maxWorks, out, fetchOut);
+
+        // One work per result looked at, skipped or not, as if we had been called once for each.
+        // The first is the work counted above.
+        const size_t received = out->size() - before;
+        if (received > 1) {
+            _commonStats.works += received - 1;
+        }
+
+        // Drop the results we're still skipping, which are the first ones in the batch.
+        const size_t toDrop = std::min(static_cast<size_t>(_toSkip), received);
+        for (size_t i = before; i < before + toDrop; ++i) {
+            _ws->free((*out)[i]);
+        }
+        out->erase(out->begin() + before, out->begin() + before + toDrop);
+        _toSkip -= static_cast<int>(toDrop);
+
+        _commonStats.advanced += out->size() - before;
+        _commonStats.needTime += toDrop;
+        if (PlanStage::NEED_FETCH == status) {
+            ++_commonStats.needFetch;
+        }
+        else if (PlanStage::NEED_TIME == status) {
+            ++_commonStats.needTime;
+        }
+        return status;
+    }
+
     void SkipStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
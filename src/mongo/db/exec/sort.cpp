@@ -32,11 +32,23 @@
 
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/bufreader.h"
 
 namespace mongo {
 
+    extern BSONObj staticNull;
+
     const size_t kMaxBytes = 32 * 1024 * 1024;
 
+    // The value 'member' sorts by for the pattern field 'fieldName'.  A missing field sorts as
+    // null, whether we sort in the WorkingSet or with a Sorter.
+    static BSONElement getSortElement(WorkingSetMember* member, const string& fieldName) {
+        BSONElement elt;
+        verify(member->getFieldDotted(fieldName, &elt));
+        return elt.eoo() ? staticNull.firstElement() : elt;
+    }
+
     // Used in STL sort.
     struct WorkingSetComparison {
         WorkingSetComparison(WorkingSet* ws, BSONObj pattern) : _ws(ws), _pattern(pattern) { }
@@ -50,11 +62,8 @@ namespace mongo {
                 BSONElement patternElt = it.next();
                 string fn = patternElt.fieldName();
 
-                BSONElement lhsElt;
-                verify(lhsMember->getFieldDotted(fn, &lhsElt));
-
-                BSONElement rhsElt;
-                verify(rhsMember->getFieldDotted(fn, &rhsElt));
+                BSONElement lhsElt = getSortElement(lhsMember, fn);
+                BSONElement rhsElt = getSortElement(rhsMember, fn);
 
                 // false means don't compare field name.
                 int x = lhsElt.woCompare(rhsElt, false);
@@ -72,22 +81,107 @@ namespace mongo {
         BSONObj _pattern;
     };
 
+    // Used by the Sorter.  The keys hold the values of the pattern's fields, in order.
+    class SortKeyComparison {
+    public:
+        explicit SortKeyComparison(const BSONObj& pattern) : _ordering(Ordering::make(pattern)) { }
+
+        int operator()(const pair<BSONObj, SortableWorkingSetMember>& lhs,
+                       const pair<BSONObj, SortableWorkingSetMember>& rhs) const {
+            // false means don't compare field name.
+            return lhs.first.woCompare(rhs.first, _ordering, false);
+        }
+
+    private:
+        Ordering _ordering;
+    };
+
+    void SortableWorkingSetMember::serializeForSorter(BufBuilder& buf) const {
+        buf.appendNum(static_cast<int>(state));
+        loc.serializeForSorter(buf);
+        buf.appendNum(addedAt);
+        obj.serializeForSorter(buf);
+        buf.appendNum(static_cast<int>(keyData.size()));
+        for (size_t i = 0; i < keyData.size(); ++i) {
+            keyData[i].indexKeyPattern.serializeForSorter(buf);
+            keyData[i].keyData.serializeForSorter(buf);
+        }
+    }
+
+    // static
+    SortableWorkingSetMember SortableWorkingSetMember::deserializeForSorter(
+            BufReader& buf, const SorterDeserializeSettings&) {
+        SortableWorkingSetMember member;
+        member.state = static_cast<WorkingSetMember::MemberState>(buf.read<int>());
+        member.loc = DiskLoc::deserializeForSorter(buf, DiskLoc::SorterDeserializeSettings());
+        member.addedAt = buf.read<long long>();
+        member.obj = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        const int numKeys = buf.read<int>();
+        for (int i = 0; i < numKeys; ++i) {
+            BSONObj keyPattern = BSONObj::deserializeForSorter(buf,
+                                                               BSONObj::SorterDeserializeSettings());
+            BSONObj key = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+            member.keyData.push_back(IndexKeyDatum(keyPattern, key));
+        }
+        return member;
+    }
+
+    int SortableWorkingSetMember::memUsageForSorter() const {
+        int usage = sizeof(*this) + obj.objsize();
+        for (size_t i = 0; i < keyData.size(); ++i) {
+            usage += sizeof(IndexKeyDatum) + keyData[i].indexKeyPattern.objsize()
+                     + keyData[i].keyData.objsize();
+        }
+        return usage;
+    }
+
+    SortableWorkingSetMember SortableWorkingSetMember::getOwned() const {
+        SortableWorkingSetMember owned;
+        owned.state = state;
+        owned.loc = loc;
+        owned.addedAt = addedAt;
+        owned.obj = obj.getOwned();
+        for (size_t i = 0; i < keyData.size(); ++i) {
+            owned.keyData.push_back(IndexKeyDatum(keyData[i].indexKeyPattern.getOwned(),
+                                                  keyData[i].keyData.getOwned()));
+        }
+        return owned;
+    }
+
     SortStage::SortStage(const SortStageParams& params, WorkingSet* ws, PlanStage* child)
         : _ws(ws), _child(child), _pattern(params.pattern), _sorted(false),
-          _resultIterator(_data.end()), _memUsage(0) { }
+          _resultIterator(_data.end()), _memUsage(0), _limit(params.limit),
+          _allowExternalSort(params.allowExternalSort), _sorterFailed(false), _numAdded(0) {
+
+        // Sorting the WorkingSetIDs in memory is cheapest, so we only use a Sorter when it buys
+        // us something: keeping only the top 'limit' results, or spilling to disk.
+        if (_limit > 0 || _allowExternalSort) {
+            SortOptions opts;
+            opts.limit = _limit;
+            opts.maxMemoryUsageBytes = kMaxBytes;
+            if (_allowExternalSort) {
+                opts.extSortAllowed = true;
+                opts.tempDir = storageGlobalParams.dbpath + "/_tmp";
+            }
+            _sorter.reset(MemberSorter::make(opts, SortKeyComparison(_pattern)));
+        }
+    }
 
     SortStage::~SortStage() { }
 
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
+        if (NULL != _sorter.get()) {
+            return _child->isEOF() && _sorted && !_sorterIterator->more();
+        }
         return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        if (_memUsage > kMaxBytes) {
+        if (_memUsage > kMaxBytes || _sorterFailed) {
             return PlanStage::FAILURE;
         }
 
@@ -98,7 +192,14 @@ namespace mongo {
             WorkingSetID id;
             StageState code = _child->work(&id);
 
-            if (PlanStage::ADVANCED == code) {
+            if (PlanStage::ADVANCED == code && NULL != _sorter.get()) {
+                if (!addToSorter(id)) {
+                    return PlanStage::FAILURE;
+                }
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+            else if (PlanStage::ADVANCED == code) {
                 // We let the data stay in the WorkingSet and sort using the IDs.
                 _data.push_back(id);
 
@@ -123,10 +224,18 @@ namespace mongo {
                 return PlanStage::NEED_TIME;
             }
             else if (PlanStage::IS_EOF == code) {
-                // TODO: We don't need the lock for this.  We could ask for a yield and do this work
-                // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                std::sort(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
-                _resultIterator = _data.begin();
+                if (NULL != _sorter.get()) {
+                    // Merges whatever was spilled with what's still in memory.
+                    _sorterIterator.reset(_sorter->done());
+                    _specificStats.spilledFiles = _sorter->numFiles();
+                }
+                else {
+                    // TODO: We don't need the lock for this.  We could ask for a yield and do this
+                    // work unlocked.  Also, this is performing a lot of work for one call to
+                    // work(...)
+                    std::sort(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
+                    _resultIterator = _data.begin();
+                }
                 _sorted = true;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -144,6 +253,13 @@ namespace mongo {
         }
 
         // Returning results.
+        if (NULL != _sorter.get()) {
+            verify(_sorted);
+            *out = nextFromSorter();
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         verify(_resultIterator != _data.end());
         verify(_sorted);
         *out = *_resultIterator++;
@@ -159,6 +275,74 @@ namespace mongo {
         return PlanStage::ADVANCED;
     }
 
+    bool SortStage::addToSorter(const WorkingSetID& id) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // Pull the pattern's fields out into the sort key.
+        BSONObjBuilder keyBob;
+        BSONObjIterator it(_pattern);
+        while (it.more()) {
+            keyBob.appendAs(getSortElement(member, it.next().fieldName()), "");
+        }
+
+        SortableWorkingSetMember sortable;
+        sortable.state = member->state;
+        sortable.loc = member->loc;
+        sortable.obj = member->obj;
+        sortable.keyData = member->keyData;
+        sortable.addedAt = _numAdded++;
+
+        // The sorter keeps its own copy, so we don't hold on to the member.  The sorter doesn't
+        // copy what it's given, so 'sortable' must be owned.
+        _ws->free(id);
+
+        try {
+            _sorter->add(keyBob.obj(), sortable.getOwned());
+        }
+        catch (const UserException&) {
+            // Out of memory and we may not spill to disk.
+            _sorterFailed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    WorkingSetID SortStage::nextFromSorter() {
+        // Results from a sorted file are only valid until the next call to next().
+        SortableWorkingSetMember sortable = _sorterIterator->next().second.getOwned();
+
+        WorkingSetID id = _ws->allocate();
+        WorkingSetMember* member = _ws->get(id);
+        member->state = sortable.state;
+        member->loc = sortable.loc;
+        member->obj = sortable.obj;
+        member->keyData.swap(sortable.keyData);
+
+        if (member->hasLoc()) {
+            // If the DiskLoc was invalidated after we read the member, it's in the same state as
+            // if we had fetched it then.  See WorkingSetCommon::fetchAndInvalidateLoc.
+            // The DiskLoc may have been reused and invalidated again since, so the document the
+            // member saw is the one fetched at the first invalidation after it was added.
+            InvalidatedMap::const_iterator it = _invalidated.find(member->loc);
+            if (_invalidated.end() != it) {
+                const vector<InvalidatedObj>& objs = it->second;
+                for (size_t i = 0; i < objs.size(); ++i) {
+                    if (sortable.addedAt >= objs[i].first) { continue; }
+                    if (!member->hasObj()) {
+                        member->obj = objs[i].second;
+                    }
+                    member->state = WorkingSetMember::OWNED_OBJ;
+                    member->loc = DiskLoc();
+                    ++_specificStats.forcedFetches;
+                    break;
+                }
+            }
+        }
+
+        return id;
+    }
+
     void SortStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -173,6 +357,20 @@ namespace mongo {
         ++_commonStats.invalidates;
         _child->invalidate(dl);
 
+        if (NULL != _sorter.get()) {
+            // We can't get at the members once they're in the sorter, so we fetch the object now
+            // in case one of them has this DiskLoc, and fix the member up as it comes out.
+            // If nothing was added since this DiskLoc was last invalidated, the members that could
+            // have it already have their object.
+            vector<InvalidatedObj>& objs = _invalidated[dl];
+            if (_numAdded > 0 && (objs.empty() || objs.back().first < _numAdded)) {
+                objs.push_back(make_pair(_numAdded, dl.obj().getOwned()));
+                // The copies are held until we're done, so they count toward our memory limit.
+                _memUsage += sizeof(DiskLoc) + objs.back().second.objsize();
+            }
+            return;
+        }
+
         // _data contains indices into the WorkingSet, not actual data.  If a WorkingSetMember in
         // the WorkingSet needs to change state as a result of a DiskLoc invalidation, it will still
         // be at the same spot in the WorkingSet.  As such, we don't need to modify _data.
@@ -198,3 +396,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -34,6 +34,8 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -41,9 +43,39 @@ namespace mongo {
     // External params for the sort stage.  Declared below.
     class SortStageParams;
 
+    /**
+     * The contents of a WorkingSetMember as handed to the Sorter.  The Sorter may write these to
+     * disk, so unlike a WorkingSetID they don't refer to anything in the WorkingSet.
+     */
+    struct SortableWorkingSetMember {
+        SortableWorkingSetMember() : state(WorkingSetMember::INVALID), addedAt(0) { }
+
+        WorkingSetMember::MemberState state;
+        DiskLoc loc;
+        BSONObj obj;
+        vector<IndexKeyDatum> keyData;
+
+        // The number of members the SortStage had added before this one.  Lets us tell whether
+        // an invalidation of 'loc' happened after we read the member.
+        long long addedAt;
+
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const;
+        static SortableWorkingSetMember deserializeForSorter(BufReader& buf,
+                                                             const SorterDeserializeSettings&);
+        int memUsageForSorter() const;
+        SortableWorkingSetMember getOwned() const;
+    };
+
     /**
      * Sorts the input received from the child according to the sort pattern provided.
      *
+     * By default the input is buffered in the WorkingSet and sorted in memory, and the stage fails
+     * once it holds more than 32MB.  If a limit is provided only the best 'limit' results are
+     * kept, and if external sorting is allowed the input is spilled to sorted files on disk
+     * rather than failing.  Either way the input is handed to a Sorter, which owns copies of it.
+     *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
      */
@@ -63,6 +95,19 @@ namespace mongo {
         PlanStageStats* getStats();
 
     private:
+        typedef Sorter<BSONObj, SortableWorkingSetMember> MemberSorter;
+
+        /**
+         * Adds the member 'id' to _sorter and frees it from the WorkingSet.  Returns false if the
+         * sorter ran out of memory.
+         */
+        bool addToSorter(const WorkingSetID& id);
+
+        /**
+         * Puts the next result of _sorterIterator into the WorkingSet, returning its id.
+         */
+        WorkingSetID nextFromSorter();
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -91,19 +136,45 @@ namespace mongo {
 
         // The usage in bytes of all bufered data that we're sorting.
         size_t _memUsage;
+
+        // See SortStageParams.
+        int _limit;
+        bool _allowExternalSort;
+
+        // Set if we sort with a Sorter rather than in the WorkingSet.  Input goes into _sorter
+        // until the child is EOF, and the sorted results are then read out of _sorterIterator.
+        scoped_ptr<MemberSorter> _sorter;
+        scoped_ptr<MemberSorter::Iterator> _sorterIterator;
+
+        // Did the sorter run out of memory?
+        bool _sorterFailed;
+
+        // How many members have been given to _sorter.
+        long long _numAdded;
+
+        // Members in _sorter can't be fetched when their DiskLoc is invalidated, so instead we
+        // fetch the object when the invalidation happens and keep it here, along with _numAdded
+        // as of then.  A DiskLoc can be reused and invalidated again, so each DiskLoc keeps its
+        // objects in invalidation order.  Members added before an invalidation are given that
+        // invalidation's object on their way out.  The objects count toward _memUsage.
+        typedef pair<long long, BSONObj> InvalidatedObj;
+        typedef unordered_map<DiskLoc, vector<InvalidatedObj>, DiskLoc::Hasher> InvalidatedMap;
+        InvalidatedMap _invalidated;
     };
 
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        //SortStageParams() : limit(0) { }
+        SortStageParams() : limit(0), allowExternalSort(false) { }
 
         // How we're sorting.
         BSONObj pattern;
 
-        // TODO: Implement this.
         // Must be >= 0.  Equal to 0 for no limit.
-        // int limit;
+        int limit;
+
+        // May we spill to disk rather than fail when the input doesn't fit in memory?
+        bool allowExternalSort;
     };
 
 }  // namespace mongo
@@ -67,13 +67,14 @@ namespace mongo {
      *
      * Internal Nodes:
      *
-     * node -> {andHash: {filter: {filter}, args: { nodes: [node, node]}}}
+     * node -> {andHash: {filter: {filter}, args: { nodes: [node, node], maxMemUsage: int}}}
      * node -> {andSorted: {filter: {filter}, args: { nodes: [node, node]}}}
      * node -> {or: {filter: {filter}, args: { dedup:bool, nodes:[node, node]}}}
      * node -> {fetch: {filter: {filter}, args: {node: node}}}
      * node -> {limit: {args: {node: node, num: posint}}}
      * node -> {skip: {args: {node: node, num: posint}}}
-     * node -> {sort: {args: {node: node, pattern: objWithSortCriterion }}}
+     * node -> {sort: {args: {node: node, pattern: objWithSortCriterion, limit: int,
+     *                        allowExternalSort: bool }}}
      * node -> {mergeSort: {args: {nodes: [node, node], pattern: objWithSortCriterion}}}
      * node -> {cscan: {filter: {filter}, args: {name: "collectionname" }}}
      *
@@ -191,7 +192,12 @@ namespace mongo {
                 uassert(16921, "Nodes argument must be provided to AND",
                         nodeArgs["nodes"].isABSONObj());
 
-                auto_ptr<AndHashStage> andStage(new AndHashStage(workingSet, matcher));
+                size_t maxMemUsage = AndHashStage::kDefaultMaxMemUsageBytes;
+                if (nodeArgs["maxMemUsage"].isNumber()) {
+                    maxMemUsage = nodeArgs["maxMemUsage"].numberLong();
+                }
+                auto_ptr<AndHashStage> andStage(new AndHashStage(workingSet, matcher,
+                                                                 maxMemUsage));
 
                 int nodesAdded = 0;
                 BSONObjIterator it(nodeArgs["nodes"].Obj());
@@ -312,6 +318,8 @@ namespace mongo {
                 PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet, exprs);
                 SortStageParams params;
                 params.pattern = nodeArgs["pattern"].Obj();
+                params.limit = nodeArgs["limit"].numberInt();
+                params.allowExternalSort = nodeArgs["allowExternalSort"].trueValue();
                 return new SortStage(params, workingSet, subNode);
             }
             else if ("mergeSort" == nodeName) {
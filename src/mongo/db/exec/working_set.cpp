@@ -34,36 +34,58 @@ namespace mongo {
 
     const WorkingSetID WorkingSet::INVALID_ID = -1;
 
-    WorkingSet::WorkingSet() : _nextId(0) { }
+    WorkingSet::MemberHolder::MemberHolder() : nextFreeOrSelf(INVALID_ID), flagged(false) { }
 
-    WorkingSet::~WorkingSet() {
-        for (DataMap::const_iterator i = _data.begin(); i != _data.end(); ++i) {
-            delete i->second;
-        }
-    }
+    WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
+
+    WorkingSet::~WorkingSet() { }
 
     WorkingSetID WorkingSet::allocate() {
-        verify(_data.end() == _data.find(_nextId));
-        _data[_nextId] = new WorkingSetMember();
-        return _nextId++;
+        if (INVALID_ID == _freeList) {
+            WorkingSetID id = _data.size();
+            _data.push_back(MemberHolder());
+            _data.back().nextFreeOrSelf = id;
+            return id;
+        }
+
+        // Reuse the most recently freed member, which free() left empty.
+        WorkingSetID id = _freeList;
+        MemberHolder& holder = _data[id];
+        _freeList = holder.nextFreeOrSelf;
+        holder.nextFreeOrSelf = id;
+        return id;
     }
 
     WorkingSetMember* WorkingSet::get(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        return it->second;
+        verify(i >= 0 && size_t(i) < _data.size());
+        MemberHolder& holder = _data[i];
+        verify(i == holder.nextFreeOrSelf);
+        return &holder.member;
     }
 
     void WorkingSet::free(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        delete it->second;
-        _data.erase(it);
+        verify(i >= 0 && size_t(i) < _data.size());
+        MemberHolder& holder = _data[i];
+        verify(i == holder.nextFreeOrSelf);
+
+        // Release the member's data but keep its keyData capacity for the next user.
+        WorkingSetMember& member = holder.member;
+        member.loc = DiskLoc();
+        member.obj = BSONObj();
+        member.keyData.clear();
+        member.state = WorkingSetMember::INVALID;
+        holder.flagged = false;
+
+        holder.nextFreeOrSelf = _freeList;
+        _freeList = i;
     }
 
     void WorkingSet::flagForReview(const WorkingSetID& i) {
         WorkingSetMember* member = get(i);
         verify(WorkingSetMember::OWNED_OBJ == member->state);
+        MemberHolder& holder = _data[i];
+        if (holder.flagged) { return; }
+        holder.flagged = true;
         _flagged.push_back(i);
     }
 
@@ -71,6 +93,28 @@ namespace mongo {
         return _flagged;
     }
 
+    bool WorkingSet::isFlagged(const WorkingSetID& i) const {
+        verify(i >= 0 && size_t(i) < _data.size());
+        return _data[i].flagged;
+    }
+
+    void WorkingSet::addPrefetch(const WorkingSetID& i) {
+        _prefetch.push_back(i);
+    }
+
+    void WorkingSet::takePrefetch(vector<DiskLoc>* out) {
+        for (size_t i = 0; i < _prefetch.size(); ++i) {
+            // A freed ID may have been reused since; prefetching its new member is harmless.
+            const MemberHolder& holder = _data[_prefetch[i]];
+            if (_prefetch[i] != holder.nextFreeOrSelf) { continue; }
+            const WorkingSetMember& member = holder.member;
+            if (member.hasLoc() && !member.hasObj()) {
+                out->push_back(member.loc);
+            }
+        }
+        _prefetch.clear();
+    }
+
     WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID) { }
 
     bool WorkingSetMember::hasLoc() const {
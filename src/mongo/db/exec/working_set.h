@@ -28,72 +28,15 @@
 
 #pragma once
 
+#include <deque>
 #include <vector>
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
-#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
-    struct WorkingSetMember;
-
     typedef long WorkingSetID;
 
-    /**
-     * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
-     * an element of the working set.  Stages can add elements to the working set, delete elements
-     * from the working set, or mutate elements in the working set.
-     */
-    class WorkingSet {
-    public:
-        static const WorkingSetID INVALID_ID;
-
-        WorkingSet();
-        ~WorkingSet();
-
-        /**
-         * Allocate a new query result and return the ID used to get and free it.
-         */
-        WorkingSetID allocate();
-
-        /**
-         * Get the i-th mutable query result.
-         */
-        WorkingSetMember* get(const WorkingSetID& i);
-
-        /**
-         * Unallocate the i-th query result and release its resouces.
-         */
-        void free(const WorkingSetID& i);
-
-        /**
-         * The DiskLoc in WSM 'i' was invalidated while being processed.  Any predicates over the
-         * WSM could not be fully evaluated, so the WSM may or may not satisfy them.  As such, if we
-         * wish to output the WSM, we must do some clean-up work later.  Adds the WSM with id 'i' to
-         * the list of flagged WSIDs.
-         *
-         * The WSM must be in the state OWNED_OBJ.
-         */
-        void flagForReview(const WorkingSetID& i);
-
-        /**
-         * Return a vector of all WSIDs passed to flagForReview.
-         */
-        const vector<WorkingSetID>& getFlagged() const;
-
-    private:
-        typedef unordered_map<WorkingSetID, WorkingSetMember*> DataMap;
-
-        DataMap _data;
-
-        // The WorkingSetID returned by the next call to allocate().  Should refer to the next valid
-        // ID.  IDs allocated contiguously.  Should never point at an in-use ID.  
-        WorkingSetID _nextId;
-
-        // All WSIDs invalidated during evaluation of a predicate (AND).
-        vector<WorkingSetID> _flagged;
-    };
-
     /**
      * The key data extracted from an index.  Keeps track of both the key (currently a BSONObj) and
      * the index that provided the key.  The index key pattern is required to correctly interpret
@@ -159,4 +102,93 @@ namespace mongo {
         bool getFieldDotted(const string& field, BSONElement* out) const;
     };
 
+    /**
+     * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
+     * an element of the working set.  Stages can add elements to the working set, delete elements
+     * from the working set, or mutate elements in the working set.
+     *
+     * IDs are dense indexes into the members, and freed members are reused by later allocations,
+     * so a query returning millions of results only ever holds as many members as it has results
+     * in flight.
+     */
+    class WorkingSet {
+    public:
+        static const WorkingSetID INVALID_ID;
+
+        WorkingSet();
+        ~WorkingSet();
+
+        /**
+         * Allocate a new query result and return the ID used to get and free it.
+         */
+        WorkingSetID allocate();
+
+        /**
+         * Get the i-th mutable query result.
+         */
+        WorkingSetMember* get(const WorkingSetID& i);
+
+        /**
+         * Unallocate the i-th query result and release its resouces.
+         */
+        void free(const WorkingSetID& i);
+
+        /**
+         * The DiskLoc in WSM 'i' was invalidated while being processed.  Any predicates over the
+         * WSM could not be fully evaluated, so the WSM may or may not satisfy them.  As such, if we
+         * wish to output the WSM, we must do some clean-up work later.  Adds the WSM with id 'i' to
+         * the list of flagged WSIDs.
+         *
+         * The WSM must be in the state OWNED_OBJ.
+         */
+        void flagForReview(const WorkingSetID& i);
+
+        /**
+         * Return a vector of all WSIDs passed to flagForReview.
+         */
+        const vector<WorkingSetID>& getFlagged() const;
+
+        /**
+         * Was WSM 'i' passed to flagForReview since it was allocated?
+         */
+        bool isFlagged(const WorkingSetID& i) const;
+
+        /**
+         * WSM 'i' will need its record paged in soon after the one a stage is about to ask for.
+         * Whoever pages in the requested record can page in this one during the same yield.
+         */
+        void addPrefetch(const WorkingSetID& i);
+
+        /**
+         * Appends to 'out' the DiskLocs of the WSMs passed to addPrefetch which still need a fetch,
+         * and forgets them all.  Must be called before the lock is given up, as the DiskLocs may
+         * be invalidated then.
+         */
+        void takePrefetch(vector<DiskLoc>* out);
+
+    private:
+        struct MemberHolder {
+            MemberHolder();
+
+            // The holder's own ID while the member is allocated, otherwise the next ID of the free
+            // list.
+            WorkingSetID nextFreeOrSelf;
+            bool flagged;
+            WorkingSetMember member;
+        };
+
+        // Every member ever allocated, indexed by ID.  A deque grows in blocks and never moves its
+        // elements, so the WorkingSetMember pointers handed out by get() stay valid.
+        std::deque<MemberHolder> _data;
+
+        // The most recently freed ID, which the next allocate() reuses, or INVALID_ID.
+        WorkingSetID _freeList;
+
+        // All WSIDs invalidated during evaluation of a predicate (AND).
+        vector<WorkingSetID> _flagged;
+
+        // WSIDs passed to addPrefetch since the last takePrefetch.  Some may have been freed.
+        vector<WorkingSetID> _prefetch;
+    };
+
 }  // namespace mongo
@@ -144,4 +144,51 @@ namespace {
         ASSERT_FALSE(member->getFieldDotted("y", &elt));
     }
 
+    TEST(WorkingSetTest, freedMembersAreReused) {
+        WorkingSet ws;
+        WorkingSetID first = ws.allocate();
+        WorkingSetID second = ws.allocate();
+        ASSERT_NOT_EQUALS(first, second);
+
+        WorkingSetMember* member = ws.get(first);
+        member->state = WorkingSetMember::OWNED_OBJ;
+        member->obj = BSON("x" << 1);
+        member->keyData.push_back(IndexKeyDatum(BSON("x" << 1), BSON("" << 1)));
+        ws.free(first);
+
+        // The freed ID comes back, empty, and at the same address.
+        ASSERT_EQUALS(first, ws.allocate());
+        ASSERT_EQUALS(member, ws.get(first));
+        ASSERT_EQUALS(WorkingSetMember::INVALID, member->state);
+        ASSERT_TRUE(member->obj.isEmpty());
+        ASSERT_TRUE(member->keyData.empty());
+
+        // Members don't move as the working set grows.
+        WorkingSetMember* secondMember = ws.get(second);
+        for (int i = 0; i < 10000; ++i) {
+            ws.allocate();
+        }
+        ASSERT_EQUALS(secondMember, ws.get(second));
+    }
+
+    TEST(WorkingSetTest, flagging) {
+        WorkingSet ws;
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* member = ws.get(id);
+        member->state = WorkingSetMember::OWNED_OBJ;
+        member->obj = BSON("x" << 1);
+        ASSERT_FALSE(ws.isFlagged(id));
+
+        ws.flagForReview(id);
+        ws.flagForReview(id);
+        ASSERT_TRUE(ws.isFlagged(id));
+        ASSERT_EQUALS(size_t(1), ws.getFlagged().size());
+        ASSERT_EQUALS(id, ws.getFlagged()[0]);
+
+        // A reused ID isn't flagged.
+        ws.free(id);
+        ASSERT_EQUALS(id, ws.allocate());
+        ASSERT_FALSE(ws.isFlagged(id));
+    }
+
 }  // namespace
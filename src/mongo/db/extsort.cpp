@@ -38,12 +38,15 @@
 
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "mongo/db/client.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/file.h"
@@ -63,7 +66,9 @@ namespace mongo {
             {}
 
             int operator() (const Data& l, const Data& r) const {
-                RARELY if (*_mayInterrupt) {
+                // the sorter's helper threads have no Client; the thread that called the 
+                // sorter checks for interrupts on their behalf
+                RARELY if (*_mayInterrupt && haveClient()) {
                     killCurrentOp.checkForInterrupt(!*_mayInterrupt);
                 }
 
@@ -76,13 +81,22 @@ namespace mongo {
         };
     }
 
+    // threads sorting each batch of index keys before it is spilled; no more than the cores
+    MONGO_EXPORT_SERVER_PARAMETER(externalSortThreads, int, 4);
+
+    static unsigned sortThreads() {
+        unsigned cores = std::max(boost::thread::hardware_concurrency(), 1U);
+        return std::min(static_cast<unsigned>(std::max(externalSortThreads, 1)), cores);
+    }
+
     BSONObjExternalSorter::BSONObjExternalSorter(const ExternalSortComparison* comp,
                                                  long maxFileSize)
         : _mayInterrupt(boost::make_shared<bool>(false))
         , _sorter(Sorter<BSONObj, DiskLoc>::make(
                     SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
                                  .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(maxFileSize),
+                                 .MaxMemoryUsageBytes(maxFileSize)
+                                 .SortThreads(sortThreads()),
                     OldExtSortComparator(comp, _mayInterrupt)))
     {}
 }
@@ -95,6 +95,12 @@ namespace mongo {
                 cursors.push_back( c );
             }
 
+            // Each term's keys come back in decreasing score order, so once the best 'limit'
+            // documents are out of reach of everything else we can stop scanning.  Phrases and
+            // negations are only checked after the scan and may still reject any of them.
+            const bool canStopEarly = limit > 0 && !_query.hasNonTermPieces();
+            long long nextStopCheck = max( 1024LL, 4LL * limit );
+
             while ( !inShutdown() ) {
                 bool gotAny = false;
                 for ( unsigned i = 0; i < cursors.size(); i++ ) {
@@ -108,6 +114,13 @@ namespace mongo {
                 if ( !gotAny )
                     break;
 
+                if ( canStopEarly && _keysLookedAt >= nextStopCheck ) {
+                    if ( _stopEarly( cursors, limit, results ) )
+                        return;
+                    // the check walks all of _scores, so space the checks out geometrically
+                    nextStopCheck *= 2;
+                }
+
                 RARELY killCurrentOp.checkForInterrupt();
             }
 
@@ -144,21 +157,88 @@ namespace mongo {
         }
 
         /*
-         * Takes a cursor and updates the partial score for said cursor in _scores map
-         * @param cursor, btree cursor pointing to the current document to be scored
+         * Returns true and fills results if no document outside the current best 'limit' can
+         * still overtake any of them.  A document's score only grows as more of its terms are
+         * seen, and by at most the current key's score plus one per term cursor left.
+         * @param cursors, the term cursors
+         * @param limit, number of results wanted
+         * @param results, the priority queue to fill with the best results and exact scores
          */
-        void FTSSearch::_process( BtreeCursor* cursor ) {
-            _keysLookedAt++;
+        bool FTSSearch::_stopEarly( const vector< shared_ptr<BtreeCursor> >& cursors,
+                                    unsigned limit,
+                                    Results* results ) {
+            double remaining = 0;
+            for ( unsigned i = 0; i < cursors.size(); i++ ) {
+                if ( !cursors[i]->eof() )
+                    remaining += _keyScore( cursors[i]->currKey() ) + 1;
+            }
 
-            BSONObj key = cursor->currKey();
+            // best 'limit' scores so far, lowest on top, and the best score of the rest
+            priority_queue< double, vector<double>, greater<double> > best;
+            double restBest = 0;
+            for ( Scores::const_iterator i = _scores.begin(); i != _scores.end(); ++i ) {
+                if ( i->second <= 0 )
+                    continue;
+                best.push( i->second );
+                if ( best.size() > limit ) {
+                    restBest = max( restBest, best.top() );
+                    best.pop();
+                }
+            }
+
+            if ( best.size() < limit || best.top() <= restBest + remaining )
+                return false;
+
+            // The set is settled but its scores may still be missing terms we haven't reached.
+            const double threshold = best.top();
+            for ( Scores::const_iterator i = _scores.begin(); i != _scores.end(); ++i ) {
+                if ( i->second >= threshold )
+                    results->push( ScoredLocation( i->first, _fullScore( i->first ) ) );
+            }
+            return true;
+        }
 
+        /*
+         * Score of a document as a complete scan would have accumulated it in _process
+         * @param record, the document
+         */
+        double FTSSearch::_fullScore( Record* record ) {
+            _objectsLookedAt++;
+
+            // the index keys were built from exactly these weights
+            TermFrequencyMap termFreqs;
+            _ftsSpec.scoreDocument( BSONObj::make( record ), &termFreqs );
+
+            double score = 0;
+            const vector<string>& terms = _query.getTerms();
+            for ( unsigned i = 0; i < terms.size(); i++ ) {
+                TermFrequencyMap::const_iterator it = termFreqs.find( terms[i] );
+                if ( it == termFreqs.end() )
+                    continue;
+                if ( score )
+                    score += it->second * (1 + 1 / it->second);
+                else
+                    score += it->second;
+            }
+            return score;
+        }
+
+        double FTSSearch::_keyScore( const BSONObj& key ) const {
             BSONObjIterator i( key );
             for ( unsigned j = 0; j < _ftsSpec.numExtraBefore(); j++)
                 i.next();
             i.next(); // move past indexToken
-            BSONElement scoreElement = i.next();
+            return i.next().number();
+        }
+
+        /*
+         * Takes a cursor and updates the partial score for said cursor in _scores map
+         * @param cursor, btree cursor pointing to the current document to be scored
+         */
+        void FTSSearch::_process( BtreeCursor* cursor ) {
+            _keysLookedAt++;
 
-            double score = scoreElement.number();
+            double score = _keyScore( cursor->currKey() );
 
             double& cur = _scores[(cursor->currLoc()).rec()];
 
@@ -84,6 +84,14 @@ namespace mongo {
 
             void _process( BtreeCursor* cursor );
 
+            bool _stopEarly( const vector< shared_ptr<BtreeCursor> >& cursors,
+                             unsigned limit,
+                             Results* results );
+
+            double _fullScore( Record* record );
+
+            double _keyScore( const BSONObj& key ) const;
+
             /**
              * checks not index pieces
              * i.e. prhases & negated terms
@@ -42,6 +42,7 @@
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/s2_access_method.h"
 #include "mongo/db/index/s2_near_cursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_details.h"
@@ -90,6 +91,113 @@ namespace mongo {
         isSpherical = cmdObj["spherical"].trueValue();
     }
 
+    S2GeoNearSearch::S2GeoNearSearch(NamespaceDetails* nsd, int idxNo, const BSONObj& cmdObj)
+        : _cmdObj(cmdObj.getOwned()),
+          _args(_cmdObj),
+          _ns(nsd->idx(idxNo).parentNS()),
+          _mustAdvance(false) {
+
+        _descriptor.reset(CatalogHack::getDescriptor(nsd, idxNo));
+        _keyPattern = _descriptor->keyPattern().getOwned();
+        S2AccessMethod sam(_descriptor.get());
+        const S2IndexingParams& params = sam.getParams();
+        _radius = params.radius;
+        _cursor.reset(new S2NearIndexCursor(_descriptor.get(), params));
+
+        vector<string> geoFieldNames;
+        BSONObjIterator i(_keyPattern);
+        while (i.more()) {
+            BSONElement e = i.next();
+            if (e.type() == String && IndexNames::GEO_2DSPHERE == e.valuestr()) {
+                geoFieldNames.push_back(e.fieldName());
+            }
+        }
+
+        // NOTE(hk): If we add a new argument to geoNear, we could have a
+        // 2dsphere index with multiple indexed geo fields, and the geoNear
+        // could pick the one to run over.  Right now, we just require one.
+        uassert(16552, "geoNear requires exactly one indexed geo field", 1 == geoFieldNames.size());
+        _nearQuery = NearQuery(geoFieldNames[0]);
+        uassert(16679, "Invalid geometry given as arguments to geoNear: " + _cmdObj.toString(),
+                _nearQuery.parseFromGeoNear(_cmdObj, _radius));
+        uassert(16683, "geoNear on 2dsphere index requires spherical", _args.isSpherical);
+
+        // NOTE(hk): For a speedup, we could look through the query to see if
+        // we've geo-indexed any of the fields in it.
+        vector<GeoQuery> regions;
+
+        NearQuery nearQuery = _nearQuery;
+        if (FLAT == nearQuery.centroid.crs) {
+            nearQuery.maxDistance *= kRadiusOfEarthInMeters;
+            nearQuery.minDistance *= kRadiusOfEarthInMeters;
+        }
+
+        _cursor->seek(_args.query, nearQuery, regions);
+
+        // We do pass in the query above, but it's just so we can possibly use it in our index
+        // scan.  We have to do our own matching.
+        _matcher.reset(new Matcher(_args.query));
+    }
+
+    S2GeoNearSearch::~S2GeoNearSearch() { }
+
+    bool S2GeoNearSearch::getNext(BSONObj* objOut, double* distOut) {
+        if (_mustAdvance) {
+            _cursor->next();
+            _mustAdvance = false;
+        }
+
+        for (; !_cursor->isEOF(); _cursor->next()) {
+            BSONObj currObj = _cursor->getValue().obj();
+            if (!_matcher->matches(currObj)) { continue; }
+
+            double dist = _cursor->currentDistance();
+            // If we got the distance in radians, output it in radians too.
+            if (FLAT == _nearQuery.centroid.crs) { dist /= _radius; }
+            *distOut = dist * _args.distanceMultiplier;
+            *objOut = currObj;
+            _mustAdvance = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    void S2GeoNearSearch::appendLocs(const BSONObj& obj, BSONObjBuilder* out) const {
+        BSONElementSet geoFieldElements;
+        obj.getFieldsDotted(_nearQuery.field, geoFieldElements, false);
+        for (BSONElementSet::iterator oi = geoFieldElements.begin();
+                oi != geoFieldElements.end(); ++oi) {
+            if (oi->isABSONObj()) {
+                out->appendAs(*oi, "loc");
+            }
+        }
+    }
+
+    void S2GeoNearSearch::saveState() {
+        // Move past the document we last returned now, while it's still locked; the cursor
+        // forgets its position within the annulus when it saves.
+        if (_mustAdvance) {
+            _cursor->next();
+            _mustAdvance = false;
+        }
+        _cursor->savePosition();
+    }
+
+    bool S2GeoNearSearch::restoreState() {
+        // Other indexes may have been dropped, so ours may have moved.
+        NamespaceDetails* nsd = nsdetails(_ns);
+        if (NULL == nsd) { return false; }
+        int idxNo = nsd->findIndexByKeyPattern(_keyPattern);
+        if (-1 == idxNo) { return false; }
+
+        _descriptor.reset(CatalogHack::getDescriptor(nsd, idxNo));
+        _cursor->setDescriptor(_descriptor.get());
+        return _cursor->restorePosition().isOK();
+    }
+
+    long long S2GeoNearSearch::nscanned() const { return _cursor->nscanned(); }
+
     class Geo2dFindNearCmd : public Command {
     public:
         Geo2dFindNearCmd() : Command("geoNear") {}
@@ -170,62 +278,17 @@ namespace mongo {
         static bool run2DSphereGeoNear(NamespaceDetails* nsDetails, int idxNo, BSONObj& cmdObj,
                                        const GeoNearArguments &parsedArgs, string& errmsg,
                                        BSONObjBuilder& result) {
-            auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(nsDetails, idxNo));
-            auto_ptr<S2AccessMethod> sam(new S2AccessMethod(descriptor.get()));
-            const S2IndexingParams& params = sam->getParams();
-            auto_ptr<S2NearIndexCursor> nic(new S2NearIndexCursor(descriptor.get(), params));
-
-            vector<string> geoFieldNames;
-            BSONObjIterator i(descriptor->keyPattern());
-            while (i.more()) {
-                BSONElement e = i.next();
-                if (e.type() == String && IndexNames::GEO_2DSPHERE == e.valuestr()) {
-                    geoFieldNames.push_back(e.fieldName());
-                }
-            }
-
-            // NOTE(hk): If we add a new argument to geoNear, we could have a
-            // 2dsphere index with multiple indexed geo fields, and the geoNear
-            // could pick the one to run over.  Right now, we just require one.
-            uassert(16552, "geoNear requires exactly one indexed geo field", 1 == geoFieldNames.size());
-            NearQuery nearQuery(geoFieldNames[0]);
-            uassert(16679, "Invalid geometry given as arguments to geoNear: " + cmdObj.toString(),
-                    nearQuery.parseFromGeoNear(cmdObj, params.radius));
-            uassert(16683, "geoNear on 2dsphere index requires spherical",
-                    parsedArgs.isSpherical);
-
-            // NOTE(hk): For a speedup, we could look through the query to see if
-            // we've geo-indexed any of the fields in it.
-            vector<GeoQuery> regions;
-
-            if (FLAT == nearQuery.centroid.crs) {
-                nearQuery.maxDistance *= kRadiusOfEarthInMeters;
-                nearQuery.minDistance *= kRadiusOfEarthInMeters;
-            }
-
-            nic->seek(parsedArgs.query, nearQuery, regions);
-
-            // We do pass in the query above, but it's just so we can possibly use it in our index
-            // scan.  We have to do our own matching.
-            auto_ptr<Matcher> matcher(new Matcher(parsedArgs.query));
+            S2GeoNearSearch search(nsDetails, idxNo, cmdObj);
 
             double totalDistance = 0;
             BSONObjBuilder resultBuilder(result.subarrayStart("results"));
             double farthestDist = 0;
 
             int results;
-            for (results = 0; results < parsedArgs.numWanted && !nic->isEOF(); ++results) {
-                BSONObj currObj = nic->getValue().obj();
-                if (!matcher->matches(currObj)) {
-                    --results;
-                    nic->next();
-                    continue;
-                }
-
-                double dist = nic->currentDistance();
-                // If we got the distance in radians, output it in radians too.
-                if (FLAT == nearQuery.centroid.crs) { dist /= params.radius; }
-                dist *= parsedArgs.distanceMultiplier;
+            BSONObj currObj;
+            double dist;
+            for (results = 0; results < parsedArgs.numWanted && search.getNext(&currObj, &dist);
+                 ++results) {
                 totalDistance += dist;
                 if (dist > farthestDist) { farthestDist = dist; }
 
@@ -233,25 +296,17 @@ namespace mongo {
                     resultBuilder.subobjStart(BSONObjBuilder::numStr(results)));
                 oneResultBuilder.append("dis", dist);
                 if (parsedArgs.includeLocs) {
-                    BSONElementSet geoFieldElements;
-                    currObj.getFieldsDotted(geoFieldNames[0], geoFieldElements, false);
-                    for (BSONElementSet::iterator oi = geoFieldElements.begin();
-                            oi != geoFieldElements.end(); ++oi) {
-                        if (oi->isABSONObj()) {
-                            oneResultBuilder.appendAs(*oi, "loc");
-                        }
-                    }
+                    search.appendLocs(currObj, &oneResultBuilder);
                 }
 
                 oneResultBuilder.append("obj", currObj);
                 oneResultBuilder.done();
-                nic->next();
             }
 
             resultBuilder.done();
 
             BSONObjBuilder stats(result.subobjStart("stats"));
-            stats.appendNumber("nscanned", nic->nscanned());
+            stats.appendNumber("nscanned", search.nscanned());
             stats.append("avgDistance", totalDistance / results);
             stats.append("maxDistance", farthestDist);
             stats.append("time", cc().curop()->elapsedMillis());
@@ -28,9 +28,19 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <string>
+
+#include "mongo/db/geo/geoquery.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher.h"
 
 namespace mongo {
+
+    class IndexDescriptor;
+    class NamespaceDetails;
+    class S2NearIndexCursor;
+
     // Arguments in common between 2d and 2dsphere geoNear.
     class GeoNearArguments {
     public:
@@ -44,4 +54,58 @@ namespace mongo {
     private:
         GeoNearArguments() { }
     };
+
+    /**
+     * A geoNear over a 2dsphere index, returning the matching documents nearest first.  The search
+     * can be paused with saveState() while the collection is unlocked and resumed with
+     * restoreState(), so its results can be consumed a batch at a time.
+     */
+    class S2GeoNearSearch {
+    public:
+        /**
+         * Starts the search described by the geoNear command 'cmdObj' over the 2dsphere index
+         * 'idxNo' of 'nsd'.  Throws if the command's arguments are bad.
+         */
+        S2GeoNearSearch(NamespaceDetails* nsd, int idxNo, const BSONObj& cmdObj);
+        ~S2GeoNearSearch();
+
+        /**
+         * Sets '*objOut' to the next document matching the command's query and '*distOut' to its
+         * distance, in the units the command reports.  Returns false if there are none left.
+         * '*objOut' is not owned and is only valid until the lock is released.
+         */
+        bool getNext(BSONObj* objOut, double* distOut);
+
+        /** Appends the indexed geometry of 'obj' as "loc", as the command's includeLocs does. */
+        void appendLocs(const BSONObj& obj, BSONObjBuilder* out) const;
+
+        /** Call before the collection is unlocked. */
+        void saveState();
+
+        /**
+         * Call once the collection is locked again.  Returns false if the collection or the index
+         * went away in the meantime, in which case the search can't go on.
+         */
+        bool restoreState();
+
+        long long nscanned() const;
+
+        const GeoNearArguments& getArguments() const { return _args; }
+
+    private:
+        const BSONObj _cmdObj;
+        const GeoNearArguments _args;
+
+        const std::string _ns;
+        BSONObj _keyPattern;
+        boost::scoped_ptr<IndexDescriptor> _descriptor;
+        boost::scoped_ptr<S2NearIndexCursor> _cursor;
+
+        NearQuery _nearQuery;
+        double _radius;
+        boost::scoped_ptr<Matcher> _matcher;
+
+        // The cursor is still on the last document returned; it moves on at the next getNext().
+        bool _mustAdvance;
+    };
 }  // namespace mongo
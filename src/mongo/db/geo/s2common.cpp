@@ -54,6 +54,16 @@ namespace mongo {
 
     bool S2SearchUtil::getKeysForObject(const BSONObj& obj, const S2IndexingParams& params,
                                         vector<string>* out) {
+        // A point's covering is the one cell at finestIndexedLevel that contains it, so emit that
+        // directly rather than allocating a container and running the coverer.
+        if (GeoParser::isPoint(obj)) {
+            PointWithCRS point;
+            if (!GeoParser::parsePoint(obj, &point)) { return false; }
+            out->push_back(S2CellId::FromPoint(point.point)
+                           .parent(params.finestIndexedLevel).toString());
+            return true;
+        }
+
         S2RegionCoverer coverer;
         params.configureCoverer(&coverer);
 
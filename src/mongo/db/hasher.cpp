@@ -52,10 +52,12 @@ namespace mongo {
     }
 
     long long int BSONElementHasher::hash64( const BSONElement& e , HashSeed seed ){
-        scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
-        recursiveHash( h.get() , e , false );
+        // On the stack rather than from HasherFactory: this runs once per hashed index key and
+        // the MD5 state is small, so the allocation was a noticeable part of the cost.
+        Hasher h( seed );
+        recursiveHash( &h , e , false );
         HashDigest d;
-        h->finish(d);
+        h.finish(d);
         //HashDigest is actually 16 bytes, but we just get 8 via truncation
         // NOTE: assumes little-endian
         return *reinterpret_cast< long long int * >( d );
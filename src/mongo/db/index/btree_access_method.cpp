@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/index/btree_based_builder.h"
 #include "mongo/db/index/btree_index_cursor.h"
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/jsobj.h"
@@ -57,6 +58,17 @@ namespace mongo {
         // Delegate to the subclass.
         getKeys(obj, &keys);
 
+        if (IndexSideWrites* side = sideWrites()) {
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                side->insert(*i, loc);
+            }
+            *numInserted = keys.size();
+            if (*numInserted > 1) {
+                _descriptor->setMultikey();
+            }
+            return Status::OK();
+        }
+
         Status ret = Status::OK();
 
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
@@ -118,6 +130,14 @@ namespace mongo {
         getKeys(obj, &keys);
         *numDeleted = 0;
 
+        if (IndexSideWrites* side = sideWrites()) {
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                side->remove(*i, loc);
+            }
+            *numDeleted = keys.size();
+            return Status::OK();
+        }
+
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
             bool thisKeyOK = removeOneKey(*i, loc);
 
@@ -152,7 +172,19 @@ namespace mongo {
         }
     }
 
+    IndexSideWrites* BtreeBasedAccessMethod::sideWrites() {
+        if (!_descriptor->isBackgroundIndex()) {
+            return NULL;
+        }
+        return IndexSideWrites::get(_descriptor->indexNamespace());
+    }
+
     Status BtreeBasedAccessMethod::touch(const BSONObj& obj) {
+        if (_descriptor->getHead().isNull()) {
+            // Being bulk built.
+            return Status::OK();
+        }
+
         BSONObjSet keys;
         getKeys(obj, &keys);
 
@@ -179,6 +211,14 @@ namespace mongo {
         BtreeBasedPrivateUpdateData *data = new BtreeBasedPrivateUpdateData();
         status->_indexSpecificUpdateData.reset(data);
 
+        if (keysUnchanged(from, to)) {
+            // Nothing to add or remove.
+            data->loc = record;
+            data->dupsAllowed = options.dupsAllowed;
+            status->_isValid = true;
+            return Status::OK();
+        }
+
         getKeys(from, &data->oldKeys);
         getKeys(to, &data->newKeys);
         data->loc = record;
@@ -187,7 +227,9 @@ namespace mongo {
         setDifference(data->oldKeys, data->newKeys, &data->removed);
         setDifference(data->newKeys, data->oldKeys, &data->added);
 
+        // The btree of an index being bulk built is incomplete, uniqueness is checked at the end.
         bool checkForDups = !data->added.empty()
+            && NULL == sideWrites()
             && (KeyPattern::isIdKeyPattern(_descriptor->keyPattern()) || _descriptor->unique())
             && !options.dupsAllowed;
 
@@ -221,6 +263,17 @@ namespace mongo {
             _descriptor->setMultikey();
         }
 
+        if (IndexSideWrites* side = sideWrites()) {
+            for (size_t i = 0; i < data->added.size(); ++i) {
+                side->insert(*data->added[i], data->loc);
+            }
+            for (size_t i = 0; i < data->removed.size(); ++i) {
+                side->remove(*data->removed[i], data->loc);
+            }
+            *numUpdated = data->added.size();
+            return Status::OK();
+        }
+
         for (size_t i = 0; i < data->added.size(); ++i) {
             _interface->bt_insert(_descriptor->getHead(), data->loc, *data->added[i], _ordering,
                                   data->dupsAllowed, _descriptor->getOnDisk(), true);
@@ -236,6 +289,67 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status BtreeBasedAccessMethod::updateAndMove(const UpdateTicket& ticket, const DiskLoc& newLoc,
+                                                 int64_t* numUpdated) {
+        if (!ticket._isValid) {
+            return Status(ErrorCodes::InternalError, "Invalid updateticket in updateAndMove");
+        }
+
+        BtreeBasedPrivateUpdateData* data =
+            static_cast<BtreeBasedPrivateUpdateData*>(ticket._indexSpecificUpdateData.get());
+
+        if (data->oldKeys.size() + data->added.size() - data->removed.size() > 1) {
+            _descriptor->setMultikey();
+        }
+
+        // Keys of both the old and new document, which only need to point at the new loc.
+        vector<const BSONObj*> kept;
+        for (BSONObjSet::const_iterator i = data->oldKeys.begin(); i != data->oldKeys.end(); ++i) {
+            if (data->newKeys.count(*i)) {
+                kept.push_back(&*i);
+            }
+        }
+
+        if (IndexSideWrites* side = sideWrites()) {
+            for (size_t i = 0; i < kept.size(); ++i) {
+                side->remove(*kept[i], data->loc);
+                side->insert(*kept[i], newLoc);
+            }
+            for (size_t i = 0; i < data->added.size(); ++i) {
+                side->insert(*data->added[i], newLoc);
+            }
+            for (size_t i = 0; i < data->removed.size(); ++i) {
+                side->remove(*data->removed[i], data->loc);
+            }
+            *numUpdated = data->added.size();
+            return Status::OK();
+        }
+
+        for (size_t i = 0; i < kept.size(); ++i) {
+            if (!_interface->relocate(_descriptor->getHead(), _descriptor->getOnDisk(), *kept[i],
+                                      data->loc, newLoc)) {
+                _interface->unindex(_descriptor->getHead(), _descriptor->getOnDisk(), *kept[i],
+                                    data->loc);
+                _interface->bt_insert(_descriptor->getHead(), newLoc, *kept[i], _ordering,
+                                      true, _descriptor->getOnDisk(), true);
+            }
+        }
+
+        for (size_t i = 0; i < data->added.size(); ++i) {
+            _interface->bt_insert(_descriptor->getHead(), newLoc, *data->added[i], _ordering,
+                                  data->dupsAllowed, _descriptor->getOnDisk(), true);
+        }
+
+        for (size_t i = 0; i < data->removed.size(); ++i) {
+            _interface->unindex(_descriptor->getHead(), _descriptor->getOnDisk(), *data->removed[i],
+                                data->loc);
+        }
+
+        *numUpdated = data->added.size();
+
+        return Status::OK();
+    }
+
     // Standard Btree implementation below.
     BtreeAccessMethod::BtreeAccessMethod(IndexDescriptor* descriptor)
         : BtreeBasedAccessMethod(descriptor) {
@@ -39,6 +39,8 @@
 
 namespace mongo {
 
+    class IndexSideWrites;
+
     /**
      * Any access method that is Btree based subclasses from this.
      *
@@ -70,6 +72,9 @@ namespace mongo {
 
         virtual Status update(const UpdateTicket& ticket, int64_t* numUpdated);
 
+        virtual Status updateAndMove(const UpdateTicket& ticket, const DiskLoc& newLoc,
+                                     int64_t* numUpdated);
+
         virtual Status newCursor(IndexCursor **out) = 0;
 
         virtual Status touch(const BSONObj& obj);
@@ -85,6 +90,13 @@ namespace mongo {
 
         virtual void getKeys(const BSONObj &obj, BSONObjSet *keys) = 0;
 
+        /**
+         * Returns true if 'from' and 'to' are known to generate the same keys, so that
+         * validateUpdate can skip generating them.  Only worth overriding where key generation is
+         * expensive; the default never skips.
+         */
+        virtual bool keysUnchanged(const BSONObj& from, const BSONObj& to) { return false; }
+
         IndexDescriptor* _descriptor;
         Ordering _ordering;
 
@@ -93,6 +105,9 @@ namespace mongo {
 
     private:
         bool removeOneKey(const BSONObj& key, const DiskLoc& loc);
+
+        // Where our writes go instead of the btree while we're being bulk built, or NULL.
+        IndexSideWrites* sideWrites();
     };
 
     /**
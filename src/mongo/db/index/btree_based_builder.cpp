@@ -28,13 +28,16 @@
 
 #include "mongo/db/index/btree_based_builder.h"
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/btreebuilder.h"
+#include "mongo/db/db.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/runner_yield_policy.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/sort_phase_one.h"
@@ -44,6 +47,14 @@ namespace mongo {
 
     int oldCompare(const BSONObj& l,const BSONObj& r, const Ordering &o); // key.cpp
 
+    // Memory for sorting the keys of an index build before spilling to disk.  When several
+    // indexes are built from one scan they split it.
+    static const long phaseOneMemoryBytes = 100 * 1024 * 1024;
+
+    // the indexes being bulk built in the background, by index namespace
+    static SimpleMutex sideWritesMutex("IndexSideWrites");
+    static map<string, IndexSideWrites*> sideWritesByIndex;
+
     class ExternalSortComparisonV0 : public ExternalSortComparison {
     public:
         ExternalSortComparisonV0(const BSONObj& ordering) : _ordering(Ordering::make(ordering)) { }
@@ -135,6 +146,58 @@ namespace mongo {
         }
     }
 
+    /**
+     * Like buildBottomUpPhases2And3, but yields the lock now and then.  Duplicates are let into
+     * unique indexes at first, since one of them may just be the old version of a document which
+     * has since changed; such keys are added to mayBeDuplicate to be checked at the end.
+     */
+    template< class V >
+    static void backgroundBuildBottomUp( const char* ns,
+                                         NamespaceDetails* d,
+                                         const string& idxName,
+                                         bool dupsAllowed,
+                                         SortPhaseOne* phase1,
+                                         vector<BSONObj>* mayBeDuplicate,
+                                         CurOp* op,
+                                         ProgressMeterHolder& pm ) {
+        IndexDetails* idx = &d->idx(IndexBuildsInProgress::get(ns, idxName));
+        BtreeBuilder<V> btBuilder(true, *idx);
+        RunnerYieldPolicy yieldPolicy;
+        BSONObj keyLast;
+        bool first = true;
+        auto_ptr<BSONObjExternalSorter::Iterator> i = phase1->sorter->iterator();
+        verify(pm == op->setMessage("index: (2/3) btree bottom up",
+                                    "Index: (2/3) BTree Bottom Up Progress",
+                                    phase1->nkeys,
+                                    10));
+        while( i->more() ) {
+            RARELY killCurrentOp.checkForInterrupt();
+            ExternalSortDatum datum = i->next();
+
+            if ( !dupsAllowed ) {
+                // compare the keys only
+                if ( !first && 0 == phase1->sortCmp->compare(make_pair(keyLast, DiskLoc()),
+                                                             make_pair(datum.first, DiskLoc())) ) {
+                    mayBeDuplicate->push_back(keyLast);
+                }
+                keyLast = datum.first.getOwned();
+                first = false;
+            }
+
+            btBuilder.addKey(datum.first, datum.second);
+            pm.hit();
+
+            if ( yieldPolicy.shouldYield() ) {
+                yieldPolicy.yield();
+                idx = &d->idx(IndexBuildsInProgress::get(ns, idxName));
+                btBuilder.relocked(*idx);
+            }
+        }
+        pm.finished();
+        op->setMessage("index: (3/3) btree-middle", "Index: (3/3) BTree Middle Progress");
+        btBuilder.commit(true);
+    }
+
     DiskLoc BtreeBasedBuilder::makeEmptyIndex(const IndexDetails& idx) {
         if (0 == idx.version()) {
             return BtreeBucket<V0>::addBucket(idx);
@@ -160,23 +223,47 @@ namespace mongo {
                            int64_t nrecords,
                            ProgressMeter* progressMeter,
                            bool mayInterrupt, int idxNo) {
+        addKeysToPhaseOnes(d, ns, vector<int>(1, idxNo), vector<SortPhaseOne*>(1, phaseOne),
+                           progressMeter, mayInterrupt);
+    }
+
+    void BtreeBasedBuilder::addKeysToPhaseOnes(NamespaceDetails* d, const char* ns,
+                                               const vector<int>& idxNos,
+                                               const vector<SortPhaseOne*>& phaseOnes,
+                                               ProgressMeter* progressMeter,
+                                               bool mayInterrupt) {
+        verify(idxNos.size() == phaseOnes.size());
+
+        // the sorters share the memory one index build would have had
+        const long sorterBytes = phaseOneMemoryBytes / static_cast<long>(idxNos.size());
+
+        OwnedPointerVector<IndexDescriptor> descs;
+        OwnedPointerVector<BtreeBasedAccessMethod> iams;
+        for (size_t i = 0; i < idxNos.size(); ++i) {
+            const IndexDetails& idx = d->idx(idxNos[i]);
+            SortPhaseOne* phaseOne = phaseOnes[i];
+            phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
+            phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get(),
+                                                             sorterBytes));
+            phaseOne->sorter->hintNumObjects(d->numRecords());
+            descs.mutableVector().push_back(CatalogHack::getDescriptor(d, idxNos[i]));
+            iams.mutableVector().push_back(CatalogHack::getBtreeBasedIndex(descs.vector()[i]));
+        }
+
         auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
-        phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
-        phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get()));
-        phaseOne->sorter->hintNumObjects( nrecords );
-        auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
-        auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
         BSONObj o;
         DiskLoc loc;
         Runner::RunnerState state;
         while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&o, &loc))) {
             RARELY killCurrentOp.checkForInterrupt( !mayInterrupt );
-            BSONObjSet keys;
-            iam->getKeys(o, &keys);
-            phaseOne->addKeys(keys, loc, mayInterrupt);
+            for (size_t i = 0; i < iams.size(); ++i) {
+                BSONObjSet keys;
+                iams.vector()[i]->getKeys(o, &keys);
+                phaseOnes[i]->addKeys(keys, loc, mayInterrupt);
+            }
             progressMeter->hit();
             if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2))
-                && phaseOne->n % 10000 == 0 ) {
+                && phaseOnes[0]->n % 10000 == 0 ) {
                 printMemInfo( "\t iterating objects" );
             }
         }
@@ -188,17 +275,20 @@ namespace mongo {
     uint64_t BtreeBasedBuilder::fastBuildIndex(const char* ns, NamespaceDetails* d,
                                                IndexDetails& idx, bool mayInterrupt,
                                                int idxNo) {
+        return fastBuildIndexes(ns, d, vector<int>(1, idxNo), mayInterrupt);
+    }
+
+    uint64_t BtreeBasedBuilder::fastBuildIndexes(const char* ns, NamespaceDetails* d,
+                                                 const vector<int>& idxNos, bool mayInterrupt) {
         CurOp * op = cc().curop();
 
         Timer t;
 
-        MONGO_TLOG(1) << "fastBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
-
-        bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
-        bool dropDups = idx.dropDups() || inDBRepair;
-        BSONObj order = idx.keyPattern();
-
-        getDur().writingDiskLoc(idx.head).Null();
+        for (size_t i = 0; i < idxNos.size(); ++i) {
+            IndexDetails& idx = d->idx(idxNos[i]);
+            MONGO_TLOG(1) << "fastBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
+            getDur().writingDiskLoc(idx.head).Null();
+        }
 
         if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
             printMemInfo( "before index start" );
@@ -208,62 +298,277 @@ namespace mongo {
                                               "Index: (1/3) External Sort Progress",
                                               d->numRecords(),
                                               10));
-        SortPhaseOne phase1;
-        addKeysToPhaseOne(d, ns, idx, order, &phase1, d->numRecords(), pm.get(),
-                          mayInterrupt, idxNo );
+        vector<SortPhaseOne> phase1(idxNos.size());
+        vector<SortPhaseOne*> phase1Ptrs;
+        for (size_t i = 0; i < phase1.size(); ++i) {
+            phase1Ptrs.push_back(&phase1[i]);
+        }
+        addKeysToPhaseOnes(d, ns, idxNos, phase1Ptrs, pm.get(), mayInterrupt);
         pm.finished();
 
-        BSONObjExternalSorter& sorter = *(phase1.sorter);
+        set<DiskLoc> dupsToDrop;
+        bool anyDropDups = false;
+
+        for (size_t i = 0; i < idxNos.size(); ++i) {
+            IndexDetails& idx = d->idx(idxNos[i]);
+            bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
+            bool dropDups = idx.dropDups() || inDBRepair;
+            anyDropDups = anyDropDups || dropDups;
+
+            BSONObjExternalSorter& sorter = *(phase1[i].sorter);
+
+            if( phase1[i].multi ) {
+                d->setIndexIsMultikey(ns, idxNos[i]);
+            }
+
+            if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
+                printMemInfo( "before final sort" );
+            sorter.sort( mayInterrupt );
+            if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
+                printMemInfo( "after final sort" );
+
+            LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles()
+                                         << " files " << " in " << t.seconds() << " secs" << endl;
+
+            /* build index --- */
+            if( idx.version() == 0 )
+                buildBottomUpPhases2And3<V0>(dupsAllowed,
+                                             idx,
+                                             sorter,
+                                             dropDups,
+                                             dupsToDrop,
+                                             op,
+                                             &phase1[i],
+                                             pm,
+                                             t,
+                                             mayInterrupt);
+            else if( idx.version() == 1 )
+                buildBottomUpPhases2And3<V1>(dupsAllowed,
+                                             idx,
+                                             sorter,
+                                             dropDups,
+                                             dupsToDrop,
+                                             op,
+                                             &phase1[i],
+                                             pm,
+                                             t,
+                                             mayInterrupt);
+            else
+                verify(false);
+
+            // the sorted keys may be large; don't hold them while building the next index
+            phase1[i].sorter.reset();
+        }
+
+        // Every index is built by now, so dropping a duplicate removes it from all of them.
+        if( anyDropDups )
+            log() << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
+
+        BtreeBasedBuilder::doDropDups(ns, d, dupsToDrop, mayInterrupt);
+
+        return phase1.empty() ? 0 : phase1[0].n;
+    }
+
+    uint64_t BtreeBasedBuilder::backgroundBuildIndex(const char* ns, NamespaceDetails* d,
+                                                     IndexDetails& idx) {
+        CurOp * op = cc().curop();
+
+        Timer t;
+
+        MONGO_TLOG(1) << "backgroundBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
+
+        // After a yield idx may point at a different index (see insert_makeIndex), so the index
+        // is looked up by name again after each.
+        const string idxName = idx.indexName();
+        const int version = idx.version();
+        const bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
+        int idxNo = IndexBuildsInProgress::get(ns, idxName);
+
+        IndexSideWrites sideWrites(idx.indexNamespace());
+        getDur().writingDiskLoc(idx.head).Null();
+
+        /* get and sort all the keys ----- */
+        ProgressMeterHolder pm(op->setMessage("index: (1/3) external sort",
+                                              "Index: (1/3) External Sort Progress",
+                                              d->numRecords(),
+                                              10));
+        SortPhaseOne phase1;
+        phase1.sortCmp.reset(getComparison(version, idx.keyPattern()));
+        phase1.sorter.reset(new BSONObjExternalSorter(phase1.sortCmp.get()));
+        phase1.sorter->hintNumObjects(d->numRecords());
+        {
+            auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
+            // We're not delegating yielding to the runner because we need to know when a yield
+            // happens.
+            RunnerYieldPolicy yieldPolicy;
+            auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
+            auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
+            BSONObj o;
+            DiskLoc loc;
+            Runner::RunnerState state;
+            while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&o, &loc))) {
+                RARELY killCurrentOp.checkForInterrupt();
+                BSONObjSet keys;
+                iam->getKeys(o, &keys);
+                phase1.addKeys(keys, loc, true);
+                pm.hit();
+
+                if (yieldPolicy.shouldYield()) {
+                    if (!yieldPolicy.yieldAndCheckIfOK(runner.get())) {
+                        uasserted(17198, "cursor gone during bg index");
+                    }
+                    pm->setTotalWhileRunning(d->numRecords());
+                    idxNo = IndexBuildsInProgress::get(ns, idxName);
+                    desc.reset(CatalogHack::getDescriptor(d, idxNo));
+                    iam.reset(CatalogHack::getBtreeBasedIndex(desc.get()));
+                }
+            }
+            uassert(17191, "Internal error reading docs from collection",
+                    Runner::RUNNER_EOF == state);
+        }
+        pm.finished();
 
         if( phase1.multi ) {
             d->setIndexIsMultikey(ns, idxNo);
         }
 
-        if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
-            printMemInfo( "before final sort" );
-        phase1.sorter->sort( mayInterrupt );
-        if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
-            printMemInfo( "after final sort" );
-
-        LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles()
+        {
+            // The sorter only holds copies of the keys, so writers (replication applying the
+            // oplog, on a secondary) can go on while it sorts them.  Their writes are recorded
+            // in sideWrites.
+            dbtempreleasecond unlock;
+            phase1.sorter->sort(true);
+        }
+        LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << phase1.sorter->numFiles()
                                      << " files " << " in " << t.seconds() << " secs" << endl;
 
-        set<DiskLoc> dupsToDrop;
-
         /* build index --- */
-        if( idx.version() == 0 )
-            buildBottomUpPhases2And3<V0>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         &phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
-        else if( idx.version() == 1 ) 
-            buildBottomUpPhases2And3<V1>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         &phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
+        vector<BSONObj> mayBeDuplicate;
+        if( version == 0 )
+            backgroundBuildBottomUp<V0>(ns, d, idxName, dupsAllowed, &phase1, &mayBeDuplicate,
+                                        op, pm);
+        else if( version == 1 )
+            backgroundBuildBottomUp<V1>(ns, d, idxName, dupsAllowed, &phase1, &mayBeDuplicate,
+                                        op, pm);
         else
             verify(false);
 
-        if( dropDups ) 
-            log() << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
+        /* catch up with the writes made meanwhile --- */
+        op->setMessage("index: applying concurrent writes");
+        applySideWrites(ns, d, idxName, &sideWrites, dupsAllowed, &mayBeDuplicate);
 
-        BtreeBasedBuilder::doDropDups(ns, d, dupsToDrop, mayInterrupt);
+        if( !dupsAllowed )
+            checkNoDuplicates(ns, d, idxName, mayBeDuplicate);
 
         return phase1.n;
     }
 
+    void BtreeBasedBuilder::applySideWrites(const char* ns, NamespaceDetails* d,
+                                            const string& idxName, IndexSideWrites* sideWrites,
+                                            bool dupsAllowed, vector<BSONObj>* mayBeDuplicate) {
+        // Apply the writes in batches, yielding after the big ones.  Once a batch has been applied
+        // without yielding there can't be any newer ones, as we hold the write lock.
+        const size_t maxFinalBatch = 1000;
+        RunnerYieldPolicy yieldPolicy;
+        while ( true ) {
+            vector<IndexSideWrites::Write> writes;
+            sideWrites->take(&writes);
+            if ( writes.empty() )
+                break;
+
+            auto_ptr<IndexDescriptor> desc(
+                CatalogHack::getDescriptor(d, IndexBuildsInProgress::get(ns, idxName)));
+            auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
+            for ( vector<IndexSideWrites::Write>::const_iterator i = writes.begin();
+                  i != writes.end(); ++i ) {
+                RARELY killCurrentOp.checkForInterrupt();
+                // Writes which the collection scan already saw are applied again, which is
+                // harmless: the last write of a (key, loc) pair wins.
+                if ( i->insert ) {
+                    try {
+                        iam->_interface->bt_insert(desc->getHead(), i->loc, i->key,
+                                                   iam->_ordering, true, desc->getOnDisk(), true);
+                    }
+                    catch( AssertionException& e ) {
+                        // 10287: key already in index
+                        if ( 10287 != e.getCode() )
+                            throw;
+                    }
+                    if ( !dupsAllowed )
+                        mayBeDuplicate->push_back(i->key);
+                }
+                else {
+                    iam->_interface->unindex(desc->getHead(), desc->getOnDisk(), i->key, i->loc);
+                }
+                getDur().commitIfNeeded();
+            }
+
+            if ( writes.size() > maxFinalBatch )
+                yieldPolicy.yield();
+        }
+    }
+
+    void BtreeBasedBuilder::checkNoDuplicates(const char* ns, NamespaceDetails* d,
+                                              const string& idxName,
+                                              const vector<BSONObj>& mayBeDuplicate) {
+        auto_ptr<IndexDescriptor> desc(
+            CatalogHack::getDescriptor(d, IndexBuildsInProgress::get(ns, idxName)));
+        auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
+        BtreeInterface* interface = iam->_interface;
+        for ( vector<BSONObj>::const_iterator i = mayBeDuplicate.begin();
+              i != mayBeDuplicate.end(); ++i ) {
+            RARELY killCurrentOp.checkForInterrupt();
+            int pos;
+            bool found;
+            DiskLoc bucket = interface->locate(desc->getOnDisk(), desc->getHead(), *i,
+                                               iam->_ordering, pos, found, minDiskLoc);
+            int n = 0;
+            while ( !bucket.isNull() ) {
+                if ( interface->keyIsUsed(bucket, pos) ) {
+                    if ( 0 != interface->keyAt(bucket, pos).woCompare(*i, iam->_ordering, false) )
+                        break;
+                    uassert(ASSERT_ID_DUPKEY,
+                            interface->dupKeyError(desc->getHead(), desc->getOnDisk(), *i),
+                            ++n < 2);
+                }
+                bucket = interface->advance(bucket, pos, 1, "checkNoDuplicates");
+            }
+        }
+    }
+
+    IndexSideWrites::IndexSideWrites(const string& indexNs)
+        : _indexNs(indexNs), _mutex("IndexSideWrites") {
+        SimpleMutex::scoped_lock lk(sideWritesMutex);
+        verify(sideWritesByIndex.insert(make_pair(_indexNs, this)).second);
+    }
+
+    IndexSideWrites::~IndexSideWrites() {
+        SimpleMutex::scoped_lock lk(sideWritesMutex);
+        sideWritesByIndex.erase(_indexNs);
+    }
+
+    IndexSideWrites* IndexSideWrites::get(const string& indexNs) {
+        SimpleMutex::scoped_lock lk(sideWritesMutex);
+        map<string, IndexSideWrites*>::const_iterator i = sideWritesByIndex.find(indexNs);
+        return i == sideWritesByIndex.end() ? NULL : i->second;
+    }
+
+    void IndexSideWrites::insert(const BSONObj& key, const DiskLoc& loc) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _writes.push_back(Write(key, loc, true));
+    }
+
+    void IndexSideWrites::remove(const BSONObj& key, const DiskLoc& loc) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _writes.push_back(Write(key, loc, false));
+    }
+
+    void IndexSideWrites::take(vector<Write>* out) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        out->swap(_writes);
+        _writes.clear();
+    }
+
     void BtreeBasedBuilder::doDropDups(const char* ns, NamespaceDetails* d,
                                        const set<DiskLoc>& dupsToDrop, bool mayInterrupt) {
 
@@ -29,9 +29,11 @@
 #pragma once
 
 #include <set>
+#include <vector>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace IndexUpdateTests {
     class AddKeysToPhaseOne;
@@ -50,6 +52,45 @@ namespace mongo {
     class ProgressMeterHolder;
     struct SortPhaseOne;
 
+    /**
+     * While an index is bulk built in the background the changes which concurrent writes make to
+     * it are recorded here, in order, instead of being applied to its btree.  They are applied
+     * once the btree has been built from the sorted keys of the collection.
+     */
+    class IndexSideWrites : boost::noncopyable {
+    public:
+        struct Write {
+            Write(const BSONObj& k, const DiskLoc& l, bool i) : key(k.getOwned()), loc(l),
+                                                                 insert(i) { }
+            BSONObj key;
+            DiskLoc loc;
+            bool insert; // otherwise a remove
+        };
+
+        /** Starts recording the writes to the index with namespace indexNs. */
+        IndexSideWrites(const string& indexNs);
+
+        /** Stops recording. */
+        ~IndexSideWrites();
+
+        /**
+         * @return the side writes of the index with namespace indexNs, or NULL if that index is
+         * not being bulk built.
+         */
+        static IndexSideWrites* get(const string& indexNs);
+
+        void insert(const BSONObj& key, const DiskLoc& loc);
+        void remove(const BSONObj& key, const DiskLoc& loc);
+
+        /** Moves the writes recorded so far to out. */
+        void take(vector<Write>* out);
+
+    private:
+        const string _indexNs;
+        SimpleMutex _mutex; // writers of a collection may run in parallel on a secondary
+        vector<Write> _writes;
+    };
+
     class BtreeBasedBuilder {
     public:
         /**
@@ -57,6 +98,25 @@ namespace mongo {
          */
         static uint64_t fastBuildIndex(const char* ns, NamespaceDetails* d, IndexDetails& idx,
                                        bool mayInterrupt, int idxNo);
+
+        /**
+         * Builds the indexes numbered idxNos like fastBuildIndex, but reads the collection once
+         * for all of them, feeding the keys of each document to one sorter per index.  Throws
+         * DBException, leaving the indexes half built for the caller to roll back.
+         * @return the number of documents scanned
+         */
+        static uint64_t fastBuildIndexes(const char* ns, NamespaceDetails* d,
+                                         const vector<int>& idxNos, bool mayInterrupt);
+
+        /**
+         * Builds background index idx like fastBuildIndex, but yields while scanning the
+         * collection and building the bottom level of the btree.  Writes made meanwhile are
+         * recorded in an IndexSideWrites and applied at the end under the write lock.  Uniqueness
+         * is checked once the side writes have been applied.  Doesn't support dropDups.  Throws
+         * DBException.
+         */
+        static uint64_t backgroundBuildIndex(const char* ns, NamespaceDetails* d,
+                                             IndexDetails& idx);
         static DiskLoc makeEmptyIndex(const IndexDetails& idx);
         static ExternalSortComparison* getComparison(int version, const BSONObj& keyPattern);
 
@@ -73,8 +133,20 @@ namespace mongo {
                                       bool mayInterrupt,
                                       int idxNo);
 
+        static void addKeysToPhaseOnes(NamespaceDetails* d, const char* ns,
+                                       const vector<int>& idxNos,
+                                       const vector<SortPhaseOne*>& phaseOnes,
+                                       ProgressMeter* progressMeter, bool mayInterrupt);
+
         static void doDropDups(const char* ns, NamespaceDetails* d, const set<DiskLoc>& dupsToDrop,
                                bool mayInterrupt );
+
+        static void applySideWrites(const char* ns, NamespaceDetails* d, const string& idxName,
+                                    IndexSideWrites* sideWrites, bool dupsAllowed,
+                                    vector<BSONObj>* mayBeDuplicate);
+
+        static void checkNoDuplicates(const char* ns, NamespaceDetails* d, const string& idxName,
+                                      const vector<BSONObj>& mayBeDuplicate);
     };
 
     // Exposed for testing purposes.
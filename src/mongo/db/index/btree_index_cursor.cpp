@@ -46,7 +46,7 @@ namespace mongo {
     BtreeIndexCursor::BtreeIndexCursor(IndexDescriptor *descriptor, Ordering ordering,
                                        BtreeInterface *interface)
         : _direction(1), _descriptor(descriptor), _ordering(ordering), _interface(interface),
-          _bucket(descriptor->getHead()), _keyOffset(0) {
+          _bucket(descriptor->getHead()), _keyOffset(0), _restoredToSavedPosition(false) {
 
         SimpleMutex::scoped_lock lock(_activeCursorsMutex);
         _activeCursors.insert(this);
@@ -163,7 +163,7 @@ namespace mongo {
 
     Status BtreeIndexCursor::savePosition() {
         if (!isEOF()) {
-            _savedKey = getKey().getOwned();
+            _interface->keyDataAt(_bucket, _keyOffset, &_savedKeyData);
             _savedLoc = getValue();
             return Status::OK();
         } else {
@@ -176,7 +176,7 @@ namespace mongo {
         // Btree calls a clientcursor function that calls down to all BTree buckets.  Really,
         // this deletion thing should be kept BTree-internal.
         if (_keyOffset >= 0) {
-            verify(!_savedKey.isEmpty());
+            verify(!_savedKeyData.empty());
 
             try {
                 if (isSavedPositionValid()) { return Status::OK(); }
@@ -188,8 +188,8 @@ namespace mongo {
                 }
                 // Object isn't at the saved position.  Fall through to calling seek.
             } catch (UserException& e) { 
-                // deletedBucketCode is what keyAt throws if the bucket was deleted.  Not a
-                // problem...
+                // deletedBucketCode is what keyDataAndRecordAre throws if the bucket was
+                // deleted.  Not a problem...
                 if (BtreeInterface::deletedBucketCode != e.getCode()) {
                     return e.toStatus();
                 }
@@ -209,7 +209,7 @@ namespace mongo {
         _bucket = _interface->locate(
                 _descriptor->getOnDisk(),
                 _descriptor->getHead(),
-                _savedKey,
+                _interface->keyDataToBson(_savedKeyData),
                 _ordering,
                 _keyOffset,
                 found, 
@@ -218,6 +218,9 @@ namespace mongo {
 
         skipUnusedKeys();
 
+        _restoredToSavedPosition = !isEOF()
+            && _interface->keyDataAndRecordAre(_bucket, _keyOffset, _savedKeyData, _savedLoc);
+
         return Status::OK();
     }
 
@@ -237,18 +240,17 @@ namespace mongo {
     }
 
     bool BtreeIndexCursor::isSavedPositionValid() {
-        // We saved the key.  If it's in the same position we saved it from...
-        if (_interface->keyAt(_bucket, _keyOffset).binaryEqual(_savedKey)) {
-            // And the record it points to is the same record...
-            if (_interface->recordAt(_bucket, _keyOffset) == _savedLoc) {
-                // Success!  We found it.  However!
-                if (!_interface->keyIsUsed(_bucket, _keyOffset)) {
-                    // We could have been deleted but still exist as a "vacant" key, so skip
-                    // over any unused keys.
-                    skipUnusedKeys();
-                }
-                return true;
+        // We saved the key and the record it points to.  If they're in the same position we
+        // saved them from...
+        if (_interface->keyDataAndRecordAre(_bucket, _keyOffset, _savedKeyData, _savedLoc)) {
+            // Success!  We found it.  However!
+            _restoredToSavedPosition = _interface->keyIsUsed(_bucket, _keyOffset);
+            if (!_restoredToSavedPosition) {
+                // We could have been deleted but still exist as a "vacant" key, so skip
+                // over any unused keys.
+                skipUnusedKeys();
             }
+            return true;
         }
 
         return false;
@@ -74,6 +74,12 @@ namespace mongo {
 
         virtual Status restorePosition();
 
+        /**
+         * True if the last restorePosition() left the cursor at the entry it was saved at, so
+         * callers need not compare the entry themselves to detect movement during a yield.
+         */
+        bool restoredToSavedPosition() const { return _restoredToSavedPosition; }
+
         virtual string toString();
 
     private:
@@ -94,9 +100,11 @@ namespace mongo {
         // Move to the next/prev. key.  Used by normal getNext and also skipping unused keys.
         void advance(const char* caller);
 
-        // For saving/restoring position.
-        BSONObj _savedKey;
+        // For saving/restoring position.  The key is saved in its on-disk form, which is cheap to
+        // copy and compare, and only converted to BSON if it must be searched for.
+        string _savedKeyData;
         DiskLoc _savedLoc;
+        bool _restoredToSavedPosition;
 
         BSONObj _emptyObj;
 
@@ -64,6 +64,14 @@ namespace mongo {
             return thisLoc.btree<Version>()->unindex(thisLoc, id, key, recordLoc);
         }
 
+        virtual bool relocate(const DiskLoc thisLoc,
+                              IndexDetails& id,
+                              const BSONObj& key,
+                              const DiskLoc oldLoc,
+                              const DiskLoc newLoc) const {
+            return thisLoc.btree<Version>()->relocate(thisLoc, id, key, oldLoc, newLoc);
+        }
+
         virtual DiskLoc locate(const IndexDetails& idx,
                                const DiskLoc& thisLoc,
                                const BSONObj& key,
@@ -182,6 +190,38 @@ namespace mongo {
             }
         }
 
+        virtual void keyDataAt(DiskLoc bucket, int keyOffset, string* keyDataOut) const {
+            verify(!bucket.isNull());
+            const typename BtreeBucket<Version>::KeyNode keyNode =
+                bucket.btree<Version>()->keyNode(keyOffset);
+            keyDataOut->assign(keyNode.key.data(), keyNode.key.dataSize());
+        }
+
+        virtual bool keyDataAndRecordAre(DiskLoc bucket, int keyOffset, const string& keyData,
+                                         const DiskLoc& recordLoc) const {
+            verify(!bucket.isNull());
+            const BtreeBucket<Version> *b = bucket.btree<Version>();
+            int n = b->getN();
+            if (n == b->INVALID_N_SENTINEL) {
+                throw UserException(deletedBucketCode, "keyDataAndRecordAre bucket deleted");
+            }
+            if (keyOffset < 0 || keyOffset >= n) {
+                return false;
+            }
+            const typename BtreeBucket<Version>::KeyNode keyNode = b->keyNode(keyOffset);
+            // The record is compared first as it's cheaper and differs whenever the key has moved
+            // to another record.
+            if (keyNode.recordLoc != recordLoc) {
+                return false;
+            }
+            return static_cast<size_t>(keyNode.key.dataSize()) == keyData.size()
+                && 0 == memcmp(keyNode.key.data(), keyData.data(), keyData.size());
+        }
+
+        virtual BSONObj keyDataToBson(const string& keyData) const {
+            return typename Version::Key(keyData.data()).toBson().getOwned();
+        }
+
         virtual string dupKeyError(DiskLoc bucket, const IndexDetails &idx,
                                    const BSONObj& keyObj) const {
             typename Version::KeyOwned key(keyObj);
@@ -63,6 +63,12 @@ namespace mongo {
                              const BSONObj& key,
                              const DiskLoc recordLoc) const = 0;
 
+        virtual bool relocate(const DiskLoc thisLoc,
+                              IndexDetails& id,
+                              const BSONObj& key,
+                              const DiskLoc oldLoc,
+                              const DiskLoc newLoc) const = 0;
+
         virtual DiskLoc locate(const IndexDetails& idx,
                                const DiskLoc& thisLoc,
                                const BSONObj& key,
@@ -134,6 +140,24 @@ namespace mongo {
          */
         virtual void keyAndRecordAt(DiskLoc bucket, int keyOffset, BSONObj* keyOut,
                                     DiskLoc* recordOut) const = 0;
+
+        /**
+         * Copy the on-disk representation of the key at (bucket, keyOffset) into 'keyDataOut'.
+         * Cheaper than keyAt, which converts the key to BSON.
+         */
+        virtual void keyDataAt(DiskLoc bucket, int keyOffset, string* keyDataOut) const = 0;
+
+        /**
+         * Is the key at (bucket, keyOffset) the one copied into 'keyData' by keyDataAt, pointing
+         * at 'recordLoc'?  Throws deletedBucketCode if the bucket was deleted.
+         */
+        virtual bool keyDataAndRecordAre(DiskLoc bucket, int keyOffset, const string& keyData,
+                                         const DiskLoc& recordLoc) const = 0;
+
+        /**
+         * Get the BSON representation of a key copied by keyDataAt.
+         */
+        virtual BSONObj keyDataToBson(const string& keyData) const = 0;
     };
 
 }  // namespace mongo
@@ -27,10 +27,55 @@
 */
 
 #include "mongo/db/index/btree_key_generator.h"
+
+#include <algorithm>
+
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    namespace {
+        // Orders offsets into a BtreeKeyBuffer by the keys they point at.
+        class KeyOffsetLess {
+        public:
+            KeyOffsetLess(const char* base, const BSONObjCmp& cmp) : _base(base), _cmp(cmp) { }
+            bool operator()(int l, int r) const {
+                return _cmp(BSONObj(_base + l), BSONObj(_base + r));
+            }
+        private:
+            const char* _base;
+            BSONObjCmp _cmp;
+        };
+
+        // A buffer much bigger than this is given back after use rather than kept for the
+        // thread's next document.
+        const int kMaxRetainedKeyBufferBytes = 1024 * 1024;
+    }
+
+    void BtreeKeyBuffer::reset() {
+        _buf.reset(kMaxRetainedKeyBufferBytes);
+        _offsets.clear();
+    }
+
+    void BtreeKeyBuffer::copyInto(BSONObjSet* keys) {
+        KeyOffsetLess less(_buf.buf(), keys->key_comp());
+        std::sort(_offsets.begin(), _offsets.end(), less);
+
+        for (size_t i = 0; i < _offsets.size(); ++i) {
+            // equal keys are adjacent after the sort
+            if (i > 0 && !less(_offsets[i - 1], _offsets[i])) {
+                continue;
+            }
+            // keys arrive in order, so hinting at the end makes each insert constant time
+            keys->insert(keys->end(), BSONObj(_buf.buf() + _offsets[i]).getOwned());
+        }
+    }
+
+    // Each thread generates keys into its own buffer, which is reused across documents.
+    TSP_DECLARE(BtreeKeyBuffer, btreeKeyBuffer)
+    TSP_DEFINE(BtreeKeyBuffer, btreeKeyBuffer)
+
     // Used in scanandorder.cpp to inforatively error when we try to sort keys with parallel arrays.
     const int BtreeKeyGenerator::ParallelArraysCode = 10088;
 
@@ -54,7 +99,10 @@ namespace mongo {
         // These are mutated as part of the getKeys call.  :|
         vector<const char*> fieldNames(_fieldNames);
         vector<BSONElement> fixed(_fixed);
-        getKeysImpl(fieldNames, fixed, obj, keys);
+        BtreeKeyBuffer* buffer = btreeKeyBuffer.getMake();
+        buffer->reset();
+        getKeysImpl(fieldNames, fixed, obj, buffer);
+        buffer->copyInto(keys);
         if (keys->empty() && ! _isSparse) {
             keys->insert(_nullKey);
         }
@@ -71,7 +119,7 @@ namespace mongo {
             : BtreeKeyGenerator(fieldNames, fixed, isSparse) { }
         
     void BtreeKeyGeneratorV0::getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
-                                          const BSONObj &obj, BSONObjSet *keys) const {
+                                          const BSONObj &obj, BtreeKeyBuffer *keys) const {
         BSONElement arrElt;
         unsigned arrIdx = ~0;
         unsigned numNotFound = 0;
@@ -126,24 +174,24 @@ namespace mongo {
         if ( allFound ) {
             if ( arrElt.eoo() ) {
                 // no terminal array element to expand
-                BSONObjBuilder b(_sizeTracker);
+                BSONObjBuilder b(keys->nextKey());
                 for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i )
                     b.appendAs( *i, "" );
-                keys->insert( b.obj() );
+                b.doneFast();
             }
             else {
                 // terminal array element to expand, so generate all keys
                 BSONObjIterator i( arrElt.embeddedObject() );
                 if ( i.more() ) {
                     while( i.more() ) {
-                        BSONObjBuilder b(_sizeTracker);
+                        BSONObjBuilder b(keys->nextKey());
                         for( unsigned j = 0; j < fixed.size(); ++j ) {
                             if ( j == arrIdx )
                                 b.appendAs( i.next(), "" );
                             else
                                 b.appendAs( fixed[ j ], "" );
                         }
-                        keys->insert( b.obj() );
+                        b.doneFast();
                     }
                 }
                 else if ( fixed.size() > 1 ) {
@@ -170,7 +218,7 @@ namespace mongo {
 
         if ( insertArrayNull ) {
             // x : [] - need to insert undefined
-            BSONObjBuilder b(_sizeTracker);
+            BSONObjBuilder b(keys->nextKey());
             for( unsigned j = 0; j < fixed.size(); ++j ) {
                 if ( j == arrIdx ) {
                     b.appendUndefined( "" );
@@ -183,7 +231,7 @@ namespace mongo {
                         b.appendAs( e , "" );
                 }
             }
-            keys->insert( b.obj() );
+            b.doneFast();
         }
     }
 
@@ -229,13 +277,13 @@ namespace mongo {
 
     void BtreeKeyGeneratorV1::_getKeysArrEltFixed(vector<const char*> &fieldNames,
                                                   vector<BSONElement> &fixed,
-                                                  const BSONElement &arrEntry, BSONObjSet *keys,
+                                                  const BSONElement &arrEntry, BtreeKeyBuffer *keys,
                                                   unsigned numNotFound,
                                                   const BSONElement &arrObjElt,
-                                                  const set<unsigned> &arrIdxs,
+                                                  const vector<unsigned> &arrIdxs,
                                                   bool mayExpandArrayUnembedded) const {
         // set up any terminal array values
-        for( set<unsigned>::const_iterator j = arrIdxs.begin(); j != arrIdxs.end(); ++j ) {
+        for( vector<unsigned>::const_iterator j = arrIdxs.begin(); j != arrIdxs.end(); ++j ) {
             if ( *fieldNames[ *j ] == '\0' ) {
                 fixed[ *j ] = mayExpandArrayUnembedded ? arrEntry : arrObjElt;
             }
@@ -249,16 +297,16 @@ namespace mongo {
                              arrObjElt.embeddedObject());
     }
 
-    void BtreeKeyGeneratorV1::getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,                                          const BSONObj &obj, BSONObjSet *keys) const {
+    void BtreeKeyGeneratorV1::getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,                                          const BSONObj &obj, BtreeKeyBuffer *keys) const {
         getKeysImplWithArray(fieldNames, fixed, obj, keys, 0, BSONObj());
     }
 
     void BtreeKeyGeneratorV1::getKeysImplWithArray(vector<const char*> fieldNames,
                                                    vector<BSONElement> fixed, const BSONObj &obj,
-                                                   BSONObjSet *keys, unsigned numNotFound,
+                                                   BtreeKeyBuffer *keys, unsigned numNotFound,
                                                    const BSONObj &array) const {
         BSONElement arrElt;
-        set<unsigned> arrIdxs;
+        vector<unsigned> arrIdxs;
         bool mayExpandArrayUnembedded = true;
         for( unsigned i = 0; i < fieldNames.size(); ++i ) {
             if ( *fieldNames[ i ] == '\0' ) {
@@ -277,7 +325,7 @@ namespace mongo {
                 numNotFound++;
             }
             else if ( e.type() == Array ) {
-                arrIdxs.insert( i );
+                arrIdxs.push_back( i );
                 if ( arrElt.eoo() ) {
                     // we only expand arrays on a single path -- track the path here
                     arrElt = e;
@@ -301,11 +349,11 @@ namespace mongo {
             if ( _isSparse && numNotFound == fieldNames.size()) {
                 return;
             }            
-            BSONObjBuilder b(_sizeTracker);
+            BSONObjBuilder b(keys->nextKey());
             for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i ) {
                 b.appendAs( *i, "" );
             }
-            keys->insert( b.obj() );
+            b.doneFast();
         }
         else if ( arrElt.embeddedObject().firstElement().eoo() ) {
             // Empty array, so set matching fields to undefined.
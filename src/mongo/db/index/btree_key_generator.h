@@ -34,6 +34,39 @@
 
 namespace mongo {
 
+    /**
+     * The keys generated for one document, built back to back in a single buffer.  A document
+     * with a large array generates a key per element, and building each of those into its own
+     * BSONObj and std::set node means thousands of allocations, most of them for keys that turn
+     * out to be duplicates.  Instead the keys are appended here and sorted and deduped as offsets
+     * into the buffer, and only the distinct keys are copied out, in order.
+     */
+    class BtreeKeyBuffer : boost::noncopyable {
+    public:
+        BtreeKeyBuffer() { }
+
+        /** Drops the keys from the last document, keeping the buffers around for reuse. */
+        void reset();
+
+        /**
+         * Returns the buffer to build the next key into.  Build it with a BSONObjBuilder on
+         * this buffer and finish that builder before calling nextKey() again.
+         */
+        BufBuilder& nextKey() {
+            _offsets.push_back(_buf.len());
+            return _buf;
+        }
+
+        bool empty() const { return _offsets.empty(); }
+
+        /** Sorts and dedups the keys by the order of 'keys' and adds owned copies to it. */
+        void copyInto(BSONObjSet* keys);
+
+    private:
+        BufBuilder _buf;
+        vector<int> _offsets;
+    };
+
     /**
      * Internal class used by BtreeAccessMethod to generate keys for indexed documents.
      * This class is meant to be kept under the index access layer.
@@ -54,11 +87,10 @@ namespace mongo {
         BSONObj _nullKey; // a full key with all fields null
         BSONObj _nullObj;     // only used for _nullElt
         BSONElement _nullElt; // jstNull
-        BSONSizeTracker _sizeTracker;
     private:
         // We have V0 and V1.  Sigh.
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
-                                 const BSONObj &obj, BSONObjSet *keys) const = 0;
+                                 const BSONObj &obj, BtreeKeyBuffer *keys) const = 0;
         vector<BSONElement> _fixed;
     };
 
@@ -70,7 +102,7 @@ namespace mongo {
         
     private:
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
-                                 const BSONObj &obj, BSONObjSet *keys) const;
+                                 const BSONObj &obj, BtreeKeyBuffer *keys) const;
     };
 
     class BtreeKeyGeneratorV1 : public BtreeKeyGenerator {
@@ -84,17 +116,17 @@ namespace mongo {
          * @param fieldNames - fields to index, may be postfixes in recursive calls
          * @param fixed - values that have already been identified for their index fields
          * @param obj - object from which keys should be extracted, based on names in fieldNames
-         * @param keys - set where index keys are written
+         * @param keys - buffer where index keys are written
          * @param numNotFound - number of index fields that have already been identified as missing
          * @param array - array from which keys should be extracted, based on names in fieldNames
          *        If obj and array are both nonempty, obj will be one of the elements of array.
          */        
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
-                                 const BSONObj &obj, BSONObjSet *keys) const;
+                                 const BSONObj &obj, BtreeKeyBuffer *keys) const;
 
         // These guys are called by getKeysImpl.
         void getKeysImplWithArray(vector<const char*> fieldNames, vector<BSONElement> fixed,
-                                  const BSONObj &obj, BSONObjSet *keys, unsigned numNotFound,
+                                  const BSONObj &obj, BtreeKeyBuffer *keys, unsigned numNotFound,
                                   const BSONObj &array) const;
         /**
          * @param arrayNestedArray - set if the returned element is an array nested directly
@@ -103,9 +135,9 @@ namespace mongo {
         BSONElement extractNextElement(const BSONObj &obj, const BSONObj &arr, const char *&field,
                                        bool &arrayNestedArray ) const;
         void _getKeysArrEltFixed(vector<const char*> &fieldNames, vector<BSONElement> &fixed,
-                                 const BSONElement &arrEntry, BSONObjSet *keys,
+                                 const BSONElement &arrEntry, BtreeKeyBuffer *keys,
                                  unsigned numNotFound, const BSONElement &arrObjElt,
-                                 const set<unsigned> &arrIdxs, bool mayExpandArrayUnembedded) const;
+                                 const vector<unsigned> &arrIdxs, bool mayExpandArrayUnembedded) const;
         
         BSONObj _undefinedObj;
         BSONElement _undefinedElt;
@@ -31,13 +31,52 @@
 
 namespace mongo {
 
+    namespace {
+
+        // The top level field of a dotted path.
+        string topLevelField(const string& path) {
+            return path.substr(0, path.find('.'));
+        }
+
+        bool identical(const BSONElement& a, const BSONElement& b) {
+            return a.size() == b.size() && 0 == memcmp(a.rawdata(), b.rawdata(), a.size());
+        }
+
+    }  // namespace
+
     FTSAccessMethod::FTSAccessMethod(IndexDescriptor* descriptor)
-        : BtreeBasedAccessMethod(descriptor), _ftsSpec(descriptor->infoObj()) { }
+        : BtreeBasedAccessMethod(descriptor), _ftsSpec(descriptor->infoObj()) {
+
+        const fts::Weights& weights = _ftsSpec.weights();
+        for (fts::Weights::const_iterator i = weights.begin(); i != weights.end(); ++i) {
+            _keyFields.insert(topLevelField(i->first));
+        }
+        _keyFields.insert(topLevelField(_ftsSpec.languageOverrideField()));
+        for (size_t i = 0; i < _ftsSpec.numExtraBefore(); ++i) {
+            _keyFields.insert(topLevelField(_ftsSpec.extraBefore(i)));
+        }
+        for (size_t i = 0; i < _ftsSpec.numExtraAfter(); ++i) {
+            _keyFields.insert(topLevelField(_ftsSpec.extraAfter(i)));
+        }
+    }
 
     void FTSAccessMethod::getKeys(const BSONObj& obj, BSONObjSet* keys) {
         fts::FTSIndexFormat::getKeys(_ftsSpec, obj, keys);
     }
 
+    bool FTSAccessMethod::keysUnchanged(const BSONObj& from, const BSONObj& to) {
+        if (_ftsSpec.wildcard()) {
+            return false;
+        }
+
+        for (set<string>::const_iterator i = _keyFields.begin(); i != _keyFields.end(); ++i) {
+            if (!identical(from.getField(*i), to.getField(*i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     Status FTSAccessMethod::newCursor(IndexCursor** out) {
         return Status::OK();
     }
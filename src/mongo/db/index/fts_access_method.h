@@ -60,7 +60,14 @@ namespace mongo {
         // Implemented:
         virtual void getKeys(const BSONObj& obj, BSONObjSet* keys);
 
+        // Tokenizing and stemming is expensive, so updates that leave every field the keys are
+        // built from untouched skip it.
+        virtual bool keysUnchanged(const BSONObj& from, const BSONObj& to);
+
         fts::FTSSpec _ftsSpec;
+
+        // Top level fields holding everything getKeys reads.  Unused for wildcard specs.
+        std::set<std::string> _keyFields;
     };
 
 } //namespace mongo
@@ -105,6 +105,14 @@ namespace mongo {
          */
         virtual Status update(const UpdateTicket& ticket, int64_t* numUpdated) = 0;
 
+        /**
+         * As update(), for a document that is also moving from the ticket's loc to 'newLoc'.
+         * Keys shared by 'from' and 'to' are repointed at 'newLoc' where possible instead of
+         * being removed and reinserted.
+         */
+        virtual Status updateAndMove(const UpdateTicket& ticket, const DiskLoc& newLoc,
+                                     int64_t* numUpdated) = 0;
+
         /**
          * Fills in '*out' with an IndexCursor.  Return a status indicating success or reason of
          * failure. If the latter, '*out' contains NULL.  See index_cursor.h for IndexCursor usage.
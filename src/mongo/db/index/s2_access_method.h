@@ -49,7 +49,7 @@ namespace mongo {
         virtual Status newCursor(IndexCursor** out);
 
     private:
-        friend class Geo2dFindNearCmd;
+        friend class S2GeoNearSearch;
         const S2IndexingParams& getParams() const { return _params; }
 
         virtual void getKeys(const BSONObj& obj, BSONObjSet* keys);
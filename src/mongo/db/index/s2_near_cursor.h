@@ -66,6 +66,13 @@ namespace mongo {
         virtual Status savePosition();
         virtual Status restorePosition();
 
+        /**
+         * Points us at a new descriptor for the same index.  A caller that releases the lock
+         * between savePosition() and restorePosition() looks the index up again, as it may have
+         * moved, and passes the new descriptor here before restoring.
+         */
+        void setDescriptor(IndexDescriptor* descriptor) { _descriptor = descriptor; }
+
         // The geoNear command wants these.
         long long nscanned() { return _stats._nscanned; }
         double currentDistance() { return _results.top().distance; }
@@ -29,12 +29,18 @@
 #include "mongo/db/index_builder.h"
 
 #include "mongo/db/client.h"
+#include "mongo/db/index_update.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    // Build replicated foreground indexes in the background too, so that applying the oplog
+    // doesn't stop while they're built.
+    MONGO_EXPORT_SERVER_PARAMETER(replIndexBuildsInBackground, bool, true);
+
     AtomicUInt IndexBuilder::_indexBuildCount = 0;
 
     IndexBuilder::IndexBuilder(const std::string ns, const BSONObj index) :
@@ -54,7 +60,13 @@ namespace mongo {
         replLocalAuth();
 
         Client::WriteContext ctx(_ns);
-        build();
+        if ( buildsInBackground(_index) ) {
+            ForceBackgroundIndexBuilds background;
+            build();
+        }
+        else {
+            build();
+        }
 
         cc().shutdown();
     }
@@ -64,6 +76,15 @@ namespace mongo {
                               true /* mayInterrupt */);
     }
 
+    // static
+    bool IndexBuilder::buildsInBackground(const BSONObj& index) {
+        if ( index["background"].trueValue() ) {
+            return true;
+        }
+        // a dropDups build deletes documents as it goes, so it has to keep others out
+        return replIndexBuildsInBackground && !index["dropDups"].trueValue();
+    }
+
     std::vector<BSONObj> IndexBuilder::killMatchingIndexBuilds(const BSONObj& criteria) {
         verify(Lock::somethingWriteLocked());
         std::vector<BSONObj> indexes;
@@ -48,6 +48,14 @@ namespace mongo {
 
         void build() const;
 
+        /**
+         * @return true if replicated index spec 'index' is built by an IndexBuilder thread,
+         * while oplog application carries on.  Background specs always are.  Foreground ones
+         * are too, as bulk background builds, unless they drop duplicates or
+         * replIndexBuildsInBackground is off.
+         */
+        static bool buildsInBackground(const BSONObj& index);
+
         /**
          * Kill all in-progress indexes matching criteria and, optionally, store them in the
          * indexes list.
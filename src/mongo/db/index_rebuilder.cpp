@@ -31,6 +31,7 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/client.h"
+#include "mongo/db/index_update.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/repl/rs.h"
@@ -116,33 +117,48 @@ namespace mongo {
                 continue;
             }
 
-            // We go from right to left building these indexes, so that indexBuildInProgress-- has
-            // the correct effect of "popping" an index off the list.
             std::string dbName = it->substr(0, it->find('.'));
-            while ( nsd->getTotalIndexCount() > nsd->getCompletedIndexCount() ) {
-                retryIndexBuild(dbName, nsd);
-            }
+            retryIndexBuilds(dbName, nsd);
         }
     }
 
-    void IndexRebuilder::retryIndexBuild(const std::string& dbName,
-                                         NamespaceDetails* nsd ) {
-        // First, clean up the in progress index build.  Save the system.indexes entry so that we
-        // can add it again afterwards.
-        BSONObj indexObj = nsd->prepOneUnfinishedIndex();
+    void IndexRebuilder::retryIndexBuilds(const std::string& dbName,
+                                          NamespaceDetails* nsd ) {
+        // First, clean up the in progress index builds.  Save their system.indexes entries so
+        // that we can add them again afterwards.  We go from right to left, so that
+        // indexBuildInProgress-- has the correct effect of "popping" an index off the list.
+        std::vector<BSONObj> indexObjs;
+        while ( nsd->getTotalIndexCount() > nsd->getCompletedIndexCount() ) {
+            indexObjs.push_back(nsd->prepOneUnfinishedIndex());
+        }
 
-        // The index has now been removed from system.indexes, so the only record of it is in-
-        // memory. If there is a journal commit between now and when insert() rewrites the entry and
-        // the db crashes before the new system.indexes entry is journalled, the index will be lost
-        // forever.  Thus, we're assuming no journaling will happen between now and the entry being
-        // re-written.
+        // The indexes have now been removed from system.indexes, so the only record of them is
+        // in-memory. If there is a journal commit between now and when insert() rewrites the
+        // entries and the db crashes before the new system.indexes entries are journalled, the
+        // indexes will be lost forever.  Thus, we're assuming no journaling will happen between
+        // now and the entries being re-written.
+
+        // Re-add them in their original order.  The foreground ones are then built together,
+        // from one scan of the collection.
+        const std::string ns = dbName + ".system.indexes";
+        IndexBuildBatch indexBuilds;
+        for (std::vector<BSONObj>::reverse_iterator i = indexObjs.rbegin();
+             i != indexObjs.rend();
+             ++i) {
+            try {
+                theDataFileMgr.insert(ns.c_str(), i->objdata(), i->objsize(), false, true);
+            }
+            catch (const DBException& e) {
+                log() << "building index failed: " << e.what() << " (" << e.getCode() << ")"
+                      << endl;
+            }
+        }
 
         try {
-            const std::string ns = dbName + ".system.indexes";
-            theDataFileMgr.insert(ns.c_str(), indexObj.objdata(), indexObj.objsize(), false, true);
+            indexBuilds.finish();
         }
         catch (const DBException& e) {
-            log() << "building index failed: " << e.what() << " (" << e.getCode() << ")"
+            log() << "building indexes failed: " << e.what() << " (" << e.getCode() << ")"
                   << endl;
         }
     }
@@ -45,18 +45,18 @@ namespace mongo {
     private:
         /**
          * Check each collection in the passed in vector to see if it has any in-progress index
-         * builds that need to be retried.  If so, calls retryIndexBuild.
+         * builds that need to be retried.  If so, calls retryIndexBuilds.
          */
         void checkNS(const std::vector<std::string>& nsToCheck);
 
         /**
-         * Actually retry an index build on a given namespace.
+         * Actually retry the index builds on a given namespace, building the foreground ones
+         * with a single scan of the collection.
          * @param dbName the name of the database for accessing db.system.indexes
-         * @param nsd the namespace details of the namespace building the index
-         * @param index the offset into nsd's index array of the partially-built index
+         * @param nsd the namespace details of the namespace building the indexes
          */
-        void retryIndexBuild(const std::string& dbName,
-                             NamespaceDetails* nsd );
+        void retryIndexBuilds(const std::string& dbName,
+                              NamespaceDetails* nsd );
     };
 
     extern IndexRebuilder indexRebuilder;
@@ -33,6 +33,9 @@
 
 namespace mongo {
 
+    IndexPathSet::IndexPathSet() : _allPaths( false ) {
+    }
+
     void IndexPathSet::addPath( const StringData& path ) {
         string s;
         if ( getCanonicalIndexField( path, &s ) ) {
@@ -43,11 +46,19 @@ namespace mongo {
         }
     }
 
+    void IndexPathSet::addAllPaths() {
+        _allPaths = true;
+    }
+
     void IndexPathSet::clear() {
         _canonical.clear();
+        _allPaths = false;
     }
 
     bool IndexPathSet::mightBeIndexed( const StringData& path ) const {
+        if ( _allPaths )
+            return true;
+
         StringData use = path;
         string x;
         if ( getCanonicalIndexField( path, &x ) )
@@ -44,8 +44,15 @@ namespace mongo {
 
     class IndexPathSet {
     public:
+        IndexPathSet();
+
         void addPath( const StringData& path );
 
+        /**
+         * for indexes that may read any field, e.g. a wildcard text index
+         */
+        void addAllPaths();
+
         void clear();
 
         bool mightBeIndexed( const StringData& path ) const;
@@ -55,6 +62,8 @@ namespace mongo {
         bool _startsWith( const StringData& a, const StringData& b ) const;
 
         std::set<std::string> _canonical;
+
+        bool _allPaths;
     };
 
 }
@@ -40,6 +40,17 @@ namespace mongo {
     }
 
 
+    TEST( IndexPathSetTest, AllPaths ) {
+        IndexPathSet a;
+        a.addPath( "a" );
+        ASSERT_FALSE( a.mightBeIndexed( "b" ) );
+        a.addAllPaths();
+        ASSERT_TRUE( a.mightBeIndexed( "b" ) );
+        ASSERT_TRUE( a.mightBeIndexed( "c.d" ) );
+        a.clear();
+        ASSERT_FALSE( a.mightBeIndexed( "b" ) );
+    }
+
     TEST( IndexPathSetTest, getCanonicalIndexField1 ) {
         string x;
 
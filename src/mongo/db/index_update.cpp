@@ -36,6 +36,7 @@
 #include "mongo/db/index.h"
 #include "mongo/db/index/btree_based_builder.h"
 #include "mongo/db/index/catalog_hack.h"
+#include "mongo/db/index_legacy.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/pdfile_private.h"
@@ -43,9 +44,15 @@
 #include "mongo/db/query/runner_yield_policy.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/processinfo.h"
 
 namespace mongo {
+
+    // Build background indexes from the sorted keys of the collection, recording concurrent
+    // writes aside, rather than by inserting the keys of one document after another.
+    MONGO_EXPORT_SERVER_PARAMETER(bulkBuildBackgroundIndexes, bool, true);
     
     /**
      * Remove the provided (obj, dl) pair from the provided index.
@@ -251,8 +258,13 @@ namespace mongo {
 
             prep(ns.c_str(), d);
             try {
-                idx.head.writing() = BtreeBasedBuilder::makeEmptyIndex(idx);
-                n = addExistingToIndex(ns.c_str(), d, idx);
+                if ( bulkBuildBackgroundIndexes && !idx.dropDups() ) {
+                    n = BtreeBasedBuilder::backgroundBuildIndex(ns.c_str(), d, idx);
+                }
+                else {
+                    idx.head.writing() = BtreeBasedBuilder::makeEmptyIndex(idx);
+                    n = addExistingToIndex(ns.c_str(), d, idx);
+                }
                 // idx may point at an invalid index entry at this point
             }
             catch(...) {
@@ -284,7 +296,9 @@ namespace mongo {
 
         verify( Lock::isWriteLocked(ns) );
 
-        if( inDBRepair || !idxInfo["background"].trueValue() ) {
+        bool background = idxInfo["background"].trueValue() ||
+                          ForceBackgroundIndexBuilds::active();
+        if( inDBRepair || !background ) {
             int idxNo = IndexBuildsInProgress::get(ns.c_str(), idx.info.obj()["name"].valuestr());
             n = BtreeBasedBuilder::fastBuildIndex(ns.c_str(), d, idx, mayInterrupt, idxNo);
             verify( !idx.head.isNull() );
@@ -296,6 +310,170 @@ namespace mongo {
         MONGO_TLOG(0) << "build index done.  scanned " << n << " total records. " << t.millis() / 1000.0 << " secs" << endl;
     }
 
+    namespace {
+        // whether a ForceBackgroundIndexBuilds is in scope on each thread
+        struct ForcingBackgroundIndexBuilds {
+            ForcingBackgroundIndexBuilds() : forcing(false) { }
+            bool forcing;
+        };
+    }
+
+    TSP_DECLARE(ForcingBackgroundIndexBuilds, forcingBackgroundIndexBuilds)
+    TSP_DEFINE(ForcingBackgroundIndexBuilds, forcingBackgroundIndexBuilds)
+
+    ForceBackgroundIndexBuilds::ForceBackgroundIndexBuilds()
+        : _outer(forcingBackgroundIndexBuilds.getMake()->forcing) {
+        forcingBackgroundIndexBuilds.get()->forcing = true;
+    }
+
+    ForceBackgroundIndexBuilds::~ForceBackgroundIndexBuilds() {
+        forcingBackgroundIndexBuilds.get()->forcing = _outer;
+    }
+
+    // static
+    bool ForceBackgroundIndexBuilds::active() {
+        return forcingBackgroundIndexBuilds.getMake()->forcing;
+    }
+
+    namespace {
+        // the innermost IndexBuildBatch open on each thread
+        struct CurrentIndexBuildBatch {
+            CurrentIndexBuildBatch() : batch(NULL) { }
+            IndexBuildBatch* batch;
+        };
+    }
+
+    TSP_DECLARE(CurrentIndexBuildBatch, currentIndexBuildBatch)
+    TSP_DEFINE(CurrentIndexBuildBatch, currentIndexBuildBatch)
+
+    struct IndexBuildBatch::PendingIndex {
+        PendingIndex(const string& n, const string& i, bool m)
+            : ns(n), name(i), mayInterrupt(m), block(n, i) { }
+        const string ns;
+        const string name;
+        const bool mayInterrupt;
+        // counts the index as in progress until it is built or rolled back
+        NamespaceDetails::IndexBuildBlock block;
+    };
+
+    IndexBuildBatch::IndexBuildBatch() : _outer(currentIndexBuildBatch.getMake()->batch) {
+        currentIndexBuildBatch.get()->batch = this;
+    }
+
+    IndexBuildBatch::~IndexBuildBatch() {
+        currentIndexBuildBatch.get()->batch = _outer;
+        rollBack();
+    }
+
+    // static
+    IndexBuildBatch* IndexBuildBatch::current() {
+        return currentIndexBuildBatch.getMake()->batch;
+    }
+
+    bool IndexBuildBatch::defer(const string& ns, const DiskLoc& specLoc, bool mayInterrupt) {
+        BSONObj info = specLoc.obj();
+        if ( inDBRepair || info["background"].trueValue() || info["dropDups"].trueValue() ||
+             ForceBackgroundIndexBuilds::active() ) {
+            return false;
+        }
+
+        NamespaceDetails* d = nsdetails(ns);
+        IndexDetails& idx = d->getNextIndexDetails(ns.c_str());
+        _pending.push_back(shared_ptr<PendingIndex>(
+                new PendingIndex(ns, info["name"].valuestr(), mayInterrupt)));
+        getDur().writingDiskLoc(idx.info) = specLoc;
+        return true;
+    }
+
+    void IndexBuildBatch::finish() {
+        try {
+            while ( !_pending.empty() ) {
+                buildCollection(_pending.front()->ns);
+            }
+        }
+        catch (DBException& e) {
+            // save our error msg string, as rolling back the indexes would overwrite it
+            LastError *le = lastError.get();
+            int savecode = 0;
+            string saveerrmsg;
+            if ( le ) {
+                savecode = le->code;
+                saveerrmsg = le->msg;
+            }
+            else {
+                savecode = e.getCode();
+                saveerrmsg = e.what();
+            }
+            rollBack();
+            setLastError(savecode, saveerrmsg.c_str());
+            throw;
+        }
+    }
+
+    void IndexBuildBatch::buildCollection(const string& ns) {
+        vector< shared_ptr<PendingIndex> > indexes;
+        vector< shared_ptr<PendingIndex> > others;
+        for ( size_t i = 0; i < _pending.size(); ++i ) {
+            ( _pending[i]->ns == ns ? indexes : others ).push_back(_pending[i]);
+        }
+
+        NamespaceDetails* d = nsdetails(ns);
+        vector<int> idxNos;
+        bool mayInterrupt = true;
+        for ( size_t i = 0; i < indexes.size(); ++i ) {
+            idxNos.push_back(IndexBuildsInProgress::get(ns.c_str(), indexes[i]->name));
+            mayInterrupt = mayInterrupt && indexes[i]->mayInterrupt;
+            MONGO_TLOG(0) << "build index on: " << ns << " properties: "
+                          << d->idx(idxNos.back()).info.obj().jsonString() << endl;
+        }
+
+        Timer t;
+        uint64_t n = BtreeBasedBuilder::fastBuildIndexes(ns.c_str(), d, idxNos, mayInterrupt);
+        MONGO_TLOG(0) << "build " << indexes.size() << " indexes done.  scanned " << n
+                      << " total records. " << t.millis() / 1000.0 << " secs" << endl;
+
+        // Make the indexes ready in the order they were asked for, as insert_makeIndex would.
+        while ( !indexes.empty() ) {
+            const string name = indexes.front()->name;
+            d = nsdetails(ns);
+            int idxNo = IndexBuildsInProgress::get(ns.c_str(), name);
+            if ( idxNo != d->getCompletedIndexCount() ) {
+                log() << "switching indexes at position " << idxNo << " and "
+                      << d->getCompletedIndexCount() << endl;
+                d->swapIndex(ns.c_str(), idxNo, d->getCompletedIndexCount());
+                idxNo = d->getCompletedIndexCount();
+            }
+
+            // increments nIndexes; dropping the block then stops counting it as in progress
+            d->addIndex(ns.c_str());
+            indexes.erase(indexes.begin());
+            _pending = others;
+            _pending.insert(_pending.end(), indexes.begin(), indexes.end());
+
+            IndexLegacy::postBuildHook(d, d->idx(idxNo));
+        }
+    }
+
+    void IndexBuildBatch::rollBack() {
+        // newest first, as they'd have failed one by one
+        while ( !_pending.empty() ) {
+            shared_ptr<PendingIndex> index = _pending.back();
+            _pending.pop_back();
+            const string ns = index->ns;
+            const string name = index->name;
+            try {
+                int idxNo = IndexBuildsInProgress::get(ns.c_str(), name);
+                nsdetails(ns)->idx(idxNo).kill_idx();
+                index.reset(); // no longer in progress
+                IndexBuildsInProgress::remove(ns.c_str(), idxNo);
+            }
+            catch (DBException& e) {
+                log() << "couldn't roll back the build of index " << name << " on " << ns
+                      << ": " << e.what() << endl;
+            }
+        }
+    }
+
     extern BSONObj id_obj;  // { _id : 1 }
 
     void ensureHaveIdIndex(const char* ns, bool mayInterrupt) {
@@ -49,6 +49,65 @@ namespace mongo {
                       IndexDetails& idx,
                       bool mayInterrupt);
 
+    /**
+     * While one of these is open on a thread, the foreground index builds the thread starts are
+     * put off until finish(), which builds the indexes of each collection together from a single
+     * scan of it rather than one scan per index.  Each deferred index is registered as in
+     * progress when its spec is inserted, so a restart finds and rebuilds it as usual.
+     *
+     * Only index specs may be inserted while a batch is open: the deferred indexes are empty
+     * until finish(), so a document inserted meanwhile would be missing from them.  Background
+     * and dropDups builds aren't deferred; an earlier deferred build is finished before them.
+     */
+    class IndexBuildBatch : boost::noncopyable {
+    public:
+        IndexBuildBatch();
+
+        /** Rolls back the indexes still deferred, if finish() wasn't reached. */
+        ~IndexBuildBatch();
+
+        /** @return the innermost batch open on this thread, or NULL. */
+        static IndexBuildBatch* current();
+
+        /**
+         * Registers the index whose spec was inserted at specLoc, for collection ns, to be built
+         * by finish().
+         * @return false if it must be built now instead.
+         */
+        bool defer(const string& ns, const DiskLoc& specLoc, bool mayInterrupt);
+
+        /**
+         * Builds the deferred indexes.  Throws DBException, in which case every index that was
+         * still deferred is rolled back.
+         */
+        void finish();
+
+    private:
+        struct PendingIndex;
+
+        void buildCollection(const string& ns);
+        void rollBack();
+
+        IndexBuildBatch* const _outer;
+        vector< shared_ptr<PendingIndex> > _pending;
+    };
+
+    /**
+     * While one of these is in scope, the index builds this thread starts run as background
+     * builds whatever their specs say.  The specs themselves are stored unchanged.
+     */
+    class ForceBackgroundIndexBuilds : boost::noncopyable {
+    public:
+        ForceBackgroundIndexBuilds();
+        ~ForceBackgroundIndexBuilds();
+
+        /** @return true if one is in scope on this thread. */
+        static bool active();
+
+    private:
+        const bool _outer;
+    };
+
     // add index keys for a newly inserted record 
     void indexRecord(const char *ns, NamespaceDetails *d, const BSONObj& obj, const DiskLoc &loc);
 
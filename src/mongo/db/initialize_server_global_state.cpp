@@ -44,6 +44,9 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/security_key.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/logger/async_appender.h"
+#include "mongo/logger/async_file_writer.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/message_event.h"
 #include "mongo/logger/message_event_utf8_encoder.h"
@@ -185,6 +188,14 @@ namespace mongo {
             _exit(EXIT_FAILURE);
     }
 
+    // When true, log lines for --logpath are written to the file by a background thread, so
+    // logging threads don't wait on the disk.  Lines below warning severity are dropped first
+    // when the buffer fills.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(logAsync, bool, false);
+
+    // Most bytes of log lines logAsync buffers in memory.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(logAsyncBufferBytes, int, 16 * 1024 * 1024);
+
     MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
                               ("GlobalLogManager", "completedStartupConfig"),
                               ("default"))(
@@ -266,14 +277,30 @@ namespace mongo {
 
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
-            manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
-            manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+            if (logAsync) {
+                // lives for the rest of the process, like the appenders
+                logger::AsyncFileWriter* asyncWriter =
+                    new logger::AsyncFileWriter(writer.getValue(),
+                                                std::max(logAsyncBufferBytes, 0));
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new logger::AsyncAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncWriter)));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new logger::AsyncAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncWriter)));
+            }
+            else {
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+            }
 
             if (serverGlobalParams.logAppend && exists) {
                 log() << "***** SERVER RESTARTED *****" << endl;
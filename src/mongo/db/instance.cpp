@@ -55,11 +55,13 @@
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/index_update.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/json.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/mongod_options.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/ops/count.h"
 #include "mongo/db/ops/delete.h"
@@ -70,7 +72,9 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/storage/warm_up.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/logger/async_file_writer.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h" // for SendStaleConfigException
@@ -107,6 +111,9 @@ namespace mongo {
 
     MONGO_FP_DECLARE(rsStopGetMore);
 
+    // longest an awaitData getmore waits for a capped insert before looking again
+    static const int awaitDataWaitMillis = 20;
+
     void BSONElementManipulator::initTimestamp() {
         massert( 10332 ,  "Expected CurrentTime type", _element.type() == Timestamp );
         unsigned long long &timestamp = *( reinterpret_cast< unsigned long long* >( value() ) );
@@ -743,6 +750,7 @@ namespace mongo {
         bool exhaust = false;
         QueryResult* msgdata = 0;
         OpTime last;
+        unsigned long long cappedInserts = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -768,6 +776,9 @@ namespace mongo {
                     }
                 }
 
+                // read before looking, so that an insert made after the look wakes the wait
+                cappedInserts = NamespaceDetails::cappedInsertCount();
+
                 msgdata = processGetMore(ns,
                                          ntoreturn,
                                          cursorid,
@@ -805,10 +816,11 @@ namespace mongo {
                     }
                 }
                 pass++;
+                // wait to be woken by the next capped insert, rather than polling
                 if (debug)
                     sleepmillis(20);
                 else
-                    sleepmillis(2);
+                    NamespaceDetails::waitForCappedInsert(cappedInserts, awaitDataWaitMillis);
                 
                 // note: the 1100 is beacuse of the waitForDifferent above
                 // should eventually clean this up a bit
@@ -848,7 +860,8 @@ namespace mongo {
         return ok;
     }
 
-    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) {
+    /** checkAndInsert() without the logOp(), for the caller to log the insert. */
+    static void checkAndInsertUnlogged(const char *ns, /*modifies*/BSONObj& js) {
         uassert( 10059 , "object to insert too large", js.objsize() <= BSONObjMaxUserSize);
         {
             BSONObjIterator i( js );
@@ -881,23 +894,125 @@ namespace mongo {
                                         // operation might not support interrupts.
                                         cc().curop()->parent() == NULL,
                                         false);
+    }
+
+    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) {
+        checkAndInsertUnlogged(ns, js);
         logOp("i", ns, js);
     }
 
-    NOINLINE_DECL void insertMulti(bool keepGoing, const char *ns, vector<BSONObj>& objs, CurOp& op) {
-        size_t i;
-        for (i=0; i<objs.size(); i++){
+    namespace {
+        // Inserted documents are logged as one batched insert entry once they reach this size.
+        const int maxUnloggedInsertBytes = 1024 * 1024;
+    }
+
+    /**
+     * Logs the inserts of the documents in 'unlogged' and clears it.  The journal isn't
+     * committed while documents are waiting here, so an insert is never durable without its
+     * oplog entry.
+     */
+    static void logUnloggedInserts(const char *ns, vector<BSONObj>* unlogged) {
+        logOpInserts(ns, *unlogged);
+        unlogged->clear();
+        getDur().commitIfNeeded();
+    }
+
+    /**
+     * insertMulti() for index specs.  The foreground indexes are built once all the specs are
+     * in, the indexes of each collection together from one scan of it, and then the specs are
+     * logged.  *next isn't advanced until then, as a page fault part way rolls back the indexes
+     * of the specs inserted before it.
+     */
+    static void insertIndexSpecs(bool keepGoing, const char *ns, vector<BSONObj>& specs,
+                                 size_t* next, CurOp& op) {
+        size_t i = *next;
+        vector<BSONObj> inserted;
+        IndexBuildBatch indexBuilds;
+        for (; i<specs.size(); i++){
             try {
-                checkAndInsert(ns, objs[i]);
-                getDur().commitIfNeeded();
+                checkAndInsertUnlogged(ns, specs[i]);
+                inserted.push_back(specs[i]);
             } catch (const UserException&) {
-                if (!keepGoing || i == objs.size()-1){
+                if (!keepGoing || i == specs.size()-1){
+                    // the specs before this one are built as though it had never come
+                    indexBuilds.finish();
+                    for (size_t j = 0; j < inserted.size(); ++j) {
+                        logOp("i", ns, inserted[j]);
+                    }
+                    *next = i;
                     globalOpCounters.incInsertInWriteLock(i);
                     throw;
                 }
                 // otherwise ignore and keep going
             }
         }
+        indexBuilds.finish();
+        for (size_t j = 0; j < inserted.size(); ++j) {
+            logOp("i", ns, inserted[j]);
+        }
+        *next = i;
+
+        globalOpCounters.incInsertInWriteLock(i);
+        op.debug().ninserted = i;
+    }
+
+    /**
+     * Inserts objs[*next] onwards, advancing *next past each document handled.  If a
+     * PageFaultException escapes, *next is the document that faulted, so the caller can touch
+     * the page and resume there instead of inserting the earlier documents again.
+     */
+    NOINLINE_DECL void insertMulti(bool keepGoing, const char *ns, vector<BSONObj>& objs,
+                                   size_t* next, CurOp& op) {
+        if (nsToCollectionSubstring(ns) == "system.indexes") {
+            insertIndexSpecs(keepGoing, ns, objs, next, op);
+            return;
+        }
+
+        size_t& i = *next;
+        if (!batchInsertOplogEntries(ns)) {
+            for (; i<objs.size(); i++){
+                try {
+                    checkAndInsert(ns, objs[i]);
+                    getDur().commitIfNeeded();
+                } catch (const UserException&) {
+                    if (!keepGoing || i == objs.size()-1){
+                        globalOpCounters.incInsertInWriteLock(i);
+                        throw;
+                    }
+                    // otherwise ignore and keep going
+                }
+            }
+        }
+        else {
+            // Documents are logged in batches.  Whatever stops the loop, including a page
+            // fault, first logs the documents inserted so far.
+            vector<BSONObj> unlogged;
+            int unloggedBytes = 0;
+            try {
+                for (; i<objs.size(); i++){
+                    try {
+                        checkAndInsertUnlogged(ns, objs[i]);
+                        unlogged.push_back(objs[i]);
+                        unloggedBytes += objs[i].objsize();
+                        if (unloggedBytes >= maxUnloggedInsertBytes) {
+                            logUnloggedInserts(ns, &unlogged);
+                            unloggedBytes = 0;
+                        }
+                    } catch (const UserException&) {
+                        if (!keepGoing || i == objs.size()-1){
+                            globalOpCounters.incInsertInWriteLock(i);
+                            throw;
+                        }
+                        // otherwise ignore and keep going
+                    }
+                }
+            }
+            catch (...) {
+                logUnloggedInserts(ns, &unlogged);
+                throw;
+            }
+            logUnloggedInserts(ns, &unlogged);
+        }
 
         globalOpCounters.incInsertInWriteLock(i);
         op.debug().ninserted = i;
@@ -913,6 +1028,7 @@ namespace mongo {
             return;
         }
 
+        const NamespaceString nsString(ns);
         vector<BSONObj> multi;
         while (d.moreJSObjs()){
             BSONObj obj = d.nextJsObj();
@@ -920,12 +1036,14 @@ namespace mongo {
 
             // Check auth for insert (also handles checking if this is an index build and checks
             // for the proper privileges in that case).
-            const NamespaceString nsString(ns);
             Status status = cc().getAuthorizationSession()->checkAuthForInsert(nsString, obj);
             audit::logInsertAuthzCheck(&cc(), nsString, obj, status.code());
             uassertStatusOK(status);
         }
 
+        // documents before this one are already inserted when retrying after a page fault
+        size_t next = 0;
+
         PageFaultRetryableSection s;
         while ( true ) {
             try {
@@ -942,7 +1060,7 @@ namespace mongo {
                 
                 if (multi.size() > 1) {
                     const bool keepGoing = d.reservedField() & InsertOption_ContinueOnError;
-                    insertMulti(keepGoing, ns, multi, op);
+                    insertMulti(keepGoing, ns, multi, &next, op);
                 } else {
                     checkAndInsert(ns, multi[0]);
                     globalOpCounters.incInsertInWriteLock(1);
@@ -1101,6 +1219,9 @@ namespace mongo {
         log() << "shutdown: waiting for fs preallocator..." << endl;
         FileAllocator::get()->waitUntilFinished();
 
+        log() << "shutdown: recording working set..." << endl;
+        saveWorkingSetSnapshot();
+
         if (storageGlobalParams.dur) {
             log() << "shutdown: lock for final commit..." << endl;
             {
@@ -1219,6 +1340,7 @@ namespace mongo {
             return;
         }
 #endif
+        logger::AsyncFileWriter::flushAll();
         tryToOutputFatal( "dbexit: really exiting now" );
         if ( c ) c->shutdown();
         ::_exit(rc);
@@ -156,6 +156,32 @@ namespace mongo {
         return ok();
     }
 
+    int64_t IntervalBtreeCursor::skipKeysInBucket( int64_t maxKeys ) {
+        if ( eof() || maxKeys <= 0 ) {
+            return 0;
+        }
+        const BtreeBucket<V1>* bucket = _curr.bucket.btree<V1>();
+        int32_t endPos = bucket->nKeys();
+        if ( _end.bucket == _curr.bucket && _end.pos > _curr.pos ) {
+            endPos = _end.pos;
+        }
+        int64_t passed = 0;
+        int32_t lastUsed = _curr.pos;
+        for( int32_t i = _curr.pos + 1; i < endPos && passed < maxKeys; ++i ) {
+            if ( !bucket->k( i ).prevChildBucket.isNull() ) {
+                // Key i is preceded by a child bucket, which advance() would visit first.
+                break;
+            }
+            if ( bucket->k( i ).isUsed() ) {
+                ++passed;
+                lastUsed = i;
+            }
+        }
+        _curr.pos = lastUsed;
+        _nscanned += passed;
+        return passed;
+    }
+
     BSONObj IntervalBtreeCursor::currKey() const {
         if ( _curr.bucket.isNull() ) {
             return BSONObj();
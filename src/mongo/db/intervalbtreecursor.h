@@ -113,6 +113,18 @@ namespace mongo {
 
         virtual void setMatcher( shared_ptr<CoveredIndexMatcher> matcher ) { _matcher = matcher; }
 
+        /**
+         * Advance past up to 'maxKeys' keys following the current key without returning to the
+         * caller for each one, counting them as scanned.  Only keys of the current bucket that can
+         * be reached without descending into a child bucket or reaching the end location are
+         * passed, so the cursor always remains positioned on a valid key within the interval.
+         * Unused keys are passed but not counted.  Dups are not checked, so this should only be
+         * used for a non multikey index.
+         *
+         * @return the number of keys passed.
+         */
+        int64_t skipKeysInBucket( int64_t maxKeys );
+
         virtual ~IntervalBtreeCursor();
 
     private:
@@ -30,24 +30,44 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_set.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/database_holder.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/background.h"
 #include "mongo/util/goodies.h"
+#include "mongo/util/queue.h"
 
 namespace {
     const size_t MAX_PROFILE_DOC_SIZE_BYTES = 100*1024;
+
+    // profile entries waiting for the writer thread when profileAsync is on
+    const size_t MAX_QUEUED_PROFILE_ENTRIES = 10000;
+
+    // most entries the writer thread inserts under one lock
+    const int MAX_PROFILE_WRITE_BATCH = 100;
 }
 
 namespace mongo {
 
+    // When true, profile entries are queued and written to system.profile by a background
+    // thread, instead of by the profiled operation.  Entries are dropped when the queue is full.
+    MONGO_EXPORT_SERVER_PARAMETER(profileAsync, bool, false);
+
+    static Counter64 profileEntriesDropped;
+    static ServerStatusMetricField<Counter64> displayProfileEntriesDropped(
+                                                    "profiler.dropped",
+                                                    &profileEntriesDropped );
+
 namespace {
     void _appendUserInfo(const Client& c,
                          BSONObjBuilder& builder,
@@ -78,12 +98,9 @@ namespace {
     }
 } // namespace
 
-    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
-        Database *db = c.database();
-        DEV verify( db );
-        const char *ns = db->getProfilingNS();
-
-        // build object
+    /** @return the system.profile entry for currentOp, built in profileBufBuilder */
+    static BSONObj _buildProfileEntry(const Client& c, CurOp& currentOp,
+                                      BufBuilder& profileBufBuilder) {
         BSONObjBuilder b(profileBufBuilder);
 
         const bool isQueryObjTooBig = !currentOp.debug().append(currentOp, b,
@@ -118,26 +135,118 @@ namespace {
             p = b.done();
         }
 
+        return p;
+    }
+
+    /** Inserts 'p' into db's system.profile.  The caller holds the db write lock. */
+    static void _writeProfileEntry(Database* db, const BSONObj& p) {
         // write: not replicated
         // get or create the profiling collection
         NamespaceDetails *details = getOrCreateProfileCollection(db);
         if (details) {
             int len = p.objsize();
-            Record *r = theDataFileMgr.fast_oplog_insert(details, ns, len);
+            Record *r = theDataFileMgr.fast_oplog_insert(details, db->getProfilingNS(), len);
             memcpy(getDur().writingPtr(r->data(), len), p.objdata(), len);
         }
     }
 
+namespace {
+
+    struct QueuedProfileEntry {
+        string dbName;
+        BSONObj entry;
+    };
+
+    BlockingQueue<QueuedProfileEntry> profileQueue(MAX_QUEUED_PROFILE_ENTRIES);
+
+    /**
+     * Drains profileQueue, inserting each database's entries under one write lock per batch.
+     */
+    class ProfileWriter : public BackgroundJob {
+    public:
+        virtual string name() const { return "ProfileWriter"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+
+            while ( ! inShutdown() ) {
+                QueuedProfileEntry queued;
+                if ( ! profileQueue.blockingPop( queued, 1 ) )
+                    continue;
+
+                map< string, vector<BSONObj> > batch;
+                int n = 0;
+                do {
+                    batch[queued.dbName].push_back( queued.entry );
+                } while ( ++n < MAX_PROFILE_WRITE_BATCH && profileQueue.tryPop( queued ) );
+
+                for ( map< string, vector<BSONObj> >::const_iterator i = batch.begin();
+                      i != batch.end(); ++i ) {
+                    writeBatch( i->first, i->second );
+                }
+            }
+
+            cc().shutdown();
+        }
+
+    private:
+        void writeBatch( const string& dbName, const vector<BSONObj>& entries ) {
+            try {
+                Lock::DBWrite lk( dbName );
+                if ( ! dbHolder()._isLoaded( dbName, storageGlobalParams.dbpath ) ) {
+                    profileEntriesDropped.increment( entries.size() );
+                    return;
+                }
+                Client::Context cx( dbName, storageGlobalParams.dbpath );
+                for ( size_t i = 0; i < entries.size(); i++ )
+                    _writeProfileEntry( cx.db(), entries[i] );
+            }
+            catch ( const AssertionException& assertionEx ) {
+                warning() << "Caught Assertion while writing profile entries for " << dbName
+                          << ": " << assertionEx.toString() << endl;
+            }
+        }
+    };
+
+    void enqueueProfileEntry( const string& dbName, const BSONObj& entry ) {
+        static SimpleMutex startMutex( "ProfileWriter" );
+        static ProfileWriter* writer = NULL;
+        {
+            SimpleMutex::scoped_lock lk( startMutex );
+            if ( ! writer ) {
+                writer = new ProfileWriter();
+                writer->go();
+            }
+        }
+
+        QueuedProfileEntry queued;
+        queued.dbName = dbName;
+        queued.entry = entry.getOwned();
+        if ( ! profileQueue.tryPush( queued ) )
+            profileEntriesDropped.increment();
+    }
+
+} // namespace
+
     void profile(const Client& c, int op, CurOp& currentOp) {
         // initialize with 1kb to start, to avoid realloc later
         // doing this outside the dblock to improve performance
         BufBuilder profileBufBuilder(1024);
 
         try {
-            Lock::DBWrite lk( currentOp.getNS() );
+            // the entry doesn't need the db lock; only writing it does
+            BSONObj p = _buildProfileEntry(c, currentOp, profileBufBuilder);
+
+            if (profileAsync) {
+                enqueueProfileEntry(nsToDatabase(currentOp.getNS()), p);
+                return;
+            }
+
+            // system.profile belongs to the whole database, not to the profiled collection
+            Lock::DBWrite lk( nsToDatabaseSubstring( currentOp.getNS() ) );
             if (dbHolder()._isLoaded(nsToDatabase(currentOp.getNS()), storageGlobalParams.dbpath)) {
                 Client::Context cx(currentOp.getNS(), storageGlobalParams.dbpath);
-                _profile(c, currentOp, profileBufBuilder);
+                _writeProfileEntry(cx.db(), p);
             }
             else {
                 mongo::log() << "note: not profiling because db went away - probably a close on: "
@@ -75,7 +75,24 @@ namespace mongo {
 
     Status JParse::value(const StringData& fieldName, BSONObjBuilder& builder) {
         MONGO_JSON_DEBUG("fieldName: " << fieldName);
-        if (accept(LBRACE, false)) {
+        // Strings and numbers are by far the most common values, so they are recognized by
+        // their first character before any of the keywords below are tried.
+        if (accept(DOUBLEQUOTE, false) || accept(SINGLEQUOTE, false)) {
+            std::string valueString;
+            valueString.reserve(STRINGVAL_RESERVE_SIZE);
+            Status ret = quotedString(&valueString);
+            if (ret != Status::OK()) {
+                return ret;
+            }
+            builder.append(fieldName, valueString);
+        }
+        else if (peekDigit()) {
+            Status ret = number(fieldName, builder);
+            if (ret != Status::OK()) {
+                return ret;
+            }
+        }
+        else if (accept(LBRACE, false)) {
             Status ret = object(fieldName, builder);
             if (ret != Status::OK()) {
                 return ret;
@@ -123,15 +140,6 @@ namespace mongo {
                 return ret;
             }
         }
-        else if (accept(DOUBLEQUOTE, false) || accept(SINGLEQUOTE, false)) {
-            std::string valueString;
-            valueString.reserve(STRINGVAL_RESERVE_SIZE);
-            Status ret = quotedString(&valueString);
-            if (ret != Status::OK()) {
-                return ret;
-            }
-            builder.append(fieldName, valueString);
-        }
         else if (accept("true")) {
             builder.append(fieldName, true);
         }
@@ -881,6 +889,15 @@ namespace mongo {
                 }
                 ++q;
             }
+            else if (allowedSet == NULL) {
+                // Append the whole run of ordinary characters at once.
+                const char* run = q++;
+                while (q < _input_end && *q != '\\' && !(0x00 <= *q && *q <= 0x1F) &&
+                       !match(*q, terminalSet)) {
+                    ++q;
+                }
+                result->append(run, q - run);
+            }
             else {
                 result->push_back(*q++);
             }
@@ -933,6 +950,14 @@ namespace mongo {
         return true;
     }
 
+    bool JParse::peekDigit() const {
+        const char* check = _input;
+        while (check < _input_end && isspace(*reinterpret_cast<const unsigned char*>(check))) {
+            ++check;
+        }
+        return check < _input_end && isdigit(*reinterpret_cast<const unsigned char*>(check));
+    }
+
     bool JParse::acceptField(const StringData& expectedField) {
         MONGO_JSON_DEBUG("expectedField: " << expectedField);
         std::string nextField;
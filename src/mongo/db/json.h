@@ -342,6 +342,12 @@ namespace mongo {
              */
             bool accept(const char* token, bool advance=true);
 
+            /**
+             * @return true if the next non whitespace character in our buffer
+             * is a decimal digit.  Does not update the pointer to our buffer.
+             */
+            bool peekDigit() const;
+
             /**
              * @return true if the next field in our stream matches field.
              * Handles single quoted, double quoted, and unquoted field names
@@ -36,18 +36,22 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/client.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
     LockState::LockState() 
         : _batchWriter(false),
+          _hasTicket(false),
           _recursive(0),
           _threadState(0),
           _whichNestable( Lock::notnestable ),
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionCount(0),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
           _lockPendingParallelWriter(false)
@@ -75,8 +79,11 @@ namespace mongo {
         nsToDatabase(ns, db);
         
         DEV verify( _otherName.find( '.' ) == string::npos ); // XXX this shouldn't be here, but somewhere
-        if ( _otherCount && db == _otherName )
-            return true;
+        if ( _otherCount && db == _otherName ) {
+            if ( !_collectionCount )
+                return true;
+            return ns.find( '.' ) == string::npos || isCollectionLocked( ns );
+        }
 
         if ( _nestableCount ) {
             if ( mongoutils::str::equals( db , "local" ) )
@@ -88,6 +95,16 @@ namespace mongo {
         return false;
     }
 
+    bool LockState::isCollectionLocked( const StringData& ns ) const {
+        if ( !_collectionCount )
+            return false;
+        if ( ns == _collectionName )
+            return true;
+        // one of its indexes, coll.$index
+        return ns.startsWith( _collectionName ) &&
+               ns.substr( _collectionName.size() ).startsWith( ".$" );
+    }
+
     void LockState::lockedStart( char newState ) {
         _threadState = newState;
     }
@@ -139,7 +156,18 @@ namespace mongo {
             if( k ) {
                 string s = "^";
                 s += k->name();
-                b.append(s, kind(_otherCount));
+                if( _collectionCount ) // intent lock on the db
+                    b.append(s, _otherCount > 0 ? "w" : "r");
+                else
+                    b.append(s, kind(_otherCount));
+            }
+        }
+        if( _collectionCount ) {
+            WrapperForRWLock *k = _collectionLock;
+            if( k ) {
+                string s = "^";
+                s += k->name();
+                b.append(s, kind(_collectionCount));
             }
         }
         BSONObj o = b.obj();
@@ -167,6 +195,9 @@ namespace mongo {
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
             }
+            if( _collectionCount ) {
+                ss << " collectionCount:" << _collectionCount << " collection:" << _collectionName;
+            }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
                 if( _whichNestable == Lock::local ) 
@@ -230,6 +261,20 @@ namespace mongo {
         _otherCount = 0;
     }
 
+    void LockState::lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock ) {
+        fassert( 17186 , _collectionCount == 0 && _otherCount != 0 );
+        _collectionName = ns.toString();
+        _collectionCount = type;
+        _collectionLock = lock;
+    }
+
+    void LockState::unlockedCollection() {
+        // unlike _otherLock we don't cache this one, as a thread usually moves between collections
+        _collectionCount = 0;
+        _collectionName.clear();
+        _collectionLock = NULL;
+    }
+
     LockStat* LockState::getRelevantLockStat() {
         if ( _whichNestable )
             return Lock::nestableLockStat( _whichNestable );
@@ -243,17 +288,46 @@ namespace mongo {
         return 0;
     }
 
+    LockStat* LockState::getCollectionLockStat() {
+        if ( _collectionCount && _collectionLock )
+            return &_collectionLock->stats;
+        return 0;
+    }
+
+
+    namespace {
+        // let a yielding op tell whether anyone could use the lock it is about to release
+        AtomicInt32 lockWaiters;
+        AtomicUInt64 lockAcquisitions;
+    }
+
+    int numLockWaiters() {
+        return lockWaiters.load();
+    }
+
+    unsigned long long numLockAcquisitions() {
+        return lockAcquisitions.load();
+    }
 
     Acquiring::Acquiring( Lock::ScopedLock* lock,  LockState& ls )
         : _lock( lock ), _ls( ls ){
         _ls._lockPending = true;
+        lockWaiters.fetchAndAdd( 1 );
     }
 
     Acquiring::~Acquiring() {
+        lockWaiters.fetchAndSubtract( 1 );
+        lockAcquisitions.fetchAndAdd( 1 );
         _ls._lockPending = false;
         LockStat* stat = _ls.getRelevantLockStat();
-        if ( stat && _lock )
-            stat->recordAcquireTimeMicros( _ls.threadState(), _lock->acquireFinished( stat ) );
+        if ( stat && _lock ) {
+            LockStat* collectionStat = _ls.getCollectionLockStat();
+            long long micros = _lock->acquireFinished( stat, collectionStat );
+            stat->recordAcquireTimeMicros( _ls.threadState(), micros );
+            if ( collectionStat )
+                collectionStat->recordAcquireTimeMicros( _ls.collectionCount() > 0 ? 'W' : 'R',
+                                                         micros );
+        }
     }
     
     AcquiringParallelWriter::AcquiringParallelWriter( LockState& ls )
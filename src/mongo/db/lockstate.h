@@ -32,6 +32,7 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/util/concurrency/qlock.h"
 
 namespace mongo {
 
@@ -59,7 +60,15 @@ namespace mongo {
         bool hasAnyReadLock() const; // explicitly rR
         bool hasAnyWriteLock() const; // wWX
         
-        bool isLocked( const StringData& ns ); // rwRW
+        /**
+         * rwRW.  While a single collection is locked (see collectionCount()) this is true for
+         * that collection and its indexes and for the database name itself, but not for the
+         * database's other collections.
+         */
+        bool isLocked( const StringData& ns );
+
+        /** true if just one collection is locked and ns is that collection or one of its indexes */
+        bool isCollectionLocked( const StringData& ns ) const;
 
         /** pending means we are currently trying to get a lock */
         bool hasLockPending() const { return _lockPending || _lockPendingParallelWriter; }
@@ -82,6 +91,10 @@ namespace mongo {
         int otherCount() const { return _otherCount; }
         const string& otherName() const { return _otherName; }
         WrapperForRWLock* otherLock() const { return _otherLock; }
+
+        int collectionCount() const { return _collectionCount; }
+        const string& collectionName() const { return _collectionName; }
+        WrapperForRWLock* collectionLock() const { return _collectionLock; }
         
         void enterScopedLock( Lock::ScopedLock* lock );
         Lock::ScopedLock* leaveScopedLock();
@@ -91,9 +104,13 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+        void lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock );
+        void unlockedCollection();
         bool _batchWriter;
+        bool _hasTicket;               // an outer lock of ours holds an admission ticket
 
         LockStat* getRelevantLockStat();
+        LockStat* getCollectionLockStat();
         void recordLockTime() { _scopedLk->recordTime(); }
         void resetLockTime() { _scopedLk->resetTime(); }
         
@@ -111,6 +128,11 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        // collection level locking related.  while set, the lock on _otherName is an intent lock
+        int _collectionCount;          // >0 means write lock, <0 read lock
+        string _collectionName;        // full ns of the one collection we are locking
+        WrapperForRWLock* _collectionLock;
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
@@ -123,20 +145,37 @@ namespace mongo {
         friend class AcquiringParallelWriter;
     };
 
+    /**
+     * The lock of a database, or of a collection when collection level locking is on.
+     * lock() and lock_shared() lock the whole database (collection); lock_intent() and
+     * lock_intent_shared() promise to lock a collection of the database as well, so that
+     * intent holders only exclude lock() and lock_shared() holders, not each other.
+     */
     class WrapperForRWLock : boost::noncopyable { 
-        SimpleRWLock r;
+        QLock q;
+        const string _name;
     public:
-        string name() const { return r.name; }
+        string name() const { return _name; }
         LockStat stats;
-        WrapperForRWLock(const StringData& name) : r(name) { }
-        void lock()          { r.lock(); }
-        void lock_shared()   { r.lock_shared(); }
-        void unlock()        { r.unlock(); }
-        void unlock_shared() { r.unlock_shared(); }
+        WrapperForRWLock(const StringData& name) : _name(name.toString()) { }
+        void lock()                 { q.lock_W(); }
+        void lock_shared()          { q.lock_R(); }
+        void lock_intent()          { q.lock_w(); }
+        void lock_intent_shared()   { q.lock_r(); }
+        void unlock()               { q.unlock_W(); }
+        void unlock_shared()        { q.unlock_R(); }
+        void unlock_intent()        { q.unlock_w(); }
+        void unlock_intent_shared() { q.unlock_r(); }
     };
 
     class ScopedLock;
 
+    /** @return the number of threads now waiting in Acquiring for a lock or a ticket */
+    int numLockWaiters();
+
+    /** @return the number of lock or ticket acquisitions that have gone through Acquiring */
+    unsigned long long numLockAcquisitions();
+
     class Acquiring {
     public:
         Acquiring( Lock::ScopedLock* lock, LockState& ls );
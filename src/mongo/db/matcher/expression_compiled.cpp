@@ -0,0 +1,287 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mongo/bson/bsonobjiterator.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    namespace {
+
+        bool isComparison( MatchExpression::MatchType type ) {
+            switch ( type ) {
+            case MatchExpression::LT:
+            case MatchExpression::LTE:
+            case MatchExpression::EQ:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool satisfies( MatchExpression::MatchType op, int x ) {
+            switch ( op ) {
+            case MatchExpression::LT:
+                return x < 0;
+            case MatchExpression::LTE:
+                return x <= 0;
+            case MatchExpression::EQ:
+                return x == 0;
+            case MatchExpression::GT:
+                return x > 0;
+            case MatchExpression::GTE:
+                return x >= 0;
+            default:
+                verify( false );
+                return false;
+            }
+        }
+
+        // Same as compareElementValues for two numbers.
+        int compareNumbers( const BSONElement& l, const BSONElement& r ) {
+            if ( l.type() == NumberInt && r.type() == NumberInt ) {
+                int L = l._numberInt();
+                int R = r._numberInt();
+                if ( L < R ) return -1;
+                return L == R ? 0 : 1;
+            }
+            if ( l.type() == NumberLong && r.type() == NumberLong ) {
+                long long L = l._numberLong();
+                long long R = r._numberLong();
+                if ( L < R ) return -1;
+                return L == R ? 0 : 1;
+            }
+            double left = l.number();
+            double right = r.number();
+            if ( left < right )
+                return -1;
+            if ( left == right )
+                return 0;
+            if ( isNaN( left ) )
+                return isNaN( right ) ? 0 : -1;
+            return 1;
+        }
+
+        // Same as compareElementValues for two strings.
+        int compareStrings( const BSONElement& l, const BSONElement& r ) {
+            int lsz = l.valuestrsize();
+            int rsz = r.valuestrsize();
+            int res = memcmp( l.valuestr(), r.valuestr(), std::min( lsz, rsz ) );
+            if ( res )
+                return res;
+            return lsz - rsz;
+        }
+
+    }  // namespace
+
+    CompiledMatchExpression::CompiledMatchExpression( const MatchExpression* root )
+        : _root( root ) {
+
+        if ( root->matchType() != MatchExpression::AND ) {
+            if ( isCompilable( root ) ) {
+                addPredicate( static_cast<const LeafMatchExpression*>( root ) );
+            }
+            else {
+                _rest.push_back( root );
+            }
+            return;
+        }
+
+        for ( size_t i = 0; i < root->numChildren(); ++i ) {
+            const MatchExpression* child = root->getChild( i );
+            if ( isCompilable( child ) ) {
+                addPredicate( static_cast<const LeafMatchExpression*>( child ) );
+            }
+            else {
+                _rest.push_back( child );
+            }
+        }
+    }
+
+    // static
+    bool CompiledMatchExpression::isCompilable( const MatchExpression* expr ) {
+        switch ( expr->matchType() ) {
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+            break;
+        default:
+            return false;
+        }
+
+        // A dotted path may go through arrays and objects, which is what ElementPath is for.
+        StringData path = expr->path();
+        return !path.empty() && string::npos == path.find( '.' );
+    }
+
+    void CompiledMatchExpression::addPredicate( const LeafMatchExpression* expr ) {
+        Predicate pred;
+        pred.expr = expr;
+        pred.kind = GENERIC;
+        pred.op = expr->matchType();
+
+        if ( isComparison( pred.op ) ) {
+            pred.rhs = static_cast<const ComparisonMatchExpression*>( expr )->getRHS();
+            if ( pred.rhs.isNumber() ) {
+                pred.kind = NUMBER;
+            }
+            else if ( pred.rhs.type() == String ) {
+                pred.kind = STRING;
+            }
+        }
+
+        for ( size_t i = 0; i < _fields.size(); ++i ) {
+            if ( _fields[i].name == expr->path() ) {
+                _fields[i].predicates.push_back( pred );
+                return;
+            }
+        }
+
+        if ( _fields.size() == kMaxFields ) {
+            _rest.push_back( expr );
+            return;
+        }
+
+        _fields.push_back( Field() );
+        _fields.back().name = expr->path();
+        _fields.back().predicates.push_back( pred );
+    }
+
+    size_t CompiledMatchExpression::numCompiled() const {
+        size_t num = 0;
+        for ( size_t i = 0; i < _fields.size(); ++i ) {
+            num += _fields[i].predicates.size();
+        }
+        return num;
+    }
+
+    bool CompiledMatchExpression::matchesBSON( const BSONObj& doc ) const {
+        if ( _fields.empty() ) {
+            return _root->matchesBSON( doc );
+        }
+
+        // Only the first field with a given name counts, as with BSONObj::getField.
+        unsigned long long seen = 0;
+        size_t numSeen = 0;
+
+        BSONObjIterator it( doc );
+        while ( it.more() && numSeen < _fields.size() ) {
+            BSONElement e = it.next();
+            StringData name = e.fieldNameStringData();
+            for ( size_t i = 0; i < _fields.size(); ++i ) {
+                unsigned long long bit = 1ULL << i;
+                if ( ( seen & bit ) || _fields[i].name != name ) {
+                    continue;
+                }
+                seen |= bit;
+                ++numSeen;
+                if ( !matchesField( _fields[i], e, doc ) ) {
+                    return false;
+                }
+                break;
+            }
+        }
+
+        // The fields the document doesn't have.
+        for ( size_t i = 0; numSeen < _fields.size() && i < _fields.size(); ++i ) {
+            if ( seen & ( 1ULL << i ) ) {
+                continue;
+            }
+            if ( !matchesField( _fields[i], BSONElement(), doc ) ) {
+                return false;
+            }
+        }
+
+        for ( size_t i = 0; i < _rest.size(); ++i ) {
+            if ( !_rest[i]->matchesBSON( doc ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // static
+    bool CompiledMatchExpression::matchesField( const Field& field,
+                                                const BSONElement& e,
+                                                const BSONObj& doc ) {
+        if ( e.type() == Array ) {
+            // Arrays are matched element by element, and sometimes as a whole.  The leaf knows
+            // how.
+            for ( size_t i = 0; i < field.predicates.size(); ++i ) {
+                if ( !field.predicates[i].expr->matchesBSON( doc ) ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        for ( size_t i = 0; i < field.predicates.size(); ++i ) {
+            if ( !matchesPredicate( field.predicates[i], e ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // static
+    bool CompiledMatchExpression::matchesPredicate( const Predicate& pred,
+                                                    const BSONElement& e ) {
+        switch ( pred.kind ) {
+        case NUMBER:
+            if ( e.isNumber() ) {
+                return satisfies( pred.op, compareNumbers( e, pred.rhs ) );
+            }
+            break;
+        case STRING:
+            if ( e.type() == String ) {
+                return satisfies( pred.op, compareStrings( e, pred.rhs ) );
+            }
+            break;
+        case GENERIC:
+            break;
+        }
+
+        return pred.expr->matchesSingleElement( e );
+    }
+
+}  // namespace mongo
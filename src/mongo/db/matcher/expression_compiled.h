@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    class LeafMatchExpression;
+
+    /**
+     * A flattened form of a MatchExpression tree for matching many documents against it.
+     *
+     * The leaves of the top-level AND that are over a single, non-dotted field (comparisons,
+     * $exists, $in, $mod and regexes) are evaluated in one pass over the fields of the document.
+     * Their field names are resolved up front, each field of the document is looked at once no
+     * matter how many predicates are over it, and comparisons against numbers and strings skip
+     * the generic comparison.  A field that holds an array is handed to the leaf itself, as are
+     * all other parts of the tree.
+     *
+     * matchesBSON gives the same answer as the tree's matchesBSON, but doesn't fill out
+     * MatchDetails; use the tree if you need them.
+     */
+    class CompiledMatchExpression {
+        MONGO_DISALLOW_COPYING( CompiledMatchExpression );
+    public:
+        /**
+         * 'root' is not owned and must outlive us.
+         */
+        explicit CompiledMatchExpression( const MatchExpression* root );
+
+        bool matchesBSON( const BSONObj& doc ) const;
+
+        /**
+         * How many predicates are evaluated in the single pass over the document?
+         */
+        size_t numCompiled() const;
+
+        // The single pass keeps track of the fields it has seen in a 64 bit mask.
+        static const size_t kMaxFields = 64;
+
+    private:
+        /**
+         * How a compiled predicate compares an element of its field.
+         */
+        enum Kind {
+            // Asks the leaf.
+            GENERIC,
+            // A comparison against a number, for numeric elements.
+            NUMBER,
+            // A comparison against a string, for string elements.
+            STRING,
+        };
+
+        struct Predicate {
+            // Not owned.
+            const LeafMatchExpression* expr;
+            Kind kind;
+            // The comparison operator and its operand, for NUMBER and STRING.
+            MatchExpression::MatchType op;
+            BSONElement rhs;
+        };
+
+        struct Field {
+            StringData name;
+            std::vector<Predicate> predicates;
+        };
+
+        /**
+         * Can the leaf 'expr' be evaluated in the single pass?
+         */
+        static bool isCompilable( const MatchExpression* expr );
+
+        void addPredicate( const LeafMatchExpression* expr );
+
+        /**
+         * Does the first element named 'field.name' in 'doc', 'e', satisfy all the predicates
+         * over the field?  'e' is EOO if the field is missing.
+         */
+        static bool matchesField( const Field& field, const BSONElement& e, const BSONObj& doc );
+
+        static bool matchesPredicate( const Predicate& pred, const BSONElement& e );
+
+        // Not owned.
+        const MatchExpression* _root;
+
+        std::vector<Field> _fields;
+
+        // Everything that isn't compiled is matched against the document on its own.  Not owned.
+        std::vector<const MatchExpression*> _rest;
+    };
+
+}  // namespace mongo
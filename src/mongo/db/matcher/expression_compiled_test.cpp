@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for CompiledMatchExpression. */
+
+#include "mongo/unittest/unittest.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+
+        /**
+         * Checks that the compiled form of 'query' matches each of 'docs' exactly when the tree
+         * does, and returns how many predicates were compiled.
+         */
+        size_t assertSameAsTree( const BSONObj& query, const BSONArray& docs ) {
+            StatusWithMatchExpression swme = MatchExpressionParser::parse( query );
+            ASSERT( swme.isOK() );
+            auto_ptr<MatchExpression> expr( swme.getValue() );
+            CompiledMatchExpression compiled( expr.get() );
+
+            BSONObjIterator it( docs );
+            while ( it.more() ) {
+                BSONObj doc = it.next().Obj();
+                ASSERT_EQUALS( expr->matchesBSON( doc ), compiled.matchesBSON( doc ) );
+            }
+            return compiled.numCompiled();
+        }
+
+        BSONArray someDocs() {
+            return BSON_ARRAY( BSONObj()
+                               << BSON( "a" << 1 )
+                               << BSON( "a" << 5 << "b" << "x" )
+                               << BSON( "a" << 5.5 << "b" << "y" )
+                               << BSON( "a" << 5LL << "b" << "xy" )
+                               << BSON( "a" << "5" << "b" << 3 )
+                               << BSON( "b" << "x" << "a" << 7 )
+                               << BSON( "a" << BSONNULL )
+                               << BSON( "a" << BSON_ARRAY( 1 << 5 << 9 ) << "b" << "x" )
+                               << BSON( "a" << BSON_ARRAY( BSON_ARRAY( 5 ) ) )
+                               << BSON( "a" << BSONArray() )
+                               << BSON( "a" << BSON( "c" << 5 ) << "b" << "x" )
+                               << BSON( "a" << 3 << "a" << 5 )
+                               << BSON( "c" << 1 << "b" << "xyz" << "a" << 4 ) );
+        }
+
+    }  // namespace
+
+    TEST( CompiledMatchExpression, Comparisons ) {
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: 5}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$lt: 5}}" ), someDocs() ) );
+        ASSERT_EQUALS( 2U, assertSameAsTree( fromjson( "{a: {$gte: 5, $lte: 6}}" ),
+                                             someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$gt: 4.5}}" ), someDocs() ) );
+        ASSERT_EQUALS( 2U, assertSameAsTree( fromjson( "{b: {$gt: 'x'}, a: {$lte: 5}}" ),
+                                             someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: null}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {c: 5}}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: [5]}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$gt: {$minKey: 1}}}" ),
+                                             someDocs() ) );
+    }
+
+    TEST( CompiledMatchExpression, NaN ) {
+        BSONArray docs = BSON_ARRAY( BSON( "a" << std::numeric_limits<double>::quiet_NaN() )
+                                     << BSON( "a" << 1.0 ) );
+        BSONObjBuilder nan;
+        nan.append( "a", std::numeric_limits<double>::quiet_NaN() );
+        BSONObj nanQuery = nan.obj();
+        ASSERT_EQUALS( 1U, assertSameAsTree( nanQuery, docs ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( BSON( "a" << BSON( "$lt" << 2.0 ) ), docs ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( BSON( "a" << BSON( "$gte" << 1 ) ), docs ) );
+    }
+
+    TEST( CompiledMatchExpression, OtherLeaves ) {
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$exists: true}}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$exists: false}}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$in: [1, 5, null]}}" ),
+                                             someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{a: {$mod: [2, 1]}}" ), someDocs() ) );
+        ASSERT_EQUALS( 1U, assertSameAsTree( fromjson( "{b: /^x/}" ), someDocs() ) );
+    }
+
+    TEST( CompiledMatchExpression, NotCompiled ) {
+        // Dotted paths, logical operators and array operators are matched by the tree.
+        ASSERT_EQUALS( 0U, assertSameAsTree( fromjson( "{'a.c': 5}" ), someDocs() ) );
+        ASSERT_EQUALS( 0U, assertSameAsTree( fromjson( "{$or: [{a: 5}, {b: 'x'}]}" ),
+                                             someDocs() ) );
+        ASSERT_EQUALS( 0U, assertSameAsTree( fromjson( "{a: {$ne: 5}}" ), someDocs() ) );
+        ASSERT_EQUALS( 0U, assertSameAsTree( fromjson( "{a: {$size: 3}}" ), someDocs() ) );
+        ASSERT_EQUALS( 0U, assertSameAsTree( fromjson( "{a: {$type: 2}}" ), someDocs() ) );
+    }
+
+    TEST( CompiledMatchExpression, Mixed ) {
+        ASSERT_EQUALS( 2U, assertSameAsTree( fromjson( "{a: {$gte: 5}, 'a.c': {$exists: false},"
+                                                       " $or: [{b: 'x'}, {b: 'y'}], b: /x/}" ),
+                                             someDocs() ) );
+        ASSERT_EQUALS( 0U, assertSameAsTree( BSONObj(), someDocs() ) );
+    }
+
+    TEST( CompiledMatchExpression, ManyFields ) {
+        // More fields than the single pass keeps track of.
+        BSONObjBuilder query;
+        BSONObjBuilder doc;
+        for ( size_t i = 0; i < CompiledMatchExpression::kMaxFields + 10; ++i ) {
+            string field = mongoutils::str::stream() << "f" << i;
+            query.append( field, static_cast<int>( i ) );
+            doc.append( field, static_cast<int>( i ) );
+        }
+        BSONObj fullDoc = doc.obj();
+        BSONArray docs = BSON_ARRAY( fullDoc
+                                     << fullDoc.removeField( "f70" )
+                                     << fullDoc.removeField( "f3" )
+                                     << BSONObj() );
+        ASSERT_EQUALS( CompiledMatchExpression::kMaxFields,
+                       assertSameAsTree( query.obj(), docs ) );
+    }
+
+}  // namespace mongo
@@ -105,6 +105,7 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        _compiled.reset( new CompiledMatchExpression( _expression.get() ) );
     }
 
     Matcher2::Matcher2( const Matcher2 &docMatcher, const BSONObj &constrainIndexKey )
@@ -122,8 +123,11 @@ namespace mongo {
         if ( !_expression )
             return true;
 
-        if ( _indexKey.isEmpty() )
+        if ( _indexKey.isEmpty() ) {
+            if ( !details && _compiled )
+                return _compiled->matchesBSON( doc );
             return _expression->matchesBSON( doc, details );
+        }
 
         if ( !doc.isEmpty() && doc.firstElement().fieldName()[0] )
             return _expression->matchesBSON( doc, details );
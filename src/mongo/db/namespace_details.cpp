@@ -36,11 +36,14 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/fts/fts_spec.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/json.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/hashtab.h"
 #include "mongo/util/startup_test.h"
@@ -309,9 +312,10 @@ namespace mongo {
             }
             if ( bestmatchlen < 0x7fffffff && --extra <= 0 )
                 break;
-            if ( ++chain > 30 && b < MaxBucket ) {
-                // too slow, force move to next bucket to grab a big chunk
-                //b++;
+            if ( ++chain > MaxDeletedListScan ) {
+                // too slow, force move to next bucket to grab a big chunk.  every record there
+                // fits; past the last bucket we give up and the caller allocates a new extent,
+                // so no allocation walks more than MaxDeletedListScan links of a bucket.
                 chain = 0;
                 cur.Null();
             }
@@ -578,6 +582,7 @@ namespace mongo {
 
     SimpleMutex NamespaceDetailsTransient::_qcMutex("qc");
     NamespaceDetailsTransient::DMap NamespaceDetailsTransient::_nsdMap;
+    AtomicUInt64 NamespaceDetailsTransient::_lastWriteStamp;
 
     void NamespaceDetailsTransient::reset() {
         Lock::assertWriteLocked(_ns); 
@@ -610,13 +615,102 @@ namespace mongo {
     // that is NOT handled here yet!  TODO
     // repair may not use nsdt though not sure.  anyway, requires work.
     NamespaceDetailsTransient::NamespaceDetailsTransient(Database *db, const string& ns) : 
-        _ns(ns), _keysComputed(false), _qcWriteCount() 
+        _ns(ns), _keysComputed(false), _writeStamp(_lastWriteStamp.addAndFetch(1)),
+        _extentsLength(0), _numExtents(0), _qcWriteCount(), _planCache(new PlanCache())
     {
         dassert(db);
+        for ( int i = 0; i < Buckets; i++ )
+            _sizePadding[i] = 0;
+    }
+
+    namespace {
+        // Documents that grow several times over would otherwise move on every update; the
+        // padding stays bounded since it is only paid by documents of sizes that grew.
+        const double maxSizePaddingFactor = 4.0;
+    }
+
+    void NamespaceDetailsTransient::sizePaddingTooSmall( int oldSize, int newSize ) {
+        double& f = _sizePadding[ NamespaceDetails::bucket( oldSize ) ];
+        double growth = min( maxSizePaddingFactor, static_cast<double>( newSize ) / oldSize );
+        // moving average, so one unusually large growth doesn't pad every later document
+        f = ( f == 0 ) ? growth : ( 3 * f + growth ) / 4;
+        if ( f < 1.0 )
+            f = 1.0;
+    }
+
+    void NamespaceDetailsTransient::sizePaddingFits( int size ) {
+        double& f = _sizePadding[ NamespaceDetails::bucket( size ) ];
+        if ( f > 1.0 )
+            f = max( 1.0, f - 0.001 );
     }
 
     NamespaceDetailsTransient::~NamespaceDetailsTransient() { 
     }
+
+    long long NamespaceDetailsTransient::storageSize( const string& ns, const NamespaceDetails* d,
+                                                      int* numExtents ) {
+        {
+            SimpleMutex::scoped_lock lk(_qcMutex);
+            NamespaceDetailsTransient& t = get_inlock(ns);
+            if ( !t._extentsFirst.isNull() &&
+                 t._extentsFirst == d->firstExtent() && t._extentsLast == d->lastExtent() ) {
+                *numExtents = t._numExtents;
+                return t._extentsLength;
+            }
+        }
+
+        // the extents can't change under our lock, so the walk is consistent with its ends
+        long long total = d->storageSize( numExtents );
+
+        SimpleMutex::scoped_lock lk(_qcMutex);
+        NamespaceDetailsTransient& t = get_inlock(ns);
+        t._extentsFirst = d->firstExtent();
+        t._extentsLast = d->lastExtent();
+        t._extentsLength = total;
+        t._numExtents = *numExtents;
+        return total;
+    }
+
+    void NamespaceDetailsTransient::extentAdded( const string& ns, const DiskLoc& prevLast,
+                                                 const DiskLoc& loc, int length ) {
+        SimpleMutex::scoped_lock lk(_qcMutex);
+        CMap& m = get_cmap_inlock(ns);
+        CMap::iterator i = m.find( ns );
+        if ( i == m.end() || !i->second.get() )
+            return;
+        NamespaceDetailsTransient& t = *i->second;
+        if ( t._extentsFirst.isNull() || t._extentsLast != prevLast )
+            return;
+        t._extentsLast = loc;
+        t._extentsLength += length;
+        t._numExtents++;
+    }
+
+    void NamespaceDetailsTransient::extentsFreed( const string& ns ) {
+        SimpleMutex::scoped_lock lk(_qcMutex);
+        CMap& m = get_cmap_inlock(ns);
+        CMap::iterator i = m.find( ns );
+        if ( i != m.end() && i->second.get() )
+            i->second->_extentsFirst.Null();
+    }
+
+    void NamespaceDetailsTransient::clearQueryCache() {
+        _qcCache.clear();
+        _qcWriteCount = 0;
+        _planCache->clear();
+    }
+
+    void NamespaceDetailsTransient::notifyOfWriteOp() {
+        documentsChanged();
+        _planCache->notifyOfWriteOp();
+        if ( _qcCache.empty() )
+            return;
+        if ( ++_qcWriteCount >= 100 ) {
+            // The PlanCache keeps its own write count.
+            _qcCache.clear();
+            _qcWriteCount = 0;
+        }
+    }
     
     void NamespaceDetailsTransient::resetCollection(const string& ns ) {
         SimpleMutex::scoped_lock lk(_qcMutex);
@@ -651,7 +745,33 @@ namespace mongo {
 
         NamespaceDetails::IndexIterator i = d->ii( true );
         while( i.more() ) {
-            BSONObj key = i.next().keyPattern();
+            IndexDetails& idx = i.next();
+            BSONObj key = idx.keyPattern();
+
+            // A text index key pattern names internal fields; the document fields it reads are
+            // in the spec.
+            const string pluginName = IndexNames::findPluginName( key );
+            if ( IndexNames::TEXT == pluginName || IndexNames::TEXT_INTERNAL == pluginName ) {
+                fts::FTSSpec spec( idx.info.obj() );
+                if ( spec.wildcard() ) {
+                    _indexedPaths.addAllPaths();
+                }
+                else {
+                    const fts::Weights& weights = spec.weights();
+                    for ( fts::Weights::const_iterator w = weights.begin();
+                          w != weights.end();
+                          ++w ) {
+                        _indexedPaths.addPath( w->first );
+                    }
+                }
+                _indexedPaths.addPath( spec.languageOverrideField() );
+                for ( size_t k = 0; k < spec.numExtraBefore(); k++ )
+                    _indexedPaths.addPath( spec.extraBefore( k ) );
+                for ( size_t k = 0; k < spec.numExtraAfter(); k++ )
+                    _indexedPaths.addPath( spec.extraAfter( k ) );
+                continue;
+            }
+
             BSONObjIterator j( key );
             while ( j.more() ) {
                 BSONElement e = j.next();
@@ -784,7 +904,7 @@ namespace mongo {
 
 
 
-    int NamespaceDetails::getRecordAllocationSize( int minRecordSize ) {
+    int NamespaceDetails::getRecordAllocationSize( int minRecordSize, double sizePaddingFactor ) {
 
         if ( isCapped() )
             return minRecordSize;
@@ -801,6 +921,8 @@ namespace mongo {
         }
 
         // adjust for padding factor
+        if ( sizePaddingFactor >= 1 )
+            return static_cast<int>(minRecordSize * sizePaddingFactor);
         return static_cast<int>(minRecordSize * _paddingFactor);
     }
 
@@ -40,10 +40,12 @@
 #include "mongo/db/querypattern.h"
 #include "mongo/db/storage/namespace.h"
 #include "mongo/db/storage/namespace_index.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
     class Database;
+    class PlanCache;
 
     /** @return true if a client can modify this namespace even though it is under ".system."
         For example <dbname>.system.users is ok for regular clients to update.
@@ -57,6 +59,9 @@ namespace mongo {
     const int Buckets = 19;
     const int MaxBucket = 18;
 
+    /** how many deleted records of one bucket an allocation looks at before moving on */
+    const int MaxDeletedListScan = 30;
+
     extern int bucketSizes[];
 
 #pragma pack(1)
@@ -173,6 +178,7 @@ namespace mongo {
         Extent *theCapExtent() const { return _capExtent.ext(); }
         void advanceCapExtent( const char *ns );
         DiskLoc __capAlloc(int len);
+        long long cappedFreeBytesInCurExtent();
         DiskLoc cappedAlloc(const char *ns, int len);
         DiskLoc &cappedFirstDeletedInCurExtent();
         bool nextIsInCapExtent( const DiskLoc &dl ) const;
@@ -220,6 +226,16 @@ namespace mongo {
          */
         static bool validMaxCappedDocs( long long* max );
 
+        /**
+         * Counts the records allocated in any capped collection.  An awaitData getmore reads it
+         * before looking for data and passes it to waitForCappedInsert(), so that it wakes as
+         * soon as there may be something new to return.
+         */
+        static unsigned long long cappedInsertCount();
+
+        /** Waits up to maxMillis for a capped insert past the "lastSeen" count. */
+        static void waitForCappedInsert( unsigned long long lastSeen, int maxMillis );
+
         DiskLoc& cappedListOfAllDeletedRecords() { return _deletedList[0]; }
         DiskLoc& cappedLastDelRecLastExtent()    { return _deletedList[1]; }
         void cappedDumpDelInfo();
@@ -304,11 +320,14 @@ namespace mongo {
         int fieldIsIndexed(const char *fieldName);
 
         /**
+         * @param sizePaddingFactor padding learned for records of this size (see
+         *        NamespaceDetailsTransient::sizePaddingFactor()), used instead of the
+         *        collection's paddingFactor when >= 1
          * @return the actual size to create
          *         will be >= oldRecordSize
          *         based on padding and any other flags
          */
-        int getRecordAllocationSize( int minRecordSize );
+        int getRecordAllocationSize( int minRecordSize, double sizePaddingFactor = 0 );
 
         double paddingFactor() const { return _paddingFactor; }
 
@@ -592,6 +611,59 @@ namespace mongo {
             return _indexedPaths;
         }
 
+        /* per-size padding ---------------------------------------------------------- */
+        /* assumed to be in write lock for this */
+    private:
+        /* padding factor learned from the moves of documents in each deleted-record bucket,
+           keyed by the document's size before it grew.  0 until a document of that size moves,
+           in which case the collection's paddingFactor applies.
+        */
+        double _sizePadding[Buckets];
+    public:
+        /* an update of a document of 'oldSize' bytes to 'newSize' bytes didn't fit in place */
+        void sizePaddingTooSmall( int oldSize, int newSize );
+        /* an update of a document of 'size' bytes fit in place */
+        void sizePaddingFits( int size );
+        /* @return the padding factor learned for documents of 'size' bytes, or 0 if none */
+        double sizePaddingFactor( int size ) const {
+            return _sizePadding[ NamespaceDetails::bucket( size ) ];
+        }
+
+        /* write stamp ------------------------------------------------------------ */
+        /* assumed to be in write lock to change it, read lock to read it */
+    private:
+        /* set, to a value no NamespaceDetailsTransient has had before, whenever a document of
+           the collection is written.  lets caches of what the documents hash or count to tell
+           whether they are still current without being told of every write.
+        */
+        unsigned long long _writeStamp;
+        static AtomicUInt64 _lastWriteStamp;
+    public:
+        void documentsChanged() { _writeStamp = _lastWriteStamp.addAndFetch( 1 ); }
+        unsigned long long writeStamp() const { return _writeStamp; }
+
+        /* extent totals ---------------------------------------------------------- */
+        /* assumed to be in _qcMutex for these */
+    private:
+        /* storage size and number of the extents from _extentsFirst to _extentsLast.  valid while
+           those are still the collection's first and last extents, and kept current by
+           extentAdded() as extents are appended.  _extentsFirst is null until the first walk.
+        */
+        DiskLoc _extentsFirst;
+        DiskLoc _extentsLast;
+        long long _extentsLength;
+        int _numExtents;
+    public:
+        /* @return the storage size of ns, and its number of extents in *numExtents.  the extents
+           are only walked if they changed other than by extentAdded() since the last walk.
+        */
+        static long long storageSize( const string& ns, const NamespaceDetails* d, int* numExtents );
+        /* an extent of 'length' bytes at 'loc' was appended to ns after 'prevLast' */
+        static void extentAdded( const string& ns, const DiskLoc& prevLast, const DiskLoc& loc,
+                                 int length );
+        /* extents of ns were freed; the next storageSize() walks them */
+        static void extentsFreed( const string& ns );
+
         /* query cache (for query optimizer) ------------------------------------- */
     private:
         int _qcWriteCount;
@@ -615,17 +687,10 @@ namespace mongo {
             return get_inlock(ns);
         }
 
-        void clearQueryCache() {
-            _qcCache.clear();
-            _qcWriteCount = 0;
-        }
+        /* clears both the query optimizer's cache and the new query framework's PlanCache */
+        void clearQueryCache();
         /* you must notify the cache if you are doing writes, as query plan utility will change */
-        void notifyOfWriteOp() {
-            if ( _qcCache.empty() )
-                return;
-            if ( ++_qcWriteCount >= 100 )
-                clearQueryCache();
-        }
+        void notifyOfWriteOp();
         CachedQueryPlan cachedQueryPlanForPattern( const QueryPattern &pattern ) {
             return _qcCache[ pattern ];
         }
@@ -634,6 +699,13 @@ namespace mongo {
             _qcCache[ pattern ] = cachedQueryPlan;
         }
 
+        /* plan cache (for the new query framework) ---------------------------- */
+    private:
+        scoped_ptr<PlanCache> _planCache;
+    public:
+        /* the PlanCache is internally synchronized.  do not hold onto it across yields. */
+        PlanCache& getPlanCache() { return *_planCache; }
+
     }; /* NamespaceDetailsTransient */
 
     inline NamespaceDetailsTransient& NamespaceDetailsTransient::get_inlock(const string& ns) {
@@ -0,0 +1,216 @@
+// @file normalized_key.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/normalized_key.h"
+
+#include "mongo/platform/float_utils.h"
+
+namespace mongo {
+
+    namespace {
+
+        // the type byte is the canonical type moved above 0, which ends an object
+        const unsigned char EndOfObject = 0;
+
+        inline unsigned char typeByte(const BSONElement& e) {
+            // Date and Timestamp share a canonical type, but woCompare() can't compare one 
+            // with the other (it asserts for a Date on the left).  we put Timestamps after 
+            // Dates; 46 is not a canonical type.
+            if( e.type() == Timestamp )
+                return (unsigned char) (e.canonicalType() + 3);
+            return (unsigned char) (e.canonicalType() + 2);
+        }
+
+        inline void appendBigEndian(BufBuilder& b, unsigned long long x, int nbytes) {
+            char *p = b.skip(nbytes);
+            for( int i = nbytes - 1; i >= 0; i-- ) {
+                p[i] = (char) (x & 0xff);
+                x >>= 8;
+            }
+        }
+
+        /** a cstring, which has no nulls inside it, followed by its null */
+        inline void appendCString(BufBuilder& b, const char *s) {
+            b.appendBuf(s, strlen(s) + 1);
+        }
+
+        /** nulls in the string are escaped as 00 ff so that 00 00 can end it: the end of the
+            string then sorts below anything that continues it, as a shorter string does.
+        */
+        inline void appendEscapedString(BufBuilder& b, const char *s, int len) {
+            const char *end = s + len;
+            while( s < end ) {
+                const char *z = (const char *) memchr(s, 0, end - s);
+                if( z == 0 ) {
+                    b.appendBuf(s, end - s);
+                    break;
+                }
+                b.appendBuf(s, z - s);
+                b.appendUChar(0);
+                b.appendUChar(0xff);
+                s = z + 1;
+            }
+            b.appendUChar(0);
+            b.appendUChar(0);
+        }
+
+        bool appendValue(const BSONElement& e, BufBuilder& b);
+
+        bool appendObject(const BSONObj& o, BufBuilder& b) {
+            BSONObjIterator i(o);
+            while( i.more() ) {
+                BSONElement e = i.next();
+                b.appendUChar(typeByte(e));
+                appendCString(b, e.fieldName());
+                if( !appendValue(e, b) )
+                    return false;
+            }
+            b.appendUChar(EndOfObject);
+            return true;
+        }
+
+        /** the value of e in an encoding whose memcmp order is compareElementValues() order
+            among elements of its canonical type, and which is never a prefix of the encoding
+            of a different value of that type.
+        */
+        bool appendValue(const BSONElement& e, BufBuilder& b) {
+            switch( e.type() ) {
+            case EOO:
+            case Undefined:
+            case jstNULL:
+            case MinKey:
+            case MaxKey:
+                // the type byte says it all
+                break;
+            case NumberLong:
+                {
+                    long long n = e._numberLong();
+                    long long m = 1LL << 53;
+                    if( n > m || n < -m ) {
+                        // compares with doubles inexactly
+                        return false;
+                    }
+                }
+                // fall through
+            case NumberInt:
+            case NumberDouble:
+                {
+                    double d = e.number();
+                    if( isNaN(d) ) {
+                        // NaN is less than any other number, and equal to itself
+                        b.appendUChar(0);
+                        break;
+                    }
+                    if( d == 0 )
+                        d = 0; // -0 == 0
+                    unsigned long long bits;
+                    memcpy(&bits, &d, sizeof(bits));
+                    // negatives sort below positives, and the more negative the lower
+                    if( bits >> 63 )
+                        bits = ~bits;
+                    else
+                        bits |= 1ULL << 63;
+                    b.appendUChar(1);
+                    appendBigEndian(b, bits, 8);
+                    break;
+                }
+            case String:
+            case Symbol:
+            case Code:
+                appendEscapedString(b, e.valuestr(), e.valuestrsize() - 1);
+                break;
+            case Object:
+            case Array:
+                return appendObject(e.embeddedObject(), b);
+            case BinData:
+                {
+                    // length, then subtype, then the data
+                    int len = e.objsize();
+                    appendBigEndian(b, (unsigned) len, 4);
+                    b.appendBuf(e.value() + 4, len + 1);
+                    break;
+                }
+            case jstOID:
+                b.appendBuf(e.value(), 12);
+                break;
+            case Bool:
+                b.appendUChar(*e.value());
+                break;
+            case Date:
+                // signed
+                appendBigEndian(b, ((unsigned long long) e.date().millis) ^ (1ULL << 63), 8);
+                break;
+            case Timestamp:
+                appendBigEndian(b, e.date().millis, 8);
+                break;
+            case RegEx:
+                appendCString(b, e.regex());
+                appendCString(b, e.regexFlags());
+                break;
+            case DBRef:
+                {
+                    int len = e.valuesize();
+                    appendBigEndian(b, (unsigned) len, 4);
+                    b.appendBuf(e.value(), len);
+                    break;
+                }
+            default:
+                // CodeWScope
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace
+
+    bool NormalizedKey::append(const BSONObj& key, const Ordering& o, BufBuilder& out) {
+        BSONObjIterator i(key);
+        unsigned mask = 1;
+        while( i.more() ) {
+            BSONElement e = i.next();
+            int start = out.len();
+            out.appendUChar(typeByte(e));
+            if( !appendValue(e, out) )
+                return false;
+            if( o.descending(mask) ) {
+                // the field's encodings are prefix free, so inverting them reverses their order
+                char *p = out.buf() + start;
+                char *end = out.buf() + out.len();
+                for( ; p < end; p++ )
+                    *p = ~*p;
+            }
+            mask <<= 1;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,69 @@
+// @file normalized_key.h index keys as memcmp-comparable byte strings
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /** Encodes an index key into a byte string whose memcmp() order is the order
+        BSONObj::woCompare(other, ordering, false) gives the keys -- type brackets, mixed
+        numeric types, strings with embedded nulls, nested objects and descending fields
+        included -- so that comparing two encoded keys is a single memcmp rather than a walk
+        over the elements.
+
+        Only keys with the same number of fields (i.e., keys from the same index) may be
+        compared this way; a shorter key is not necessarily less.  A Date and a Timestamp,
+        which woCompare() can't order, are put Dates first.
+
+        Not every value can be encoded: CodeWScope compares its scope with strcmp, and a
+        NumberLong beyond 2^53 compares against doubles through a lossy conversion, so neither
+        has a memcmp-able form.  append() returns false for keys containing them and the
+        caller compares the BSON as usual, much as KeyV1 keeps such keys in bson format.
+    */
+    class NormalizedKey {
+    public:
+        /** appends the encoding of key to out.
+            @return false if key holds a value with no encoding; out is then left with a
+                    partial encoding which the caller should discard.
+        */
+        static bool append(const BSONObj& key, const Ordering& o, BufBuilder& out);
+
+        /** @return <0, 0 or >0 as the keys the encodings came from compare under their ordering */
+        static int compare(const char *l, int llen, const char *r, int rlen) {
+            int res = memcmp(l, r, std::min(llen, rlen));
+            if( res )
+                return res;
+            return llen - rlen;
+        }
+    };
+
+}
@@ -0,0 +1,194 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/normalized_key.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    int sign(int x) {
+        return x < 0 ? -1 : ( x > 0 ? 1 : 0 );
+    }
+
+    /** one-field values of every encodable type, with ties across numeric types */
+    BSONObj sampleValues() {
+        BSONObjBuilder b;
+        b.appendMinKey("");
+        b.appendMaxKey("");
+        b.appendNull("");
+        b.appendUndefined("");
+        b.append("", std::numeric_limits<double>::quiet_NaN());
+        b.append("", -std::numeric_limits<double>::infinity());
+        b.append("", std::numeric_limits<double>::infinity());
+        b.append("", -1.5);
+        b.append("", -1);
+        b.append("", -0.0);
+        b.append("", 0);
+        b.append("", 0LL);
+        b.append("", 0.5);
+        b.append("", 1);
+        b.append("", 1LL);
+        b.append("", 1.0);
+        b.append("", 1LL << 53);
+        b.append("", -(1LL << 53));
+        b.append("", 1e300);
+        b.append("", "");
+        b.append("", "a");
+        b.append("", std::string("a\0", 2));
+        b.append("", std::string("a\0b", 3));
+        b.append("", "a\x01");
+        b.append("", "ab");
+        b.append("", "b");
+        b.append("", "\xff");
+        b.appendSymbol("", "ab");
+        b.appendCode("", "ab");
+        b.appendCode("", "");
+        b.append("", BSONObj());
+        b.append("", BSON("a" << 1));
+        b.append("", BSON("a" << 1.0 << "b" << "x"));
+        b.append("", BSON("a" << "x"));
+        b.append("", BSON("b" << 1));
+        b.append("", BSON("a" << BSON("c" << 1)));
+        b.appendArray("", BSONObj());
+        b.append("", BSON_ARRAY(1 << 2));
+        b.append("", BSON_ARRAY(1));
+        b.append("", BSON_ARRAY("z"));
+        b.appendBinData("", 0, BinDataGeneral, "");
+        b.appendBinData("", 2, BinDataGeneral, "ab");
+        b.appendBinData("", 2, bdtCustom, "ab");
+        b.appendBinData("", 3, BinDataGeneral, "aaa");
+        b.append("", OID("000000000000000000000000"));
+        b.append("", OID("00000000000000000000000f"));
+        b.append("", OID("f00000000000000000000000"));
+        b.append("", false);
+        b.append("", true);
+        b.appendDate("", Date_t(0));
+        b.appendDate("", Date_t(1000));
+        b.appendDate("", Date_t((unsigned long long) -1000LL));
+        b.appendTimestamp("", 0);
+        b.appendTimestamp("", 1000);
+        b.appendTimestamp("", (unsigned long long) -1LL);
+        b.appendRegex("", "a", "");
+        b.appendRegex("", "a", "i");
+        b.appendRegex("", "ab", "");
+        return b.obj();
+    }
+
+    /** every key of two fields from the sample values */
+    vector<BSONObj> sampleKeys() {
+        vector<BSONElement> values;
+        BSONObj sample = sampleValues();
+        sample.elems(values);
+
+        vector<BSONObj> keys;
+        for ( size_t i = 0; i < values.size(); i++ ) {
+            for ( size_t j = 0; j < values.size(); j += 7 ) {
+                BSONObjBuilder b;
+                b.appendAs(values[i], "");
+                b.appendAs(values[j], "");
+                keys.push_back(b.obj());
+            }
+        }
+        return keys;
+    }
+
+    /** woCompare() asserts when comparing a Date with a Timestamp */
+    bool comparable(const BSONObj& l, const BSONObj& r) {
+        BSONObjIterator i(l);
+        BSONObjIterator j(r);
+        while ( i.more() && j.more() ) {
+            BSONElement a = i.next();
+            BSONElement b = j.next();
+            if ( ( a.type() == Date && b.type() == Timestamp ) ||
+                 ( a.type() == Timestamp && b.type() == Date ) )
+                return false;
+        }
+        return true;
+    }
+
+    void checkOrdering(const BSONObj& keyPattern) {
+        Ordering o = Ordering::make(keyPattern);
+        vector<BSONObj> keys = sampleKeys();
+
+        vector<string> encoded;
+        for ( size_t i = 0; i < keys.size(); i++ ) {
+            BufBuilder b;
+            ASSERT( NormalizedKey::append(keys[i], o, b) );
+            encoded.push_back(string(b.buf(), b.len()));
+        }
+
+        for ( size_t i = 0; i < keys.size(); i++ ) {
+            for ( size_t j = 0; j < keys.size(); j++ ) {
+                if ( !comparable(keys[i], keys[j]) )
+                    continue;
+                int expected = sign(keys[i].woCompare(keys[j], o, false));
+                int actual = sign(NormalizedKey::compare(encoded[i].data(), encoded[i].size(),
+                                                         encoded[j].data(), encoded[j].size()));
+                if ( expected != actual ) {
+                    FAIL(mongoutils::str::stream() << keys[i] << " vs " << keys[j]
+                                                   << " under " << keyPattern
+                                                   << ": expected " << expected
+                                                   << " got " << actual);
+                }
+            }
+        }
+    }
+
+    TEST(NormalizedKeyTest, Ascending) {
+        checkOrdering(BSON("a" << 1 << "b" << 1));
+    }
+
+    TEST(NormalizedKeyTest, Descending) {
+        checkOrdering(BSON("a" << -1 << "b" << -1));
+    }
+
+    TEST(NormalizedKeyTest, Mixed) {
+        checkOrdering(BSON("a" << 1 << "b" << -1));
+        checkOrdering(BSON("a" << -1 << "b" << 1));
+    }
+
+    TEST(NormalizedKeyTest, Unencodable) {
+        Ordering o = Ordering::make(BSON("a" << 1));
+        BufBuilder b;
+        ASSERT_FALSE( NormalizedKey::append(BSON("" << ((1LL << 53) + 1)), o, b) );
+        b.reset();
+        ASSERT_FALSE( NormalizedKey::append(BSON("" << BSON("x" << (-(1LL << 53) - 1))), o, b) );
+        b.reset();
+        BSONObjBuilder code;
+        code.appendCodeWScope("", "x", BSONObj());
+        ASSERT_FALSE( NormalizedKey::append(code.obj(), o, b) );
+    }
+
+} // namespace
+} // namespace mongo
@@ -30,9 +30,12 @@
 
 #include "mongo/db/ops/count.h"
 
+#include <limits>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/intervalbtreecursor.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -89,6 +92,9 @@ namespace mongo {
         }
 
         shared_ptr<Cursor> cursor = getOptimizedCursor( ns, query, BSONObj(), _countPlanPolicies );
+        // When the query bounds are matched exactly by an interval cursor, the keys between the
+        // endpoints need only be counted.
+        IntervalBtreeCursor* intervalCursor = dynamic_cast<IntervalBtreeCursor*>( cursor.get() );
         ClientCursorHolder ccPointer;
         ElapsedTracker timeToStartYielding( 256, 20 );
         try {
@@ -112,6 +118,12 @@ namespace mongo {
                     }
                     else {
                         ++count;
+                        if ( intervalCursor && !intervalCursor->matcher() &&
+                             !intervalCursor->isMultiKey() ) {
+                            count += intervalCursor->skipKeysInBucket(
+                                    limit > 0 ? limit - count :
+                                    std::numeric_limits<long long>::max() );
+                        }
                         if ( limit > 0 && count >= limit ) {
                             break;
                         }
@@ -37,6 +37,7 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/pdfile.h"
@@ -49,11 +50,13 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_reads_ok.h"
 #include "mongo/db/scanandorder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h"  // for SendStaleConfigException
 #include "mongo/server.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/mmap.h"
 
 namespace mongo {
 
@@ -93,7 +96,7 @@ namespace mongo {
 
     /* empty result for error conditions */
     QueryResult* emptyMoreResult(long long cursorid) {
-        BufBuilder b(32768);
+        BufBuilder b(sizeof(QueryResult));
         b.skip(sizeof(QueryResult));
         QueryResult *qr = (QueryResult *) b.buf();
         qr->cursorId = 0; // 0 indicates no more data to retrieve.
@@ -106,6 +109,42 @@ namespace mongo {
         return qr;
     }
 
+    // How far ahead of a tailing cursor on the oplog a getMore asks the OS to read, when the
+    // cursor's position isn't in memory.  0 disables the read-ahead.
+    MONGO_EXPORT_SERVER_PARAMETER(oplogReadAheadBytes, int, 8 * 1024 * 1024);
+
+    /**
+     * Asks the OS to start reading in the oplog from 'loc' on, so that a lagging member reading
+     * old oplog doesn't fault page by page while holding the read lock.  The range may wrap
+     * from the last extent of the capped collection to the first.
+     */
+    static void prefetchOplogAhead(const char* ns, const DiskLoc& loc) {
+        int remaining = oplogReadAheadBytes;
+        if (remaining <= 0 || loc.isNull() || loc.rec()->likelyInPhysicalMemory())
+            return;
+
+        NamespaceDetails* nsd = nsdetails(ns);
+        if (NULL == nsd)
+            return;
+
+        Extent* const start = loc.rec()->myExtent(loc);
+        Extent* e = start;
+        char* p = reinterpret_cast<char*>(loc.rec());
+        while (remaining > 0) {
+            char* end = reinterpret_cast<char*>(e) + e->length;
+            unsigned len = std::min<long long>(end - p, remaining);
+            MAdvise::willNeed(p, len);
+            remaining -= len;
+
+            e = e->getNextExtent();
+            if (NULL == e)
+                e = nsd->firstExtent().ext();
+            if (e == start)
+                break;
+            p = reinterpret_cast<char*>(e);
+        }
+    }
+
     static BSONObj extractKey(Cursor* c, const KeyPattern& usingKeyPattern ) {
         KeyPattern currentIndex( c->indexKeyPattern() );
         if ( usingKeyPattern.isCoveredBy( currentIndex ) && ! currentIndex.isSpecial() ){
@@ -193,6 +232,9 @@ namespace mongo {
             c->recoverFromYield();
             DiskLoc last;
 
+            if ( c->tailable() && c->ok() && NamespaceString::oplog( ns ) )
+                prefetchOplogAhead( ns, c->currLoc() );
+
             // This metadata may be stale, but it's the state of chunking when the cursor was
             // created.
             CollectionMetadataPtr metadata = cc->getCollMetadata();
@@ -351,6 +351,8 @@ namespace mongo {
                 // no work to do, in which case we want to consider the object unchanged.
                 if (!damages.empty() ) {
                     nsDetails->paddingFits();
+                    nsDetailsTransient->sizePaddingFits( oldObj.objsize() );
+                    nsDetailsTransient->documentsChanged();
 
                     // All updates were in place. Apply them via durability and writing pointer.
                     mutablebson::DamageVector::const_iterator where = damages.begin();
@@ -369,8 +371,11 @@ namespace mongo {
             }
             else {
 
-                // The updates were not in place. Apply them through the file manager.
+                // The updates were not in place. Apply them through the file manager. A
+                // replacement doesn't report the fields it touches, so it always updates indexes.
                 newObj = doc.getObject();
+                const bool indexesAffected =
+                    driver->isDocReplacement() || driver->modsAffectIndices();
                 DiskLoc newLoc = theDataFileMgr.updateRecord(nsString.ns().c_str(),
                                                              nsDetails,
                                                              nsDetailsTransient,
@@ -378,7 +383,9 @@ namespace mongo {
                                                              loc,
                                                              newObj.objdata(),
                                                              newObj.objsize(),
-                                                             *opDebug);
+                                                             *opDebug,
+                                                             false,
+                                                             indexesAffected);
 
                 // If we've moved this object to a new location, make sure we don't apply
                 // that update again if our traversal picks the objecta again.
@@ -34,9 +34,11 @@
 #include "mongo/db/pagefault.h"
 
 #include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/server.h"
+#include "mongo/util/timer.h"
 
 namespace mongo { 
 
@@ -60,7 +62,13 @@ namespace mongo {
             MONGO_DLOG(2) << "era changed" << endl;
             return;
         }
+        Timer t;
         r->touch();
+        CurOp* curop = cc().curop();
+        if ( curop ) {
+            curop->debug().pageFaultRetries++;
+            curop->debug().pageFaultMicros += t.micros();
+        }
     }
 
     PageFaultRetryableSection::~PageFaultRetryableSection() {
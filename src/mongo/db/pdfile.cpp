@@ -73,6 +73,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/file.h"
@@ -359,10 +360,12 @@ namespace mongo {
         if ( details ) {
             verify( !details->lastExtent().isNull() );
             verify( !details->firstExtent().isNull() );
-            getDur().writingDiskLoc(e->xprev) = details->lastExtent();
-            getDur().writingDiskLoc(details->lastExtent().ext()->xnext) = eloc;
+            DiskLoc prevLast = details->lastExtent();
+            getDur().writingDiskLoc(e->xprev) = prevLast;
+            getDur().writingDiskLoc(prevLast.ext()->xnext) = eloc;
             verify( !eloc.isNull() );
             details->setLastExtent( eloc );
+            NamespaceDetailsTransient::extentAdded( ns, prevLast, eloc, e->length );
         }
         else {
             ni->add_ns(ns, eloc, capped);
@@ -480,6 +483,16 @@ namespace mongo {
         }
     }
 
+    /** the record store over d's extents; built from d rather than taken from the database's
+        collection cache, which has no entries for index namespaces */
+    class NamespaceRecordStore : public ExtentRecordStore {
+    public:
+        NamespaceRecordStore( const char* ns, NamespaceDetails* d ) {
+            init( ns, d, &cc().database()->getExtentManager(),
+                  nsToCollectionSubstring( ns ) == "system.indexes" );
+        }
+    };
+
     /* drop a collection/namespace */
     void dropNS(const string& nsToDrop) {
         NamespaceDetails* d = nsdetails(nsToDrop);
@@ -523,52 +536,8 @@ namespace mongo {
        caller must check if capped
     */
     void DataFileMgr::_deleteRecord(NamespaceDetails *d, const char *ns, Record *todelete, const DiskLoc& dl) {
-        /* remove ourself from the record next/prev chain */
-        {
-            if ( todelete->prevOfs() != DiskLoc::NullOfs )
-                getDur().writingInt( todelete->getPrev(dl).rec()->nextOfs() ) = todelete->nextOfs();
-            if ( todelete->nextOfs() != DiskLoc::NullOfs )
-                getDur().writingInt( todelete->getNext(dl).rec()->prevOfs() ) = todelete->prevOfs();
-        }
-
-        /* remove ourself from extent pointers */
-        {
-            Extent *e = getDur().writing( todelete->myExtent(dl) );
-            if ( e->firstRecord == dl ) {
-                if ( todelete->nextOfs() == DiskLoc::NullOfs )
-                    e->firstRecord.Null();
-                else
-                    e->firstRecord.set(dl.a(), todelete->nextOfs() );
-            }
-            if ( e->lastRecord == dl ) {
-                if ( todelete->prevOfs() == DiskLoc::NullOfs )
-                    e->lastRecord.Null();
-                else
-                    e->lastRecord.set(dl.a(), todelete->prevOfs() );
-            }
-        }
-
-        /* add to the free list */
-        {
-            d->incrementStats( -1 * todelete->netLength(), -1 );
-
-            if ( nsToCollectionSubstring(ns) == "system.indexes") {
-                /* temp: if in system.indexes, don't reuse, and zero out: we want to be
-                   careful until validated more, as IndexDetails has pointers
-                   to this disk location.  so an incorrectly done remove would cause
-                   a lot of problems.
-                */
-                memset(getDur().writingPtr(todelete, todelete->lengthWithHeaders() ), 0, todelete->lengthWithHeaders() );
-            }
-            else {
-                DEV {
-                    unsigned long long *p = reinterpret_cast<unsigned long long *>( todelete->data() );
-                    *getDur().writing(p) = 0;
-                    //DEV memset(todelete->data, 0, todelete->netLength()); // attempt to notice invalid reuse.
-                }
-                d->addDeletedRec((DeletedRecord*)todelete, dl);
-            }
-        }
+        dassert( todelete == dl.rec() );
+        NamespaceRecordStore( ns, d ).deleteRecord( dl );
     }
 
     void DataFileMgr::deleteRecord(const char *ns, Record *todelete, const DiskLoc& dl, bool cappedOK, bool noWarn, bool doLog ) {
@@ -615,7 +584,7 @@ namespace mongo {
         NamespaceDetails *d,
         NamespaceDetailsTransient *nsdt,
         Record *toupdate, const DiskLoc& dl,
-        const char *_buf, int _len, OpDebug& debug,  bool god) {
+        const char *_buf, int _len, OpDebug& debug,  bool god, bool indexesAffected) {
 
         dassert( toupdate == dl.rec() );
 
@@ -649,9 +618,12 @@ namespace mongo {
         /* duplicate key check. we descend the btree twice - once for this check, and once for the actual inserts, further
            below.  that is suboptimal, but it's pretty complicated to do it the other way without rollbacks...
         */
+        // A moving document needs tickets even if no indexed field changed, so that its keys
+        // can be repointed at the new record.
+        const bool moving = toupdate->netLength() < objNew.objsize();
         OwnedPointerVector<UpdateTicket> updateTickets;
         updateTickets.mutableVector().resize(d->getTotalIndexCount());
-        for (int i = 0; i < d->getTotalIndexCount(); ++i) {
+        for (int i = 0; (indexesAffected || moving) && i < d->getTotalIndexCount(); ++i) {
             auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(d, i));
             auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(descriptor.get()));
             InsertDeleteOptions options;
@@ -668,13 +640,14 @@ namespace mongo {
             }
         }
 
-        if ( toupdate->netLength() < objNew.objsize() ) {
+        if ( moving ) {
             // doesn't fit.  reallocate -----------------------------------------------------
             moveCounter.increment();
             uassert( 10003 , "failing update: objects in a capped ns cannot grow", !(d && d->isCapped()));
             d->paddingTooSmall();
-            deleteRecord(ns, toupdate, dl);
-            DiskLoc res = insert(ns, objNew.objdata(), objNew.objsize(), false, god);
+            nsdt->sizePaddingTooSmall( objOld.objsize(), objNew.objsize() );
+            DiskLoc res = _moveRecord(ns, d, nsdt, toupdate, dl, objNew, updateTickets.vector(),
+                                      debug, god);
 
             if (debug.nmoved == -1) // default of -1 rather than 0
                 debug.nmoved = 1;
@@ -686,10 +659,11 @@ namespace mongo {
 
         nsdt->notifyOfWriteOp();
         d->paddingFits();
+        nsdt->sizePaddingFits( objOld.objsize() );
 
         debug.keyUpdates = 0;
 
-        for (int i = 0; i < d->getTotalIndexCount(); ++i) {
+        for (int i = 0; indexesAffected && i < d->getTotalIndexCount(); ++i) {
             auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(d, i));
             auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(descriptor.get()));
             int64_t updatedKeys;
@@ -702,8 +676,10 @@ namespace mongo {
         }
 
         //  update in place
-        int sz = objNew.objsize();
-        memcpy(getDur().writingPtr(toupdate->data(), sz), objNew.objdata(), sz);
+        StatusWith<DiskLoc> status =
+            NamespaceRecordStore( ns, d ).updateRecord( dl, objNew.objdata(), objNew.objsize(),
+                                                        !god );
+        verify( status.isOK() && status.getValue() == dl );
         return dl;
     }
 
@@ -758,6 +734,79 @@ namespace mongo {
     };
 #pragma pack()
 
+    /** writes the document being inserted, adding the _id when we generated one */
+    class InsertDocWriter : public DocWriter {
+    public:
+        InsertDocWriter( const void* obuf, int len, const IDToInsert& idToInsert ) :
+            _obuf( static_cast<const char*>( obuf ) ), _len( len ), _idToInsert( idToInsert ) {}
+
+        virtual void writeDocument( char* buf ) const {
+            if( _idToInsert.needed() ) {
+                /* a little effort was made here to avoid a double copy when we add an ID */
+                int originalSize = *((int*) _obuf);
+                ((int&)*buf) = originalSize + _idToInsert.size();
+                memcpy(buf+4, _idToInsert.rawdata(), _idToInsert.size());
+                memcpy(buf+4+_idToInsert.size(), _obuf+4, originalSize-4);
+            }
+            else {
+                if( _obuf ) // obuf can be null from internal callers
+                    memcpy(buf, _obuf, _len);
+            }
+        }
+
+        virtual size_t documentSize() const { return _len; }
+
+    private:
+        const char* _obuf;
+        int _len;
+        const IDToInsert& _idToInsert;
+    };
+
+    DiskLoc DataFileMgr::_moveRecord(const char* ns,
+                                     NamespaceDetails* d,
+                                     NamespaceDetailsTransient* nsdt,
+                                     Record* toupdate,
+                                     const DiskLoc& dl,
+                                     const BSONObj& objNew,
+                                     const vector<UpdateTicket*>& tickets,
+                                     OpDebug& debug,
+                                     bool god) {
+        /* check if any cursors point to us.  if so, advance them. */
+        ClientCursor::aboutToDelete(ns, d, dl);
+
+        if ( !god ) {
+            BSONElementManipulator::lookForTimestamps( objNew );
+        }
+
+        _deleteRecord(d, ns, toupdate, dl);
+
+        // objNew always carries the _id of the old document, so none is generated here.
+        IDToInsert noId;
+        InsertDocWriter docWriter( objNew.objdata(), objNew.objsize(), noId );
+        StatusWith<DiskLoc> status = NamespaceRecordStore( ns, d ).insertRecord( &docWriter, !god );
+        massert( 17300, "couldn't allocate space for moved record", status.isOK() );
+        DiskLoc newLoc = status.getValue();
+
+        debug.keyUpdates = 0;
+
+        for (int i = 0; i < d->getTotalIndexCount(); ++i) {
+            auto_ptr<IndexDescriptor> descriptor(CatalogHack::getDescriptor(d, i));
+            auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(descriptor.get()));
+            int64_t updatedKeys;
+            Status ret = iam->updateAndMove(*tickets[i], newLoc, &updatedKeys);
+            if (Status::OK() != ret) {
+                // This shouldn't happen unless something disastrous occurred.
+                massert(17301, "update failed: " + ret.toString(), false);
+            }
+            debug.keyUpdates += updatedKeys;
+        }
+
+        nsdt->notifyOfWriteOp();
+        d->paddingFits();
+
+        return newLoc;
+    }
+
     void DataFileMgr::insertAndLog( const char *ns, const BSONObj &o, bool god, bool fromMigrate ) {
         BSONObj tmp = o;
         insertWithObjMod( ns, tmp, false, god );
@@ -914,6 +963,16 @@ namespace mongo {
             cc().curop()->setQuery(info);
         }
 
+        IndexBuildBatch* batch = IndexBuildBatch::current();
+        if ( batch ) {
+            if ( batch->defer( tabletoidxns, loc, mayInterrupt ) ) {
+                return;
+            }
+            // an index which can't wait is built after the ones already waiting
+            batch->finish();
+            tableToIndex = nsdetails( tabletoidxns );
+        }
+
         try {
             IndexDetails& idx = tableToIndex->getNextIndexDetails(tabletoidxns.c_str());
             NamespaceDetails::IndexBuildBlock indexBuildBlock( tabletoidxns, idxName );
@@ -1088,9 +1147,6 @@ namespace mongo {
             BSONElementManipulator::lookForTimestamps( io );
         }
 
-        int lenWHdr = d->getRecordAllocationSize( len + Record::HeaderSize );
-        fassert( 16440, lenWHdr >= ( len + Record::HeaderSize ) );
-
         // If the collection is capped, check if the new object will violate a unique index
         // constraint before allocating space.
         if (d->getCompletedIndexCount() &&
@@ -1099,39 +1155,23 @@ namespace mongo {
             checkNoIndexConflicts( d, BSONObj( reinterpret_cast<const char *>( obuf ) ) );
         }
 
-        DiskLoc loc = allocateSpaceForANewRecord(ns, d, lenWHdr, god);
-
-        if ( loc.isNull() ) {
+        InsertDocWriter docWriter( obuf, len, idToInsert );
+        StatusWith<DiskLoc> status = NamespaceRecordStore( ns, d ).insertRecord( &docWriter, !god );
+        if ( !status.isOK() ) {
             log() << "insert: couldn't alloc space for object ns:" << ns
                   << " capped:" << d->isCapped() << endl;
             verify(d->isCapped());
             return DiskLoc();
         }
 
+        DiskLoc loc = status.getValue();
         Record *r = loc.rec();
-        {
-            verify( r->lengthWithHeaders() >= lenWHdr );
-            r = (Record*) getDur().writingPtr(r, lenWHdr);
-            if( idToInsert.needed() ) {
-                /* a little effort was made here to avoid a double copy when we add an ID */
-                int originalSize = *((int*) obuf);
-                ((int&)*r->data()) = originalSize + idToInsert.size();
-                memcpy(r->data()+4, idToInsert.rawdata(), idToInsert.size());
-                memcpy(r->data()+4+idToInsert.size(), ((char*)obuf)+4, originalSize-4);
-            }
-            else {
-                if( obuf ) // obuf can be null from internal callers
-                    memcpy(r->data(), obuf, len);
-            }
-        }
-
-        addRecordToRecListInExtent(r, loc);
-
-        d->incrementStats( r->netLength(), 1 );
 
         // we don't bother resetting query optimizer stats for the god tables - also god is true when adding a btree bucket
         if ( !god )
             NamespaceDetailsTransient::get( ns ).notifyOfWriteOp();
+        else if ( NamespaceString::normal( ns ) )
+            NamespaceDetailsTransient::get( ns ).documentsChanged();
 
         if ( tableToIndex ) {
             insert_makeIndex(tableToIndex, tabletoidxns, loc, mayInterrupt);
@@ -61,6 +61,7 @@ namespace mongo {
     class Extent;
     class OpDebug;
     class Record;
+    class UpdateTicket;
     struct SortPhaseOne;
 
     void dropDatabase(const std::string& db);
@@ -85,12 +86,15 @@ namespace mongo {
 
         /** @return DiskLoc where item ends up */
         // changedId should be initialized to false
+        // indexesAffected may be false only if the caller knows no indexed field changed; then
+        // index keys are left alone unless the record has to move.
         const DiskLoc updateRecord(
             const char *ns,
             NamespaceDetails *d,
             NamespaceDetailsTransient *nsdt,
             Record *toupdate, const DiskLoc& dl,
-            const char *buf, int len, OpDebug& debug, bool god=false);
+            const char *buf, int len, OpDebug& debug, bool god=false,
+            bool indexesAffected=true);
 
         // The object o may be updated if modified on insert.
         void insertAndLog( const char *ns, const BSONObj &o, bool god = false, bool fromMigrate = false );
@@ -157,6 +161,20 @@ namespace mongo {
         mongo::mutex _precalcedMutex;
 
     private:
+        /**
+         * Moves the document at 'dl' to a new record holding 'objNew', carrying its index entries
+         * along with the already validated 'tickets' rather than unindexing and reindexing it.
+         */
+        DiskLoc _moveRecord(const char* ns,
+                            NamespaceDetails* d,
+                            NamespaceDetailsTransient* nsdt,
+                            Record* toupdate,
+                            const DiskLoc& dl,
+                            const BSONObj& objNew,
+                            const vector<UpdateTicket*>& tickets,
+                            OpDebug& debug,
+                            bool god);
+
         vector<DataFile *> files;
         SortPhaseOne* _precalced;
     };
@@ -30,10 +30,31 @@
 
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/platform/float_utils.h"
 
 namespace mongo {
 
     void AccumulatorMinMax::processInternal(const Value& input, bool merging) {
+        // Fast path for a stream of ints or doubles: no generic compare, and the size is fixed.
+        // NaN sorts below every number, so it takes the generic path.
+        const BSONType type = input.getType();
+        if (type == _val.getType()) {
+            if (type == NumberInt) {
+                const int cmp = (_val.getInt() > input.getInt()) - (_val.getInt() < input.getInt());
+                if (cmp * _sense > 0)
+                    _val = input;
+                return;
+            }
+            if (type == NumberDouble && !isNaN(input.getDouble()) && !isNaN(_val.getDouble())) {
+                const double current = _val.getDouble();
+                const double candidate = input.getDouble();
+                const int cmp = (current > candidate) - (current < candidate);
+                if (cmp * _sense > 0)
+                    _val = input;
+                return;
+            }
+        }
+
         // nullish values should have no impact on result
         if (!input.nullish()) {
             /* compare with the current value; swap if appropriate */
@@ -34,25 +34,29 @@
 namespace mongo {
 
     void AccumulatorSum::processInternal(const Value& input, bool merging) {
-        // do nothing with non numeric types
-        if (!input.numeric())
-            return;
-
-        // upgrade to the widest type required to hold the result
-        totalType = Value::getWidestNumeric(totalType, input.getType());
+        // Switch on the input's own type rather than coercing, since this runs once per
+        // document and the inputs of a $sum are nearly always all ints or all doubles.
+        switch (input.getType()) {
+        case NumberDouble:
+            totalType = NumberDouble;
+            doubleTotal += input.getDouble();
+            break;
 
-        if (totalType == NumberInt || totalType == NumberLong) {
-            long long v = input.coerceToLong();
+        case NumberLong:
+            if (totalType == NumberInt)
+                totalType = NumberLong;
+            // fall through
+        case NumberInt: {
+            // keep doubleTotal too, in case a double arrives later
+            const long long v = input.getLong();
             longTotal += v;
             doubleTotal += v;
+            break;
         }
-        else if (totalType == NumberDouble) {
-            double v = input.coerceToDouble();
-            doubleTotal += v;
-        }
-        else {
-            // non numerics should have returned above so we should never get here
-            verify(false);
+
+        default:
+            // do nothing with non numeric types
+            return;
         }
 
         count++;
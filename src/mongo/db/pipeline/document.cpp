@@ -40,10 +40,21 @@ namespace mongo {
     using namespace mongoutils;
 
     Position DocumentStorage::findField(StringData requested) const {
+        // the replaced field of an overlay keeps its name
+        const DocumentStorage& doc = MONGO_unlikely(isOverlay()) ? *_base : *this;
+
+        // small documents are scanned, so only hash for the ones with a hash table
+        return doc.findField(requested, doc._numFields >= HASH_TAB_MIN ? hashKey(requested) : 0);
+    }
+
+    Position DocumentStorage::findField(StringData requested, unsigned requestedHash) const {
+        if (MONGO_unlikely(isOverlay()))
+            return _base->findField(requested, requestedHash);
+
         int reqSize = requested.size(); // get size calculation out of the way if needed
 
         if (_numFields >= HASH_TAB_MIN) { // hash lookup
-            const unsigned bucket = bucketForKey(requested);
+            const unsigned bucket = requestedHash & _hashTabMask;
 
             Position pos = _hashTab[bucket];
             while (pos.found()) {
@@ -58,7 +69,7 @@ namespace mongo {
             }
         }
         else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            for (DocumentStorageIterator it = iteratorConverted(); !it.atEnd(); it.advance()) {
                 if (it->nameLen == reqSize
                     && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                     return it.position();
@@ -66,11 +77,53 @@ namespace mongo {
             }
         }
 
-        // if we got here, there's no such field
+        // if we got here, there's no such field unless it hasn't been converted yet
+        if (MONGO_unlikely(hasLazyFields()))
+            return loadLazyFieldsUntil(requested);
+
+        return Position();
+    }
+
+    void DocumentStorage::setLazyFields(const BSONObj& bson) {
+        fassert(17199, !_buffer && !hasLazyFields());
+        dassert(bson.isOwned());
+
+        if (bson.isEmpty())
+            return;
+
+        _bson = bson;
+        _bsonPos = sizeof(int); // skip the BSONObj's size
+    }
+
+    Position DocumentStorage::loadNextLazyField() const {
+        dassert(hasLazyFields());
+        DocumentStorage& self = const_cast<DocumentStorage&>(*this);
+
+        const BSONElement elem(_bson.objdata() + _bsonPos);
+        const Position pos = getNextPosition();
+        self.appendFieldNoLoad(elem.fieldNameStringData()) = Value(elem);
+        self._bsonPos += elem.size();
+
+        if (BSONElement(_bson.objdata() + _bsonPos).eoo()) {
+            // Values don't point into the BSON they came from, so we can let it go
+            self._bson = BSONObj();
+            self._bsonPos = 0;
+        }
+
+        return pos;
+    }
+
+    Position DocumentStorage::loadLazyFieldsUntil(StringData name) const {
+        while (hasLazyFields()) {
+            const Position pos = loadNextLazyField();
+            if (getField(pos).nameSD() == name)
+                return pos;
+        }
+
         return Position();
     }
 
-    Value& DocumentStorage::appendField(StringData name) {
+    Value& DocumentStorage::appendFieldNoLoad(StringData name) {
         Position pos = getNextPosition();
         const int nameSize = name.size();
 
@@ -181,7 +234,32 @@ namespace mongo {
         _bufferEnd = _buffer + newSize;
     }
 
+    intrusive_ptr<DocumentStorage> DocumentStorage::overlay(
+            const intrusive_ptr<const DocumentStorage>& base, Position pos, const Value& val) {
+        // overlays aren't stacked: replacing the same field again just replaces it in the
+        // original, and replacing another flattens first so there is only ever one level
+        intrusive_ptr<const DocumentStorage> under = base;
+        if (base->isOverlay()) {
+            if (pos == base->_overridePos)
+                under = base->_base;
+            else
+                under = base->clone();
+        }
+
+        intrusive_ptr<DocumentStorage> out (new DocumentStorage());
+        out->appendFieldNoLoad(under->getField(pos).nameSD()) = val;
+        out->_base = under;
+        out->_overridePos = pos;
+        return out;
+    }
+
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
+        if (isOverlay()) {
+            intrusive_ptr<DocumentStorage> out = _base->clone();
+            out->getField(_overridePos).val = _firstElement->val;
+            return out;
+        }
+
         intrusive_ptr<DocumentStorage> out (new DocumentStorage());
 
         // Make a copy of the buffer.
@@ -195,9 +273,13 @@ namespace mongo {
         out->_usedBytes = _usedBytes;
         out->_numFields = _numFields;
         out->_hashTabMask = _hashTabMask;
+        if (hasLazyFields()) {
+            out->_bson = _bson;
+            out->_bsonPos = _bsonPos;
+        }
 
         // Tell values that they have been memcpyed (updates ref counts)
-        for (DocumentStorageIterator it = out->iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = out->iteratorConverted(); !it.atEnd(); it.advance()) {
             it->val.memcpyed();
         }
 
@@ -207,7 +289,7 @@ namespace mongo {
     DocumentStorage::~DocumentStorage() {
         boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
 
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = iteratorConverted(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
         }
     }
@@ -224,6 +306,35 @@ namespace mongo {
         *this = md.freeze();
     }
 
+    Document Document::fromBsonLazily(const BSONObj& bson) {
+        intrusive_ptr<DocumentStorage> storage(new DocumentStorage());
+        storage->setLazyFields(bson.getOwned());
+        return Document(storage.get());
+    }
+
+    Document Document::withField(Position pos, const Value& val) const {
+        verify(_storage);
+        return Document(DocumentStorage::overlay(_storage, pos, val).get());
+    }
+
+    static Document withNestedFieldHelper(const Document& doc,
+                                          const vector<Position>& positions,
+                                          size_t level,
+                                          const Value& val) {
+        if (level == positions.size() - 1)
+            return doc.withField(positions[level], val);
+
+        const Document nested = doc.getField(positions[level]).getDocument();
+        return doc.withField(positions[level],
+                             Value(withNestedFieldHelper(nested, positions, level + 1, val)));
+    }
+
+    Document Document::withNestedField(const vector<Position>& positions,
+                                       const Value& val) const {
+        fassert(17326, !positions.empty());
+        return withNestedFieldHelper(*this, positions, 0, val);
+    }
+
     BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& doc) {
         BSONObjBuilder subobj(builder.subobjStart());
         doc.toBson(&subobj);
@@ -320,9 +431,15 @@ namespace mongo {
             return 0; // we've allocated no memory
 
         size_t size = sizeof(DocumentStorage);
+        if (const DocumentStorage* base = storage().overlayBase()) {
+            // counted as if not shared, the same as the copies overlays stand in for
+            size += Document(base).getApproximateSize();
+        }
         size += storage().allocatedBytes();
+        size += storage().lazyFieldsBytes(); // don't convert them just to measure them
 
-        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = storage().iteratorConverted(); !it.atEnd();
+                it.advance()) {
             size += it->val.getApproximateSize();
             size -= sizeof(Value); // already accounted for above
         }
@@ -71,12 +71,30 @@ namespace mongo {
         /// Create a new Document deep-converted from the given BSONObj.
         explicit Document(const BSONObj& bson);
 
+        /** Create a new Document that converts the fields of the given BSONObj as they are used.
+         *
+         *  Looking up a field by name converts the fields before it that haven't been yet. Anything
+         *  that goes through all the fields (iterating, comparing, serializing or modifying the
+         *  Document) converts the rest. A field holding an object is converted deeply, just like
+         *  with the constructor above. This keeps an owned copy of bson until all fields are
+         *  converted, and must not be read from two threads at once until then.
+         */
+        static Document fromBsonLazily(const BSONObj& bson);
+
         void swap(Document& rhs) { _storage.swap(rhs._storage); }
 
         /// Look up a field by key name. Returns Value() if no such field. O(1)
         const Value operator[] (StringData key) const { return getField(key); }
         const Value getField(StringData key) const { return storage().getField(key); }
 
+        /** Like getField(key), with 'keyHash' from hashFieldName(key). Looking up the same name
+         *  in many documents this way (as field path expressions do) only hashes it once.
+         */
+        const Value getField(StringData key, unsigned keyHash) const {
+            return storage().getField(key, keyHash);
+        }
+        static unsigned hashFieldName(StringData key) { return DocumentStorage::hashKey(key); }
+
         /// Look up a field by Position. See positionOf and getNestedField.
         const Value operator[] (Position pos) const { return getField(pos); }
         const Value getField(Position pos) const { return storage().getField(pos).val; }
@@ -94,7 +112,10 @@ namespace mongo {
         size_t size() const { return storage().size(); }
 
         /// True if this document has no fields.
-        bool empty() const { return !_storage || storage().iterator().atEnd(); }
+        bool empty() const {
+            return !_storage
+                || (!storage().hasLazyFields() && storage().iterator().atEnd());
+        }
 
         /// Create a new FieldIterator that can be used to examine the Document's fields in order.
         FieldIterator fieldIterator() const;
@@ -155,6 +176,17 @@ namespace mongo {
          */
         Document clone() const { return Document(storage().clone().get()); }
 
+        /** A copy of this document with the field at 'pos' (from positionOf()) set to 'val'.
+         *
+         *  Rather than copying the other fields, the new document shares them with this one
+         *  until a MutableDocument changes it, which is what makes $unwind cheap on wide
+         *  documents.
+         */
+        Document withField(Position pos, const Value& val) const;
+
+        /// Like withField() for a field nested in subdocuments, by getNestedField() positions
+        Document withNestedField(const vector<Position>& positions, const Value& val) const;
+
         /// members for Sorter
         struct SorterDeserializeSettings {}; // unused
         void serializeForSorter(BufBuilder& buf) const;
@@ -388,7 +420,8 @@ namespace mongo {
             if (MONGO_unlikely( !_storage ))
                 return newStorage();
 
-            if (MONGO_unlikely( _storage->isShared() ))
+            // an overlay can't be changed in place, see DocumentStorage::overlay()
+            if (MONGO_unlikely( _storage->isShared() || storagePtr()->isOverlay() ))
                 return clonedStorage();
 
             // This function exists to ensure this is safe
@@ -114,12 +114,17 @@ namespace mongo {
     class DocumentStorageIterator {
     public:
         // DocumentStorage::iterator() and iteratorAll() are easier to use
+        // 'replaced', if not NULL, is shown as 'replacement' (see DocumentStorage::overlay())
         DocumentStorageIterator(const ValueElement* first,
                                 const ValueElement* end,
-                                bool includeMissing)
+                                bool includeMissing,
+                                const ValueElement* replaced = NULL,
+                                const ValueElement* replacement = NULL)
                 : _first(first)
                 , _it(first)
                 , _end(end)
+                , _replaced(replaced)
+                , _replacement(replacement)
                 , _includeMissing(includeMissing) {
             if (!_includeMissing)
                 skipMissing();
@@ -127,7 +132,9 @@ namespace mongo {
 
         bool atEnd() const { return _it == _end; }
 
-        const ValueElement& get() const { return *_it; }
+        const ValueElement& get() const {
+            return MONGO_unlikely(_it == _replaced) ? *_replacement : *_it;
+        }
 
         Position position() const { return Position(_it->ptr() - _first->ptr()); }
 
@@ -137,8 +144,8 @@ namespace mongo {
                 skipMissing();
         }
 
-        const ValueElement* operator-> () { return _it; }
-        const ValueElement& operator* () { return *_it; }
+        const ValueElement* operator-> () { return &get(); }
+        const ValueElement& operator* () { return get(); }
 
     private:
         void advanceOne() {
@@ -146,7 +153,7 @@ namespace mongo {
         }
 
         void skipMissing() {
-            while (!atEnd() && _it->val.missing()) {
+            while (!atEnd() && get().val.missing()) {
                 advanceOne();
             }
         }
@@ -154,6 +161,8 @@ namespace mongo {
         const ValueElement* _first;
         const ValueElement* _it;
         const ValueElement* _end;
+        const ValueElement* _replaced;
+        const ValueElement* _replacement;
         bool _includeMissing;
     };
 
@@ -166,6 +175,7 @@ namespace mongo {
                           , _usedBytes(0)
                           , _numFields(0)
                           , _hashTabMask(0)
+                          , _bsonPos(0)
         {}
         ~DocumentStorage();
 
@@ -176,6 +186,7 @@ namespace mongo {
 
         size_t size() const {
             // can't use _numFields because it includes removed Fields
+            // (iterator() converts any lazy fields first)
             size_t count = 0;
             for (DocumentStorageIterator it = iterator(); !it.atEnd(); it.advance())
                 count++;
@@ -188,9 +199,21 @@ namespace mongo {
         /// Returns the position of the named field (may be missing) or Position()
         Position findField(StringData name) const;
 
+        /// Like findField(name) with 'nameHash' from hashKey(name), for callers that cache it
+        Position findField(StringData name, unsigned nameHash) const;
+
+        static unsigned hashKey(StringData name) {
+            // TODO consider FNV-1a once we have a better benchmark corpus
+            unsigned out;
+            MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
+            return out;
+        }
+
         // Document uses these
         const ValueElement& getField(Position pos) const {
             verify(pos.found());
+            if (MONGO_unlikely(isOverlay()))
+                return pos == _overridePos ? *_firstElement : _base->getField(pos);
             return *(_firstElement->plusBytes(pos.index));
         }
         Value getField(StringData name) const {
@@ -199,6 +222,12 @@ namespace mongo {
                 return Value();
             return getField(pos).val;
         }
+        Value getField(StringData name, unsigned nameHash) const {
+            Position pos = findField(name, nameHash);
+            if (!pos.found())
+                return Value();
+            return getField(pos).val;
+        }
 
         // MutableDocument uses these
         ValueElement& getField(Position pos) {
@@ -213,24 +242,70 @@ namespace mongo {
         }
 
         /// Adds a new field with missing Value at the end of the document
-        Value& appendField(StringData name);
+        Value& appendField(StringData name) {
+            loadAllLazyFields(); // new fields go after the ones still in _bson
+            return appendFieldNoLoad(name);
+        }
 
         /** Preallocates space for fields. Use this to attempt to prevent buffer growth.
          *  This is only valid to call before anything is added to the document.
          */
         void reserveFields(size_t expectedFields);
 
+        /** Backs this document with the fields of 'bson', which must be owned, without converting
+         *  them. findField() converts them in order until it reaches the one asked for, and
+         *  iterating or adding fields converts all the rest first.
+         *  This is only valid to call before anything is added to the document.
+         */
+        void setLazyFields(const BSONObj& bson);
+
+        /** A document made of the fields of 'base', except that the one at 'pos' has the value
+         *  'val'. Only the replaced field is stored; the others stay shared with 'base', which
+         *  is kept alive. Positions are those of 'base'.
+         *  Only Document may read an overlay; MutableDocument flattens it with clone() first.
+         */
+        static intrusive_ptr<DocumentStorage> overlay(
+                const intrusive_ptr<const DocumentStorage>& base, Position pos, const Value& val);
+
+        bool isOverlay() const { return _base.get() != NULL; }
+
+        /// True if some fields are still only in the BSONObj passed to setLazyFields()
+        bool hasLazyFields() const { return _bsonPos != 0; }
+
+        /// Bytes of the BSONObj passed to setLazyFields() that haven't been converted yet
+        size_t lazyFieldsBytes() const {
+            return hasLazyFields() ? _bson.objsize() - _bsonPos : 0;
+        }
+
         /// This skips missing values
         DocumentStorageIterator iterator() const {
+            if (MONGO_unlikely(isOverlay()))
+                return overlayIterator(false);
+            loadAllLazyFields();
             return DocumentStorageIterator(_firstElement, end(), false);
         }
 
         /// This includes missing values
         DocumentStorageIterator iteratorAll() const {
+            if (MONGO_unlikely(isOverlay()))
+                return overlayIterator(true);
+            loadAllLazyFields();
+            return iteratorConverted();
+        }
+
+        /** Like iteratorAll() but leaves lazy fields alone, so it only sees converted ones.
+         *  For an overlay this is just the replaced field.
+         */
+        DocumentStorageIterator iteratorConverted() const {
             return DocumentStorageIterator(_firstElement, end(), true);
         }
 
-        /// Shallow copy of this. Caller owns memory.
+        /// The storage an overlay shares its other fields with, or NULL
+        const DocumentStorage* overlayBase() const { return _base.get(); }
+
+        /** Shallow copy of this. Caller owns memory.
+         *  The copy of an overlay is a plain document with the same fields and positions.
+         */
         intrusive_ptr<DocumentStorage> clone() const;
 
         size_t allocatedBytes() const {
@@ -242,9 +317,34 @@ namespace mongo {
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
+        /// The fields of _base with the one at _overridePos shown as ours
+        DocumentStorageIterator overlayIterator(bool includeMissing) const {
+            _base->loadAllLazyFields();
+            return DocumentStorageIterator(_base->_firstElement, _base->end(), includeMissing,
+                                           &_base->getField(_overridePos), _firstElement);
+        }
+
         /// Allocates space in _buffer. Copies existing data if there is any.
         void alloc(unsigned newSize);
 
+        /// appendField() without converting lazy fields first
+        Value& appendFieldNoLoad(StringData name);
+
+        /** Converts the next lazy field and returns its position.
+         *  Lazy fields are what the document holds from the start, even if they haven't been
+         *  converted yet, so this is allowed through a const DocumentStorage. This means that
+         *  a Document with lazy fields must not be read from two threads at once.
+         */
+        Position loadNextLazyField() const;
+
+        /// Converts lazy fields until one is named 'name'. Returns its position or Position().
+        Position loadLazyFieldsUntil(StringData name) const;
+
+        void loadAllLazyFields() const {
+            while (MONGO_unlikely(hasLazyFields()))
+                loadNextLazyField();
+        }
+
         /// Call after adding field to _buffer and increasing _numFields
         void addFieldToHashTable(Position pos);
 
@@ -258,13 +358,6 @@ namespace mongo {
         /// Initialize empty hash table
         void hashTabInit() { memset(_hashTab, -1, hashTabBytes()); }
 
-        static unsigned hashKey(StringData name) {
-            // TODO consider FNV-1a once we have a better benchmark corpus
-            unsigned out;
-            MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
-            return out;
-        }
-
         unsigned bucketForKey(StringData name) const {
             return hashKey(name) & _hashTabMask;
         }
@@ -272,7 +365,7 @@ namespace mongo {
         /// Adds all fields to the hash table
         void rehash() {
             hashTabInit();
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+            for (DocumentStorageIterator it = iteratorConverted(); !it.atEnd(); it.advance())
                 addFieldToHashTable(it.position());
         }
 
@@ -305,6 +398,17 @@ namespace mongo {
         unsigned _usedBytes; // position where next field would start
         unsigned _numFields; // this includes removed fields
         unsigned _hashTabMask; // equal to hashTabBuckets()-1 but used more often
+
+        // Fields not converted yet start at offset _bsonPos of _bson. _bsonPos is 0 (and _bson
+        // released) once there are none left. _bson is only valid while _bsonPos is non-zero,
+        // since emptyDoc() doesn't run its constructor.
+        BSONObj _bson;
+        unsigned _bsonPos;
+
+        // Set for an overlay, see overlay(). Its own buffer then only holds the field replacing
+        // the one at _overridePos of _base.
+        intrusive_ptr<const DocumentStorage> _base;
+        Position _overridePos;
         // When adding a field, make sure to update clone() method
     };
 }
@@ -253,6 +253,19 @@ namespace mongo {
      */
     class DocumentSourceNeedsMongod {
     public:
+        // The results of a geoNear, produced a batch at a time.
+        class GeoNearCursor {
+        public:
+            virtual ~GeoNearCursor() {};
+
+            /**
+             * Appends up to 'maxResults' more results to 'out', each owned and in the form of an
+             * element of the geoNear command's "results" array.  Appends nothing once there are
+             * no more.
+             */
+            virtual void nextBatch(long long maxResults, vector<BSONObj>* out) = 0;
+        };
+
         // Wraps mongod-specific functions to allow linking into mongos.
         class MongodInterface {
         public:
@@ -267,6 +280,13 @@ namespace mongo {
 
             virtual bool isCapped(const NamespaceString& ns) = 0;
 
+            /**
+             * Returns a cursor over the results of the geoNear command 'geoNearCmd' on 'ns', or
+             * NULL if the command has to be run in one go.  The caller owns the cursor.
+             */
+            virtual GeoNearCursor* openGeoNear(const NamespaceString& ns,
+                                               const BSONObj& geoNearCmd) = 0;
+
             // Add new methods as needed.
         };
 
@@ -532,6 +552,7 @@ namespace mongo {
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
         virtual void dispose();
         virtual Value serialize(bool explain = false) const;
+        virtual void optimize();
 
         /**
           Create a new grouping DocumentSource.
@@ -596,8 +617,12 @@ namespace mongo {
     private:
         DocumentSourceGroup(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
-        /// Spill groups map to disk and returns an iterator to the file.
-        shared_ptr<Sorter<Value, Value>::Iterator> spill();
+        typedef vector<intrusive_ptr<Accumulator> > Accumulators;
+        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
+        GroupsMap groups;
+
+        /// Spill 'groups' to disk and returns an iterator to the file. Leaves 'groups' empty.
+        shared_ptr<Sorter<Value, Value>::Iterator> spill(GroupsMap* groups);
 
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
@@ -611,11 +636,22 @@ namespace mongo {
         void populate();
         bool populated;
 
-        intrusive_ptr<Expression> pIdExpression;
+        /*
+          populate() for aggregationGroupThreads > 1.  The input is split
+          by the hash of its _id between 'numPartitions' worker threads,
+          each with its own groups map, so every group is accumulated by
+          exactly one thread.  The partitions share the memory limit, and
+          the largest one is spilled when they exceed it.
+         */
+        void populateParallel(size_t numPartitions);
 
-        typedef vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
-        GroupsMap groups;
+        /// Sets up the output once all input is in 'groups' or in 'sortedFiles'.
+        void finishPopulate(vector<shared_ptr<Sorter<Value, Value>::Iterator> >& sortedFiles);
+
+        // One worker of populateParallel(). Defined in document_source_group.cpp.
+        class Partition;
+
+        intrusive_ptr<Expression> pIdExpression;
 
         /*
           The field names for the result documents and the accumulator
@@ -633,6 +669,13 @@ namespace mongo {
         vector<intrusive_ptr<Accumulator> (*)()> vpAccumulatorFactory;
         vector<intrusive_ptr<Expression> > vpExpression;
 
+        /*
+          Sub-expressions repeated across pIdExpression and vpExpression,
+          found by optimize().  They are reset before each input document.
+         */
+        vector<intrusive_ptr<ExpressionCommonSubexpression> > _commonSubexpressions;
+        void resetCommonSubexpressions();
+
 
         Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
@@ -717,8 +760,19 @@ namespace mongo {
 
         static const char name[];
 
+        /** Opens the cursors and returns them, for a following $sort to merge them itself.
+         *  This must be called instead of getNext(). The cursors stay owned by this source.
+         */
+        vector<DBClientCursor*> getCursors();
+
+        /// Returns the next document from cursor, which must have one, or throws its error.
+        static Document nextSafeFrom(DBClientCursor* cursor);
+
     private:
 
+        /// Opens each cursor and waits for its first batch
+        void start();
+
         struct CursorAndConnection {
             CursorAndConnection(ConnectionString host, NamespaceString ns, CursorId id);
             ScopedDbConnection connection;
@@ -780,6 +834,9 @@ namespace mongo {
         // Sets _tempsNs and prepares it to receive data.
         void prepTempCollection();
 
+        // Builds the indexes of _outputNs on _tempNs. Called once all data is in _tempNs.
+        void copyIndexes();
+
         void spill(DBClientBase* conn, const vector<BSONObj>& toInsert);
 
         bool _done;
@@ -819,6 +876,11 @@ namespace mongo {
         /** projection as specified by the user */
         BSONObj getRaw() const { return _raw; }
 
+        /** @see ExpressionObject::getSourceField() */
+        string getSourceField(const string& fieldName) const {
+            return pEO->getSourceField(fieldName);
+        }
+
     private:
         DocumentSourceProject(const intrusive_ptr<ExpressionContext>& pExpCtx,
                               const intrusive_ptr<ExpressionObject>& exprObj);
@@ -827,6 +889,9 @@ namespace mongo {
         intrusive_ptr<ExpressionObject> pEO;
         BSONObj _raw;
 
+        // repeated sub-expressions of pEO, found by optimize(). Reset for each document.
+        vector<intrusive_ptr<ExpressionCommonSubexpression> > _commonSubexpressions;
+
 #if defined(_DEBUG)
         // this is used in DEBUG builds to ensure we are compatible
         Projection _simpleProjection;
@@ -872,8 +937,10 @@ namespace mongo {
         // All work for sort is done in router currently if there is no limit.
         // If there is a limit, the $sort/$limit combination is performed on the
         // shards, then the results are resorted and limited on mongos
-        virtual intrusive_ptr<DocumentSource> getShardSource() { return limitSrc ? this : NULL; }
-        virtual intrusive_ptr<DocumentSource> getRouterSource() { return this; }
+        // The shards sort their own results (and apply the limit, if any) and the router
+        // merges the sorted streams, applying the limit again.
+        virtual intrusive_ptr<DocumentSource> getShardSource() { return this; }
+        virtual intrusive_ptr<DocumentSource> getRouterSource();
 
         /**
           Add sort key field.
@@ -934,6 +1001,20 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /*
+          If true, each cursor of the $mergeCursors source before this one
+          returns documents already sorted by our key, so we only need to
+          merge them and can start returning documents right away.  It is
+          set on the router's half of a split $sort, and is serialized as
+          "$mergePresorted" so the merging shard sees it too.
+         */
+        bool _mergingPresorted;
+
+        /// Merges the already sorted cursors into _output
+        void populateFromCursors(const vector<DBClientCursor*>& cursors);
+
+        SortOptions makeSortOptions() const;
+
         /* these two parallel each other */
         typedef vector<intrusive_ptr<ExpressionFieldPath> > SortPaths;
         SortPaths vSortKey;
@@ -958,6 +1039,9 @@ namespace mongo {
             const DocumentSourceSort& _source;
         };
 
+        /// Feeds a presorted cursor to the merge in populateFromCursors()
+        class IteratorFromCursor;
+
         intrusive_ptr<DocumentSourceLimit> limitSrc;
 
         bool _done;
@@ -1101,6 +1185,9 @@ namespace mongo {
 
         static const char unwindName[];
 
+        /** The field being unwound. */
+        const FieldPath& getUnwindPath() const { return *_unwindPath; }
+
     private:
         DocumentSourceUnwind(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
@@ -1138,6 +1225,15 @@ namespace mongo {
 
         long long getLimit() { return limit; }
 
+        /**
+         * Takes over the work of 'match', which must directly follow this stage, if it doesn't
+         * look at the fields this stage adds.  The documents it drops still count towards the
+         * limit, as they would have before reaching it.  Returns false if it can't.
+         */
+        bool absorbMatch(const DocumentSourceMatch& match);
+
+        virtual void dispose();
+
         // this should only be used for testing
         static intrusive_ptr<DocumentSourceGeoNear> create(
             const intrusive_ptr<ExpressionContext> &pCtx);
@@ -1149,6 +1245,9 @@ namespace mongo {
         BSONObj buildGeoNearCmd() const;
         void runCommand();
 
+        /** Refills _batch from the near cursor, or from the command's results the first time. */
+        void loadBatch();
+
         // These fields describe the command to run.
         // coords and distanceField are required, rest are optional
         BSONObj coords; // "near" option, but near is a reserved keyword on windows
@@ -1162,9 +1261,17 @@ namespace mongo {
         scoped_ptr<FieldPath> includeLocs;
         bool uniqueDocs;
 
+        // A $match absorbed by absorbMatch(), applied to the documents we'd otherwise return.
+        BSONObj filterQuery;
+        boost::scoped_ptr<Matcher> filter;
+
         // these fields are used while processing the results
-        BSONObj cmdOutput;
-        boost::scoped_ptr<BSONObjIterator> resultsIterator; // iterator over cmdOutput["results"]
+        bool started;
+        BSONObj cmdOutput; // only when the command had to be run
+        boost::scoped_ptr<GeoNearCursor> nearCursor;
+        long long numFetched; // results taken from nearCursor so far
+        vector<BSONObj> batch;
+        size_t batchPos;
     };
 }
 
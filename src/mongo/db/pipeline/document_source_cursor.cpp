@@ -145,9 +145,11 @@ namespace mongo {
                     if ( !_collMetadata->keyBelongsToMe( kp.extractSingleKey( next ) ) ) continue;
                 }
 
+                // Without a projection we don't know which fields the pipeline will use, so
+                // only convert the ones it looks at.
                 _currentBatch.push_back(_projection
                                             ? documentFromBsonWithDeps(next, _dependencies)
-                                            : Document(next));
+                                            : Document::fromBsonLazily(next));
             }
 
             if (_limit) {
@@ -38,22 +38,63 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGeoNear::getNext() {
         pExpCtx->checkForInterrupt();
 
-        if (!resultsIterator)
-            runCommand();
-
-        if (!resultsIterator->more())
-            return boost::none;
-
-        // each result from the geoNear command is wrapped in a wrapper object with "obj",
-        // "dis" and maybe "loc" fields. We want to take the object from "obj" and inject the
-        // other fields into it.
-        Document result (resultsIterator->next().embeddedObject());
-        MutableDocument output (result["obj"].getDocument());
-        output.setNestedField(*distanceField, result["dis"]);
-        if (includeLocs)
-            output.setNestedField(*includeLocs, result["loc"]);
+        while (true) {
+            if (batchPos == batch.size()) {
+                loadBatch();
+                if (batch.empty())
+                    return boost::none;
+            }
+
+            // each result from the geoNear command is wrapped in a wrapper object with "obj",
+            // "dis" and maybe "loc" fields. We want to take the object from "obj" and inject the
+            // other fields into it.
+            const BSONObj& wrapper = batch[batchPos++];
+            BSONObj obj = wrapper["obj"].embeddedObject();
+            if (filter && !filter->matches(obj))
+                continue;
+
+            Document result (obj);
+            MutableDocument output (result);
+            output.setNestedField(*distanceField, Value(wrapper["dis"]));
+            if (includeLocs)
+                output.setNestedField(*includeLocs, Value(wrapper["loc"]));
+
+            return output.freeze();
+        }
+    }
+
+    void DocumentSourceGeoNear::loadBatch() {
+        batch.clear();
+        batchPos = 0;
+
+        if (!started) {
+            started = true;
+            nearCursor.reset(_mongod->openGeoNear(pExpCtx->ns, buildGeoNearCmd()));
+            if (!nearCursor) {
+                // the command holds all the results at once, so they are a single batch
+                runCommand();
+                BSONForEach(result, cmdOutput["results"].embeddedObject()) {
+                    batch.push_back(result.embeddedObject());
+                }
+                return;
+            }
+        }
 
-        return output.freeze();
+        if (!nearCursor)
+            return;
+
+        if (numFetched < limit)
+            nearCursor->nextBatch(limit - numFetched, &batch);
+        numFetched += batch.size();
+        if (batch.empty())
+            nearCursor.reset();
+    }
+
+    void DocumentSourceGeoNear::dispose() {
+        nearCursor.reset();
+        batch.clear();
+        batchPos = 0;
+        cmdOutput = BSONObj();
     }
 
     void DocumentSourceGeoNear::setSource(DocumentSource*) {
@@ -71,12 +112,13 @@ namespace mongo {
     }
 
     // This command is sent as-is to the shards.
-    // On router this becomes a sort by distance (nearest-first) with limit.
+    // On router this becomes a sort by distance (nearest-first) with limit. Each shard's results
+    // already come nearest-first, so the router only merges them.
     intrusive_ptr<DocumentSource> DocumentSourceGeoNear::getShardSource() { return this; }
     intrusive_ptr<DocumentSource> DocumentSourceGeoNear::getRouterSource() {
         return DocumentSourceSort::create(pExpCtx,
                                           BSON(distanceField->getPath(false) << 1),
-                                          limit);
+                                          limit)->getRouterSource();
     }
 
     Value DocumentSourceGeoNear::serialize(bool explain) const {
@@ -106,6 +148,10 @@ namespace mongo {
 
         result.setField("uniqueDocs", Value(uniqueDocs));
 
+        // not an option; only set on mongod, after the pipeline is split for sharding
+        if (explain && filter)
+            result.setField("filter", Value(filterQuery));
+
         return Value(DOC(getSourceName() << result.freeze()));
     }
 
@@ -143,15 +189,70 @@ namespace mongo {
 
     void DocumentSourceGeoNear::runCommand() {
         massert(16603, "Already ran geoNearCommand",
-                !resultsIterator);
+                cmdOutput.isEmpty());
 
         bool ok = _mongod->directClient()->runCommand(pExpCtx->ns.db().toString(),
                                                       buildGeoNearCmd(),
                                                       cmdOutput);
         uassert(16604, "geoNear command failed: " + cmdOutput.toString(),
                 ok);
+    }
+
+    namespace {
+        /* Do the dotted paths 'a' and 'b' name the same field, or one a parent of the other? */
+        bool pathsOverlap(const string& a, const string& b) {
+            const string& shorter = a.size() < b.size() ? a : b;
+            const string& longer = a.size() < b.size() ? b : a;
+            return str::startsWith(longer, shorter)
+                && (longer.size() == shorter.size() || longer[shorter.size()] == '.');
+        }
 
-        resultsIterator.reset(new BSONObjIterator(cmdOutput["results"].embeddedObject()));
+        /*
+          Does the query only look at fields other than 'added'?  Operators that don't name
+          fields, like $where, may look at anything.
+        */
+        bool queryAvoids(const BSONObj& query, const vector<string>& added) {
+            BSONForEach(predicate, query) {
+                const string field = predicate.fieldName();
+                if (field == "$and" || field == "$or" || field == "$nor") {
+                    if (predicate.type() != Array)
+                        return false;
+                    BSONForEach(clause, predicate.embeddedObject()) {
+                        if (!clause.isABSONObj() || !queryAvoids(clause.embeddedObject(), added))
+                            return false;
+                    }
+                    continue;
+                }
+
+                if (field[0] == '$')
+                    return false;
+
+                for (size_t i = 0; i < added.size(); i++) {
+                    if (pathsOverlap(field, added[i]))
+                        return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool DocumentSourceGeoNear::absorbMatch(const DocumentSourceMatch& match) {
+        BSONObjBuilder queryBuilder;
+        match.toMatcherBson(&queryBuilder);
+        BSONObj query = queryBuilder.obj();
+
+        vector<string> added;
+        added.push_back(distanceField->getPath(false));
+        if (includeLocs)
+            added.push_back(includeLocs->getPath(false));
+        if (!queryAvoids(query, added))
+            return false;
+
+        // A second $match is ANDed with the first.
+        filterQuery = filterQuery.isEmpty() ? query
+                                            : BSON("$and" << BSON_ARRAY(filterQuery << query));
+        filter.reset(new Matcher(filterQuery));
+        return true;
     }
 
     intrusive_ptr<DocumentSourceGeoNear> DocumentSourceGeoNear::create(
@@ -215,5 +316,8 @@ namespace mongo {
         , spherical(false)
         , distanceMultiplier(1.0)
         , uniqueDocs(true)
+        , started(false)
+        , numFetched(0)
+        , batchPos(0)
     {}
 }
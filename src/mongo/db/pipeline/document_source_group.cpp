@@ -28,7 +28,9 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
@@ -36,8 +38,14 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/queue.h"
 
 namespace mongo {
+    // Number of threads $group accumulates its input on. 1 keeps everything on the reading thread.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationGroupThreads, int, 1);
+
     const char DocumentSourceGroup::groupName[] = "$group";
 
     const char *DocumentSourceGroup::getSourceName() const {
@@ -144,6 +152,30 @@ namespace mongo {
         return Value(DOC(getSourceName() << insides.freeze()));
     }
 
+    void DocumentSourceGroup::optimize() {
+        pIdExpression = pIdExpression->optimize();
+        for (size_t i = 0; i < vpExpression.size(); i++) {
+            vpExpression[i] = vpExpression[i]->optimize();
+        }
+
+        // The _id and the accumulators all see the same document, so a sub-expression they
+        // share (or that one repeats) is only evaluated once.
+        vector<intrusive_ptr<Expression>*> roots;
+        roots.push_back(&pIdExpression);
+        for (size_t i = 0; i < vpExpression.size(); i++) {
+            roots.push_back(&vpExpression[i]);
+        }
+        const vector<intrusive_ptr<ExpressionCommonSubexpression> > found =
+            Expression::eliminateCommonSubexpressions(roots);
+        _commonSubexpressions.insert(_commonSubexpressions.end(), found.begin(), found.end());
+    }
+
+    void DocumentSourceGroup::resetCommonSubexpressions() {
+        for (size_t i = 0; i < _commonSubexpressions.size(); i++) {
+            _commonSubexpressions[i]->reset();
+        }
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceGroup::getDependencies(set<string>& deps) const {
         // add the _id
         pIdExpression->addDependencies(deps);
@@ -341,12 +373,278 @@ namespace mongo {
                 return Value::compare(lhs.first, rhs.first);
             }
         };
+
+        void uassertCanSpill(bool extSortAllowed) {
+            uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort",
+                    extSortAllowed);
+        }
+
+        /*
+          The _id and accumulator arguments of one input document.  They
+          are evaluated on the thread reading the input, since Expressions
+          are shared and their reference counts are not thread safe.
+         */
+        struct GroupInput {
+            Value id;
+            vector<Value> args;
+        };
+
+        /*
+          What the reading thread hands a partition: a batch of inputs, a
+          request to spill what the partition holds, or the end of the input.
+         */
+        struct GroupBatch {
+            enum Kind { INPUTS, SPILL, END };
+            explicit GroupBatch(Kind kind = INPUTS) : kind(kind) {}
+
+            Kind kind;
+            vector<GroupInput> inputs;
+        };
+
+        /*
+          The $group memory limit, shared by all partitions.  The reading
+          thread spills one partition at a time, the largest, once the
+          partitions together use more than the limit.
+         */
+        struct GroupMemoryBudget {
+            AtomicInt64 usedBytes;
+            AtomicUInt32 spillsPending;
+        };
+
+        // Inputs are handed to a partition this many at a time.
+        const size_t groupBatchSize = 1024;
+
+        // Batches a partition may have queued before the reading thread waits on it.
+        const size_t groupQueueDepth = 4;
+    }
+
+    class DocumentSourceGroup::Partition : boost::noncopyable {
+    public:
+        Partition(DocumentSourceGroup* owner, GroupMemoryBudget* budget)
+            : _owner(owner)
+            , _budget(budget)
+            , _queue(groupQueueDepth)
+            , _errorCode(0)
+        {}
+
+        ~Partition() {
+            // Only reached with a running thread if the reader failed; results are discarded.
+            if (_thread) {
+                push(shared_ptr<GroupBatch>(new GroupBatch(GroupBatch::END)));
+                _thread->join();
+            }
+        }
+
+        void start() {
+            _thread.reset(new boost::thread(boost::bind(&Partition::run, this)));
+        }
+
+        /// Queue 'batch' for this partition.
+        void push(const shared_ptr<GroupBatch>& batch) {
+            _queue.push(batch);
+        }
+
+        /// Bytes used by this partition's groups, as of the last batch it processed.
+        long long memoryUsageBytes() const {
+            return _memoryUsageBytes.load();
+        }
+
+        /// Wait for the end of the input to be processed, rethrowing any error the worker hit.
+        void join() {
+            _thread->join();
+            _thread.reset();
+            if (_errorCode)
+                uasserted(_errorCode, _errmsg);
+        }
+
+        GroupsMap groups;
+        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+
+    private:
+        void run() {
+            bool sawEnd = false;
+            try {
+                while (!sawEnd) {
+                    shared_ptr<GroupBatch> batch = _queue.blockingPop();
+                    switch (batch->kind) {
+                    case GroupBatch::INPUTS: process(batch->inputs); break;
+                    case GroupBatch::SPILL: spill(); break;
+                    case GroupBatch::END: sawEnd = true; break;
+                    }
+                }
+
+                // A partition that spilled is merged from disk, so spill the rest of it too.
+                if (!sortedFiles.empty() && !groups.empty())
+                    sortedFiles.push_back(_owner->spill(&groups));
+            }
+            catch (const DBException& e) {
+                _errorCode = e.getCode();
+                _errmsg = e.what();
+            }
+            catch (const std::exception& e) {
+                _errorCode = 17197;
+                _errmsg = str::stream() << "$group worker failed: " << e.what();
+            }
+
+            // Keep draining after an error so the reader never blocks on this partition.
+            while (!sawEnd) {
+                shared_ptr<GroupBatch> batch = _queue.blockingPop();
+                if (batch->kind == GroupBatch::SPILL)
+                    _budget->spillsPending.subtractAndFetch(1);
+                sawEnd = batch->kind == GroupBatch::END;
+            }
+        }
+
+        void process(const vector<GroupInput>& inputs) {
+            const size_t numAccumulators = _owner->vpAccumulatorFactory.size();
+
+            // Published once per batch, to keep the shared counter cheap.
+            long long usageDelta = 0;
+            for (size_t i = 0; i < inputs.size(); i++) {
+                const Value& id = inputs[i].id;
+                const size_t oldSize = groups.size();
+                Accumulators& group = groups[id];
+
+                if (groups.size() != oldSize) {
+                    usageDelta += id.getApproximateSize();
+                    group.reserve(numAccumulators);
+                    for (size_t j = 0; j < numAccumulators; j++) {
+                        group.push_back(_owner->vpAccumulatorFactory[j]());
+                    }
+                } else {
+                    for (size_t j = 0; j < numAccumulators; j++) {
+                        usageDelta -= group[j]->memUsageForSorter();
+                    }
+                }
+
+                for (size_t j = 0; j < numAccumulators; j++) {
+                    group[j]->process(inputs[i].args[j], _owner->_doingMerge);
+                    usageDelta += group[j]->memUsageForSorter();
+                }
+            }
+
+            _memoryUsageBytes.fetchAndAdd(usageDelta);
+            _budget->usedBytes.fetchAndAdd(usageDelta);
+        }
+
+        void spill() {
+            if (!groups.empty())
+                sortedFiles.push_back(_owner->spill(&groups));
+            _budget->usedBytes.subtractAndFetch(_memoryUsageBytes.load());
+            _memoryUsageBytes.store(0);
+            _budget->spillsPending.subtractAndFetch(1);
+        }
+
+        DocumentSourceGroup* const _owner;
+        GroupMemoryBudget* const _budget;
+        AtomicInt64 _memoryUsageBytes; // written by the worker, read by the reader
+        BlockingQueue<shared_ptr<GroupBatch> > _queue;
+        scoped_ptr<boost::thread> _thread;
+
+        // Set by the worker thread, read by the reader only after join().
+        int _errorCode;
+        string _errmsg;
+    };
+
+    void DocumentSourceGroup::populateParallel(size_t numPartitions) {
+        const size_t numAccumulators = vpExpression.size();
+
+        GroupMemoryBudget budget;
+        OwnedPointerVector<Partition> ownedPartitions;
+        vector<Partition*>& partitions = ownedPartitions.mutableVector();
+        vector<shared_ptr<GroupBatch> > batches(numPartitions);
+        for (size_t i = 0; i < numPartitions; i++) {
+            partitions.push_back(new Partition(this, &budget));
+            partitions[i]->start();
+            batches[i].reset(new GroupBatch());
+            batches[i]->inputs.reserve(groupBatchSize);
+        }
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            // Wait for one spill to land before asking for another, since usage is only
+            // published as partitions finish their batches.
+            if (budget.usedBytes.load() > _maxMemoryUsageBytes
+                    && budget.spillsPending.load() == 0) {
+                uassertCanSpill(_extSortAllowed);
+
+                size_t largest = 0;
+                for (size_t i = 1; i < numPartitions; i++) {
+                    if (partitions[i]->memoryUsageBytes()
+                            > partitions[largest]->memoryUsageBytes())
+                        largest = i;
+                }
+                budget.spillsPending.addAndFetch(1);
+                partitions[largest]->push(
+                    shared_ptr<GroupBatch>(new GroupBatch(GroupBatch::SPILL)));
+            }
+
+            const Variables vars(*input);
+            resetCommonSubexpressions();
+
+            Value id = pIdExpression->evaluate(vars);
+            if (id.missing())
+                id = Value(BSONNULL); // SERVER-4674, as in populate()
+
+            // Value::Hash agrees with Value::compare, so equal ids land in the same partition.
+            const size_t partition = Value::Hash()(id) % numPartitions;
+            vector<GroupInput>& inputs = batches[partition]->inputs;
+            inputs.push_back(GroupInput());
+            inputs.back().id = id;
+            inputs.back().args.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                inputs.back().args.push_back(vpExpression[i]->evaluate(vars));
+            }
+
+            if (inputs.size() == groupBatchSize) {
+                partitions[partition]->push(batches[partition]);
+                batches[partition].reset(new GroupBatch());
+                batches[partition]->inputs.reserve(groupBatchSize);
+            }
+        }
+
+        bool spilled = false;
+        for (size_t i = 0; i < numPartitions; i++) {
+            if (!batches[i]->inputs.empty())
+                partitions[i]->push(batches[i]);
+            partitions[i]->push(shared_ptr<GroupBatch>(new GroupBatch(GroupBatch::END)));
+        }
+        for (size_t i = 0; i < numPartitions; i++) {
+            partitions[i]->join();
+            spilled = spilled || !partitions[i]->sortedFiles.empty();
+        }
+
+        // Partitions hold disjoint sets of ids, so they can be concatenated without merging
+        // accumulators. If any spilled, everything goes through the usual sorted merge.
+        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+        for (size_t i = 0; i < numPartitions; i++) {
+            Partition& p = *partitions[i];
+            if (spilled) {
+                if (!p.groups.empty())
+                    sortedFiles.push_back(spill(&p.groups));
+                sortedFiles.insert(sortedFiles.end(), p.sortedFiles.begin(), p.sortedFiles.end());
+            }
+            else if (groups.empty()) {
+                groups.swap(p.groups);
+            }
+            else {
+                groups.insert(p.groups.begin(), p.groups.end());
+                GroupsMap().swap(p.groups);
+            }
+        }
+
+        finishPopulate(sortedFiles);
     }
 
     void DocumentSourceGroup::populate() {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
+        const int numThreads = aggregationGroupThreads;
+        if (numThreads > 1) {
+            populateParallel(numThreads);
+            return;
+        }
+
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
         int memoryUsageBytes = 0;
@@ -354,13 +652,13 @@ namespace mongo {
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
             if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
+                uassertCanSpill(_extSortAllowed);
+                sortedFiles.push_back(spill(&groups));
                 memoryUsageBytes = 0;
             }
 
             const Variables vars(*input);
+            resetCommonSubexpressions();
 
             /* get the _id value */
             Value id = pIdExpression->evaluate(vars);
@@ -406,16 +704,23 @@ namespace mongo {
                         && !_extSortAllowed // don't change behavior when testing external sort
                         && sortedFiles.size() < 20 // don't open too many FDs
                         ) {
-                    sortedFiles.push_back(spill());
+                    sortedFiles.push_back(spill(&groups));
                 }
             }
         }
 
+        finishPopulate(sortedFiles);
+    }
+
+    void DocumentSourceGroup::finishPopulate(
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> >& sortedFiles) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+
         // These blocks do any final steps necessary to prepare to output results.
         if (!sortedFiles.empty()) {
             _spilled = true;
             if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+                sortedFiles.push_back(spill(&groups));
             }
 
             // We won't be using groups again so free its memory.
@@ -448,10 +753,10 @@ namespace mongo {
         }
     };
 
-    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
+    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill(GroupsMap* groups) {
         vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
+        ptrs.reserve(groups->size());
+        for (GroupsMap::const_iterator it=groups->begin(), end=groups->end(); it != end; ++it) {
             ptrs.push_back(&*it);
         }
 
@@ -483,7 +788,7 @@ namespace mongo {
             break;
         }
 
-        groups.clear();
+        groups->clear();
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
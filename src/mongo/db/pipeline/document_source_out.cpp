@@ -78,22 +78,35 @@ namespace mongo {
                                          << _tempNs.ns() << "': " << info.toString(),
                     ok);
         }
+    }
+
+    void DocumentSourceOut::copyIndexes() {
+        verify(_tempNs.size() != 0);
+
+        DBClientBase* conn = _mongod->directClient();
 
-        // copy indexes on _outputNs to _tempNs
+        // copy indexes on _outputNs to _tempNs. This is done after the data is loaded so that
+        // each index is built once, by the bulk builder, instead of being maintained per insert.
+        // The specs go in as one insert so that the indexes are built from a single scan.
+        vector<BSONObj> indexSpecs;
         scoped_ptr<DBClientCursor> indexes(conn->getIndexes(_outputNs));
         while (indexes->more()) {
             MutableDocument index(Document(indexes->nextSafe()));
             index.remove("_id"); // indexes shouldn't have _ids but some existing ones do
             index["ns"] = Value(_tempNs.ns());
 
-            BSONObj indexBson = index.freeze().toBson();
-            conn->insert(_tempNs.getSystemIndexesCollection(), indexBson);
-            BSONObj err = conn->getLastErrorDetailed();
-            uassert(16995, str::stream() << "copying index for $out failed."
-                                         << " index: " << indexBson
-                                         << " error: " <<  err,
-                    DBClientWithCommands::getLastErrorString(err).empty());
+            indexSpecs.push_back(index.freeze().toBson());
         }
+
+        if (indexSpecs.empty())
+            return;
+
+        conn->insert(_tempNs.getSystemIndexesCollection(), indexSpecs);
+        BSONObj err = conn->getLastErrorDetailed();
+        uassert(16995, str::stream() << "copying indexes for $out failed."
+                                     << " indexes: " << BSON("specs" << indexSpecs)
+                                     << " error: " <<  err,
+                DBClientWithCommands::getLastErrorString(err).empty());
     }
 
     void DocumentSourceOut::spill(DBClientBase* conn, const vector<BSONObj>& toInsert) {
@@ -133,6 +146,8 @@ namespace mongo {
         if (!bufferedObjects.empty())
             spill(conn, bufferedObjects);
 
+        copyIndexes();
+
         // Checking again to make sure we didn't become sharded while running.
         uassert(17018, str::stream() << "namespace '" << _outputNs.ns()
                                      << "' became sharded so it can't be used for $out'",
@@ -65,6 +65,9 @@ namespace mongo {
           If we're excluding fields at the top level, leave out the _id if
           it is found, because we took care of it above.
         */
+        for (size_t i = 0; i < _commonSubexpressions.size(); i++) {
+            _commonSubexpressions[i]->reset();
+        }
         pEO->addToDocument(out, *input, Variables(*input));
 
 #if defined(_DEBUG)
@@ -92,6 +95,14 @@ namespace mongo {
     void DocumentSourceProject::optimize() {
         intrusive_ptr<Expression> pE(pEO->optimize());
         pEO = dynamic_pointer_cast<ExpressionObject>(pE);
+
+        // Fields often repeat a sub-expression, such as the same $cond. Evaluate it once.
+        // This keeps the ones found by earlier calls, since they are still in pEO.
+        vector<intrusive_ptr<Expression>*> fields;
+        pEO->addChildrenInSameScope(fields);
+        const vector<intrusive_ptr<ExpressionCommonSubexpression> > found =
+            Expression::eliminateCommonSubexpressions(fields);
+        _commonSubexpressions.insert(_commonSubexpressions.end(), found.begin(), found.end());
     }
 
     Value DocumentSourceProject::serialize(bool explain) const {
@@ -59,11 +59,16 @@ namespace mongo {
         if (explain) { // always one Value for combined $sort + $limit
             array.push_back(Value(
                     DOC(getSourceName() << DOC("sortKey" << serializeSortKey()
+                                            << "mergePresorted" << (_mergingPresorted ? Value(true)
+                                                                                      : Value())
                                             << "limit" << (limitSrc ? Value(limitSrc->getLimit())
                                                                     : Value())))));
         }
         else { // one Value for $sort and maybe a Value for $limit
-            array.push_back(Value(DOC(getSourceName() << serializeSortKey())));
+            MutableDocument inner (serializeSortKey());
+            if (_mergingPresorted)
+                inner["$mergePresorted"] = Value(true);
+            array.push_back(Value(DOC(getSourceName() << inner.freeze())));
             if (limitSrc) {
                 limitSrc->serializeToArray(array);
             }
@@ -78,8 +83,19 @@ namespace mongo {
     DocumentSourceSort::DocumentSourceSort(const intrusive_ptr<ExpressionContext> &pExpCtx)
         : SplittableDocumentSource(pExpCtx)
         , populated(false)
+        , _mergingPresorted(false)
     {}
 
+    intrusive_ptr<DocumentSource> DocumentSourceSort::getRouterSource() {
+        verify(!_mergingPresorted);
+        intrusive_ptr<DocumentSourceSort> other = new DocumentSourceSort(pExpCtx);
+        other->vSortKey = vSortKey;
+        other->vAscending = vAscending;
+        other->limitSrc = limitSrc;
+        other->_mergingPresorted = true;
+        return other;
+    }
+
     long long DocumentSourceSort::getLimit() const {
         return limitSrc ? limitSrc->getLimit() : -1;
     }
@@ -150,6 +166,12 @@ namespace mongo {
             BSONElement keyField(keyIterator.next());
             const char *pKeyFieldName = keyField.fieldName();
             int sortOrder = 0;
+
+            if (str::equals(pKeyFieldName, "$mergePresorted")) {
+                // set by getRouterSource() on a pipeline being merged for mongos
+                pSort->_mergingPresorted = keyField.trueValue();
+                continue;
+            }
                 
             uassert(15974, str::stream() << sortName <<
                     " key ordering must be specified using a number",
@@ -176,7 +198,7 @@ namespace mongo {
         return pSort;
     }
 
-    void DocumentSourceSort::populate() {
+    SortOptions DocumentSourceSort::makeSortOptions() const {
         /* make sure we've got a sort key */
         verify(vSortKey.size());
 
@@ -190,7 +212,22 @@ namespace mongo {
             opts.tempDir = pExpCtx->tempDir;
         }
 
-        scoped_ptr<MySorter> sorter (MySorter::make(opts, Comparator(*this)));
+        return opts;
+    }
+
+    void DocumentSourceSort::populate() {
+        if (_mergingPresorted) {
+            // Other sources, like the $commandShards of a mongos merging on its own, don't keep
+            // each shard's documents apart, so for them we sort everything as usual.
+            if (DocumentSourceMergeCursors* cursors =
+                    dynamic_cast<DocumentSourceMergeCursors*>(pSource)) {
+                populateFromCursors(cursors->getCursors());
+                populated = true;
+                return;
+            }
+        }
+
+        scoped_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
 
         while (boost::optional<Document> next = pSource->getNext()) {
             sorter->add(extractKey(*next), *next);
@@ -200,6 +237,33 @@ namespace mongo {
         populated = true;
     }
 
+    class DocumentSourceSort::IteratorFromCursor : public MySorter::Iterator {
+    public:
+        IteratorFromCursor(DocumentSourceSort* sorter, DBClientCursor* cursor)
+            : _sorter(sorter)
+            , _cursor(cursor)
+        {}
+
+        bool more() { return _cursor->more(); }
+        Data next() {
+            const Document doc = DocumentSourceMergeCursors::nextSafeFrom(_cursor);
+            return make_pair(_sorter->extractKey(doc), doc);
+        }
+
+    private:
+        DocumentSourceSort* _sorter;
+        DBClientCursor* _cursor;
+    };
+
+    void DocumentSourceSort::populateFromCursors(const vector<DBClientCursor*>& cursors) {
+        vector<boost::shared_ptr<MySorter::Iterator> > iterators;
+        for (size_t i = 0; i < cursors.size(); i++) {
+            iterators.push_back(boost::make_shared<IteratorFromCursor>(this, cursors[i]));
+        }
+
+        _output.reset(MySorter::Iterator::merge(iterators, makeSortOptions(), Comparator(*this)));
+    }
+
     Value DocumentSourceSort::extractKey(const Document& d) const {
         if (vSortKey.size() == 1) {
             return vSortKey[0]->evaluate(d);
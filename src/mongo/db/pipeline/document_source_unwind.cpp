@@ -57,7 +57,7 @@ namespace mongo {
         const FieldPath _unwindPath;
 
         Value _inputArray;
-        MutableDocument _output;
+        Document _input;
 
         // Document indexes of the field path components.
         vector<Position> _unwindPathFieldIndexes;
@@ -73,7 +73,7 @@ namespace mongo {
 
         // Reset document specific attributes.
         _inputArray = Value();
-        _output.reset(document);
+        _input = document;
         _unwindPathFieldIndexes.clear();
         _index = 0;
 
@@ -96,16 +96,12 @@ namespace mongo {
         if (_inputArray.missing() || _index == _inputArray.getArrayLength())
             return boost::none;
 
-        // If needed, this will automatically clone all the documents along the
-        // field path so that the end values are not shared across documents
-        // that have come out of this pipeline operator.  This is a partial deep
-        // clone. Because the value at the end will be replaced, everything
-        // along the path leading to that will be replaced in order not to share
-        // that change with any other clones (or the original).
-
-        _output.setNestedField(_unwindPathFieldIndexes, _inputArray[_index]);
+        // Each document along the field path is replaced by one that differs from the input
+        // only in the next field down, and shares all its other fields with the input rather
+        // than copying them. A later stage changing one of these documents copies it first.
+        Document output = _input.withNestedField(_unwindPathFieldIndexes, _inputArray[_index]);
         _index++;
-        return _output.peek();
+        return output;
     }
 
     const char DocumentSourceUnwind::unwindName[] = "$unwind";
@@ -312,6 +312,81 @@ namespace {
         }
     }
 
+namespace {
+    typedef map<string, int> SubexpressionCounts;
+    typedef map<string, intrusive_ptr<ExpressionCommonSubexpression> > SharedSubexpressions;
+
+    /** Expressions that are worth evaluating only once. Constants and field paths are cheaper
+     *  to evaluate than to look up, and ExpressionObject must stay one for addToDocument().
+     */
+    bool isCommonSubexpressionCandidate(const Expression* expr) {
+        return !dynamic_cast<const ExpressionConstant*>(expr)
+            && !dynamic_cast<const ExpressionFieldPath*>(expr)
+            && !dynamic_cast<const ExpressionObject*>(expr)
+            && !dynamic_cast<const ExpressionCommonSubexpression*>(expr);
+    }
+
+    /// Expressions that serialize the same compute the same thing, since serialize() round-trips
+    string subexpressionKey(const Expression* expr) {
+        BSONObjBuilder builder;
+        builder << "" << expr->serialize();
+        const BSONObj obj = builder.done();
+        return string(obj.objdata(), obj.objsize());
+    }
+
+    void countSubexpressions(const intrusive_ptr<Expression>& expr, SubexpressionCounts& counts) {
+        if (isCommonSubexpressionCandidate(expr.get()))
+            counts[subexpressionKey(expr.get())]++;
+
+        vector<intrusive_ptr<Expression>*> children;
+        expr->addChildrenInSameScope(children);
+        for (size_t i = 0; i < children.size(); i++) {
+            countSubexpressions(*children[i], counts);
+        }
+    }
+
+    void replaceSubexpressions(intrusive_ptr<Expression>& expr,
+                               const SubexpressionCounts& counts,
+                               SharedSubexpressions& shared) {
+        if (isCommonSubexpressionCandidate(expr.get())) {
+            const string key = subexpressionKey(expr.get());
+            if (counts.find(key)->second > 1) {
+                // Don't look inside: the whole subtree is now only evaluated once
+                intrusive_ptr<ExpressionCommonSubexpression>& common = shared[key];
+                if (!common)
+                    common = ExpressionCommonSubexpression::create(expr);
+                expr = common;
+                return;
+            }
+        }
+
+        vector<intrusive_ptr<Expression>*> children;
+        expr->addChildrenInSameScope(children);
+        for (size_t i = 0; i < children.size(); i++) {
+            replaceSubexpressions(*children[i], counts, shared);
+        }
+    }
+}
+
+    vector<intrusive_ptr<ExpressionCommonSubexpression> >
+    Expression::eliminateCommonSubexpressions(const vector<intrusive_ptr<Expression>*>& roots) {
+        SubexpressionCounts counts;
+        for (size_t i = 0; i < roots.size(); i++) {
+            countSubexpressions(*roots[i], counts);
+        }
+
+        SharedSubexpressions shared;
+        for (size_t i = 0; i < roots.size(); i++) {
+            replaceSubexpressions(*roots[i], counts, shared);
+        }
+
+        vector<intrusive_ptr<ExpressionCommonSubexpression> > out;
+        for (SharedSubexpressions::const_iterator it = shared.begin(); it != shared.end(); ++it) {
+            out.push_back(it->second);
+        }
+        return out;
+    }
+
     /* ------------------------- ExpressionAdd ----------------------------- */
 
     Value ExpressionAdd::evaluateInternal(const Variables& vars) const {
@@ -545,6 +620,11 @@ namespace {
         pExpression->addDependencies(deps);
     }
 
+    void ExpressionCoerceToBool::addChildrenInSameScope(
+            vector<intrusive_ptr<Expression>*>& children) {
+        children.push_back(&pExpression);
+    }
+
     Value ExpressionCoerceToBool::evaluateInternal(const Variables& vars) const {
         Value pResult(pExpression->evaluateInternal(vars));
         bool b = pResult.coerceToBool();
@@ -558,6 +638,43 @@ namespace {
         return Value(DOC("$and" << DOC_ARRAY(pExpression->serialize())));
     }
 
+    /* ---------------- ExpressionCommonSubexpression ---------------------- */
+
+    intrusive_ptr<ExpressionCommonSubexpression> ExpressionCommonSubexpression::create(
+            const intrusive_ptr<Expression>& expression) {
+        return new ExpressionCommonSubexpression(expression);
+    }
+
+    ExpressionCommonSubexpression::ExpressionCommonSubexpression(
+            const intrusive_ptr<Expression>& expression)
+        : _expression(expression)
+        , _evaluated(false)
+    {}
+
+    intrusive_ptr<Expression> ExpressionCommonSubexpression::optimize() {
+        // Keep standing in for the expression, even if it becomes a constant, since the stage
+        // still owns and resets this.
+        _expression = _expression->optimize();
+        return this;
+    }
+
+    void ExpressionCommonSubexpression::addDependencies(set<string>& deps,
+                                                        vector<string>* path) const {
+        _expression->addDependencies(deps, path);
+    }
+
+    Value ExpressionCommonSubexpression::evaluateInternal(const Variables& vars) const {
+        if (!_evaluated) {
+            _value = _expression->evaluateInternal(vars);
+            _evaluated = true;
+        }
+        return _value;
+    }
+
+    Value ExpressionCommonSubexpression::serialize() const {
+        return _expression->serialize();
+    }
+
     /* ----------------------- ExpressionCompare --------------------------- */
 
     REGISTER_EXPRESSION("$cmp", ExpressionCompare::parse);
@@ -729,6 +846,18 @@ namespace {
 
     /* ----------------------- ExpressionCond ------------------------------ */
 
+    intrusive_ptr<Expression> ExpressionCond::optimize() {
+        intrusive_ptr<Expression> optimized = ExpressionNary::optimize();
+        if (optimized.get() != this)
+            return optimized; // all constant
+
+        // a constant condition picks the branch once, rather than once per document
+        if (ExpressionConstant* cond = dynamic_cast<ExpressionConstant*>(vpOperand[0].get()))
+            return vpOperand[cond->getValue().coerceToBool() ? 1 : 2];
+
+        return this;
+    }
+
     Value ExpressionCond::evaluateInternal(const Variables& vars) const {
         Value pCond(vpOperand[0]->evaluateInternal(vars));
         int idx = pCond.coerceToBool() ? 1 : 2;
@@ -904,6 +1033,13 @@ namespace {
         return intrusive_ptr<Expression>(this);
     }
 
+    void ExpressionObject::addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children) {
+        for (FieldMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
+            if (it->second) // inclusions have no expression
+                children.push_back(&it->second);
+        }
+    }
+
     bool ExpressionObject::isSimple() {
         for (FieldMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
             if (it->second && !it->second->isSimple())
@@ -1156,6 +1292,27 @@ namespace {
         addField(theFieldPath, NULL);
     }
 
+    string ExpressionObject::getSourceField(const string& fieldName) const {
+        FieldMap::const_iterator it = _expressions.find(fieldName);
+        if (it == _expressions.end()) {
+            // _id from the root doc is always included unless it is excluded
+            return (_atRoot && !_excludeId && fieldName == "_id") ? fieldName : "";
+        }
+
+        if (!it->second) // inclusion
+            return fieldName;
+
+        // A dotted path can flatten nested arrays, so only a top-level field is an exact copy.
+        const ExpressionFieldPath* fieldPath =
+            dynamic_cast<const ExpressionFieldPath*>(it->second.get());
+        if (fieldPath
+                && fieldPath->getFieldPath().getPathLength() == 2
+                && fieldPath->getFieldPath().getFieldName(0) == "CURRENT")
+            return fieldPath->getFieldPath().getFieldName(1);
+
+        return "";
+    }
+
     Value ExpressionObject::serialize() const {
         MutableDocument valBuilder;
         if (_excludeId)
@@ -1210,7 +1367,10 @@ namespace {
         , _baseVar(_fieldPath.getFieldName(0) == "CURRENT" ? CURRENT :
                    _fieldPath.getFieldName(0) == "ROOT" ?    ROOT :
                                                              OTHER)
-    {}
+    {
+        for (size_t i = 0; i < _fieldPath.getPathLength(); i++)
+            _fieldHashes.push_back(Document::hashFieldName(_fieldPath.getFieldName(i)));
+    }
 
     intrusive_ptr<Expression> ExpressionFieldPath::optimize() {
         /* nothing can be done for these */
@@ -1251,10 +1411,10 @@ namespace {
 
         /* if we've hit the end of the path, stop */
         if (index == _fieldPath.getPathLength() - 1)
-            return input[_fieldPath.getFieldName(index)];
+            return input.getField(_fieldPath.getFieldName(index), _fieldHashes[index]);
 
         // Try to dive deeper
-        const Value val = input[_fieldPath.getFieldName(index)];
+        const Value val = input.getField(_fieldPath.getFieldName(index), _fieldHashes[index]);
         switch (val.getType()) {
         case Object:
             return evaluatePath(index+1, val.getDocument());
@@ -1947,6 +2107,18 @@ namespace {
 
     /* ----------------------- ExpressionIfNull ---------------------------- */
 
+    intrusive_ptr<Expression> ExpressionIfNull::optimize() {
+        intrusive_ptr<Expression> optimized = ExpressionNary::optimize();
+        if (optimized.get() != this)
+            return optimized; // all constant
+
+        // a constant first operand decides which operand is the result
+        if (ExpressionConstant* left = dynamic_cast<ExpressionConstant*>(vpOperand[0].get()))
+            return left->getValue().nullish() ? vpOperand[1] : vpOperand[0];
+
+        return this;
+    }
+
     Value ExpressionIfNull::evaluateInternal(const Variables& vars) const {
         Value pLeft(vpOperand[0]->evaluateInternal(vars));
         if (!pLeft.nullish())
@@ -2044,6 +2216,12 @@ namespace {
         }
     }
 
+    void ExpressionNary::addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children) {
+        for (size_t i = 0; i < vpOperand.size(); i++) {
+            children.push_back(&vpOperand[i]);
+        }
+    }
+
     void ExpressionNary::addOperand(const intrusive_ptr<Expression>& pExpression) {
         vpOperand.push_back(pExpression);
     }
@@ -42,6 +42,7 @@ namespace mongo {
     class BSONElement;
     class BSONObjBuilder;
     class DocumentSource;
+    class ExpressionCommonSubexpression;
 
     // TODO: Look into merging with ExpressionContext and possibly ObjectCtx.
     /// The state used as input to Expressions
@@ -106,6 +107,23 @@ namespace mongo {
         /** simple expressions are just inclusion exclusion as supported by ExpressionObject */
         virtual bool isSimple() { return false; }
 
+        /** Add pointers to this expression's direct sub-expressions that are evaluated with the
+         *  same Variables as this one, so that they can be replaced in place.
+         *
+         *  Expressions that bind variables ($let and $map) add none.
+         */
+        virtual void addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children) {}
+
+        /** Find sub-expressions that are repeated under the given roots and replace each with a
+         *  single ExpressionCommonSubexpression, so it is only evaluated once per document.
+         *
+         *  All roots must be evaluated with the same Variables. Call this after optimize().
+         *
+         *  @returns the replacements, which must be reset() before each new document
+         */
+        static vector<intrusive_ptr<ExpressionCommonSubexpression> >
+            eliminateCommonSubexpressions(const vector<intrusive_ptr<Expression>*>& roots);
+
 
         /**
          * Serialize the Expression tree (recursively) and results in a Value
@@ -236,6 +254,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual Value serialize() const;
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
+        virtual void addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children);
 
         /*
           Add an operand to the n-ary expression.
@@ -342,6 +361,7 @@ namespace mongo {
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
         virtual Value evaluateInternal(const Variables& vars) const;
         virtual Value serialize() const;
+        virtual void addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children);
 
         static intrusive_ptr<ExpressionCoerceToBool> create(
             const intrusive_ptr<Expression> &pExpression);
@@ -354,6 +374,36 @@ namespace mongo {
     };
 
 
+    /** Stands for an expression that appears more than once in a stage, so that it is
+     *  evaluated at most once per document.
+     *
+     *  This is never parsed: Expression::eliminateCommonSubexpressions() creates it, and it
+     *  serializes as the expression it stands for. The stage owning it calls reset() before
+     *  evaluating its expressions for each new document.
+     */
+    class ExpressionCommonSubexpression : public Expression {
+    public:
+        // virtuals from Expression
+        virtual intrusive_ptr<Expression> optimize();
+        virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
+        virtual Value evaluateInternal(const Variables& vars) const;
+        virtual Value serialize() const;
+
+        static intrusive_ptr<ExpressionCommonSubexpression> create(
+            const intrusive_ptr<Expression>& expression);
+
+        /// Forget the Value computed for the previous document
+        void reset() { _evaluated = false; }
+
+    private:
+        explicit ExpressionCommonSubexpression(const intrusive_ptr<Expression>& expression);
+
+        intrusive_ptr<Expression> _expression;
+        mutable bool _evaluated;
+        mutable Value _value;
+    };
+
+
     class ExpressionCompare : public ExpressionFixedArity<ExpressionCompare, 2> {
     public:
         // virtuals from ExpressionNary
@@ -383,6 +433,7 @@ namespace mongo {
         typedef ExpressionFixedArity<ExpressionCond, 3> Base;
     public:
         // virtuals from ExpressionNary
+        virtual intrusive_ptr<Expression> optimize();
         virtual Value evaluateInternal(const Variables& vars) const;
         virtual const char *getOpName() const;
 
@@ -506,6 +557,10 @@ namespace mongo {
 
         const FieldPath _fieldPath;
         const BaseVar _baseVar;
+
+        // Document::hashFieldName() of each name in _fieldPath, so that evaluating this on
+        // many documents doesn't hash the same names over and over
+        vector<unsigned> _fieldHashes;
     };
 
 
@@ -596,6 +651,7 @@ namespace mongo {
     class ExpressionIfNull : public ExpressionFixedArity<ExpressionIfNull, 2> {
     public:
         // virtuals from ExpressionNary
+        virtual intrusive_ptr<Expression> optimize();
         virtual Value evaluateInternal(const Variables& vars) const;
         virtual const char *getOpName() const;
     };
@@ -695,6 +751,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual bool isSimple();
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
+        virtual void addChildrenInSameScope(vector<intrusive_ptr<Expression>*>& children);
         /** Only evaluates non inclusion expressions.  For inclusions, use addToDocument(). */
         virtual Value evaluateInternal(const Variables& vars) const;
         virtual Value serialize() const;
@@ -783,6 +840,13 @@ namespace mongo {
 
         void excludeId(bool b) { _excludeId = b; }
 
+        /**
+         * If the output field 'fieldName' is an unchanged copy of a field of the input, through
+         * an inclusion or a plain "$field", returns the name of that input field.  Otherwise
+         * returns the empty string.  Only fields copied from the top level of the input count.
+         */
+        string getSourceField(const string& fieldName) const;
+
     private:
         ExpressionObject(bool atRoot);
 
@@ -95,6 +95,138 @@ namespace mongo {
                       ((const StageDesc *)pR)->pName);
     }
 
+    /*
+      The path 'path' would have in the input of 'project', or the empty
+      string if its first field isn't an unchanged copy of an input field.
+    */
+    static string renameThroughProject(const DocumentSourceProject* project,
+                                       const string& path) {
+        const size_t dot = path.find('.');
+        const string first = path.substr(0, dot);
+        const string source = project->getSourceField(first);
+        if (source.empty())
+            return source;
+        return dot == string::npos ? source : source + path.substr(dot);
+    }
+
+    /* Do the dotted paths 'a' and 'b' name the same field, or one a parent of the other? */
+    static bool pathsOverlap(const string& a, const string& b) {
+        const string& shorter = a.size() < b.size() ? a : b;
+        const string& longer = a.size() < b.size() ? b : a;
+        return str::startsWith(longer, shorter)
+            && (longer.size() == shorter.size() || longer[shorter.size()] == '.');
+    }
+
+    static intrusive_ptr<DocumentSource> makeMatch(
+            const BSONObj& query,
+            const intrusive_ptr<ExpressionContext>& pCtx) {
+        BSONObj spec = BSON(DocumentSourceMatch::matchName << query);
+        BSONElement specElt = spec.firstElement();
+        return DocumentSourceMatch::createFromBson(&specElt, pCtx);
+    }
+
+    /*
+      Try to move the stage at sources[i] ahead of the one before it,
+      without changing what comes out of the pair:
+
+      - $skip and $limit go ahead of $project, which neither adds nor
+        drops documents.
+      - $sort goes ahead of $project if every key is an unchanged copy of
+        an input field, and is renamed to that field.
+      - $match goes ahead of $project for the predicates on unchanged
+        copies of input fields, renamed the same way, and ahead of $unwind
+        for the predicates that don't touch the unwound field.  When only
+        some predicates can move, the $match is split in two.
+
+      Returns true if sources[i - 1] changed.
+    */
+    bool Pipeline::moveAheadOfPrevious(SourceContainer& sources,
+                                       size_t i,
+                                       const intrusive_ptr<ExpressionContext>& pCtx) {
+        DocumentSource* previous = sources[i - 1].get();
+        DocumentSource* current = sources[i].get();
+        DocumentSourceProject* project = dynamic_cast<DocumentSourceProject*>(previous);
+        DocumentSourceUnwind* unwind = dynamic_cast<DocumentSourceUnwind*>(previous);
+        if (!project && !unwind)
+            return false;
+
+        if (project && (dynamic_cast<DocumentSourceSkip*>(current)
+                        || dynamic_cast<DocumentSourceLimit*>(current))) {
+            swap(sources[i], sources[i - 1]);
+            return true;
+        }
+
+        if (DocumentSourceSort* sort = dynamic_cast<DocumentSourceSort*>(current)) {
+            if (!project || sort->getLimitSrc())
+                return false;
+
+            BSONObjBuilder sortKey;
+            BSONForEach(key, sort->serializeSortKey().toBson()) {
+                const string source = renameThroughProject(project, key.fieldName());
+                if (source.empty())
+                    return false;
+                sortKey.appendAs(key, source);
+            }
+
+            intrusive_ptr<DocumentSource> moved = DocumentSourceSort::create(pCtx, sortKey.obj());
+            moved->setPipelineStep(sort->getPipelineStep());
+            sources[i] = sources[i - 1];
+            sources[i - 1] = moved;
+            return true;
+        }
+
+        DocumentSourceMatch* match = dynamic_cast<DocumentSourceMatch*>(current);
+        if (!match)
+            return false;
+
+        BSONObjBuilder query;
+        match->toMatcherBson(&query);
+
+        // Top-level predicates are ANDed, so they can be split between two $matches.
+        BSONObjBuilder ahead;
+        BSONObjBuilder behind;
+        set<string> aheadFields;
+        bool anyAhead = false;
+        bool anyBehind = false;
+        BSONForEach(predicate, query.obj()) {
+            const string field = predicate.fieldName();
+            string source;
+            if (field[0] != '$') { // $and, $or and friends stay where they are
+                if (project)
+                    source = renameThroughProject(project, field);
+                else if (!pathsOverlap(field, unwind->getUnwindPath().getPath(false)))
+                    source = field;
+            }
+
+            // Two renames to the same field would have to be ANDed differently.
+            if (!source.empty() && aheadFields.insert(source).second) {
+                ahead.appendAs(predicate, source);
+                anyAhead = true;
+            }
+            else {
+                behind.append(predicate);
+                anyBehind = true;
+            }
+        }
+
+        if (!anyAhead)
+            return false;
+
+        intrusive_ptr<DocumentSource> moved = makeMatch(ahead.obj(), pCtx);
+        moved->setPipelineStep(match->getPipelineStep());
+        if (anyBehind) {
+            intrusive_ptr<DocumentSource> left = makeMatch(behind.obj(), pCtx);
+            left->setPipelineStep(match->getPipelineStep());
+            sources[i] = left;
+            sources.insert(sources.begin() + (i - 1), moved);
+        }
+        else {
+            sources[i] = sources[i - 1];
+            sources[i - 1] = moved;
+        }
+        return true;
+    }
+
     intrusive_ptr<Pipeline> Pipeline::parseCommand(
         string &errmsg, BSONObj &cmdObj,
         const intrusive_ptr<ExpressionContext> &pCtx) {
@@ -205,11 +337,19 @@ namespace mongo {
             return pPipeline;
 
         /*
-          Move filters up where possible.
-
-          CW TODO -- move filter past projections where possible, and noting
-          corresponding field renaming.
+          Move filters, sorts, skips and limits up where possible, past
+          projections (noting field renaming) and, for filters, unwinds.
+          This lets more of them reach the query run for the first stage,
+          and means later stages see fewer documents.  We do this before the
+          other rewrites below, so they see the stages in their new places.
+
+          Start over whenever something moves, since a moved stage may be
+          able to move again.
         */
+        for (size_t srci = 1; srci < sources.size(); ++srci) {
+            if (moveAheadOfPrevious(sources, srci, pCtx))
+                srci = 0; // incremented before next pass
+        }
 
         /*
           Wherever there is a match immediately following a sort, swap them.
@@ -164,6 +164,14 @@ namespace mongo {
 
         typedef std::deque<boost::intrusive_ptr<DocumentSource> > SourceContainer;
         SourceContainer sources;
+
+        /**
+         * Moves sources[i] ahead of sources[i - 1], or part of it if it is a $match, where that
+         * doesn't change the results.  Returns true if anything moved.
+         */
+        static bool moveAheadOfPrevious(SourceContainer& sources,
+                                        size_t i,
+                                        const intrusive_ptr<ExpressionContext>& pCtx);
         bool explain;
 
         boost::intrusive_ptr<ExpressionContext> pCtx;
@@ -32,17 +32,68 @@
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/cursor.h"
+#include "mongo/db/geo/geonear.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/ops/query.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query_optimizer.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/s/d_logic.h"
 
 
 namespace mongo {
 
 namespace {
+    /**
+     * Runs a 2dsphere geoNear a batch at a time, holding the read lock only while it fills each
+     * batch.
+     */
+    class S2GeoNearCursor : public DocumentSourceNeedsMongod::GeoNearCursor {
+    public:
+        // Takes ownership of 'search', which must have saved its state.
+        S2GeoNearCursor(const NamespaceString& ns, S2GeoNearSearch* search)
+            : _ns(ns)
+            , _search(search)
+        {}
+
+        void nextBatch(long long maxResults, vector<BSONObj>* out) {
+            // As with DocumentSourceCursor, the shard version isn't checked again.
+            Lock::DBRead lk(_ns.ns());
+            Client::Context ctx(_ns.ns(), storageGlobalParams.dbpath, /*doVersion=*/false);
+
+            uassert(17327, "collection or index dropped during $geoNear",
+                    _search->restoreState());
+
+            const bool includeLocs = _search->getArguments().includeLocs;
+            int memUsageBytes = 0;
+            BSONObj obj;
+            double dist;
+            for (long long n = 0;
+                 n < maxResults
+                    && memUsageBytes <= MaxBytesToReturnToClientAtOnce
+                    && _search->getNext(&obj, &dist);
+                 n++) {
+                BSONObjBuilder result;
+                result.append("dis", dist);
+                if (includeLocs)
+                    _search->appendLocs(obj, &result);
+                result.append("obj", obj);
+                out->push_back(result.obj());
+                memUsageBytes += out->back().objsize();
+            }
+
+            _search->saveState();
+        }
+
+    private:
+        const NamespaceString _ns;
+        boost::scoped_ptr<S2GeoNearSearch> _search;
+    };
+
     class MongodImplementation : public DocumentSourceNeedsMongod::MongodInterface {
     public:
         DBClientBase* directClient() { return &_client; }
@@ -58,6 +109,31 @@ namespace {
             return nsd && nsd->isCapped();
         }
 
+        DocumentSourceNeedsMongod::GeoNearCursor* openGeoNear(const NamespaceString& ns,
+                                                              const BSONObj& geoNearCmd) {
+            Lock::DBRead lk(ns.ns());
+            Client::Context ctx(ns.ns(), storageGlobalParams.dbpath, /*doVersion=*/false);
+
+            // Leave the errors to the command: a missing collection, a bad limit and more than
+            // one geo index.  A 2d near search needs the limit up front, so it's run in one go.
+            NamespaceDetails* nsd = nsdetails(ns.ns());
+            if (!nsd || GeoNearArguments(geoNearCmd).numWanted < 0)
+                return NULL;
+
+            vector<int> idxs;
+            nsd->findIndexByType(IndexNames::GEO_2D, idxs);
+            if (!idxs.empty())
+                return NULL;
+
+            nsd->findIndexByType(IndexNames::GEO_2DSPHERE, idxs);
+            if (idxs.size() != 1)
+                return NULL;
+
+            auto_ptr<S2GeoNearSearch> search(new S2GeoNearSearch(nsd, idxs[0], geoNearCmd));
+            search->saveState();
+            return new S2GeoNearCursor(ns, search.release());
+        }
+
     private:
         DBDirectClient _client;
     };
@@ -80,6 +156,16 @@ namespace {
         }
 
         if (!sources.empty() && sources.front()->isValidInitialSource()) {
+            // A $match right after a $geoNear can drop documents before they are converted.
+            DocumentSourceGeoNear* geoNear =
+                dynamic_cast<DocumentSourceGeoNear*>(sources.front().get());
+            while (geoNear && sources.size() > 1) {
+                DocumentSourceMatch* match = dynamic_cast<DocumentSourceMatch*>(sources[1].get());
+                if (!match || !geoNear->absorbMatch(*match))
+                    break;
+                sources.erase(sources.begin() + 1);
+            }
+
             if (dynamic_cast<DocumentSourceMergeCursors*>(sources.front().get())) {
                 // Enable the hooks for setting up authentication on the subsequent internal
                 // connections we are going to create. This would normally have been done
@@ -218,7 +218,8 @@ namespace mongo {
                 struct {
                     bool refCounter : 1; // true if we need to refCount
                     bool shortStr : 1; // true if we are using short strings
-                    // reservedFlags: 6;
+                    unsigned char shortStrSize : 4; // only valid if shortStr
+                    // reservedFlags: 2;
                 };
 
                 // bytes 3-16;
@@ -226,8 +227,7 @@ namespace mongo {
                     unsigned char oid[12];
 
                     struct {
-                        char shortStrSize; // TODO Consider moving into flags union (4 bits)
-                        char shortStrStorage[16/*total bytes*/ - 3/*offset*/ - 1/*NUL byte*/];
+                        char shortStrStorage[16/*total bytes*/ - 2/*offset*/ - 1/*NUL byte*/];
                         union {
                             char nulTerminator;
                         };
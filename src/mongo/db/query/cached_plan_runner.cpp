@@ -30,6 +30,7 @@
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/canonical_query.h"
@@ -117,27 +118,17 @@ namespace mongo {
     void CachedPlanRunner::updateCache() {
         _updatedCache = true;
 
-        // We're done.  Update the cache.
-        PlanCache* cache = PlanCache::get(_canonicalQuery->ns());
+        // We're done running.  Update the cache.  The cache decides whether our performance has
+        // degraded enough that the plan should be evicted.
+        PlanCache& cache =
+            NamespaceDetailsTransient::get(_canonicalQuery->ns().c_str()).getPlanCache();
 
-        // TODO: Is this an error?
-        if (NULL == cache) { return; }
-
-        // TODO: How do we decide this?
-        bool shouldRemovePlan = false;
-
-        if (shouldRemovePlan) {
-            if (!cache->remove(*_canonicalQuery, *_cachedQuery->solution)) {
-                warning() << "Cached plan runner couldn't remove plan from cache.  Maybe"
-                    " somebody else did already?";
-                return;
-            }
-        }
-
-        // We're done running.  Update cache.
         auto_ptr<CachedSolutionFeedback> feedback(new CachedSolutionFeedback());
         feedback->stats = _exec->getStats();
-        cache->feedback(*_canonicalQuery, *_cachedQuery->solution, feedback.release());
+        if (!cache.feedback(*_canonicalQuery, *_cachedQuery->solution, feedback.release())) {
+            LOG(2) << "Cached plan runner couldn't find its plan in the cache.  Maybe somebody"
+                " removed it already?" << endl;
+        }
     }
 
 } // namespace mongo
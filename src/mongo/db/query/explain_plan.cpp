@@ -31,6 +31,32 @@
 #include "mongo/db/query/stage_types.h"
 #include "mongo/db/query/type_explain.h"
 
+namespace {
+
+    using mongo::StageType;
+
+    const char* stageTypeString(StageType type) {
+        switch (type) {
+        case mongo::STAGE_AND_HASH: return "AND_HASH";
+        case mongo::STAGE_AND_SORTED: return "AND_SORTED";
+        case mongo::STAGE_COLLSCAN: return "COLLSCAN";
+        case mongo::STAGE_FETCH: return "FETCH";
+        case mongo::STAGE_GEO_2D: return "GEO_2D";
+        case mongo::STAGE_GEO_NEAR_2D: return "GEO_NEAR_2D";
+        case mongo::STAGE_GEO_NEAR_2DSPHERE: return "GEO_NEAR_2DSPHERE";
+        case mongo::STAGE_IXSCAN: return "IXSCAN";
+        case mongo::STAGE_LIMIT: return "LIMIT";
+        case mongo::STAGE_OR: return "OR";
+        case mongo::STAGE_PROJECTION: return "PROJECTION";
+        case mongo::STAGE_SKIP: return "SKIP";
+        case mongo::STAGE_SORT: return "SORT";
+        case mongo::STAGE_SORT_MERGE: return "SORT_MERGE";
+        default: return "UNKNOWN";
+        }
+    }
+
+}  // namespace
+
 namespace mongo {
 
     Status explainPlan(const PlanStageStats& stats, TypeExplain** explain, bool fullDetails) {
@@ -124,10 +150,63 @@ namespace mongo {
         if (fullDetails) {
             res->setScanAndOrder(sortPresent);
             res->setNYields(root->common.yields);
+            res->setStats(statsToBSON(*root));
         }
 
         *explain = res.release();
         return Status::OK();
     }
 
+    BSONObj statsToBSON(const PlanStageStats& stats) {
+        BSONObjBuilder bob;
+        bob.append("type", stageTypeString(stats.stageType));
+        bob.appendNumber("works", static_cast<long long>(stats.common.works));
+        bob.appendNumber("advanced", static_cast<long long>(stats.common.advanced));
+        bob.appendNumber("needTime", static_cast<long long>(stats.common.needTime));
+        bob.appendNumber("needFetch", static_cast<long long>(stats.common.needFetch));
+        bob.appendNumber("yields", static_cast<long long>(stats.common.yields));
+        bob.appendNumber("invalidates", static_cast<long long>(stats.common.invalidates));
+        bob.appendBool("isEOF", stats.common.isEOF);
+        if (0 != stats.common.executionTimeMicros) {
+            bob.appendNumber("executionTimeMicros",
+                             static_cast<long long>(stats.common.executionTimeMicros));
+        }
+
+        const SpecificStats* specific = stats.specific.get();
+        if (NULL == specific) {
+            // No stage specific counters to show.
+        }
+        else if (STAGE_IXSCAN == stats.stageType) {
+            const IndexScanStats* spec = static_cast<const IndexScanStats*>(specific);
+            bob.append("indexName", spec->indexName);
+            bob.appendNumber("keysExamined", static_cast<long long>(spec->keysExamined));
+            bob.appendNumber("dupsDropped", static_cast<long long>(spec->dupsDropped));
+            bob.appendNumber("keysSkipped", static_cast<long long>(spec->keysSkipped));
+            bob.appendNumber("yieldMovedCursor", static_cast<long long>(spec->yieldMovedCursor));
+        }
+        else if (STAGE_FETCH == stats.stageType) {
+            const FetchStats* spec = static_cast<const FetchStats*>(specific);
+            // Every result a fetch advances was fetched unless its child already had the object.
+            bob.appendNumber("docsFetched",
+                             static_cast<long long>(stats.common.advanced - spec->alreadyHasObj));
+            bob.appendNumber("alreadyHasObj", static_cast<long long>(spec->alreadyHasObj));
+            bob.appendNumber("forcedFetches", static_cast<long long>(spec->forcedFetches));
+        }
+        else if (STAGE_SORT == stats.stageType) {
+            const SortStats* spec = static_cast<const SortStats*>(specific);
+            bob.appendNumber("forcedFetches", static_cast<long long>(spec->forcedFetches));
+            bob.appendNumber("spilledFiles", static_cast<long long>(spec->spilledFiles));
+        }
+
+        if (!stats.children.empty()) {
+            BSONArrayBuilder children(bob.subarrayStart("children"));
+            for (size_t i = 0; i < stats.children.size(); ++i) {
+                children.append(statsToBSON(*stats.children[i]));
+            }
+            children.doneFast();
+        }
+
+        return bob.obj();
+    }
+
 } // namespace mongo
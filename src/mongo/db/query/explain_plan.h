@@ -52,4 +52,11 @@ namespace mongo {
      */
     Status explainPlan(const PlanStageStats& stats, TypeExplain** explain, bool fullDetails);
 
+    /**
+     * Returns a description of every stage in the 'stats' tree: its type, the counters common to
+     * all stages, the most telling stage specific counters (keys examined, documents fetched,
+     * ...) and, under 'children', the same for each of its children.
+     */
+    BSONObj statsToBSON(const PlanStageStats& stats);
+
 } // namespace mongo
@@ -0,0 +1,135 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/idhack_runner.h"
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/projection_executor.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/query/parsed_projection.h"
+#include "mongo/db/query/type_explain.h"
+#include "mongo/db/queryutil.h"
+
+namespace mongo {
+
+    IDHackRunner::IDHackRunner(NamespaceDetails* nsd, LiteParsedQuery* query,
+                               ParsedProjection* proj)
+        : _nsd(nsd), _query(query), _proj(proj), _done(false), _found(false), _killed(false) {
+    }
+
+    IDHackRunner::~IDHackRunner() {
+    }
+
+    // static
+    bool IDHackRunner::supportsQuery(const LiteParsedQuery& query) {
+        return !query.isExplain()
+            && !query.showDiskLoc()
+            && !query.returnKey()
+            && !query.hasOption(QueryOption_CursorTailable)
+            && 0 == query.getSkip()
+            && query.getHint().isEmpty()
+            && query.getMin().isEmpty()
+            && query.getMax().isEmpty()
+            && isSimpleIdQuery(query.getFilter());
+    }
+
+    Runner::RunnerState IDHackRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
+        if (_killed) { return Runner::RUNNER_DEAD; }
+        if (_done) { return Runner::RUNNER_EOF; }
+        _done = true;
+
+        DiskLoc loc = Helpers::findById(_nsd, _query->getFilter());
+        if (loc.isNull()) { return Runner::RUNNER_EOF; }
+        _found = true;
+
+        WorkingSetMember member;
+        member.loc = loc;
+        member.obj = loc.obj();
+        member.state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+        if (NULL != _proj.get()) {
+            Status projStatus = ProjectionExecutor::apply(_proj.get(), &member);
+            if (!projStatus.isOK()) { return Runner::RUNNER_ERROR; }
+        }
+
+        if (NULL != objOut) { *objOut = member.obj; }
+        if (NULL != dlOut) { *dlOut = member.loc; }
+        return Runner::RUNNER_ADVANCED;
+    }
+
+    bool IDHackRunner::isEOF() {
+        return _killed || _done;
+    }
+
+    void IDHackRunner::saveState() {
+    }
+
+    bool IDHackRunner::restoreState() {
+        return !_killed;
+    }
+
+    void IDHackRunner::setYieldPolicy(Runner::YieldPolicy policy) {
+        // The lookup is one index probe and one fetch; there is nothing worth yielding for.
+    }
+
+    void IDHackRunner::invalidate(const DiskLoc& dl) {
+        // We don't hold on to DiskLocs between calls to getNext.
+    }
+
+    const std::string& IDHackRunner::ns() {
+        return _query->ns();
+    }
+
+    void IDHackRunner::kill() {
+        _killed = true;
+    }
+
+    Status IDHackRunner::getExplainPlan(TypeExplain** explain) const {
+        *explain = new TypeExplain;
+
+        (*explain)->setCursor("BtreeCursor _id_");
+        (*explain)->setScanAndOrder(false);
+        (*explain)->setIsMultiKey(false);
+        (*explain)->setIndexOnly(false);
+        (*explain)->setNYields(0);
+        (*explain)->setN(_found ? 1 : 0);
+        (*explain)->setNScanned(_done ? 1 : 0);
+        (*explain)->setNScannedObjects(_found ? 1 : 0);
+
+        TypeExplain* allPlans = new TypeExplain;
+        allPlans->setCursor("BtreeCursor _id_");
+        (*explain)->addToAllPlans(allPlans); // ownership xfer
+
+        return Status::OK();
+    }
+
+} // namespace mongo
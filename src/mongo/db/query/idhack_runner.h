@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/db/query/runner.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class LiteParsedQuery;
+    class NamespaceDetails;
+    class ParsedProjection;
+    class TypeExplain;
+
+    /**
+     * IDHackRunner answers an exact match on _id with a single _id index lookup and a fetch,
+     * without going through CanonicalQuery or the planner.  It never yields, so it has nothing
+     * to save across a yield and returns at most one document.
+     */
+    class IDHackRunner : public Runner {
+    public:
+
+        /**
+         * Takes ownership of 'query' and 'proj'.  'proj' may be NULL, in which case the whole
+         * document is returned.  'nsd' must have an _id index.
+         */
+        IDHackRunner(NamespaceDetails* nsd, LiteParsedQuery* query, ParsedProjection* proj);
+
+        virtual ~IDHackRunner();
+
+        /**
+         * Can 'query' be answered by an IDHackRunner?  True for an exact _id match with an
+         * optional projection and none of the options (explain, skip, hint, tailable, ...) that
+         * need the full query machinery.
+         */
+        static bool supportsQuery(const LiteParsedQuery& query);
+
+        virtual Runner::RunnerState getNext(BSONObj* objOut, DiskLoc* dlOut);
+
+        virtual bool isEOF();
+
+        virtual void saveState();
+
+        virtual bool restoreState();
+
+        virtual void setYieldPolicy(Runner::YieldPolicy policy);
+
+        virtual void invalidate(const DiskLoc& dl);
+
+        virtual const std::string& ns();
+
+        virtual void kill();
+
+        virtual Status getExplainPlan(TypeExplain** explain) const;
+
+    private:
+        NamespaceDetails* _nsd;
+        boost::scoped_ptr<LiteParsedQuery> _query;
+        boost::scoped_ptr<ParsedProjection> _proj;
+
+        // Have we done the lookup?
+        bool _done;
+
+        // Did the lookup find a document?  Only meaningful if _done.
+        bool _found;
+
+        bool _killed;
+    };
+
+}  // namespace mongo
@@ -396,19 +396,29 @@ namespace mongo {
     IndexBoundsChecker::Location IndexBoundsChecker::findIntervalForField(const BSONElement& elt,
             const OrderedIntervalList& oil, const int expectedDirection, size_t* newIntervalIndex) {
 
-        for (size_t i = 0; i < oil.intervals.size(); ++i) {
-            Location where = intervalCmp(oil.intervals[i], elt, expectedDirection);
-
-            // Intervals are ordered in the same direction as our keys.  The first interval we
-            // aren't ahead of is the one we're looking for.
-            if (AHEAD != where) {
-                *newIntervalIndex = i;
-                return where;
+        // Intervals are ordered in the same direction as our keys and don't overlap, so we're
+        // ahead of every interval before some point and of none after it.  The first interval
+        // we aren't ahead of is the one we're looking for.  Binary search for it, as a large
+        // $in makes a list of thousands of point intervals.
+        size_t low = 0;
+        size_t high = oil.intervals.size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (AHEAD == intervalCmp(oil.intervals[mid], elt, expectedDirection)) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
             }
         }
 
         // If we're here, we're ahead of all intervals.
-        return AHEAD;
+        if (low == oil.intervals.size()) {
+            return AHEAD;
+        }
+
+        *newIntervalIndex = low;
+        return intervalCmp(oil.intervals[low], elt, expectedDirection);
     }
 
 }  // namespace mongo
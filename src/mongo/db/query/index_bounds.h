@@ -209,7 +209,6 @@ namespace mongo {
          * If 'elt' cannot be advanced to any interval, return AHEAD.
          *
          * TODO(efficiency): Start search from a given index.
-         * TODO(efficiency): Binary search for the answer.
          */
         static Location findIntervalForField(const BSONElement &elt, const OrderedIntervalList& oil,
                                              const int expectedDirection, size_t* newIntervalIndex);
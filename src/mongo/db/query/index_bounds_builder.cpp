@@ -28,6 +28,8 @@
 
 #include "mongo/db/query/index_bounds_builder.h"
 
+#include <algorithm>
+
 #include "mongo/db/geo/geoconstants.h"
 #include "mongo/db/geo/s2common.h"
 #include "mongo/db/index/expression_index.h"
@@ -131,8 +133,9 @@ namespace mongo {
             BSONObj dataObj = bob.obj();
             verify(dataObj.isOwned());
             interval = makeRangeInterval(dataObj, true, true);
-            // XXX: only exact if not (null or array)
-            exact = true;
+            // XXX: only exact if not null.  An array operand isn't compared against the array
+            // field's key.
+            exact = (Array != dataElt.type());
         }
         else if (MatchExpression::LT == expr->matchType()) {
             const LTMatchExpression* node = static_cast<const LTMatchExpression*>(expr);
@@ -143,8 +146,9 @@ namespace mongo {
             BSONObj dataObj = bob.obj();
             verify(dataObj.isOwned());
             interval = makeRangeInterval(dataObj, true, false);
-            // XXX: only exact if not (null or array)
-            exact = true;
+            // XXX: only exact if not null.  An array operand isn't compared against the array
+            // field's key.
+            exact = (Array != dataElt.type());
         }
         else if (MatchExpression::GT == expr->matchType()) {
             const GTMatchExpression* node = static_cast<const GTMatchExpression*>(expr);
@@ -155,8 +159,9 @@ namespace mongo {
             BSONObj dataObj = bob.obj();
             verify(dataObj.isOwned());
             interval = makeRangeInterval(dataObj, false, true);
-            // XXX: only exact if not (null or array)
-            exact = true;
+            // XXX: only exact if not null.  An array operand isn't compared against the array
+            // field's key.
+            exact = (Array != dataElt.type());
         }
         else if (MatchExpression::GTE == expr->matchType()) {
             const GTEMatchExpression* node = static_cast<const GTEMatchExpression*>(expr);
@@ -168,8 +173,9 @@ namespace mongo {
             BSONObj dataObj = bob.obj();
             verify(dataObj.isOwned());
             interval = makeRangeInterval(dataObj, true, true);
-            // XXX: only exact if not (null or array)
-            exact = true;
+            // XXX: only exact if not null.  An array operand isn't compared against the array
+            // field's key.
+            exact = (Array != dataElt.type());
         }
         else if (MatchExpression::REGEX == expr->matchType()) {
             warning() << "building lazy bounds for " << expr->toString() << endl;
@@ -186,6 +192,10 @@ namespace mongo {
             exact = false;
         }
         else if (MatchExpression::MATCH_IN == expr->matchType()) {
+            const InMatchExpression* ime = static_cast<const InMatchExpression*>(expr);
+            if (translateIn(ime->getData(), isHashed, direction, oilOut, exactOut)) {
+                return;
+            }
             warning() << "building lazy bounds for " << expr->toString() << endl;
             interval = allValues();
             exact = false;
@@ -200,11 +210,6 @@ namespace mongo {
             interval = makeRangeInterval(dataObj, true, true);
             exact = false;
         }
-        else if (MatchExpression::MATCH_IN == expr->matchType()) {
-            warning() << "building lazy bounds for " << expr->toString() << endl;
-            interval = allValues();
-            exact = false;
-        }
         else if (MatchExpression::GEO == expr->matchType()) {
             const GeoMatchExpression* gme = static_cast<const GeoMatchExpression*>(expr);
             // Can only do this for 2dsphere.
@@ -234,6 +239,60 @@ namespace mongo {
         *exactOut = exact;
     }
 
+    namespace {
+
+        bool firstElementLessThan(const BSONObj& lhs, const BSONObj& rhs) {
+            return lhs.firstElement().woCompare(rhs.firstElement(), false) < 0;
+        }
+
+        bool firstElementEqual(const BSONObj& lhs, const BSONObj& rhs) {
+            return lhs.firstElement().woCompare(rhs.firstElement(), false) == 0;
+        }
+
+    }  // namespace
+
+    // static
+    bool IndexBoundsBuilder::translateIn(const ArrayFilterEntries& entries, bool isHashed,
+                                         int direction, OrderedIntervalList* oilOut,
+                                         bool* exactOut) {
+        // Regexes and array operands would need more than point intervals, and an empty $in
+        // has no interval to start a scan at.  The caller falls back to scanning every key.
+        if (entries.numRegexes() > 0 || entries.equalities().empty()) {
+            return false;
+        }
+
+        // The equalities are already sorted without duplicates, in the order of an ascending
+        // index.  Hashing them loses that order.
+        vector<BSONObj> points;
+        points.reserve(entries.equalities().size());
+        for (BSONElementSet::const_iterator it = entries.equalities().begin();
+             it != entries.equalities().end(); ++it) {
+            if (Array == it->type()) {
+                return false;
+            }
+            points.push_back(isHashed ? ExpressionMapping::hash(*it) : objFromElement(*it));
+        }
+
+        if (isHashed) {
+            std::sort(points.begin(), points.end(), firstElementLessThan);
+            points.erase(std::unique(points.begin(), points.end(), firstElementEqual),
+                         points.end());
+        }
+
+        if (-1 == direction) {
+            std::reverse(points.begin(), points.end());
+        }
+
+        oilOut->intervals.reserve(oilOut->intervals.size() + points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            oilOut->intervals.push_back(makePointInterval(points[i]));
+        }
+
+        // As with equality, null also matches missing fields and hashes can collide.
+        *exactOut = !entries.hasNull() && !isHashed;
+        return true;
+    }
+
     // static
     Interval IndexBoundsBuilder::makeRangeInterval(const BSONObj& obj, bool startInclusive,
                                                    bool endInclusive) {
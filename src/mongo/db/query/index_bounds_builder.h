@@ -92,6 +92,14 @@ namespace mongo {
         static void reverseInterval(Interval* ival);
 
         static Interval allValues();
+
+        /**
+         * Fills 'oilOut' with one point interval per value of a $in, sorted along 'direction'
+         * without duplicates, so that the scan seeks from value to value.  Returns false,
+         * leaving 'oilOut' alone, if the $in can't be expressed that way.
+         */
+        static bool translateIn(const ArrayFilterEntries& entries, bool isHashed, int direction,
+                                OrderedIntervalList* oilOut, bool* exactOut);
     };
 
 }  // namespace mongo
@@ -527,4 +527,41 @@ namespace {
         ASSERT(movePastKeyElts);
     }
 
+    TEST(IndexBoundsCheckerTest, ManyPointIntervals) {
+        // The bounds a large $in makes: points 0, 2, 4, ..., 1998.
+        OrderedIntervalList fooList("foo");
+        for (int i = 0; i < 1000; ++i) {
+            fooList.intervals.push_back(Interval(BSON("" << 2 * i << "" << 2 * i), true, true));
+        }
+
+        IndexBounds bounds;
+        bounds.fields.push_back(fooList);
+        IndexBoundsChecker it(&bounds, BSON("foo" << 1), 1);
+
+        int keyEltsToUse;
+        bool movePastKeyElts;
+        vector<const BSONElement*> elt(1);
+        vector<bool> inc(1);
+
+        IndexBoundsChecker::KeyState state;
+
+        // A key between two points seeks to the next one.
+        state = it.checkKey(BSON("" << 1001), &keyEltsToUse, &movePastKeyElts, &elt, &inc);
+        ASSERT_EQUALS(state, IndexBoundsChecker::MUST_ADVANCE);
+        ASSERT_EQUALS(keyEltsToUse, 0);
+        ASSERT_FALSE(movePastKeyElts);
+        ASSERT_EQUALS(elt[0]->numberInt(), 1002);
+        ASSERT(inc[0]);
+
+        // Keys on points are in the bounds.
+        state = it.checkKey(BSON("" << 1002), &keyEltsToUse, &movePastKeyElts, &elt, &inc);
+        ASSERT_EQUALS(state, IndexBoundsChecker::VALID);
+        state = it.checkKey(BSON("" << 1500), &keyEltsToUse, &movePastKeyElts, &elt, &inc);
+        ASSERT_EQUALS(state, IndexBoundsChecker::VALID);
+
+        // Past the last point we're done.
+        state = it.checkKey(BSON("" << 1999), &keyEltsToUse, &movePastKeyElts, &elt, &inc);
+        ASSERT_EQUALS(state, IndexBoundsChecker::DONE);
+    }
+
 }  // namespace
@@ -63,7 +63,8 @@ namespace mongo {
 
     LiteParsedQuery::LiteParsedQuery() : _wantMore(true), _explain(false), _snapshot(false),
                                          _returnKey(false), _showDiskLoc(false), _maxScan(0),
-                                         _maxTimeMS(0) { }
+                                         _maxTimeMS(0), _prefetchExtents(-1),
+                                         _allowDiskUse(false) { }
 
     Status LiteParsedQuery::init(const string& ns, int ntoskip, int ntoreturn, int queryOptions,
                                  const BSONObj& queryObj, const BSONObj& proj,
@@ -205,6 +206,17 @@ namespace mongo {
                     }
                     _maxTimeMS = maxTimeMS.getValue();
                 }
+                else if (str::equals("prefetchExtents", name)) {
+                    if (!e.isNumber() || e.numberInt() < 0) {
+                        return Status(ErrorCodes::BadValue,
+                                      "$prefetchExtents must be a non-negative number");
+                    }
+                    _prefetchExtents = e.numberInt();
+                }
+                else if (str::equals("allowDiskUse", name)) {
+                    // Won't throw.
+                    _allowDiskUse = e.trueValue();
+                }
             }
         }
         
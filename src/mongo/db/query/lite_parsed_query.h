@@ -80,6 +80,9 @@ namespace mongo {
         const BSONObj& getMax() const { return _max; }
         int getMaxScan() const { return _maxScan; }
         int getMaxTimeMS() const { return _maxTimeMS; }
+        // -1 if the query leaves it to the server
+        int getPrefetchExtents() const { return _prefetchExtents; }
+        bool allowDiskUse() const { return _allowDiskUse; }
         
     private:
         LiteParsedQuery();
@@ -107,6 +110,8 @@ namespace mongo {
         BSONObj _hint;
         int _maxScan;
         int _maxTimeMS;
+        int _prefetchExtents;
+        bool _allowDiskUse;
     };
 
 } // namespace mongo
@@ -32,14 +32,53 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/explain_plan.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/type_explain.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * How many results the client asks for in its first batch.  If ntoreturn is zero we
+         * return up to 101 of them; see new_find.cpp.
+         */
+        size_t firstBatchSize(const LiteParsedQuery& pq) {
+            int numToReturn = pq.getNumToReturn();
+            if (0 == numToReturn) {
+                return 101;
+            }
+            if (numToReturn < 0) {
+                numToReturn = -numToReturn;
+            }
+            return static_cast<size_t>(numToReturn) + pq.getSkip();
+        }
+
+        /**
+         * Does the tree rooted at 'node' hash its input?  An AND_HASH fails if its first child
+         * doesn't fit in memory, which may not show until after the plan competition.
+         */
+        bool hasAndHashStage(const PlanStageStats& stats) {
+            if (STAGE_AND_HASH == stats.stageType) { return true; }
+            for (size_t i = 0; i < stats.children.size(); ++i) {
+                if (hasAndHashStage(*stats.children[i])) { return true; }
+            }
+            return false;
+        }
+
+        bool hasAndHashStage(const CandidatePlan& candidate) {
+            scoped_ptr<PlanStageStats> stats(candidate.root->getStats());
+            return hasAndHashStage(*stats);
+        }
+
+    }  // namespace
+
     MultiPlanRunner::MultiPlanRunner(CanonicalQuery* query)
         : _killed(false), _failure(false), _failureCount(0), _policy(Runner::YIELD_MANUAL),
           _query(query) { }
@@ -70,6 +109,7 @@ namespace mongo {
 
         if (NULL != _bestPlan) {
             _bestPlan->setYieldPolicy(policy);
+            if (NULL != _backupPlan) { _backupPlan->setYieldPolicy(policy); }
         } else {
             // Still running our candidates and doing our own yielding.
             if (Runner::YIELD_MANUAL == policy) {
@@ -86,6 +126,7 @@ namespace mongo {
 
         if (NULL != _bestPlan) {
             _bestPlan->saveState();
+            if (NULL != _backupPlan) { _backupPlan->saveState(); }
         }
         else {
             allPlansSaveState();
@@ -96,6 +137,10 @@ namespace mongo {
         if (_failure || _killed) { return false; }
 
         if (NULL != _bestPlan) {
+            if (NULL != _backupPlan && !_backupPlan->restoreState()) {
+                // Nothing to fall back on, but the winner may still be fine.
+                dropBackupPlan();
+            }
             return _bestPlan->restoreState();
         }
         else {
@@ -116,6 +161,16 @@ namespace mongo {
                     WorkingSetCommon::fetchAndInvalidateLoc(member);
                 }
             }
+            if (NULL != _backupPlan) {
+                _backupPlan->invalidate(dl);
+                for (deque<WorkingSetID>::iterator it = _backupAlreadyProduced.begin();
+                     it != _backupAlreadyProduced.end(); ++it) {
+                    WorkingSetMember* member = _backupPlan->getWorkingSet()->get(*it);
+                    if (member->hasLoc() && member->loc == dl) {
+                        WorkingSetCommon::fetchAndInvalidateLoc(member);
+                    }
+                }
+            }
         }
         else {
             for (size_t i = 0; i < _candidates.size(); ++i) {
@@ -145,6 +200,7 @@ namespace mongo {
     void MultiPlanRunner::kill() {
         _killed = true;
         if (NULL != _bestPlan) { _bestPlan->kill(); }
+        if (NULL != _backupPlan) { _backupPlan->kill(); }
     }
 
     Runner::RunnerState MultiPlanRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
@@ -197,21 +253,83 @@ namespace mongo {
             return Runner::RUNNER_ADVANCED;
         }
 
-        return _bestPlan->getNext(objOut, dlOut);
+        RunnerState state = _bestPlan->getNext(objOut, dlOut);
+
+        if (NULL != _backupPlan) {
+            if (Runner::RUNNER_ERROR == state) {
+                // The winner failed before producing anything, so nothing has been returned that
+                // the backup could produce again.
+                switchToBackupPlan();
+                return getNext(objOut, dlOut);
+            }
+            if (Runner::RUNNER_ADVANCED == state) {
+                // The winner has made it past its hashing.  Results have been returned, so we can
+                // no longer switch plans.
+                dropBackupPlan();
+            }
+        }
+
+        return state;
+    }
+
+    void MultiPlanRunner::switchToBackupPlan() {
+        verify(NULL != _backupPlan);
+        verify(_alreadyProduced.empty());
+
+        // The cached choice may fail the same way, so let the next query plan afresh.
+        if (PlanCache::shouldCacheQuery(*_query)) {
+            NamespaceDetailsTransient::get(_query->ns().c_str()).getPlanCache().remove(*_query);
+        }
+
+        // The failed winner becomes one more rejected candidate in explain, with the stats it
+        // failed with.
+        PlanStageStats* failedStats = _bestPlan->getStats();
+        if (NULL != failedStats) {
+            _candidateStats.push_back(failedStats);
+        }
+        _bestPlanTrialStats.swap(_backupPlanTrialStats);
+
+        _bestPlan.swap(_backupPlan);
+        _alreadyProduced.swap(_backupAlreadyProduced);
+        _bestSolution.swap(_backupSolution);
+        dropBackupPlan();
+    }
+
+    void MultiPlanRunner::dropBackupPlan() {
+        _backupPlan.reset();
+        _backupAlreadyProduced.clear();
+        _backupSolution.reset();
+        _backupPlanTrialStats.reset();
     }
 
     bool MultiPlanRunner::pickBestPlan(size_t* out) {
         static const int timesEachPlanIsWorked = 100;
 
+        // A plan that has produced the client's first batch has shown all we need to see, so
+        // there's no point in buffering more results from every plan.  Plans with a blocking
+        // sort have nothing to show until they're done reading their input, which the ranker
+        // takes into account.
+        size_t numResults = firstBatchSize(_query->getParsed());
+
         // Run each plan some number of times.
+        size_t earlyWinner = _candidates.size();
         for (int i = 0; i < timesEachPlanIsWorked; ++i) {
-            bool moreToDo = workAllPlans();
+            bool moreToDo = workAllPlans(numResults, &earlyWinner);
             if (!moreToDo) { break; }
         }
 
         if (_failure || _killed) { return false; }
 
-        size_t bestChild = PlanRanker::pickBestPlan(_candidates, NULL);
+        // A plan that finished the competition early wins outright.  Otherwise rank them.
+        auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        size_t bestChild;
+        if (earlyWinner < _candidates.size()) {
+            bestChild = earlyWinner;
+            why->statsOfWinner = _candidates[bestChild].root->getStats();
+        }
+        else {
+            bestChild = PlanRanker::pickBestPlan(_candidates, why.get());
+        }
 
         // Run the best plan.  Store it.
         _bestPlan.reset(new PlanExecutor(_candidates[bestChild].ws,
@@ -222,21 +340,55 @@ namespace mongo {
         // XXX
         // cout << "Winning solution:\n" << _bestSolution->toString() << endl;
 
-        // TODO:
-        // Store the choice we just made in the cache.
-        // QueryPlanCache* cache = PlanCache::get(somenamespace);
-        // cache->add(_query, *_candidates[bestChild]->solution, decision->bestPlanStats);
-        // delete decision;
+        // An AND_HASH winner that hasn't produced anything yet may still run out of memory while
+        // it hashes.  Keep the best plan without one, if any, to fall back on.
+        size_t backupChild = _candidates.size();
+        if (_alreadyProduced.empty() && hasAndHashStage(_candidates[bestChild])) {
+            vector<CandidatePlan> backupCandidates;
+            vector<size_t> backupIndices;
+            for (size_t i = 0; i < _candidates.size(); ++i) {
+                if (_candidates[i].failed) { continue; }
+                if (hasAndHashStage(_candidates[i])) { continue; }
+                backupCandidates.push_back(_candidates[i]);
+                backupIndices.push_back(i);
+            }
+            if (!backupCandidates.empty()) {
+                backupChild = backupIndices[PlanRanker::pickBestPlan(backupCandidates, NULL)];
+                CandidatePlan& backup = _candidates[backupChild];
+                _backupPlan.reset(new PlanExecutor(backup.ws, backup.root));
+                _backupPlan->setYieldPolicy(_policy);
+                _backupAlreadyProduced = backup.results;
+                _backupSolution.reset(backup.solution);
+            }
+        }
+
+        // Store the choice we just made in the cache.  If a plan failed during the competition
+        // the ranking may not reflect what the winner is up against, so don't remember it.
+        if (0 == _failureCount && PlanCache::shouldCacheQuery(*_query)) {
+            PlanCache& cache = NamespaceDetailsTransient::get(_query->ns().c_str()).getPlanCache();
+            cache.add(*_query, *_bestSolution, why.release());
+        }
 
         // Clear out the candidate plans, leaving only stats as we're all done w/them.
         for (size_t i = 0; i < _candidates.size(); ++i) {
-            if (i == bestChild) { continue; }
-            delete _candidates[i].solution;
-
             // Remember the stats for the candidate plan because we always show it on an
             // explain. (The {verbose:false} in explain() is client-side trick; we always
             // generate a "verbose" explain.)
             PlanStageStats* stats = _candidates[i].root->getStats();
+            if (stats) {
+                stats->common.executionTimeMicros = _candidates[i].trialTimeMicros;
+            }
+
+            if (i == bestChild) {
+                _bestPlanTrialStats.reset(stats);
+                continue;
+            }
+            if (i == backupChild) {
+                _backupPlanTrialStats.reset(stats);
+                continue;
+            }
+            delete _candidates[i].solution;
+
             if (stats) {
                 _candidateStats.push_back(stats);
             }
@@ -251,17 +403,25 @@ namespace mongo {
         return true;
     }
 
-    bool MultiPlanRunner::workAllPlans() {
+    bool MultiPlanRunner::workAllPlans(size_t numResults, size_t* earlyWinner) {
         for (size_t i = 0; i < _candidates.size(); ++i) {
             CandidatePlan& candidate = _candidates[i];
             if (candidate.failed) { continue; }
 
             WorkingSetID id;
+            Timer timer;
             PlanStage::StageState state = candidate.root->work(&id);
+            candidate.trialTimeMicros += timer.micros();
 
             if (PlanStage::ADVANCED == state) {
                 // Save result for later.
                 candidate.results.push_back(id);
+
+                // This plan has the first batch ready, before any other plan.  It wins.
+                if (candidate.results.size() >= numResults) {
+                    *earlyWinner = i;
+                    return false;
+                }
             }
             else if (PlanStage::NEED_TIME == state) {
                 // Fall through to yield check at end of large conditional.
@@ -302,7 +462,7 @@ namespace mongo {
             }
             else if (PlanStage::IS_EOF == state) {
                 // First plan to hit EOF wins automatically.  Stop evaluating other plans.
-                // Assumes that the ranking will pick this plan.
+                *earlyWinner = i;
                 return false;
             }
             else {
@@ -373,6 +533,9 @@ namespace mongo {
         TypeExplain* chosenPlan = NULL;
         explainPlan(*stats, &chosenPlan, false /* no full details */);
         if (chosenPlan) {
+            if (_bestPlanTrialStats.get()) {
+                chosenPlan->setStats(statsToBSON(*_bestPlanTrialStats));
+            }
             (*explain)->addToAllPlans(chosenPlan);
         }
         (*explain)->setNScannedObjectsAllPlans((*explain)->getNScannedObjects());
@@ -388,6 +551,7 @@ namespace mongo {
             }
 
             // TODO: we only need this in "explain({verbose:true}) mode.
+            candidateExplain->setStats(statsToBSON(**it));
             (*explain)->addToAllPlans(candidateExplain); // ownership xfer
 
             (*explain)->setNScannedObjectsAllPlans((*explain)->getNScannedObjectsAllPlans() +
@@ -98,18 +98,32 @@ namespace mongo {
          * plan. Caller takes ownership of '*explain'. Otherwise, return a status describing
          * the error.
          *
-         * TOOD: fill in the explain of all candidate plans
+         * Every candidate plan, the winner included, is listed under 'allPlans' with the stats of
+         * its stages as of the end of the plan competition.
          */
         virtual Status getExplainPlan(TypeExplain** explain) const;
 
     private:
         /**
-         * Have all our candidate plans do something.
+         * Have all our candidate plans do something.  Returns false once the competition is
+         * over: a plan hit EOF or produced 'numResults' results, or everything failed.  A plan
+         * that hit EOF or produced 'numResults' results is the winner, and its index is put in
+         * '*earlyWinner'.
          */
-        bool workAllPlans();
+        bool workAllPlans(size_t numResults, size_t* earlyWinner);
         void allPlansSaveState();
         void allPlansRestoreState();
 
+        /**
+         * The winner failed before returning anything.  Carry on with the backup plan instead.
+         */
+        void switchToBackupPlan();
+
+        /**
+         * The backup plan is no longer needed, or can no longer be used.
+         */
+        void dropBackupPlan();
+
         // Were we killed by an invalidate?
         bool _killed;
 
@@ -138,12 +152,23 @@ namespace mongo {
         // ...and the solution, for caching.
         boost::scoped_ptr<QuerySolution> _bestSolution;
 
+        // If the winner has an AND_HASH, which can fail when its first child doesn't fit in
+        // memory, the best plan without one.  Kept until the winner returns a result.
+        boost::scoped_ptr<PlanExecutor> _backupPlan;
+        std::deque<WorkingSetID> _backupAlreadyProduced;
+        boost::scoped_ptr<QuerySolution> _backupSolution;
+        boost::scoped_ptr<PlanStageStats> _backupPlanTrialStats;
+
         // Candidate plans.
         std::vector<CandidatePlan> _candidates;
 
         // Candidate plans' stats. Owned here.
         std::vector<PlanStageStats*> _candidateStats;
 
+        // The winner's stats as of the end of the plan competition, to compare with the
+        // candidates' stats.
+        boost::scoped_ptr<PlanStageStats> _bestPlanTrialStats;
+
         // Yielding policy we use when we're running candidates.
         boost::scoped_ptr<RunnerYieldPolicy> _yieldPolicy;
 
@@ -38,12 +38,15 @@
 #include "mongo/db/query/cached_plan_runner.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/eof_runner.h"
+#include "mongo/db/query/idhack_runner.h"
 #include "mongo/db/query/multi_plan_runner.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/projection_parser.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/single_solution_runner.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/db/query/type_explain.h"
+#include "mongo/db/queryutil.h"
 #include "mongo/db/repl/repl_reads_ok.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
@@ -60,7 +63,6 @@ namespace {
     // a little bit more than this, it is a threshold rather than a limit.
     static const int32_t MaxBytesToReturnToClientAtOnce = 4 * 1024 * 1024;
 
-    // TODO: Remove this or use it.
     bool hasIndexSpecifier(const mongo::LiteParsedQuery& pq) {
         return !pq.getHint().isEmpty() || !pq.getMin().isEmpty() || !pq.getMax().isEmpty();
     }
@@ -113,24 +115,6 @@ namespace mongo {
         verify(rawCanonicalQuery);
         auto_ptr<CanonicalQuery> canonicalQuery(*rawCanonicalQuery);
 
-        // Try to look up a cached solution for the query.
-        // TODO: Can the cache have negative data about a solution?
-        PlanCache* localCache = PlanCache::get(canonicalQuery->ns());
-        if (NULL != localCache) {
-            CachedSolution* cs = localCache->get(*canonicalQuery);
-            if (NULL != cs) {
-                // We have a cached solution.  Hand the canonical query and cached solution off to
-                // the cached plan runner, which takes ownership of both.
-                WorkingSet* ws;
-                PlanStage* root;
-                verify(StageBuilder::build(*cs->solution, &root, &ws));
-                *out = new CachedPlanRunner(canonicalQuery.release(), cs, root, ws);
-                return Status::OK();
-            }
-        }
-
-        // No entry in cache for the query.  We have to solve the query ourself.
-
         // Get the indices that we could possibly use.
         NamespaceDetails* nsd = nsdetails(canonicalQuery->ns().c_str());
 
@@ -203,7 +187,71 @@ namespace mongo {
             return Status::OK();
         }
         else {
-            // Many solutions.  Let the MultiPlanRunner pick the best, update the cache, and so on.
+            // Many solutions.  If we've seen a query of this shape before, the cache tells us which
+            // one won the last plan competition and we can skip racing them.
+            PlanCache& cache =
+                NamespaceDetailsTransient::get(canonicalQuery->ns().c_str()).getPlanCache();
+
+            // An index pinned for this shape overrides the plan competition, like a hint.  Unlike
+            // cached plans, pins apply to explain so that their effect can be seen.
+            BSONObj pinnedIndex;
+            if (!hasIndexSpecifier(canonicalQuery->getParsed())
+                && cache.getPin(*canonicalQuery, &pinnedIndex)) {
+                size_t chosen = solutions.size();
+                for (size_t i = 0; i < solutions.size(); ++i) {
+                    if (PlanCache::solutionUsesIndex(*solutions[i], pinnedIndex)) {
+                        chosen = i;
+                        break;
+                    }
+                }
+
+                if (chosen < solutions.size()) {
+                    for (size_t i = 0; i < solutions.size(); ++i) {
+                        if (i != chosen) { delete solutions[i]; }
+                    }
+
+                    WorkingSet* ws;
+                    PlanStage* root;
+                    verify(StageBuilder::build(*solutions[chosen], &root, &ws));
+                    *out = new SingleSolutionRunner(canonicalQuery.release(), solutions[chosen],
+                                                    root, ws);
+                    return Status::OK();
+                }
+            }
+
+            if (PlanCache::shouldCacheQuery(*canonicalQuery)) {
+                auto_ptr<CachedSolution> cs(cache.get(*canonicalQuery));
+                if (NULL != cs.get()) {
+                    size_t chosen = solutions.size();
+                    for (size_t i = 0; i < solutions.size(); ++i) {
+                        if (PlanCache::getSolutionKey(*solutions[i]) == cs->solutionKey) {
+                            chosen = i;
+                            break;
+                        }
+                    }
+
+                    if (chosen < solutions.size()) {
+                        cs->solution.reset(solutions[chosen]);
+                        for (size_t i = 0; i < solutions.size(); ++i) {
+                            if (i != chosen) { delete solutions[i]; }
+                        }
+
+                        WorkingSet* ws;
+                        PlanStage* root;
+                        verify(StageBuilder::build(*cs->solution, &root, &ws));
+                        // Takes ownership of all arguments.
+                        *out = new CachedPlanRunner(canonicalQuery.release(), cs.release(), root,
+                                                    ws);
+                        return Status::OK();
+                    }
+
+                    // The cached solution isn't one of our candidates anymore, eg. because its
+                    // index is no longer usable for this query.  Forget it and re-race.
+                    cache.remove(*canonicalQuery);
+                }
+            }
+
+            // Let the MultiPlanRunner pick the best, update the cache, and so on.
             auto_ptr<MultiPlanRunner> mpr(new MultiPlanRunner(canonicalQuery.release()));
             for (size_t i = 0; i < solutions.size(); ++i) {
                 WorkingSet* ws;
@@ -383,6 +431,79 @@ namespace mongo {
         Runner* _runner;
     };
 
+    /**
+     * Answers an exact match on _id with an IDHackRunner and writes the reply into 'result'
+     * directly, skipping canonicalization, planning and the ClientCursor machinery.
+     *
+     * Returns false without touching 'result' if the query must take the regular path: it isn't
+     * a plain _id match, the collection or its _id index doesn't exist, or the projection can't
+     * be applied.
+     */
+    bool runIdHackQuery(QueryMessage& q, CurOp& curop, Message& result) {
+        // Queries wrapped in $query never qualify, so this check is all they pay.
+        if (!isSimpleIdQuery(q.query)) { return false; }
+
+        NamespaceDetails* nsd = nsdetails(q.ns);
+        if (NULL == nsd || nsd->findIdIndex() < 0) { return false; }
+
+        LiteParsedQuery* rawLpq;
+        if (!LiteParsedQuery::make(q, &rawLpq).isOK()) { return false; }
+        auto_ptr<LiteParsedQuery> lpq(rawLpq);
+        if (!IDHackRunner::supportsQuery(*lpq)) { return false; }
+
+        ParsedProjection* rawProj = NULL;
+        if (!lpq->getProj().isEmpty()
+            && !ProjectionParser::parseFindSyntax(lpq->getProj(), &rawProj).isOK()) {
+            return false;
+        }
+
+        curop.setMaxTimeMicros(static_cast<unsigned long long>(lpq->getMaxTimeMS()) * 1000);
+        killCurrentOp.checkForInterrupt(); // May trigger maxTimeAlwaysTimeOut fail point.
+        replVerifyReadsOk(lpq.get());
+
+        // Takes ownership of the parsed query and projection.
+        IDHackRunner runner(nsd, lpq.release(), rawProj);
+
+        BSONObj obj;
+        Runner::RunnerState state = runner.getNext(&obj, NULL);
+        if (Runner::RUNNER_ERROR == state) {
+            // Let the regular path report whatever went wrong.
+            return false;
+        }
+
+        bool found = (Runner::RUNNER_ADVANCED == state);
+
+        // A document that is still being migrated off of this shard isn't ours to return.
+        if (found && shardingState.needCollectionMetadata(q.ns)) {
+            CollectionMetadataPtr collMetadata = shardingState.getCollectionMetadata(q.ns);
+            if (collMetadata) {
+                KeyPattern kp(collMetadata->getKeyPattern());
+                found = collMetadata->keyBelongsToMe(kp.extractSingleKey(obj));
+            }
+        }
+
+        BufBuilder bb(sizeof(QueryResult) + (found ? obj.objsize() : 0) + 32);
+        bb.skip(sizeof(QueryResult));
+        if (found) {
+            bb.appendBuf((void*)obj.objdata(), obj.objsize());
+        }
+
+        result.appendData(bb.buf(), bb.len());
+        bb.decouple();
+
+        QueryResult* qr = static_cast<QueryResult*>(result.header());
+        qr->cursorId = 0;
+        qr->setResultFlagsToOk();
+        qr->setOperation(opReply);
+        qr->startingFrom = 0;
+        qr->nReturned = found ? 1 : 0;
+
+        curop.debug().idhack = true;
+        curop.debug().cursorid = -1;
+        curop.debug().nreturned = qr->nReturned;
+        return true;
+    }
+
     /**
      * This is called by db/ops/query.cpp.  This is the entry point for answering a query.
      */
@@ -390,6 +511,10 @@ namespace mongo {
         // This is a read lock.
         Client::ReadContext ctx(q.ns, storageGlobalParams.dbpath);
 
+        if (runIdHackQuery(q, curop, result)) {
+            return "";
+        }
+
         // Parse, canonicalize, plan, transcribe, and get a runner.
         Runner* rawRunner;
         CanonicalQuery* cq;
@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -106,6 +107,13 @@ namespace mongo {
         // ...or you include other fields, which can be ordered.
         // UNITTEST 11738048
         vector<string> _includedFields;
+
+        // The included fields other than _id, for looking up the names of a document's fields.
+        StringMap<bool> _includedFieldSet;
+
+        // True if none of the included fields is dotted, so that an inclusion can be applied in
+        // one pass over the document's top-level fields.
+        bool _includedTopLevelOnly;
     };
 
 }  // namespace mongo
@@ -0,0 +1,555 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/plan_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+
+    // How many cached runs of a plan we remember.
+    const size_t kMaxFeedback = 20;
+
+    // A cached run must have done at least this much work before we judge it.  Tiny queries are
+    // too noisy to say anything about a plan.
+    const uint64_t kMinWorksForEviction = 1000;
+
+    // A cached plan is evicted if it becomes this many times less productive than it was during
+    // the plan competition.
+    const double kDegradationFactor = 10.0;
+
+    const char* encodeMatchType(MatchExpression::MatchType type) {
+        switch (type) {
+        case MatchExpression::AND: return "an";
+        case MatchExpression::OR: return "or";
+        case MatchExpression::NOR: return "nr";
+        case MatchExpression::NOT: return "nt";
+        case MatchExpression::ALL: return "al";
+        case MatchExpression::ELEM_MATCH_OBJECT: return "eo";
+        case MatchExpression::ELEM_MATCH_VALUE: return "ev";
+        case MatchExpression::SIZE: return "sz";
+        case MatchExpression::LTE: return "le";
+        case MatchExpression::LT: return "lt";
+        case MatchExpression::EQ: return "eq";
+        case MatchExpression::GT: return "gt";
+        case MatchExpression::GTE: return "ge";
+        case MatchExpression::REGEX: return "re";
+        case MatchExpression::MOD: return "mo";
+        case MatchExpression::EXISTS: return "ex";
+        case MatchExpression::MATCH_IN: return "in";
+        case MatchExpression::NIN: return "ni";
+        case MatchExpression::TYPE_OPERATOR: return "ty";
+        case MatchExpression::GEO: return "go";
+        case MatchExpression::WHERE: return "wh";
+        case MatchExpression::ATOMIC: return "at";
+        case MatchExpression::ALWAYS_FALSE: return "af";
+        case MatchExpression::GEO_NEAR: return "gn";
+        }
+        return "??";
+    }
+
+    /**
+     * Appends the shape of 'tree' to 'keyBuilder'.  The children of commutative nodes are sorted
+     * so that {a: 1, b: 1} and {b: 1, a: 1} have the same shape.
+     */
+    void encodeMatchExpression(const MatchExpression* tree, StringBuilder* keyBuilder) {
+        *keyBuilder << encodeMatchType(tree->matchType());
+        StringData path = tree->path();
+        if (!path.empty()) {
+            *keyBuilder << path;
+        }
+
+        if (0 == tree->numChildren()) {
+            return;
+        }
+
+        std::vector<std::string> children;
+        for (size_t i = 0; i < tree->numChildren(); ++i) {
+            StringBuilder childBuilder;
+            encodeMatchExpression(tree->getChild(i), &childBuilder);
+            children.push_back(childBuilder.str());
+        }
+
+        MatchExpression::MatchType type = tree->matchType();
+        if (MatchExpression::AND == type || MatchExpression::OR == type
+            || MatchExpression::NOR == type) {
+            std::sort(children.begin(), children.end());
+        }
+
+        *keyBuilder << '[';
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i > 0) { *keyBuilder << ','; }
+            *keyBuilder << children[i];
+        }
+        *keyBuilder << ']';
+    }
+
+    /**
+     * Fills 'out' with the children of 'node' in order.
+     */
+    void getSolutionChildren(const QuerySolutionNode* node,
+                             std::vector<const QuerySolutionNode*>* out) {
+        switch (node->getType()) {
+        case STAGE_AND_HASH: {
+            const AndHashNode* ahn = static_cast<const AndHashNode*>(node);
+            out->insert(out->end(), ahn->children.begin(), ahn->children.end());
+            break;
+        }
+        case STAGE_AND_SORTED: {
+            const AndSortedNode* asn = static_cast<const AndSortedNode*>(node);
+            out->insert(out->end(), asn->children.begin(), asn->children.end());
+            break;
+        }
+        case STAGE_OR: {
+            const OrNode* orn = static_cast<const OrNode*>(node);
+            out->insert(out->end(), orn->children.begin(), orn->children.end());
+            break;
+        }
+        case STAGE_SORT_MERGE: {
+            const MergeSortNode* msn = static_cast<const MergeSortNode*>(node);
+            out->insert(out->end(), msn->children.begin(), msn->children.end());
+            break;
+        }
+        case STAGE_FETCH:
+            out->push_back(static_cast<const FetchNode*>(node)->child.get());
+            break;
+        case STAGE_PROJECTION:
+            out->push_back(static_cast<const ProjectionNode*>(node)->child.get());
+            break;
+        case STAGE_SORT:
+            out->push_back(static_cast<const SortNode*>(node)->child.get());
+            break;
+        case STAGE_LIMIT:
+            out->push_back(static_cast<const LimitNode*>(node)->child.get());
+            break;
+        case STAGE_SKIP:
+            out->push_back(static_cast<const SkipNode*>(node)->child.get());
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * Returns the key pattern of the index 'node' reads, or BSONObj() if it doesn't read one.
+     */
+    BSONObj getIndexKeyPattern(const QuerySolutionNode* node) {
+        switch (node->getType()) {
+        case STAGE_IXSCAN:
+            return static_cast<const IndexScanNode*>(node)->indexKeyPattern;
+        case STAGE_GEO_2D:
+            return static_cast<const Geo2DNode*>(node)->indexKeyPattern;
+        case STAGE_GEO_NEAR_2D:
+            return static_cast<const GeoNear2DNode*>(node)->indexKeyPattern;
+        case STAGE_GEO_NEAR_2DSPHERE:
+            return static_cast<const GeoNear2DSphereNode*>(node)->indexKeyPattern;
+        default:
+            return BSONObj();
+        }
+    }
+
+    void encodeSolutionNode(const QuerySolutionNode* node, StringBuilder* keyBuilder) {
+        *keyBuilder << static_cast<int>(node->getType());
+
+        if (STAGE_COLLSCAN == node->getType()) {
+            *keyBuilder << ':' << static_cast<const CollectionScanNode*>(node)->direction;
+        }
+        else if (STAGE_IXSCAN == node->getType()) {
+            const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+            *keyBuilder << ':' << isn->indexKeyPattern.toString() << ':' << isn->direction;
+        }
+        else {
+            BSONObj keyPattern = getIndexKeyPattern(node);
+            if (!keyPattern.isEmpty()) {
+                *keyBuilder << ':' << keyPattern.toString();
+            }
+        }
+
+        std::vector<const QuerySolutionNode*> children;
+        getSolutionChildren(node, &children);
+        if (children.empty()) {
+            return;
+        }
+
+        *keyBuilder << '[';
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i > 0) { *keyBuilder << ','; }
+            encodeSolutionNode(children[i], keyBuilder);
+        }
+        *keyBuilder << ']';
+    }
+
+    /**
+     * Returns true if every leaf of the tree rooted at 'node' reads the index 'keyPattern'.  The
+     * key pattern {$natural: 1} stands for a collection scan.
+     */
+    bool readsOnlyIndex(const QuerySolutionNode* node, const BSONObj& keyPattern) {
+        if (STAGE_COLLSCAN == node->getType()) {
+            return str::equals(keyPattern.firstElementFieldName(), "$natural");
+        }
+
+        BSONObj nodeKeyPattern = getIndexKeyPattern(node);
+        if (!nodeKeyPattern.isEmpty()) {
+            return nodeKeyPattern == keyPattern;
+        }
+
+        std::vector<const QuerySolutionNode*> children;
+        getSolutionChildren(node, &children);
+        if (children.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (!readsOnlyIndex(children[i], keyPattern)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendCommonStats(const CommonStats& stats, BSONObjBuilder* out) {
+        out->appendNumber("works", static_cast<long long>(stats.works));
+        out->appendNumber("advanced", static_cast<long long>(stats.advanced));
+        out->appendNumber("needTime", static_cast<long long>(stats.needTime));
+        out->appendNumber("needFetch", static_cast<long long>(stats.needFetch));
+        out->appendNumber("yields", static_cast<long long>(stats.yields));
+        out->appendBool("isEOF", stats.isEOF);
+    }
+
+    double productivity(const CommonStats& stats) {
+        if (0 == stats.works) { return 0; }
+        return static_cast<double>(stats.advanced) / static_cast<double>(stats.works);
+    }
+
+}  // namespace
+
+namespace mongo {
+
+    // Maximum number of query shapes cached per collection.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
+
+    // Number of writes to a collection after which its plan cache is flushed.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
+
+    //
+    // PlanCacheEntry
+    //
+
+    PlanCacheEntry::PlanCacheEntry(const CanonicalQuery& query, const std::string& solnKey,
+                                   PlanRankingDecision* why)
+        : query(query.getQueryObj().getOwned()),
+          sort(query.getParsed().getSort().getOwned()),
+          projection(query.getParsed().getProj().getOwned()),
+          solutionKey(solnKey),
+          decision(why),
+          numHits(0) { }
+
+    PlanCacheEntry::~PlanCacheEntry() {
+        for (size_t i = 0; i < feedback.size(); ++i) {
+            delete feedback[i];
+        }
+    }
+
+    //
+    // PlanCache
+    //
+
+    PlanCache::PlanCache() : _mutex("PlanCache"), _writeOpsSinceFlush(0) { }
+
+    PlanCache::~PlanCache() {
+        clear_inlock();
+    }
+
+    // static
+    PlanCacheKey PlanCache::getPlanCacheKey(const CanonicalQuery& query) {
+        StringBuilder keyBuilder;
+        encodeMatchExpression(query.root(), &keyBuilder);
+        keyBuilder << "|s" << query.getParsed().getSort().toString();
+        keyBuilder << "|p" << query.getParsed().getProj().toString();
+        return keyBuilder.str();
+    }
+
+    // static
+    std::string PlanCache::getSolutionKey(const QuerySolution& solution) {
+        if (NULL == solution.root) { return ""; }
+        StringBuilder keyBuilder;
+        encodeSolutionNode(solution.root.get(), &keyBuilder);
+        return keyBuilder.str();
+    }
+
+    // static
+    bool PlanCache::shouldCacheQuery(const CanonicalQuery& query) {
+        const LiteParsedQuery& lpq = query.getParsed();
+        return lpq.getHint().isEmpty()
+            && lpq.getMin().isEmpty()
+            && lpq.getMax().isEmpty()
+            && !lpq.isSnapshot()
+            && !lpq.isExplain()
+            && !lpq.hasOption(QueryOption_CursorTailable);
+    }
+
+    bool PlanCache::add(const CanonicalQuery& query, const QuerySolution& solution,
+                        PlanRankingDecision* why) {
+        auto_ptr<PlanRankingDecision> decision(why);
+        if (NULL == decision->statsOfWinner) { return false; }
+
+        PlanCacheKey key = getPlanCacheKey(query);
+        std::string solnKey = getSolutionKey(solution);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_entries.end() != _entries.find(key)) { return false; }
+
+        _lru.push_front(key);
+        PlanCacheEntry* entry = new PlanCacheEntry(query, solnKey, decision.release());
+        _entries[key] = EntryAndPosition(entry, _lru.begin());
+
+        // Evict the least recently used shapes if we've grown too big.
+        while (_entries.size() > static_cast<size_t>(std::max(internalQueryCacheSize, 1))) {
+            EntryMap::iterator lruIt = _entries.find(_lru.back());
+            verify(_entries.end() != lruIt);
+            remove_inlock(lruIt);
+        }
+
+        LOG(2) << "Added plan cache entry for shape " << key << " with solution " << solnKey
+               << endl;
+        return true;
+    }
+
+    CachedSolution* PlanCache::get(const CanonicalQuery& query) {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() == it) { return NULL; }
+
+        PlanCacheEntry* entry = it->second.first;
+        ++entry->numHits;
+
+        // Mark as most recently used.
+        _lru.splice(_lru.begin(), _lru, it->second.second);
+
+        auto_ptr<CachedSolution> cs(new CachedSolution());
+        cs->key = key;
+        cs->solutionKey = entry->solutionKey;
+        cs->winnerStats = entry->decision->statsOfWinner->common;
+        return cs.release();
+    }
+
+    bool PlanCache::feedback(const CanonicalQuery& query, const QuerySolution& solution,
+                             CachedSolutionFeedback* feedback) {
+        auto_ptr<CachedSolutionFeedback> autoFeedback(feedback);
+        PlanCacheKey key = getPlanCacheKey(query);
+        std::string solnKey = getSolutionKey(solution);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() == it) { return false; }
+
+        PlanCacheEntry* entry = it->second.first;
+        if (entry->solutionKey != solnKey) { return false; }
+
+        if (NULL != feedback->stats && hasDegraded(*entry, *feedback)) {
+            LOG(2) << "Evicting plan cache entry for shape " << key
+                   << ": cached plan has degraded" << endl;
+            remove_inlock(it);
+            return true;
+        }
+
+        entry->feedback.push_back(autoFeedback.release());
+        if (entry->feedback.size() > kMaxFeedback) {
+            delete entry->feedback.front();
+            entry->feedback.pop_front();
+        }
+        return true;
+    }
+
+    bool PlanCache::remove(const CanonicalQuery& query) {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() == it) { return false; }
+        remove_inlock(it);
+        return true;
+    }
+
+    void PlanCache::clear() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        clear_inlock();
+    }
+
+    void PlanCache::notifyOfWriteOp() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_entries.empty()) { return; }
+        if (++_writeOpsSinceFlush >= internalQueryCacheWriteOpsBetweenFlush) {
+            clear_inlock();
+        }
+    }
+
+    void PlanCache::pin(const CanonicalQuery& query, const BSONObj& indexKeyPattern) {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        PinnedIndex pinned;
+        pinned.query = query.getQueryObj().getOwned();
+        pinned.sort = query.getParsed().getSort().getOwned();
+        pinned.projection = query.getParsed().getProj().getOwned();
+        pinned.indexKeyPattern = indexKeyPattern.getOwned();
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        _pins[key] = pinned;
+
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() != it) {
+            remove_inlock(it);
+        }
+    }
+
+    bool PlanCache::unpin(const CanonicalQuery& query) {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _pins.erase(key) > 0;
+    }
+
+    bool PlanCache::getPin(const CanonicalQuery& query, BSONObj* indexKeyPatternOut) const {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_pins.empty()) { return false; }
+        PinMap::const_iterator it = _pins.find(key);
+        if (_pins.end() == it) { return false; }
+        *indexKeyPatternOut = it->second.indexKeyPattern;
+        return true;
+    }
+
+    // static
+    bool PlanCache::solutionUsesIndex(const QuerySolution& solution,
+                                      const BSONObj& indexKeyPattern) {
+        if (NULL == solution.root) { return false; }
+        return readsOnlyIndex(solution.root.get(), indexKeyPattern);
+    }
+
+    void PlanCache::appendShapes(BSONArrayBuilder* out) const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        for (KeyList::const_iterator it = _lru.begin(); it != _lru.end(); ++it) {
+            const PlanCacheEntry* entry = _entries.find(*it)->second.first;
+            BSONObjBuilder shapeBob(out->subobjStart());
+            shapeBob.append("query", entry->query);
+            shapeBob.append("sort", entry->sort);
+            shapeBob.append("projection", entry->projection);
+            shapeBob.doneFast();
+        }
+
+        // Pinned shapes that aren't cached as well.
+        for (PinMap::const_iterator it = _pins.begin(); it != _pins.end(); ++it) {
+            if (_entries.end() != _entries.find(it->first)) { continue; }
+            BSONObjBuilder shapeBob(out->subobjStart());
+            shapeBob.append("query", it->second.query);
+            shapeBob.append("sort", it->second.sort);
+            shapeBob.append("projection", it->second.projection);
+            shapeBob.doneFast();
+        }
+    }
+
+    bool PlanCache::appendShapeDetails(const CanonicalQuery& query, BSONObjBuilder* out) const {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        EntryMap::const_iterator entryIt = _entries.find(key);
+        PinMap::const_iterator pinIt = _pins.find(key);
+        if (_entries.end() == entryIt && _pins.end() == pinIt) { return false; }
+
+        out->append("shape", key);
+
+        if (_pins.end() != pinIt) {
+            out->append("pinnedIndex", pinIt->second.indexKeyPattern);
+        }
+
+        if (_entries.end() == entryIt) { return true; }
+
+        const PlanCacheEntry* entry = entryIt->second.first;
+        out->append("solution", entry->solutionKey);
+        out->appendNumber("hits", entry->numHits);
+
+        BSONObjBuilder decisionBob(out->subobjStart("decision"));
+        decisionBob.appendBool("onlyOneSolution", entry->decision->onlyOneSolution);
+        BSONObjBuilder winnerBob(decisionBob.subobjStart("statsOfWinner"));
+        appendCommonStats(entry->decision->statsOfWinner->common, &winnerBob);
+        winnerBob.doneFast();
+        decisionBob.doneFast();
+
+        BSONArrayBuilder feedbackBab(out->subarrayStart("feedback"));
+        for (size_t i = 0; i < entry->feedback.size(); ++i) {
+            if (NULL == entry->feedback[i]->stats) { continue; }
+            BSONObjBuilder feedbackBob(feedbackBab.subobjStart());
+            appendCommonStats(entry->feedback[i]->stats->common, &feedbackBob);
+            feedbackBob.doneFast();
+        }
+        feedbackBab.doneFast();
+        return true;
+    }
+
+    size_t PlanCache::size() const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+    // static
+    bool PlanCache::hasDegraded(const PlanCacheEntry& entry,
+                                const CachedSolutionFeedback& feedback) {
+        const CommonStats& actual = feedback.stats->common;
+        if (actual.works < kMinWorksForEviction) { return false; }
+
+        const CommonStats& expected = entry.decision->statsOfWinner->common;
+        return productivity(actual) * kDegradationFactor < productivity(expected);
+    }
+
+    void PlanCache::remove_inlock(EntryMap::iterator it) {
+        _lru.erase(it->second.second);
+        delete it->second.first;
+        _entries.erase(it);
+    }
+
+    void PlanCache::clear_inlock() {
+        for (EntryMap::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            delete it->second.first;
+        }
+        _entries.clear();
+        _lru.clear();
+        _writeOpsSinceFlush = 0;
+    }
+
+}  // namespace mongo
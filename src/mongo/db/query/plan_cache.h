@@ -28,106 +28,271 @@
 
 #pragma once
 
+#include <deque>
+#include <list>
+#include <string>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
+    class CanonicalQuery;
+
     /**
-     * TODO: Debug commands:
-     * 1. show canonical form of query
-     * 2. show plans generated for query without (and with) cache
-     * 3. print out cache.
-     * 4. clear all elements from cache / otherwise manipulate cache.
+     * The normalized shape of a query: the structure of its predicate tree (operators and paths,
+     * but no constants), its sort and its projection.  Two queries that differ only in the values
+     * they compare against share a PlanCacheKey and therefore a cached plan.
      */
+    typedef std::string PlanCacheKey;
 
     /**
      * When the CachedPlanRunner runs a cached query, it can provide feedback to the cache.  This
      * feedback is available to anyone who retrieves that query in the future.
      */
     struct CachedSolutionFeedback {
+        CachedSolutionFeedback() : stats(NULL) { }
+        ~CachedSolutionFeedback() { delete stats; }
+
+        // Owned here.
         PlanStageStats* stats;
+    private:
+        MONGO_DISALLOW_COPYING(CachedSolutionFeedback);
     };
 
     /**
-     * A cached solution to a query.
+     * A cached solution to a query, handed out by PlanCache::get.
+     *
+     * The cache does not store QuerySolution trees, as they are full of bounds computed from the
+     * constants of one particular query.  Instead it stores a description of the winning plan (the
+     * 'solutionKey', see PlanCache::getSolutionKey) and the caller picks the matching solution out
+     * of the planner's output.  Planning is cheap; racing the candidate plans is what we avoid.
      */
     struct CachedSolution {
-        ~CachedSolution() {
-            for (size_t i = 0; i < feedback.size(); ++i) {
-                delete feedback[i];
-            }
-        }
+        CachedSolution() { }
+
+        // The shape of the query this solution was cached for.
+        PlanCacheKey key;
 
-        // The best solution for the CanonicalQuery.
+        // Identifies the winning solution among the solutions generated for the query.
+        std::string solutionKey;
+
+        // The best solution for the CanonicalQuery.  Filled in by the caller, owned here.
         scoped_ptr<QuerySolution> solution;
 
+        // How the winner performed during the plan competition that put it in the cache.
+        CommonStats winnerStats;
+    private:
+        MONGO_DISALLOW_COPYING(CachedSolution);
+    };
+
+    /**
+     * Everything the cache knows about one query shape.  Owned by the PlanCache.
+     */
+    struct PlanCacheEntry {
+        /**
+         * Takes ownership of 'why'.
+         */
+        PlanCacheEntry(const CanonicalQuery& query, const std::string& solnKey,
+                       PlanRankingDecision* why);
+        ~PlanCacheEntry();
+
+        // A query (and its sort and projection) of this shape, for diagnostics.
+        BSONObj query;
+        BSONObj sort;
+        BSONObj projection;
+
+        // Description of the winning solution.  See PlanCache::getSolutionKey.
+        std::string solutionKey;
+
         // Why the best solution was picked.
         scoped_ptr<PlanRankingDecision> decision;
 
-        // Annotations from cached runs.
-        // TODO: How many of these do we really want to keep?
-        vector<CachedSolutionFeedback*> feedback;
+        // Annotations from cached runs, oldest first.  Owned here and bounded in size.
+        std::deque<CachedSolutionFeedback*> feedback;
+
+        // How many times this entry has been handed out by PlanCache::get.
+        long long numHits;
     private:
-        MONGO_DISALLOW_COPYING(CachedSolution);
+        MONGO_DISALLOW_COPYING(PlanCacheEntry);
     };
 
     /**
      * Caches the best solution to a query.  Aside from the (CanonicalQuery -> QuerySolution)
      * mapping, the cache contains information on why that mapping was made, and statistics on the
      * cache entry's actual performance on subsequent runs.
+     *
+     * There is one PlanCache per collection, owned by its NamespaceDetailsTransient.  The cache is
+     * bounded: once it holds internalQueryCacheSize shapes, the least recently used shape is
+     * evicted.  It is flushed when the set of indices changes and after
+     * internalQueryCacheWriteOpsBetweenFlush writes to the collection.
+     *
+     * All methods are thread safe; queries holding only a read lock share the cache.
      */
     class PlanCache {
     public:
+        PlanCache();
+        ~PlanCache();
+
+        /**
+         * Returns the shape of 'query' used to index the cache.
+         */
+        static PlanCacheKey getPlanCacheKey(const CanonicalQuery& query);
+
         /**
-         * Get the (global) cache for the provided namespace.  Must not be held across yields.
-         * As such, there is no locking required.
+         * Returns a description of 'solution' which does not depend on the constants in the
+         * query: the tree of stages and, for index scans, the index and direction used.
          */
-        static PlanCache* get(const string& ns) { return NULL; }
+        static std::string getSolutionKey(const QuerySolution& solution);
+
+        /**
+         * Returns true if plans for 'query' may be read from or written to the cache.  Queries
+         * that force a plan (hint, min/max, snapshot) or ask for all plans (explain) may not.
+         */
+        static bool shouldCacheQuery(const CanonicalQuery& query);
 
         /**
          * Record 'solution' as the best plan for 'query' which was picked for reasons detailed in
          * 'why'.
          *
-         * Takes ownership of all arguments.
+         * Takes ownership of 'why'.
          *
          * If the mapping was added successfully, returns true.
          * If the mapping already existed or some other error occurred, returns false;
          */
-        bool add(CanonicalQuery* query, QuerySolution* solution, PlanRankingDecision* why) {
-            return false;
-        }
+        bool add(const CanonicalQuery& query, const QuerySolution& solution,
+                 PlanRankingDecision* why);
 
         /**
          * Look up the cached solution for the provided query.  If a cached solution exists, return
          * a copy of it which the caller then owns.  If no cached solution exists, returns NULL.
          *
-         * TODO: Allow querying for exact query and querying for the shape of the query.
+         * The returned CachedSolution has no 'solution'; see CachedSolution.
          */
-        CachedSolution* get(const CanonicalQuery& query) {
-            return NULL;
-        }
+        CachedSolution* get(const CanonicalQuery& query);
 
         /**
          * When the CachedPlanRunner runs a plan out of the cache, we want to record data about the
          * plan's performance.  Cache takes ownership of 'feedback'.
          *
+         * If the feedback shows that the cached plan has degraded badly compared to its
+         * performance when it won the plan competition, the entry is evicted so the next query of
+         * this shape re-races the candidate plans.
+         *
          * If the (query, solution) pair isn't in the cache, the cache deletes feedback and returns
          * false.  Otherwise, returns true.
          */
         bool feedback(const CanonicalQuery& query, const QuerySolution& solution,
-                      const CachedSolutionFeedback* feedback) {
-            return false;
-        }
+                      CachedSolutionFeedback* feedback);
+
+        /**
+         * Remove the entry for the shape of 'query' from our cache.  Returns true if the plan was
+         * removed, false if it wasn't found.
+         */
+        bool remove(const CanonicalQuery& query);
+
+        /**
+         * Remove all entries.  Pins are kept.
+         */
+        void clear();
+
+        /**
+         * Force queries of the shape of 'query' to use the index 'indexKeyPattern', as if they had
+         * been hinted.  {$natural: 1} pins a collection scan.  Replaces any existing pin for the
+         * shape and removes its cached entry.
+         *
+         * Pins survive flushes of the cache and last until unpinned or the collection goes away.
+         * If none of the solutions for a query use the pinned index, the pin is ignored.
+         */
+        void pin(const CanonicalQuery& query, const BSONObj& indexKeyPattern);
+
+        /**
+         * Removes the pin for the shape of 'query'.  Returns false if it wasn't pinned.
+         */
+        bool unpin(const CanonicalQuery& query);
+
+        /**
+         * If the shape of 'query' is pinned, returns true and fills in the pinned index's key
+         * pattern.  Returns false otherwise.
+         */
+        bool getPin(const CanonicalQuery& query, BSONObj* indexKeyPatternOut) const;
+
+        /**
+         * Returns true if 'solution' reads no index but 'indexKeyPattern', as a hint of that index
+         * would.  {$natural: 1} matches solutions which only scan the collection.
+         */
+        static bool solutionUsesIndex(const QuerySolution& solution,
+                                      const BSONObj& indexKeyPattern);
+
+        //
+        // Introspection, for the planCache* commands.
+        //
+
+        /**
+         * Appends a {query, sort, projection} example of every cached or pinned shape, most
+         * recently used cached shapes first.
+         */
+        void appendShapes(BSONArrayBuilder* out) const;
+
+        /**
+         * Appends everything the cache knows about the shape of 'query': the solution chosen,
+         * why it was chosen, feedback from cached runs, and the pinned index if any.  Returns
+         * false if the shape is neither cached nor pinned.
+         */
+        bool appendShapeDetails(const CanonicalQuery& query, BSONObjBuilder* out) const;
 
         /**
-         * Remove the (query, solution) pair from our cache.  Returns true if the plan was removed,
-         * false if it wasn't found.
+         * Writes change the data distribution and thereby the relative merit of plans.  Flushes
+         * the cache every internalQueryCacheWriteOpsBetweenFlush writes.
          */
-        bool remove(const CanonicalQuery& query, const QuerySolution& solution) {
-            return false;
-        }
+        void notifyOfWriteOp();
+
+        /**
+         * Number of query shapes currently cached.
+         */
+        size_t size() const;
+
+    private:
+        typedef std::list<PlanCacheKey> KeyList;
+        typedef std::pair<PlanCacheEntry*, KeyList::iterator> EntryAndPosition;
+        typedef unordered_map<PlanCacheKey, EntryAndPosition> EntryMap;
+
+        /**
+         * Returns true if 'feedback' shows that 'entry' produces results much less efficiently
+         * than it did during the plan competition.
+         */
+        static bool hasDegraded(const PlanCacheEntry& entry,
+                                const CachedSolutionFeedback& feedback);
+
+        /**
+         * A shape forced to use an index.  See pin().
+         */
+        struct PinnedIndex {
+            BSONObj query;
+            BSONObj sort;
+            BSONObj projection;
+            BSONObj indexKeyPattern;
+        };
+        typedef unordered_map<PlanCacheKey, PinnedIndex> PinMap;
+
+        void remove_inlock(EntryMap::iterator it);
+        void clear_inlock();
+
+        // Protects all members below.
+        mutable SimpleMutex _mutex;
+
+        EntryMap _entries;
+
+        // Keys in order of use, most recently used first.
+        KeyList _lru;
+
+        // Writes to the collection since the cache was last flushed.
+        int _writeOpsSinceFlush;
+
+        PinMap _pins;
     };
 
 }  // namespace mongo
@@ -0,0 +1,313 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/plan_cache.cpp
+ */
+
+#include "mongo/db/query/plan_cache.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    static const char* ns = "somebogusns";
+
+    CanonicalQuery* canonicalize(const char* queryStr, const char* sortStr = "{}",
+                                 const char* projStr = "{}") {
+        CanonicalQuery* cq;
+        Status status = CanonicalQuery::canonicalize(ns, fromjson(queryStr), fromjson(sortStr),
+                                                     fromjson(projStr), &cq);
+        ASSERT_OK(status);
+        return cq;
+    }
+
+    PlanCacheKey keyOf(const char* queryStr, const char* sortStr = "{}",
+                       const char* projStr = "{}") {
+        auto_ptr<CanonicalQuery> cq(canonicalize(queryStr, sortStr, projStr));
+        return PlanCache::getPlanCacheKey(*cq);
+    }
+
+    void setServerParameter(const string& name, const string& value) {
+        const ServerParameterSet::Map& params = ServerParameterSet::getGlobal()->getMap();
+        ServerParameterSet::Map::const_iterator it = params.find(name);
+        ASSERT(params.end() != it);
+        ASSERT_OK(it->second->setFromString(value));
+    }
+
+    /**
+     * A ranking decision whose winner advanced 'advanced' times in 'works' calls.
+     */
+    PlanRankingDecision* makeDecision(uint64_t works, uint64_t advanced) {
+        CommonStats common;
+        common.works = works;
+        common.advanced = advanced;
+        PlanRankingDecision* why = new PlanRankingDecision();
+        why->statsOfWinner = new PlanStageStats(common, STAGE_COLLSCAN);
+        return why;
+    }
+
+    CachedSolutionFeedback* makeFeedback(uint64_t works, uint64_t advanced) {
+        CommonStats common;
+        common.works = works;
+        common.advanced = advanced;
+        CachedSolutionFeedback* feedback = new CachedSolutionFeedback();
+        feedback->stats = new PlanStageStats(common, STAGE_COLLSCAN);
+        return feedback;
+    }
+
+    /**
+     * Plans 'cq' against a single {a: 1} index and returns the solution which scans the
+     * collection.
+     */
+    QuerySolution* planCollScan(const CanonicalQuery& cq) {
+        vector<IndexEntry> indices;
+        indices.push_back(IndexEntry(BSON("a" << 1), false, false));
+        vector<QuerySolution*> solns;
+        QueryPlanner::plan(cq, indices, QueryPlanner::INCLUDE_COLLSCAN, &solns);
+
+        QuerySolution* collScan = NULL;
+        for (size_t i = 0; i < solns.size(); ++i) {
+            if (NULL == collScan
+                && PlanCache::solutionUsesIndex(*solns[i], BSON("$natural" << 1))) {
+                collScan = solns[i];
+            }
+            else {
+                delete solns[i];
+            }
+        }
+        ASSERT(NULL != collScan);
+        return collScan;
+    }
+
+    //
+    // Query shapes
+    //
+
+    TEST(PlanCacheKeyTest, ConstantsDoNotMatter) {
+        ASSERT_EQUALS(keyOf("{a: 1}"), keyOf("{a: 5}"));
+        ASSERT_EQUALS(keyOf("{a: {$gt: 1}, b: 'x'}"), keyOf("{a: {$gt: 99}, b: 'y'}"));
+        ASSERT_EQUALS(keyOf("{a: {$in: [1, 2]}}"), keyOf("{a: {$in: [3]}}"));
+    }
+
+    TEST(PlanCacheKeyTest, PredicateOrderDoesNotMatter) {
+        ASSERT_EQUALS(keyOf("{a: 1, b: 1}"), keyOf("{b: 1, a: 1}"));
+        ASSERT_EQUALS(keyOf("{$or: [{a: 1}, {b: 1}]}"), keyOf("{$or: [{b: 1}, {a: 1}]}"));
+    }
+
+    TEST(PlanCacheKeyTest, StructureMatters) {
+        ASSERT_NOT_EQUALS(keyOf("{a: 1}"), keyOf("{b: 1}"));
+        ASSERT_NOT_EQUALS(keyOf("{a: 1}"), keyOf("{a: {$gt: 1}}"));
+        ASSERT_NOT_EQUALS(keyOf("{a: 1}"), keyOf("{a: 1, b: 1}"));
+        ASSERT_NOT_EQUALS(keyOf("{a: 1}", "{b: 1}"), keyOf("{a: 1}", "{b: -1}"));
+        ASSERT_NOT_EQUALS(keyOf("{a: 1}", "{}", "{a: 1}"), keyOf("{a: 1}", "{}", "{b: 1}"));
+    }
+
+    TEST(PlanCacheTest, ShouldCacheQuery) {
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        ASSERT_TRUE(PlanCache::shouldCacheQuery(*cq));
+    }
+
+    //
+    // Cache operations
+    //
+
+    TEST(PlanCacheTest, AddGetRemove) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(planCollScan(*cq));
+
+        ASSERT(NULL == cache.get(*cq));
+        ASSERT_TRUE(cache.add(*cq, *soln, makeDecision(100, 10)));
+        // A shape is only added once.
+        ASSERT_FALSE(cache.add(*cq, *soln, makeDecision(100, 10)));
+        ASSERT_EQUALS(cache.size(), 1U);
+
+        // A query of the same shape finds the cached solution.
+        auto_ptr<CanonicalQuery> sameShape(canonicalize("{a: 7}"));
+        scoped_ptr<CachedSolution> cs(cache.get(*sameShape));
+        ASSERT(NULL != cs.get());
+        ASSERT_EQUALS(cs->solutionKey, PlanCache::getSolutionKey(*soln));
+        ASSERT_EQUALS(cs->winnerStats.works, 100U);
+
+        ASSERT_TRUE(cache.remove(*sameShape));
+        ASSERT_FALSE(cache.remove(*sameShape));
+        ASSERT(NULL == cache.get(*cq));
+    }
+
+    TEST(PlanCacheTest, EvictsLeastRecentlyUsed) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+        auto_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+        scoped_ptr<QuerySolution> solnA(planCollScan(*cqA));
+        scoped_ptr<QuerySolution> solnB(planCollScan(*cqB));
+
+        ASSERT_TRUE(cache.add(*cqA, *solnA, makeDecision(100, 10)));
+        ASSERT_TRUE(cache.add(*cqB, *solnB, makeDecision(100, 10)));
+
+        // Touch 'a' so that 'b' is the least recently used shape.
+        delete cache.get(*cqA);
+
+        setServerParameter("internalQueryCacheSize", "2");
+        auto_ptr<CanonicalQuery> cqC(canonicalize("{c: 1}"));
+        scoped_ptr<QuerySolution> solnC(planCollScan(*cqC));
+        ASSERT_TRUE(cache.add(*cqC, *solnC, makeDecision(100, 10)));
+        setServerParameter("internalQueryCacheSize", "5000");
+
+        ASSERT_EQUALS(cache.size(), 2U);
+        scoped_ptr<CachedSolution> csA(cache.get(*cqA));
+        scoped_ptr<CachedSolution> csB(cache.get(*cqB));
+        scoped_ptr<CachedSolution> csC(cache.get(*cqC));
+        ASSERT(NULL != csA.get());
+        ASSERT(NULL == csB.get());
+        ASSERT(NULL != csC.get());
+    }
+
+    TEST(PlanCacheTest, FlushedAfterWrites) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(planCollScan(*cq));
+        ASSERT_TRUE(cache.add(*cq, *soln, makeDecision(100, 10)));
+
+        for (int i = 0; i < 999; ++i) {
+            cache.notifyOfWriteOp();
+        }
+        ASSERT_EQUALS(cache.size(), 1U);
+        cache.notifyOfWriteOp();
+        ASSERT_EQUALS(cache.size(), 0U);
+    }
+
+    TEST(PlanCacheTest, FeedbackEvictsDegradedPlan) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(planCollScan(*cq));
+        ASSERT_TRUE(cache.add(*cq, *soln, makeDecision(100, 50)));
+
+        // Performing about as well as in the competition keeps the plan.
+        ASSERT_TRUE(cache.feedback(*cq, *soln, makeFeedback(10000, 4000)));
+        ASSERT_EQUALS(cache.size(), 1U);
+
+        // Short runs aren't judged.
+        ASSERT_TRUE(cache.feedback(*cq, *soln, makeFeedback(100, 0)));
+        ASSERT_EQUALS(cache.size(), 1U);
+
+        // A long, unproductive run evicts the plan.
+        ASSERT_TRUE(cache.feedback(*cq, *soln, makeFeedback(10000, 10)));
+        ASSERT_EQUALS(cache.size(), 0U);
+
+        // Feedback for a shape that isn't cached is dropped.
+        ASSERT_FALSE(cache.feedback(*cq, *soln, makeFeedback(10000, 10)));
+    }
+
+    //
+    // Pins and introspection
+    //
+
+    TEST(PlanCacheTest, SolutionUsesIndex) {
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> collScan(planCollScan(*cq));
+        ASSERT_TRUE(PlanCache::solutionUsesIndex(*collScan, BSON("$natural" << 1)));
+        ASSERT_FALSE(PlanCache::solutionUsesIndex(*collScan, BSON("a" << 1)));
+
+        vector<IndexEntry> indices;
+        indices.push_back(IndexEntry(BSON("a" << 1), false, false));
+        vector<QuerySolution*> solns;
+        QueryPlanner::plan(*cq, indices, QueryPlanner::DEFAULT, &solns);
+        ASSERT_EQUALS(solns.size(), 1U);
+        scoped_ptr<QuerySolution> indexScan(solns[0]);
+        ASSERT_TRUE(PlanCache::solutionUsesIndex(*indexScan, BSON("a" << 1)));
+        ASSERT_FALSE(PlanCache::solutionUsesIndex(*indexScan, BSON("b" << 1)));
+        ASSERT_FALSE(PlanCache::solutionUsesIndex(*indexScan, BSON("$natural" << 1)));
+    }
+
+    TEST(PlanCacheTest, PinsReplaceEntriesAndSurviveFlushes) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(planCollScan(*cq));
+        ASSERT_TRUE(cache.add(*cq, *soln, makeDecision(100, 10)));
+
+        BSONObj pinned;
+        ASSERT_FALSE(cache.getPin(*cq, &pinned));
+
+        cache.pin(*cq, BSON("a" << 1));
+        ASSERT_EQUALS(cache.size(), 0U);
+
+        auto_ptr<CanonicalQuery> sameShape(canonicalize("{a: 3}"));
+        ASSERT_TRUE(cache.getPin(*sameShape, &pinned));
+        ASSERT_EQUALS(pinned, BSON("a" << 1));
+
+        cache.clear();
+        ASSERT_TRUE(cache.getPin(*cq, &pinned));
+
+        ASSERT_TRUE(cache.unpin(*cq));
+        ASSERT_FALSE(cache.unpin(*cq));
+        ASSERT_FALSE(cache.getPin(*cq, &pinned));
+    }
+
+    TEST(PlanCacheTest, AppendShapesAndDetails) {
+        PlanCache cache;
+        auto_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}", "{b: 1}"));
+        auto_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+        scoped_ptr<QuerySolution> solnA(planCollScan(*cqA));
+        ASSERT_TRUE(cache.add(*cqA, *solnA, makeDecision(100, 10)));
+        ASSERT_TRUE(cache.feedback(*cqA, *solnA, makeFeedback(50, 5)));
+        cache.pin(*cqB, BSON("b" << 1));
+
+        BSONArrayBuilder shapesBab;
+        cache.appendShapes(&shapesBab);
+        BSONArray shapes = shapesBab.arr();
+        ASSERT_EQUALS(shapes.nFields(), 2);
+        ASSERT_EQUALS(shapes["0"].Obj()["query"].Obj(), fromjson("{a: 1}"));
+        ASSERT_EQUALS(shapes["0"].Obj()["sort"].Obj(), fromjson("{b: 1}"));
+        ASSERT_EQUALS(shapes["1"].Obj()["query"].Obj(), fromjson("{b: 1}"));
+
+        BSONObjBuilder detailsA;
+        ASSERT_TRUE(cache.appendShapeDetails(*cqA, &detailsA));
+        BSONObj objA = detailsA.obj();
+        ASSERT_EQUALS(objA["solution"].String(), PlanCache::getSolutionKey(*solnA));
+        ASSERT_EQUALS(objA["decision"]["statsOfWinner"]["works"].numberLong(), 100);
+        ASSERT_EQUALS(objA["feedback"].Obj().nFields(), 1);
+        ASSERT_FALSE(objA.hasField("pinnedIndex"));
+
+        BSONObjBuilder detailsB;
+        ASSERT_TRUE(cache.appendShapeDetails(*cqB, &detailsB));
+        ASSERT_EQUALS(detailsB.obj()["pinnedIndex"].Obj(), BSON("b" << 1));
+
+        auto_ptr<CanonicalQuery> cqC(canonicalize("{c: 1}"));
+        BSONObjBuilder detailsC;
+        ASSERT_FALSE(cache.appendShapeDetails(*cqC, &detailsC));
+    }
+
+}  // namespace
@@ -16,11 +16,19 @@
 
 #include "mongo/db/query/plan_enumerator.h"
 
+#include <algorithm>
 #include <set>
 
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_tag.h"
 
+namespace {
+
+    // How many index intersection choices we generate for one AND.
+    const size_t kMaxIntersections = 10;
+
+}  // namespace
+
 namespace mongo {
 
     PlanEnumerator::PlanEnumerator(MatchExpression* root, const vector<IndexEntry>* indices)
@@ -236,7 +244,15 @@ namespace mongo {
         sortUsingTags(*tree);
 
         _root->resetTag();
-        _done = true;
+
+        // Tag the next solution, if there is one, for the next call.
+        if (nextMemo(_nodeToId[_root])) {
+            _done = true;
+        }
+        else {
+            tagMemo(_nodeToId[_root]);
+            checkCompound("", _root);
+        }
         return true;
     }
 
@@ -259,6 +275,9 @@ namespace mongo {
 
             _curEnum[myID] = 0;
 
+            // Only one choice is enumerated; we don't intersect indices under array operators.
+            andSolution->firstIntersection = andSolution->subnodes.size();
+
             // Takes ownership.
             soln->andSolution.reset(andSolution);
             return andSolution->subnodes.size() > 0;
@@ -319,8 +338,9 @@ namespace mongo {
                 // more than one plan.
                 size_t geoNearChild = IndexTag::kNoIndex;
                 
-                // For efficiency concerns, we don't explore any more than the size-1 members
-                // of the power set.  That is, we will only use one index at a time.
+                // For efficiency concerns, we don't explore the whole power set.  We use one
+                // index at a time, and then try intersecting the indices of the predicates that
+                // are likely to be selective.  See addIntersections.
                 AndSolution* andSolution = new AndSolution();
                 for (size_t i = 0; i < node->numChildren(); ++i) {
                     // If AND requires an index it can only piggyback on the children that have
@@ -349,6 +369,12 @@ namespace mongo {
                     andSolution->subnodes[0].swap(andSolution->subnodes[geoNearChild]);
                 }
 
+                // The geoNear has to be the index that provides results, so we don't intersect.
+                andSolution->firstIntersection = andSolution->subnodes.size();
+                if (IndexTag::kNoIndex == geoNearChild) {
+                    addIntersections(andSolution);
+                }
+
                 size_t myID = _inOrderCount++;
                 _nodeToId[node] = myID;
                 NodeSolution* soln = new NodeSolution();
@@ -399,7 +425,119 @@ namespace mongo {
         }
     }
 
+    bool PlanEnumerator::isIntersectable(MatchExpression* expr, size_t idx) const {
+        switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+            break;
+        default:
+            return false;
+        }
+
+        // The AND stages need each DiskLoc once per child and can't make sense of special index
+        // types.
+        const IndexEntry& index = (*_indices)[idx];
+        if (index.multikey) { return false; }
+
+        BSONObjIterator it(index.keyPattern);
+        while (it.more()) {
+            if (!it.next().isNumber()) { return false; }
+        }
+        return true;
+    }
+
+    void PlanEnumerator::addIntersections(AndSolution* andSolution) {
+        // Group the intersectable predicates by the index they would use.  Predicates over the
+        // same index are scanned together.
+        vector<size_t> indices;
+        vector<vector<size_t> > predsByIndex;
+
+        for (size_t i = 0; i < andSolution->firstIntersection; ++i) {
+            const vector<size_t>& option = andSolution->subnodes[i];
+            verify(1 == option.size());
+
+            NodeSolution* ns = _memo[option[0]];
+            if (NULL == ns->pred || ns->pred->first.empty()) { continue; }
+
+            // tagMemo assigns a predicate its first 'first' index.
+            size_t idx = ns->pred->first[0];
+            if (!isIntersectable(ns->pred->expr, idx)) { continue; }
+
+            vector<size_t>::iterator found = std::find(indices.begin(), indices.end(), idx);
+            if (indices.end() == found) {
+                indices.push_back(idx);
+                predsByIndex.push_back(vector<size_t>());
+                predsByIndex.back().push_back(option[0]);
+            }
+            else {
+                predsByIndex[found - indices.begin()].push_back(option[0]);
+            }
+        }
+
+        if (indices.size() < 2) { return; }
+
+        // Every pair of indices...
+        for (size_t i = 0; i < indices.size(); ++i) {
+            for (size_t j = i + 1; j < indices.size(); ++j) {
+                if (andSolution->subnodes.size() - andSolution->firstIntersection
+                    >= kMaxIntersections) {
+                    return;
+                }
+                vector<size_t> option(predsByIndex[i]);
+                option.insert(option.end(), predsByIndex[j].begin(), predsByIndex[j].end());
+                andSolution->subnodes.push_back(option);
+            }
+        }
+
+        // ...and all of them at once.
+        if (indices.size() > 2) {
+            vector<size_t> option;
+            for (size_t i = 0; i < predsByIndex.size(); ++i) {
+                option.insert(option.end(), predsByIndex[i].begin(), predsByIndex[i].end());
+            }
+            andSolution->subnodes.push_back(option);
+        }
+    }
+
     bool PlanEnumerator::nextMemo(size_t id) {
+        NodeSolution* soln = _memo[id];
+        verify(NULL != soln);
+
+        if (NULL != soln->pred) {
+            // A predicate always uses its first index.
+            return true;
+        }
+        else if (NULL != soln->orSolution) {
+            // Enumerating every combination of the clauses' choices would multiply the number of
+            // plans, so each clause of an OR sticks to its first choice.
+            return true;
+        }
+
+        verify(NULL != soln->andSolution);
+        AndSolution* andSolution = soln->andSolution.get();
+
+        // Run through the states of the choice we're on before moving to the next choice.
+        const vector<size_t>& cur = andSolution->subnodes[_curEnum[id]];
+        for (size_t i = 0; i < cur.size(); ++i) {
+            if (!nextMemo(cur[i])) { return false; }
+        }
+
+        size_t next = _curEnum[id] + 1;
+        if (next < andSolution->firstIntersection) {
+            // Only the first single-index choice is enumerated.
+            next = andSolution->firstIntersection;
+        }
+
+        if (next >= andSolution->subnodes.size()) {
+            _curEnum[id] = 0;
+            return true;
+        }
+
+        _curEnum[id] = next;
         return false;
     }
 
@@ -114,7 +114,8 @@ namespace mongo {
          *
          * Returns false if the memo subtree has moved to the next state.
          *
-         * XXX implement.
+         * An AND enumerates its first single-index choice followed by its intersection choices
+         * (see AndSolution).  Predicates and ORs have only one state.
          */
         bool nextMemo(size_t id);
 
@@ -126,8 +127,15 @@ namespace mongo {
         };
 
         struct AndSolution {
+            AndSolution() : firstIntersection(0) { }
+
             // Must use one of the elements of subnodes.
             vector<vector<size_t> > subnodes;
+
+            // subnodes[firstIntersection] onward use two or more different indices, one per
+            // child, and are answered with an AND_HASH or AND_SORTED over the index scans.  The
+            // subnodes before it use one index each; only the first of those is enumerated.
+            size_t firstIntersection;
         };
 
         struct OrSolution {
@@ -142,6 +150,19 @@ namespace mongo {
             string toString() const;
         };
 
+        /**
+         * Can the predicate 'expr' be one of the index scans in an index intersection?  It must
+         * be selective enough to be worth intersecting (equalities, $in and ranges) and must be
+         * answered by the btree index it's been assigned.
+         */
+        bool isIntersectable(MatchExpression* expr, size_t idx) const;
+
+        /**
+         * Adds the index intersection choices to 'andSolution', which holds the single-index
+         * choices of the AND being memoized.
+         */
+        void addIntersections(AndSolution* andSolution);
+
         // Memoization
 
         // Used to label nodes in the order in which we visit in a post-order traversal.
@@ -28,16 +28,24 @@
 
 #include "mongo/db/query/plan_executor.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // How many units of work a PlanExecutor asks of its plan at once.  Batches take one call per
+    // stage rather than one per stage per result, which adds up on big scans.
+    MONGO_EXPORT_SERVER_PARAMETER(planExecutorBatchSize, int, 1);
+
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt)
-        : _workingSet(ws) , _root(rt) , _killed(false) {
+        : _workingSet(ws) , _root(rt) , _killed(false),
+          _batchSize(std::max(1, static_cast<int>(planExecutorBatchSize))) {
     }
 
     PlanExecutor::~PlanExecutor() {
@@ -63,7 +71,18 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(const DiskLoc& dl) {
-        if (!_killed) { _root->invalidate(dl); }
+        if (_killed) { return; }
+
+        _root->invalidate(dl);
+
+        // The plan is done with the results we're holding on to, so they're up to us.
+        for (std::deque<WorkingSetID>::const_iterator it = _batch.begin(); it != _batch.end();
+             ++it) {
+            WorkingSetMember* member = _workingSet->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     void PlanExecutor::setYieldPolicy(Runner::YieldPolicy policy) {
@@ -80,7 +99,36 @@ namespace mongo {
 
         for (;;) {
             WorkingSetID id;
-            PlanStage::StageState code = _root->work(&id);
+            PlanStage::StageState code;
+
+            if (!_batch.empty()) {
+                // Left over from the last batch.
+                id = _batch.front();
+                _batch.pop_front();
+                code = PlanStage::ADVANCED;
+            }
+            else if (_batchSize > 1) {
+                _batchResults.clear();
+                code = _root->workBatch(_batchSize, &_batchResults, &id);
+                _batch.insert(_batch.end(), _batchResults.begin(), _batchResults.end());
+
+                if (PlanStage::FAILURE == code) {
+                    for (size_t i = 0; i < _batchResults.size(); ++i) {
+                        _workingSet->free(_batchResults[i]);
+                    }
+                    _batch.clear();
+                }
+                else if (PlanStage::NEED_FETCH != code && !_batch.empty()) {
+                    // Return the first result now.  IS_EOF or NEED_TIME will come up again once
+                    // the batch is used up.  After a NEED_FETCH the page-in comes first.
+                    id = _batch.front();
+                    _batch.pop_front();
+                    code = PlanStage::ADVANCED;
+                }
+            }
+            else {
+                code = _root->work(&id);
+            }
             /*
               cout << "gotNext state " << PlanStage::stateStr(code);
               if (PlanStage::ADVANCED == code || PlanStage::NEED_FETCH == code) {
@@ -133,19 +181,28 @@ namespace mongo {
                 // lock between receiving the NEED_FETCH and actually fetching(?).
                 verify(member->hasLoc());
 
-                // Actually bring record into memory.
+                // Actually bring record into memory, along with any other records the plan
+                // will want soon after it.
                 Record* record = member->loc.rec();
+                vector<Record*> records(1, record);
+                vector<DiskLoc> prefetch;
+                _workingSet->takePrefetch(&prefetch);
+                for (size_t i = 0; i < prefetch.size(); ++i) {
+                    records.push_back(prefetch[i].rec());
+                }
 
                 // If we're allowed to, go to disk outside of the lock.
                 if (NULL != _yieldPolicy.get()) {
                     saveState();
-                    _yieldPolicy->yield(record);
+                    _yieldPolicy->yield(records);
                     if (_killed) { return Runner::RUNNER_DEAD; }
                     restoreState();
                 }
                 else {
                     // We're set to manually yield.  We go to disk in the lock.
-                    record->touch();
+                    for (size_t i = 0; i < records.size(); ++i) {
+                        records[i]->touch();
+                    }
                 }
 
                 // Record should be in memory now.  Log if it's not.
@@ -177,7 +234,7 @@ namespace mongo {
     }
 
     bool PlanExecutor::isEOF() {
-        return _killed || _root->isEOF();
+        return _killed || (_batch.empty() && _root->isEOF());
     }
 
     void PlanExecutor::kill() {
@@ -29,8 +29,11 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/runner.h"
 #include "mongo/db/query/runner_yield_policy.h"
 
@@ -40,7 +43,6 @@ namespace mongo {
     class DiskLoc;
     class PlanStage;
     struct PlanStageStats;
-    class WorkingSet;
 
     /**
      * A PlanExecutor is the abstraction that knows how to crank a tree of stages into execution.
@@ -49,6 +51,10 @@ namespace mongo {
      *
      * Executes a plan.  Used by a runner.  Calls work() on a plan until a result is produced.
      * Stops when the plan is EOF or if the plan errors.
+     *
+     * If the planExecutorBatchSize server parameter is more than 1, the plan is run with
+     * workBatch(...) instead, and the results of a batch are handed out by later calls to
+     * getNext(...).
      */
     class PlanExecutor {
     public:
@@ -106,6 +112,15 @@ namespace mongo {
         // Did somebody drop an index we care about or the namespace we're looking at?  If so,
         // we'll be killed.
         bool _killed;
+
+        // How many units of work we ask of _root at once.  1 means we call work().
+        size_t _batchSize;
+
+        // Results of _root's last batch that getNext(...) hasn't returned yet.
+        std::deque<WorkingSetID> _batch;
+
+        // Reused for _root's results.
+        std::vector<WorkingSetID> _batchResults;
     };
 
 }  // namespace mongo
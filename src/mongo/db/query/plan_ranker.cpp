@@ -34,6 +34,13 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/query_solution.h"
 
+namespace {
+
+    // How much a sorted but not yet returned result counts for, compared to a returned one.
+    const double kBlockingSortCredit = 0.5;
+
+}  // namespace
+
 namespace mongo {
 
     // static 
@@ -47,10 +54,12 @@ namespace mongo {
             statTrees.push_back(candidates[i].root->getStats());
         }
 
-        // Compute score for each tree.  Record the best.
+        // Compute score for each tree.  Record the best.  A plan that failed, for instance an
+        // index intersection whose hash table grew too large, can't win.
         double maxScore = 0;
         size_t bestChild = numeric_limits<size_t>::max();
         for (size_t i = 0; i < statTrees.size(); ++i) {
+            if (candidates[i].failed) { continue; }
             double score = scoreTree(*statTrees[i]);
             if (score > maxScore) {
                 maxScore = score;
@@ -88,9 +97,53 @@ namespace mongo {
             //
             // We start all scores at 1.  Our "no plan selected" score is 0 and we want all plans to
             // be greater than that.
-            return 1 + static_cast<double>(stats.common.advanced)
-                   / static_cast<double>(stats.common.works);
+            //
+            // A single index plan fetches every document its index scan produces in order to
+            // filter it, while an index intersection throws away non-matching DiskLocs before
+            // fetching anything.  Charge each document fetch as another unit of work so that the
+            // two compete on what they cost rather than on how many times they were worked.
+            double cost = static_cast<double>(stats.common.works + countFetches(stats));
+
+            // A blocking sort produces nothing until it has read all of its input, so a trial
+            // can't tell a good sort plan from a bad one by its results.  Credit it with part of
+            // what it has sorted so far instead: it still has the rest of its input to read
+            // before it returns anything.  With a limit the sort keeps only the top results, so
+            // reading that input takes bounded memory.
+            double advanced = static_cast<double>(stats.common.advanced);
+            if (0 == stats.common.advanced) {
+                const PlanStageStats* sort = findBlockingSort(stats);
+                if (NULL != sort && 1 == sort->children.size()) {
+                    advanced = kBlockingSortCredit
+                               * static_cast<double>(sort->children[0]->common.advanced);
+                }
+            }
+
+            return 1 + advanced / cost;
+        }
+    }
+
+    // static
+    const PlanStageStats* PlanRanker::findBlockingSort(const PlanStageStats& stats) {
+        const PlanStageStats* cur = &stats;
+        while (STAGE_SORT != cur->stageType) {
+            if (1 != cur->children.size()) { return NULL; }
+            cur = cur->children[0];
+        }
+        return cur;
+    }
+
+    // static
+    size_t PlanRanker::countFetches(const PlanStageStats& stats) {
+        size_t fetches = 0;
+        if (STAGE_FETCH == stats.stageType && 1 == stats.children.size()) {
+            // Everything the child produced was fetched unless it already had the object.
+            const FetchStats* spec = static_cast<const FetchStats*>(stats.specific.get());
+            fetches += stats.children[0]->common.advanced - spec->alreadyHasObj;
+        }
+        for (size_t i = 0; i < stats.children.size(); ++i) {
+            fetches += countFetches(*stats.children[i]);
         }
+        return fetches;
     }
 
 }  // namespace mongo
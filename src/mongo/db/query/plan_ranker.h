@@ -57,6 +57,17 @@ namespace mongo {
          * Assign the stats tree a 'goodness' score.  Used internally.
          */
         static double scoreTree(const PlanStageStats& stats);
+
+        /**
+         * How many documents did the FETCH stages in the stats tree 'stats' fetch?
+         */
+        static size_t countFetches(const PlanStageStats& stats);
+
+        /**
+         * Returns the SORT stage at the top of the stats tree 'stats', looking through stages
+         * with one child, or NULL if there isn't one.
+         */
+        static const PlanStageStats* findBlockingSort(const PlanStageStats& stats);
     };
 
     /**
@@ -65,7 +76,7 @@ namespace mongo {
      */
     struct CandidatePlan {
         CandidatePlan(QuerySolution* s, PlanStage* r, WorkingSet* w)
-            : solution(s), root(r), ws(w), failed(false) { }
+            : solution(s), root(r), ws(w), failed(false), trialTimeMicros(0) { }
 
         QuerySolution* solution;
         PlanStage* root;
@@ -75,6 +86,9 @@ namespace mongo {
         std::deque<WorkingSetID> results;
 
         bool failed;
+
+        // Wall time spent working the plan while it competed with the others.
+        uint64_t trialTimeMicros;
     };
 
     /**
@@ -83,6 +97,7 @@ namespace mongo {
      */
     struct PlanRankingDecision {
         PlanRankingDecision() : statsOfWinner(NULL), onlyOneSolution(false) { }
+        ~PlanRankingDecision() { delete statsOfWinner; }
 
         // Owned by us.
         PlanStageStats* statsOfWinner;
@@ -91,6 +106,8 @@ namespace mongo {
 
         // TODO: We can place anything we want here.  What's useful to the cache?  What's useful to
         // planning and optimization?
+    private:
+        MONGO_DISALLOW_COPYING(PlanRankingDecision);
     };
 
 }  // namespace mongo
@@ -69,6 +69,15 @@ namespace mongo {
             }
         }
 
+        qp->_includedTopLevelOnly = true;
+        for (size_t i = 0; i < qp->_includedFields.size(); ++i) {
+            const string& field = qp->_includedFields[i];
+            qp->_includedFieldSet[field] = true;
+            if (string::npos != field.find('.')) {
+                qp->_includedTopLevelOnly = false;
+            }
+        }
+
         if (qp->_includeID) {
             qp->_includedFields.push_back(string("_id"));
         }
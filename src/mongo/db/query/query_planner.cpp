@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/query_planner.h"
 
+#include <limits>
 #include <map>
 #include <set>
 #include <stack>
@@ -37,6 +38,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_bounds_builder.h"
@@ -44,9 +46,13 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/plan_enumerator.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // The most index scans explodeForSort() will merge to avoid a blocking sort.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
+
     // static
     void QueryPlanner::getFields(MatchExpression* node, string prefix, unordered_set<string>* out) {
         // Leaf nodes with a path and some array operators.
@@ -208,6 +214,7 @@ namespace mongo {
         csn->name = query.ns();
         csn->filter.reset(query.root()->shallowClone());
         csn->tailable = tailable;
+        csn->prefetchExtents = query.getParsed().getPrefetchExtents();
 
         // If the sort is {$natural: +-1} this changes the direction of the collection scan.
         const BSONObj& sortObj = query.getParsed().getSort();
@@ -424,6 +431,87 @@ namespace mongo {
         }
     }
 
+    // static
+    bool QueryPlanner::isCoveredFilter(const MatchExpression* expr, const IndexEntry& index) {
+        // A multikey index has one key per array element, so the key isn't the field's value.
+        if (index.multikey) { return false; }
+
+        switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!isCoveredFilter(expr->getChild(i), index)) {
+                    return false;
+                }
+            }
+            return true;
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            // {a: []} and {a: [1]} have the single, non-multikey keys undefined and 1, which an
+            // array operand can't be compared against.
+            const ComparisonMatchExpression* cme =
+                static_cast<const ComparisonMatchExpression*>(expr);
+            if (Array == cme->getData().type()) { return false; }
+            break;
+        }
+        case MatchExpression::MATCH_IN: {
+            // Same as above for any array in the $in list ($nin is a NOT over an $in).
+            const InMatchExpression* ime = static_cast<const InMatchExpression*>(expr);
+            const BSONElementSet& equalities = ime->getData().equalities();
+            for (BSONElementSet::const_iterator it = equalities.begin();
+                 it != equalities.end(); ++it) {
+                if (Array == it->type()) { return false; }
+            }
+            break;
+        }
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+            break;
+        default:
+            // $exists and $type tell a missing field from a null one but the index key doesn't.
+            // Array, geo and $where predicates need the document.
+            return false;
+        }
+
+        // The key for a non-btree index (hashed, 2d, ...) isn't the value of the field.
+        BSONObjIterator it(index.keyPattern);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            if (!elt.isNumber()) { return false; }
+            if (expr->path() == elt.fieldName()) { return true; }
+        }
+        return false;
+    }
+
+    // static
+    QuerySolutionNode* QueryPlanner::addFilterToIndexedNode(MatchExpression* filter,
+                                                            QuerySolutionNode* node,
+                                                            const vector<IndexEntry>& indices) {
+        if (STAGE_IXSCAN == node->getType()) {
+            IndexScanNode* isn = static_cast<IndexScanNode*>(node);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                if (0 != indices[i].keyPattern.woCompare(isn->indexKeyPattern)) { continue; }
+                if (NULL == isn->filter.get() && isCoveredFilter(filter, indices[i])) {
+                    // The scan can apply the filter to its keys.  Takes ownership.
+                    isn->filter.reset(filter);
+                    return isn;
+                }
+                break;
+            }
+        }
+
+        FetchNode* fetch = new FetchNode();
+        // Takes ownership.
+        fetch->filter.reset(filter);
+        fetch->child.reset(node);
+        return fetch;
+    }
+
     // static
     bool QueryPlanner::processIndexScans(MatchExpression* root,
                                          bool inArrayOperator,
@@ -679,13 +767,9 @@ namespace mongo {
         // If there are any nodes still attached to the AND, we can't answer them using the
         // index, so we put a fetch with filter.
         if (root->numChildren() > 0) {
-            FetchNode* fetch = new FetchNode();
             verify(NULL != autoRoot.get());
-            // Takes ownership.
-            fetch->filter.reset(autoRoot.release());
-            // takes ownership
-            fetch->child.reset(andResult);
-            andResult = fetch;
+            // Takes ownership of both.
+            andResult = addFilterToIndexedNode(autoRoot.release(), andResult, indices);
         }
         else {
             // root has no children, let autoRoot get rid of it when it goes out of scope.
@@ -823,11 +907,9 @@ namespace mongo {
                     return soln;
                 }
 
-                FetchNode* fetch = new FetchNode();
+                // If the index has the field, the scan can check the predicate itself.
                 verify(NULL != autoRoot.get());
-                fetch->filter.reset(autoRoot.release());
-                fetch->child.reset(soln);
-                return fetch;
+                return addFilterToIndexedNode(autoRoot.release(), soln, indices);
             }
             else if (Indexability::arrayUsesIndexOnChildren(root)) {
                 QuerySolutionNode* solution = NULL;
@@ -881,6 +963,133 @@ namespace mongo {
         return NULL;
     }
 
+    namespace {
+
+        bool isPointInterval(const Interval& interval) {
+            return interval.startInclusive && interval.endInclusive
+                && 0 == interval.start.woCompare(interval.end, false);
+        }
+
+    }  // namespace
+
+    // static
+    QuerySolutionNode* QueryPlanner::explodeForSort(const BSONObj& sortObj,
+                                                    QuerySolutionNode* solnRoot) {
+        // The scan is either the root or under a fetch.
+        FetchNode* fetch = NULL;
+        QuerySolutionNode* scanNode = solnRoot;
+        if (STAGE_FETCH == scanNode->getType()) {
+            fetch = static_cast<FetchNode*>(scanNode);
+            scanNode = fetch->child.get();
+        }
+        if (STAGE_IXSCAN != scanNode->getType()) { return solnRoot; }
+
+        IndexScanNode* isn = static_cast<IndexScanNode*>(scanNode);
+        const IndexBounds& bounds = isn->bounds;
+        if (bounds.isSimpleRange || sortObj.isEmpty()) { return solnRoot; }
+
+        // Find where the sort fields start in the key pattern.  Every field before them must
+        // be constrained to points, and the sort fields must follow in the direction we scan.
+        vector<BSONElement> keyFields;
+        BSONObjIterator kpIt(isn->indexKeyPattern);
+        while (kpIt.more()) { keyFields.push_back(kpIt.next()); }
+        if (keyFields.size() != bounds.fields.size()) { return solnRoot; }
+
+        const string firstSortField = sortObj.firstElement().fieldName();
+        size_t prefixLen = 0;
+        while (prefixLen < keyFields.size() && firstSortField != keyFields[prefixLen].fieldName()) {
+            ++prefixLen;
+        }
+        if (0 == prefixLen || prefixLen + sortObj.nFields() > keyFields.size()) {
+            return solnRoot;
+        }
+
+        size_t sortField = prefixLen;
+        BSONObjIterator sortIt(sortObj);
+        while (sortIt.more()) {
+            BSONElement elt = sortIt.next();
+            const BSONElement& keyElt = keyFields[sortField++];
+            if (!keyElt.isNumber() || !elt.isNumber()) { return solnRoot; }
+            int keyDirection = (keyElt.number() >= 0 ? 1 : -1) * isn->direction;
+            int sortDirection = elt.number() >= 0 ? 1 : -1;
+            if (string(elt.fieldName()) != keyElt.fieldName() || keyDirection != sortDirection) {
+                return solnRoot;
+            }
+        }
+
+        // One scan per combination of the prefix points.  Past a limit a blocking sort of the
+        // one scan's results is cheaper than seeking around that many.
+        size_t numScans = 1;
+        for (size_t i = 0; i < prefixLen; ++i) {
+            const vector<Interval>& intervals = bounds.fields[i].intervals;
+            for (size_t j = 0; j < intervals.size(); ++j) {
+                if (!isPointInterval(intervals[j])) { return solnRoot; }
+            }
+            numScans *= intervals.size();
+            if (0 == numScans
+                || numScans > static_cast<size_t>(internalQueryMaxScansToExplode)) {
+                return solnRoot;
+            }
+        }
+
+        // Each scan returns its keys in sort order, so merging them gives the whole result in
+        // sort order.  The same document can be in several scans if the index is multikey.
+        MergeSortNode* msn = new MergeSortNode();
+        msn->sort = sortObj;
+        msn->dedup = true;
+
+        vector<size_t> pointIndex(prefixLen, 0);
+        for (size_t scan = 0; scan < numScans; ++scan) {
+            IndexScanNode* child = new IndexScanNode();
+            child->indexKeyPattern = isn->indexKeyPattern;
+            child->direction = isn->direction;
+            child->limit = isn->limit;
+            child->bounds = bounds;
+            for (size_t i = 0; i < prefixLen; ++i) {
+                Interval point = bounds.fields[i].intervals[pointIndex[i]];
+                child->bounds.fields[i].intervals.clear();
+                child->bounds.fields[i].intervals.push_back(point);
+            }
+            if (NULL != isn->filter.get()) {
+                child->filter.reset(isn->filter->shallowClone());
+            }
+            msn->children.push_back(child);
+
+            // Next combination, rightmost field first.
+            for (size_t i = prefixLen; i > 0; --i) {
+                if (++pointIndex[i - 1] < bounds.fields[i - 1].intervals.size()) { break; }
+                pointIndex[i - 1] = 0;
+            }
+        }
+
+        if (NULL != fetch) {
+            fetch->child.reset(msn);
+            return fetch;
+        }
+        delete isn;
+        return msn;
+    }
+
+    // static
+    bool QueryPlanner::pushSkipIntoIndexScan(int skip, QuerySolutionNode* solnRoot) {
+        QuerySolutionNode* node = solnRoot;
+        if (STAGE_PROJECTION == node->getType()) {
+            node = static_cast<ProjectionNode*>(node)->child.get();
+        }
+        if (STAGE_FETCH == node->getType()) {
+            FetchNode* fetch = static_cast<FetchNode*>(node);
+            // A fetch that filters can drop what the scan returns, so the scan can't count the
+            // skipped results.
+            if (NULL != fetch->filter.get()) { return false; }
+            node = fetch->child.get();
+        }
+        if (STAGE_IXSCAN != node->getType()) { return false; }
+
+        // The scan applies its own filter and dedups before it counts a result as skipped.
+        static_cast<IndexScanNode*>(node)->skip = skip;
+        return true;
+    }
+
     // static
     QuerySolution* QueryPlanner::analyzeDataAccess(const CanonicalQuery& query,
                                                    QuerySolutionNode* solnRoot) {
@@ -900,6 +1109,12 @@ namespace mongo {
             // outputted a collscan to satisfy the desired order.
             BSONElement natural = sortObj.getFieldDotted("$natural");
             if (natural.eoo()) {
+                // An index scan over a few points followed by the sort fields can stream the
+                // sort by merging one scan per point.
+                if (0 != sortObj.woCompare(solnRoot->getSort())) {
+                    solnRoot = explodeForSort(sortObj, solnRoot);
+                }
+
                 // See if solnRoot gives us the sort.  If so, we're done.
                 if (0 == sortObj.woCompare(solnRoot->getSort())) {
                     // Sort is already provided!
@@ -929,6 +1144,15 @@ namespace mongo {
                     SortNode* sort = new SortNode();
                     sort->pattern = sortObj;
                     sort->child.reset(solnRoot);
+
+                    // Only the first skip + ntoreturn results are returned, so that's all the
+                    // sort has to keep.
+                    const LiteParsedQuery& lpq = query.getParsed();
+                    if (lpq.getNumToReturn() > 0
+                        && lpq.getSkip() <= std::numeric_limits<int>::max() - lpq.getNumToReturn()) {
+                        sort->limit = lpq.getSkip() + lpq.getNumToReturn();
+                    }
+                    sort->allowExternalSort = lpq.allowDiskUse();
                     solnRoot = sort;
                 }
             }
@@ -979,7 +1203,8 @@ namespace mongo {
             }
         }
 
-        if (0 != query.getParsed().getSkip()) {
+        if (0 != query.getParsed().getSkip()
+            && !pushSkipIntoIndexScan(query.getParsed().getSkip(), solnRoot)) {
             SkipNode* skip = new SkipNode();
             skip->skip = query.getParsed().getSkip();
             skip->child.reset(solnRoot);
@@ -1186,13 +1411,11 @@ namespace mongo {
                 ++field;
             }
 
-            // TODO: We may not need to do the fetch if the predicates in root are covered.  But
-            // for now it's safe (though *maybe* slower).
-            FetchNode* fetch = new FetchNode();
-            fetch->filter.reset(query.root()->shallowClone());
-            fetch->child.reset(isn);
+            // If the predicates in root are covered by the index they're applied by the scan.
+            QuerySolutionNode* solnRoot = addFilterToIndexedNode(query.root()->shallowClone(),
+                                                                 isn, indices);
 
-            QuerySolution* soln = analyzeDataAccess(query, fetch);
+            QuerySolution* soln = analyzeDataAccess(query, solnRoot);
             verify(NULL != soln);
             out->push_back(soln);
 
@@ -1233,13 +1456,12 @@ namespace mongo {
                                                                   &isn->bounds.fields[field]);
                         }
 
-                        // TODO: We may not need to do the fetch if the predicates in root are
-                        // covered.  But for now it's safe (though *maybe* slower).
-                        FetchNode* fetch = new FetchNode();
-                        fetch->filter.reset(query.root()->shallowClone());
-                        fetch->child.reset(isn);
+                        // If the predicates in root are covered by the index they're applied
+                        // by the scan.
+                        QuerySolutionNode* solnRoot =
+                            addFilterToIndexedNode(query.root()->shallowClone(), isn, indices);
 
-                        QuerySolution* soln = analyzeDataAccess(query, fetch);
+                        QuerySolution* soln = analyzeDataAccess(query, solnRoot);
                         verify(NULL != soln);
                         out->push_back(soln);
                         cout << "using index to provide sort, soln = " << soln->toString() << endl;
@@ -207,6 +207,25 @@ namespace mongo {
          */
         static void finishLeafNode(QuerySolutionNode* node, const BSONObj& indexKeyPattern);
 
+        /**
+         * Can 'expr' be evaluated using only the keys of 'index'?  True if every predicate in
+         * 'expr' is over a field of 'index' and gives the same answer on that field's key as on
+         * the document itself.  This rules out multikey and non-btree indices, and predicates
+         * that tell a missing field apart from a null one.
+         */
+        static bool isCoveredFilter(const MatchExpression* expr, const IndexEntry& index);
+
+        /**
+         * Apply 'filter' to the results of 'node'.  If 'node' is an index scan over an index that
+         * covers 'filter', the filter is hung on the scan and no documents are fetched.
+         * Otherwise a fetch with 'filter' is placed above 'node'.
+         *
+         * Takes ownership of 'filter' and 'node'.  Returns the new root.
+         */
+        static QuerySolutionNode* addFilterToIndexedNode(MatchExpression* filter,
+                                                         QuerySolutionNode* node,
+                                                         const vector<IndexEntry>& indices);
+
         //
         // Analysis of Data Access
         //
@@ -227,6 +246,25 @@ namespace mongo {
          */
         static QuerySolution* analyzeDataAccess(const CanonicalQuery& query,
                                                 QuerySolutionNode* solnRoot);
+
+        /**
+         * If 'solnRoot' is an index scan (possibly under a fetch) whose leading fields are
+         * constrained to a few points and are followed in the key pattern by 'sortObj', replace
+         * the scan with a merge sort of one scan per combination of points, which provides
+         * 'sortObj' without a blocking sort.  Otherwise returns 'solnRoot' unchanged.
+         *
+         * Takes ownership of 'solnRoot' and returns the new root.
+         */
+        static QuerySolutionNode* explodeForSort(const BSONObj& sortObj,
+                                                 QuerySolutionNode* solnRoot);
+
+        /**
+         * If every result of the index scan at the bottom of 'solnRoot' is a result of the query,
+         * that is if only a projection and a fetch without a filter sit above it, have the scan
+         * drop the first 'skip' results itself so they are never fetched.  Returns false, leaving
+         * the tree alone, if there's no such scan.
+         */
+        static bool pushSkipIntoIndexScan(int skip, QuerySolutionNode* solnRoot);
     };
 
 }  // namespace mongo
@@ -64,6 +64,11 @@ namespace {
             keyPatterns.push_back(IndexEntry(keyPattern, false, false));
         }
 
+        void setMultikeyIndex(BSONObj keyPattern) {
+            // The false means not sparse.
+            keyPatterns.push_back(IndexEntry(keyPattern, true, false));
+        }
+
         //
         // Execute planner.
         //
@@ -130,6 +135,23 @@ namespace {
             }
         }
 
+        /**
+         * How many solutions fetch the results of an index intersection of type 'andType'?
+         */
+        size_t countIntersections(StageType andType) const {
+            size_t found = 0;
+            for (vector<QuerySolution*>::const_iterator it = solns.begin();
+                 it != solns.end();
+                 ++it) {
+                if (STAGE_FETCH != (*it)->root->getType()) { continue; }
+                FetchNode* fn = static_cast<FetchNode*>((*it)->root.get());
+                if (fn->child->getType() == andType) {
+                    found++;
+                }
+            }
+            return found;
+        }
+
         // { 'field': [ [min, max, startInclusive, endInclusive], ... ], 'field': ... }
         void boundsEqual(BSONObj boundsObj, IndexBounds bounds) const {
             ASSERT_EQUALS(static_cast<int>(bounds.size()), boundsObj.nFields());
@@ -427,6 +449,79 @@ namespace {
         }
     }
 
+    TEST_F(SingleIndexTest, CoveredFilterOnIndexScan) {
+        setIndex(BSON("x" << 1 << "y" << 1));
+        // The regex bounds aren't exact but the index has x, so the scan applies the regex.
+        runDetailedQuery(fromjson("{x: /abc/, y: {$ne: 3}}"), BSONObj(),
+                         fromjson("{_id: 0, x: 1, y: 1}"));
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        ASSERT_EQUALS(solns.size(), 2U);
+
+        size_t ixscans = 0;
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            if (STAGE_IXSCAN == pn->child->getType()) {
+                IndexScanNode* isn = static_cast<IndexScanNode*>(pn->child.get());
+                ASSERT(NULL != isn->filter.get());
+                ++ixscans;
+            }
+            else {
+                ASSERT_EQUALS(STAGE_COLLSCAN, pn->child->getType());
+            }
+        }
+        ASSERT_EQUALS(ixscans, 1U);
+    }
+
+    TEST_F(SingleIndexTest, UncoveredFilterNeedsFetch) {
+        setIndex(BSON("x" << 1));
+        // y isn't in the index, so its predicate needs the document.
+        runDetailedQuery(fromjson("{x: {$gt: 1}, y: 1}"), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            ASSERT(STAGE_IXSCAN != pn->child->getType());
+        }
+    }
+
+    TEST_F(SingleIndexTest, ArrayOperandNeedsFetch) {
+        setIndex(BSON("x" << 1));
+        // {x: []} and {x: [1]} have the non-multikey keys undefined and 1, so an array operand
+        // can't be compared against the key.
+        const char* queries[] = { "{x: []}", "{x: [1]}", "{x: {$gt: [1]}}", "{x: {$in: [[1]]}}",
+                                  "{x: {$in: [2, []]}}", "{x: {$nin: [[1]]}}" };
+        for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+            runDetailedQuery(fromjson(queries[i]), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+            vector<QuerySolution*> solns;
+            getAllPlans(STAGE_PROJECTION, &solns);
+            for (size_t j = 0; j < solns.size(); ++j) {
+                ProjectionNode* pn = static_cast<ProjectionNode*>(solns[j]->root.get());
+                ASSERT(STAGE_IXSCAN != pn->child->getType());
+            }
+        }
+    }
+
+    TEST_F(SingleIndexTest, MultikeyFilterNeedsFetch) {
+        setMultikeyIndex(BSON("x" << 1));
+        runDetailedQuery(fromjson("{x: /abc/}"), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            if (STAGE_FETCH == pn->child->getType()) {
+                FetchNode* fn = static_cast<FetchNode*>(pn->child.get());
+                ASSERT_EQUALS(STAGE_IXSCAN, fn->child->getType());
+                ASSERT(NULL == static_cast<IndexScanNode*>(fn->child.get())->filter.get());
+            }
+        }
+    }
+
     //
     // Basic sort elimination
     //
@@ -444,6 +539,36 @@ namespace {
         getPlanByType(STAGE_FETCH, &indexedSolution);
     }
 
+    TEST_F(SingleIndexTest, InWithSortUsesMergeSort) {
+        setIndex(BSON("a" << 1 << "b" << 1));
+        runDetailedQuery(fromjson("{a: {$in: [1, 2, 3]}}"), fromjson("{b: 1}"), BSONObj());
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+
+        QuerySolution* collScanSolution;
+        getPlanByType(STAGE_SORT, &collScanSolution);
+
+        // The indexed solution merges one scan per $in value instead of sorting.
+        QuerySolution* indexedSolution;
+        getPlanByType(STAGE_FETCH, &indexedSolution);
+        FetchNode* fn = static_cast<FetchNode*>(indexedSolution->root.get());
+        ASSERT_EQUALS(fn->child->getType(), STAGE_SORT_MERGE);
+        MergeSortNode* msn = static_cast<MergeSortNode*>(fn->child.get());
+        ASSERT_EQUALS(msn->children.size(), 3U);
+        for (size_t i = 0; i < msn->children.size(); ++i) {
+            ASSERT_EQUALS(msn->children[i]->getType(), STAGE_IXSCAN);
+            IndexScanNode* isn = static_cast<IndexScanNode*>(msn->children[i]);
+            ASSERT_EQUALS(isn->bounds.getNumIntervals(0), 1U);
+        }
+    }
+
+    TEST_F(SingleIndexTest, RangeWithSortNeedsBlockingSort) {
+        setIndex(BSON("a" << 1 << "b" << 1));
+        runDetailedQuery(fromjson("{a: {$gt: 1}}"), fromjson("{b: 1}"), BSONObj());
+        vector<QuerySolution*> sorted;
+        getAllPlans(STAGE_SORT, &sorted);
+        ASSERT_EQUALS(sorted.size(), getNumSolutions());
+    }
+
     //
     // Basic compound
     //
@@ -642,6 +767,69 @@ namespace {
         ASSERT_EQUALS(getNumSolutions(), 2U);
     }
 
+    //
+    // Index intersection
+    //
+
+    TEST_F(SingleIndexTest, IntersectEqualities) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: 1, b: 2}"));
+        // Collection scan, one index, and both indices.
+        ASSERT_EQUALS(getNumSolutions(), 3U);
+
+        // Point scans come back in DiskLoc order, so the intersection is a merge.
+        ASSERT_EQUALS(countIntersections(STAGE_AND_SORTED), 1U);
+        ASSERT_EQUALS(countIntersections(STAGE_AND_HASH), 0U);
+    }
+
+    TEST_F(SingleIndexTest, IntersectRanges) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: {$gt: 1}, b: {$lt: 5}}"));
+        ASSERT_EQUALS(getNumSolutions(), 3U);
+        ASSERT_EQUALS(countIntersections(STAGE_AND_HASH), 1U);
+    }
+
+    TEST_F(SingleIndexTest, IntersectThreeIndices) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        setIndex(BSON("c" << 1));
+        runQuery(fromjson("{a: 1, b: 2, c: 3}"));
+        // Collection scan, one index, three pairs of indices, and all three.
+        ASSERT_EQUALS(getNumSolutions(), 6U);
+        ASSERT_EQUALS(countIntersections(STAGE_AND_SORTED), 4U);
+    }
+
+    TEST_F(SingleIndexTest, IntersectSameIndexPredicates) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: {$gt: 1, $lt: 5}, b: 2}"));
+        ASSERT_EQUALS(getNumSolutions(), 3U);
+        ASSERT_EQUALS(countIntersections(STAGE_AND_HASH), 1U);
+    }
+
+    TEST_F(SingleIndexTest, NoIntersectMultikey) {
+        setMultikeyIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: 1, b: 2}"));
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+    }
+
+    TEST_F(SingleIndexTest, NoIntersectUnselective) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: {$exists: true}, b: 2}"));
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+    }
+
+    TEST_F(SingleIndexTest, NoIntersectUnderOr) {
+        setIndex(BSON("a" << 1));
+        setIndex(BSON("b" << 1));
+        runQuery(fromjson("{$or: [{a: 1, b: 2}, {a: 3}]}"));
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+    }
+
     // STOPPED HERE - need to hook up machinery for multiple indexed predicates
     //                second is not working (until the machinery is in place)
     //
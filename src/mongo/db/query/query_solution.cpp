@@ -34,7 +34,8 @@ namespace mongo {
     // CollectionScanNode
     //
 
-    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), filter(NULL) { }
+    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), prefetchExtents(-1),
+                                               filter(NULL) { }
 
     void CollectionScanNode::appendToString(stringstream* ss, int indent) const {
         addIndent(ss, indent);
@@ -309,7 +310,7 @@ namespace mongo {
     // IndexScanNode
     //
 
-    IndexScanNode::IndexScanNode() : filter(NULL), limit(0), direction(1) { }
+    IndexScanNode::IndexScanNode() : filter(NULL), limit(0), direction(1), skip(0) { }
 
     void IndexScanNode::appendToString(stringstream* ss, int indent) const {
         addIndent(ss, indent);
@@ -324,6 +325,10 @@ namespace mongo {
         *ss << "dir = " << direction << endl;
         addIndent(ss, indent + 1);
         *ss << "bounds = " << bounds.toString() << endl;
+        if (0 != skip) {
+            addIndent(ss, indent + 1);
+            *ss << "skip = " << skip << endl;
+        }
         addIndent(ss, indent + 1);
         *ss << "fetched = " << fetched() << endl;
         addIndent(ss, indent + 1);
@@ -398,6 +403,10 @@ namespace mongo {
         addIndent(ss, indent + 1);
         *ss << "pattern = " << pattern.toString() << endl;
         addIndent(ss, indent + 1);
+        *ss << "limit = " << limit << endl;
+        addIndent(ss, indent + 1);
+        *ss << "allowExternalSort = " << allowExternalSort << endl;
+        addIndent(ss, indent + 1);
         *ss << "fetched = " << fetched() << endl;
         addIndent(ss, indent + 1);
         *ss << "sortedByDiskLoc = " << sortedByDiskLoc() << endl;
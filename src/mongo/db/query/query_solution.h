@@ -173,6 +173,9 @@ namespace mongo {
 
         int direction;
 
+        // See CollectionScanParams::prefetchExtents.
+        int prefetchExtents;
+
         scoped_ptr<MatchExpression> filter;
     };
 
@@ -304,6 +307,10 @@ namespace mongo {
 
         int direction;
 
+        // Results the scan drops itself, see IndexScanParams::skip.  Set by the planner when a
+        // skip can be applied before the fetch.
+        int skip;
+
         // BIG NOTE:
         // If you use simple bounds, we'll use whatever index access method the keypattern implies.
         // If you use the complex bounds, we force Btree access.
@@ -354,7 +361,7 @@ namespace mongo {
     };
 
     struct SortNode : public QuerySolutionNode {
-        SortNode() { }
+        SortNode() : limit(0), allowExternalSort(false) { }
         virtual ~SortNode() { }
 
         virtual StageType getType() const { return STAGE_SORT; }
@@ -369,6 +376,10 @@ namespace mongo {
         BSONObj pattern;
         scoped_ptr<QuerySolutionNode> child;
         // TODO: Filter
+
+        // See SortStageParams.
+        int limit;
+        bool allowExternalSort;
     };
 
     struct LimitNode : public QuerySolutionNode {
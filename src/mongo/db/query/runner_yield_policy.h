@@ -79,9 +79,19 @@ namespace mongo {
          * Used for YIELD_AUTO runners.
          */
         void yield(Record* rec = NULL) {
+            vector<Record*> recs;
+            if (NULL != rec) { recs.push_back(rec); }
+            yield(recs);
+        }
+
+        /**
+         * Yield, fetching the provided records.  If there are any, the lock is always given up,
+         * so that the disk reads never happen while it is held.
+         */
+        void yield(const vector<Record*>& recs) {
             int micros = ClientCursor::suggestYieldMicros();
-            if (micros > 0) {
-                staticYield(micros, rec);
+            if (micros > 0 || !recs.empty()) {
+                ClientCursor::staticYield(micros, "", recs);
                 _elapsedTracker.resetLastTime();
             }
         }
@@ -51,6 +51,7 @@ namespace mongo {
             CollectionScanParams params;
             params.ns = csn->name;
             params.tailable = csn->tailable;
+            params.prefetchExtents = csn->prefetchExtents;
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             return new CollectionScan(params, ws, csn->filter.get());
@@ -80,6 +81,7 @@ namespace mongo {
             params.bounds = ixn->bounds;
             params.direction = ixn->direction;
             params.limit = ixn->limit;
+            params.skip = ixn->skip;
             return new IndexScan(params, ws, ixn->filter.get());
         }
         else if (STAGE_FETCH == root->getType()) {
@@ -94,6 +96,8 @@ namespace mongo {
             if (NULL == childStage) { return NULL; }
             SortStageParams params;
             params.pattern = sn->pattern;
+            params.limit = sn->limit;
+            params.allowExternalSort = sn->allowExternalSort;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -40,6 +40,7 @@ namespace mongo {
     const BSONField<std::vector<TypeExplain*> > TypeExplain::allPlans("allPlans");
     const BSONField<TypeExplain*> TypeExplain::oldPlan("oldPlan");
     const BSONField<std::string> TypeExplain::server("server");
+    const BSONField<BSONObj> TypeExplain::stats("stats");
 
     TypeExplain::TypeExplain() {
         clear();
@@ -156,6 +157,8 @@ namespace mongo {
 
         if (_isServerSet) builder.append(server(), _server);
 
+        if (_isStatsSet) builder.append(stats(), _stats);
+
         return builder.obj();
     }
 
@@ -241,6 +244,10 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isServerSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, stats, &_stats, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isStatsSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -293,6 +300,8 @@ namespace mongo {
         _server.clear();
         _isServerSet = false;
 
+        _stats = BSONObj();
+        _isStatsSet = false;
     }
 
     void TypeExplain::cloneTo(TypeExplain* other) const {
@@ -368,6 +377,9 @@ namespace mongo {
 
         other->_server = _server;
         other->_isServerSet = _isServerSet;
+
+        other->_stats = _stats;
+        other->_isStatsSet = _isStatsSet;
     }
 
     std::string TypeExplain::toString() const {
@@ -741,4 +753,22 @@ namespace mongo {
         return _server;
     }
 
+    void TypeExplain::setStats(const BSONObj& stats) {
+        _stats = stats.getOwned();
+        _isStatsSet = true;
+    }
+
+    void TypeExplain::unsetStats() {
+         _isStatsSet = false;
+    }
+
+    bool TypeExplain::isStatsSet() const {
+         return _isStatsSet;
+    }
+
+    const BSONObj& TypeExplain::getStats() const {
+        dassert(_isStatsSet);
+        return _stats;
+    }
+
 } // namespace mongo
@@ -52,6 +52,7 @@ namespace mongo {
         static const BSONField<std::vector<TypeExplain*> > allPlans;
         static const BSONField<TypeExplain*> oldPlan;
         static const BSONField<std::string> server;
+        static const BSONField<BSONObj> stats;
 
         //
         // construction / destruction
@@ -168,6 +169,11 @@ namespace mongo {
         bool isServerSet() const;
         const std::string& getServer() const;
 
+        void setStats(const BSONObj& stats);
+        void unsetStats();
+        bool isStatsSet() const;
+        const BSONObj& getStats() const;
+
     private:
         // Convention: (M)andatory, (O)ptional
 
@@ -235,6 +241,10 @@ namespace mongo {
         // (O)  server's host:port against which the query ran
         std::string _server;
         bool _isServerSet;
+
+        // (O)  execution statistics of every stage in the plan
+        BSONObj _stats;
+        bool _isStatsSet;
     };
 
 } // namespace mongo
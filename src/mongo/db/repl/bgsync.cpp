@@ -108,7 +108,7 @@ namespace replset {
         notify();
     }
 
-    void BackgroundSync::notify() {
+    void BackgroundSync::notifyOplogWritten() {
         {
             boost::unique_lock<boost::mutex> lock(s_mutex);
             if (s_instance == NULL) {
@@ -120,6 +120,17 @@ namespace replset {
             boost::unique_lock<boost::mutex> opLock(s_instance->_lastOpMutex);
             s_instance->_lastOpCond.notify_all();
         }
+    }
+
+    void BackgroundSync::notify() {
+        {
+            boost::unique_lock<boost::mutex> lock(s_mutex);
+            if (s_instance == NULL) {
+                return;
+            }
+        }
+
+        notifyOplogWritten();
 
         {
             boost::unique_lock<boost::mutex> lock(s_instance->_mutex);
@@ -135,6 +135,9 @@ namespace replset {
         static BackgroundSync* get();
         static void shutdown();
         static void notify();
+        // Wakes the notifier thread after ops were written to the oplog, without marking the
+        // buffer as applied.  Used while later ops taken from the buffer are still in flight.
+        static void notifyOplogWritten();
 
         virtual ~BackgroundSync() {}
 
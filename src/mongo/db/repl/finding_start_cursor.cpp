@@ -28,17 +28,109 @@
 
 #include "mongo/db/repl/finding_start_cursor.h"
 
+#include <map>
+#include <vector>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/cursor.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/query_plan.h"
 #include "mongo/db/queryutil.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
     // Configurable for testing.
     int FindingStartCursor::_initialTimeout = 5;
 
+    namespace {
+
+        /**
+         * A sparse index of the extents of capped collections, oldest first, so the extent
+         * holding a given ts can be found by binary search instead of by walking the extents
+         * backwards.  The data in a capped collection only changes in the extent being written,
+         * so an index stays valid until the collection moves on to its next extent; it is then
+         * rebuilt on the next lookup.
+         */
+        class CappedExtentIndex {
+        public:
+            struct Entry {
+                DiskLoc extent;
+                DiskLoc firstRecord;
+            };
+
+            /**
+             * @return the nonempty extents of capped collection 'ns', oldest first.  The extent
+             * being written is left out of a collection that has looped, as its first record is
+             * not its oldest.  Caller holds the db lock.
+             */
+            std::vector<Entry> get( const std::string& ns, const NamespaceDetails* nsd ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                Index& index = _indexes[ns];
+                if ( index.nsd != nsd || index.capExtent != nsd->capExtent() ||
+                     index.looped != nsd->capLooped() ) {
+                    build( nsd, &index );
+                }
+                return index.entries;
+            }
+
+            /** Drops the index of 'ns', after finding one of its entries out of date. */
+            void invalidate( const std::string& ns ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                _indexes.erase( ns );
+            }
+
+        private:
+            struct Index {
+                Index() : nsd( NULL ), looped( false ) {}
+                const NamespaceDetails* nsd;
+                DiskLoc capExtent;
+                bool looped;
+                std::vector<Entry> entries;
+            };
+
+            static void build( const NamespaceDetails* nsd, Index* index ) {
+                index->nsd = nsd;
+                index->capExtent = nsd->capExtent();
+                index->looped = nsd->capLooped();
+                index->entries.clear();
+
+                if ( nsd->firstExtent().isNull() )
+                    return;
+
+                // Unlooped, the extents are in age order from the first.  Looped, the oldest
+                // data follows the extent being written, wrapping around to the first extent.
+                DiskLoc start = nsd->firstExtent();
+                if ( index->looped ) {
+                    start = nsd->capExtent().ext()->xnext;
+                    if ( start.isNull() )
+                        start = nsd->firstExtent();
+                }
+
+                DiskLoc loc = start;
+                do {
+                    Extent* e = loc.ext();
+                    if ( !( index->looped && loc == nsd->capExtent() ) &&
+                         !e->firstRecord.isNull() ) {
+                        Entry entry;
+                        entry.extent = loc;
+                        entry.firstRecord = e->firstRecord;
+                        index->entries.push_back( entry );
+                    }
+                    loc = e->xnext;
+                    if ( loc.isNull() && index->looped )
+                        loc = nsd->firstExtent();
+                } while ( !loc.isNull() && loc != start );
+            }
+
+            SimpleMutex _mutex;
+            std::map<std::string, Index> _indexes;
+        };
+
+        CappedExtentIndex cappedExtentIndex;
+
+    } // namespace
+
     // -------------------------------------
 
     FindingStartCursor *FindingStartCursor::make( const QueryPlan &qp ) {
@@ -166,6 +258,47 @@ namespace mongo {
         _findingStartCursor.reset( new ClientCursor(QueryOption_NoCursorTimeout, c, _qp.ns()) );
     }
 
+    bool FindingStartCursor::matches( const DiskLoc& loc ) const {
+        shared_ptr<Cursor> c = _qp.newCursor( loc );
+        return c->ok() && _matcher->matchesCurrent( c.get() );
+    }
+
+    DiskLoc FindingStartCursor::indexedExtentFirstLoc() const {
+        const NamespaceDetails* nsd = _qp.nsd();
+        if ( !nsd->isCapped() )
+            return DiskLoc();
+
+        std::vector<CappedExtentIndex::Entry> entries = cappedExtentIndex.get( _qp.ns(), nsd );
+
+        // The first docs of the extents go from not matching to matching.  Find the newest
+        // extent whose first doc doesn't match: the first matching doc is within it or starts
+        // the next one.
+        int lo = 0;
+        int hi = static_cast<int>( entries.size() ) - 1;
+        int found = -1;
+        while ( lo <= hi ) {
+            int mid = lo + ( hi - lo ) / 2;
+            const CappedExtentIndex::Entry& entry = entries[mid];
+            if ( entry.extent.ext()->firstRecord != entry.firstRecord ) {
+                // stale, e.g. after the collection was emptied
+                cappedExtentIndex.invalidate( _qp.ns() );
+                return DiskLoc();
+            }
+            if ( matches( entry.firstRecord ) ) {
+                hi = mid - 1;
+            }
+            else {
+                found = mid;
+                lo = mid + 1;
+            }
+        }
+
+        // A start in the newest extents is found faster by the backward scan.
+        if ( found < 0 || found == static_cast<int>( entries.size() ) - 1 )
+            return DiskLoc();
+        return entries[found].firstRecord;
+    }
+
     bool FindingStartCursor::firstDocMatchesOrEmpty() const {
         shared_ptr<Cursor> c = _qp.newCursor();
         return !c->ok() || _matcher->matchesCurrent( c.get() );
@@ -183,6 +316,13 @@ namespace mongo {
             _findingStart = false;
             return;
         }
+        // For an older start, go straight to the extent holding it.
+        DiskLoc extentStart = indexedExtentFirstLoc();
+        if ( !extentStart.isNull() ) {
+            createClientCursor( extentStart );
+            _findingStartMode = InExtent;
+            return;
+        }
         // Use a ClientCursor here so we can release db mutex while scanning
         // oplog (can take quite a while with large oplogs).
         shared_ptr<Cursor> c = _qp.newReverseCursor();
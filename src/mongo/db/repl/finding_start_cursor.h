@@ -120,6 +120,15 @@ namespace mongo {
             _findingStartCursor.reset( 0 );
         }
         bool firstDocMatchesOrEmpty() const;
+
+        /** @return true if the doc at @param loc matches the ts query. */
+        bool matches( const DiskLoc& loc ) const;
+
+        /**
+         * @return the first record of the extent the first matching op is in, looked up in the
+         *     collection's extent index, or DiskLoc() to use the backward scan instead.
+         */
+        DiskLoc indexedExtentFirstLoc() const;
     };
 
 }
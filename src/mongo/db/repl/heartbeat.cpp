@@ -30,11 +30,13 @@
 
 #include <boost/thread/thread.hpp>
 
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/connections.h"
 #include "mongo/db/repl/health.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs.h"
 #include "mongo/util/background.h"
@@ -78,6 +80,7 @@ namespace mongo {
         skew = newInfo.skew;
         authIssue = newInfo.authIssue;
         ping = newInfo.ping;
+        syncLoad = newInfo.syncLoad;
     }
 
     /* { replSetHeartbeat : <setname> } */
@@ -163,6 +166,12 @@ namespace mongo {
             if (syncTarget) {
                 result.append("syncingTo", syncTarget->fullName());
             }
+            {
+                // members choosing a sync source prefer the less loaded ones
+                set<CursorId> oplogCursors;
+                ClientCursor::find(rsoplog, oplogCursors);
+                result.append("syncLoad", static_cast<int>(oplogCursors.size()));
+            }
 
             int v = theReplSet->config().version;
             result.append("v", v);
@@ -464,6 +473,9 @@ namespace mongo {
             if( info.hasElement("opTime") )
                 mem.opTime = info["opTime"].Date();
 
+            // older members don't report it
+            mem.syncLoad = info["syncLoad"].isNumber() ? info["syncLoad"].numberInt() : -1;
+
             // see if this member is in the electable set
             if( info["e"].eoo() ) {
                 // for backwards compatibility
@@ -51,6 +51,7 @@
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/s/d_logic.h"
@@ -350,6 +351,7 @@ namespace mongo {
     /*@ @param opstr:
           c userCreateNS
           i insert
+          bi batched insert, see logOpInserts()
           n no-op / keepalive
           d delete / remove
           u update
@@ -370,6 +372,41 @@ namespace mongo {
         getGlobalAuthorizationManager()->logOp(opstr, ns, obj, patt, b, fromMigrate, fullObj);
     }
 
+    // When true, the documents of a multi-document insert are written to the oplog as one
+    // "bi" entry.  Only members which understand "bi" entries can replicate from such an oplog.
+    MONGO_EXPORT_SERVER_PARAMETER( replBatchInsertOplogEntries, bool, false );
+
+    bool batchInsertOplogEntries(const char* ns) {
+        return replBatchInsertOplogEntries && replSettings.master &&
+               !NamespaceString(ns).isSystem();
+    }
+
+    void logOpInserts(const char* ns, const std::vector<BSONObj>& docs) {
+        if ( docs.empty() )
+            return;
+
+        if ( replSettings.master ) {
+            if ( docs.size() == 1 || !batchInsertOplogEntries(ns) ) {
+                for ( size_t i = 0; i < docs.size(); i++ )
+                    _logOp("i", ns, 0, docs[i], 0, 0, false);
+            }
+            else {
+                BSONObjBuilder b;
+                BSONArrayBuilder arr(b.subarrayStart("docs"));
+                for ( size_t i = 0; i < docs.size(); i++ )
+                    arr.append(docs[i]);
+                arr.done();
+                _logOp("bi", ns, 0, b.done(), 0, 0, false);
+            }
+        }
+
+        for ( size_t i = 0; i < docs.size(); i++ ) {
+            logOpForSharding("i", ns, docs[i], 0, 0, false);
+            logOpForDbHash("i", ns, docs[i], 0, 0, false);
+            getGlobalAuthorizationManager()->logOp("i", ns, docs[i], 0, 0, false, 0);
+        }
+    }
+
     void createOplog() {
         Lock::GlobalWrite lk;
 
@@ -453,6 +490,67 @@ namespace mongo {
 
     // -------------------------------------
 
+    /** Applies the insert of 'o' into 'ns', as an upsert so that it may be replayed. */
+    static void applyInsert_inlock(const char* ns, NamespaceDetails* nsd, const BSONObj& o) {
+        const char *p = strchr(ns, '.');
+        if ( p && strcmp(p, ".system.indexes") == 0 ) {
+            if (IndexBuilder::buildsInBackground(o)) {
+                IndexBuilder* builder = new IndexBuilder(ns, o);
+                // This spawns a new thread and returns immediately.
+                builder->go();
+            }
+            else {
+                IndexBuilder builder(ns, o);
+                // Finish the foreground build before returning
+                builder.build();
+            }
+        }
+        else {
+            // do upserts for inserts as we might get replayed more than once
+            OpDebug debug;
+            BSONElement _id;
+            if( !o.getObjectID(_id) ) {
+                /* No _id.  This will be very slow. */
+                Timer t;
+
+                const NamespaceString requestNs(ns);
+                UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
+
+                request.setQuery(o);
+                request.setUpdates(o);
+                request.setUpsert();
+                request.setFromReplication();
+
+                update(request, &debug);
+
+                if( t.millis() >= 2 ) {
+                    RARELY OCCASIONALLY log() << "warning, repl doing slow updates (no _id field) for " << ns << endl;
+                }
+            }
+            else {
+                // probably don't need this since all replicated colls have _id indexes now
+                // but keep it just in case
+                RARELY if ( nsd && !nsd->isCapped() ) { ensureHaveIdIndex(ns, false); }
+
+                /* todo : it may be better to do an insert here, and then catch the dup key exception and do update
+                          then.  very few upserts will not be inserts...
+                          */
+                BSONObjBuilder b;
+                b.append(_id);
+
+                const NamespaceString requestNs(ns);
+                UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
+
+                request.setQuery(b.done());
+                request.setUpdates(o);
+                request.setUpsert();
+                request.setFromReplication();
+
+                update(request, &debug);
+            }
+        }
+    }
+
     /** @param fromRepl false if from ApplyOpsCmd
         @return true if was and update should have happened and the document DNE.  see replset initial sync code.
      */
@@ -481,63 +579,13 @@ namespace mongo {
 
         if ( *opType == 'i' ) {
             opCounters->gotInsert();
-
-            const char *p = strchr(ns, '.');
-            if ( p && strcmp(p, ".system.indexes") == 0 ) {
-                if (o["background"].trueValue()) {
-                    IndexBuilder* builder = new IndexBuilder(ns, o);
-                    // This spawns a new thread and returns immediately.
-                    builder->go();
-                }
-                else {
-                    IndexBuilder builder(ns, o);
-                    // Finish the foreground build before returning
-                    builder.build();
-                }
-            }
-            else {
-                // do upserts for inserts as we might get replayed more than once
-                OpDebug debug;
-                BSONElement _id;
-                if( !o.getObjectID(_id) ) {
-                    /* No _id.  This will be very slow. */
-                    Timer t;
-
-                    const NamespaceString requestNs(ns);
-                    UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
-
-                    request.setQuery(o);
-                    request.setUpdates(o);
-                    request.setUpsert();
-                    request.setFromReplication();
-
-                    update(request, &debug);
-
-                    if( t.millis() >= 2 ) {
-                        RARELY OCCASIONALLY log() << "warning, repl doing slow updates (no _id field) for " << ns << endl;
-                    }
-                }
-                else {
-                    // probably don't need this since all replicated colls have _id indexes now
-                    // but keep it just in case
-                    RARELY if ( nsd && !nsd->isCapped() ) { ensureHaveIdIndex(ns, false); }
-
-                    /* todo : it may be better to do an insert here, and then catch the dup key exception and do update
-                              then.  very few upserts will not be inserts...
-                              */
-                    BSONObjBuilder b;
-                    b.append(_id);
-
-                    const NamespaceString requestNs(ns);
-                    UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
-
-                    request.setQuery(b.done());
-                    request.setUpdates(o);
-                    request.setUpsert();
-                    request.setFromReplication();
-
-                    update(request, &debug);
-                }
+            applyInsert_inlock(ns, nsd, o);
+        }
+        else if ( opType[0] == 'b' && opType[1] == 'i' ) {
+            BSONObjIterator i(o.getObjectField("docs"));
+            while ( i.more() ) {
+                opCounters->gotInsert();
+                applyInsert_inlock(ns, nsd, i.next().Obj());
             }
         }
         else if ( *opType == 'u' ) {
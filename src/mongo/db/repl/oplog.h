@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 namespace mongo {
 
     class BSONObj;
@@ -57,6 +59,7 @@ namespace mongo {
         "u" update
         "d" delete
         "c" db cmd
+        "bi" batched insert, see logOpInserts()
         "n" no-op
         "db" declares presence of a database (ns is set to the db name + '.')
 
@@ -70,6 +73,17 @@ namespace mongo {
                 BSONObj *patt = NULL, bool *b = NULL, bool fromMigrate = false,
                 const BSONObj* fullObj = NULL );
 
+    /**
+     * Logs the insert of each of 'docs' into 'ns', like logOp("i", ...) for each.  If
+     * batchInsertOplogEntries(ns), several documents are logged as one batched insert entry
+     *     { ts: ..., h: ..., v: ..., op: "bi", ns: <ns>, o: { docs: [ <doc>, ... ] } }
+     * which is applied as the inserts of its documents, in order.
+     */
+    void logOpInserts( const char *ns, const std::vector<BSONObj>& docs );
+
+    /** @return true if inserts into 'ns' may be logged as batched insert entries. */
+    bool batchInsertOplogEntries( const char *ns );
+
     // Log an empty no-op operation to the local oplog
     void logKeepalive();
 
@@ -42,6 +42,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/wire_version.h"
+#include "mongo/util/net/message_compression.h"
 
 namespace mongo {
 
@@ -181,6 +182,7 @@ namespace mongo {
             result.appendDate("localTime", jsTime());
             result.append("maxWireVersion", maxWireVersion);
             result.append("minWireVersion", minWireVersion);
+            negotiateWireCompression(cmdObj, cc().port(), &result);
             return true;
         }
     } cmdismaster;
@@ -465,6 +465,7 @@ namespace mongo {
         ghost(0),
         _writerPool(replWriterThreadCount),
         _prefetcherPool(replPrefetcherThreadCount),
+        _oplogWriterPool(1),
         oplogVersion(0),
         _indexPrefetchConfig(PREFETCH_ALL) {
     }
@@ -561,6 +561,8 @@ namespace mongo {
         threadpool::ThreadPool _writerPool;
         // persistent pool of worker threads for prefetching
         threadpool::ThreadPool _prefetcherPool;
+        // single worker thread writing applied batches to the local oplog
+        threadpool::ThreadPool _oplogWriterPool;
 
     public:
         // Allow index prefetching to be turned on/off
@@ -579,6 +581,7 @@ namespace mongo {
         static const int replPrefetcherThreadCount;
         threadpool::ThreadPool& getPrefetchPool() { return _prefetcherPool; }
         threadpool::ThreadPool& getWriterPool() { return _writerPool; }
+        threadpool::ThreadPool& getOplogWriterPool() { return _oplogWriterPool; }
 
         static const int maxSyncSourceLagSecs;
 
@@ -649,6 +652,7 @@ namespace mongo {
         void fillIsMaster(BSONObjBuilder& b) { _fillIsMaster(b); }
         threadpool::ThreadPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
         threadpool::ThreadPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
+        threadpool::ThreadPool& getOplogWriterPool() { return ReplSetImpl::getOplogWriterPool(); }
 
         /**
          * We have a new config (reconfig) - apply it.
@@ -39,6 +39,7 @@
 #include "mongo/bson/optime.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -48,6 +49,14 @@ namespace mongo {
 
     void dropAllDatabasesExceptLocal();
 
+    // Number of collections of a database initial sync copies at once, each over its own
+    // connection to the sync source.
+    MONGO_EXPORT_SERVER_PARAMETER( initialSyncCloneThreads, int, 4 );
+
+    // Milliseconds of ping a sync source candidate is charged for each member already tailing
+    // its oplog, so that secondaries spread out over the members close to them.
+    MONGO_EXPORT_SERVER_PARAMETER( replSyncSourceLoadPenaltyMillis, int, 10 );
+
     // add try/catch with sleep
 
     void isyncassert(const string& msg, bool expr) {
@@ -106,6 +115,7 @@ namespace mongo {
             options.mayBeInterrupted = false;
             options.syncData = dataPass;
             options.syncIndexes = ! dataPass;
+            options.parallelCollections = initialSyncCloneThreads;
 
             if (!cloner.go(master, options, err, &errCode)) {
                 sethbmsg(str::stream() << "initial sync: error while "
@@ -138,6 +148,26 @@ namespace mongo {
         return hbinfo().up() && (config().buildIndexes || !buildIndexes) && state().readable();
     }
 
+    /**
+     * @return how many members are syncing from "m": the oplog cursors it reported, or, if it
+     * didn't report any (older versions), the members whose heartbeats name it as their target
+     */
+    static int syncSourceLoad(const Member* m, const Member* members) {
+        int load = m->hbinfo().syncLoad;
+        int following = 0;
+        for (const Member* other = members; other; other = other->next()) {
+            if (other->hbinfo().syncingTo.get() == m->fullName())
+                following++;
+        }
+        return max(load, following);
+    }
+
+    /** @return the ping of "m" plus the penalty for the members already syncing from it */
+    static long long syncSourceCost(const Member* m, const Member* members) {
+        return m->hbinfo().ping +
+            static_cast<long long>(replSyncSourceLoadPenaltyMillis) * syncSourceLoad(m, members);
+    }
+
     const Member* ReplSetImpl::getMemberToSyncTo() {
         lock lk(this);
 
@@ -168,7 +198,8 @@ namespace mongo {
             }
         }
 
-        // find the member with the lowest ping time that has more data than me
+        // find the member with the lowest ping time, allowing for how many members already sync
+        // from it, that has more data than me
 
         // Find primary's oplog time. Reject sync candidates that are more than
         // maxSyncSourceLagSecs seconds behind.
@@ -209,9 +240,11 @@ namespace mongo {
                         continue;
                 }
 
-                // omit nodes that are more latent than anything we've already considered
+                // omit nodes that are more latent, or more loaded, than anything we've already
+                // considered
                 if (closest &&
-                    (m->hbinfo().ping > closest->hbinfo().ping))
+                    (syncSourceCost(m, _members.head()) >
+                     syncSourceCost(closest, _members.head())))
                     continue;
 
                 if (attempts == 0 &&
@@ -84,7 +84,8 @@ namespace mongo {
         unsigned _id;
     public:
         HeartbeatInfo() : _id(0xffffffff), hbstate(MemberState::RS_UNKNOWN), health(-1.0),
-            downSince(0), lastHeartbeatRecv(0), skew(INT_MIN), authIssue(false), ping(0) { }
+            downSince(0), lastHeartbeatRecv(0), skew(INT_MIN), authIssue(false), ping(0),
+            syncLoad(0) { }
         HeartbeatInfo(unsigned id);
         unsigned id() const { return _id; }
         MemberState hbstate;
@@ -101,6 +102,8 @@ namespace mongo {
         int skew;
         bool authIssue;
         unsigned int ping; // milliseconds
+        // number of cursors tailing the member's oplog, as it reported; -1 if it didn't
+        int syncLoad;
         static unsigned int numPings;
 
         bool up() const { return health > 0; }
@@ -124,7 +127,8 @@ namespace mongo {
         _id(id),
         lastHeartbeatRecv(0),
         authIssue(false),
-        ping(0) {
+        ping(0),
+        syncLoad(-1) {
         hbstate = MemberState::RS_UNKNOWN;
         health = -1.0;
         downSince = 0;
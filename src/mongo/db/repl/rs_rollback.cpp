@@ -198,6 +198,20 @@ namespace mongo {
             }
         }
 
+        if( op[0] == 'b' && op[1] == 'i' ) {
+            /* batched insert: { ..., op: "bi", ns: ..., o: { docs: [ ... ] } } */
+            BSONObjIterator i(o.getObjectField("docs"));
+            while( i.more() ) {
+                d._id = i.next().Obj()["_id"];
+                if( d._id.eoo() ) {
+                    log() << "replSet WARNING ignoring op on rollback no _id TODO : " << d.ns << ' '<< ourObj.toString() << rsLog;
+                    continue;
+                }
+                h.toRefetch.insert(d);
+            }
+            return;
+        }
+
         d._id = o["_id"];
         if( d._id.eoo() ) {
             log() << "replSet WARNING ignoring op on rollback no _id TODO : " << d.ns << ' '<< ourObj.toString() << rsLog;
@@ -317,6 +331,44 @@ namespace mongo {
         bson::bo goodVersionOfObject;
     };
 
+    // most _ids, and bytes of _ids, asked for by one refetch query
+    static const size_t refetchBatchSize = 1000;
+    static const int refetchBatchBytes = 1024 * 1024;
+
+    /**
+     * Fetches the current versions of the documents in "batch", which are all in one
+     * collection, with a single $in query.  A document the source doesn't have is added to
+     * goodVersions as an empty object, so that it's deleted.
+     */
+    static void refetchBatch(DBClientConnection* them, const vector<DocID>& batch,
+                             list< pair<DocID,bo> >& goodVersions, unsigned long long& totSize) {
+        BSONObjBuilder query;
+        {
+            BSONObjBuilder idClause(query.subobjStart("_id"));
+            BSONArrayBuilder in(idClause.subarrayStart("$in"));
+            for( size_t i = 0; i < batch.size(); i++ )
+                in.append(batch[i]._id);
+            in.done();
+            idClause.done();
+        }
+
+        map<bo, bo, BSONObjCmp> found;
+        auto_ptr<DBClientCursor> c = them->query(batch.front().ns, query.obj(), 0, 0, NULL,
+                                                 QueryOption_SlaveOk);
+        uassert(17319, "replSet rollback couldn't query the sync source", c.get());
+        while( c->more() ) {
+            bo good = c->nextSafe().getOwned();
+            totSize += good.objsize();
+            uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
+            found[good["_id"].wrap("")] = good;
+        }
+
+        for( size_t i = 0; i < batch.size(); i++ ) {
+            map<bo, bo, BSONObjCmp>::const_iterator it = found.find(batch[i]._id.wrap(""));
+            goodVersions.push_back(pair<DocID,bo>(batch[i], it == found.end() ? bo() : it->second));
+        }
+    }
+
     void ReplSetImpl::syncFixUp(HowToFixUp& h, OplogReader& r) {
         DBClientConnection *them = r.conn();
 
@@ -328,26 +380,33 @@ namespace mongo {
 
         bo newMinValid;
 
-        /* fetch all the goodVersions of each document from current primary */
+        /* fetch all the goodVersions of each document from current primary.  toRefetch is
+           ordered by ns, so a collection's documents are asked for together, a batch at a time. */
         DocID d;
         unsigned long long n = 0;
         try {
+            vector<DocID> batch;
+            int batchBytes = 0;
             for( set<DocID>::iterator i = h.toRefetch.begin(); i != h.toRefetch.end(); i++ ) {
                 d = *i;
 
                 verify( !d._id.eoo() );
 
-                {
-                    /* TODO : slow.  lots of round trips. */
-                    n++;
-                    bo good= them->findOne(d.ns, d._id.wrap(), NULL, QueryOption_SlaveOk).getOwned();
-                    totSize += good.objsize();
-                    uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
-
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID,bo>(d,good));
+                n++;
+                if( !batch.empty() &&
+                    ( strcmp(batch.back().ns, d.ns) != 0 ||
+                      batch.size() >= refetchBatchSize ||
+                      batchBytes + d._id.size() > refetchBatchBytes ) ) {
+                    refetchBatch(them, batch, goodVersions, totSize);
+                    batch.clear();
+                    batchBytes = 0;
                 }
+                batch.push_back(d);
+                batchBytes += d._id.size();
             }
+            if( !batch.empty() )
+                refetchBatch(them, batch, goodVersions, totSize);
+
             newMinValid = r.getLastOp(rsoplog);
             if( newMinValid.isEmpty() ) {
                 sethbmsg("rollback error newMinValid empty?");
@@ -37,6 +37,8 @@
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
@@ -48,6 +50,7 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/base/counter.h"
+#include "mongo/db/server_parameters.h"
 
 
 
@@ -77,12 +80,25 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    // When true, a batch is written to the local oplog by a separate thread while the next
+    // batch is prefetched and applied.
+    MONGO_EXPORT_SERVER_PARAMETER( replPipelineOplogWrites, bool, true );
+
+    // When true, CRUD ops on a collection are spread across writer threads by document _id
+    // rather than all being applied by the single writer owning the namespace.
+    MONGO_EXPORT_SERVER_PARAMETER( replWriterSplitByDocument, bool, true );
+
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
-        Sync(""), oplogVersion(0), _networkQueue(q)
+        Sync(""), oplogVersion(0), _networkQueue(q), _oplogWritePending(false)
     {}
 
-    SyncTail::~SyncTail() {}
+    SyncTail::~SyncTail() {
+        // The oplog writer thread may still reference _oplogWriteOps
+        if (_oplogWritePending) {
+            theReplSet->getOplogWriterPool().join();
+        }
+    }
 
     bool SyncTail::peek(BSONObj* op) {
         return _networkQueue->peek(op);
@@ -136,6 +152,15 @@ namespace replset {
     }
 
     static AtomicUInt32 replWriterWorkerId;
+    void initializeOplogWriterThread() {
+        if (!ClientBasic::getCurrent()) {
+            Client::initThread("repl oplog writer");
+            // the next batch holds the barrier while we write this one
+            Lock::ParallelBatchWriterMode::iAmABatchParticipant();
+            replLocalAuth();
+        }
+    }
+
     void initializeWriterThread() {
         // Only do this once per thread
         if (!ClientBasic::getCurrent()) {
@@ -271,8 +296,71 @@ namespace replset {
     }
 
 
+namespace {
+    /**
+     * Returns the _id element identifying the document a CRUD op modifies, or an EOO element if
+     * the op does not name a single document.
+     */
+    BSONElement getDocumentId(const BSONObj& op) {
+        const char* opType = op.getStringField("op");
+        if (opType[0] == 'i' || opType[0] == 'd') {
+            return op.getObjectField("o")["_id"];
+        }
+        if (opType[0] == 'u') {
+            return op.getObjectField("o2")["_id"];
+        }
+        return BSONElement();
+    }
+
+    /**
+     * Returns true if ops on different documents of 'ns' commute, so they may be applied by
+     * different writers. Ops on capped collections depend on insertion order, and ops on
+     * collections with a unique secondary index can transiently collide on its keys when
+     * reordered, so those stay with the namespace's writer.
+     */
+    bool canSplitByDocument(const std::string& ns) {
+        if (NamespaceString(ns).isSystem()) {
+            return false;
+        }
+
+        Client::ReadContext ctx(ns);
+        NamespaceDetails* nsd = nsdetails(ns);
+        if (NULL == nsd || nsd->isCapped()) {
+            return false;
+        }
+
+        NamespaceDetails::IndexIterator ii = nsd->ii(true);
+        while (ii.more()) {
+            IndexDetails& idx = ii.next();
+            if (idx.unique() && !idx.isIdIndex()) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Decide per namespace, for the whole batch, whether its ops may be split by document.
+        // Every op on a split namespace must name its document, otherwise an op without an _id
+        // could be reordered against the ops it depends on.
+        std::map<std::string, bool> splitNamespaces;
+        if (replWriterSplitByDocument) {
+            for (std::deque<BSONObj>::const_iterator it = ops.begin();
+                 it != ops.end();
+                 ++it) {
+                const std::string ns = it->getStringField("ns");
+                std::map<std::string, bool>::iterator split = splitNamespaces.find(ns);
+                if (split == splitNamespaces.end()) {
+                    split = splitNamespaces.insert(make_pair(ns, canSplitByDocument(ns))).first;
+                }
+                if (split->second && getDocumentId(*it).eoo()) {
+                    split->second = false;
+                }
+            }
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -283,6 +371,15 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            std::map<std::string, bool>::const_iterator split = splitNamespaces.find(ns);
+            if (split != splitNamespaces.end() && split->second) {
+                // Ops on the same document always land on the same writer and keep their
+                // relative order. The hasher treats numerically equal _ids as the same key.
+                long long idHash = BSONElementHasher::hash64(getDocumentId(*it),
+                                                             BSONElementHasher::DEFAULT_HASH_SEED);
+                hash ^= static_cast<uint32_t>(idHash) ^ static_cast<uint32_t>(idHash >> 32);
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
@@ -399,6 +496,7 @@ namespace replset {
             do {
                 if (theReplSet->isPrimary()) {
                     massert(16620, "there are ops to sync, but I'm primary", ops.empty());
+                    waitForOplogWrites();
                     return;
                 }
 
@@ -433,6 +531,7 @@ namespace replset {
                         // When would mgr be null?  During replsettest'ing, in which case we should
                         // fall through and actually apply ops as if we were a real secondary.
                         if (mgr) { 
+                            waitForOplogWrites();
                             mgr->send(boost::bind(&Manager::msgCheckNewState, theReplSet->mgr));
                             sleepsecs(1);
                             // There should never be ops to sync in a 1-member set, anyway
@@ -475,12 +574,19 @@ namespace replset {
 
             multiApply(ops.getDeque(), multiSyncApply);
 
-            applyOpsToOplog(&ops.getDeque());
+            if (replPipelineOplogWrites) {
+                applyOpsToOplogAsync(&ops.getDeque());
+            }
+            else {
+                waitForOplogWrites();
+                applyOpsToOplog(&ops.getDeque());
+            }
 
             // If we're just testing (no manager), don't keep looping if we exhausted the bgqueue
             if (!theReplSet->mgr) {
                 BSONObj op;
                 if (!peek(&op)) {
+                    waitForOplogWrites();
                     return;
                 }
             }
@@ -502,6 +608,8 @@ namespace replset {
         if (!peek_success) {
             // if we don't have anything in the queue, wait a bit for something to appear
             if (ops->empty()) {
+                // nothing else is in flight, so finish the last batch before going idle
+                waitForOplogWrites();
                 // block up to 1 second
                 _networkQueue->waitForMore();
                 return false;
@@ -574,6 +682,49 @@ namespace replset {
         BackgroundSync::notify();
     }
 
+    void SyncTail::applyOpsToOplogAsync(std::deque<BSONObj>* ops) {
+        ThreadPool& oplogWriterPool = theReplSet->getOplogWriterPool();
+        if (_oplogWritePending) {
+            oplogWriterPool.join();
+            // Let the primary know about the previous batch.  The producer thread must not
+            // consider the buffer applied yet since this batch is still being written.
+            BackgroundSync::notifyOplogWritten();
+        }
+
+        _oplogWriteOps.swap(*ops);
+        _oplogWritePending = true;
+        oplogWriterPool.schedule(&writeOpsToOplog, &_oplogWriteOps);
+    }
+
+    void SyncTail::waitForOplogWrites() {
+        if (!_oplogWritePending) {
+            return;
+        }
+
+        theReplSet->getOplogWriterPool().join();
+        _oplogWritePending = false;
+
+        // Update write concern on primary
+        BackgroundSync::notify();
+    }
+
+    void SyncTail::writeOpsToOplog(std::deque<BSONObj>* ops) {
+        initializeOplogWriterThread();
+        try {
+            Lock::DBWrite lk("local");
+            while (!ops->empty()) {
+                const BSONObj& op = ops->front();
+                // this updates theReplSet->lastOpTimeWritten
+                _logOpObjRS(op);
+                ops->pop_front();
+            }
+        }
+        catch (const DBException& e) {
+            error() << "oplog writer caught exception: " << causedBy(e) << endl;
+            fassertFailed(17184);
+        }
+    }
+
     void SyncTail::handleSlaveDelay(const BSONObj& lastOp) {
         int sd = theReplSet->myConfig().slaveDelay;
 
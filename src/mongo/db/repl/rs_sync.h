@@ -106,6 +106,15 @@ namespace replset {
         // Ops are removed from the deque.
         void applyOpsToOplog(std::deque<BSONObj>* ops);
 
+        // Like applyOpsToOplog, but hands the ops to the oplog writer thread so the next batch
+        // can be prefetched and applied while they are written.  Waits first for the previously
+        // handed off batch, so at most one batch is being written at a time.
+        void applyOpsToOplogAsync(std::deque<BSONObj>* ops);
+
+        // Waits until every batch handed to the oplog writer thread has been written, then
+        // notifies the primary that we have applied the ops.
+        void waitForOplogWrites();
+
     protected:
         // Cap the batches using the limit on journal commits.
         // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
@@ -136,6 +145,13 @@ namespace replset {
                                std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
         void setOplogVersion(const BSONObj& op);
+
+        // Used by the oplog writer thread to write a batch to the local oplog
+        static void writeOpsToOplog(std::deque<BSONObj>* ops);
+
+        // The batch owned by the oplog writer thread, if _oplogWritePending
+        std::deque<BSONObj> _oplogWriteOps;
+        bool _oplogWritePending;
     };
 
     /**
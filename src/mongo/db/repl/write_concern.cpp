@@ -77,6 +77,7 @@ namespace mongo {
             _dirty = false;
             _started = false;
             _currentlyUpdatingCache = false;
+            _updates = 0;
         }
 
         void run() {
@@ -140,6 +141,7 @@ namespace mongo {
             if (last > _slaves[ident]) {
                 _slaves[ident] = last;
                 _dirty = true;
+                _updates++;
 
                 if (theReplSet && theReplSet->isPrimary()) {
                     theReplSet->ghost->updateSlave(ident.obj["_id"].OID(), last);
@@ -222,6 +224,28 @@ namespace mongo {
             return true;
         }
 
+        unsigned long long getUpdateCount() const {
+            scoped_lock mylk(_mutex);
+            return _updates;
+        }
+
+        void waitForUpdate(unsigned long long lastSeen, int maxMillis) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, MONGO_BOOST_TIME_UTC);
+            xt.sec += maxMillis / 1000;
+            xt.nsec += (maxMillis % 1000) * 1000000;
+            if (xt.nsec >= 1000000000) {
+                xt.nsec -= 1000000000;
+                xt.sec++;
+            }
+
+            scoped_lock mylk(_mutex);
+            while (_updates == lastSeen) {
+                if (!_threadsWaitingForReplication.timed_wait(mylk.boost(), xt))
+                    return;
+            }
+        }
+
         bool _replicatedToNum_slaves_locked(OpTime& op, int numSlaves ) {
             for ( map<Ident,OpTime>::iterator i=_slaves.begin(); i!=_slaves.end(); i++) {
                 OpTime s = i->second;
@@ -265,6 +289,7 @@ namespace mongo {
         bool _dirty;
         bool _started;
         bool _currentlyUpdatingCache; // this is not thread safe, but ok for our purposes
+        unsigned long long _updates; // bumped whenever a slave's position advances
 
     } slaveTracking;
 
@@ -335,6 +360,14 @@ namespace mongo {
         return slaveTracking.waitForReplication( op, w, maxSecondsToWait );
     }
 
+    unsigned long long getSlaveUpdateCount() {
+        return slaveTracking.getUpdateCount();
+    }
+
+    void waitForSlaveUpdate(unsigned long long lastSeen, int maxMillis) {
+        slaveTracking.waitForUpdate(lastSeen, maxMillis);
+    }
+
     vector<BSONObj> getHostsWrittenTo(OpTime& op) {
         return slaveTracking.getHostsAtOp(op);
     }
@@ -51,6 +51,15 @@ namespace mongo {
 
     bool waitForReplication( OpTime op , int w , int maxSecondsToWait );
 
+    /**
+     * Counts the slave position updates seen; a waiter reads it before checking
+     * opReplicatedEnough() and passes it to waitForSlaveUpdate(), so no update is missed.
+     */
+    unsigned long long getSlaveUpdateCount();
+
+    /** Waits up to maxMillis for a slave to report progress past the "lastSeen" count. */
+    void waitForSlaveUpdate( unsigned long long lastSeen , int maxMillis );
+
     std::vector<BSONObj> getHostsWrittenTo(OpTime& op);
 
     void resetSlaveCache();
@@ -132,6 +132,18 @@ namespace mongo {
         if (!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("serviceExecutor", "serviceExecutor", moe::String,
+                    "how connections are served: threadPerConnection (default) or pooled "
+                    "(a fixed pool of threads, linux only)", true));
+        if (!ret.isOK()) {
+            return ret;
+        }
+        ret = options->addOption(OD("serviceExecutorThreads", "serviceExecutorThreads", moe::Int,
+                    "number of threads serving connections with --serviceExecutor pooled "
+                    "(default: twice the number of cores, at least 8)", true));
+        if (!ret.isOK()) {
+            return ret;
+        }
         ret = options->addOption(OD("logpath", "logpath", moe::String,
                     "log file to send write to instead of stdout - has to be a file, not directory",
                     true));
@@ -434,6 +446,30 @@ namespace mongo {
             }
         }
 
+        if (params.count("serviceExecutor")) {
+            std::string executor = params["serviceExecutor"].as<std::string>();
+            if (executor == "pooled") {
+#ifdef __linux__
+                serverGlobalParams.pooledServiceExecutor = true;
+#else
+                return Status(ErrorCodes::BadValue,
+                              "serviceExecutor pooled is only supported on linux");
+#endif
+            }
+            else if (executor != "threadPerConnection") {
+                return Status(ErrorCodes::BadValue,
+                              "serviceExecutor must be threadPerConnection or pooled");
+            }
+        }
+
+        if (params.count("serviceExecutorThreads")) {
+            serverGlobalParams.serviceExecutorThreads = params["serviceExecutorThreads"].as<int>();
+
+            if (serverGlobalParams.serviceExecutorThreads < 1) {
+                return Status(ErrorCodes::BadValue, "serviceExecutorThreads has to be at least 1");
+            }
+        }
+
         if (params.count("objcheck")) {
             serverGlobalParams.objcheck = true;
         }
@@ -52,6 +52,7 @@ namespace mongo {
             configsvr(false), cpu(false), objcheck(true), defaultProfile(0),
             slowMS(100), defaultLocalThresholdMillis(15), moveParanoia(true),
             noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN),
+            pooledServiceExecutor(false), serviceExecutorThreads(0),
             logAppend(false), logWithSyslog(false), isHttpInterfaceEnabled(false)
         {
             started = time(0);
@@ -93,6 +94,9 @@ namespace mongo {
 
         int maxConns;          // Maximum number of simultaneous open connections.
 
+        bool pooledServiceExecutor;  // --serviceExecutor pooled: serve connections on a pool
+        int serviceExecutorThreads;  // --serviceExecutorThreads: size of that pool, 0 for default
+
         std::string keyFile;   // Path to keyfile, or empty if none.
         std::string pidFile;   // Path to pid file, or empty if none.
 
@@ -48,12 +48,17 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <snappy.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "mongo/base/string_data.h"
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/goodies.h"
@@ -164,6 +169,8 @@ namespace mongo {
                 , _fileName(fileName)
                 , _fileDeleter(fileDeleter)
                 , _file(_fileName.c_str(), std::ios::in | std::ios::binary)
+                , _offset(0)
+                , _readAheadFd(-1)
             {
                 massert(16814, str::stream() << "error opening file \"" << _fileName << "\": "
                                              << myErrnoWithDescription(),
@@ -171,6 +178,18 @@ namespace mongo {
 
                 massert(16815, str::stream() << "unexpected empty file: " << _fileName,
                         boost::filesystem::file_size(_fileName) != 0);
+
+#ifdef POSIX_FADV_WILLNEED
+                // only used for read-ahead hints, so it is fine if this fails
+                _readAheadFd = ::open(_fileName.c_str(), O_RDONLY);
+#endif
+            }
+
+            ~FileIterator() {
+#ifdef POSIX_FADV_WILLNEED
+                if (_readAheadFd >= 0)
+                    ::close(_readAheadFd);
+#endif
             }
 
             bool more() {
@@ -211,6 +230,8 @@ namespace mongo {
                 read(_buffer.get(), blockSize);
                 massert(16816, "file too short?", !_done);
 
+                readAhead();
+
                 if (!compressed) {
                     _reader.reset(new BufReader(_buffer.get(), blockSize));
                     return;
@@ -233,6 +254,19 @@ namespace mongo {
                 _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
             }
 
+            /**
+             * Asks the OS to start reading the blocks after the one we just read, so that the
+             * disk works on them while the merge consumes this one rather than when the merge
+             * gets to them. A merge reads many files a block at a time each, so they otherwise
+             * get little read-ahead.
+             */
+            void readAhead() {
+#ifdef POSIX_FADV_WILLNEED
+                if (_readAheadFd >= 0)
+                    posix_fadvise(_readAheadFd, _offset, kReadAheadBytes, POSIX_FADV_WILLNEED);
+#endif
+            }
+
             // sets _done to true on EOF - asserts on any other error
             void read(void* out, size_t size) {
                 _file.read(reinterpret_cast<char*>(out), size);
@@ -247,8 +281,11 @@ namespace mongo {
                                                      << myErrnoWithDescription());
                 }
                 verify(_file.gcount() == static_cast<std::streamsize>(size));
+                _offset += size;
             }
 
+            static const size_t kReadAheadBytes = 1024*1024;
+
             const Settings _settings;
             bool _done;
             boost::scoped_array<char> _buffer;
@@ -256,6 +293,8 @@ namespace mongo {
             string _fileName;
             boost::shared_ptr<FileDeleter> _fileDeleter; // Must outlive _file
             std::ifstream _file;
+            unsigned long long _offset; // of the next byte to read from _file
+            int _readAheadFd; // another descriptor for _fileName, or -1
         };
 
         /** Merge-sorts results from 0 or more FileIterators */
@@ -435,8 +474,48 @@ namespace mongo {
                 const Comparator& _comp;
             };
 
+            typedef typename std::deque<Data>::iterator DataIterator;
+
+            /** stable_sorts a slice of _data, on a thread of its own */
+            class SortRun {
+            public:
+                SortRun(DataIterator begin, DataIterator end, const STLComparator& less,
+                        std::string* error)
+                    : _begin(begin)
+                    , _end(end)
+                    , _less(less)
+                    , _error(error)
+                {}
+
+                void operator() () {
+                    try {
+                        std::stable_sort(_begin, _end, _less);
+                    }
+                    catch (const std::exception& e) {
+                        *_error = e.what();
+                    }
+                }
+
+            private:
+                DataIterator _begin;
+                DataIterator _end;
+                STLComparator _less;
+                std::string* _error;
+            };
+
+            // slices smaller than this aren't worth a thread
+            static const size_t kMinParallelSortRun = 16*1024;
+
             void sort() {
                 STLComparator less(_comp);
+
+                const size_t nRuns = std::min(size_t(_opts.sortThreads),
+                                              _data.size() / kMinParallelSortRun);
+                if (nRuns > 1) {
+                    parallelSort(nRuns, less);
+                    return;
+                }
+
                 std::stable_sort(_data.begin(), _data.end(), less);
 
                 // Does 2x more compares than stable_sort
@@ -444,6 +523,47 @@ namespace mongo {
                 //std::sort(_data.begin(), _data.end(), comp);
             }
 
+            /**
+             * Sorts nRuns slices of _data at once, the first on this thread, then merges them.
+             * The result is the same as the serial stable_sort's since inplace_merge is stable
+             * and keeps the earlier slice's elements first.
+             */
+            void parallelSort(size_t nRuns, const STLComparator& less) {
+                std::vector<DataIterator> bounds;
+                for (size_t i = 0; i < nRuns; i++)
+                    bounds.push_back(_data.begin() + (_data.size() * i / nRuns));
+                bounds.push_back(_data.end());
+
+                std::vector<std::string> errors(nRuns);
+                boost::thread_group threads;
+                for (size_t i = 1; i < nRuns; i++)
+                    threads.create_thread(SortRun(bounds[i], bounds[i+1], less, &errors[i]));
+
+                try {
+                    // the comparator may throw here, e.g. if the operation is killed
+                    std::stable_sort(bounds[0], bounds[1], less);
+                }
+                catch (...) {
+                    threads.join_all();
+                    throw;
+                }
+                threads.join_all();
+
+                for (size_t i = 1; i < nRuns; i++) {
+                    massert(17324, str::stream() << "error sorting in parallel: " << errors[i],
+                            errors[i].empty());
+                }
+
+                for (size_t width = 1; width < nRuns; width *= 2) {
+                    for (size_t i = 0; i + width < nRuns; i += 2*width) {
+                        std::inplace_merge(bounds[i],
+                                           bounds[i + width],
+                                           bounds[std::min(i + 2*width, nRuns)],
+                                           less);
+                    }
+                }
+            }
+
             void spill() {
                 if (_data.empty())
                     return;
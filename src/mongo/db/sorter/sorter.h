@@ -98,11 +98,15 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        unsigned sortThreads; /// Threads to sort the buffered data with when there is no limit.
+                              /// If more than 1, the comparator is called concurrently from
+                              /// threads other than the one calling the Sorter.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , sortThreads(1)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +130,11 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& SortThreads(unsigned newSortThreads) {
+            sortThreads = newSortThreads;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -486,6 +486,15 @@ namespace mongo {
         };
 
 
+        template <bool Random=true>
+        class LotsOfDataParallelSort : public LotsOfDataLittleMemory<Random> {
+            typedef LotsOfDataLittleMemory<Random> Parent;
+            SortOptions adjustSortOptions(SortOptions opts) {
+                // each spill sorts enough data for all 4 threads
+                return Parent::adjustSortOptions(opts).SortThreads(4);
+            }
+        };
+
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
             typedef LotsOfDataLittleMemory<Random> Parent;
@@ -525,6 +534,8 @@ namespace mongo {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataParallelSort</*random=*/false> >();
+            add<SorterTests::LotsOfDataParallelSort</*random=*/true> >();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
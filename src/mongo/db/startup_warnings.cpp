@@ -31,6 +31,11 @@
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
@@ -87,7 +92,15 @@ namespace mongo {
             warned = true;
         }
 
-        if (boost::filesystem::exists("/sys/devices/system/node/node1")){
+        // The process's memory policy is already interleave if it was started under
+        // "numactl --interleave" or with the numaInterleave parameter.
+        int memoryPolicy = 0;
+        const int mpolInterleave = 3; // MPOL_INTERLEAVE from <numaif.h>
+        const bool interleaved =
+            syscall(SYS_get_mempolicy, &memoryPolicy, NULL, 0, NULL, 0) == 0 &&
+            memoryPolicy == mpolInterleave;
+
+        if (!interleaved && boost::filesystem::exists("/sys/devices/system/node/node1")){
             // We are on a box with a NUMA enabled kernel and more than 1 numa node (they start at
             // node0)
             // Now we look at the first line of /proc/self/numa_maps
@@ -128,6 +141,8 @@ namespace mongo {
                               << "performance problems:" << startupWarningsLog;
                         log() << "**              numactl --interleave=all mongod [other options]"
                               << startupWarningsLog;
+                        log() << "**          or with --setParameter numaInterleave=true"
+                              << startupWarningsLog;
                         warned = true;
                     }
                 }
@@ -38,6 +38,7 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/util/net/message.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 
 namespace mongo {
 
@@ -45,6 +46,27 @@ namespace mongo {
         // this won't be 100% accurate on rollovers and drop(), but at least it won't be negative
         time  = (newer.time  >= older.time)  ? (newer.time  - older.time)  : newer.time;
         count = (newer.count >= older.count) ? (newer.count - older.count) : newer.count;
+        for ( int i = 0; i < NumLatencyBuckets; i++ ) {
+            latency[i] = (newer.latency[i] >= older.latency[i]) ?
+                (newer.latency[i] - older.latency[i]) : newer.latency[i];
+        }
+    }
+
+    long long Top::UsageData::latencyPercentile( double percent ) const {
+        long long total = 0;
+        for ( int i = 0; i < NumLatencyBuckets; i++ )
+            total += latency[i];
+        if ( total == 0 )
+            return 0;
+
+        const double rank = total * percent / 100;
+        long long seen = 0;
+        for ( int i = 0; i < NumLatencyBuckets - 1; i++ ) {
+            seen += latency[i];
+            if ( seen >= rank )
+                return 2LL << i;
+        }
+        return -1;
     }
 
     Top::CollectionData::CollectionData( const CollectionData& older , const CollectionData& newer )
@@ -135,6 +157,11 @@ namespace mongo {
         _appendToUsageMap( b , _usage );
     }
 
+    void Top::appendGlobal( BSONObjBuilder& b ) {
+        SimpleMutex::scoped_lock lk( _lock );
+        _appendCollectionData( b , _global );
+    }
+
     void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
         // pull all the names into a vector so we can sort them for the user
         
@@ -150,26 +177,48 @@ namespace mongo {
 
             const CollectionData& coll = map.find(names[i])->second;
 
-            _appendStatsEntry( b , "total" , coll.total );
-
-            _appendStatsEntry( b , "readLock" , coll.readLock );
-            _appendStatsEntry( b , "writeLock" , coll.writeLock );
-
-            _appendStatsEntry( b , "queries" , coll.queries );
-            _appendStatsEntry( b , "getmore" , coll.getmore );
-            _appendStatsEntry( b , "insert" , coll.insert );
-            _appendStatsEntry( b , "update" , coll.update );
-            _appendStatsEntry( b , "remove" , coll.remove );
-            _appendStatsEntry( b , "commands" , coll.commands );
+            _appendCollectionData( bb , coll );
 
             bb.done();
         }
     }
 
+    void Top::_appendCollectionData( BSONObjBuilder& b , const CollectionData& coll ) const {
+        _appendStatsEntry( b , "total" , coll.total );
+
+        _appendStatsEntry( b , "readLock" , coll.readLock );
+        _appendStatsEntry( b , "writeLock" , coll.writeLock );
+
+        _appendStatsEntry( b , "queries" , coll.queries );
+        _appendStatsEntry( b , "getmore" , coll.getmore );
+        _appendStatsEntry( b , "insert" , coll.insert );
+        _appendStatsEntry( b , "update" , coll.update );
+        _appendStatsEntry( b , "remove" , coll.remove );
+        _appendStatsEntry( b , "commands" , coll.commands );
+    }
+
     void Top::_appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const {
         BSONObjBuilder bb( b.subobjStart( statsName ) );
         bb.appendNumber( "time" , map.time );
         bb.appendNumber( "count" , map.count );
+
+        if ( map.count ) {
+            // only the buckets that were hit, keyed by their upper bound in micros
+            BSONObjBuilder latency( bb.subobjStart( "latency" ) );
+            for ( int i = 0; i < UsageData::NumLatencyBuckets; i++ ) {
+                if ( !map.latency[i] )
+                    continue;
+                if ( i == UsageData::NumLatencyBuckets - 1 )
+                    latency.appendNumber( "more" , map.latency[i] );
+                else
+                    latency.appendNumber( BSONObjBuilder::numStr( 2 << i ) , map.latency[i] );
+            }
+            latency.done();
+
+            bb.appendNumber( "p50" , map.latencyPercentile( 50 ) );
+            bb.appendNumber( "p95" , map.latencyPercentile( 95 ) );
+            bb.appendNumber( "p99" , map.latencyPercentile( 99 ) );
+        }
         bb.done();
     }
 
@@ -200,6 +249,19 @@ namespace mongo {
 
     } topCmd;
 
+    class TopLatencySSS : public ServerStatusSection {
+    public:
+        TopLatencySSS() : ServerStatusSection( "opLatencies" ) {}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            b.append( "note" , "all times in microseconds" );
+            Top::global.appendGlobal( b );
+            return b.obj();
+        }
+    } topLatencySSS;
+
     Top Top::global;
 
 }
@@ -33,15 +33,39 @@ namespace mongo {
         Top() : _lock("Top") { }
 
         struct UsageData {
-            UsageData() : time(0) , count(0) {}
+            /**
+             * latency[i] counts the ops that took [2^i, 2^(i+1)) micros; the first bucket also
+             * takes 0 micros and the last one everything slower
+             */
+            enum { NumLatencyBuckets = 24 };
+
+            UsageData() : time(0) , count(0) { memset( latency , 0 , sizeof(latency) ); }
             UsageData( const UsageData& older , const UsageData& newer );
             long long time;
             long long count;
+            long long latency[NumLatencyBuckets];
 
             void inc( long long micros ) {
                 count++;
                 time += micros;
+                latency[ latencyBucket( micros ) ]++;
+            }
+
+            /** @return the bucket of latency[] an op taking 'micros' is counted in */
+            static int latencyBucket( long long micros ) {
+                int bucket = 0;
+                while ( micros > 1 && bucket < NumLatencyBuckets - 1 ) {
+                    micros >>= 1;
+                    bucket++;
+                }
+                return bucket;
             }
+
+            /**
+             * @return the upper bound in micros of the bucket holding the 'percent' percentile
+             *         of latencies, or -1 past the last bounded bucket
+             */
+            long long latencyPercentile( double percent ) const;
         };
 
         struct CollectionData {
@@ -69,8 +93,13 @@ namespace mongo {
     public:
         void record( const StringData& ns , int op , int lockType , long long micros , bool command );
         void append( BSONObjBuilder& b );
+        /** appends the usage summed over all namespaces */
+        void appendGlobal( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
-        CollectionData getGlobalData() const { return _global; }
+        CollectionData getGlobalData() const {
+            SimpleMutex::scoped_lock lk(_lock);
+            return _global;
+        }
         void collectionDropped( const StringData& ns );
 
     public: // static stuff
@@ -78,6 +107,7 @@ namespace mongo {
 
     private:
         void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
+        void _appendCollectionData( BSONObjBuilder& b , const CollectionData& coll ) const;
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
         void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
 
@@ -47,9 +47,24 @@ using namespace mongoutils;
 
 namespace mongo {
 
-    void DurableMappedFile::remapThePrivateView() {
+    void DurableMappedFile::noteWritten(size_t ofs, unsigned len) {
+        size_t first = ofs / RemapChunkSize;
+        size_t last = (ofs + std::max(len, 1U) - 1) / RemapChunkSize;
+        if( last >= _writtenChunks.size() )
+            _writtenChunks.resize(last + 1, false);
+        for( size_t c = first; c <= last; c++ ) {
+            // usually already set, so test first
+            if( !_writtenChunks[c] ) {
+                _writtenChunks[c] = true;
+                _nWrittenChunks++;
+            }
+        }
+    }
+
+    unsigned DurableMappedFile::remapThePrivateView(unsigned maxChunks) {
         verify(storageGlobalParams.dur);
 
+#if defined(_WIN32) || defined(__sunos__)
         // todo 1.9 : it turns out we require that we always remap to the same address.
         // so the remove / add isn't necessary and can be removed?
         void *old = _view_private;
@@ -57,6 +72,36 @@ namespace mongo {
         _view_private = remapPrivateView(_view_private);
         //privateViews.add(_view_private, this);
         fassert( 16112, _view_private == old );
+
+        unsigned n = _nWrittenChunks;
+        _writtenChunks.assign(_writtenChunks.size(), false);
+        _nWrittenChunks = 0;
+        return n;
+#else
+        unsigned n = 0;
+        const size_t nChunks = _writtenChunks.size();
+        for( size_t c = 0; c < nChunks && n < maxChunks; c++ ) {
+            if( !_writtenChunks[c] )
+                continue;
+
+            // remap a run of adjacent written regions with one call
+            size_t end = c + 1;
+            while( end < nChunks && _writtenChunks[end] && n + (end - c) < maxChunks )
+                end++;
+
+            unsigned long long ofs = (unsigned long long) c * RemapChunkSize;
+            unsigned long long len = std::min((unsigned long long) (end - c) * RemapChunkSize,
+                                              length() - ofs);
+            remapPrivateViewRange(_view_private, ofs, len);
+
+            for( size_t k = c; k < end; k++ )
+                _writtenChunks[k] = false;
+            n += end - c;
+            _nWrittenChunks -= end - c;
+            c = end - 1;
+        }
+        return n;
+#endif
     }
 
     /** register view. threadsafe */
@@ -170,7 +215,7 @@ namespace mongo {
         return false;
     }
 
-    DurableMappedFile::DurableMappedFile() : _willNeedRemap(false) {
+    DurableMappedFile::DurableMappedFile() : _nWrittenChunks(0) {
         _view_write = _view_private = 0;
     }
 
@@ -89,13 +89,28 @@ namespace mongo {
         int fileSuffixNo() const { return _fileSuffixNo; }
         HANDLE getFd() { return MemoryMappedFile::getFd(); }
 
+        /** the private view is remapped in regions of this size, so that a remap only throws away
+            the copy on write pages of regions that were written
+        */
+        static const unsigned RemapChunkSize = 1024 * 1024;
+
         /** true if we have written.
             set in PREPLOGBUFFER, it is NOT set immediately on write intent declaration.
-            reset to false in REMAPPRIVATEVIEW
+            reset in REMAPPRIVATEVIEW once all the written regions are remapped
         */
-        bool& willNeedRemap() { return _willNeedRemap; }
+        bool willNeedRemap() const { return _nWrittenChunks > 0; }
+
+        /** note that [ofs, ofs+len) of the private view was written. called in PREPLOGBUFFER */
+        void noteWritten(size_t ofs, unsigned len);
 
-        void remapThePrivateView();
+        /** number of RemapChunkSize regions written since they were last remapped */
+        unsigned writtenChunks() const { return _nWrittenChunks; }
+
+        /** remap up to maxChunks of the written regions of the private view.
+            windows and solaris can only remap the whole view, so there all of them are remapped.
+            @return the number of written regions remapped
+        */
+        unsigned remapThePrivateView(unsigned maxChunks);
 
         virtual bool isDurableMappedFile() { return true; }
 
@@ -103,7 +118,8 @@ namespace mongo {
 
         void *_view_write;
         void *_view_private;
-        bool _willNeedRemap;
+        vector<bool> _writtenChunks; // by RemapChunkSize region of the private view
+        unsigned _nWrittenChunks;
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
@@ -33,15 +33,35 @@
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/storage/data_file.h"
 #include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/coarse_clock.h"
+#include "mongo/util/file.h"
+#include "mongo/util/file_allocator.h"
 
 // XXX-erh
 #include "mongo/db/pdfile.h"
 
 namespace mongo {
 
+    // how many files past the last one _preallocateAhead() may request
+    static const int MaxFilesPreallocatedAhead = 2;
+
+    class FileAllocatorSSS : public ServerStatusSection {
+    public:
+        FileAllocatorSSS() : ServerStatusSection( "fileAllocator" ){}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            FileAllocator::get()->appendStats( b );
+            return b.obj();
+        }
+    } fileAllocatorSSS;
+
     ExtentManager::ExtentManager( const StringData& dbname,
                                   const StringData& path,
                                   NamespaceDetails* freeListDetails,
@@ -49,7 +69,12 @@ namespace mongo {
         : _dbname( dbname.toString() ),
           _path( path.toString() ),
           _freeListDetails( freeListDetails ),
-          _directoryPerDB( directoryPerDB ) {
+          _directoryPerDB( directoryPerDB ),
+          _growthWindowStartMillis( 0 ),
+          _growthWindowBytes( 0 ),
+          _bytesPerMilli( 0 ),
+          _openFileMutex( "ExtentManager::_openFileMutex" ) {
+        std::fill( _files, _files + DiskLoc::MaxFiles, static_cast<DataFile*>(NULL) );
     }
 
     ExtentManager::~ExtentManager() {
@@ -57,10 +82,12 @@ namespace mongo {
     }
 
     void ExtentManager::reset() {
-        for ( size_t i = 0; i < _files.size(); i++ ) {
+        const unsigned n = _numFiles.load();
+        _numFiles.store( 0 );
+        for ( unsigned i = 0; i < n; i++ ) {
             delete _files[i];
+            _files[i] = NULL;
         }
-        _files.clear();
     }
 
     boost::filesystem::path ExtentManager::fileName( int n ) const {
@@ -75,28 +102,35 @@ namespace mongo {
 
 
     Status ExtentManager::init() {
-        verify( _files.size() == 0 );
+        verify( _numFiles.load() == 0 );
 
         for ( int n = 0; n < DiskLoc::MaxFiles; n++ ) {
             boost::filesystem::path fullName = fileName( n );
             if ( !boost::filesystem::exists( fullName ) )
                 break;
 
+            // only the header's version is read here; mapping waits for the first access
             string fullNameString = fullName.string();
-
-            auto_ptr<DataFile> df( new DataFile(n) );
-
-            Status s = df->openExisting( fullNameString.c_str() );
-            if ( !s.isOK() ) {
-                return s;
+            File f;
+            f.open( fullNameString.c_str(), true );
+            if ( !f.is_open() || f.bad() ) {
+                return Status( ErrorCodes::InternalError,
+                               str::stream() << "couldn't open " << fullNameString );
+            }
+            int version = 0;
+            if ( f.len() >= static_cast<fileofs>( sizeof( version ) ) )
+                f.read( 0, reinterpret_cast<char*>( &version ), sizeof( version ) );
+            if ( f.bad() ) {
+                return Status( ErrorCodes::InternalError,
+                               str::stream() << "couldn't read the header of " << fullNameString );
             }
 
-            if ( df->getHeader()->uninitialized() ) {
+            if ( version == 0 ) {
                 // pre-alloc only, so we're done
                 break;
             }
 
-            _files.push_back( df.release() );
+            _numFiles.store( n + 1 );
         }
 
         return Status::OK();
@@ -105,7 +139,27 @@ namespace mongo {
     const DataFile* ExtentManager::_getOpenFile( int n ) const {
         verify(this);
         DEV Lock::assertAtLeastReadLocked( _dbname );
-        verify( n >= 0 && n < static_cast<int>(_files.size()) );
+        verify( n >= 0 && n < static_cast<int>(_numFiles.load()) );
+        const DataFile* f = _files[n];
+        if ( MONGO_unlikely( f == NULL ) )
+            f = _openExisting( n );
+        return f;
+    }
+
+    DataFile* ExtentManager::_openExisting( int n ) const {
+        SimpleMutex::scoped_lock lk( _openFileMutex );
+        if ( _files[n] )
+            return _files[n];
+
+        string fullNameString = fileName( n ).string();
+        auto_ptr<DataFile> df( new DataFile(n) );
+        Status s = df->openExisting( fullNameString.c_str() );
+        if ( !s.isOK() ) {
+            msgasserted( 17325, str::stream() << "couldn't open " << fullNameString << ": "
+                                              << s.toString() );
+        }
+        LOG(1) << "opened " << fullNameString << endl;
+        _files[n] = df.release();
         return _files[n];
     }
 
@@ -126,17 +180,18 @@ namespace mongo {
         }
         DataFile* p = 0;
         if ( !preallocateOnly ) {
-            while ( n >= (int) _files.size() ) {
+            if ( n >= (int) _numFiles.load() ) {
                 verify(this);
                 if( !Lock::isWriteLocked(_dbname) ) {
                     log() << "error: getFile() called in a read lock, yet file to return is not yet open" << endl;
-                    log() << "       getFile(" << n << ") _files.size:" <<_files.size() << ' ' << fileName(n).string() << endl;
+                    log() << "       getFile(" << n << ") numFiles:" << _numFiles.load() << ' ' << fileName(n).string() << endl;
                     log() << "       context ns: " << cc().ns() << endl;
                     verify(false);
                 }
-                _files.push_back(0);
             }
             p = _files[n];
+            if ( p == 0 && n < (int) _numFiles.load() )
+                p = _openExisting( n );
         }
         if ( p == 0 ) {
             DEV Lock::assertWriteLocked( _dbname );
@@ -144,8 +199,8 @@ namespace mongo {
             string fullNameString = fullName.string();
             p = new DataFile(n);
             int minSize = 0;
-            if ( n != 0 && _files[ n - 1 ] )
-                minSize = _files[ n - 1 ]->getHeader()->fileLength;
+            if ( n != 0 && n - 1 < (int) _numFiles.load() )
+                minSize = _getOpenFile( n - 1 )->getHeader()->fileLength;
             if ( sizeNeeded + DataFileHeader::HeaderSize > minSize )
                 minSize = sizeNeeded + DataFileHeader::HeaderSize;
             try {
@@ -155,17 +210,22 @@ namespace mongo {
                 delete p;
                 throw;
             }
-            if ( preallocateOnly )
+            if ( preallocateOnly ) {
                 delete p;
-            else
+            }
+            else {
                 _files[n] = p;
+                // publish the file only now that its slot is written
+                if ( n >= (int) _numFiles.load() )
+                    _numFiles.store( n + 1 );
+            }
         }
         return preallocateOnly ? 0 : p;
     }
 
     DataFile* ExtentManager::addAFile( int sizeNeeded, bool preallocateNextFile ) {
         DEV Lock::assertWriteLocked( _dbname );
-        int n = (int) _files.size();
+        int n = (int) _numFiles.load();
         DataFile *ret = getFile( n, sizeNeeded );
         if ( preallocateNextFile )
             preallocateAFile();
@@ -174,7 +234,7 @@ namespace mongo {
 
     size_t ExtentManager::numFiles() const {
         DEV Lock::assertAtLeastReadLocked( _dbname );
-        return _files.size();
+        return _numFiles.load();
     }
 
     long long ExtentManager::fileSize() const {
@@ -186,9 +246,10 @@ namespace mongo {
 
     void ExtentManager::flushFiles( bool sync ) {
         DEV Lock::assertAtLeastReadLocked( _dbname );
-        for( vector<DataFile*>::iterator i = _files.begin(); i != _files.end(); i++ ) {
-            DataFile *f = *i;
-            f->flush(sync);
+        const unsigned n = _numFiles.load();
+        for( unsigned i = 0; i < n; i++ ) {
+            if ( _files[i] )
+                _files[i]->flush(sync);
         }
     }
 
@@ -363,9 +424,55 @@ namespace mongo {
         LOG(1) << "ExtentManager: creating new extent for: " << ns << " in file: " << fileNo
                << " size: " << size << endl;
 
+        _preallocateAhead( size );
+
         return e;
     }
 
+    void ExtentManager::_preallocateAhead( int extentSize ) {
+        if ( !storageGlobalParams.prealloc )
+            return;
+
+        // smoothed over windows of at least a second, so that a single large extent doesn't
+        // look like fast growth
+        long long now = coarseTimeMillis64();
+        if ( _growthWindowStartMillis == 0 )
+            _growthWindowStartMillis = now;
+        _growthWindowBytes += extentSize;
+        long long elapsed = now - _growthWindowStartMillis;
+        if ( elapsed >= 1000 ) {
+            double rate = static_cast<double>( _growthWindowBytes ) / elapsed;
+            _bytesPerMilli = ( _bytesPerMilli + rate ) / 2;
+            _growthWindowStartMillis = now;
+            _growthWindowBytes = 0;
+        }
+        if ( _bytesPerMilli == 0 )
+            return;
+
+        int last = numFiles() - 1;
+        const DataFileHeader* h = _getOpenFile( last )->getHeader();
+
+        // the files needed within twice the time an allocation takes (plus a second of slack)
+        // are requested now
+        long long allocMillis = FileAllocator::get()->expectedAllocationMillis( h->fileLength );
+        long long needed = static_cast<long long>( _bytesPerMilli * ( 2 * allocMillis + 1000 ) );
+        int minSize = h->fileLength;
+        long long available = h->unusedLength;
+        for ( int n = last + 1; available < needed && n < last + 1 + MaxFilesPreallocatedAhead; n++ ) {
+            if ( n >= DiskLoc::MaxFiles )
+                break;
+            _preallocateFile( n, minSize );
+            available += minSize;
+        }
+    }
+
+    void ExtentManager::_preallocateFile( int n, int minSize ) {
+        DataFile df( n );
+        // returns at once: the FileAllocator thread does the work, and does nothing if the file
+        // exists or has been requested already
+        df.open( fileName( n ).string().c_str(), minSize, true );
+    }
+
 
     Extent* ExtentManager::createExtent(const char *ns, int size, bool newCapped, bool enforceQuota ) {
         size = quantizeExtentSize( size );
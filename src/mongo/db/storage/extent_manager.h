@@ -38,6 +38,8 @@
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -84,7 +86,7 @@ namespace mongo {
         void init( NamespaceDetails* freeListDetails );
 
         /**
-         * opens all current files
+         * finds the current files; each is only opened and mapped the first time it is used
          */
         Status init();
 
@@ -160,12 +162,23 @@ namespace mongo {
 
         const DataFile* _getOpenFile( int n ) const;
 
+        /** opens and maps an existing file that hasn't been used yet */
+        DataFile* _openExisting( int n ) const;
+
         Extent* _createExtentInFile( int fileNo, DataFile* f,
                                      const char* ns, int size, bool newCapped,
                                      bool enforceQuota );
 
         boost::filesystem::path fileName( int n ) const;
 
+        /**
+         * requests preallocation of the files the database will need before the FileAllocator
+         * could allocate them on demand, going by how fast extents are being created.
+         */
+        void _preallocateAhead( int extentSize );
+
+        void _preallocateFile( int n, int minSize );
+
 // -----
 
         std::string _dbname; // i.e. "test"
@@ -176,7 +189,19 @@ namespace mongo {
         // must be in the dbLock when touching this (and write locked when writing to of course)
         // however during Database object construction we aren't, which is ok as it isn't yet visible
         //   to others and we are in the dbholder lock then.
-        std::vector<DataFile*> _files;
+        // writers holding only a collection lock add files under Database::allocExtent's mutex
+        // while readers look up records in the open ones, so the slots never move and a file is
+        // only counted in _numFiles once its slot is written.
+        // files found at startup are counted but left unopened (NULL) until first used; readers
+        // may open them, so that is done under _openFileMutex and the slot written last.
+        mutable DataFile* _files[DiskLoc::MaxFiles];
+        AtomicUInt32 _numFiles;
+        mutable SimpleMutex _openFileMutex;
+
+        // extent creation rate, see _preallocateAhead()
+        long long _growthWindowStartMillis;
+        long long _growthWindowBytes;
+        double _bytesPerMilli;
 
     };
 
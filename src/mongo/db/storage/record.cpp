@@ -38,7 +38,9 @@
 #include "mongo/db/database_holder.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/platform/bits.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/processinfo.h"
@@ -132,7 +134,11 @@ namespace mongo {
             }
 
 
-            void addPages( unordered_set<size_t>* pages ) {
+            /**
+             * adds each page seen in this slice to pages, keeping for each the start of the most
+             * recent slice it was seen in
+             */
+            void addPages( unordered_map<size_t, time_t>* pages ) {
                 for ( int i = 0; i < SliceSize; i++ ) {
                     unsigned long long v = _data[i].value;
                     
@@ -140,7 +146,8 @@ namespace mongo {
                         int offset = firstBitSet( v ) - 1;
                         
                         size_t page = ( _data[i].region << 6 | offset );
-                        pages->insert( page );
+                        time_t& lastSeen = (*pages)[page];
+                        lastSeen = std::max( lastSeen, _lastReset );
 
                         v &= ~( 1ULL << offset );
                     }
@@ -239,7 +246,7 @@ namespace mongo {
              * @param mySlices temporary space for copy
              * @return the oldest timestamp we have
              */
-            time_t addPages( unordered_set<size_t>* pages, Slice* mySlices ) {
+            time_t addPages( unordered_map<size_t, time_t>* pages, Slice* mySlices ) {
                 time_t oldestTimestamp = std::numeric_limits<time_t>::max();
                 {
                     // by doing this, we're in the lock only about half as long as the naive way
@@ -371,23 +378,163 @@ namespace mongo {
 
         };
      
-        void appendWorkingSetInfo( BSONObjBuilder& b ) {
-            boost::scoped_array<Slice> mySlices( new Slice[NumSlices] );
+        /** the address range of one mapped data file */
+        struct FileRange {
+            const char* start;
+            const char* end;
+            string file;
+            string db;
+            bool operator<( const FileRange& other ) const { return start < other.start; }
+        };
 
-            unordered_set<size_t> totalPages;
-            Timer t;
+        /** @return the database a data file belongs to, from "<dbpath>/[<db>/]<db>.<n>" */
+        string dbNameFromFilename( const string& filename ) {
+            size_t slash = filename.find_last_of( "/\\" );
+            string base = slash == string::npos ? filename : filename.substr( slash + 1 );
+            return base.substr( 0, base.rfind( '.' ) );
+        }
 
-            time_t timestamp = 0;
+        /** @return the address ranges of the mapped data files, sorted by address */
+        vector<FileRange> dataFileRanges() {
+            vector<FileRange> ranges;
+            LockMongoFilesShared lk;
+            const set<MongoFile*>& files = MongoFile::getAllFiles();
+            for ( set<MongoFile*>::const_iterator i = files.begin(); i != files.end(); ++i ) {
+                DurableMappedFile* mmf = dynamic_cast<DurableMappedFile*>( *i );
+                if ( !mmf || !mmf->getView() )
+                    continue;
+                FileRange r;
+                r.start = static_cast<const char*>( mmf->getView() );
+                r.end = r.start + mmf->length();
+                r.file = mmf->filename();
+                r.db = dbNameFromFilename( r.file );
+                ranges.push_back( r );
+            }
+            std::sort( ranges.begin(), ranges.end() );
+            return ranges;
+        }
 
+        /**
+         * @param pages OUT page -> start of the most recent slice it was seen in
+         * @return how far back all the slices go
+         */
+        time_t collectPages( unordered_map<size_t, time_t>* pages ) {
+            boost::scoped_array<Slice> mySlices( new Slice[NumSlices] );
+            time_t timestamp = 0;
             for ( int i = 0; i < BigHashSize; i++ ) {
-                time_t myOldestTimestamp = rolling[i].addPages( &totalPages, mySlices.get() );
+                time_t myOldestTimestamp = rolling[i].addPages( pages, mySlices.get() );
                 timestamp = std::max( timestamp, myOldestTimestamp );
             }
+            return timestamp;
+        }
+
+        /** @return the data file holding the page, or end */
+        vector<FileRange>::const_iterator fileOf( const vector<FileRange>& ranges,
+                                                  size_t page ) {
+            FileRange key;
+            key.start = reinterpret_cast<const char*>( page << 12 );
+            vector<FileRange>::const_iterator r =
+                std::upper_bound( ranges.begin(), ranges.end(), key );
+            if ( r != ranges.begin() && key.start < (r - 1)->end )
+                return r - 1;
+            return ranges.end();
+        }
+
+        bool moreRecent( const HotDataRange& a, const HotDataRange& b ) {
+            return a.lastSeen > b.lastSeen;
+        }
+
+        /** pages this close together go in one range; read-ahead fetches the gap anyway */
+        const long long maxHotRangeGap = 64 * 1024;
+
+        void getHotDataRanges( vector<HotDataRange>* out ) {
+            unordered_map<size_t, time_t> totalPages;
+            collectPages( &totalPages );
+
+            // (file, offset) of each page, in file order
+            const vector<FileRange> ranges = dataFileRanges();
+            vector< pair< pair<size_t, long long>, time_t > > located;
+            located.reserve( totalPages.size() );
+            for ( unordered_map<size_t, time_t>::const_iterator i = totalPages.begin();
+                  i != totalPages.end(); ++i ) {
+                vector<FileRange>::const_iterator r = fileOf( ranges, i->first );
+                if ( r == ranges.end() )
+                    continue;
+                long long offset = reinterpret_cast<const char*>( i->first << 12 ) - r->start;
+                located.push_back( make_pair( make_pair( static_cast<size_t>( r - ranges.begin() ),
+                                                         offset ),
+                                              i->second ) );
+            }
+            std::sort( located.begin(), located.end() );
+
+            const long long pageSize = 1 << 12;
+            for ( size_t i = 0; i < located.size(); i++ ) {
+                const FileRange& file = ranges[located[i].first.first];
+                const long long offset = located[i].first.second;
+                if ( !out->empty() && out->back().file == file.file &&
+                     offset - ( out->back().offset + out->back().length ) <= maxHotRangeGap ) {
+                    HotDataRange& last = out->back();
+                    last.length = offset + pageSize - last.offset;
+                    last.lastSeen = std::max( last.lastSeen, located[i].second );
+                    continue;
+                }
+                HotDataRange range;
+                range.db = file.db;
+                range.file = file.file;
+                range.offset = offset;
+                range.length = pageSize;
+                range.lastSeen = located[i].second;
+                out->push_back( range );
+            }
+            std::stable_sort( out->begin(), out->end(), moreRecent );
+        }
+
+        void appendWorkingSetInfo( BSONObjBuilder& b ) {
+            // page -> start of the most recent slice it was seen in
+            unordered_map<size_t, time_t> totalPages;
+            Timer t;
+
+            time_t timestamp = collectPages( &totalPages );
+
+            // How recently the pages were touched: pagesByAge[i] were last seen less than
+            // (i + 1) * RotateTimeSecs ago.  Also which database each page is in.
+            const time_t now = time(0);
+            vector<long long> pagesByAge( NumSlices, 0 );
+            const vector<FileRange> ranges = dataFileRanges();
+            map<string, long long> pagesByDb;
+            for ( unordered_map<size_t, time_t>::const_iterator i = totalPages.begin();
+                  i != totalPages.end(); ++i ) {
+                long long age = std::max( static_cast<long long>( now - i->second ), 0LL );
+                pagesByAge[ std::min( age / RotateTimeSecs,
+                                      static_cast<long long>( NumSlices - 1 ) ) ]++;
+
+                vector<FileRange>::const_iterator r = fileOf( ranges, i->first );
+                if ( r != ranges.end() )
+                    pagesByDb[r->db]++;
+            }
 
             b.append( "note", "thisIsAnEstimate" );
             b.appendNumber( "pagesInMemory", totalPages.size() );
+
+            // cumulative, so each entry is the working set over a window ending now
+            BSONArrayBuilder recency( b.subarrayStart( "recency" ) );
+            long long withinWindow = 0;
+            for ( int i = 0; i < NumSlices; i++ ) {
+                withinWindow += pagesByAge[i];
+                recency.append( BSON( "seconds" << ( i + 1 ) * RotateTimeSecs <<
+                                      "pages" << withinWindow ) );
+            }
+            recency.done();
+
+            BSONObjBuilder byDb( b.subobjStart( "pagesByDatabase" ) );
+            for ( map<string, long long>::const_iterator i = pagesByDb.begin();
+                  i != pagesByDb.end(); ++i ) {
+                byDb.appendNumber( i->first, i->second );
+            }
+            byDb.done();
+
             b.appendNumber( "computationTimeMicros", static_cast<long long>(t.micros()) );
-            b.append( "overSeconds", static_cast<int>( time(0) - timestamp ) );
+            b.append( "overSeconds", static_cast<int>( now - timestamp ) );
 
         }
         
@@ -412,6 +559,10 @@ namespace mongo {
     }
 #endif
 
+    void getHotDataRanges( vector<HotDataRange>* out ) {
+        ps::getHotDataRanges( out );
+    }
+
     bool Record::MemoryTrackingEnabled = true;
     
     volatile int __record_touch_dummy = 1; // this is used to make sure the compiler doesn't get too smart on us
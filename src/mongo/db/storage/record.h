@@ -42,6 +42,20 @@ namespace mongo {
         AtomicInt64 pageFaultExceptionsThrown;
     };
 
+    /** a range of a data file whose pages were accessed recently */
+    struct HotDataRange {
+        std::string db;
+        std::string file;
+        long long offset;
+        long long length;
+        time_t lastSeen;
+    };
+
+    /**
+     * the ranges of the data files which the working set estimate has seen accessed, most
+     * recently seen first.  nearby pages are merged into one range.
+     */
+    void getHotDataRanges( std::vector<HotDataRange>* out );
 
 
 }
@@ -30,27 +30,140 @@
 
 #include "mongo/db/storage/record_store.h"
 
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
 
 #include "mongo/db/pdfile.h" // XXX-ERH
 
 namespace mongo {
 
-    RecordStore::RecordStore() {
+    namespace {
+        class BufferDocWriter : public DocWriter {
+        public:
+            BufferDocWriter( const char* data, int len ) : _data( data ), _len( len ) {}
+            virtual void writeDocument( char* buf ) const { memcpy( buf, _data, _len ); }
+            virtual size_t documentSize() const { return _len; }
+        private:
+            const char* _data;
+            int _len;
+        };
+    }
+
+    ExtentRecordStore::ExtentRecordStore() {
         _extentManager = NULL;
         _details = NULL;
+        _isSystemIndexes = false;
     }
 
-    void RecordStore::init( NamespaceDetails* details,
-                            ExtentManager* em,
-                            bool isSystemIndexes ) {
+    void ExtentRecordStore::init( const StringData& ns,
+                                  NamespaceDetails* details,
+                                  ExtentManager* em,
+                                  bool isSystemIndexes ) {
+        _ns = ns.toString();
         _details = details;
         _extentManager = em;
         _isSystemIndexes = isSystemIndexes;
     }
 
-    void RecordStore::deallocRecord( const DiskLoc& dl, Record* todelete ) {
+    Record* ExtentRecordStore::recordFor( const DiskLoc& loc ) const {
+        return _extentManager->recordFor( loc );
+    }
+
+    StatusWith<DiskLoc> ExtentRecordStore::insertRecord( const char* data, int len,
+                                                         bool enforceQuota ) {
+        BufferDocWriter doc( data, len );
+        return insertRecord( &doc, enforceQuota );
+    }
+
+    StatusWith<DiskLoc> ExtentRecordStore::insertRecord( const DocWriter* doc, bool enforceQuota ) {
+        int len = doc->documentSize();
+        double sizePaddingFactor = 0;
+        if ( enforceQuota && !_details->isCapped() ) {
+            // user documents: pad by how much documents of this size have been growing
+            NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get( _ns.c_str() );
+            sizePaddingFactor = nsdt.sizePaddingFactor( len );
+        }
+        int lenWHdr = _details->getRecordAllocationSize( len + Record::HeaderSize,
+                                                         sizePaddingFactor );
+        fassert( 16440, lenWHdr >= ( len + Record::HeaderSize ) );
+
+        DiskLoc loc = allocateSpaceForANewRecord( _ns.c_str(), _details, lenWHdr, !enforceQuota );
+        if ( loc.isNull() )
+            return StatusWith<DiskLoc>( ErrorCodes::InternalError,
+                                        "couldn't allocate space for record in " + _ns );
+
+        Record* r = recordFor( loc );
+        verify( r->lengthWithHeaders() >= lenWHdr );
+        r = reinterpret_cast<Record*>( getDur().writingPtr( r, lenWHdr ) );
+        doc->writeDocument( r->data() );
+
+        addRecordToRecListInExtent( r, loc );
+
+        _details->incrementStats( r->netLength(), 1 );
+
+        return StatusWith<DiskLoc>( loc );
+    }
+
+    StatusWith<DiskLoc> ExtentRecordStore::updateRecord( const DiskLoc& loc, const char* data,
+                                                         int len, bool enforceQuota ) {
+        Record* r = recordFor( loc );
+        if ( r->netLength() >= len ) {
+            memcpy( getDur().writingPtr( r->data(), len ), data, len );
+            return StatusWith<DiskLoc>( loc );
+        }
+
+        if ( _details->isCapped() )
+            return StatusWith<DiskLoc>( ErrorCodes::BadValue,
+                                        "objects in a capped ns cannot grow" );
+
+        // doesn't fit: move the record
+        _details->paddingTooSmall();
+        deleteRecord( loc );
+        return insertRecord( data, len, enforceQuota );
+    }
+
+    void ExtentRecordStore::deleteRecord( const DiskLoc& loc ) {
+        deallocRecord( loc, recordFor( loc ) );
+    }
+
+    DiskLoc ExtentRecordStore::getNext( const DiskLoc& loc ) const {
+        return _extentManager->getNextRecord( loc );
+    }
+
+    DiskLoc ExtentRecordStore::getPrev( const DiskLoc& loc ) const {
+        return _extentManager->getPrevRecord( loc );
+    }
+
+    DiskLoc ExtentRecordStore::firstRecord() const {
+        for ( DiskLoc i = _details->firstExtent(); !i.isNull();
+              i = _extentManager->getExtent( i )->xnext ) {
+            Extent* e = _extentManager->getExtent( i );
+            if ( !e->firstRecord.isNull() )
+                return e->firstRecord;
+        }
+        return DiskLoc();
+    }
+
+    DiskLoc ExtentRecordStore::lastRecord() const {
+        for ( DiskLoc i = _details->lastExtent(); !i.isNull();
+              i = _extentManager->getExtent( i )->xprev ) {
+            Extent* e = _extentManager->getExtent( i );
+            if ( !e->lastRecord.isNull() )
+                return e->lastRecord;
+        }
+        return DiskLoc();
+    }
+
+    long long ExtentRecordStore::numRecords() const {
+        return _details->numRecords();
+    }
+
+    long long ExtentRecordStore::dataSize() const {
+        return _details->dataSize();
+    }
 
+    void ExtentRecordStore::deallocRecord( const DiskLoc& dl, Record* todelete ) {
         /* remove ourself from the record next/prev chain */
         {
             if ( todelete->prevOfs() != DiskLoc::NullOfs ) {
@@ -30,6 +30,10 @@
 
 #pragma once
 
+#include <string>
+
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
 #include "mongo/db/diskloc.h"
 
 namespace mongo {
@@ -38,17 +42,109 @@ namespace mongo {
     class NamespaceDetails;
     class Record;
 
+    /**
+     * Writes a document straight into the space a RecordStore allocated for it, so that callers
+     * which assemble documents (e.g. adding an _id) need not copy them first.
+     */
+    class DocWriter {
+    public:
+        virtual ~DocWriter() {}
+        virtual void writeDocument( char* buf ) const = 0;
+        virtual size_t documentSize() const = 0;
+    };
+
+    /**
+     * The records of one collection (or of one index's buckets).  A RecordStore allocates,
+     * updates, frees and navigates records by DiskLoc; how and where they are kept is up to the
+     * storage engine implementing it.
+     *
+     * Locking is up to the caller: the collection must be write locked to modify it, read locked
+     * to read it.
+     */
     class RecordStore {
     public:
-        RecordStore();
+        virtual ~RecordStore() {}
+
+        /** @param loc the location of an existing record */
+        virtual Record* recordFor( const DiskLoc& loc ) const = 0;
+
+        /**
+         * @param enforceQuota whether storing the record may fail for exceeding the database's
+         *        file quota
+         * @return the location of the new record
+         */
+        virtual StatusWith<DiskLoc> insertRecord( const char* data, int len, bool enforceQuota ) = 0;
+
+        virtual StatusWith<DiskLoc> insertRecord( const DocWriter* doc, bool enforceQuota ) = 0;
+
+        /**
+         * replaces the data of the record at loc.
+         * @return loc if the data was updated in place, otherwise the record's new location
+         */
+        virtual StatusWith<DiskLoc> updateRecord( const DiskLoc& loc, const char* data, int len,
+                                                  bool enforceQuota ) = 0;
+
+        virtual void deleteRecord( const DiskLoc& loc ) = 0;
+
+        /**
+         * @return the record following loc in the store's natural order, or a null DiskLoc at
+         *         the end
+         */
+        virtual DiskLoc getNext( const DiskLoc& loc ) const = 0;
+
+        /** @return the record preceding loc in natural order, or a null DiskLoc */
+        virtual DiskLoc getPrev( const DiskLoc& loc ) const = 0;
+
+        /** @return the first record in natural order, or a null DiskLoc if there are none */
+        virtual DiskLoc firstRecord() const = 0;
+
+        /** @return the last record in natural order, or a null DiskLoc if there are none */
+        virtual DiskLoc lastRecord() const = 0;
 
-        void init( NamespaceDetails* details,
+        virtual long long numRecords() const = 0;
+
+        /** the length of all records' data, without headers and padding */
+        virtual long long dataSize() const = 0;
+    };
+
+    /**
+     * The mmap'd storage engine: records are kept in the extents of the database's ExtentManager,
+     * chained per extent, and freed records go to the NamespaceDetails' deleted lists.
+     */
+    class ExtentRecordStore : public RecordStore {
+    public:
+        ExtentRecordStore();
+        virtual ~ExtentRecordStore() {}
+
+        void init( const StringData& ns,
+                   NamespaceDetails* details,
                    ExtentManager* em,
                    bool isSystemIndexes );
 
+        virtual Record* recordFor( const DiskLoc& loc ) const;
+
+        virtual StatusWith<DiskLoc> insertRecord( const char* data, int len, bool enforceQuota );
+
+        virtual StatusWith<DiskLoc> insertRecord( const DocWriter* doc, bool enforceQuota );
+
+        virtual StatusWith<DiskLoc> updateRecord( const DiskLoc& loc, const char* data, int len,
+                                                  bool enforceQuota );
+
+        virtual void deleteRecord( const DiskLoc& loc );
+
+        virtual DiskLoc getNext( const DiskLoc& loc ) const;
+        virtual DiskLoc getPrev( const DiskLoc& loc ) const;
+        virtual DiskLoc firstRecord() const;
+        virtual DiskLoc lastRecord() const;
+
+        virtual long long numRecords() const;
+        virtual long long dataSize() const;
+
+        /** unlinks todelete from its extent and puts it on the deleted list */
         void deallocRecord( const DiskLoc& dl, Record* todelete );
 
     private:
+        std::string _ns;
         NamespaceDetails* _details;
         ExtentManager* _extentManager;
         bool _isSystemIndexes;
@@ -0,0 +1,332 @@
+// warm_up.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/storage/warm_up.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/database.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/record.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/background.h"
+#include "mongo/util/file.h"
+#include "mongo/util/mmap.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    extern RecordStats recordStats;
+
+    // how often the hot parts of the data files are recorded for the next startup; 0 for never
+    MONGO_EXPORT_SERVER_PARAMETER(workingSetSnapshotSecs, int, 600);
+
+    // threads prefetching the recorded working set after startup; 0 for no warm-up
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(warmUpThreads, int, 2);
+
+    // what all the warm-up threads together may read
+    MONGO_EXPORT_SERVER_PARAMETER(warmUpMBPerSec, int, 32);
+
+    namespace {
+
+        const char snapshotFileName[] = "workingSet.bson";
+
+        // keeps the snapshot small; the most recently used ranges are the ones kept
+        const size_t maxSnapshotRanges = 100 * 1000;
+
+        // the warm-up reads this much between checks for foreground page faults
+        const long long warmUpChunkBytes = 1024 * 1024;
+
+        // how long the warm-up pauses when foreground operations have faulted meanwhile
+        const int foregroundBackoffMillis = 100;
+
+        // a snapshot made while warming up would only hold the little used since startup
+        AtomicUInt32 warmingUp;
+        AtomicUInt32 started;
+
+        boost::filesystem::path snapshotPath() {
+            return boost::filesystem::path( storageGlobalParams.dbpath ) / snapshotFileName;
+        }
+
+        void loadSnapshot( vector<HotDataRange>* ranges ) {
+            const string path = snapshotPath().string();
+            if ( !boost::filesystem::exists( path ) )
+                return;
+
+            File f;
+            f.open( path.c_str(), true );
+            if ( !f.is_open() || f.bad() )
+                return;
+            fileofs len = f.len();
+            if ( len == 0 || len > 64 * 1024 * 1024 ) {
+                warning() << "ignoring working set snapshot " << path << " of " << len
+                          << " bytes" << endl;
+                return;
+            }
+            string data( len, '\0' );
+            f.read( 0, &data[0], len );
+            if ( f.bad() )
+                return;
+
+            const char* p = data.data();
+            const char* end = p + data.size();
+            while ( end - p >= 5 ) {
+                int size;
+                memcpy( &size, p, sizeof( size ) );
+                if ( size < 5 || size > end - p )
+                    break;
+                BSONObj o( p );
+                p += size;
+                if ( !o.valid() )
+                    break;
+                HotDataRange r;
+                r.db = o["db"].str();
+                r.file = o["file"].str();
+                r.offset = o["ofs"].numberLong();
+                r.length = o["len"].numberLong();
+                r.lastSeen = o["seen"].date().toTimeT();
+                if ( r.db.empty() || r.file.empty() || r.offset < 0 || r.length <= 0 )
+                    continue;
+                ranges->push_back( r );
+            }
+        }
+
+        /** the ranges of one warm-up, handed out most recently used first */
+        class WarmUp {
+        public:
+            WarmUp( const vector<HotDataRange>& ranges, int threads )
+                : _ranges( ranges ), _threads( threads ), _next( 0 ), _bytes( 0 ) {
+            }
+
+            bool take( HotDataRange* range ) {
+                boost::mutex::scoped_lock lk( _mutex );
+                if ( _next == _ranges.size() || inShutdown() )
+                    return false;
+                *range = _ranges[_next++];
+                return true;
+            }
+
+            void touched( long long bytes ) {
+                boost::mutex::scoped_lock lk( _mutex );
+                _bytes += bytes;
+            }
+
+            long long bytes() {
+                boost::mutex::scoped_lock lk( _mutex );
+                return _bytes;
+            }
+
+            int threads() const { return _threads; }
+
+        private:
+            boost::mutex _mutex;
+            const vector<HotDataRange> _ranges;
+            const int _threads;
+            size_t _next;
+            long long _bytes;
+        };
+
+        volatile char warmUpReader;
+
+        /** reads the first byte of every page of the file between offset and end */
+        long long touchRange( const string& file, long long offset, long long end ) {
+            // held while reading, so the file can't be unmapped under us
+            MongoFileFinder finder;
+            MongoFile* mf = finder.findByPath( file );
+            DurableMappedFile* mmf = dynamic_cast<DurableMappedFile*>( mf );
+            if ( !mmf || !mmf->getView() )
+                return -1;
+
+            end = std::min( end, static_cast<long long>( mmf->length() ) );
+            const char* p = static_cast<const char*>( mmf->getView() );
+            for ( long long ofs = offset; ofs < end; ofs += g_minOSPageSizeBytes )
+                warmUpReader += p[ofs];
+            return std::max( end - offset, 0LL );
+        }
+
+        void warmUpWorker( WarmUp* warmUp ) {
+            Client::initThread( "warmUp" );
+            set<string> opened;
+            long long lastFaults = recordStats.accessesNotInMemory.load();
+            Timer timer;
+            long long bytes = 0;
+
+            HotDataRange range;
+            while ( warmUp->take( &range ) ) {
+                try {
+                    if ( opened.count( range.db ) == 0 ) {
+                        // the database may have been dropped since the snapshot
+                        if ( !boost::filesystem::exists( range.file ) )
+                            continue;
+                        Client::ReadContext ctx( range.db );
+                        opened.insert( range.db );
+                    }
+                }
+                catch ( const DBException& e ) {
+                    LOG(1) << "warm-up couldn't open " << range.db << ": " << e.toString() << endl;
+                    continue;
+                }
+
+                for ( long long ofs = range.offset;
+                      ofs < range.offset + range.length && !inShutdown();
+                      ofs += warmUpChunkBytes ) {
+                    // foreground operations go first: wait out their page faults
+                    long long faults;
+                    while ( ( faults = recordStats.accessesNotInMemory.load() ) != lastFaults &&
+                            !inShutdown() ) {
+                        lastFaults = faults;
+                        sleepmillis( foregroundBackoffMillis );
+                    }
+
+                    long long touched = touchRange( range.file, ofs,
+                                                    std::min( ofs + warmUpChunkBytes,
+                                                              range.offset + range.length ) );
+                    if ( touched < 0 )
+                        break;
+                    bytes += touched;
+                    warmUp->touched( touched );
+
+                    // keep to this thread's share of warmUpMBPerSec
+                    const long long perThread =
+                        std::max( 1, warmUpMBPerSec ) * 1024LL * 1024 / warmUp->threads();
+                    const long long dueMillis = bytes * 1000 / std::max( perThread, 1LL );
+                    if ( dueMillis > timer.millis() )
+                        sleepmillis( dueMillis - timer.millis() );
+                }
+            }
+
+            cc().shutdown();
+        }
+
+        void warmUpThread() {
+            vector<HotDataRange> ranges;
+            try {
+                loadSnapshot( &ranges );
+            }
+            catch ( const std::exception& e ) {
+                warning() << "couldn't read working set snapshot: " << e.what() << endl;
+            }
+
+            int threads = std::max( warmUpThreads, 0 );
+            if ( !ranges.empty() && threads > 0 ) {
+                log() << "warming up " << ranges.size() << " recently used ranges of the data files"
+                      << endl;
+                Timer t;
+                WarmUp warmUp( ranges, threads );
+                boost::thread_group workers;
+                for ( int i = 0; i < threads; i++ )
+                    workers.create_thread( boost::bind( &warmUpWorker, &warmUp ) );
+                workers.join_all();
+                log() << "warm-up read " << warmUp.bytes() / ( 1024 * 1024 ) << "MB in "
+                      << t.seconds() << "s" << endl;
+            }
+
+            warmingUp.store( 0 );
+        }
+
+        class WorkingSetSnapshotTask : public PeriodicTask {
+        public:
+            WorkingSetSnapshotTask() : _lastSnapshot( time( 0 ) ) {}
+
+            virtual string taskName() const { return "WorkingSetSnapshot"; }
+
+            virtual void taskDoWork() {
+                if ( !started.load() || workingSetSnapshotSecs <= 0 )
+                    return;
+                time_t now = time( 0 );
+                if ( now - _lastSnapshot < workingSetSnapshotSecs )
+                    return;
+                _lastSnapshot = now;
+                saveWorkingSetSnapshot();
+            }
+
+        private:
+            time_t _lastSnapshot;
+        } workingSetSnapshotTask;
+
+    }
+
+    void startWorkingSetWarmUp() {
+        warmingUp.store( 1 );
+        started.store( 1 );
+        boost::thread t( warmUpThread );
+    }
+
+    void saveWorkingSetSnapshot() {
+        if ( !started.load() || warmingUp.load() || workingSetSnapshotSecs <= 0 )
+            return;
+
+        vector<HotDataRange> ranges;
+        getHotDataRanges( &ranges );
+        if ( ranges.empty() )
+            return;
+        if ( ranges.size() > maxSnapshotRanges )
+            ranges.resize( maxSnapshotRanges );
+
+        BufBuilder buf;
+        for ( size_t i = 0; i < ranges.size(); i++ ) {
+            BSONObj o = BSON( "db" << ranges[i].db <<
+                              "file" << ranges[i].file <<
+                              "ofs" << ranges[i].offset <<
+                              "len" << ranges[i].length <<
+                              "seen" << Date_t( ranges[i].lastSeen * 1000ULL ) );
+            buf.appendBuf( o.objdata(), o.objsize() );
+        }
+
+        // written aside and renamed over, so a crash never leaves half a snapshot
+        const boost::filesystem::path path = snapshotPath();
+        const boost::filesystem::path tmp = path.string() + ".tmp";
+        try {
+            {
+                File f;
+                f.open( tmp.string().c_str() );
+                if ( !f.is_open() || f.bad() )
+                    return;
+                f.truncate( 0 );
+                f.write( 0, buf.buf(), buf.len() );
+                f.fsync();
+                if ( f.bad() )
+                    return;
+            }
+            boost::filesystem::rename( tmp, path );
+            LOG(1) << "recorded " << ranges.size() << " working set ranges in " << path.string()
+                   << endl;
+        }
+        catch ( const std::exception& e ) {
+            warning() << "couldn't record the working set in " << path.string() << ": "
+                      << e.what() << endl;
+        }
+    }
+
+}
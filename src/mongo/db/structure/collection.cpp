@@ -48,7 +48,8 @@ namespace mongo {
         : _ns( fullNS ) {
         _details = details;
         _database = database;
-        _recordStore.init( _details,
+        _recordStore.init( _ns.ns(),
+                           _details,
                            &database->getExtentManager(),
                            _ns.coll() == "system.indexes" );
         _magic = 1357924;
@@ -67,8 +68,15 @@ namespace mongo {
         return new FlatIterator( this, start, dir );
     }
 
+    CollectionIterator* CollectionTemp::getExtentRangeIterator( const DiskLoc& firstExtent,
+                                                                const DiskLoc& lastExtent ) const {
+        verify( ok() );
+        verify( !_details->isCapped() );
+        return new ExtentRangeIterator( this, firstExtent, lastExtent );
+    }
+
     BSONObj CollectionTemp::docFor( const DiskLoc& loc ) {
-        Record* rec = getExtentManager()->recordFor( loc );
+        Record* rec = _recordStore.recordFor( loc );
         return BSONObj::make( rec->accessed() );
     }
 
@@ -91,11 +99,11 @@ namespace mongo {
         /* check if any cursors point to us.  if so, advance them. */
         ClientCursor::aboutToDelete(_ns.ns(), _details, loc);
 
-        Record* rec = getExtentManager()->recordFor( loc );
+        Record* rec = _recordStore.recordFor( loc );
 
         unindexRecord(_details, rec, loc, noWarn);
 
-        _recordStore.deallocRecord( loc, rec );
+        _recordStore.deleteRecord( loc );
 
         NamespaceDetailsTransient::get( _ns.ns().c_str() ).notifyOfWriteOp();
 
@@ -47,6 +47,7 @@ namespace mongo {
     class CollectionIterator;
     class FlatIterator;
     class CappedIterator;
+    class ExtentRangeIterator;
 
     /**
      * this is NOT safe through a yield right now
@@ -66,9 +67,19 @@ namespace mongo {
 
         BSONObj docFor( const DiskLoc& loc );
 
+        RecordStore* getRecordStore() { return &_recordStore; }
+        const RecordStore* getRecordStore() const { return &_recordStore; }
+
         CollectionIterator* getIterator( const DiskLoc& start, bool tailable,
                                          const CollectionScanParams::Direction& dir) const;
 
+        /**
+         * Iterates forward over the extents firstExtent through lastExtent of a non-capped
+         * collection.
+         */
+        CollectionIterator* getExtentRangeIterator( const DiskLoc& firstExtent,
+                                                    const DiskLoc& lastExtent ) const;
+
         void deleteDocument( const DiskLoc& loc,
                              bool cappedOK = false,
                              bool noWarn = false,
@@ -84,11 +95,12 @@ namespace mongo {
         NamespaceString _ns;
         NamespaceDetails* _details;
         Database* _database;
-        RecordStore _recordStore;
+        ExtentRecordStore _recordStore;
 
         friend class Database;
         friend class FlatIterator;
         friend class CappedIterator;
+        friend class ExtentRangeIterator;
     };
 
 }
@@ -45,37 +45,10 @@ namespace mongo {
         : _curr(start), _collection(collection), _direction(dir) {
 
         if (_curr.isNull()) {
-
-            const ExtentManager* em = _collection->getExtentManager();
-
-            if (CollectionScanParams::FORWARD == _direction) {
-
-                // Find a non-empty extent and start with the first record in it.
-                Extent* e = em->getExtent( _collection->_details->firstExtent() );
-
-                while (e->firstRecord.isNull() && !e->xnext.isNull()) {
-                    e = em->getNextExtent( e );
-                }
-
-                // _curr may be set to DiskLoc() here if e->lastRecord isNull but there is no
-                // valid e->xnext
-                _curr = e->firstRecord;
-            }
-            else {
-                // Walk backwards, skipping empty extents, and use the last record in the first
-                // non-empty extent we see.
-                Extent* e = em->getExtent( _collection->_details->lastExtent() );
-
-                // TODO ELABORATE
-                // Does one of e->lastRecord.isNull(), e.firstRecord.isNull() imply the other?
-                while (e->lastRecord.isNull() && !e->xprev.isNull()) {
-                    e = em->getPrevExtent( e );
-                }
-
-                // _curr may be set to DiskLoc() here if e->lastRecord isNull but there is no
-                // valid e->xprev
-                _curr = e->lastRecord;
-            }
+            const RecordStore* rs = _collection->getRecordStore();
+            // may be DiskLoc() if the collection is empty
+            _curr = CollectionScanParams::FORWARD == _direction ? rs->firstRecord()
+                                                                : rs->lastRecord();
         }
     }
 
@@ -89,10 +62,10 @@ namespace mongo {
         // Move to the next thing.
         if (!isEOF()) {
             if (CollectionScanParams::FORWARD == _direction) {
-                _curr = _collection->getExtentManager()->getNextRecord( _curr );
+                _curr = _collection->getRecordStore()->getNext( _curr );
             }
             else {
-                _curr = _collection->getExtentManager()->getPrevRecord( _curr );
+                _curr = _collection->getRecordStore()->getPrev( _curr );
             }
         }
 
@@ -122,6 +95,71 @@ namespace mongo {
         return true;
     }
 
+    //
+    // Traversal of a range of extents of a non-capped collection
+    //
+
+    ExtentRangeIterator::ExtentRangeIterator(const CollectionTemp* collection,
+                                             const DiskLoc& firstExtent,
+                                             const DiskLoc& lastExtent)
+        : _lastExtent(lastExtent), _collection(collection) {
+        startAtExtent(firstExtent);
+    }
+
+    void ExtentRangeIterator::startAtExtent(DiskLoc extentLoc) {
+        const ExtentManager* em = _collection->getExtentManager();
+        while (!extentLoc.isNull()) {
+            Extent* e = em->getExtent(extentLoc);
+            if (!e->firstRecord.isNull()) {
+                _currExtent = extentLoc;
+                _curr = e->firstRecord;
+                return;
+            }
+            if (extentLoc == _lastExtent) {
+                break;
+            }
+            extentLoc = e->xnext;
+        }
+        _curr = DiskLoc();
+    }
+
+    bool ExtentRangeIterator::isEOF() {
+        return _curr.isNull();
+    }
+
+    DiskLoc ExtentRangeIterator::getNext() {
+        DiskLoc ret = _curr;
+
+        if (!isEOF()) {
+            const ExtentManager* em = _collection->getExtentManager();
+            _curr = em->getNextRecordInExtent(_curr);
+            if (_curr.isNull() && _currExtent != _lastExtent) {
+                startAtExtent(em->getExtent(_currExtent)->xnext);
+            }
+        }
+
+        return ret;
+    }
+
+    void ExtentRangeIterator::invalidate(const DiskLoc& dl) {
+        verify( _collection->ok() );
+
+        // Just move past the thing being deleted.
+        if (dl == _curr) {
+            getNext();
+        }
+    }
+
+    void ExtentRangeIterator::prepareToYield() {
+    }
+
+    bool ExtentRangeIterator::recoverFromYield() {
+        // See FlatIterator::recoverFromYield.
+        verify( _collection->ok() );
+
+        return true;
+    }
+
     //
     // Capped collection traversal
     //
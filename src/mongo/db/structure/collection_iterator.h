@@ -90,6 +90,41 @@ namespace mongo {
         CollectionScanParams::Direction _direction;
     };
 
+    /**
+     * This class iterates forward over the records in the extents firstExtent through lastExtent
+     * of a non-capped collection, firstExtent coming at or before lastExtent in the collection's
+     * extent chain.  If lastExtent is DiskLoc(), the iteration ends with the collection's last
+     * extent.  The collection must exist when the constructor is called.
+     *
+     * Used to split a collection scan into several which may run concurrently.
+     */
+    class ExtentRangeIterator : public CollectionIterator {
+    public:
+        ExtentRangeIterator(const CollectionTemp* collection, const DiskLoc& firstExtent,
+                            const DiskLoc& lastExtent);
+        virtual ~ExtentRangeIterator() { }
+
+        virtual bool isEOF();
+        virtual DiskLoc getNext();
+
+        virtual void invalidate(const DiskLoc& dl);
+        virtual void prepareToYield();
+        virtual bool recoverFromYield();
+
+    private:
+        // Moves to the first record of the first non-empty extent in the range, starting at
+        // extentLoc.
+        void startAtExtent(DiskLoc extentLoc);
+
+        // The result returned on the next call to getNext(), and its extent.
+        DiskLoc _curr;
+        DiskLoc _currExtent;
+
+        const DiskLoc _lastExtent;
+
+        const CollectionTemp* _collection;
+    };
+
     /**
      * This class iterates over a capped collection identified by 'ns'.
      * The collection must exist when the constructor is called.
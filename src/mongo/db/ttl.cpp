@@ -53,7 +53,20 @@ namespace mongo {
     ServerStatusMetricField<Counter64> ttlPassesDisplay("ttl.passes", &ttlPasses);
     ServerStatusMetricField<Counter64> ttlDeletedDocumentsDisplay("ttl.deletedDocuments", &ttlDeletedDocuments);
 
+    // expired documents counted by the current pass and not yet deleted
+    Counter64 ttlBacklog;
+    ServerStatusMetricField<Counter64> ttlBacklogDisplay("ttl.backlog", &ttlBacklog);
+
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
+
+    // Seconds between the starts of TTL passes.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorSleepSecs, int, 60 );
+
+    // Expired documents are deleted this many at a time, giving up the write lock in between.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchSize, int, 1000 );
+
+    // Most expired documents deleted per second on a collection; 0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeletesPerSecond, int, 0 );
     
     class TTLMonitor : public BackgroundJob {
     public:
@@ -64,6 +77,67 @@ namespace mongo {
         
         static string secondsExpireField;
         
+        /**
+         * Deletes the documents matching 'query' a batch at a time, in the order of the ttl
+         * index 'key', holding the write lock only while a batch is deleted and keeping to
+         * ttlDeletesPerSecond.
+         * @return the number of documents deleted
+         */
+        long long deleteInBatches( const string& ns, const BSONObj& key, const BSONObj& query ) {
+            long long backlog = db.count( ns , query , QueryOption_SlaveOk );
+            ttlBacklog.increment( backlog );
+
+            const int batchSize = std::max( 1 , static_cast<int>( ttlDeleteBatchSize ) );
+            const BSONObj idField = BSON( "_id" << 1 );
+            long long deleted = 0;
+            Timer timer;
+            while ( ! inShutdown() ) {
+                BSONArrayBuilder ids;
+                int nIds = 0;
+                {
+                    auto_ptr<DBClientCursor> cursor = db.query( ns , Query( query ).hint( key ) ,
+                                                                batchSize , 0 , &idField );
+                    while ( cursor.get() && nIds < batchSize && cursor->more() ) {
+                        ids.append( cursor->next()["_id"] );
+                        nIds++;
+                    }
+                }
+                if ( nIds == 0 )
+                    break;
+
+                long long n;
+                {
+                    Client::WriteContext ctx( ns );
+                    if ( ! nsdetails( ns ) || ! isMasterNs( ns.c_str() ) )
+                        break;
+
+                    // the expiry is checked again, in case a document changed since it was found
+                    BSONObjBuilder b;
+                    b.append( "_id" , BSON( "$in" << ids.arr() ) );
+                    b.appendElements( query );
+                    n = deleteObjects( ns.c_str() , b.obj() , false , true );
+                }
+                deleted += n;
+                ttlDeletedDocuments.increment( n );
+                long long done = std::min( n , backlog );
+                ttlBacklog.decrement( done );
+                backlog -= done;
+
+                if ( nIds < batchSize )
+                    break;
+
+                if ( ttlDeletesPerSecond > 0 ) {
+                    long long dueMillis = deleted * 1000 / ttlDeletesPerSecond;
+                    long long elapsedMillis = timer.millis();
+                    if ( dueMillis > elapsedMillis )
+                        sleepmillis( dueMillis - elapsedMillis );
+                }
+            }
+
+            ttlBacklog.decrement( backlog );
+            return deleted;
+        }
+
         void doTTLForDB( const string& dbName ) {
 
             bool isMaster = isMasterNs( dbName.c_str() );
@@ -103,8 +177,9 @@ namespace mongo {
                 LOG(1) << "TTL: " << key << " \t " << query << endl;
                 
                 long long n = 0;
+                bool deletedAll = false;
+                string ns = idx["ns"].String();
                 {
-                    string ns = idx["ns"].String();
                     Client::WriteContext ctx( ns );
                     NamespaceDetails* nsd = nsdetails( ns );
                     if ( ! nsd ) {
@@ -119,8 +194,16 @@ namespace mongo {
                         continue;
                     }
 
-                    n = deleteObjects( ns.c_str() , query , false , true );
-                    ttlDeletedDocuments.increment( n );
+                    if ( ! nsd->haveIdIndex() ) {
+                        // batches are deleted by _id, so without the index do it all at once
+                        n = deleteObjects( ns.c_str() , query , false , true );
+                        ttlDeletedDocuments.increment( n );
+                        deletedAll = true;
+                    }
+                }
+
+                if ( ! deletedAll ) {
+                    n = deleteInBatches( ns , key , query );
                 }
 
                 LOG(1) << "\tTTL deleted: " << n << endl;
@@ -134,7 +217,7 @@ namespace mongo {
             cc().getAuthorizationSession()->grantInternalAuthorization();
 
             while ( ! inShutdown() ) {
-                sleepsecs( 60 );
+                sleepsecs( std::max( 1 , static_cast<int>( ttlMonitorSleepSecs ) ) );
                 
                 LOG(3) << "TTLMonitor thread awake" << endl;
 
@@ -49,11 +49,14 @@ namespace mongo {
 
         // The aggregation command may now be requested to return cursors.
         AGG_RETURNS_CURSORS = 1,
+
+        // Messages may be sent snappy compressed (dbCompressed) once negotiated in isMaster.
+        COMPRESSED_MESSAGES = 2,
     };
 
     // Latest version that the server accepts. This should always be at the latest entry in
     // WireVersion.
-    static const int maxWireVersion = AGG_RETURNS_CURSORS;
+    static const int maxWireVersion = COMPRESSED_MESSAGES;
 
     // Minimum version that the server accepts. We should bump this whenever we don't want
     // to allow communication with too old agents.
@@ -43,6 +43,9 @@ namespace mongo {
     static Counter64 gleWtimeouts;
     static ServerStatusMetricField<Counter64> gleWtimeoutsDisplay( "getLastError.wtimeouts", &gleWtimeouts );
 
+    // longest a w>1 waiter sleeps between checks for killOp and stepdown
+    static const int maxSlaveUpdateWaitMillis = 100;
+
     bool waitForWriteConcern(const BSONObj& cmdObj,
                              bool err,
                              BSONObjBuilder* result,
@@ -151,6 +154,9 @@ namespace mongo {
 
             while ( 1 ) {
 
+                // read before checking, so that progress made after the check wakes the wait
+                unsigned long long slaveUpdates = getSlaveUpdateCount();
+
                 if ( !_isMaster() ) {
                     // this should be in the while loop in case we step down
                     *errmsg = "not master";
@@ -183,7 +189,14 @@ namespace mongo {
 
                 verify( sprintf( buf , "w block pass: %lld" , ++passes ) < 30 );
                 c.curop()->setMessage( buf );
-                sleepmillis(1);
+
+                // wait for a slave to report progress rather than polling; the wait is bounded
+                // so that killOp and stepping down are still noticed
+                int waitMillis = maxSlaveUpdateWaitMillis;
+                if ( timeout > 0 )
+                    waitMillis = std::min( waitMillis, timeout - gleTimerHolder->millis() );
+                if ( waitMillis > 0 )
+                    waitForSlaveUpdate( slaveUpdates, waitMillis );
                 killCurrentOp.checkForInterrupt();
             }
 
@@ -23,6 +23,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/platform/float_utils.h"
 
 namespace AccumulatorTests {
 
@@ -471,7 +472,22 @@ namespace AccumulatorTests {
                 ASSERT_EQUALS( 7 , accumulator()->getValue(false).getInt() );
             }
         };
-        
+
+        /* A run of doubles retains the minimum, and a NaN is lower than every number. */
+        class Doubles : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                accumulator()->process(Value(2.5), false);
+                accumulator()->process(Value(-1.5), false);
+                accumulator()->process(Value(3.0), false);
+                ASSERT_EQUALS( -1.5, accumulator()->getValue(false).getDouble() );
+                accumulator()->process(Value(numeric_limits<double>::quiet_NaN()), false);
+                accumulator()->process(Value(-7.0), false);
+                ASSERT( isNaN( accumulator()->getValue(false).getDouble() ) );
+            }
+        };
+
     } // namespace Min
     
     namespace Max {
@@ -538,7 +554,20 @@ namespace AccumulatorTests {
                 ASSERT_EQUALS( 7, accumulator()->getValue(false).getInt() );
             }
         };
-        
+
+        /* A run of doubles retains the maximum, and a NaN is never retained over a number. */
+        class Doubles : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                accumulator()->process(Value(2.5), false);
+                accumulator()->process(Value(numeric_limits<double>::quiet_NaN()), false);
+                accumulator()->process(Value(-1.5), false);
+                accumulator()->process(Value(3.0), false);
+                ASSERT_EQUALS( 3.0, accumulator()->getValue(false).getDouble() );
+            }
+        };
+
     } // namespace Max
 
     namespace Sum {
@@ -867,12 +896,14 @@ namespace AccumulatorTests {
             add<Min::Missing>();
             add<Min::Two>();
             add<Min::LastMissing>();
+            add<Min::Doubles>();
 
             add<Max::None>();
             add<Max::One>();
             add<Max::Missing>();
             add<Max::Two>();
             add<Max::LastMissing>();
+            add<Max::Doubles>();
 
             add<Sum::None>();
             add<Sum::OneInt>();
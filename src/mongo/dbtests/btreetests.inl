@@ -152,6 +152,36 @@
         }
     };
 
+    /** unindexing from a leaf that needn't rebalance writes back only the changed bytes */
+    class UnindexFromLeaf : public Base {
+    public:
+        void run() {
+            for ( char c = 'a'; c <= 'j'; ++c ) {
+                BSONObj k = simpleKey( c );
+                insert( k );
+            }
+            checkValid( 10 );
+
+            for ( char c = 'c'; c <= 'g'; c += 2 ) {
+                BSONObj k = simpleKey( c );
+                ASSERT( unindex( k ) );
+            }
+            checkValid( 7 );
+            ASSERT_EQUALS( 7, bt()->nKeys() );
+            for ( char c = 'a'; c <= 'j'; ++c ) {
+                BSONObj k = simpleKey( c );
+                ASSERT_EQUALS( c != 'c' && c != 'e' && c != 'g', present( k, 1 ) );
+            }
+
+            // and the bucket takes them back
+            for ( char c = 'c'; c <= 'g'; c += 2 ) {
+                BSONObj k = simpleKey( c );
+                insert( k );
+            }
+            checkValid( 10 );
+        }
+    };
+
     class SplitUnevenBucketBase : public Base {
     public:
         virtual ~SplitUnevenBucketBase() {}
@@ -307,6 +337,33 @@
         }
     };
 
+    class DupCheckSkipsUnused : public Base {
+    public:
+        void run() {
+            for ( int i = 0; i < 10; ++i ) {
+                BSONObj k = key( 'b' + 2 * i );
+                Base::insert( k );
+            }
+            BSONObj root = key( 'p' );
+            unindex( root );
+            // only an unused entry for the key remains, so a unique insert succeeds
+            uniqueInsert( root, DiskLoc( 0, 4 ) );
+            // the same record again is reported as already in the index
+            ASSERT_THROWS( uniqueInsert( root, DiskLoc( 0, 4 ) ), AssertionException );
+            // another record is a duplicate of the used entry
+            ASSERT_THROWS( uniqueInsert( root, DiskLoc( 0, 6 ) ), UserException );
+            checkValid( 10 );
+        }
+    private:
+        BSONObj key( char c ) {
+            return simpleKey( c, 800 );
+        }
+        void uniqueInsert( BSONObj &k, const DiskLoc &loc ) {
+            bt()->bt_insert( dl(), loc, k, Ordering::make( order() ), false, id(), true );
+            getDur().commitIfNeeded();
+        }
+    };
+
     class PackUnused : public Base {
     public:
         void run() {
@@ -1635,12 +1692,14 @@
         void setupTests() {
             add< Create >();
             add< SimpleInsertDelete >();
+            add< UnindexFromLeaf >();
             add< SplitRightHeavyBucket >();
             add< SplitLeftHeavyBucket >();
             add< MissingLocate >();
             add< MissingLocateMultiBucket >();
             add< SERVER983 >();
             add< DontReuseUnused >();
+            add< DupCheckSkipsUnused >();
             add< PackUnused >();
             add< DontDropReferenceKey >();
             add< MergeBucketsLeft >();
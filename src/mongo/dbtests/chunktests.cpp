@@ -75,16 +75,22 @@ namespace ChunkTests {
                 chunkManager.setShardKey( shardKey() );
                 chunkManager.setSingleChunkForShards( splitPointsVector() );
                 
+                // the second lookup uses the targeting remembered for the query's shape
+                for( int pass = 0; pass < 2; ++pass ) {
+                    ASSERT_EQUALS( expectedShardNames(), shardNames( chunkManager, query() ) );
+                }
+            }
+        protected:
+            static BSONArray shardNames( const ChunkManager &chunkManager, const BSONObj &query ) {
                 set<Shard> shards;
-                chunkManager.getShardsForQuery( shards, query() );
+                chunkManager.getShardsForQuery( shards, query );
                 
                 BSONArrayBuilder b;
                 for( set<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
                     b << i->getName();
                 }
-                ASSERT_EQUALS( expectedShardNames(), b.arr() );
+                return b.arr();
             }
-        protected:
             virtual BSONObj shardKey() const { return BSON( "a" << 1 ); }
             virtual BSONArray splitPoints() const { return BSONArray(); }
             virtual BSONObj query() const { return BSONObj(); }
@@ -215,6 +221,7 @@ namespace ChunkTests {
         };
 
         class CompoundKeyBase : public Base {
+        protected:
             virtual BSONObj shardKey() const {
                 return BSON( "a" << 1 << "b" << 1 );
             }
@@ -235,6 +242,37 @@ namespace ChunkTests {
             }
         };
 
+        /** Queries of one shape with different constants are targeted by their constants. */
+        class SameShapeDifferentConstants : public CompoundKeyBase {
+        public:
+            void run() {
+                ChunkManager chunkManager;
+                chunkManager.setShardKey( shardKey() );
+                chunkManager.setSingleChunkForShards( splitPointsVector() );
+
+                ASSERT_EQUALS( BSON_ARRAY( "1" ),
+                               shardNames( chunkManager, BSON( "a" << 5 << "b" << 15 ) ) );
+                ASSERT_EQUALS( BSON_ARRAY( "0" ),
+                               shardNames( chunkManager, BSON( "a" << 5 << "b" << 5 ) ) );
+                ASSERT_EQUALS( BSON_ARRAY( "2" ),
+                               shardNames( chunkManager, BSON( "a" << 5 << "b" << 25 ) ) );
+                ASSERT_EQUALS( BSON_ARRAY( "2" ),
+                               shardNames( chunkManager, BSON( "a" << 6 << "b" << 0 ) ) );
+
+                // a constant of another kind is another shape
+                ASSERT_EQUALS( BSON_ARRAY( "0" << "1" << "2" ),
+                               shardNames( chunkManager, BSON( "a" << 5 << "b" << GT << 0 ) ) );
+                ASSERT_EQUALS( BSON_ARRAY( "0" ),
+                               shardNames( chunkManager, BSON( "a" << 5 << "b" << BSONNULL ) ) );
+
+                // queries not constraining the shard key go everywhere
+                ASSERT_EQUALS( BSON_ARRAY( "0" << "1" << "2" ),
+                               shardNames( chunkManager, BSON( "c" << 1 ) ) );
+                ASSERT_EQUALS( BSON_ARRAY( "0" << "1" << "2" ),
+                               shardNames( chunkManager, BSON( "c" << 2 ) ) );
+            }
+        };
+
     } // namespace ChunkManagerTests
     
     class All : public Suite {
@@ -263,6 +301,7 @@ namespace ChunkTests {
             add<ChunkManagerTests::InequalityThenUnsatisfiable>();
             add<ChunkManagerTests::OrEqualityUnsatisfiableInequality>();
             add<ChunkManagerTests::InMultiShard>();
+            add<ChunkManagerTests::SameShapeDifferentConstants>();
         }
     } myall;
     
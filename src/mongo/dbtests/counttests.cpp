@@ -161,6 +161,32 @@ namespace CountTests {
         mutable boost::condition _condition;
     };
 
+    /** Counts over an interval of many btree buckets, counting keys in bulk. */
+    class IndexedRange : public Base {
+    public:
+        void run() {
+            for( int i = 0; i < 5000; ++i ) {
+                insert( BSON( "a" << i ) );
+            }
+            BSONObj range = BSON( "a" << GTE << 100 << LT << 4100 );
+            string err;
+            int errCode;
+            ASSERT_EQUALS( 4000, runCount( ns(), countCommand( range ), err, errCode ) );
+            ASSERT_EQUALS( 1000, runCount( ns(), BSON( "query" << range << "limit" << 1000 ),
+                                           err, errCode ) );
+            ASSERT_EQUALS( 3990, runCount( ns(), BSON( "query" << range << "skip" << 10 ),
+                                           err, errCode ) );
+            ASSERT_EQUALS( 7, runCount( ns(), BSON( "query" << range << "skip" << 3993 <<
+                                                    "limit" << -20 ),
+                                        err, errCode ) );
+
+            // Once the index is multikey, each document is counted once.
+            insert( BSON( "a" << BSON_ARRAY( 200 << 201 << 202 ) ) );
+            ASSERT_EQUALS( 4001, runCount( ns(), countCommand( range ), err, errCode ) );
+            ASSERT_EQUALS( "", err );
+        }
+    };
+
     /** A writer client will be registered for the lifetime of an object of this class. */
     class WriterClientScope {
     public:
@@ -201,8 +227,10 @@ namespace CountTests {
         void run() {
             // Insert enough documents that counting them will exceed the iteration threshold
             // to trigger a yield.
+            // Keys matched exactly by the index bounds are counted in bulk without iterating
+            // the cursor, so 'b' is filtered to require per document iteration.
             for( int i = 0; i < 1000; ++i ) {
-                insert( BSON( "a" << 1 ) );
+                insert( BSON( "a" << 1 << "b" << 1 ) );
             }
             
             // Call runCount() under a read lock.
@@ -213,7 +241,8 @@ namespace CountTests {
             
             string err;
             int errCode;
-            ASSERT_EQUALS( 1000, runCount( ns(), countCommand( BSON( "a" << 1 ) ), err, errCode ) );
+            ASSERT_EQUALS( 1000, runCount( ns(), countCommand( BSON( "a" << 1 << "b" << 1 ) ),
+                                             err, errCode ) );
             ASSERT_EQUALS( "", err );
 
             int numYieldsAfterCount = numYields();
@@ -242,6 +271,7 @@ namespace CountTests {
             add<Fields>();
             add<QueryFields>();
             add<IndexedRegex>();
+            add<IndexedRange>();
             add<Yield>();
         }
     } myall;
@@ -1074,7 +1074,7 @@ namespace DocumentSourceTests {
                     sort()->serializeToArray(arr);
                     ASSERT_EQUALS(arr[0].getDocument().toBson(), BSON("$sort" << BSON("a" << 1)));
 
-                    ASSERT(sort()->getShardSource() == NULL);
+                    ASSERT(sort()->getShardSource() != NULL);
                     ASSERT(sort()->getRouterSource() != NULL);
                 }
 
@@ -1092,6 +1092,13 @@ namespace DocumentSourceTests {
 
                 ASSERT(sort()->getShardSource() != NULL);
                 ASSERT(sort()->getRouterSource() != NULL);
+
+                // the router merges the shards' sorted results, applying the limit again
+                arr.clear();
+                sort()->getRouterSource()->serializeToArray(arr);
+                ASSERT_EQUALS(Value(arr),
+                              DOC_ARRAY(DOC("$sort" << DOC("a" << 1 << "$mergePresorted" << true))
+                                        << DOC("$limit" << sort()->getLimit())));
             }
 
             intrusive_ptr<DocumentSource> mkLimit(int limit) {
@@ -1193,6 +1200,17 @@ namespace DocumentSourceTests {
             string expectedResultSetString() { return "[{_id:1,a:1},{_id:0,a:2}]"; }
         };
 
+        /** A merging sort whose source doesn't keep presorted streams apart sorts everything. */
+        class MergePresortedWithoutCursors : public CheckResultsBase {
+            void populateData() {
+                client.insert( ns, BSON( "_id" << 0 << "a" << 2 ) );
+                client.insert( ns, BSON( "_id" << 1 << "a" << 1 ) );
+                client.insert( ns, BSON( "_id" << 2 << "a" << 3 ) );
+            }
+            string expectedResultSetString() { return "[{_id:1,a:1},{_id:0,a:2},{_id:2,a:3}]"; }
+            BSONObj sortSpec() { return BSON( "a" << 1 << "$mergePresorted" << true ); }
+        };
+
         /** Sort spec is not an object. */
         class NonObjectSpec : public Base {
         public:
@@ -1711,6 +1729,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceSort::Empty>();
             add<DocumentSourceSort::SingleValue>();
             add<DocumentSourceSort::TwoValues>();
+            add<DocumentSourceSort::MergePresortedWithoutCursors>();
             add<DocumentSourceSort::NonObjectSpec>();
             add<DocumentSourceSort::EmptyObjectSpec>();
             add<DocumentSourceSort::NonNumberDirectionSpec>();
@@ -287,6 +287,75 @@ namespace DocumentTests {
             }
         };
 
+        /** withField() and withNestedField() share the unchanged fields with the original. */
+        class WithField {
+        public:
+            void run() {
+                const Document document = fromBson( fromjson( "{a:1,b:{c:2,d:3},e:'x'}" ) );
+
+                const Document withA = document.withField(document.positionOf("a"), Value(5));
+                ASSERT_EQUALS( DOC( "a" << 5 << "b" << DOC( "c" << 2 << "d" << 3 ) << "e" << "x" ),
+                               withA );
+                ASSERT_EQUALS( 5, withA["a"].getInt() );
+                ASSERT_EQUALS( document["b"].getDocument().getPtr(),
+                               withA["b"].getDocument().getPtr() );
+                ASSERT_EQUALS( Value(1), document["a"] );
+
+                // Iteration sees the replacement in the original field's place.
+                FieldIterator it (withA);
+                ASSERT_EQUALS( "a", it.next().first.toString() );
+                ASSERT_EQUALS( "b", it.next().first.toString() );
+                ASSERT_EQUALS( "e", it.next().first.toString() );
+                ASSERT( !it.more() );
+
+                // Replacing the same field again doesn't stack overlays.
+                const Document withA2 = withA.withField(withA.positionOf("a"), Value(6));
+                ASSERT_EQUALS( 6, withA2["a"].getInt() );
+                ASSERT_EQUALS( 5, withA["a"].getInt() );
+
+                // Changing an overlay copies it, leaving the original alone.
+                MutableDocument md (withA);
+                md["e"] = Value("y");
+                ASSERT_EQUALS( DOC( "a" << 5 << "b" << DOC( "c" << 2 << "d" << 3 ) << "e" << "y" ),
+                               md.freeze() );
+                ASSERT_EQUALS( Value("x"), withA["e"] );
+                ASSERT_EQUALS( Value("x"), document["e"] );
+
+                vector<Position> path;
+                ASSERT_EQUALS( Value(3), document.getNestedField(FieldPath("b.d"), &path) );
+                const Document withD = document.withNestedField(path, Value(4));
+                ASSERT_EQUALS( Value(4), withD.getNestedField(FieldPath("b.d")) );
+                ASSERT_EQUALS( Value(2), withD.getNestedField(FieldPath("b.c")) );
+                ASSERT_EQUALS( Value(3), document.getNestedField(FieldPath("b.d")) );
+            }
+        };
+
+        /** getField() with a hash from hashFieldName(), in small, hashed and lazy documents. */
+        class GetFieldWithHash {
+        public:
+            void run() {
+                const unsigned hashB = Document::hashFieldName("b");
+                const unsigned hashZ = Document::hashFieldName("z");
+
+                const Document small = fromBson( BSON( "a" << 1 << "b" << 2 ) );
+                ASSERT_EQUALS( Value(2), small.getField("b", hashB) );
+                ASSERT( small.getField("z", hashZ).missing() );
+
+                const BSONObj bson = BSON( "a" << 1 << "c" << 3 << "d" << 4 << "e" << 5
+                                           << "f" << 6 << "b" << 2 );
+                const Document large = fromBson( bson );
+                ASSERT_EQUALS( Value(2), large.getField("b", hashB) );
+                ASSERT( large.getField("z", hashZ).missing() );
+
+                const Document lazy = Document::fromBsonLazily( bson );
+                ASSERT_EQUALS( Value(2), lazy.getField("b", hashB) );
+                ASSERT( lazy.getField("z", hashZ).missing() );
+
+                const Document overlay = large.withField(large.positionOf("b"), Value(7));
+                ASSERT_EQUALS( Value(7), overlay.getField("b", hashB) );
+            }
+        };
+
         /** FieldIterator for an empty Document. */
         class FieldIteratorEmpty {
         public:
@@ -332,6 +401,59 @@ namespace DocumentTests {
             }
         };
 
+        /** Documents that convert their BSON fields as they are looked up. */
+        class LazyFromBson {
+        public:
+            void run() {
+                ASSERT( Document::fromBsonLazily( BSONObj() ).empty() );
+
+                // enough fields to use the hash table
+                const BSONObj obj = fromjson( "{a:1,b:{c:2},d:'x',e:[3],f:true,g:null}" );
+                Document lazy = Document::fromBsonLazily( obj );
+                ASSERT( !lazy.empty() );
+
+                // look up out of order, and again once converted
+                ASSERT_EQUALS( Value( true ), lazy["f"] );
+                ASSERT_EQUALS( Value( 1 ), lazy["a"] );
+                ASSERT_EQUALS( Value( 2 ), lazy.getNestedField( FieldPath( "b.c" ) ) );
+                ASSERT_EQUALS( Value( true ), lazy["f"] );
+                ASSERT( lazy["z"].missing() );
+                ASSERT_EQUALS( 6U, lazy.size() );
+                ASSERT_EQUALS( fromBson( obj ), lazy );
+                ASSERT_EQUALS( obj, lazy.toBson() );
+
+                // the BSON doesn't have to outlive the Document
+                Document fromTemp = Document::fromBsonLazily( BSON( "a" << "hello" << "b" << 1 ) );
+                ASSERT_EQUALS( Value( 1 ), fromTemp["b"] );
+                ASSERT_EQUALS( "hello", fromTemp["a"].getString() );
+            }
+        };
+
+        /** Modifying a lazily converted Document keeps the field order of the BSON. */
+        class LazyFromBsonModify {
+        public:
+            void run() {
+                const BSONObj obj = BSON( "a" << 1 << "b" << 2 << "c" << 3 );
+                const Document lazy = Document::fromBsonLazily( obj );
+                ASSERT_EQUALS( Value( 1 ), lazy["a"] );
+
+                MutableDocument md ( lazy );
+                md.addField( "d", Value( 4 ) );
+                md.setField( "b", Value( 5 ) );
+                ASSERT_EQUALS( BSON( "a" << 1 << "b" << 5 << "c" << 3 << "d" << 4 ),
+                               md.freeze().toBson() );
+
+                // the original is unchanged
+                ASSERT_EQUALS( obj, lazy.toBson() );
+
+                // an unshared Document is modified in place
+                MutableDocument inPlace ( Document::fromBsonLazily( obj ) );
+                inPlace.remove( "a" );
+                inPlace.addField( "e", Value( 6 ) );
+                ASSERT_EQUALS( BSON( "b" << 2 << "c" << 3 << "e" << 6 ), inPlace.freeze().toBson() );
+            }
+        };
+
         class AllTypesDoc {
         public:
             void run() {
@@ -499,6 +621,19 @@ namespace DocumentTests {
             }
         };
 
+        /** Strings around the longest length stored inline in a Value. */
+        class StringInlineBoundary {
+        public:
+            void run() {
+                for (size_t len = 11; len <= 15; len++) {
+                    const string str (len, 'x');
+                    Value value = Value( str );
+                    ASSERT_EQUALS( str, value.getString() );
+                    assertRoundTrips( value );
+                }
+            }
+        };
+
         /** String with a null character. */
         class StringWithNull {
         public:
@@ -1412,9 +1547,13 @@ namespace DocumentTests {
             add<Document::CompareNamedNull>();
             add<Document::Clone>();
             add<Document::CloneMultipleFields>();
+            add<Document::WithField>();
+            add<Document::GetFieldWithHash>();
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
+            add<Document::LazyFromBson>();
+            add<Document::LazyFromBsonModify>();
             add<Document::AllTypesDoc>();
 
             add<Value::BSONArrayTest>();
@@ -1422,6 +1561,7 @@ namespace DocumentTests {
             add<Value::Long>();
             add<Value::Double>();
             add<Value::String>();
+            add<Value::StringInlineBoundary>();
             add<Value::StringWithNull>();
             add<Value::Date>();
             add<Value::Timestamp>();
@@ -3541,6 +3541,131 @@ namespace ExpressionTests {
 
     } // namespace AllAnyElements
 
+    namespace Cond {
+
+        class OptimizeBase {
+        public:
+            virtual ~OptimizeBase() {}
+            void run() {
+                BSONObj specObject = BSON( "" << spec() );
+                BSONElement specElement = specObject.firstElement();
+                intrusive_ptr<Expression> expression = Expression::parseOperand( specElement );
+                intrusive_ptr<Expression> optimized = expression->optimize();
+                ASSERT_EQUALS( expectedOptimized(), BSON( "" << optimized->serialize() ) );
+            }
+        protected:
+            virtual BSONObj spec() = 0;
+            virtual BSONObj expectedOptimized() = 0;
+        };
+
+        /** A true constant condition is replaced by the 'then' branch. */
+        class ConstantTrue : public OptimizeBase {
+            BSONObj spec() { return BSON( "$cond" << BSON_ARRAY( true << "$a" << "$b" ) ); }
+            BSONObj expectedOptimized() { return BSON( "" << "$a" ); }
+        };
+
+        /** A false constant condition is replaced by the 'else' branch. */
+        class ConstantFalse : public OptimizeBase {
+            BSONObj spec() {
+                return BSON( "$cond" << BSON_ARRAY( BSON( "$eq" << BSON_ARRAY( 1 << 2 ) ) <<
+                                                    "$a" << "$b" ) );
+            }
+            BSONObj expectedOptimized() { return BSON( "" << "$b" ); }
+        };
+
+        /** A condition that is not constant is kept. */
+        class NonConstant : public OptimizeBase {
+            BSONObj spec() { return BSON( "$cond" << BSON_ARRAY( "$x" << "$a" << "$b" ) ); }
+            BSONObj expectedOptimized() {
+                return BSON( "" << BSON( "$cond" << BSON_ARRAY( "$x" << "$a" << "$b" ) ) );
+            }
+        };
+
+    } // namespace Cond
+
+    namespace IfNull {
+
+        /** A non-null constant first operand is the result. */
+        class NotNullConstant : public Cond::OptimizeBase {
+            BSONObj spec() { return BSON( "$ifNull" << BSON_ARRAY( 5 << "$b" ) ); }
+            BSONObj expectedOptimized() { return BSON( "" << BSON( "$const" << 5 ) ); }
+        };
+
+        /** A null constant first operand is replaced by the second. */
+        class NullConstant : public Cond::OptimizeBase {
+            BSONObj spec() { return BSON( "$ifNull" << BSON_ARRAY( BSONNULL << "$b" ) ); }
+            BSONObj expectedOptimized() { return BSON( "" << "$b" ); }
+        };
+
+        /** A first operand that is not constant is kept. */
+        class NonConstant : public Cond::OptimizeBase {
+            BSONObj spec() { return BSON( "$ifNull" << BSON_ARRAY( "$a" << "$b" ) ); }
+            BSONObj expectedOptimized() {
+                return BSON( "" << BSON( "$ifNull" << BSON_ARRAY( "$a" << "$b" ) ) );
+            }
+        };
+
+    } // namespace IfNull
+
+    namespace CommonSubexpression {
+
+        static intrusive_ptr<Expression> parseTopLevel( const BSONObj& spec ) {
+            BSONObj specObject = BSON( "" << spec );
+            BSONElement specElement = specObject.firstElement();
+            Expression::ObjectCtx ctx( Expression::ObjectCtx::DOCUMENT_OK |
+                                       Expression::ObjectCtx::TOP_LEVEL );
+            return Expression::parseObject( &specElement, &ctx )->optimize();
+        }
+
+        static vector<intrusive_ptr<ExpressionCommonSubexpression> > eliminate(
+                intrusive_ptr<Expression>& expression ) {
+            vector<intrusive_ptr<Expression>*> roots;
+            expression->addChildrenInSameScope( roots );
+            return Expression::eliminateCommonSubexpressions( roots );
+        }
+
+        static BSONObj evaluate( const intrusive_ptr<Expression>& expression,
+                                 const BSONObj& input ) {
+            return expression->evaluate( fromBson( input ) ).getDocument().toBson();
+        }
+
+        /** The same $cond in two fields is shared, and evaluated per document. */
+        class Shared {
+        public:
+            void run() {
+                BSONObj cond = BSON( "$cond" << BSON_ARRAY( BSON( "$gt" << BSON_ARRAY( "$a" << 1 ) )
+                                                            << "$b" << "$c" ) );
+                intrusive_ptr<Expression> expression =
+                        parseTopLevel( BSON( "x" << cond <<
+                                             "y" << BSON( "$add" << BSON_ARRAY( cond << 1 ) ) ) );
+                BSONObj serialized = expressionToBson( expression );
+
+                vector<intrusive_ptr<ExpressionCommonSubexpression> > shared =
+                        eliminate( expression );
+                ASSERT_EQUALS( 1U, shared.size() );
+                ASSERT_EQUALS( serialized, expressionToBson( expression ) );
+
+                ASSERT_EQUALS( BSON( "x" << 5 << "y" << 6 ),
+                               evaluate( expression, BSON( "a" << 2 << "b" << 5 << "c" << 7 ) ) );
+                shared[0]->reset();
+                ASSERT_EQUALS( BSON( "x" << 7 << "y" << 8 ),
+                               evaluate( expression, BSON( "a" << 0 << "b" << 5 << "c" << 7 ) ) );
+            }
+        };
+
+        /** Field paths and constants are cheap, so they are not shared. */
+        class Cheap {
+        public:
+            void run() {
+                intrusive_ptr<Expression> expression =
+                        parseTopLevel( BSON( "x" << "$a" << "y" << "$a" <<
+                                             "z" << BSON( "$add" << BSON_ARRAY( "$a" << 1 ) ) ) );
+                ASSERT_EQUALS( 0U, eliminate( expression ).size() );
+            }
+        };
+
+    } // namespace CommonSubexpression
+
     class All : public Suite {
     public:
         All() : Suite( "expression" ) {
@@ -3862,6 +3987,17 @@ namespace ExpressionTests {
             add<AllAnyElements::TrueViaInt>();
             add<AllAnyElements::FalseViaInt>();
             add<AllAnyElements::Null>();
+
+            add<Cond::ConstantTrue>();
+            add<Cond::ConstantFalse>();
+            add<Cond::NonConstant>();
+
+            add<IfNull::NotNullConstant>();
+            add<IfNull::NullConstant>();
+            add<IfNull::NonConstant>();
+
+            add<CommonSubexpression::Shared>();
+            add<CommonSubexpression::Cheap>();
         }
     } myall;
 
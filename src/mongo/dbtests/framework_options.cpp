@@ -105,6 +105,16 @@ namespace mongo {
         if (!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("perfJson", "perfJson", moe::String,
+                    "file to append perf results to, one json document per line", true));
+        if (!ret.isOK()) {
+            return ret;
+        }
+        ret = options->addOption(OD("oplogFile", "oplogFile", moe::String,
+                    "bson dump of oplog entries for the replsetperf suite to apply", true));
+        if (!ret.isOK()) {
+            return ret;
+        }
 
         ret = options->addOption(OD("suites", "suites", moe::StringVector, "test suites to run",
                     false));
@@ -175,6 +185,14 @@ namespace mongo {
             frameworkGlobalParams.perfHist = params["perfHist"].as<unsigned>();
         }
 
+        if (params.count("perfJson")) {
+            frameworkGlobalParams.perfJson = params["perfJson"].as<string>();
+        }
+
+        if (params.count("oplogFile")) {
+            frameworkGlobalParams.oplogFile = params["oplogFile"].as<string>();
+        }
+
         bool nodur = false;
         if( params.count("nodur") ) {
             nodur = true;
@@ -35,6 +35,8 @@ namespace mongo {
 
     struct FrameworkGlobalParams {
         unsigned perfHist;
+        std::string perfJson;
+        std::string oplogFile;
         unsigned long long seed;
         int runsPerTest;
         std::string dbpathSpec;
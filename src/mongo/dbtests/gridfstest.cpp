@@ -21,6 +21,7 @@
 #include "mongo/util/assert_util.h"
 
 using mongo::DBDirectClient;
+using mongo::GridFile;
 using mongo::GridFS;
 using mongo::MsgAssertionException;
 
@@ -41,6 +42,43 @@ namespace {
         virtual ~SetChunkSizeTest() {}
     };
 
+    class WriteRangeTest {
+    public:
+        virtual void run() {
+            GridFS grid( _client, "gridtest" );
+            grid.setChunkSize( 5 );
+
+            const std::string data = "0123456789abcdefghijklmnopqrstuvwxyz";
+            grid.storeFile( data.c_str(), data.size(), "writeRange" );
+            GridFile f = grid.findFile( "writeRange" );
+            ASSERT_EQUALS( 8, f.getNumChunks() );
+
+            std::ostringstream all;
+            ASSERT_EQUALS( data.size(), f.write( all ) );
+            ASSERT_EQUALS( data, all.str() );
+
+            // within one chunk, across chunks, and past the end
+            std::ostringstream one;
+            ASSERT_EQUALS( 3U, f.writeRange( one, 6, 3 ) );
+            ASSERT_EQUALS( "678", one.str() );
+
+            std::ostringstream across;
+            ASSERT_EQUALS( 14U, f.writeRange( across, 3, 14 ) );
+            ASSERT_EQUALS( data.substr( 3, 14 ), across.str() );
+
+            std::ostringstream tail;
+            ASSERT_EQUALS( 6U, f.writeRange( tail, 30, 100 ) );
+            ASSERT_EQUALS( "uvwxyz", tail.str() );
+
+            std::ostringstream none;
+            ASSERT_EQUALS( 0U, f.writeRange( none, 36, 10 ) );
+
+            grid.removeFile( "writeRange" );
+        }
+
+        virtual ~WriteRangeTest() {}
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "gridfs" ) {
@@ -48,6 +86,7 @@ namespace {
 
         void setupTests() {
             add< SetChunkSizeTest >();
+            add< WriteRangeTest >();
         }
     } myall;
 }
@@ -578,6 +578,74 @@ namespace IndexUpdateTests {
         }
     };
 
+    /** An IndexBuildBatch builds the indexes whose specs were inserted once it's finished. */
+    class BuildIndexesInBatch : public IndexBuildBase {
+    public:
+        void run() {
+            int32_t nDocs = 100;
+            for( int32_t i = 0; i < nDocs; ++i ) {
+                _client.insert( _ns, BSON( "a" << i << "b" << -i ) );
+            }
+            IndexBuildBatch batch;
+            BSONObj aInfo = BSON( "key" << BSON( "a" << 1 ) << "ns" << _ns << "name" << "a_1" );
+            BSONObj bInfo = BSON( "key" << BSON( "b" << 1 ) << "ns" << _ns << "name" << "b_1" );
+            theDataFileMgr.insertWithObjMod( "unittests.system.indexes", aInfo, false );
+            theDataFileMgr.insertWithObjMod( "unittests.system.indexes", bInfo, false );
+            // Both indexes are waiting to be built.
+            ASSERT_EQUALS( 1, nsdetails( _ns )->getCompletedIndexCount() );
+            ASSERT_EQUALS( 3, nsdetails( _ns )->getTotalIndexCount() );
+
+            batch.finish();
+            ASSERT_EQUALS( 3, nsdetails( _ns )->getCompletedIndexCount() );
+            ASSERT_EQUALS( 3, nsdetails( _ns )->getTotalIndexCount() );
+            ASSERT_EQUALS( 2U, _client.count( "unittests.system.indexes",
+                                              BSON( "ns" << _ns << "name" << NE << "_id_" ) ) );
+            // Each index has a key for every document.
+            ASSERT_EQUALS( nDocs,
+                           _client.query( _ns, Query().hint( BSON( "a" << 1 ) ) )->itcount() );
+            ASSERT_EQUALS( nDocs,
+                           _client.query( _ns, Query().hint( BSON( "b" << 1 ) ) )->itcount() );
+        }
+    };
+
+    /** If one index of an IndexBuildBatch fails, all of them are rolled back. */
+    class BuildIndexesInBatchFailure : public IndexBuildBase {
+    public:
+        void run() {
+            _client.insert( _ns, BSON( "a" << 1 << "b" << 1 ) );
+            _client.insert( _ns, BSON( "a" << 1 << "b" << 2 ) );
+            IndexBuildBatch batch;
+            BSONObj bInfo = BSON( "key" << BSON( "b" << 1 ) << "ns" << _ns << "name" << "b_1" );
+            BSONObj aInfo = BSON( "key" << BSON( "a" << 1 ) << "ns" << _ns << "name" << "a_1" <<
+                                  "unique" << true );
+            theDataFileMgr.insertWithObjMod( "unittests.system.indexes", bInfo, false );
+            theDataFileMgr.insertWithObjMod( "unittests.system.indexes", aInfo, false );
+            // The unique index can't be built over the duplicate values of a.
+            ASSERT_THROWS( batch.finish(), UserException );
+            ASSERT_EQUALS( 1, nsdetails( _ns )->getCompletedIndexCount() );
+            ASSERT_EQUALS( 1, nsdetails( _ns )->getTotalIndexCount() );
+            ASSERT_EQUALS( 0U, _client.count( "unittests.system.indexes",
+                                              BSON( "ns" << _ns << "name" << NE << "_id_" ) ) );
+        }
+    };
+
+    /** The indexes of an IndexBuildBatch which is never finished are rolled back. */
+    class UnfinishedIndexBuildBatch : public IndexBuildBase {
+    public:
+        void run() {
+            {
+                IndexBuildBatch batch;
+                BSONObj aInfo = BSON( "key" << BSON( "a" << 1 ) << "ns" << _ns <<
+                                      "name" << "a_1" );
+                theDataFileMgr.insertWithObjMod( "unittests.system.indexes", aInfo, false );
+                ASSERT_EQUALS( 2, nsdetails( _ns )->getTotalIndexCount() );
+            }
+            ASSERT_EQUALS( 1, nsdetails( _ns )->getTotalIndexCount() );
+            ASSERT_EQUALS( 0U, _client.count( "unittests.system.indexes",
+                                              BSON( "ns" << _ns << "name" << "a_1" ) ) );
+        }
+    };
+
     /**
      * Fixture class that has a basic compound index.
      */
@@ -750,6 +818,9 @@ namespace IndexUpdateTests {
             add<DirectClientEnsureIndexInterruptDisallowed>();
             add<HelpersEnsureIndexInterruptDisallowed>();
             add<IndexBuildInProgressTest>();
+            add<BuildIndexesInBatch>();
+            add<BuildIndexesInBatchFailure>();
+            add<UnfinishedIndexBuildBatch>();
             add<SameSpecDifferentOption>();
             add<SameSpecSameOptions>();
             add<DifferentSpecSameName>();
@@ -631,6 +631,45 @@ namespace IntervalBtreeCursorTests {
         }
     };
 
+    /** Keys following the current key in its bucket are passed and counted in bulk. */
+    class SkipKeysInBucket {
+    public:
+        void run() {
+            Client::WriteContext ctx( _ns );
+            _client.dropCollection( _ns );
+            for( int32_t i = 0; i < 10; ++i ) {
+                _client.insert( _ns, BSON( "a" << i ) );
+            }
+            _client.ensureIndex( _ns, BSON( "a" << 1 ) );
+
+            // Mark the key at position 4 as unused.
+            nsdetails( _ns )->idx( 1 ).head.btreemod<V1>()->_k( 4 ).setUnused();
+
+            scoped_ptr<IntervalBtreeCursor> cursor(
+                    IntervalBtreeCursor::make( nsdetails( _ns ),
+                                               nsdetails( _ns )->idx( 1 ),
+                                               BSON( "" << 2 ),
+                                               true,
+                                               BSON( "" << 8 ),
+                                               false ) );
+            ASSERT_EQUALS( 2, cursor->current()[ "a" ].Int() );
+            ASSERT_EQUALS( 0, cursor->skipKeysInBucket( 0 ) );
+
+            // The unused key is passed but not counted.
+            ASSERT_EQUALS( 2, cursor->skipKeysInBucket( 2 ) );
+            ASSERT_EQUALS( 5, cursor->current()[ "a" ].Int() );
+            ASSERT_EQUALS( 3, cursor->nscanned() );
+
+            // Passing stops before the end location.
+            ASSERT_EQUALS( 2, cursor->skipKeysInBucket( 100 ) );
+            ASSERT_EQUALS( 7, cursor->current()[ "a" ].Int() );
+            ASSERT_EQUALS( 5, cursor->nscanned() );
+            ASSERT_EQUALS( 0, cursor->skipKeysInBucket( 100 ) );
+            ASSERT( !cursor->advance() );
+            ASSERT_EQUALS( 0, cursor->skipKeysInBucket( 100 ) );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "intervalbtreecursor" ) {
@@ -654,6 +693,7 @@ namespace IntervalBtreeCursorTests {
             add<UnusedKeys>();
             add<UnusedEndKey>();
             add<KeyBecomesUnusedDuringYield>();
+            add<SkipKeysInBucket>();
         }
     } myall;
 
@@ -106,11 +106,69 @@ namespace MMapTests {
         }
     };
 
+    /** only the written regions of the private view are remapped, a budget's worth at a time */
+    class RemapWrittenRegionsTest {
+        const string fn;
+        const int optOld;
+    public:
+        RemapWrittenRegionsTest() :
+            fn((boost::filesystem::path(storageGlobalParams.dbpath) / "testfile.map").string()),
+               optOld(storageGlobalParams.durOptions)
+        {
+            storageGlobalParams.durOptions = 0; // we write the private view without write intents
+        }
+        ~RemapWrittenRegionsTest() {
+            storageGlobalParams.durOptions = optOld;
+            try { boost::filesystem::remove(fn); }
+            catch(...) { }
+        }
+        void run() {
+            if (!storageGlobalParams.dur)
+                return;
+
+            try { boost::filesystem::remove(fn); }
+            catch(...) { }
+
+            Lock::GlobalWrite lk;
+
+            const unsigned chunk = DurableMappedFile::RemapChunkSize;
+            DurableMappedFile f;
+            unsigned long long len = 4 * chunk;
+            verify( f.create(fn, len, /*sequential*/false) );
+            char *p = (char *) f.getView();
+            ASSERT( !f.willNeedRemap() );
+
+            MemoryMappedFile::makeWritable(p, 1);
+            p[0] = 'a';
+            MemoryMappedFile::makeWritable(p + 2 * chunk, 1);
+            p[2 * chunk] = 'c';
+            f.noteWritten(0, 1);
+            f.noteWritten(2 * chunk, 1);
+            f.noteWritten(2 * chunk, 1);
+            ASSERT_EQUALS( 2U, f.writtenChunks() );
+
+            ASSERT_EQUALS( 1U, f.remapThePrivateView(1) );
+            ASSERT_EQUALS( 1U, f.writtenChunks() );
+            ASSERT( f.willNeedRemap() );
+            // the remapped region shows the file again, the other keeps its private copy
+            ASSERT_EQUALS( 0, p[0] );
+            ASSERT_EQUALS( 'c', p[2 * chunk] );
+
+            ASSERT_EQUALS( 1U, f.remapThePrivateView(10) );
+            ASSERT( !f.willNeedRemap() );
+            ASSERT_EQUALS( 0, p[2 * chunk] );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "mmap" ) {}
         void setupTests() {
             add< LeakTest >();
+#if !defined(_WIN32) && !defined(__sunos__)
+            // those remap the whole private view
+            add< RemapWrittenRegionsTest >();
+#endif
         }
     } myall;
 
@@ -946,6 +946,33 @@ namespace NamespaceTests {
             BSONObj key() const { return BSON( "a.0.b.0" << 1 ); }
         };
         
+        /** A large array with repeated values generates one key per distinct value. */
+        class LargeArrayWithDuplicates : public Base {
+        public:
+            void run() {
+                create();
+
+                BSONArrayBuilder a;
+                for ( int i = 500; i > 0; --i ) {
+                    a.append( i % 50 );
+                }
+                BSONObjSet keys;
+                getKeysFromObject( BSON( "a" << a.arr() ), keys );
+                checkSize( 50, keys );
+                int expected = 0;
+                for ( BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i ) {
+                    assertEquals( BSON( "" << expected++ ), *i );
+                }
+
+                // the key buffer is reused for the next document
+                keys.clear();
+                getKeysFromObject( BSON( "a" << BSON_ARRAY( 7 << 3 << 7 ) ), keys );
+                checkSize( 2, keys );
+                assertEquals( BSON( "" << 3 ), *keys.begin() );
+                assertEquals( BSON( "" << 7 ), *keys.rbegin() );
+            }
+        };
+
         // also test numeric string field names
         
     } // namespace IndexDetailsTests
@@ -2361,6 +2388,7 @@ namespace NamespaceTests {
             add< IndexDetailsTests::DoubleIndexedArrayIndex >();
             add< IndexDetailsTests::ObjectWithinArray >();
             add< IndexDetailsTests::ArrayWithinObjectWithinArray >();
+            add< IndexDetailsTests::LargeArrayWithDuplicates >();
             add< IndexDetailsTests::MissingField >();
             add< IndexDetailsTests::SubobjectMissing >();
             add< IndexDetailsTests::CompoundMissing >();
@@ -30,10 +30,14 @@
 
 #include "mongo/db/db.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/extsort.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/key.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/document.h"
 #include "mongo/db/taskqueue.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
@@ -219,6 +223,21 @@ namespace PerfTests {
                 cout << dur::stats.curr->_asCSV();
             cout << endl;
 
+            if( !frameworkGlobalParams.perfJson.empty() ) {
+                // test names are the stable keys for comparing runs across builds
+                static std::ofstream perfJson( frameworkGlobalParams.perfJson.c_str(),
+                                               std::ios::app );
+                bob b;
+                b.append("test", s);
+                b.append("rps", (long long) rps);
+                b.append("n", (long long) n);
+                b.append("millis", ms);
+                b.appendBool("dur", storageGlobalParams.dur);
+                b.appendBool("debug", DEBUG_BUILD);
+                b.append("git", gitVersion());
+                perfJson << b.obj().jsonString() << endl;
+            }
+
             if( conn && !conn->isFailed() ) {
                 const char *ns = "perf.pstats";
                 if(frameworkGlobalParams.perfHist) {
@@ -473,6 +492,84 @@ namespace PerfTests {
         }
     };
 
+    class DocumentFromBson : public NonDurTest {
+        BSONObj _o;
+    public:
+        DocumentFromBson() {
+            BSONObjBuilder b;
+            for( int i = 0; i < 20; i++ )
+                b.append( "f" + BSONObjBuilder::numStr( i ), i );
+            _o = b.obj();
+        }
+        string name() { return "Document-from-bson"; }
+        void timed() {
+            Document d( _o );
+            dontOptimizeOutHopefully += d["f19"].getInt();
+        }
+    };
+
+    class MatchExpressionEval : public NonDurTest {
+        scoped_ptr<MatchExpression> _expr;
+        BSONObj _doc;
+    public:
+        MatchExpressionEval() : _doc( BSON( "a" << 7 << "b" << "x" << "c" << BSON_ARRAY( 1 << 2 << 3 ) ) ) {
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse( BSON( "a" << GT << 5 << "b" << "x" << "c" << 3 ) );
+            verify( swme.isOK() );
+            _expr.reset( swme.getValue() );
+        }
+        string name() { return "MatchExpression-matchesBSON"; }
+        void timed() {
+            verify( _expr->matchesBSON( _doc ) );
+        }
+    };
+
+    class WorkingSetChurn : public NonDurTest {
+        WorkingSet _ws;
+        BSONObj _o;
+    public:
+        WorkingSetChurn() : _o( BSON( "x" << 1 ) ) { }
+        string name() { return "WorkingSet-allocate-free"; }
+        void timed() {
+            WorkingSetID ids[16];
+            for( int i = 0; i < 16; i++ ) {
+                ids[i] = _ws.allocate();
+                WorkingSetMember* member = _ws.get( ids[i] );
+                member->obj = _o;
+                member->state = WorkingSetMember::OWNED_OBJ;
+            }
+            for( int i = 0; i < 16; i++ )
+                _ws.free( ids[i] );
+        }
+    };
+
+    /** sorts 10000 single field keys in memory, as an index build does */
+    class SorterThroughput : public NonDurTest {
+        class Cmp : public ExternalSortComparison {
+        public:
+            virtual int compare(const ExternalSortDatum& l, const ExternalSortDatum& r) const {
+                return l.first.woCompare( r.first );
+            }
+        };
+    public:
+        virtual unsigned batchSize() { return 1; }
+        string name() { return "Sorter-10k-keys"; }
+        void timed() {
+            Cmp cmp;
+            BSONObjExternalSorter sorter( &cmp );
+            for( int i = 0; i < 10000; i++ )
+                sorter.add( BSON( "" << rand() ), DiskLoc( 0, i ), false );
+            sorter.sort( false );
+            auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
+            int n = 0;
+            while( i->more() ) {
+                i->next();
+                n++;
+            }
+            verify( n == 10000 );
+        }
+    };
+
     class KeyTest : public B {
     public:
         KeyV1Owned a,b,c;
@@ -490,6 +587,24 @@ namespace PerfTests {
         }
     };
 
+    class KeyCompare : public B {
+    public:
+        KeyV1Owned a,b;
+        Ordering o;
+        string name() { return "Key-woCompare"; }
+        virtual int howLongMillis() { return 3000; }
+        KeyCompare() :
+          a(BSON("a"<<1<<"b"<<3.0<<"c"<<"qqq")),
+          b(BSON("a"<<1<<"b"<<3.0<<"c"<<"qqqb")),
+          o(Ordering::make(BSON("a"<<1<<"b"<<-1<<"c"<<1)))
+          {}
+        virtual bool showDurStats() { return false; }
+        void timed() {
+            verify( a.woCompare(b, o) < 0 );
+            verify( b.woCompare(a, o) > 0 );
+        }
+    };
+
     unsigned long long aaa;
 
     class Timer : public B {
@@ -1124,6 +1239,41 @@ namespace PerfTests {
         }
     };
 
+    /** 100 key range scans, and single key finds, over an index of 10000 keys */
+    class BtreeScan : public B {
+    public:
+        virtual int howLongMillis() { return 3000; }
+        string name() { return "btree-range-scan"; }
+        void prep() {
+            for( int i = 0; i < 10000; i++ )
+                client().insert( ns(), BSON( "x" << i ) );
+            client().ensureIndex( ns(), BSON( "x" << 1 ) );
+        }
+        void timed() {
+            int x = rand() % 9900;
+            auto_ptr<DBClientCursor> c =
+                client().query( ns(), QUERY( "x" << GTE << x << LT << x + 100 ), 0, 0, 0, 0, 100 );
+            verify( c->itcount() == 100 );
+        }
+        string name2() { return "btree-find"; }
+        void timed2(DBClientBase& c) {
+            c.findOne( ns(), QUERY( "x" << rand() % 10000 ) );
+        }
+    };
+
+    /** a small write followed by a group commit of the journal */
+    class DurCommit : public B {
+    public:
+        virtual int howLongMillis() { return 3000; }
+        virtual unsigned batchSize() { return 1; }
+        string name() { return "dur-commit"; }
+        void timed() {
+            client().insert( ns(), BSON( "x" << 1 ) );
+            Lock::GlobalWrite lk;
+            getDur().commitNow();
+        }
+    };
+
     template <typename T>
     class MoreIndexes : public T {
     public:
@@ -1389,11 +1539,16 @@ namespace PerfTests {
                 add< CTM >();
                 add< CTMicros >();
                 add< KeyTest >();
+                add< KeyCompare >();
                 add< Bldr >();
                 add< StkBldr >();
                 add< BSONIter >();
                 add< BSONGetFields1 >();
                 add< BSONGetFields2 >();
+                add< DocumentFromBson >();
+                add< MatchExpressionEval >();
+                add< WorkingSetChurn >();
+                add< SorterThroughput >();
                 //add< TaskQueueTest >();
                 add< InsertDup >();
                 add< Insert1 >();
@@ -1402,6 +1557,8 @@ namespace PerfTests {
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
                 add< InsertBig >();
+                add< BtreeScan >();
+                add< DurCommit >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
                 add< FailPointTest<true, true> >();
@@ -14,15 +14,18 @@
  *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/sort.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/query/multi_plan_runner.h"
+#include "mongo/db/query/type_explain.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryMultiPlanRunner {
@@ -125,6 +128,175 @@ namespace QueryMultiPlanRunner {
             }
 
             ASSERT_EQUALS(results, N / 10);
+
+            // Both candidates are explained with the stats of their stages from the competition.
+            TypeExplain* rawExplain = NULL;
+            ASSERT_OK(mpr.getExplainPlan(&rawExplain));
+            scoped_ptr<TypeExplain> explain(rawExplain);
+            ASSERT_EQUALS(size_t(2), explain->sizeAllPlans());
+
+            BSONObj winner = explain->getAllPlansAt(0)->getStats();
+            ASSERT_EQUALS("FETCH", winner["type"].String());
+            ASSERT_EQUALS("IXSCAN", winner["children"].Array()[0]["type"].String());
+            ASSERT_LESS_THAN(winner["advanced"].numberLong(), N / 10);
+
+            BSONObj loser = explain->getAllPlansAt(1)->getStats();
+            ASSERT_EQUALS("COLLSCAN", loser["type"].String());
+            ASSERT_GREATER_THAN(loser["works"].numberLong(), 0);
+
+            // The chosen plan's own stats cover its whole run.
+            ASSERT_EQUALS(N / 10, explain->getStats()["advanced"].numberLong());
+        }
+    };
+
+    // A blocking sort over a selective index scan vs. an index scan that provides the sort but
+    // filters out most of what it scans.  The sort plan returns nothing during the trial but
+    // should still win.
+    class MPRBlockingSortVsUnselectiveSortedScan : public MultiPlanRunnerBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            const int N = 5000;
+            for (int i = 0; i < N; ++i) {
+                insert(BSON("foo" << (i % 10) << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            BSONObj filterObj = BSON("foo" << 7);
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filter(swme.getValue());
+
+            // Plan 0: IXScan over all of bar, fetch and filter by foo == 7.  One in ten
+            // documents match.
+            IndexScanParams ixparams;
+            ixparams.descriptor = getIndex(BSON("bar" << 1));
+            ixparams.bounds.isSimpleRange = true;
+            ixparams.bounds.startKey = BSON("" << MINKEY);
+            ixparams.bounds.endKey = BSON("" << MAXKEY);
+            ixparams.bounds.endKeyInclusive = true;
+            ixparams.direction = 1;
+            auto_ptr<WorkingSet> firstWs(new WorkingSet());
+            IndexScan* barScan = new IndexScan(ixparams, firstWs.get(), NULL);
+            auto_ptr<PlanStage> firstRoot(new FetchStage(firstWs.get(), barScan, filter.get()));
+
+            // Plan 1: IXScan over foo == 7, fetch, and sort the top 10 by bar.  More than a
+            // trial's worth of documents match, so the sort doesn't finish during the trial.
+            ixparams.descriptor = getIndex(BSON("foo" << 1));
+            ixparams.bounds.startKey = BSON("" << 7);
+            ixparams.bounds.endKey = BSON("" << 7);
+            auto_ptr<WorkingSet> secondWs(new WorkingSet());
+            IndexScan* fooScan = new IndexScan(ixparams, secondWs.get(), NULL);
+            FetchStage* fetch = new FetchStage(secondWs.get(), fooScan, NULL);
+            SortStageParams sortParams;
+            sortParams.pattern = BSON("bar" << 1);
+            sortParams.limit = 10;
+            auto_ptr<PlanStage> secondRoot(new SortStage(sortParams, secondWs.get(), fetch));
+
+            CanonicalQuery* cq = NULL;
+            verify(CanonicalQuery::canonicalize(ns(), filterObj, BSON("bar" << 1), BSONObj(),
+                                                &cq).isOK());
+            verify(NULL != cq);
+            MultiPlanRunner mpr(cq);
+            mpr.addPlan(new QuerySolution(), firstRoot.release(), firstWs.release());
+            mpr.addPlan(new QuerySolution(), secondRoot.release(), secondWs.release());
+
+            size_t best;
+            ASSERT(mpr.pickBestPlan(&best));
+            ASSERT_EQUALS(size_t(1), best);
+
+            // The top 10 by bar: 7, 17, 27, ...
+            int results = 0;
+            BSONObj obj;
+            while (Runner::RUNNER_ADVANCED == mpr.getNext(&obj, NULL)) {
+                ASSERT_EQUALS(obj["bar"].numberInt(), 10 * results + 7);
+                ++results;
+            }
+            ASSERT_EQUALS(results, 10);
+        }
+    };
+
+    // An index intersection that wins the trial but later runs out of room for its first child.
+    // The runner falls back on the best plan without an AND_HASH.
+    class MPRAndHashFailsAfterTrial : public MultiPlanRunnerBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            const int N = 5000;
+            for (int i = 0; i < N; ++i) {
+                insert(BSON("foo" << (i % 10) << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            BSONObj filterObj = BSON("foo" << 7 << "bar" << GTE << 4000);
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filter(swme.getValue());
+
+            // Plan 0: AND_HASH of foo == 7 and bar >= 4000.  Its table has room for more than a
+            // trial's worth of the 500 foo == 7 entries, but not for all of them.
+            auto_ptr<WorkingSet> firstWs(new WorkingSet());
+            size_t memLimit = 250 * (sizeof(WorkingSetMember) + sizeof(IndexKeyDatum) + 64);
+            AndHashStage* ah = new AndHashStage(firstWs.get(), NULL, memLimit);
+
+            IndexScanParams ixparams;
+            ixparams.descriptor = getIndex(BSON("foo" << 1));
+            ixparams.bounds.isSimpleRange = true;
+            ixparams.bounds.startKey = BSON("" << 7);
+            ixparams.bounds.endKey = BSON("" << 7);
+            ixparams.bounds.endKeyInclusive = true;
+            ixparams.direction = 1;
+            ah->addChild(new IndexScan(ixparams, firstWs.get(), NULL));
+
+            ixparams.descriptor = getIndex(BSON("bar" << 1));
+            ixparams.bounds.startKey = BSON("" << 4000);
+            ixparams.bounds.endKey = BSON("" << MAXKEY);
+            ah->addChild(new IndexScan(ixparams, firstWs.get(), NULL));
+            auto_ptr<PlanStage> firstRoot(new FetchStage(firstWs.get(), ah, NULL));
+
+            // Plan 1: IXScan over foo == 7, fetch and filter by bar >= 4000.  Its first matches
+            // come after the trial, so it doesn't beat the intersection.
+            ixparams.descriptor = getIndex(BSON("foo" << 1));
+            ixparams.bounds.startKey = BSON("" << 7);
+            ixparams.bounds.endKey = BSON("" << 7);
+            auto_ptr<WorkingSet> secondWs(new WorkingSet());
+            IndexScan* fooScan = new IndexScan(ixparams, secondWs.get(), NULL);
+            auto_ptr<PlanStage> secondRoot(new FetchStage(secondWs.get(), fooScan, filter.get()));
+
+            CanonicalQuery* cq = NULL;
+            verify(CanonicalQuery::canonicalize(ns(), filterObj, &cq).isOK());
+            verify(NULL != cq);
+            MultiPlanRunner mpr(cq);
+            mpr.addPlan(new QuerySolution(), firstRoot.release(), firstWs.release());
+            mpr.addPlan(new QuerySolution(), secondRoot.release(), secondWs.release());
+
+            size_t best;
+            ASSERT(mpr.pickBestPlan(&best));
+            ASSERT_EQUALS(size_t(0), best);
+
+            // Every result comes from the backup plan: bar is 4007, 4017, ...
+            int results = 0;
+            BSONObj obj;
+            Runner::RunnerState state;
+            while (Runner::RUNNER_ADVANCED == (state = mpr.getNext(&obj, NULL))) {
+                ASSERT_EQUALS(obj["bar"].numberInt(), 4000 + 10 * results + 7);
+                ++results;
+            }
+            ASSERT_EQUALS(Runner::RUNNER_EOF, state);
+            ASSERT_EQUALS(results, (N - 4000) / 10);
+
+            TypeExplain* rawExplain = NULL;
+            ASSERT_OK(mpr.getExplainPlan(&rawExplain));
+            scoped_ptr<TypeExplain> explain(rawExplain);
+            ASSERT_EQUALS("FETCH", explain->getAllPlansAt(0)->getStats()["type"].String());
+            ASSERT_EQUALS("IXSCAN",
+                explain->getAllPlansAt(0)->getStats()["children"].Array()[0]["type"].String());
         }
     };
 
@@ -134,6 +306,8 @@ namespace QueryMultiPlanRunner {
 
         void setupTests() {
             add<MPRCollectionScanVsHighlySelectiveIXScan>();
+            add<MPRBlockingSortVsUnselectiveSortedScan>();
+            add<MPRAndHashFailsAfterTrial>();
         }
     }  queryMultiPlanRunnerAll;
 
@@ -26,6 +26,7 @@
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
@@ -356,6 +357,75 @@ namespace QueryStageAnd {
         }
     };
 
+    // An AND whose first child produces more than the hash table can hold fails.
+    class QueryStageAndHashMemLimit : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            // Room for a few, but not all, of the 21 members read from the first child.
+            WorkingSet ws;
+            size_t memLimit = 5 * (sizeof(WorkingSetMember) + sizeof(IndexKeyDatum) + 64);
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, memLimit));
+
+            // Foo <= 20
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1));
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 20);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            // Bar >= 10
+            params.descriptor = getIndex(BSON("bar" << 1));
+            params.bounds.startKey = BSON("" << 10);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            int works = 0;
+            PlanStage::StageState status = PlanStage::NEED_TIME;
+            while (PlanStage::NEED_TIME == status) {
+                WorkingSetID id;
+                status = ah->work(&id);
+                ++works;
+            }
+            ASSERT_EQUALS(PlanStage::FAILURE, status);
+            ASSERT_LESS_THAN(works, 21);
+            ASSERT_TRUE(ah->isEOF());
+
+            scoped_ptr<PlanStageStats> stats(ah->getStats());
+            const AndHashStats* spec = static_cast<const AndHashStats*>(stats->specific.get());
+            ASSERT_EQUALS(memLimit, spec->memLimit);
+            ASSERT_GREATER_THAN(spec->memUsage, memLimit);
+
+            // The same AND with the default limit has plenty of room.
+            WorkingSet ws2;
+            scoped_ptr<AndHashStage> ah2(new AndHashStage(&ws2, NULL));
+            params.descriptor = getIndex(BSON("foo" << 1));
+            params.bounds.startKey = BSON("" << 20);
+            params.direction = -1;
+            ah2->addChild(new IndexScan(params, &ws2, NULL));
+            params.descriptor = getIndex(BSON("bar" << 1));
+            params.bounds.startKey = BSON("" << 10);
+            params.direction = 1;
+            ah2->addChild(new IndexScan(params, &ws2, NULL));
+
+            // foo == 10, foo == 11, ..., foo == 20.
+            ASSERT_EQUALS(11, countResults(ah2.get()));
+        }
+    };
+
     //
     // Sorted AND tests
     //
@@ -650,6 +720,7 @@ namespace QueryStageAnd {
             add<QueryStageAndHashWithNothing>();
             add<QueryStageAndHashProducesNothing>();
             add<QueryStageAndHashWithMatcher>();
+            add<QueryStageAndHashMemLimit>();
             add<QueryStageAndSortedInvalidation>();
             add<QueryStageAndSortedThreeLeaf>();
             add<QueryStageAndSortedWithNothing>();
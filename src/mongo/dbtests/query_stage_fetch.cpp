@@ -381,6 +381,72 @@ namespace QueryStageFetch {
         }
     };
 
+    //
+    // Test that a batch waits on a page-in, and that the rest of the batch survives invalidation
+    // while it waits.
+    //
+    class FetchStageBatch : public QueryStageFetchBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            WorkingSet ws;
+
+            for (int i = 0; i < 3; ++i) {
+                insert(BSON("foo" << i));
+            }
+            set<DiskLoc> locs;
+            getLocs(&locs);
+            ASSERT_EQUALS(size_t(3), locs.size());
+
+            auto_ptr<MockStage> mockStage(new MockStage(&ws));
+            for (set<DiskLoc>::iterator it = locs.begin(); it != locs.end(); ++it) {
+                WorkingSetMember mockMember;
+                mockMember.state = WorkingSetMember::LOC_AND_IDX;
+                mockMember.loc = *it;
+                mockStage->pushBack(mockMember);
+            }
+
+            auto_ptr<FetchStage> fetchStage(new FetchStage(&ws, mockStage.release(), NULL));
+
+            // Nothing is in memory.
+            FailPointRegistry* reg = getGlobalFailPointRegistry();
+            FailPoint* fetchInMemoryFail = reg->getFailPoint("fetchInMemoryFail");
+            fetchInMemoryFail->setMode(FailPoint::alwaysOn);
+
+            // The batch stops at the first member, which must be paged in.
+            vector<WorkingSetID> ids;
+            WorkingSetID fetchId;
+            ASSERT_EQUALS(PlanStage::NEED_FETCH, fetchStage->workBatch(10, &ids, &fetchId));
+            ASSERT_EQUALS(size_t(0), ids.size());
+            ASSERT_EQUALS(*locs.begin(), ws.get(fetchId)->loc);
+
+            // The last member is waiting in the fetch stage.  Invalidating it forces a fetch.
+            fetchStage->prepareToYield();
+            fetchStage->invalidate(*locs.rbegin());
+            fetchStage->recoverFromYield();
+
+            int numFetches = 1;
+            while (!fetchStage->isEOF()) {
+                PlanStage::StageState state = fetchStage->workBatch(10, &ids, &fetchId);
+                if (PlanStage::NEED_FETCH == state) {
+                    ++numFetches;
+                }
+            }
+
+            // The second member needed its own page-in but the invalidated one didn't.
+            ASSERT_EQUALS(2, numFetches);
+            ASSERT_EQUALS(size_t(3), ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                WorkingSetMember* member = ws.get(ids[i]);
+                ASSERT_TRUE(member->hasObj());
+                ASSERT_EQUALS(static_cast<int>(i), member->obj["foo"].numberInt());
+            }
+            ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, ws.get(ids[2])->state);
+
+            fetchInMemoryFail->setMode(FailPoint::off);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_fetch" ) { }
@@ -391,6 +457,7 @@ namespace QueryStageFetch {
             add<FetchStageAlreadyFetched>();
             add<FetchStageInvalidation>();
             add<FetchStageFilter>();
+            add<FetchStageBatch>();
         }
     }  queryStageFetchAll;
 
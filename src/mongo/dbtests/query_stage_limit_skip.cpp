@@ -62,6 +62,18 @@ namespace {
         return count;
     }
 
+    int countBatchResults(PlanStage* stage, size_t batchSize) {
+        int count = 0;
+        while (!stage->isEOF()) {
+            vector<WorkingSetID> ids;
+            WorkingSetID fetchId;
+            stage->workBatch(batchSize, &ids, &fetchId);
+            ASSERT_LESS_THAN_OR_EQUALS(ids.size(), batchSize);
+            count += ids.size();
+        }
+        return count;
+    }
+
     //
     // Insert 50 objects.  Filter/skip 0, 1, 2, ..., 100 objects and expect the right # of results.
     //
@@ -80,12 +92,75 @@ namespace {
         }
     };
 
+    //
+    // The same, batch by batch, including a skip over a limit.
+    //
+    class QueryStageLimitSkipBatchTest {
+    public:
+        void run() {
+            for (size_t batchSize = 1; batchSize < 8; ++batchSize) {
+                for (int i = 0; i < 2 * N; ++i) {
+                    WorkingSet ws;
+
+                    scoped_ptr<PlanStage> skip(new SkipStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(max(0, N - i), countBatchResults(skip.get(), batchSize));
+
+                    scoped_ptr<PlanStage> limit(new LimitStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(min(N, i), countBatchResults(limit.get(), batchSize));
+
+                    scoped_ptr<PlanStage> both(new SkipStage(i / 2, &ws,
+                                                             new LimitStage(i, &ws, getMS(&ws))));
+                    ASSERT_EQUALS(min(N, i) - min(N, i / 2),
+                                  countBatchResults(both.get(), batchSize));
+                }
+            }
+        }
+    };
+
+    //
+    // A batch counts one work per result that passes through, as single calls to work() would.
+    //
+    class QueryStageLimitSkipBatchWorks {
+    public:
+        void run() {
+            const int numResults = 10;
+            WorkingSet ws;
+
+            // Nothing but results, so every unit of work produces one.
+            auto_ptr<MockStage> limitMs(getAdvancingMS(&ws, numResults));
+            scoped_ptr<PlanStage> limit(new LimitStage(numResults, &ws, limitMs.release()));
+            ASSERT_EQUALS(numResults, countBatchResults(limit.get(), 5));
+            scoped_ptr<PlanStageStats> limitStats(limit->getStats());
+            ASSERT_EQUALS(uint64_t(numResults), limitStats->common.works);
+
+            // Skipped results were looked at too.
+            auto_ptr<MockStage> skipMs(getAdvancingMS(&ws, numResults));
+            scoped_ptr<PlanStage> skip(new SkipStage(3, &ws, skipMs.release()));
+            ASSERT_EQUALS(numResults - 3, countBatchResults(skip.get(), 5));
+            scoped_ptr<PlanStageStats> skipStats(skip->getStats());
+            ASSERT_EQUALS(uint64_t(numResults), skipStats->common.works);
+        }
+
+        static MockStage* getAdvancingMS(WorkingSet* ws, int numResults) {
+            auto_ptr<MockStage> ms(new MockStage(ws));
+            for (int i = 0; i < numResults; ++i) {
+                WorkingSetMember wsm;
+                wsm.state = WorkingSetMember::OWNED_OBJ;
+                wsm.obj = BSON("x" << i);
+                ms->pushBack(wsm);
+            }
+            return ms.release();
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_limit_skip" ) { }
 
         void setupTests() {
             add<QueryStageLimitSkipBasicTest>();
+            add<QueryStageLimitSkipBatchTest>();
+            add<QueryStageLimitSkipBatchWorks>();
         }
     }  queryStageLimitSkipAll;
 
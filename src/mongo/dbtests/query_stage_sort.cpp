@@ -41,6 +41,14 @@ namespace QueryStageSortTests {
             }
         }
 
+        // Fill out numObj objects of about 'size' bytes each.
+        void fillBigData(int size) {
+            const string pad(size, 'x');
+            for (int i = 0; i < numObj(); ++i) {
+                insert(BSON("foo" << i << "pad" << pad));
+            }
+        }
+
         virtual ~QueryStageSortTestBase() {
             _client.dropCollection(ns());
         }
@@ -110,8 +118,10 @@ namespace QueryStageSortTests {
          * Fill out numObj objects, sort them in the order provided by 'direction'.
          * If extAllowed is true, sorting will use use external sorting if available.
          * If limit is not zero, we limit the output of the sort stage to 'limit' results.
+         *
+         * Returns the number of files the sort spilled to disk.
          */
-        void sortAndCheck(int direction) {
+        uint64_t sortAndCheck(int direction, bool extAllowed = false, int limit = 0) {
             WorkingSet* ws = new WorkingSet();
             MockStage* ms = new MockStage(ws);
 
@@ -120,9 +130,12 @@ namespace QueryStageSortTests {
 
             SortStageParams params;
             params.pattern = BSON("foo" << direction);
+            params.allowExternalSort = extAllowed;
+            params.limit = limit;
 
             // Must fetch so we can look at the doc as a BSONObj.
-            PlanExecutor runner(ws, new FetchStage(ws, new SortStage(params, ws, ms), NULL));
+            SortStage* ss = new SortStage(params, ws, ms);
+            PlanExecutor runner(ws, new FetchStage(ws, ss, NULL));
 
             // Look at pairs of objects to make sure that the sort order is pairwise (and therefore
             // totally) correct.
@@ -142,8 +155,17 @@ namespace QueryStageSortTests {
                 last = current;
             }
 
-            // No limit, should get all objects back.
-            ASSERT_EQUALS(numObj(), count);
+            // With no limit we should get all objects back.
+            ASSERT_EQUALS(0 == limit ? numObj() : std::min(limit, numObj()), count);
+
+            // The best 'limit' objects are at the front of the sort order.
+            if (0 != limit && limit < numObj()) {
+                int lastWanted = 1 == direction ? limit - 1 : numObj() - limit;
+                ASSERT_EQUALS(lastWanted, last["foo"].numberInt());
+            }
+
+            scoped_ptr<PlanStageStats> stats(ss->getStats());
+            return static_cast<SortStats*>(stats->specific.get())->spilledFiles;
         }
 
         virtual int numObj() = 0;
@@ -191,11 +213,89 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Keep only the top results of an increasing sort.
+    class QueryStageSortLimitInc : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 1000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(1, false, 10);
+        }
+    };
+
+    // Keep only the top results of a decreasing sort.
+    class QueryStageSortLimitDec : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 1000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(-1, false, 10);
+        }
+    };
+
+    // A limit larger than the input returns everything.
+    class QueryStageSortLimitLarge : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 100; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(1, false, 1000);
+        }
+    };
+
+    // Sort more than fits in memory, spilling to disk.
+    class QueryStageSortSpill : public QueryStageSortTestBase {
+    public:
+        // Two thirds of these are fed to the sort as objects, which is past its 32MB of memory.
+        virtual int numObj() { return 4000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillBigData(16 * 1024);
+            ASSERT_GREATER_THAN(sortAndCheck(1, true), 0U);
+        }
+    };
+
+    // Too big to sort without spilling to disk.
+    class QueryStageSortNoSpill : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 4000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillBigData(16 * 1024);
+
+            WorkingSet ws;
+            MockStage* ms = new MockStage(&ws);
+            insertVarietyOfObjects(ms);
+
+            SortStageParams params;
+            params.pattern = BSON("foo" << 1);
+            SortStage ss(params, &ws, ms);
+
+            PlanStage::StageState status = PlanStage::NEED_TIME;
+            while (PlanStage::NEED_TIME == status) {
+                WorkingSetID id;
+                status = ss.work(&id);
+            }
+            ASSERT_EQUALS(PlanStage::FAILURE, status);
+        }
+    };
+
     // Invalidation of everything fed to sort.
     class QueryStageSortInvalidation : public QueryStageSortTestBase {
     public:
         virtual int numObj() { return 2000; }
 
+        // Whether the sort is handed to a Sorter, which can't reach its members on invalidation.
+        virtual bool extAllowed() { return false; }
+
         void run() {
             Client::WriteContext ctx(ns());
             fillData();
@@ -211,6 +311,7 @@ namespace QueryStageSortTests {
 
             SortStageParams params;
             params.pattern = BSON("foo" << 1);
+            params.allowExternalSort = extAllowed();
             auto_ptr<SortStage> ss(new SortStage(params, &ws, ms.get()));
 
             const int firstRead = 10;
@@ -260,6 +361,61 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Invalidation of everything fed to an external sort.
+    class QueryStageSortInvalidationExt : public QueryStageSortInvalidation {
+    public:
+        virtual bool extAllowed() { return true; }
+    };
+
+    // A missing sort field sorts as null, whether the sort is done in the WorkingSet or by a
+    // Sorter.
+    class QueryStageSortMissingField {
+    public:
+        virtual ~QueryStageSortMissingField() { }
+
+        virtual bool extAllowed() { return false; }
+
+        void run() {
+            WorkingSet ws;
+            auto_ptr<MockStage> ms(new MockStage(&ws));
+
+            // Ties on 'foo' are broken by 'bar', so the missing 'foo' must equal the null one.
+            const BSONObj objs[] = { BSON("bar" << 3),
+                                     BSON("foo" << BSONNULL << "bar" << 2),
+                                     BSON("bar" << 1),
+                                     BSON("foo" << MINKEY << "bar" << 4) };
+            const int expectedBar[] = { 4, 1, 2, 3 };
+            const size_t numObjs = sizeof(objs) / sizeof(objs[0]);
+            for (size_t i = 0; i < numObjs; ++i) {
+                WorkingSetMember member;
+                member.state = WorkingSetMember::OWNED_OBJ;
+                member.obj = objs[i];
+                ms->pushBack(member);
+            }
+
+            SortStageParams params;
+            params.pattern = BSON("foo" << 1 << "bar" << 1);
+            params.allowExternalSort = extAllowed();
+            SortStage ss(params, &ws, ms.release());
+
+            size_t count = 0;
+            while (!ss.isEOF()) {
+                WorkingSetID id;
+                PlanStage::StageState status = ss.work(&id);
+                if (PlanStage::ADVANCED != status) { continue; }
+                ASSERT_LESS_THAN(count, numObjs);
+                ASSERT_EQUALS(expectedBar[count], ws.get(id)->obj["bar"].numberInt());
+                ++count;
+            }
+            ASSERT_EQUALS(numObjs, count);
+        }
+    };
+
+    class QueryStageSortMissingFieldExt : public QueryStageSortMissingField {
+    public:
+        virtual bool extAllowed() { return true; }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_sort_test" ) { }
@@ -268,7 +424,15 @@ namespace QueryStageSortTests {
             add<QueryStageSortInc>();
             add<QueryStageSortDec>();
             add<QueryStageSortExt>();
+            add<QueryStageSortLimitInc>();
+            add<QueryStageSortLimitDec>();
+            add<QueryStageSortLimitLarge>();
+            add<QueryStageSortSpill>();
+            add<QueryStageSortNoSpill>();
             add<QueryStageSortInvalidation>();
+            add<QueryStageSortInvalidationExt>();
+            add<QueryStageSortMissingField>();
+            add<QueryStageSortMissingFieldExt>();
         }
     }  queryStageSortTest;
 
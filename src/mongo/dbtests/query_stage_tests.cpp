@@ -21,7 +21,10 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/stage_builder.h"
 #include "mongo/dbtests/dbtests.h"
 
 /**
@@ -237,6 +240,121 @@ namespace QueryStageTests {
         }
     };
 
+    /**
+     * A yield that leaves the entry under the cursor alone doesn't move the scan, and one that
+     * deletes it moves the scan to the next entry without skipping it.
+     */
+    class QueryStageIXScanYield : public IndexScanBase {
+    public:
+        virtual ~QueryStageIXScanYield() { }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            // 0 <= foo <= numObj()
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1));
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 0);
+            params.bounds.endKey = BSON("" << numObj());
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+
+            WorkingSet ws;
+            scoped_ptr<IndexScan> scan(new IndexScan(params, &ws, NULL));
+
+            int count = 0;
+            while (!scan->isEOF()) {
+                WorkingSetID id;
+                PlanStage::StageState state = scan->work(&id);
+                if (PlanStage::ADVANCED != state) { continue; }
+
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(count, member->keyData[0].keyData.firstElement().numberInt());
+                ws.free(id);
+
+                // Yield after every result, deleting the document under the cursor once.
+                scan->prepareToYield();
+                if (20 == count) {
+                    DBDirectClient client;
+                    client.remove(ns(), BSON("foo" << 20));
+                }
+                scan->recoverFromYield();
+                ++count;
+            }
+
+            ASSERT_EQUALS(numObj(), count);
+            scoped_ptr<PlanStageStats> stats(scan->getStats());
+            const IndexScanStats* spec = static_cast<const IndexScanStats*>(stats->specific.get());
+            ASSERT_EQUALS(1U, spec->yieldMovedCursor);
+        }
+    };
+
+    /**
+     * {a: []} and {a: [1]} have the single keys undefined and 1 and leave the index non-multikey,
+     * so predicates with an array operand can't be answered from the key.  Every plan of a covered
+     * query must find the same documents as the matcher.
+     */
+    class QueryStageIXScanArrayOperand {
+    public:
+        ~QueryStageIXScanArrayOperand() {
+            Client::WriteContext ctx(ns());
+            _client.dropCollection(ns());
+        }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            _client.insert(ns(), fromjson("{a: []}"));
+            _client.insert(ns(), fromjson("{a: [1]}"));
+            _client.insert(ns(), fromjson("{a: 1}"));
+            _client.insert(ns(), fromjson("{a: 2}"));
+            _client.ensureIndex(ns(), BSON("a" << 1));
+
+            NamespaceDetails* nsd = nsdetails(ns());
+            int idxNo = nsd->findIndexByKeyPattern(BSON("a" << 1));
+            ASSERT(!nsd->isMultikey(idxNo));
+
+            const char* queries[] = { "{a: []}", "{a: [1]}", "{a: {$in: [[1]]}}",
+                                      "{a: {$in: [[], 2]}}", "{a: {$nin: [[1]]}}" };
+            for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+                BSONObj query = fromjson(queries[i]);
+                size_t expected = _client.count(ns(), query);
+                ASSERT_NOT_EQUALS(0U, expected);
+
+                CanonicalQuery* rawCq;
+                ASSERT(CanonicalQuery::canonicalize(ns(), query, BSONObj(),
+                                                    fromjson("{_id: 0, a: 1}"), &rawCq).isOK());
+                scoped_ptr<CanonicalQuery> cq(rawCq);
+
+                vector<IndexEntry> indices;
+                indices.push_back(IndexEntry(BSON("a" << 1), false, false));
+                vector<QuerySolution*> solns;
+                QueryPlanner::plan(*cq, indices, QueryPlanner::DEFAULT, &solns);
+                ASSERT_NOT_EQUALS(0U, solns.size());
+
+                for (size_t j = 0; j < solns.size(); ++j) {
+                    scoped_ptr<QuerySolution> soln(solns[j]);
+                    PlanStage* root;
+                    WorkingSet* ws;
+                    ASSERT(StageBuilder::build(*soln, &root, &ws));
+                    PlanExecutor runner(ws, root);
+
+                    size_t count = 0;
+                    for (BSONObj obj; Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL); ) {
+                        ++count;
+                    }
+                    ASSERT_EQUALS(expected, count);
+                }
+            }
+        }
+
+    private:
+        static const char* ns() { return "unittests.IndexScanArrayOperand"; }
+        static DBDirectClient _client;
+    };
+
+    DBDirectClient QueryStageIXScanArrayOperand::_client;
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_tests" ) { }
@@ -249,6 +367,8 @@ namespace QueryStageTests {
             add<QueryStageIXScanCantMatch>();
             add<QueryStageIXScan2dSphere>();
             add<QueryStageIXScan2d>();
+            add<QueryStageIXScanYield>();
+            add<QueryStageIXScanArrayOperand>();
         }
     }  queryStageTestsAll;
 
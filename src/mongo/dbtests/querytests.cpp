@@ -1328,6 +1328,38 @@ namespace QueryTests {
         }
     };
 
+    /**
+     * Check OplogReplay mode as the capped collection moves on to new extents, which replaces
+     * the cached index of its extents.
+     */
+    class FindingStartAfterRollover : public CollectionBase {
+    public:
+        FindingStartAfterRollover() : CollectionBase( "findingstart" ) {}
+
+        void run() {
+            BSONObj info;
+            ASSERT( client().runCommand( "unittests", BSON( "create" << "querytests.findingstart" << "capped" << true << "$nExtents" << 5 << "autoIndexId" << false ), info ) );
+
+            int i = 0;
+            for( int oldCount = -1;
+                    count() != oldCount;
+                    oldCount = count(), client().insert( ns(), BSON( "ts" << i++ ) ) );
+
+            for( int round = 0; round < 4; ++round ) {
+                // about half the collection, so it loops around to other extents
+                for( int n = count() / 2; n > 0; --n )
+                    client().insert( ns(), BSON( "ts" << i++ ) );
+
+                int min = client().query( ns(), Query().sort( BSON( "$natural" << 1 ) ) )->next()[ "ts" ].numberInt();
+                for( int j = min - 1; j < i; j += 7 ) {
+                    auto_ptr< DBClientCursor > c = client().query( ns(), QUERY( "ts" << GTE << j ), 0, 0, 0, QueryOption_OplogReplay );
+                    ASSERT( c->more() );
+                    ASSERT_EQUALS( ( j > min ? j : min ), c->next()[ "ts" ].numberInt() );
+                }
+            }
+        }
+    };
+
     class WhatsMyUri : public CollectionBase {
     public:
         WhatsMyUri() : CollectionBase( "whatsmyuri" ) {}
@@ -1708,6 +1740,7 @@ namespace QueryTests {
             add< HelperByIdTest >();
             add< FindingStartPartiallyFull >();
             add< FindingStartStale >();
+            add< FindingStartAfterRollover >();
             add< WhatsMyUri >();
             add< Exhaust >();
             add< QueryCursorTimeout >();
@@ -19,6 +19,8 @@
 
 #include "mongo/pch.h"
 
+#include <fstream>
+
 #include "mongo/db/db.h"
 #include "mongo/db/index_builder.h"
 #include "mongo/db/instance.h"
@@ -29,6 +31,7 @@
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/dbtests/framework_options.h"
 #include "mongo/util/time_support.h"
 
 
@@ -155,6 +158,10 @@ namespace ReplSetTests {
             c.ctx().db()->dropCollection( ns() );
         }
         static void setup() {
+            if (_tailer) {
+                // already set up by another suite in this run
+                return;
+            }
             replSettings.replSet = "foo";
             replSettings.oplogSize = 5 * 1024 * 1024;
             createOplog();
@@ -1130,6 +1137,132 @@ namespace ReplSetTests {
         }
     };
 
+    /**
+     * Measures secondary apply throughput.  Batches of oplog entries are fed through
+     * SyncTail::multiApply once for each replIndexPrefetch mode.  The harness reports ops/s and
+     * per-batch latency.  The entries come from --oplogFile, a bson dump of an oplog, or else are
+     * a generated mix of inserts, updates and deletes.  The writer pool is the replica set's,
+     * with ReplSetImpl::replWriterThreadCount threads.
+     */
+    class ApplyThroughput : public Base {
+        class Tailer : public replset::SyncTail {
+        public:
+            Tailer() : SyncTail(0) {}
+            static unsigned batchLimit() { return replBatchLimitOperations; }
+            void apply(std::deque<BSONObj>& ops) { multiApply(ops, replset::multiSyncApply); }
+        };
+
+        static const char* generatedNs() { return "replperf.coll"; }
+
+        static BSONObj makeOp(int i, const string& op, const BSONObj& o, const BSONObj* o2) {
+            BSONObjBuilder b;
+            b.appendTimestamp("ts", OpTime(1, i + 1).asLL());
+            b.append("h", static_cast<long long>(i));
+            b.append("v", 2);
+            b.append("op", op);
+            b.append("ns", generatedNs());
+            b.append("o", o);
+            if (o2) {
+                b.append("o2", *o2);
+            }
+            return b.obj();
+        }
+
+        static void generateOps(std::vector<BSONObj>* ops) {
+            const int numDocs = 20000;
+            for (int i = 0; i < numDocs; i++) {
+                ops->push_back(makeOp(ops->size(), "i", BSON("_id" << i << "x" << i), NULL));
+            }
+            for (int i = 0; i < numDocs; i++) {
+                BSONObj id = BSON("_id" << (i * 7) % numDocs);
+                ops->push_back(makeOp(ops->size(), "u", BSON("$set" << BSON("x" << -i)), &id));
+            }
+            for (int i = 0; i < numDocs; i += 2) {
+                ops->push_back(makeOp(ops->size(), "d", BSON("_id" << i), NULL));
+            }
+        }
+
+        static void readOps(const string& file, std::vector<BSONObj>* ops) {
+            std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+            ASSERT(in.is_open());
+            std::vector<char> buf;
+            int size;
+            while (in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+                ASSERT(size >= 5 && size <= BSONObjMaxInternalSize);
+                buf.resize(size);
+                memcpy(&buf[0], &size, sizeof(size));
+                ASSERT(in.read(&buf[sizeof(size)], size - sizeof(size)));
+                ops->push_back(BSONObj(&buf[0]).getOwned());
+            }
+        }
+
+        /** Drops the databases the ops write to, so every mode starts from the same state. */
+        void resetDatabases(const std::vector<BSONObj>& ops) {
+            std::set<string> dbs;
+            for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+                const char* ns = it->getStringField("ns");
+                if (ns[0] != '\0' && !str::startsWith(ns, "local.")) {
+                    dbs.insert(nsToDatabase(ns));
+                }
+            }
+            for (std::set<string>::const_iterator it = dbs.begin(); it != dbs.end(); ++it) {
+                client()->dropDatabase(*it);
+            }
+        }
+
+    public:
+        void run() {
+            std::vector<BSONObj> ops;
+            const bool generated = frameworkGlobalParams.oplogFile.empty();
+            if (generated) {
+                generateOps(&ops);
+            }
+            else {
+                readOps(frameworkGlobalParams.oplogFile, &ops);
+            }
+
+            const ReplSetImpl::IndexPrefetchConfig modes[] = {
+                ReplSetImpl::PREFETCH_NONE, ReplSetImpl::PREFETCH_ID_ONLY, ReplSetImpl::PREFETCH_ALL
+            };
+            const char* modeNames[] = { "none", "_id_only", "all" };
+            const ReplSetImpl::IndexPrefetchConfig savedMode = theReplSet->getIndexPrefetchConfig();
+
+            for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                resetDatabases(ops);
+                if (generated) {
+                    client()->ensureIndex(generatedNs(), BSON("x" << 1));
+                }
+                theReplSet->setIndexPrefetchConfig(modes[m]);
+
+                Tailer tailer;
+                std::vector<long long> batchMicros;
+                mongo::Timer total;
+                for (size_t i = 0; i < ops.size(); i += Tailer::batchLimit()) {
+                    size_t end = std::min(ops.size(), i + Tailer::batchLimit());
+                    std::deque<BSONObj> batch(ops.begin() + i, ops.begin() + end);
+                    mongo::Timer t;
+                    tailer.apply(batch);
+                    batchMicros.push_back(t.micros());
+                }
+                long long micros = std::max(total.micros(), 1LL);
+
+                std::sort(batchMicros.begin(), batchMicros.end());
+                long long p50 = batchMicros.empty() ? 0 : batchMicros[batchMicros.size() / 2];
+                long long max = batchMicros.empty() ? 0 : batchMicros.back();
+                log() << "replApply prefetch: " << modeNames[m]
+                      << " writers: " << ReplSetImpl::replWriterThreadCount
+                      << " ops: " << ops.size()
+                      << " ops/s: " << ops.size() * 1000 * 1000 / micros
+                      << " batches: " << batchMicros.size()
+                      << " batch micros p50: " << p50
+                      << " max: " << max << endl;
+            }
+
+            theReplSet->setIndexPrefetchConfig(savedMode);
+            resetDatabases(ops);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "replset" ) {
@@ -1152,4 +1285,15 @@ namespace ReplSetTests {
             add< TestCompact >();
         }
     } myall;
+
+    class PerfAll : public Suite {
+    public:
+        PerfAll() : Suite( "replsetperf" ) {
+        }
+
+        void setupTests() {
+            Base::setup();
+            add< ApplyThroughput >();
+        }
+    } myperf;
 }
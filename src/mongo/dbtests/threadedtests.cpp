@@ -24,14 +24,17 @@
 
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/concurrency/mvar.h"
 #include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/concurrency/list.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/concurrency/qlock.h"
+#include "mongo/util/concurrency/striped_counter.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/server.h"
 
@@ -297,6 +300,29 @@ namespace ThreadedTests {
         }
     };
 
+    class IsStripedCounterAtomic : public ThreadedTest<> {
+        static const int iterations = 1000000;
+        StripedCounter target;
+
+        void subthread(int) {
+            for(int i=0; i < iterations; i++) {
+                if ( i % 2 )
+                    target.increment();
+                else
+                    target.add( 3 );
+            }
+        }
+        void validate() {
+            ASSERT_EQUALS(target.get() , 2LL * nthreads * iterations);
+
+            StripedCounter c;
+            ASSERT_EQUALS(0LL, c.get());
+            c.add(5);
+            c.add(-2);
+            ASSERT_EQUALS(3LL, c.get());
+        }
+    };
+
     template <typename _AtomicUInt>
     class IsAtomicWordAtomic : public ThreadedTest<> {
         static const int iterations = 1000000;
@@ -895,6 +921,109 @@ namespace ThreadedTests {
         }
     };
 
+    /**
+     * Readers take a QLock without its mutex unless something blocks them; check that every
+     * mode still excludes what it should when all of them are mixed.
+     */
+    class QLockModesExclude : public ThreadedTest<8> {
+    public:
+        QLockModesExclude() { }
+    private:
+        QLock q;
+        AtomicInt32 nr, nR, nw, nW;
+        virtual void validate() {
+            ASSERT_EQUALS( 0, nr.load() + nR.load() + nw.load() + nW.load() );
+        }
+        virtual void subthread(int x) {
+            PseudoRandom rand( x );
+            for ( int i = 0; i < 20000; i++ ) {
+                unsigned k = static_cast<uint32_t>( rand.nextInt32() ) % 100;
+                if ( k < 60 ) {
+                    q.lock_r();
+                    nr.fetchAndAdd(1);
+                    ASSERT_EQUALS( 0, nW.load() );
+                    nr.fetchAndSubtract(1);
+                    q.unlock_r();
+                }
+                else if ( k < 85 ) {
+                    q.lock_R();
+                    nR.fetchAndAdd(1);
+                    ASSERT_EQUALS( 0, nw.load() + nW.load() );
+                    nR.fetchAndSubtract(1);
+                    q.unlock_R();
+                }
+                else if ( k < 97 ) {
+                    q.lock_w();
+                    nw.fetchAndAdd(1);
+                    ASSERT_EQUALS( 0, nR.load() + nW.load() );
+                    nw.fetchAndSubtract(1);
+                    q.unlock_w();
+                }
+                else {
+                    q.lock_W();
+                    nW.fetchAndAdd(1);
+                    ASSERT_EQUALS( 0, nr.load() + nR.load() + nw.load() );
+                    nW.fetchAndSubtract(1);
+                    if ( k == 99 ) {
+                        q.W_to_R();
+                        ASSERT_EQUALS( 0, nw.load() + nW.load() );
+                        q.unlock_R();
+                    }
+                    else {
+                        q.unlock_W();
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * With collection level locking a writer to one collection doesn't block a writer to
+     * another collection of the same database, but does block a reader of the whole database.
+     */
+    class CollectionLevelLocking : public ThreadedTest<3> {
+    public:
+        CollectionLevelLocking() : _param(ServerParameterSet::getGlobal()->getMap()["collectionLevelLocking"]) {}
+        virtual void setup() {
+            ASSERT( _param );
+            ASSERT_OK( _param->setFromString( "true" ) );
+            DBDirectClient client;
+            client.insert( "unittests.cll_a", BSON( "x" << 1 ) );
+            client.insert( "unittests.cll_b", BSON( "x" << 1 ) );
+        }
+        virtual void validate() {
+            ASSERT_OK( _param->setFromString( "false" ) );
+            DBDirectClient client;
+            client.dropCollection( "unittests.cll_a" );
+            client.dropCollection( "unittests.cll_b" );
+        }
+    private:
+        ServerParameter* _param;
+        virtual void subthread(int x) {
+            Client::initThread("cll");
+            if( x == 1 ) {
+                Lock::DBWrite lk("unittests.cll_a");
+                ASSERT( Lock::isWriteLocked("unittests.cll_a") );
+                ASSERT( Lock::isWriteLocked("unittests.cll_a.$_id_") );
+                ASSERT( !Lock::isWriteLocked("unittests.cll_b") );
+                sleepmillis(300);
+            }
+            if( x == 2 ) {
+                sleepmillis(100);
+                Timer t;
+                Lock::DBWrite lk("unittests.cll_b");
+                ASSERT( t.millis() < 100 );
+            }
+            if( x == 3 ) {
+                sleepmillis(100);
+                Timer t;
+                Lock::DBRead lk("unittests");
+                ASSERT( t.millis() > 50 );
+            }
+            cc().shutdown();
+        }
+    };
+
     // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
     // max _nRooms threads should ever get in at once
     class TicketHolderWaits : public ThreadedTest<10> {
@@ -977,6 +1106,8 @@ namespace ThreadedTests {
             add< WriteLocksAreGreedy >();
             add< QLockTest >();
             add< QLockTest >();
+            add< QLockModesExclude >();
+            add< CollectionLevelLocking >();
 
             // Slack is a test to see how long it takes for another thread to pick up
             // and begin work after another relinquishes the lock.  e.g. a spin lock 
@@ -991,6 +1122,7 @@ namespace ThreadedTests {
             add< List1Test2 >();
 
             add< IsAtomicUIntAtomic >();
+            add< IsStripedCounterAtomic >();
             add< IsAtomicWordAtomic<AtomicUInt32> >();
             add< IsAtomicWordAtomic<AtomicUInt64> >();
             add< MVarTest >();
@@ -0,0 +1,62 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <sstream>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/async_file_writer.h"
+#include "mongo/logger/encoder.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Appender that encodes events on the logging thread and hands the text to an
+     * AsyncFileWriter.
+     */
+    template <typename Event>
+    class AsyncAppender : public Appender<Event> {
+        MONGO_DISALLOW_COPYING(AsyncAppender);
+
+    public:
+        typedef Encoder<Event> EventEncoder;
+
+        /**
+         * Constructs an appender, that owns "encoder", but not "writer."  Caller must
+         * keep "writer" in scope at least as long as the constructed appender.
+         */
+        AsyncAppender(EventEncoder* encoder, AsyncFileWriter* writer) :
+            _encoder(encoder),
+            _writer(writer) {
+        }
+
+        virtual Status append(const Event& event) {
+            std::ostringstream os;
+            _encoder->encode(event, os);
+            return _writer->write(event.getSeverity(), os.str());
+        }
+
+    private:
+        boost::scoped_ptr<EventEncoder> _encoder;
+        AsyncFileWriter* _writer;
+    };
+
+}  // namespace logger
+}  // namespace mongo
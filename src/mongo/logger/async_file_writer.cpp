@@ -0,0 +1,146 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_file_writer.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace mongo {
+namespace logger {
+
+namespace {
+
+    // Every live AsyncFileWriter, for flushAll().
+    boost::mutex writersMutex;
+    std::vector<AsyncFileWriter*> writers;
+
+}  // namespace
+
+    AsyncFileWriter::AsyncFileWriter(RotatableFileWriter* writer, size_t maxBufferedBytes) :
+        _writer(writer),
+        _maxBufferedBytes(maxBufferedBytes),
+        _bufferedBytes(0),
+        _droppedSinceWrite(0),
+        _droppedTotal(0),
+        _shutdown(false),
+        _thread(boost::bind(&AsyncFileWriter::_run, this)) {
+
+        boost::lock_guard<boost::mutex> lk(writersMutex);
+        writers.push_back(this);
+    }
+
+    AsyncFileWriter::~AsyncFileWriter() {
+        {
+            boost::lock_guard<boost::mutex> lk(writersMutex);
+            writers.erase(std::find(writers.begin(), writers.end(), this));
+        }
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _shutdown = true;
+            _bufferedCondition.notify_one();
+        }
+        _thread.join();
+    }
+
+    Status AsyncFileWriter::write(LogSeverity severity, const std::string& line) {
+        if (severity >= LogSeverity::Severe()) {
+            boost::lock_guard<boost::mutex> writeLk(_writeMutex);
+            Status status = _drain();
+            Status lineStatus = _writeLines(std::vector<std::string>(1, line), 0);
+            return status.isOK() ? lineStatus : status;
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        size_t limit = severity >= LogSeverity::Warning() ? _maxBufferedBytes
+                                                          : _maxBufferedBytes / 2;
+        if (_bufferedBytes + line.size() > limit) {
+            ++_droppedSinceWrite;
+            ++_droppedTotal;
+            return Status::OK();
+        }
+        _buffered.push_back(line);
+        _bufferedBytes += line.size();
+        _bufferedCondition.notify_one();
+        return Status::OK();
+    }
+
+    Status AsyncFileWriter::flush() {
+        boost::lock_guard<boost::mutex> writeLk(_writeMutex);
+        return _drain();
+    }
+
+    unsigned long long AsyncFileWriter::getDroppedCount() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _droppedTotal;
+    }
+
+    void AsyncFileWriter::flushAll() {
+        boost::lock_guard<boost::mutex> lk(writersMutex);
+        for (size_t i = 0; i < writers.size(); ++i)
+            writers[i]->flush();
+    }
+
+    void AsyncFileWriter::_run() {
+        while (true) {
+            {
+                boost::unique_lock<boost::mutex> lk(_mutex);
+                while (_buffered.empty() && _droppedSinceWrite == 0 && !_shutdown)
+                    _bufferedCondition.wait(lk);
+                if (_buffered.empty() && _droppedSinceWrite == 0 && _shutdown)
+                    return;
+            }
+
+            boost::lock_guard<boost::mutex> writeLk(_writeMutex);
+            _drain();
+        }
+    }
+
+    Status AsyncFileWriter::_drain() {
+        std::vector<std::string> lines;
+        unsigned long long dropped;
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            lines.swap(_buffered);
+            _bufferedBytes = 0;
+            dropped = _droppedSinceWrite;
+            _droppedSinceWrite = 0;
+        }
+        return _writeLines(lines, dropped);
+    }
+
+    Status AsyncFileWriter::_writeLines(const std::vector<std::string>& lines,
+                                        unsigned long long dropped) {
+        if (lines.empty() && dropped == 0)
+            return Status::OK();
+
+        RotatableFileWriter::Use useWriter(_writer);
+        Status status = useWriter.status();
+        if (!status.isOK())
+            return status;
+
+        std::ostream& os = useWriter.stream();
+        if (dropped)
+            os << "warning: " << dropped << " log lines dropped because the log buffer was full\n";
+        for (size_t i = 0; i < lines.size(); ++i)
+            os << lines[i];
+        os.flush();
+        return useWriter.status();
+    }
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/log_severity.h"
+#include "mongo/logger/rotatable_file_writer.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Buffers encoded log lines in memory and writes them to a RotatableFileWriter from a
+     * background thread, so that logging threads don't wait on the disk.
+     *
+     * The buffer is bounded.  Once it's half full only warnings and more severe lines are
+     * buffered; once it's full every line is dropped.  Dropped lines are counted and the count
+     * is written to the log when there is room again.  Severe lines are written synchronously,
+     * after everything buffered before them, so they are on disk if the process then dies.
+     */
+    class AsyncFileWriter {
+        MONGO_DISALLOW_COPYING(AsyncFileWriter);
+
+    public:
+        /**
+         * Starts the writer thread.  Doesn't own "writer"; the caller must keep it in scope at
+         * least as long as this object.
+         */
+        AsyncFileWriter(RotatableFileWriter* writer, size_t maxBufferedBytes);
+
+        /** Stops the writer thread, after it writes what is buffered. */
+        ~AsyncFileWriter();
+
+        /**
+         * Buffers "line", or writes it now if "severity" is Severe.
+         */
+        Status write(LogSeverity severity, const std::string& line);
+
+        /**
+         * Writes what is buffered on the calling thread.
+         */
+        Status flush();
+
+        /** Number of lines dropped because the buffer was full. */
+        unsigned long long getDroppedCount() const;
+
+        /**
+         * Flushes every AsyncFileWriter in the process.  Called before exiting.
+         */
+        static void flushAll();
+
+    private:
+        void _run();
+
+        /** Writes "lines" and the drop notice, if any.  Called with _writeMutex held. */
+        Status _writeLines(const std::vector<std::string>& lines, unsigned long long dropped);
+
+        /** Takes what's buffered and writes it.  Called with _writeMutex held. */
+        Status _drain();
+
+        RotatableFileWriter* const _writer;
+        const size_t _maxBufferedBytes;
+
+        // Serializes draining, so buffered lines are written in order.
+        boost::mutex _writeMutex;
+
+        // Protects the members below.
+        mutable boost::mutex _mutex;
+        boost::condition_variable _bufferedCondition;
+        std::vector<std::string> _buffered;
+        size_t _bufferedBytes;
+        unsigned long long _droppedSinceWrite;
+        unsigned long long _droppedTotal;
+        bool _shutdown;
+
+        boost::thread _thread;
+    };
+
+}  // namespace logger
+}  // namespace mongo
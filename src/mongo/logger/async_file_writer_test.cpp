@@ -0,0 +1,94 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <fstream>
+
+#include "mongo/logger/async_file_writer.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using namespace mongo;
+    using namespace mongo::logger;
+
+    const std::string logFileName("LogTest_AsyncFileWriter.txt");
+
+    class AsyncFileWriterTest : public mongo::unittest::Test {
+    public:
+        AsyncFileWriterTest() {
+            unlink(logFileName.c_str());
+        }
+
+        virtual ~AsyncFileWriterTest() {
+            unlink(logFileName.c_str());
+        }
+
+        static std::vector<std::string> readLog() {
+            std::vector<std::string> lines;
+            std::ifstream ifs(logFileName.c_str());
+            std::string input;
+            while (std::getline(ifs, input))
+                lines.push_back(input);
+            return lines;
+        }
+    };
+
+    TEST_F(AsyncFileWriterTest, WritesLinesInOrder) {
+        RotatableFileWriter writer;
+        ASSERT_OK(RotatableFileWriter::Use(&writer).setFileName(logFileName, false));
+
+        {
+            AsyncFileWriter asyncWriter(&writer, 1024 * 1024);
+            ASSERT_OK(asyncWriter.write(LogSeverity::Log(), "line 1\n"));
+            ASSERT_OK(asyncWriter.write(LogSeverity::Warning(), "line 2\n"));
+            ASSERT_OK(asyncWriter.flush());
+
+            std::vector<std::string> lines = readLog();
+            ASSERT_EQUALS(2U, lines.size());
+            ASSERT_EQUALS("line 1", lines[0]);
+            ASSERT_EQUALS("line 2", lines[1]);
+
+            // written by the destructor
+            ASSERT_OK(asyncWriter.write(LogSeverity::Log(), "line 3\n"));
+        }
+
+        std::vector<std::string> lines = readLog();
+        ASSERT_EQUALS(3U, lines.size());
+        ASSERT_EQUALS("line 3", lines[2]);
+    }
+
+    TEST_F(AsyncFileWriterTest, DropsWhenFullAndWritesSevereNow) {
+        RotatableFileWriter writer;
+        ASSERT_OK(RotatableFileWriter::Use(&writer).setFileName(logFileName, false));
+
+        // room for warnings but not for lower severities
+        AsyncFileWriter asyncWriter(&writer, 16);
+        ASSERT_OK(asyncWriter.write(LogSeverity::Log(), "dropped line\n"));
+        ASSERT_OK(asyncWriter.write(LogSeverity::Error(), "kept\n"));
+        ASSERT_EQUALS(1U, asyncWriter.getDroppedCount());
+
+        // no flush: severe lines are written synchronously, after what was buffered
+        ASSERT_OK(asyncWriter.write(LogSeverity::Severe(), "severe\n"));
+
+        std::vector<std::string> lines = readLog();
+        ASSERT_EQUALS(3U, lines.size());
+        ASSERT_EQUALS("warning: 1 log lines dropped because the log buffer was full", lines[0]);
+        ASSERT_EQUALS("kept", lines[1]);
+        ASSERT_EQUALS("severe", lines[2]);
+    }
+
+}  // namespace
@@ -30,6 +30,8 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
 #include "mongo/db/jsobj.h"
@@ -55,79 +57,145 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
-    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
-                              bool secondaryThrottle,
-                              bool waitForDelete)
+    int Balancer::_moveChunk(const CandidateChunk& chunkInfo,
+                             bool secondaryThrottle,
+                             bool waitForDelete)
     {
-        int movedCount = 0;
-
-        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
                 verify( cm );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
                 if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
-
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return 0;
                 }
+            }
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     secondaryThrottle,
-                                     waitForDelete,
-                                     res)) {
-                    movedCount++;
-                    continue;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                                 Chunk::MaxChunkSize,
+                                 secondaryThrottle,
+                                 waitForDelete,
+                                 res)) {
+                return 1;
+            }
+
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
+
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+
+                log() << "forcing a split because migrate failed for size reasons" << endl;
+
+                res = BSONObj();
+                c->singleSplit( true , res );
+                log() << "forced split results: " << res << endl;
+
+                if ( ! res["ok"].trueValue() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we count it as moved so we do another round right away
+                    return 1;
                 }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            }
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+        return 0;
+    }
 
-                    log() << "forcing a split because migrate failed for size reasons" << endl;
+    void Balancer::_moveChunkInWave(const CandidateChunk* chunkInfo,
+                                    bool secondaryThrottle,
+                                    bool waitForDelete,
+                                    int* moved)
+    {
+        try {
+            *moved = _moveChunk(*chunkInfo, secondaryThrottle, waitForDelete);
+        }
+        catch ( const std::exception& ex ) {
+            warning() << "could not move chunk " << chunkInfo->chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex.what() ) << endl;
+        }
+    }
 
-                    res = BSONObj();
-                    c->singleSplit( true , res );
-                    log() << "forced split results: " << res << endl;
+    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                              bool secondaryThrottle,
+                              bool waitForDelete,
+                              int maxConcurrentMigrations)
+    {
+        int movedCount = 0;
 
-                    if ( ! res["ok"].trueValue() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+        // A shard takes part in only one migration at a time, as donor or recipient, so split
+        // the candidates into waves in which no shard appears twice. Candidates are one per
+        // collection, and each migration takes its own collection's lock, so a wave never
+        // contends with itself.
+        vector<const CandidateChunk*> remaining;
+        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+            remaining.push_back( it->get() );
+        }
 
+        while ( ! remaining.empty() ) {
+            set<string> busyShards;
+            vector<const CandidateChunk*> wave;
+            vector<const CandidateChunk*> deferred;
+            for ( size_t i = 0; i < remaining.size(); i++ ) {
+                const CandidateChunk* chunkInfo = remaining[i];
+                if ( static_cast<int>( wave.size() ) < maxConcurrentMigrations &&
+                     ! busyShards.count( chunkInfo->from ) &&
+                     ! busyShards.count( chunkInfo->to ) ) {
+                    busyShards.insert( chunkInfo->from );
+                    busyShards.insert( chunkInfo->to );
+                    wave.push_back( chunkInfo );
+                }
+                else {
+                    deferred.push_back( chunkInfo );
                 }
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+            remaining.swap( deferred );
+
+            if ( wave.size() == 1 ) {
+                movedCount += _moveChunk( *wave[0], secondaryThrottle, waitForDelete );
+                continue;
+            }
+
+            LOG(1) << "moving " << wave.size() << " chunks concurrently" << endl;
+
+            vector<int> moved( wave.size(), 0 );
+            boost::thread_group threads;
+            for ( size_t i = 0; i < wave.size(); i++ ) {
+                threads.create_thread( boost::bind( &Balancer::_moveChunkInWave, this, wave[i],
+                                                    secondaryThrottle, waitForDelete,
+                                                    &moved[i] ) );
+            }
+            threads.join_all();
+
+            for ( size_t i = 0; i < moved.size(); i++ ) {
+                movedCount += moved[i];
             }
         }
 
@@ -491,8 +559,16 @@ namespace mongo {
                         secondaryThrottle = balancerConfig[SettingsType::secondaryThrottle()].trueValue();
                     }
 
+                    // how many migrations between disjoint pairs of shards may run at once
+                    int maxConcurrentMigrations = 1;
+                    if ( balancerConfig["_maxConcurrentMigrations"].isNumber() ) {
+                        maxConcurrentMigrations =
+                            std::max( 1, balancerConfig["_maxConcurrentMigrations"].numberInt() );
+                    }
+
                     LOG(1) << "waitForDelete: " << waitForDelete << endl;
                     LOG(1) << "secondaryThrottle: " << secondaryThrottle << endl;
+                    LOG(1) << "maxConcurrentMigrations: " << maxConcurrentMigrations << endl;
 
                     vector<CandidateChunkPtr> candidateChunks;
                     _doBalanceRound( conn.conn() , &candidateChunks );
@@ -503,7 +579,8 @@ namespace mongo {
                     else {
                         _balancedLastTime = _moveChunks(&candidateChunks,
                                                         secondaryThrottle,
-                                                        waitForDelete );
+                                                        waitForDelete,
+                                                        maxConcurrentMigrations );
                     }
 
                     LOG(1) << "*** end of balancing round" << endl;
@@ -93,16 +93,37 @@ namespace mongo {
         void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests, in waves where no shard takes part in two of them.
+         * The migrations of a wave run concurrently.
          *
          * @param candidateChunks possible chunks to move
          * @param secondaryThrottle wait for secondaries to catch up before pushing more deletes
          * @param waitForDelete wait for deletes to complete after each chunk move
+         * @param maxConcurrentMigrations the most migrations a wave may hold
          * @return number of chunks effectively moved
          */
         int _moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
                         bool secondaryThrottle,
-                        bool waitForDelete);
+                        bool waitForDelete,
+                        int maxConcurrentMigrations);
+
+        /**
+         * Issues one chunk migration request and handles its failure.
+         *
+         * @return number of chunks effectively moved (0 or 1)
+         */
+        int _moveChunk(const CandidateChunk& chunkInfo,
+                       bool secondaryThrottle,
+                       bool waitForDelete);
+
+        /**
+         * Body of a thread running one migration of a wave. Stores _moveChunk's result in
+         * 'moved'.
+         */
+        void _moveChunkInWave(const CandidateChunk* chunkInfo,
+                              bool secondaryThrottle,
+                              bool waitForDelete,
+                              int* moved);
 
         /**
          * Marks this balancer as being live on the config server(s).
@@ -88,6 +88,7 @@ namespace mongo {
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
+        long long minSize = numeric_limits<long long>::max();
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             if ( i->second.isSizeMaxed() ) {
@@ -111,13 +112,21 @@ namespace mongo {
             }
 
             unsigned myChunks = numberOfChunksInShard( i->first );
-            if ( myChunks >= minChunks ) {
+            if ( myChunks > minChunks ) {
                 LOG(1) << i->first << " has more chunks me:" << myChunks << " best: " << best << ":" << minChunks << endl;
                 continue;
             }
 
+            // among shards with as few chunks, the one holding the least data takes the chunk
+            long long mySize = i->second.getCurrSize();
+            if ( myChunks == minChunks && mySize >= minSize ) {
+                LOG(1) << i->first << " has as many chunks and more data me:" << mySize << " best: " << best << ":" << minSize << endl;
+                continue;
+            }
+
             best = i->first;
             minChunks = myChunks;
+            minSize = mySize;
         }
 
         return best;
@@ -126,6 +135,7 @@ namespace mongo {
     string DistributionStatus::getMostOverloadedShard( const string& tag ) const {
         string worst;
         unsigned maxChunks = 0;
+        long long maxSize = -1;
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
 
@@ -135,11 +145,17 @@ namespace mongo {
             }
 
             unsigned myChunks = numberOfChunksInShardWithTag( i->first, tag );
-            if ( myChunks <= maxChunks )
+            if ( myChunks < maxChunks || myChunks == 0 )
+                continue;
+
+            // among shards with as many chunks, the one holding the most data gives one up
+            long long mySize = i->second.getCurrSize();
+            if ( myChunks == maxChunks && mySize <= maxSize )
                 continue;
 
             worst = i->first;
             maxChunks = myChunks;
+            maxSize = mySize;
         }
 
         return worst;
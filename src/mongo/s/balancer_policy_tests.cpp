@@ -378,6 +378,32 @@ namespace mongo {
             ASSERT( !m );
         }
 
+        /**
+         * Among shards with the same number of chunks, the one with the least data receives the
+         * chunk and the one with the most data donates it.
+         */
+        TEST( BalancerPolicyTests, DataSizeBreaksTies ) {
+
+            ShardToChunksMap chunks;
+            addShard( chunks, 10 , false );
+            addShard( chunks, 10 , false );
+            addShard( chunks, 0 , false );
+            addShard( chunks, 0 , true );
+
+            ShardInfoMap shards;
+            // ShardInfo(maxSize, currSize, draining, opsQueued)
+            shards["shard0"] = ShardInfo( 0, 10, false, false );
+            shards["shard1"] = ShardInfo( 0, 40, false, false );
+            shards["shard2"] = ShardInfo( 0, 50, false, false );
+            shards["shard3"] = ShardInfo( 0, 5, false, false );
+
+            DistributionStatus d( shards, chunks );
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard1" , m->from );
+            ASSERT_EQUALS( "shard3" , m->to );
+        }
+
         /**
          * Idea behind this test is that we set up several shards, the first two of which are
          * draining and the second two of which have a data size limit.  We also simulate a random
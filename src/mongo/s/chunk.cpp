@@ -604,7 +604,8 @@ namespace mongo {
         _unique( unique ),
         _chunkRanges(),
         _mutex("ChunkManager"),
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _targetingMutex("ChunkManager::targeting")
     {
         //
         // Sets up a chunk manager from new data
@@ -626,7 +627,8 @@ namespace mongo {
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
         // Increasing this number here will prompt checkShardVersion() to refresh the connection-level versions to
         // the most up to date value.
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _targetingMutex("ChunkManager::targeting")
     {
 
         //
@@ -645,7 +647,8 @@ namespace mongo {
         _unique( oldManager->isUnique() ),
         _chunkRanges(),
         _mutex("ChunkManager"),
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _targetingMutex("ChunkManager::targeting")
     {
         //
         // Sets up a chunk manager based on an older manager
@@ -782,7 +785,8 @@ namespace mongo {
 
                 c->setBytesWritten( oldC->getBytesWritten() );
 
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
+                // the old map is in order, so hinting at the end makes each insert constant time
+                chunkMap.insert( chunkMap.end(), make_pair( oldC->getMax(), c ) );
             }
 
             // Also get any minor versions stored for reload
@@ -1101,7 +1105,109 @@ namespace mongo {
         return ChunkPtr();
     }
 
+    namespace {
+        /** @return true if a query equality on e pins a shard key field to one value */
+        bool isPointEquality( const BSONElement& e ) {
+            switch ( e.type() ) {
+            case NumberDouble:
+            case String:
+            case jstOID:
+            case Bool:
+            case Date:
+            case NumberInt:
+            case Timestamp:
+            case NumberLong:
+            case BinData:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /** field names and operators, with constants reduced to their kind */
+        void appendQueryShape( const BSONObj& obj , StringBuilder& shape ) {
+            BSONForEach( e , obj ) {
+                shape << e.fieldNameSize() << e.fieldName();
+                if ( isPointEquality( e ) ) {
+                    shape << '=';
+                }
+                else if ( e.type() == Object ) {
+                    shape << '{';
+                    appendQueryShape( e.embeddedObject() , shape );
+                    shape << '}';
+                }
+                else {
+                    shape << '#' << e.type();
+                }
+            }
+        }
+    }
+
     void ChunkManager::getShardsForQuery( set<Shard>& shards , const BSONObj& query ) const {
+        StringBuilder shapeBuilder;
+        appendQueryShape( query , shapeBuilder );
+        string shape = shapeBuilder.str();
+
+        TargetingStrategy strategy = TargetUnknown;
+        {
+            scoped_lock lk( _targetingMutex );
+            map<string,TargetingStrategy>::const_iterator i = _targeting.find( shape );
+            if ( i != _targeting.end() )
+                strategy = i->second;
+        }
+
+        if ( strategy == TargetEquality && query.objsize() < 512 ) {
+            // small enough that the extracted key can't exceed the shard key size limit
+            shards.insert( findIntersectingChunk( _key.extractKey( query ) )->getShard() );
+            return;
+        }
+        if ( strategy == TargetAll ) {
+            getAllShards( shards );
+            return;
+        }
+
+        // this uasserts on queries mongos can't route, so those shapes are never remembered
+        _getShardsForRanges( shards , query );
+
+        if ( strategy == TargetUnknown ) {
+            TargetingStrategy found = _targetingFor( query );
+            scoped_lock lk( _targetingMutex );
+            if ( _targeting.size() < maxTargetingShapes )
+                _targeting[ shape ] = found;
+        }
+    }
+
+    ChunkManager::TargetingStrategy ChunkManager::_targetingFor( const BSONObj& query ) const {
+        BSONForEach( e , query ) {
+            // $or, $and, $where etc
+            if ( e.fieldName()[0] == '$' )
+                return TargetGeneral;
+        }
+
+        bool allPoints = true;
+        BSONForEach( keyField , _key.key() ) {
+            BSONElement e = query[ keyField.fieldName() ];
+            if ( str::contains( keyField.fieldName() , '.' ) || ! isPointEquality( e ) ) {
+                allPoints = false;
+                break;
+            }
+        }
+        if ( allPoints )
+            return TargetEquality;
+
+        // a query that doesn't mention the leading shard key field at all goes everywhere
+        string first = _key.key().firstElementFieldName();
+        BSONForEach( e , query ) {
+            string name = e.fieldName();
+            if ( name == first ||
+                 str::startsWith( name , first + '.' ) ||
+                 str::startsWith( first , name + '.' ) )
+                return TargetGeneral;
+        }
+        return TargetAll;
+    }
+
+    void ChunkManager::_getShardsForRanges( set<Shard>& shards , const BSONObj& query ) const {
         // TODO Determine if the third argument to OrRangeGenerator() is necessary, see SERVER-5165.
         OrRangeGenerator org(_ns.c_str(), query, false);
 
@@ -1389,7 +1495,8 @@ namespace mongo {
                 ++begin;
 
             shared_ptr<ChunkRange> cr (new ChunkRange(first, begin));
-            _ranges[cr->getMax()] = cr;
+            // ranges are made in order, so hinting at the end makes each insert constant time
+            _ranges.insert(_ranges.end(), make_pair(cr->getMax(), cr));
         }
     }
 
@@ -1422,7 +1529,8 @@ namespace mongo {
     _unique(),
     _chunkRanges(),
     _mutex( "ChunkManager" ),
-    _sequenceNumber()
+    _sequenceNumber(),
+    _targetingMutex( "ChunkManager::targeting" )
     {}
 
     class ChunkObjUnitTest : public StartupTest {
@@ -416,6 +416,12 @@ namespace mongo {
 
         ChunkPtr findChunkOnServer( const Shard& shard ) const;
 
+        /**
+         * The targeting of a query depends only on its shape -- field names, operators and the
+         * kinds of its constants -- except for the constants themselves.  Each shape seen on this
+         * version of the chunks is remembered as targeting one shard by equality on the shard
+         * key, all shards, or the general range computation.
+         */
         void getShardsForQuery( set<Shard>& shards , const BSONObj& query ) const;
         void getAllShards( set<Shard>& all ) const;
         /** @param shards set to the shards covered by the interval [min, max], see SERVER-4791 */
@@ -487,6 +493,15 @@ namespace mongo {
 
         const unsigned long long _sequenceNumber;
 
+        // query shape -> targeting, see getShardsForQuery()
+        enum TargetingStrategy { TargetUnknown, TargetGeneral, TargetEquality, TargetAll };
+        TargetingStrategy _targetingFor( const BSONObj& query ) const;
+        void _getShardsForRanges( set<Shard>& shards , const BSONObj& query ) const;
+
+        mutable mutex _targetingMutex;
+        mutable map<string,TargetingStrategy> _targeting;
+        static const size_t maxTargetingShapes = 1000;
+
         //
         // Split Heuristic info
         //
@@ -87,10 +87,16 @@ namespace mongo {
                                         << " does not contain shard key for pattern "
                                         << _manager->getShardKey().key() );
             }
-            ChunkPtr chunk = _manager->findChunkForDoc( doc );
-            *endpoint = new ShardEndpoint( chunk->getShard().getName(),
-                                           _manager->getVersion( chunk->getShard() ),
-                                           chunk->getShard().getAddress() );
+            BSONObj key = _manager->getShardKey().extractKey( doc );
+            if ( _lastManager != _manager || !_lastChunk->containsPoint( key ) ) {
+                ChunkPtr chunk = _manager->findIntersectingChunk( key );
+                _lastEndpoint.reset( new ShardEndpoint( chunk->getShard().getName(),
+                                                        _manager->getVersion( chunk->getShard() ),
+                                                        chunk->getShard().getAddress() ) );
+                _lastChunk = chunk;
+                _lastManager = _manager;
+            }
+            *endpoint = new ShardEndpoint( *_lastEndpoint );
         }
         else {
             *endpoint = new ShardEndpoint( _primary->getName(),
@@ -98,6 +98,13 @@ namespace mongo {
 
         // Stores whether we need to check the remote server on refresh
         bool _needsTargetingRefresh;
+
+        // The chunk and endpoint of the last targetDoc, tried first by the next one, since the
+        // documents of a bulk insert often fall in the same chunk. Holding the manager keeps
+        // the cache from matching a newer _manager allocated at the same address.
+        mutable ChunkManagerPtr _lastManager;
+        mutable ChunkPtr _lastChunk;
+        mutable scoped_ptr<ShardEndpoint> _lastEndpoint;
     };
 
 } // namespace mongo
@@ -121,6 +121,15 @@ namespace mongo {
         return _tlInfo.get();
     }
 
+    ClientInfo* ClientInfo::release() {
+        return _tlInfo.release();
+    }
+
+    void ClientInfo::install(ClientInfo* info) {
+        verify(!_tlInfo.get());
+        _tlInfo.reset(info);
+    }
+
     bool ClientBasic::hasCurrent() {
         return ClientInfo::exists();
     }
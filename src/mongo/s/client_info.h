@@ -120,6 +120,11 @@ namespace mongo {
         static ClientInfo * get(AbstractMessagingPort* messagingPort = NULL);
         // Creates a ClientInfo and stores it in _tlInfo
         static ClientInfo* create(AbstractMessagingPort* messagingPort);
+        // Detaches this thread's ClientInfo from _tlInfo without destroying it, so that the
+        // client can be resumed on another thread with install()
+        static ClientInfo* release();
+        // Stores a released ClientInfo in _tlInfo; this thread must not already have one
+        static void install(ClientInfo* info);
 
     private:
         struct WBInfo {
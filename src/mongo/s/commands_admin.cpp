@@ -36,6 +36,7 @@
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/client_basic.h"
 #include "mongo/db/commands/shutdown.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/field_parser.h"
@@ -54,6 +55,7 @@
 #include "mongo/s/writeback_listener.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/stringutils.h"
@@ -661,7 +663,9 @@ namespace mongo {
                 // Pre-splitting:
                 // For new collections which use hashed shard keys, we can can pre-split the
                 // range of possible hashes into a large number of chunks, and distribute them
-                // evenly at creation time. Until we design a better initialization scheme, the
+                // evenly at creation time. New collections with any shard key can instead be
+                // given the split points, e.g. sampled from the data about to be loaded, as
+                // "initialSplitPoints". Until we design a better initialization scheme, the
                 // safest way to pre-split is to
                 // 1. make one big chunk for each shard
                 // 2. move them one at a time
@@ -675,8 +679,34 @@ namespace mongo {
                 vector<BSONObj> initSplits;  // there will be at most numShards-1 of these
                 vector<BSONObj> allSplits;   // all of the initial desired split points
 
+                BSONElement initialSplitPoints = cmdObj["initialSplitPoints"];
+                if ( !initialSplitPoints.eoo() ) {
+                    if ( initialSplitPoints.type() != Array ) {
+                        errmsg = "initialSplitPoints must be an array of shard key values";
+                        return false;
+                    }
+                    if ( !isEmpty ) {
+                        errmsg = "initialSplitPoints can only be used on an empty collection";
+                        return false;
+                    }
+
+                    set<BSONObj> orderedPoints;
+                    BSONForEach( point, initialSplitPoints.embeddedObject() ) {
+                        if ( point.type() != Object ||
+                             point.embeddedObject().nFields() != proposedKey.nFields() ||
+                             !proposedShardKey.hasShardKey( point.embeddedObject() ) ||
+                             point.embeddedObject().woCompare( proposedShardKey.globalMin() ) == 0 ||
+                             point.embeddedObject().woCompare( proposedShardKey.globalMax() ) == 0 ) {
+                            errmsg = str::stream() << "split point " << point << " does not "
+                                                   << "match shard key " << proposedKey;
+                            return false;
+                        }
+                        orderedPoints.insert( point.embeddedObject().getOwned() );
+                    }
+                    allSplits.assign( orderedPoints.begin(), orderedPoints.end() );
+                }
                 // only pre-split when using a hashed shard key and collection is still empty
-                if ( isHashedShardKey && isEmpty ){
+                else if ( isHashedShardKey && isEmpty ){
 
                     int numChunks = cmdObj["numInitialChunks"].numberInt();
                     if ( numChunks <= 0 )
@@ -700,8 +730,11 @@ namespace mongo {
                         current += intervalSize;
                     }
                     sort( allSplits.begin() , allSplits.end() );
+                }
 
-                    // 1. the initial splits define the "big chunks" that we will subdivide later
+                // 1. the initial splits define the "big chunks" that we will subdivide later
+                if ( !allSplits.empty() ) {
+                    int numChunks = allSplits.size() + 1;
                     int lastIndex = -1;
                     for ( int i = 1; i < numShards; i++ ){
                         if ( lastIndex < (i*numChunks)/numShards - 1 ){
@@ -717,8 +750,8 @@ namespace mongo {
 
                 result << "collectionsharded" << ns;
 
-                // only initially move chunks when using a hashed shard key
-                if (isHashedShardKey) {
+                // only initially move chunks when using a hashed shard key or given split points
+                if (isHashedShardKey || !allSplits.empty()) {
 
                     // Reload the new config info.  If we created more than one initial chunk, then
                     // we need to move them around to balance.
@@ -1379,6 +1412,8 @@ namespace mongo {
                 result.append("maxWireVersion", maxWireVersion);
                 result.append("minWireVersion", minWireVersion);
 
+                negotiateWireCompression(cmdObj, ClientBasic::getCurrent()->port(), &result);
+
                 return true;
             }
         } ismaster;
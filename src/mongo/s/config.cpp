@@ -126,8 +126,7 @@ namespace mongo {
     bool DBConfig::isSharded( const string& ns ) {
         if ( ! _shardingEnabled )
             return false;
-        scoped_lock lk( _lock );
-        return _isSharded( ns );
+        return _getPublishedChunkManager( ns ).get() != NULL;
     }
 
     bool DBConfig::_isSharded( const string& ns ) {
@@ -210,6 +209,7 @@ namespace mongo {
             cm->createFirstChunks( configServer.getPrimary().getConnString(),
                                    getPrimary(), initPoints, initShards );
             ci.shard( cm );
+            _publishChunkManagers();
 
             _save();
 
@@ -271,6 +271,7 @@ namespace mongo {
         }
 
         ci.unshard();
+        _publishChunkManagers();
         _save( false, true );
         return true;
     }
@@ -285,6 +286,12 @@ namespace mongo {
         manager.reset();
         primary.reset();
 
+        if ( _shardingEnabled ) {
+            manager = _getPublishedChunkManager( ns );
+            if ( manager )
+                return;
+        }
+
         {
             scoped_lock lk( _lock );
 
@@ -328,6 +335,13 @@ namespace mongo {
     }
 
     ChunkManagerPtr DBConfig::getChunkManager( const string& ns , bool shouldReload, bool forceReload ) {
+        if ( ! ( shouldReload || forceReload ) ) {
+            ChunkManagerPtr manager = _getPublishedChunkManager( ns );
+            if ( manager )
+                return manager;
+            // not sharded, or not yet published; the locked path below asserts
+        }
+
         BSONObj key;
         ChunkVersion oldVersion;
         ChunkManagerPtr oldManager;
@@ -456,6 +470,7 @@ namespace mongo {
 
         if ( shouldReset ){
             ci.resetCM( temp.release() );
+            _publishChunkManagers();
         }
         
         uassert( 15883 , str::stream() << "not sharded after chunk manager reset : " << ns , ci.isSharded() );
@@ -544,6 +559,8 @@ namespace mongo {
 
         conn.done();
 
+        _publishChunkManagers();
+
         return true;
     }
 
@@ -578,6 +595,26 @@ namespace mongo {
         conn.done();
     }
 
+    void DBConfig::_publishChunkManagers() {
+        boost::shared_ptr<ChunkManagerMap> cms( new ChunkManagerMap() );
+        for ( Collections::const_iterator i = _collections.begin(); i != _collections.end(); ++i ) {
+            if ( i->second.isSharded() )
+                (*cms)[i->first] = i->second.getCM();
+        }
+        boost::shared_ptr<const ChunkManagerMap> published( cms );
+        boost::atomic_store( &_chunkManagers, published );
+    }
+
+    ChunkManagerPtr DBConfig::_getPublishedChunkManager( const string& ns ) const {
+        boost::shared_ptr<const ChunkManagerMap> cms = boost::atomic_load( &_chunkManagers );
+        if ( ! cms )
+            return ChunkManagerPtr();
+        ChunkManagerMap::const_iterator i = cms->find( ns );
+        if ( i == cms->end() )
+            return ChunkManagerPtr();
+        return i->second;
+    }
+
     bool DBConfig::reload() {
         bool successful = false;
 
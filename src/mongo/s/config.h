@@ -98,6 +98,7 @@ namespace mongo {
         };
 
         typedef map<string,CollectionInfo> Collections;
+        typedef map<string,ChunkManagerPtr> ChunkManagerMap;
 
     public:
 
@@ -196,6 +197,19 @@ namespace mongo {
         bool _reload();
         void _save( bool db = true, bool coll = true );
 
+        /**
+         * Replaces _chunkManagers with the chunk managers now in _collections.  Must be called,
+         * with _lock held, after any change to which collections are sharded or to their
+         * chunk managers.
+         */
+        void _publishChunkManagers();
+
+        /**
+         * @return the published chunk manager for 'ns', or an empty pointer if 'ns' wasn't
+         * sharded when it was last published.  Doesn't take _lock.
+         */
+        ChunkManagerPtr _getPublishedChunkManager( const string& ns ) const;
+
         string _name; // e.g. "alleyinsider"
         Shard _primary; // e.g. localhost , mongo.foo.com:9999
         bool _shardingEnabled;
@@ -205,6 +219,11 @@ namespace mongo {
 
         Collections _collections;
 
+        // The chunk managers of the sharded collections in _collections.  The map is never
+        // modified once published, only replaced under _lock, so the request path can look up
+        // a chunk manager with an atomic load instead of contending on _lock.
+        boost::shared_ptr<const ChunkManagerMap> _chunkManagers;
+
         mutable mongo::mutex _lock; // TODO: change to r/w lock ??
         mutable mongo::mutex _hitConfigServerLock;
     };
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/s/config_change_watcher.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/client/connpool.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/config.h"
+#include "mongo/s/grid.h"
+#include "mongo/s/type_changelog.h"
+
+namespace mongo {
+
+    // Follow config.changelog to reload chunk managers as soon as their metadata changes.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(watchConfigChanges, bool, true);
+
+    namespace {
+
+        // Thread that tails config.changelog.
+        boost::scoped_ptr<boost::thread> _watcherThread;
+
+        /** Brings this mongos's view of the namespace in a changelog entry up to date. */
+        void applyChange( const BSONObj& entry ) {
+            string what = entry[ChangelogType::what()].str();
+            string ns = entry[ChangelogType::ns()].str();
+
+            // Only databases this mongos has already loaded have anything to refresh
+            DBConfigPtr config = grid.getDBConfigIfLoaded( ns );
+            if ( ! config || config->getName() == "config" )
+                return;
+
+            if ( what == "moveChunk.commit" || what == "split" || what == "multi-split" ||
+                 what == "merge" || what == "shardCollection" ) {
+                LOG(1) << "reloading chunk manager for " << ns << " after " << what << endl;
+                // loads only the chunks that changed since the current chunk manager
+                config->getChunkManagerIfExists( ns, true );
+            }
+            else if ( what == "dropCollection" || what == "dropDatabase" ||
+                      what == "movePrimary" ) {
+                LOG(1) << "reloading database config for " << ns << " after " << what << endl;
+                config->reload();
+            }
+        }
+
+        void watchChanges() {
+            // Changes made before this mongos started are in the config it loads anyway.  The
+            // tail starts at the newest entry, since a tailable cursor with no results is dead.
+            Date_t lastSeen = jsTime();
+            bool haveLastSeen = false;
+            unsigned hostIndex = 0;
+
+            while ( ! inShutdown() ) {
+                // Every config server gets each changelog entry, so any of them can be tailed
+                vector<HostAndPort> hosts = configServer.getConnectionString().getServers();
+                string host = hosts[ hostIndex % hosts.size() ].toString();
+
+                try {
+                    ScopedDbConnection conn( host, 30.0 );
+
+                    if ( ! haveLastSeen ) {
+                        BSONObj newest = conn->findOne( ChangelogType::ConfigNS,
+                                                        Query().sort( BSON( "$natural" << -1 ) ) );
+                        if ( ! newest.isEmpty() )
+                            lastSeen = newest[ChangelogType::time()].date();
+                        haveLastSeen = true;
+                    }
+
+                    // $gte so the cursor stays alive; applying the newest entry again is harmless
+                    Query query = QUERY( ChangelogType::time() << GTE << lastSeen );
+                    query.sort( BSON( "$natural" << 1 ) );
+                    auto_ptr<DBClientCursor> cursor =
+                        conn->query( ChangelogType::ConfigNS, query, 0, 0, 0,
+                                     QueryOption_CursorTailable | QueryOption_AwaitData );
+
+                    while ( ! inShutdown() && cursor.get() && ! cursor->isDead() ) {
+                        // blocks on the config server for a while when there's nothing new
+                        if ( ! cursor->more() )
+                            continue;
+
+                        BSONObj entry = cursor->nextSafe();
+                        lastSeen = entry[ChangelogType::time()].date();
+
+                        try {
+                            applyChange( entry );
+                        }
+                        catch ( DBException& e ) {
+                            warning() << "couldn't apply config change " << entry << causedBy( e )
+                                      << endl;
+                        }
+                    }
+
+                    conn.done();
+                }
+                catch ( DBException& e ) {
+                    LOG(1) << "error following config changelog on " << host << causedBy( e )
+                           << endl;
+                    hostIndex++;
+                }
+
+                sleepsecs( 1 );
+            }
+        }
+    }
+
+    void startConfigChangeWatcher() {
+        if ( ! watchConfigChanges )
+            return;
+
+        if ( _watcherThread == NULL ) {
+            _watcherThread.reset( new boost::thread( watchChanges ) );
+        }
+    }
+}
@@ -32,9 +32,11 @@
 
 #include "mongo/s/cursors.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
@@ -43,13 +45,27 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/client/connpool.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/net/listen.h"
 
 namespace mongo {
     const int ShardedClientCursor::INIT_REPLY_BUFFER_SIZE = 32768;
 
+    // Once the sharded cursors hold more than this many MB of shard replies, the longest idle
+    // ones are killed.  0 is no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( shardedCursorBufferLimitMB, int, 0 );
+
+    static Counter64 bufferedBytesTotal;
+    static ServerStatusMetricField<Counter64> displayBufferedBytes( "cursor.sharded.bufferedBytes",
+                                                                    &bufferedBytesTotal );
+
+    static Counter64 killedForMemory;
+    static ServerStatusMetricField<Counter64> displayKilledForMemory(
+            "cursor.sharded.killedForMemory", &killedForMemory );
+
     // --------  ShardedCursor -----------
 
     ShardedClientCursor::ShardedClientCursor( QueryMessage& q , ClusteredCursor * cursor ) {
@@ -75,6 +91,7 @@ namespace mongo {
         verify( _cursor );
         delete _cursor;
         _cursor = 0;
+        bufferedBytesTotal.decrement( _bufferedBytes.load() );
     }
 
     long long ShardedClientCursor::getId() {
@@ -160,6 +177,14 @@ namespace mongo {
         _totalSent += docCount;
         _done = ! hasMore;
 
+        // the replies the shard cursors still hold stay alive while this cursor is idle
+        long long buffered = _cursor->bufferedBytes();
+        long long previous = _bufferedBytes.swap( buffered );
+        if ( buffered > previous )
+            bufferedBytesTotal.increment( buffered - previous );
+        else
+            bufferedBytesTotal.decrement( previous - buffered );
+
         return hasMore;
     }
 
@@ -173,30 +198,37 @@ namespace mongo {
     }
 
     CursorCache::CursorCache()
-        :_mutex( "CursorCache" ),
-         _random( getCCRandomSeed() ),
-         _shardedTotal(0) {
+        :_randomMutex( "CursorCacheRandom" ),
+         _random( getCCRandomSeed() ) {
     }
 
     CursorCache::~CursorCache() {
         // TODO: delete old cursors?
+        size_t sharded = 0;
+        size_t refs = 0;
+        for ( int p = 0; p < NumPartitions; p++ ) {
+            verify( _partitions[p].refs.size() == _partitions[p].refsNS.size() );
+            sharded += _partitions[p].cursors.size();
+            refs += _partitions[p].refs.size();
+        }
+
         bool print = logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1));
-        if ( _cursors.size() || _refs.size() )
+        if ( sharded || refs )
             print = true;
-        verify(_refs.size() == _refsNS.size());
-        
+
         if ( print ) 
             log() << " CursorCache at shutdown - "
-                  << " sharded: " << _cursors.size()
-                  << " passthrough: " << _refs.size()
+                  << " sharded: " << sharded
+                  << " passthrough: " << refs
                   << endl;
     }
 
     ShardedClientCursorPtr CursorCache::get( long long id ) const {
         LOG(_myLogLevel) << "CursorCache::get id: " << id << endl;
-        scoped_lock lk( _mutex );
-        MapSharded::const_iterator i = _cursors.find( id );
-        if ( i == _cursors.end() ) {
+        Partition& partition = _partition( id );
+        scoped_lock lk( partition.mutex );
+        MapSharded::const_iterator i = partition.cursors.find( id );
+        if ( i == partition.cursors.end() ) {
             OCCASIONALLY log() << "Sharded CursorCache missing cursor id: " << id << endl;
             return ShardedClientCursorPtr();
         }
@@ -207,52 +239,58 @@ namespace mongo {
     void CursorCache::store( ShardedClientCursorPtr cursor ) {
         LOG(_myLogLevel) << "CursorCache::store cursor " << " id: " << cursor->getId() << endl;
         verify( cursor->getId() );
-        scoped_lock lk( _mutex );
-        _cursors[cursor->getId()] = cursor;
-        _shardedTotal++;
+        Partition& partition = _partition( cursor->getId() );
+        scoped_lock lk( partition.mutex );
+        partition.cursors[cursor->getId()] = cursor;
+        _shardedTotal.fetchAndAdd( 1 );
     }
     void CursorCache::remove( long long id ) {
         verify( id );
-        scoped_lock lk( _mutex );
-        _cursors.erase( id );
+        Partition& partition = _partition( id );
+        scoped_lock lk( partition.mutex );
+        partition.cursors.erase( id );
     }
     
     void CursorCache::removeRef( long long id ) {
         verify( id );
-        scoped_lock lk( _mutex );
-        _refs.erase( id );
-        _refsNS.erase( id );
+        Partition& partition = _partition( id );
+        scoped_lock lk( partition.mutex );
+        partition.refs.erase( id );
+        partition.refsNS.erase( id );
     }
 
     void CursorCache::storeRef(const std::string& server, long long id, const std::string& ns) {
         LOG(_myLogLevel) << "CursorCache::storeRef server: " << server << " id: " << id << endl;
         verify( id );
-        scoped_lock lk( _mutex );
-        _refs[id] = server;
-        _refsNS[id] = ns;
+        Partition& partition = _partition( id );
+        scoped_lock lk( partition.mutex );
+        partition.refs[id] = server;
+        partition.refsNS[id] = ns;
     }
 
     string CursorCache::getRef( long long id ) const {
         verify( id );
-        scoped_lock lk( _mutex );
-        MapNormal::const_iterator i = _refs.find( id );
+        Partition& partition = _partition( id );
+        scoped_lock lk( partition.mutex );
+        MapNormal::const_iterator i = partition.refs.find( id );
 
-        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == _refs.end() ? " NONE " : i->second ) << endl;
+        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == partition.refs.end() ? " NONE " : i->second ) << endl;
 
-        if ( i == _refs.end() )
+        if ( i == partition.refs.end() )
             return "";
         return i->second;
     }
 
     std::string CursorCache::getRefNS(long long id) const {
         verify(id);
-        scoped_lock lk(_mutex);
-        MapNormal::const_iterator i = _refsNS.find(id);
+        Partition& partition = _partition(id);
+        scoped_lock lk(partition.mutex);
+        MapNormal::const_iterator i = partition.refsNS.find(id);
 
         LOG(_myLogLevel) << "CursorCache::getRefNs id: " << id
-                << " out: " << ( i == _refsNS.end() ? " NONE " : i->second ) << std::endl;
+                << " out: " << ( i == partition.refsNS.end() ? " NONE " : i->second ) << std::endl;
 
-        if ( i == _refsNS.end() )
+        if ( i == partition.refsNS.end() )
             return "";
         return i->second;
     }
@@ -260,10 +298,11 @@ namespace mongo {
 
     long long CursorCache::genId() {
         while ( true ) {
-            scoped_lock lk( _mutex );
-
             long long x = Listener::getElapsedTimeMillis() << 32;
-            x |= _random.nextInt32();
+            {
+                scoped_lock lk( _randomMutex );
+                x |= _random.nextInt32();
+            }
 
             if ( x == 0 )
                 continue;
@@ -271,12 +310,15 @@ namespace mongo {
             if ( x < 0 )
                 x *= -1;
 
-            MapSharded::iterator i = _cursors.find( x );
-            if ( i != _cursors.end() )
+            Partition& partition = _partition( x );
+            scoped_lock lk( partition.mutex );
+
+            MapSharded::iterator i = partition.cursors.find( x );
+            if ( i != partition.cursors.end() )
                 continue;
 
-            MapNormal::iterator j = _refs.find( x );
-            if ( j != _refs.end() )
+            MapNormal::iterator j = partition.refs.find( x );
+            if ( j != partition.refs.end() )
                 continue;
 
             return x;
@@ -310,10 +352,11 @@ namespace mongo {
 
             string server;
             {
-                scoped_lock lk( _mutex );
+                Partition& partition = _partition( id );
+                scoped_lock lk( partition.mutex );
 
-                MapSharded::iterator i = _cursors.find( id );
-                if ( i != _cursors.end() ) {
+                MapSharded::iterator i = partition.cursors.find( id );
+                if ( i != partition.cursors.end() ) {
                     const bool isAuthorized = authSession->isAuthorizedForActionsOnNamespace(
                             NamespaceString(i->second->getNS()), ActionType::killCursors);
                     audit::logKillCursorsAuthzCheck(
@@ -322,18 +365,18 @@ namespace mongo {
                             id,
                             isAuthorized ? ErrorCodes::OK : ErrorCodes::Unauthorized);
                     if (isAuthorized) {
-                        _cursors.erase( i );
+                        partition.cursors.erase( i );
                     }
                     continue;
                 }
 
-                MapNormal::iterator refsIt = _refs.find(id);
-                MapNormal::iterator refsNSIt = _refsNS.find(id);
-                if (refsIt == _refs.end()) {
+                MapNormal::iterator refsIt = partition.refs.find(id);
+                MapNormal::iterator refsNSIt = partition.refsNS.find(id);
+                if (refsIt == partition.refs.end()) {
                     warning() << "can't find cursor: " << id << endl;
                     continue;
                 }
-                verify(refsNSIt != _refsNS.end());
+                verify(refsNSIt != partition.refsNS.end());
                 const bool isAuthorized = authSession->isAuthorizedForActionsOnNamespace(
                         NamespaceString(refsNSIt->second), ActionType::killCursors);
                 audit::logKillCursorsAuthzCheck(
@@ -345,8 +388,8 @@ namespace mongo {
                     continue;
                 }
                 server = refsIt->second;
-                _refs.erase(refsIt);
-                _refsNS.erase(refsNSIt);
+                partition.refs.erase(refsIt);
+                partition.refsNS.erase(refsNSIt);
             }
 
             LOG(_myLogLevel) << "CursorCache::found gotKillCursors id: " << id << " server: " << server << endl;
@@ -359,27 +402,77 @@ namespace mongo {
     }
 
     void CursorCache::appendInfo( BSONObjBuilder& result ) const {
-        scoped_lock lk( _mutex );
-        result.append( "sharded" , (int)_cursors.size() );
-        result.appendNumber( "shardedEver" , _shardedTotal );
-        result.append( "refs" , (int)_refs.size() );
-        result.append( "totalOpen" , (int)(_cursors.size() + _refs.size() ) );
+        int sharded = 0;
+        int refs = 0;
+        for ( int p = 0; p < NumPartitions; p++ ) {
+            scoped_lock lk( _partitions[p].mutex );
+            sharded += _partitions[p].cursors.size();
+            refs += _partitions[p].refs.size();
+        }
+        result.append( "sharded" , sharded );
+        result.appendNumber( "shardedEver" , _shardedTotal.load() );
+        result.append( "refs" , refs );
+        result.append( "totalOpen" , sharded + refs );
+        result.appendNumber( "shardedBufferedBytes" , bufferedBytesTotal.get() );
     }
 
     void CursorCache::doTimeouts() {
         long long now = Listener::getElapsedTimeMillis();
-        scoped_lock lk( _mutex );
-        for ( MapSharded::iterator i=_cursors.begin(); i!=_cursors.end(); ++i ) {
-            // Note: cursors with no timeout will always have an idleTime of 0
-            long long idleFor = i->second->idleTime( now );
-            if ( idleFor < TIMEOUT ) {
-                continue;
+        for ( int p = 0; p < NumPartitions; p++ ) {
+            // the cursors are destroyed once the lock is released
+            vector<ShardedClientCursorPtr> killed;
+            Partition& partition = _partitions[p];
+            scoped_lock lk( partition.mutex );
+            for ( MapSharded::iterator i = partition.cursors.begin(); i != partition.cursors.end(); ) {
+                // Note: cursors with no timeout will always have an idleTime of 0
+                long long idleFor = i->second->idleTime( now );
+                if ( idleFor < TIMEOUT ) {
+                    ++i;
+                    continue;
+                }
+                log() << "killing old cursor " << i->second->getId() << " idle for: " << idleFor << "ms" << endl; // TODO: make LOG(1)
+                killed.push_back( i->second );
+                partition.cursors.erase( i++ );
             }
-            log() << "killing old cursor " << i->second->getId() << " idle for: " << idleFor << "ms" << endl; // TODO: make LOG(1)
-            _cursors.erase( i );
-            i = _cursors.begin(); // possible 2nd entry will get skipped, will get on next pass
-            if ( i == _cursors.end() )
-                break;
+        }
+
+        _killForMemory( now );
+    }
+
+    void CursorCache::_killForMemory( long long now ) {
+        const long long limit = static_cast<long long>( shardedCursorBufferLimitMB ) * 1024 * 1024;
+        if ( limit <= 0 || bufferedBytesTotal.get() <= limit )
+            return;
+
+        // longest idle first; cursors with no timeout have no idle time, so they go last
+        vector< pair<long long, long long> > byIdle;
+        for ( int p = 0; p < NumPartitions; p++ ) {
+            scoped_lock lk( _partitions[p].mutex );
+            for ( MapSharded::const_iterator i = _partitions[p].cursors.begin();
+                  i != _partitions[p].cursors.end(); ++i ) {
+                if ( i->second->bufferedBytes() == 0 )
+                    continue;
+                byIdle.push_back( make_pair( -i->second->idleTime( now ), i->first ) );
+            }
+        }
+        std::sort( byIdle.begin(), byIdle.end() );
+
+        for ( size_t i = 0; i < byIdle.size() && bufferedBytesTotal.get() > limit; i++ ) {
+            long long id = byIdle[i].second;
+            ShardedClientCursorPtr cursor;
+            {
+                Partition& partition = _partition( id );
+                scoped_lock lk( partition.mutex );
+                MapSharded::iterator it = partition.cursors.find( id );
+                if ( it == partition.cursors.end() )
+                    continue;
+                cursor = it->second;
+                partition.cursors.erase( it );
+            }
+            log() << "killing cursor " << id << " holding " << cursor->bufferedBytes()
+                  << " bytes, over shardedCursorBufferLimitMB: " << shardedCursorBufferLimitMB
+                  << endl;
+            killedForMemory.increment();
         }
     }
 
@@ -37,6 +37,7 @@
 #include "mongo/client/parallel.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/random.h"
 #include "mongo/s/request.h"
 
@@ -79,6 +80,12 @@ namespace mongo {
         /** @return idle time in ms */
         long long idleTime( long long now );
 
+        /**
+         * @return the bytes of shard replies this cursor held at the end of its last batch.
+         * Safe to call while another thread is using the cursor.
+         */
+        long long bufferedBytes() const { return _bufferedBytes.load(); }
+
         std::string getNS() { return _cursor->getNS(); }
 
         // The default initial buffer size for sending responses.
@@ -97,10 +104,17 @@ namespace mongo {
         long long _id;
         long long _lastAccessMillis; // 0 means no timeout
 
+        AtomicInt64 _bufferedBytes;
     };
 
     typedef boost::shared_ptr<ShardedClientCursor> ShardedClientCursorPtr;
 
+    /**
+     * The cursors mongos holds open for clients: sharded cursors it merges itself, and refs
+     * to cursors it passes through to a single shard.  The maps are split into partitions by
+     * cursor id, each with its own mutex, so that getMores on different cursors don't
+     * contend.
+     */
     class CursorCache {
     public:
 
@@ -130,18 +144,37 @@ namespace mongo {
 
         long long genId();
 
+        /**
+         * Kills cursors idle for longer than TIMEOUT, then, if the sharded cursors hold more
+         * than shardedCursorBufferLimitMB of shard replies, the longest idle ones until they
+         * don't.
+         */
         void doTimeouts();
         void startTimeoutThread();
     private:
-        mutable mongo::mutex _mutex;
+        enum { NumPartitions = 16 };
+
+        struct Partition {
+            Partition() : mutex( "CursorCache" ) {}
 
+            mongo::mutex mutex;
+            MapSharded cursors;
+            MapNormal refs; // Maps cursor ID to shard name
+            MapNormal refsNS; // Maps cursor ID to namespace
+        };
+
+        Partition& _partition( long long id ) const {
+            return _partitions[ static_cast<unsigned long long>( id ) % NumPartitions ];
+        }
+
+        void _killForMemory( long long now );
+
+        mutable Partition _partitions[NumPartitions];
+
+        mongo::mutex _randomMutex;
         PseudoRandom _random;
 
-        MapSharded _cursors;
-        MapNormal _refs; // Maps cursor ID to shard name
-        MapNormal _refsNS; // Maps cursor ID to namespace
-        
-        long long _shardedTotal;
+        AtomicInt64 _shardedTotal;
 
         static const int _myLogLevel;
     };
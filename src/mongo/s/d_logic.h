@@ -295,6 +295,13 @@ namespace mongo {
         static void reset();
         static void addHook();
 
+        /**
+         * Detaches this thread's info without destroying it, and installs a detached info on the
+         * calling thread.  Used when a client connection moves between threads.
+         */
+        static ShardedConnectionInfo* release();
+        static void install( ShardedConnectionInfo* info );
+
         bool inForceVersionOkMode() const {
             return _forceVersionOk;
         }
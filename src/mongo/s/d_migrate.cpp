@@ -1472,6 +1472,48 @@ namespace mongo {
        commend to "commit"
     */
 
+    /**
+     * Runs one _migrateClone on its own thread, so that the donor can read the next batch while
+     * the recipient is still inserting the previous one. The connection must not be used by
+     * anyone else until wait() returns.
+     */
+    class CloneBatchFetcher : boost::noncopyable {
+    public:
+        explicit CloneBatchFetcher( DBClientBase* conn ) : _conn( conn ), _ok( false ) {
+            _thread.reset( new boost::thread( boost::bind( &CloneBatchFetcher::run, this ) ) );
+        }
+
+        ~CloneBatchFetcher() {
+            // the thread uses the connection and this object, so it can't outlive either
+            if ( _thread )
+                _thread->join();
+        }
+
+        /** Waits for the batch. On failure returns false, and 'res' holds the error. */
+        bool wait( BSONObj* res ) {
+            _thread->join();
+            _thread.reset();
+            *res = _res;
+            return _ok;
+        }
+
+    private:
+        void run() {
+            try {
+                _ok = _conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , _res );
+            }
+            catch ( std::exception& e ) {
+                _ok = false;
+                _res = BSON( "errmsg" << e.what() );
+            }
+        }
+
+        DBClientBase* const _conn;
+        scoped_ptr<boost::thread> _thread;
+        bool _ok;
+        BSONObj _res;
+    };
+
     class MigrateStatus {
     public:
         
@@ -1624,9 +1666,13 @@ namespace mongo {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                // gets array of objects to copy, in disk order
+                scoped_ptr<CloneBatchFetcher> fetcher( new CloneBatchFetcher( conn.get() ) );
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    bool ok = fetcher->wait( &res );
+                    fetcher.reset();
+                    if ( ! ok ) {
                         state = FAIL;
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1638,6 +1684,10 @@ namespace mongo {
                     BSONObj arr = res["objects"].Obj();
                     int thisTime = 0;
 
+                    // ask for the next batch while this one is inserted
+                    if ( ! arr.isEmpty() )
+                        fetcher.reset( new CloneBatchFetcher( conn.get() ) );
+
                     BSONObjIterator i( arr );
                     while( i.more() ) {
                         BSONObj o = i.next().Obj();
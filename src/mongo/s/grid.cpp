@@ -53,6 +53,16 @@ namespace mongo {
 
     MONGO_FP_DECLARE(neverBalance);
 
+    DBConfigPtr Grid::getDBConfigIfLoaded( const StringData& ns ) {
+        string database = nsToDatabase( ns );
+
+        scoped_lock l( _lock );
+        map<string, DBConfigPtr>::const_iterator i = _databases.find( database );
+        if ( i == _databases.end() )
+            return DBConfigPtr();
+        return i->second;
+    }
+
     DBConfigPtr Grid::getDBConfig( const StringData& ns , bool create , const string& shardNameHint ) {
         string database = nsToDatabase( ns );
 
@@ -76,6 +76,12 @@ namespace mongo {
          */
         void removeDBIfExists( const DBConfig& database );
 
+        /**
+         * @return the config for the db of 'ns' if it has already been loaded, otherwise an
+         * empty pointer.  Never contacts the config servers.
+         */
+        DBConfigPtr getDBConfigIfLoaded( const StringData& ns );
+
         /**
          * @return true if shards and config servers are allowed to use 'localhost' in address
          */
@@ -46,11 +46,13 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/log_process_details.h"
+#include "mongo/logger/async_file_writer.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/balance.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
+#include "mongo/s/config_change_watcher.h"
 #include "mongo/s/config_server_checker_service.h"
 #include "mongo/s/config_upgrade.h"
 #include "mongo/s/cursors.h"
@@ -170,6 +172,39 @@ namespace mongo {
         virtual void disconnected( AbstractMessagingPort* p ) {
             // all things are thread local
         }
+
+        virtual bool supportsParking() const { return true; }
+
+        virtual ParkedConnectionState* park( AbstractMessagingPort* p ) {
+            return new ParkedClient();
+        }
+
+    private:
+        /** A connection's ClientInfo and shard connections while no thread is serving it. */
+        class ParkedClient : public ParkedConnectionState {
+        public:
+            ParkedClient() :
+                _info( ClientInfo::release() ),
+                _connections( ShardConnection::detachMyConnections() ) {
+            }
+
+            virtual ~ParkedClient() {
+                ShardConnection::deleteConnections( _connections );
+                delete _info;
+            }
+
+            virtual void resume() {
+                if ( _info )
+                    ClientInfo::install( _info );
+                _info = NULL;
+                ShardConnection::attachMyConnections( _connections );
+                _connections = NULL;
+            }
+
+        private:
+            ClientInfo* _info;
+            ClientConnections* _connections;
+        };
     };
 
     void sighandler(int sig) {
@@ -295,6 +330,7 @@ static bool runMongosServer( bool doUpgrade ) {
     }
 
     startConfigServerChecker();
+    startConfigChangeWatcher();
 
     VersionType initVersionInfo;
     VersionType versionInfo;
@@ -337,6 +373,8 @@ static bool runMongosServer( bool doUpgrade ) {
     MessageServer::Options opts;
     opts.port = serverGlobalParams.port;
     opts.ipList = serverGlobalParams.bind_ip;
+    opts.pooled = serverGlobalParams.pooledServiceExecutor;
+    opts.poolThreads = serverGlobalParams.serviceExecutorThreads;
     start(opts);
 
     // listen() will return when exit code closes its socket.
@@ -505,6 +543,7 @@ void mongo::dbexit( ExitCode rc, const char *why ) {
           << " rc:" << rc
           << " " << ( why ? why : "" )
           << endl;
+    logger::AsyncFileWriter::flushAll();
     flushForGcov();
     ::_exit(rc);
 }
@@ -36,6 +36,7 @@
 
 namespace mongo {
 
+    class ClientConnections;
     class ShardConnection;
     class ShardStatus;
 
@@ -319,6 +320,16 @@ namespace mongo {
          */
         static void clearPool();
 
+        /**
+         * Detaches this thread's cached shard connections without closing them, so that they can
+         * follow a parked client connection to another thread.  attachMyConnections() installs
+         * them on the calling thread, which must not have any of its own; deleteConnections()
+         * disposes of a set which is never reattached.
+         */
+        static ClientConnections* detachMyConnections();
+        static void attachMyConnections( ClientConnections* connections );
+        static void deleteConnections( ClientConnections* connections );
+
         /**
          * Forgets a namespace to prevent future versioning.
          */
@@ -352,6 +352,15 @@ namespace mongo {
             }
             return cc;
         }
+
+        static ClientConnections* releaseThreadInstance() {
+            return _perThread.release();
+        }
+
+        static void installThreadInstance( ClientConnections* cc ) {
+            verify( ! _perThread.get() );
+            _perThread.reset( cc );
+        }
     };
 
     thread_specific_ptr<ClientConnections> ClientConnections::_perThread;
@@ -497,6 +506,22 @@ namespace mongo {
         true
     );
 
+    ExportedServerParameter<int> ConnPoolMaxIdleSecs(
+        ServerParameterSet::getGlobal(),
+        "connPoolMaxIdleSecs",
+        &PoolForHost::maxIdleSecs,
+        true,
+        true
+    );
+
+    ExportedServerParameter<int> ConnPoolMinIdlePerHost(
+        ServerParameterSet::getGlobal(),
+        "connPoolMinIdlePerHost",
+        &PoolForHost::minIdlePerHost,
+        true,
+        true
+    );
+
     void ShardConnection::releaseMyConnections() {
         ClientConnections::threadInstance()->releaseAll();
     }
@@ -506,6 +531,19 @@ namespace mongo {
         ClientConnections::threadInstance()->clearPool();
     }
 
+    ClientConnections* ShardConnection::detachMyConnections() {
+        return ClientConnections::releaseThreadInstance();
+    }
+
+    void ShardConnection::attachMyConnections( ClientConnections* connections ) {
+        if ( connections )
+            ClientConnections::installThreadInstance( connections );
+    }
+
+    void ShardConnection::deleteConnections( ClientConnections* connections ) {
+        delete connections;
+    }
+
     void ShardConnection::forgetNS( const string& ns ) {
         ClientConnections::threadInstance()->forgetNS( ns );
     }
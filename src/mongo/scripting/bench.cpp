@@ -25,9 +25,11 @@
 #include <boost/thread/thread.hpp>
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/scripting/bson_template_evaluator.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/md5.h"
+#include "mongo/util/time_support.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 
@@ -65,11 +67,46 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        memset(_latency, 0, sizeof(_latency));
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        for (int i = 0; i < kNumBuckets; ++i)
+            _latency[i] += other._latency[i];
+    }
+
+    int BenchRunEventCounter::latencyBucket(unsigned long long micros) {
+        if (micros < kSubBuckets)
+            return static_cast<int>(micros);
+
+        int topBit = kSubBucketBits;
+        while ((micros >> (topBit + 1)) != 0)
+            ++topBit;
+        const int shift = topBit - kSubBucketBits;
+        const int bucket = kSubBuckets * (shift + 1) +
+                           static_cast<int>((micros >> shift) & (kSubBuckets - 1));
+        return std::min(bucket, kNumBuckets - 1);
+    }
+
+    unsigned long long BenchRunEventCounter::bucketUpperBound(int bucket) {
+        if (bucket < kSubBuckets)
+            return bucket + 1;
+        const int shift = bucket / kSubBuckets - 1;
+        const unsigned long long sub = bucket % kSubBuckets;
+        return (kSubBuckets + sub + 1) << shift;
+    }
+
+    unsigned long long BenchRunEventCounter::getPercentileMicros(double percent) const {
+        const double rank = _numEvents * percent / 100;
+        unsigned long long seen = 0;
+        for (int i = 0; i < kNumBuckets; ++i) {
+            seen += _latency[i];
+            if (seen > 0 && seen >= rank)
+                return bucketUpperBound(i);
+        }
+        return 0;
     }
 
     BenchRunStats::BenchRunStats() {
@@ -87,6 +124,8 @@ namespace mongo {
         insertCounter.reset();
         deleteCounter.reset();
         queryCounter.reset();
+        aggregateCounter.reset();
+        getMoreCounter.reset();
 
         trappedErrors.clear();
     }
@@ -101,6 +140,8 @@ namespace mongo {
         insertCounter.updateFrom(other.insertCounter);
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
+        aggregateCounter.updateFrom(other.aggregateCounter);
+        getMoreCounter.updateFrom(other.getMoreCounter);
 
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
@@ -118,6 +159,7 @@ namespace mongo {
 
         parallel = 1;
         seconds = 1;
+        opsPerSecond = 0;
         hideResults = true;
         handleErrors = false;
         hideErrors = false;
@@ -155,6 +197,8 @@ namespace mongo {
             this->parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             this->seconds = args["seconds"].number();
+        if ( args["opsPerSecond"].isNumber() )
+            this->opsPerSecond = args["opsPerSecond"].number();
         if ( ! args["hideResults"].eoo() )
             this->hideResults = args["hideResults"].trueValue();
         if ( ! args["handleErrors"].eoo() )
@@ -295,6 +339,38 @@ namespace mongo {
         return b.obj();
     }
 
+    /**
+     * Applies fixQuery to each object in "arr", for lists of documents or pipeline stages.
+     */
+    static BSONArray fixArray( const BSONObj& arr, BsonTemplateEvaluator& btl ) {
+        BSONArrayBuilder b( arr.objsize() + 128 );
+        BSONObjIterator i( arr );
+        while ( i.more() )
+            b.append( fixQuery( i.next().Obj(), btl ) );
+        return b.arr();
+    }
+
+    /**
+     * Iterates "cursor" to the end, recording each getMore round trip in "getMoreCounter".
+     *
+     * @return the number of documents returned
+     */
+    static int drainCursor( DBClientCursor* cursor, BenchRunEventCounter* getMoreCounter ) {
+        int count = 0;
+        while ( true ) {
+            if ( ! cursor->moreInCurrentBatch() ) {
+                if ( cursor->getCursorId() == 0 )
+                    break;
+                BenchRunEventTrace _bret(getMoreCounter);
+                if ( ! cursor->more() )
+                    break;
+            }
+            cursor->nextSafe();
+            count++;
+        }
+        return count;
+    }
+
     BenchRunWorker::BenchRunWorker(const BenchRunConfig *config, BenchRunState *brState)
         : _config(config), _brState(brState) {
     }
@@ -318,12 +394,28 @@ namespace mongo {
 
         BsonTemplateEvaluator bsonTemplateEvaluator;
 
+        // open loop: this thread's share of opsPerSecond, as the micros between due times
+        const double opIntervalMicros = _config->opsPerSecond > 0 ?
+            1000 * 1000 * _config->parallel / _config->opsPerSecond : 0;
+        double nextOpDueMicros = 0;
+
         while ( !shouldStop() ) {
             BSONObjIterator i( _config->ops );
             while ( i.more() ) {
 
                 if ( shouldStop() ) break;
 
+                unsigned long long lagMicros = 0;
+                if ( opIntervalMicros > 0 ) {
+                    long long now = timer.micros();
+                    long long due = static_cast<long long>( nextOpDueMicros );
+                    if ( now < due )
+                        sleepmicros( due - now );
+                    else
+                        lagMicros = now - due;
+                    nextOpDueMicros += opIntervalMicros;
+                }
+
                 BSONElement e = i.next();
 
                 string ns = e["ns"].String();
@@ -372,7 +464,7 @@ namespace mongo {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_stats.findOneCounter, lagMicros);
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -427,15 +519,15 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, lagMicros);
                             boost::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, lagMicros);
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
-                            count = cursor->itcount();
+                            count = drainCursor(cursor.get(), &_stats.getMoreCounter);
                         }
 
                         if ( expected >= 0 &&  count != expected ) {
@@ -468,7 +560,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_stats.updateCounter, lagMicros);
                             conn->update( ns, fixQuery( query, bsonTemplateEvaluator ), update,
                                           upsert , multi );
                             if (safe)
@@ -496,13 +588,42 @@ namespace mongo {
                     }
                     else if( op == "insert" ) {
                         bool safe = e["safe"].trueValue();
+                        bool writeCmd = e["writeCmd"].trueValue();
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
-                            conn->insert( ns, fixQuery( e["doc"].Obj(), bsonTemplateEvaluator ) );
-                            if (safe)
+                            BenchRunEventTrace _bret(&_stats.insertCounter, lagMicros);
+                            if ( e["docs"].eoo() ) {
+                                conn->insert( ns, fixQuery( e["doc"].Obj(),
+                                                            bsonTemplateEvaluator ) );
+                            }
+                            else if ( writeCmd ) {
+                                // one insert write command for the whole batch; its reply
+                                // stands in for getLastError
+                                BSONObjBuilder cmd;
+                                cmd.append( "insert", nsToCollectionSubstring( ns ) );
+                                cmd.append( "documents",
+                                            fixArray( e["docs"].Obj(), bsonTemplateEvaluator ) );
+                                conn->runCommand( nsToDatabase( ns ), cmd.obj(), result );
+                                if ( ! result["ok"].trueValue() ) {
+                                    BSONObjBuilder err;
+                                    err.append( "err", result["errMessage"].str() );
+                                    err.append( "code", result["errCode"].numberInt() );
+                                    result = err.obj();
+                                }
+                            }
+                            else {
+                                BSONArray docs = fixArray( e["docs"].Obj(),
+                                                           bsonTemplateEvaluator );
+                                vector<BSONObj> batch;
+                                BSONObjIterator i( docs );
+                                while ( i.more() )
+                                    batch.push_back( i.next().Obj() );
+                                conn->insert( ns, batch );
+                            }
+                            if ( safe && ! writeCmd )
                                 result = conn->getLastErrorDetailed();
                         }
+                        safe = safe || writeCmd;
 
                         if( safe ){
                             if( check ){
@@ -531,7 +652,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_stats.deleteCounter, lagMicros);
                             conn->remove( ns, fixQuery( query, bsonTemplateEvaluator ), ! multi );
                             if (safe)
                                 result = conn->getLastErrorDetailed();
@@ -556,6 +677,55 @@ namespace mongo {
                                                    result["code"].eoo() ? 0 : result["code"].Int() );
                         }
                     }
+                    else if ( op == "aggregate" ) {
+
+                        int batchSize = e["batchSize"].eoo() ? 0 : e["batchSize"].numberInt();
+                        int count = 0;
+
+                        BSONObjBuilder cmd;
+                        cmd.append( "aggregate", nsToCollectionSubstring( ns ) );
+                        cmd.append( "pipeline",
+                                    fixArray( e["pipeline"].Obj(), bsonTemplateEvaluator ) );
+                        BSONObjBuilder cursorSpec( cmd.subobjStart( "cursor" ) );
+                        if ( batchSize > 0 )
+                            cursorSpec.append( "batchSize", batchSize );
+                        cursorSpec.done();
+
+                        {
+                            BenchRunEventTrace _bret(&_stats.aggregateCounter, lagMicros);
+                            BSONObj result;
+                            if ( ! conn->runCommand( nsToDatabase( ns ), cmd.obj(), result ) ) {
+                                throw DBException( (string)"From benchRun aggregate" +
+                                                       causedBy( result["errmsg"].str() ),
+                                                   result["code"].numberInt() );
+                            }
+
+                            BSONObj cursorObj = result["cursor"].Obj();
+                            count = cursorObj["firstBatch"].Obj().nFields();
+                            long long cursorId = cursorObj["id"].numberLong();
+                            if ( cursorId != 0 ) {
+                                DBClientCursor cursor( conn, cursorObj["ns"].String(), cursorId,
+                                                       0, 0 );
+                                cursor.setBatchSize( batchSize );
+                                count += drainCursor( &cursor, &_stats.getMoreCounter );
+                            }
+                        }
+
+                        if( check ){
+                            BSONObj thisValue = BSON( "count" << count << "context" << context );
+                            int err = scope->invoke( scopeFunc , 0 , &thisValue, 1000 * 60 , false );
+                            if( err ){
+                                log() << "Error checking in benchRun thread [aggregate]" << causedBy( scope->getError() ) << endl;
+
+                                _stats.errCount++;
+
+                                return;
+                            }
+                        }
+
+                        if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [aggregate] : " << count << endl;
+
+                    }
                     else if ( op == "createIndex" ) {
                         conn->ensureIndex( ns , e["key"].Obj() , false , "" , false );
                     }
@@ -761,6 +931,19 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendPercentilesIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() > 0) {
+             BSONObjBuilder percentiles(buf.subobjStart(name));
+             percentiles.append("50", static_cast<long long>(counter.getPercentileMicros(50)));
+             percentiles.append("95", static_cast<long long>(counter.getPercentileMicros(95)));
+             percentiles.append("99", static_cast<long long>(counter.getPercentileMicros(99)));
+             percentiles.append("99.9", static_cast<long long>(counter.getPercentileMicros(99.9)));
+             percentiles.done();
+         }
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -787,6 +970,15 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "deleteLatencyAverageMicros", stats.deleteCounter);
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
+         appendAverageMicrosIfAvailable(buf, "aggregateLatencyAverageMicros", stats.aggregateCounter);
+         appendAverageMicrosIfAvailable(buf, "getMoreLatencyAverageMicros", stats.getMoreCounter);
+         appendPercentilesIfAvailable(buf, "findOneLatencyPercentilesMicros", stats.findOneCounter);
+         appendPercentilesIfAvailable(buf, "insertLatencyPercentilesMicros", stats.insertCounter);
+         appendPercentilesIfAvailable(buf, "deleteLatencyPercentilesMicros", stats.deleteCounter);
+         appendPercentilesIfAvailable(buf, "updateLatencyPercentilesMicros", stats.updateCounter);
+         appendPercentilesIfAvailable(buf, "queryLatencyPercentilesMicros", stats.queryCounter);
+         appendPercentilesIfAvailable(buf, "aggregateLatencyPercentilesMicros", stats.aggregateCounter);
+         appendPercentilesIfAvailable(buf, "getMoreLatencyPercentilesMicros", stats.getMoreCounter);
 
          {
              BSONObjIterator i( after );
@@ -85,6 +85,14 @@ namespace mongo {
          */
         double seconds;
 
+        /**
+         * Target rate of operations, summed over all threads.  When above 0, each thread issues
+         * its operations on a fixed schedule (open loop) rather than as soon as the previous one
+         * finishes, and an operation's latency counts from when it was due, so time spent behind
+         * schedule is not hidden.  0, the default, runs closed loop.
+         */
+        double opsPerSecond;
+
         bool hideResults;
         bool handleErrors;
         bool hideErrors;
@@ -142,8 +150,15 @@ namespace mongo {
         void countOne(unsigned long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            ++_latency[latencyBucket(timeMicros)];
         }
 
+        /**
+         * Get the latency in microseconds below which "percent" percent of the events fell, to
+         * within the 1/8 precision of the latency histogram.
+         */
+        unsigned long long getPercentileMicros(double percent) const;
+
         /**
          * Get the total number of microseconds ellapsed during all observed events.
          */
@@ -155,8 +170,18 @@ namespace mongo {
         unsigned long long getNumEvents() const { return _numEvents; }
 
     private:
+        /**
+         * The latency histogram is log-linear: below 8 micros each bucket is one microsecond,
+         * above that every power of two is split into 8 equal buckets.
+         */
+        enum { kSubBucketBits = 3, kSubBuckets = 1 << kSubBucketBits, kNumBuckets = 8 * 40 };
+
+        static int latencyBucket(unsigned long long micros);
+        static unsigned long long bucketUpperBound(int bucket);
+
         unsigned long long _numEvents;
         unsigned long long _totalTimeMicros;
+        unsigned long long _latency[kNumBuckets];
     };
 
     /**
@@ -174,18 +199,23 @@ namespace mongo {
      */
     class BenchRunEventTrace : private boost::noncopyable {
     public:
-        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter) {
+        /**
+         * @param lagMicros how long before now the event was due to start, which is counted as
+         *        part of its duration
+         */
+        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter,
+                                    unsigned long long lagMicros=0) : _lagMicros(lagMicros) {
             initialize(eventCounter, eventCounter, false);
         }
 
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
                            BenchRunEventCounter *failCounter,
-                           bool defaultToFailure=true) {
+                           bool defaultToFailure=true) : _lagMicros(0) {
             initialize(successCounter, failCounter, defaultToFailure);
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            (_succeeded ? _successCounter : _failCounter)->countOne(_lagMicros + _timer.micros());
         }
 
         void succeed() { _succeeded = true; }
@@ -201,6 +231,7 @@ namespace mongo {
         }
 
         Timer _timer;
+        unsigned long long _lagMicros;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
         bool _succeeded;
@@ -226,6 +257,10 @@ namespace mongo {
         BenchRunEventCounter insertCounter;
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
+        BenchRunEventCounter aggregateCounter;
+
+        // each getMore round trip made while draining a find or aggregate cursor
+        BenchRunEventCounter getMoreCounter;
 
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
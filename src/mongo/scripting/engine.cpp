@@ -24,6 +24,7 @@
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/scripting/bench.h"
 #include "mongo/util/file.h"
@@ -269,6 +270,12 @@ namespace mongo {
     }
 
 namespace {
+    // How many idle scopes are kept, and how many times a scope is handed out before it is
+    // discarded.  A pooled scope keeps the functions it compiled, so repeated $where, group and
+    // mapReduce functions skip compilation as long as their scope survives.
+    MONGO_EXPORT_SERVER_PARAMETER(scriptingPoolSize, int, 32);
+    MONGO_EXPORT_SERVER_PARAMETER(scriptingMaxScopeReuse, int, 100);
+
     class ScopeCache {
     public:
         ScopeCache() : _mutex("ScopeCache") {}
@@ -283,17 +290,21 @@ namespace {
                 return;
             }
 
-            if (scope->getTimesUsed() > kMaxScopeReuse)
+            if (scope->getTimesUsed() > scriptingMaxScopeReuse)
                 return; // used too many times to save
 
             if (!scope->getError().empty())
                 return; // not saving errored scopes
 
-            if (_pools.size() >= kMaxPoolSize) {
-                // prefer to keep recently-used scopes
-                _pools.pop_back();
+            if (scriptingPoolSize <= 0) {
+                _pools.clear();
+                return; // pooling is off
             }
 
+            // prefer to keep recently-used scopes
+            while (_pools.size() >= static_cast<size_t>(scriptingPoolSize))
+                _pools.pop_back();
+
             ScopeAndPool toStore = {scope, poolName};
             _pools.push_front(toStore);
         }
@@ -320,10 +331,8 @@ namespace {
             string poolName;
         };
 
-        // Note: if these numbers change, reconsider choice of datastructure for _pools
-        static const unsigned kMaxPoolSize = 10;
-        static const int kMaxScopeReuse = 10;
-
+        // Note: a deque scanned linearly is fine for the pool sizes that make sense; reconsider
+        // the datastructure if scriptingPoolSize gets into the thousands
         typedef deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
         Pools _pools;    // protected by _mutex
         mongo::mutex _mutex;
@@ -53,7 +53,7 @@ namespace mongo {
     static BSONObj unwrapBSONObj(V8Scope* scope, const v8::Handle<v8::Object>& obj) {
         // Warning: can't throw exceptions in this context.
         BSONHolder* holder = unwrapHolder(scope, obj);
-        return holder ? holder->_obj : BSONObj();
+        return holder ? holder->owned() : BSONObj();
     }
 
     static v8::Handle<v8::Object> unwrapObject(V8Scope* scope, const v8::Handle<v8::Object>& obj) {
@@ -64,11 +64,12 @@ namespace mongo {
         return obj->GetInternalField(1).As<v8::Object>();
     }
 
-    void V8Scope::wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly) {
+    void V8Scope::wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly,
+                                 const BSONObj& owner) {
         verify(LazyBsonFT()->HasInstance(obj));
 
         // Nothing below throws
-        BSONHolder* holder = new BSONHolder(data);
+        BSONHolder* holder = new BSONHolder(data, owner);
         holder->_readOnly = readOnly;
         holder->_scope = this;
         obj->SetInternalField(0, v8::External::New(holder)); // Holder
@@ -100,7 +101,7 @@ namespace mongo {
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
-            val = scope->mongoToV8Element(elmt, holder->_readOnly);
+            val = scope->mongoToV8Element(elmt, holder->_readOnly, holder->buffer());
 
             if (obj.objsize() > 128 || val->IsObject()) {
                 // Only cache if expected to help (large BSON) or is required due to js semantics
@@ -217,7 +218,7 @@ namespace mongo {
             BSONElement elmt = obj.getField(key);
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
-            val = scope->mongoToV8Element(elmt, holder->_readOnly);
+            val = scope->mongoToV8Element(elmt, holder->_readOnly, holder->buffer());
             realObject->Set(index, val);
 
             if (elmt.type() == mongo::Object || elmt.type() == mongo::Array) {
@@ -1334,7 +1335,8 @@ namespace mongo {
     /**
      * converts a BSONObj to a Lazy V8 object
      */
-    v8::Handle<v8::Object> V8Scope::mongoToLZV8(const BSONObj& m, bool readOnly) {
+    v8::Handle<v8::Object> V8Scope::mongoToLZV8(const BSONObj& m, bool readOnly,
+                                                const BSONObj& owner) {
         if (m.firstElementType() == String && str::equals(m.firstElementFieldName(), "$ref")) {
             BSONObjIterator it(m);
             const BSONElement ref = it.next();
@@ -1361,11 +1363,12 @@ namespace mongo {
                                         "v8 still executing."),
                        *o != NULL);
 
-        wrapBSONObject(o, m, readOnly);
+        wrapBSONObject(o, m, readOnly, owner);
         return o;
     }
 
-    v8::Handle<v8::Value> V8Scope::mongoToV8Element(const BSONElement &elem, bool readOnly) {
+    v8::Handle<v8::Value> V8Scope::mongoToV8Element(const BSONElement &elem, bool readOnly,
+                                                    const BSONObj& owner) {
         v8::Handle<v8::Value> argv[3];      // arguments for v8 instance constructors
         v8::Local<v8::Object> instance;     // instance of v8 type
         uint64_t nativeUnsignedLong;        // native representation of NumberLong
@@ -1397,12 +1400,12 @@ namespace mongo {
             v8::Handle<v8::Array> array = v8::Array::New();
             int i = 0;
             BSONForEach(subElem, elem.embeddedObject()) {
-                array->Set(i++, mongoToV8Element(subElem, readOnly));
+                array->Set(i++, mongoToV8Element(subElem, readOnly, owner));
             }
             return array;
         }
         case mongo::Object:
-            return mongoToLZV8(elem.embeddedObject(), readOnly);
+            return mongoToLZV8(elem.embeddedObject(), readOnly, owner);
         case mongo::Date:
             return v8::Date::New((double) ((long long)elem.date().millis));
         case mongo::Bool:
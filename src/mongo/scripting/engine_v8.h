@@ -228,10 +228,13 @@ namespace mongo {
                                                  ScriptingFunction functionNumber = 0);
 
         /**
-         * Convert BSON types to v8 Javascript types
+         * Convert BSON types to v8 Javascript types.  Embedded objects become lazy objects; when
+         * 'owner' is the owned document they lie in, they share its buffer rather than copy it.
          */
-        v8::Handle<v8::Object> mongoToLZV8(const mongo::BSONObj& m, bool readOnly = false);
-        v8::Handle<v8::Value> mongoToV8Element(const BSONElement& f, bool readOnly = false);
+        v8::Handle<v8::Object> mongoToLZV8(const mongo::BSONObj& m, bool readOnly = false,
+                                           const BSONObj& owner = BSONObj());
+        v8::Handle<v8::Value> mongoToV8Element(const BSONElement& f, bool readOnly = false,
+                                               const BSONObj& owner = BSONObj());
 
         /**
          * Convert v8 Javascript types to BSON types
@@ -343,7 +346,8 @@ namespace mongo {
          * Attach data to obj such that the data has the same lifetime as the Object obj points to.
          * obj must have been created by either LazyBsonFT or ROBsonFT.
          */
-        void wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly);
+        void wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly,
+                            const BSONObj& owner = BSONObj());
 
         /**
          * Trampoline to call a c++ function with a specific signature (V8Scope*, v8::Arguments&).
@@ -493,23 +497,39 @@ namespace mongo {
     class BSONHolder {
     MONGO_DISALLOW_COPYING(BSONHolder);
     public:
-        explicit BSONHolder(BSONObj obj) :
+        /**
+         * If 'owner' is an owned object whose buffer contains 'obj' (the holder of an enclosing
+         * document), 'obj' is used in place and 'owner' is kept alive instead of copying it.
+         */
+        explicit BSONHolder(BSONObj obj, const BSONObj& owner = BSONObj()) :
             _scope(NULL),
-            _obj(obj.getOwned()),
-            _modified(false) {
+            _owner(owner.isOwned() ? owner : BSONObj()),
+            _obj(owner.isOwned() ? obj : obj.getOwned()),
+            _modified(false),
+            _externalSize(owner.isOwned() ? 0 : _obj.objsize()) {
             // give hint v8's GC
-            v8::V8::AdjustAmountOfExternalAllocatedMemory(_obj.objsize());
+            if (_externalSize)
+                v8::V8::AdjustAmountOfExternalAllocatedMemory(_externalSize);
         }
         ~BSONHolder() {
-            if (_scope && _scope->getIsolate())
+            if (_externalSize && _scope && _scope->getIsolate())
                 // if v8 is still up, send hint to GC
-                v8::V8::AdjustAmountOfExternalAllocatedMemory(-_obj.objsize());
+                v8::V8::AdjustAmountOfExternalAllocatedMemory(-_externalSize);
         }
+
+        /** @return the owned object whose buffer _obj lies in, for nested holders to share */
+        const BSONObj& buffer() const { return _owner.isOwned() ? _owner : _obj; }
+
+        /** @return _obj, copied if it is a view into an enclosing document */
+        BSONObj owned() const { return _obj.getOwned(); }
+
         V8Scope* _scope;
+        BSONObj _owner;
         BSONObj _obj;
         bool _modified;
         bool _readOnly;
         set<string> _removed;
+        const int _externalSize;
     };
 
     /**
@@ -911,6 +911,19 @@ DBCollection.prototype.aggregateCursor = function(pipeline, extraOpts) {
     return new DBCommandCursor(this._mongo, cursorRes);
 }
 
+/**
+ * Returns up to numCursors cursors which together return every document of this collection.
+ * They can be read from concurrently, e.g. from parallel shells.
+ */
+DBCollection.prototype.parallelScan = function(numCursors) {
+    var res = this.runCommand("parallelCollectionScan", {numCursors: numCursors});
+    assert.commandWorked(res, "parallelCollectionScan failed");
+    var mongo = this._mongo;
+    return res.cursors.map(function(cursorRes) {
+        return new DBCommandCursor(mongo, cursorRes);
+    });
+}
+
 DBCollection.prototype.aggregate = function( ops ) {
     
     var arr = ops;
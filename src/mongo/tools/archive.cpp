@@ -0,0 +1,154 @@
+/*
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/tools/archive.h"
+
+#include <cstring>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+        const char archiveMagic[] = "mdbarch1";
+        const size_t archiveMagicLen = 8;
+
+        const int blockSize = 1024 * 1024;
+    }
+
+    ArchiveWriter::ArchiveWriter( FILE* out, bool compress ) : _out( out ), _compress( compress ) {
+        write( archiveMagic, archiveMagicLen );
+    }
+
+    void ArchiveWriter::writeBlock( const std::string& ns, const std::string& type,
+                                    const char* data, size_t len ) {
+        std::string compressed;
+        if ( _compress ) {
+            mongo::compress( data, len, &compressed );
+            data = compressed.data();
+            len = compressed.size();
+        }
+
+        BSONObjBuilder b;
+        b.append( "ns", ns );
+        b.append( "type", type );
+        b.append( "len", static_cast<int>( len ) );
+        b.appendBool( "compressed", _compress );
+        BSONObj header = b.done();
+
+        boost::mutex::scoped_lock lk( _mutex );
+        write( header.objdata(), header.objsize() );
+        write( data, len );
+    }
+
+    void ArchiveWriter::finish() {
+        BSONObj eof = BSON( "eof" << true );
+        boost::mutex::scoped_lock lk( _mutex );
+        write( eof.objdata(), eof.objsize() );
+        uassert( 17305, errnoWithPrefix( "couldn't flush archive" ), fflush( _out ) == 0 );
+    }
+
+    void ArchiveWriter::write( const char* data, size_t len ) {
+        while ( len ) {
+            size_t ret = fwrite( data, 1, len, _out );
+            uassert( 17306, errnoWithPrefix( "couldn't write archive" ), ret );
+            data += ret;
+            len -= ret;
+        }
+    }
+
+    ArchiveWriter::CollectionWriter::CollectionWriter( ArchiveWriter* archive,
+                                                       const std::string& ns,
+                                                       const std::string& type )
+        : _archive( archive ), _ns( ns ), _type( type ), _buf( blockSize ) {
+    }
+
+    void ArchiveWriter::CollectionWriter::add( const BSONObj& obj ) {
+        if ( _buf.len() > 0 && _buf.len() + obj.objsize() > blockSize )
+            done();
+        _buf.appendBuf( obj.objdata(), obj.objsize() );
+    }
+
+    void ArchiveWriter::CollectionWriter::done() {
+        if ( _buf.len() == 0 )
+            return;
+        _archive->writeBlock( _ns, _type, _buf.buf(), _buf.len() );
+        _buf.reset();
+    }
+
+    ArchiveReader::ArchiveReader( FILE* in ) : _in( in ) {
+        char magic[archiveMagicLen];
+        read( magic, archiveMagicLen );
+        uassert( 17307, "not a dump archive", memcmp( magic, archiveMagic, archiveMagicLen ) == 0 );
+    }
+
+    bool ArchiveReader::next( Block* block ) {
+        int size;
+        read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+        uassert( 17308, str::stream() << "invalid archive block header size: " << size,
+                 size >= 5 && size <= BSONObjMaxUserSize );
+
+        std::string headerBuf( size, '\0' );
+        memcpy( &headerBuf[0], &size, sizeof( size ) );
+        read( &headerBuf[sizeof( size )], size - sizeof( size ) );
+        BSONObj header( headerBuf.data() );
+
+        if ( header["eof"].trueValue() )
+            return false;
+
+        block->ns = header["ns"].str();
+        block->type = header["type"].str();
+        int len = header["len"].numberInt();
+        uassert( 17309, str::stream() << "invalid archive block length: " << len, len >= 0 );
+
+        std::string payload( len, '\0' );
+        if ( len > 0 )
+            read( &payload[0], len );
+
+        if ( header["compressed"].trueValue() ) {
+            block->data.clear();
+            uassert( 17310, "couldn't uncompress archive block",
+                     uncompress( payload.data(), payload.size(), &block->data ) );
+        }
+        else {
+            block->data.swap( payload );
+        }
+        return true;
+    }
+
+    bool ArchiveReader::isArchive( const std::string& path ) {
+        FILE* f = fopen( path.c_str(), "rb" );
+        if ( !f )
+            return false;
+        char magic[archiveMagicLen];
+        bool ret = fread( magic, 1, archiveMagicLen, f ) == archiveMagicLen &&
+                   memcmp( magic, archiveMagic, archiveMagicLen ) == 0;
+        fclose( f );
+        return ret;
+    }
+
+    void ArchiveReader::read( char* data, size_t len ) {
+        while ( len ) {
+            size_t ret = fread( data, 1, len, _in );
+            uassert( 17311, "unexpected end of archive", ret );
+            data += ret;
+            len -= ret;
+        }
+    }
+
+}
@@ -0,0 +1,105 @@
+/*
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstdio>
+#include <string>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A dump archive multiplexes all the collections of a dump into one stream, so that
+     * mongodump can write to a pipe, and mongorestore read from one, without staging files.
+     *
+     * The stream is the 8 byte magic "mdbarch1" followed by blocks.  Each block is a BSON
+     * header { ns: <namespace>, type: <type>, len: <int>, compressed: <bool> } and then "len"
+     * bytes of payload, snappy compressed when "compressed" is set.  The types are:
+     *     "metadata"  the collection's metadata document, as in a .metadata.json file
+     *     "data"      some of the collection's documents, back to back as in a .bson file
+     *     "oplog"     like "data", for the oplog entries of an --oplog dump
+     * A collection's metadata block comes before its data blocks; the data blocks of different
+     * collections may be interleaved.  A header of { eof: true } ends the stream.
+     */
+    class ArchiveWriter : boost::noncopyable {
+    public:
+        /** Writes the magic to "out", which the caller closes after finish(). */
+        ArchiveWriter( FILE* out, bool compress );
+
+        /** Writes one block.  Thread safe; the payload is compressed before locking. */
+        void writeBlock( const std::string& ns, const std::string& type,
+                         const char* data, size_t len );
+
+        /** Writes the end of stream header and flushes. */
+        void finish();
+
+        /**
+         * Groups one collection's documents into data blocks of about 1MB.  Not thread safe; a
+         * thread dumping a collection has its own.
+         */
+        class CollectionWriter : boost::noncopyable {
+        public:
+            CollectionWriter( ArchiveWriter* archive, const std::string& ns,
+                              const std::string& type = "data" );
+
+            void add( const BSONObj& obj );
+
+            /** Writes the last, partial block. */
+            void done();
+
+        private:
+            ArchiveWriter* _archive;
+            const std::string _ns;
+            const std::string _type;
+            BufBuilder _buf;
+        };
+
+    private:
+        void write( const char* data, size_t len );
+
+        boost::mutex _mutex;
+        FILE* _out;
+        const bool _compress;
+    };
+
+    class ArchiveReader : boost::noncopyable {
+    public:
+        struct Block {
+            std::string ns;
+            std::string type;
+            std::string data;
+        };
+
+        /** Reads and checks the magic from "in", which the caller closes. */
+        explicit ArchiveReader( FILE* in );
+
+        /** @return false at the end of the stream */
+        bool next( Block* block );
+
+        /** @return true if the file at "path" starts with the archive magic */
+        static bool isArchive( const std::string& path );
+
+    private:
+        void read( char* data, size_t len );
+
+        FILE* _in;
+    };
+
+}
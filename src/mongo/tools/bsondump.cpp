@@ -16,9 +16,11 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <fcntl.h>
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/tools/archive.h"
 #include "mongo/tools/bsondump_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/mmap.h"
@@ -57,10 +59,36 @@ public:
             return 1;
         }
 
+        if ( root == "-" || ArchiveReader::isArchive( root.string() ) ) {
+            processArchive( root.string() );
+            return 0;
+        }
+
         processFile( root );
         return 0;
     }
 
+    // Prints the documents of a mongodump --archive, or of one streamed in on stdin for "-"
+    void processArchive( const string& path ) {
+        FILE* f = stdin;
+        if ( path != "-" ) {
+            f = fopen( path.c_str(), "rb" );
+            uassert( 17316, errnoWithPrefix( "couldn't open archive" ), f );
+        }
+
+        ArchiveReader archive( f );
+        ArchiveReader::Block block;
+        const boost::function<void (const BSONObj&)> sink =
+            boost::bind( &BSONDump::gotObject, this, _1 );
+        while ( archive.next( &block ) ) {
+            if ( block.type == "data" || block.type == "oplog" )
+                processBuffer( block.data.data(), block.data.size(), sink );
+        }
+
+        if ( f != stdin )
+            fclose( f );
+    }
+
     bool debug( const BSONObj& o , int depth=0) {
         string prefix = "";
         for ( int i=0; i<depth; i++ ) {
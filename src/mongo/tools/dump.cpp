@@ -16,6 +16,7 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <fcntl.h>
@@ -25,6 +26,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/db.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/tools/archive.h"
 #include "mongo/tools/mongodump_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
@@ -44,7 +46,7 @@ public:
     Dump() : Tool(true/*usesstdout*/) { }
 
     virtual void preSetup() {
-        if (mongoDumpGlobalParams.outputFile == "-") {
+        if (mongoDumpGlobalParams.outputFile == "-" || mongoDumpGlobalParams.archive == "-") {
                 // write output to standard error to avoid mangling output
                 // must happen early to avoid sending junk to stdout
                 useStandardOutput(false);
@@ -80,7 +82,23 @@ public:
         ProgressMeter* _m;
     };
 
-    void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
+    // Like Writer, but adds each BSONObj to a collection's blocks in the archive
+    struct ArchiveSink {
+        ArchiveSink(ArchiveWriter::CollectionWriter* out, ProgressMeter* m) :_out(out), _m(m) {}
+
+        void operator () (const BSONObj& obj) {
+            _out->add(obj);
+            if (_m) {
+                _m->hit();
+            }
+        }
+
+        ArchiveWriter::CollectionWriter* _out;
+        ProgressMeter* _m;
+    };
+
+    void doCollection( DBClientBase& connBase, const string coll,
+                       const boost::function<void(const BSONObj&)>& sink ) {
         Query q = _query;
 
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
@@ -89,44 +107,74 @@ public:
         else if (mongoDumpGlobalParams.snapShotQuery) {
             q.snapshot();
         }
-        
-        DBClientBase& connBase = conn(true);
-        Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
         if (!_usingMongos && typeid(connBase) == typeid(DBClientConnection&)) {
             DBClientConnection& conn = static_cast<DBClientConnection&>(connBase);
-            boost::function<void(const BSONObj&)> castedWriter(writer); // needed for overload resolution
-            conn.query( castedWriter, coll.c_str() , q , NULL, queryOptions | QueryOption_Exhaust);
+            conn.query( sink, coll.c_str() , q , NULL, queryOptions | QueryOption_Exhaust);
         }
         else {
             //This branch should only be taken with DBDirectClient or mongos which doesn't support exhaust mode
             scoped_ptr<DBClientCursor> cursor(connBase.query( coll.c_str() , q , 0 , 0 , 0 , queryOptions ));
             while ( cursor->more() ) {
-                writer(cursor->next());
+                sink(cursor->next());
             }
         }
     }
 
     void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
+        writeCollectionFile( conn(true), coll, outputFile );
+    }
+
+    void writeCollectionFile( DBClientBase& c, const string coll,
+                              boost::filesystem::path outputFile ) {
         log() << "\t" << coll << " to " << outputFile.string() << endl;
 
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        ProgressMeter m(c.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
         m.setName("Collection File Writing Progress");
         m.setUnits("objects");
 
-        doCollection(coll, f, &m);
+        doCollection(c, coll, Writer(f, &m));
+
+        log() << "\t\t " << m.done() << " objects" << endl;
+    }
+
+    // Writes coll's documents to the archive as blocks of "type"
+    void writeCollectionArchive( DBClientBase& c, const string& coll, const string& type ) {
+        log() << "\t" << coll << " to archive" << endl;
+
+        ProgressMeter m(c.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        m.setName("Collection Archive Writing Progress");
+        m.setUnits("objects");
+
+        ArchiveWriter::CollectionWriter out(_archive.get(), coll, type);
+        doCollection(c, coll, ArchiveSink(&out, &m));
+        out.done();
 
         log() << "\t\t " << m.done() << " objects" << endl;
     }
 
     void writeMetadataFile( const string coll, boost::filesystem::path outputFile, 
-                            map<string, BSONObj> options, multimap<string, BSONObj> indexes ) {
+                            const map<string, BSONObj>& options,
+                            const multimap<string, BSONObj>& indexes ) {
         log() << "\tMetadata for " << coll << " to " << outputFile.string() << endl;
 
+        ofstream file (outputFile.string().c_str());
+        uassert(15933, "Couldn't open file: " + outputFile.string(), file.is_open());
+        file << buildMetadata(coll, options, indexes).jsonString();
+    }
+
+    void writeMetadataArchive( const string& coll, const map<string, BSONObj>& options,
+                               const multimap<string, BSONObj>& indexes ) {
+        BSONObj metadata = buildMetadata(coll, options, indexes);
+        _archive->writeBlock(coll, "metadata", metadata.objdata(), metadata.objsize());
+    }
+
+    BSONObj buildMetadata( const string& coll, const map<string, BSONObj>& options,
+                           const multimap<string, BSONObj>& indexes ) {
         bool hasOptions = options.count(coll) > 0;
         bool hasIndexes = indexes.count(coll) > 0;
 
@@ -140,31 +188,33 @@ public:
             BSONArrayBuilder indexesOutput (metadata.subarrayStart("indexes"));
 
             // I'd kill for C++11 auto here...
-            const pair<multimap<string, BSONObj>::iterator, multimap<string, BSONObj>::iterator>
-                range = indexes.equal_range(coll);
+            typedef multimap<string, BSONObj>::const_iterator IndexIterator;
+            const pair<IndexIterator, IndexIterator> range = indexes.equal_range(coll);
 
-            for (multimap<string, BSONObj>::iterator it=range.first; it!=range.second; ++it) {
+            for (IndexIterator it=range.first; it!=range.second; ++it) {
                  indexesOutput << it->second;
             }
 
             indexesOutput.done();
         }
 
-        ofstream file (outputFile.string().c_str());
-        uassert(15933, "Couldn't open file: " + outputFile.string(), file.is_open());
-        file << metadata.done().jsonString();
+        return metadata.obj();
     }
 
 
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, stdout, NULL);
+        doCollection(conn(true), coll, Writer(stdout, NULL));
     }
 
     void go( const string db , const boost::filesystem::path outdir ) {
-        log() << "DATABASE: " << db << "\t to \t" << outdir.string() << endl;
-
-        boost::filesystem::create_directories( outdir );
+        if (_archive) {
+            log() << "DATABASE: " << db << "\t to archive" << endl;
+        }
+        else {
+            log() << "DATABASE: " << db << "\t to \t" << outdir.string() << endl;
+            boost::filesystem::create_directories( outdir );
+        }
 
         map <string, BSONObj> collectionOptions;
         multimap <string, BSONObj> indexes;
@@ -211,6 +261,9 @@ public:
             }
 
             if (nsToCollectionSubstring(name) == "system.indexes") {
+              // The archive's metadata blocks carry the indexes
+              if (_archive)
+                  continue;
               // Create system.indexes.bson for compatibility with pre 2.2 mongorestore
               const string filename = name.substr( db.size() + 1 );
               writeCollectionFile( name.c_str() , outdir / ( filename + ".bson" ) );
@@ -220,14 +273,28 @@ public:
             
             collections.push_back(name);
         }
-        
-        for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
-            string name = *it;
-            const string filename = name.substr( db.size() + 1 );
-            writeCollectionFile( name , outdir / ( filename + ".bson" ) );
-            writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
-        }
 
+        runInParallel( collections.size(), mongoDumpGlobalParams.numParallelCollections, true,
+                       boost::bind( &Dump::dumpCollection, this, _1, boost::cref( db ),
+                                    boost::cref( outdir ), boost::cref( collections ),
+                                    boost::cref( collectionOptions ), boost::cref( indexes ),
+                                    _2 ) );
+    }
+
+    // Writes the data and metadata files of collections[i]; a job for runInParallel()
+    void dumpCollection( DBClientBase& c, const string& db, const boost::filesystem::path& outdir,
+                         const vector<string>& collections,
+                         const map<string, BSONObj>& collectionOptions,
+                         const multimap<string, BSONObj>& indexes, size_t i ) {
+        const string& name = collections[i];
+        if (_archive) {
+            writeMetadataArchive( name, collectionOptions, indexes );
+            writeCollectionArchive( c, name, "data" );
+            return;
+        }
+        const string filename = name.substr( db.size() + 1 );
+        writeCollectionFile( c, name , outdir / ( filename + ".bson" ) );
+        writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
     }
 
     int repair() {
@@ -454,6 +521,17 @@ public:
 
         _usingMongos = isMongos();
 
+        scoped_ptr<FilePtr> archiveFile;
+        if (!mongoDumpGlobalParams.archive.empty()) {
+            FILE* f = stdout;
+            if (mongoDumpGlobalParams.archive != "-") {
+                f = fopen(mongoDumpGlobalParams.archive.c_str(), "wb");
+                uassert(17314, errnoWithPrefix("couldn't open archive"), f);
+                archiveFile.reset(new FilePtr(f));
+            }
+            _archive.reset(new ArchiveWriter(f, mongoDumpGlobalParams.compress));
+        }
+
         boost::filesystem::path root(mongoDumpGlobalParams.outputFile);
 
         if (toolGlobalParams.db == "") {
@@ -499,14 +577,21 @@ public:
 
             _query = BSON("ts" << b.obj());
 
-            writeCollectionFile( opLogName , root / "oplog.bson" );
+            if (_archive)
+                writeCollectionArchive( conn(true), opLogName, "oplog" );
+            else
+                writeCollectionFile( opLogName , root / "oplog.bson" );
         }
 
+        if (_archive)
+            _archive->finish();
+
         return 0;
     }
 
     bool _usingMongos;
     BSONObj _query;
+    scoped_ptr<ArchiveWriter> _archive;
 };
 
 REGISTER_MONGO_TOOL(Dump);
@@ -16,22 +16,36 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
 #include <fstream>
 #include <iostream>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/tools/mongoexport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
+#include "mongo/util/stringutils.h"
 
 using namespace mongo;
 
+namespace {
+    // documents formatted together by one thread
+    const size_t docsPerBatch = 1000;
+}
+
 class Export : public Tool {
 public:
-    Export() : Tool(false/*usesstdout*/) { }
+    Export() : Tool(false/*usesstdout*/), _out(NULL), _num(0) { }
 
     virtual void preSetup() {
         if (mongoExportGlobalParams.outputFileSpecified) {
@@ -115,6 +129,218 @@ public:
         return "";
     }
 
+    /**
+     * The projection for --fields.  CSV output only shows the listed fields, so the projection
+     * is as narrow as the dotted paths allow and leaves out _id unless asked for.  JSON output
+     * shows whole top level fields, so only those are projected.
+     */
+    BSONObj buildProjection() {
+        // we can't use just toolGlobalParams.fields since we support everything getFieldDotted
+        // does
+        vector<string> paths;
+        for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
+             i != toolGlobalParams.fields.end(); i++) {
+            if (!mongoExportGlobalParams.csv) {
+                paths.push_back(str::before(*i, '.'));
+                continue;
+            }
+
+            // a projection of "a.0" would select the "0" field of a's elements, not the element
+            string path;
+            vector<string> parts;
+            splitStringDelim(*i, &parts, '.');
+            for (size_t j = 0; j < parts.size(); j++) {
+                if (j > 0 && !parts[j].empty() && isdigit(parts[j][0]))
+                    break;
+                if (j > 0)
+                    path += '.';
+                path += parts[j];
+            }
+            paths.push_back(path);
+        }
+
+        // a path already covered by a shorter one would conflict with it
+        set<string> seen;
+        BSONObjBuilder b;
+        bool hasId = false;
+        for (size_t i = 0; i < paths.size(); i++) {
+            bool covered = false;
+            for (size_t j = 0; j < paths.size() && !covered; j++) {
+                covered = paths[j].size() < paths[i].size() &&
+                          str::startsWith(paths[i], paths[j] + '.');
+            }
+            if (covered || !seen.insert(paths[i]).second)
+                continue;
+            if (str::before(paths[i], '.') == "_id")
+                hasId = true;
+            b.append(paths[i], 1);
+        }
+        if (mongoExportGlobalParams.csv && !hasId)
+            b.append("_id", 0);
+        return b.obj();
+    }
+
+    /** Appends docs to *text as they appear in the output, separated but not terminated. */
+    void formatBatch(const vector<BSONObj>& docs, string* text) {
+        StringBuilder out;
+        for (size_t d = 0; d < docs.size(); d++) {
+            const BSONObj& obj = docs[d];
+            if (mongoExportGlobalParams.csv) {
+                for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
+                     i != toolGlobalParams.fields.end(); i++) {
+                    if (i != toolGlobalParams.fields.begin())
+                        out << ",";
+                    const BSONElement & e = obj.getFieldDotted(i->c_str());
+                    if ( ! e.eoo() ) {
+                        out << csvString(e);
+                    }
+                }
+                out << "\n";
+            }
+            else {
+                if (mongoExportGlobalParams.jsonArray && d != 0)
+                    out << ',';
+
+                out << obj.jsonString();
+
+                if (!mongoExportGlobalParams.jsonArray)
+                    out << "\n";
+            }
+        }
+        *text = out.str();
+    }
+
+    /** Writes a formatted batch of n documents; safe to call from several threads. */
+    void writeBatch(const string& text, size_t n) {
+        if (n == 0)
+            return;
+        boost::mutex::scoped_lock lk(_outMutex);
+        if (mongoExportGlobalParams.jsonArray && _num != 0)
+            *_out << ',';
+        *_out << text;
+        _num += n;
+    }
+
+    // Reads up to docsPerBatch documents from cursor
+    void readBatch(DBClientCursor& cursor, vector<BSONObj>* docs) {
+        while (docs->size() < docsPerBatch && cursor.more()) {
+            docs->push_back(cursor.nextSafe().getOwned());
+        }
+    }
+
+    // A batch being formatted by a worker; done once text is ready
+    struct FormatJob {
+        FormatJob() : done(false) {}
+        vector<BSONObj> docs;
+        string text;
+        bool done;
+    };
+
+    // Formats the jobs on _formatQueue until it pops an empty one
+    void formatWorker() {
+        while (true) {
+            boost::shared_ptr<FormatJob> job = _formatQueue.blockingPop();
+            if (!job)
+                return;
+            string text;
+            formatBatch(job->docs, &text);
+            boost::mutex::scoped_lock lk(_formatMutex);
+            job->text.swap(text);
+            job->done = true;
+            _formatDone.notify_all();
+        }
+    }
+
+    /**
+     * Exports the documents of cursor in order.  With more than one worker the batches are
+     * formatted on worker threads while the next ones are read, and written as they finish in
+     * the order they were read.
+     */
+    void exportCursor(DBClientCursor& cursor, int numWorkers) {
+        if (numWorkers <= 1) {
+            while (cursor.more()) {
+                vector<BSONObj> docs;
+                readBatch(cursor, &docs);
+                string text;
+                formatBatch(docs, &text);
+                writeBatch(text, docs.size());
+            }
+            return;
+        }
+
+        boost::thread_group workers;
+        for (int i = 0; i < numWorkers; i++) {
+            workers.create_thread(boost::bind(&Export::formatWorker, this));
+        }
+
+        deque< boost::shared_ptr<FormatJob> > inFlight;
+        while (true) {
+            if (inFlight.size() < 2 * static_cast<size_t>(numWorkers) && cursor.more()) {
+                boost::shared_ptr<FormatJob> job(new FormatJob);
+                readBatch(cursor, &job->docs);
+                inFlight.push_back(job);
+                _formatQueue.push(job);
+                continue;
+            }
+            if (inFlight.empty())
+                break;
+
+            boost::shared_ptr<FormatJob> job = inFlight.front();
+            inFlight.pop_front();
+            {
+                boost::mutex::scoped_lock lk(_formatMutex);
+                while (!job->done)
+                    _formatDone.wait(lk);
+            }
+            writeBatch(job->text, job->docs.size());
+        }
+
+        for (int i = 0; i < numWorkers; i++) {
+            _formatQueue.push(boost::shared_ptr<FormatJob>());
+        }
+        workers.join_all();
+    }
+
+    /**
+     * Exports ns over cursors from parallelCollectionScan, each read and formatted by its own
+     * thread.  @return false, having written nothing, if the server can't split the collection
+     */
+    bool exportParallelScan(const string& ns, int numCursors) {
+        BSONObj res;
+        if (!conn().runCommand(nsToDatabase(ns),
+                               BSON("parallelCollectionScan" << nsToCollectionSubstring(ns) <<
+                                    "numCursors" << numCursors),
+                               res)) {
+            LOG(1) << "parallelCollectionScan failed, exporting with one cursor: " << res << endl;
+            return false;
+        }
+
+        vector<long long> cursorIds;
+        BSONObjIterator i(res["cursors"].Obj());
+        while (i.more()) {
+            cursorIds.push_back(i.next().Obj()["cursor"]["id"].numberLong());
+        }
+
+        runInParallel(cursorIds.size(), numCursors, false,
+                      boost::bind(&Export::exportScanCursor, this, boost::cref(ns),
+                                  boost::cref(cursorIds), _1, _2));
+        return true;
+    }
+
+    // Exports the documents of cursorIds[i]; a job for runInParallel()
+    void exportScanCursor(const string& ns, const vector<long long>& cursorIds,
+                          DBClientBase& c, size_t i) {
+        DBClientCursor cursor(&c, ns, cursorIds[i], 0,
+                              mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0);
+        while (cursor.more()) {
+            vector<BSONObj> docs;
+            readBatch(cursor, &docs);
+            string text;
+            formatBatch(docs, &text);
+            writeBatch(text, docs.size());
+        }
+    }
+
     int run() {
         string ns;
         ostream *outPtr = &cout;
@@ -147,21 +373,7 @@ public:
         }
 
         if (toolGlobalParams.fieldsSpecified || mongoExportGlobalParams.csv) {
-            
-            // we can't use just toolGlobalParams.fields since we support everything getFieldDotted
-            // does
-            
-            set<string> seen;
-            BSONObjBuilder b;
-            
-            for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
-                 i != toolGlobalParams.fields.end(); i++) {
-                std::string f = str::before(*i, '.');
-                if ( seen.insert( f ).second )
-                    b.append( f , 1 );
-            }
-            
-            realFieldsToReturn = b.obj();
+            realFieldsToReturn = buildProjection();
             fieldsToReturn = &realFieldsToReturn;
         }
         
@@ -171,16 +383,7 @@ public:
             return -1;
         }
 
-        Query q(mongoExportGlobalParams.query);
-
-        if (mongoExportGlobalParams.snapShotQuery) {
-            q.snapshot();
-        }
-
-        auto_ptr<DBClientCursor> cursor = conn().query(ns.c_str(), q,
-                mongoExportGlobalParams.limit, mongoExportGlobalParams.skip, fieldsToReturn,
-                (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
-                QueryOption_NoCursorTimeout);
+        _out = &out;
 
         if (mongoExportGlobalParams.csv) {
             for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
@@ -195,42 +398,52 @@ public:
         if (mongoExportGlobalParams.jsonArray)
             out << '[';
 
-        long long num = 0;
-        while ( cursor->more() ) {
-            num++;
-            BSONObj obj = cursor->next();
-            if (mongoExportGlobalParams.csv) {
-                for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
-                     i != toolGlobalParams.fields.end(); i++) {
-                    if (i != toolGlobalParams.fields.begin())
-                        out << ",";
-                    const BSONElement & e = obj.getFieldDotted(i->c_str());
-                    if ( ! e.eoo() ) {
-                        out << csvString(e);
-                    }
-                }
-                out << endl;
-            }
-            else {
-                if (mongoExportGlobalParams.jsonArray && num != 1)
-                    out << ',';
+        const int numWorkers = mongoExportGlobalParams.numParallelWorkers;
 
-                out << obj.jsonString();
+        // A table scan of the whole collection can be split across cursors, one per thread, at
+        // the cost of the order of the documents.  Otherwise one cursor is read here and its
+        // batches are formatted by numWorkers threads and written in order.
+        if (!(numWorkers > 1 &&
+              mongoExportGlobalParams.forceTableScan &&
+              (mongoExportGlobalParams.query.empty() ||
+               fromjson(mongoExportGlobalParams.query).isEmpty()) &&
+              mongoExportGlobalParams.skip == 0 &&
+              mongoExportGlobalParams.limit == 0 &&
+              exportParallelScan(ns, numWorkers))) {
 
-                if (!mongoExportGlobalParams.jsonArray)
-                    out << endl;
+            Query q(mongoExportGlobalParams.query);
+
+            if (mongoExportGlobalParams.snapShotQuery) {
+                q.snapshot();
             }
+
+            auto_ptr<DBClientCursor> cursor = conn().query(ns.c_str(), q,
+                    mongoExportGlobalParams.limit, mongoExportGlobalParams.skip, fieldsToReturn,
+                    (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
+                    QueryOption_NoCursorTimeout);
+
+            exportCursor(*cursor, numWorkers);
         }
 
         if (mongoExportGlobalParams.jsonArray)
             out << ']' << endl;
 
+        const long long num = _num;
         if (!toolGlobalParams.quiet) {
             (_usesstdout ? cout : cerr ) << "exported " << num << " records" << endl;
         }
 
         return 0;
     }
+
+private:
+    ostream* _out;
+    boost::mutex _outMutex;
+    long long _num;
+
+    BlockingQueue< boost::shared_ptr<FormatJob> > _formatQueue;
+    boost::mutex _formatMutex;
+    boost::condition _formatDone;
 };
 
 REGISTER_MONGO_TOOL(Export);
@@ -17,21 +17,38 @@
 #include "mongo/pch.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
 #include "mongo/base/initializer.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/json.h"
 #include "mongo/tools/mongoimport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/text.h"
 
 using namespace mongo;
 using std::string;
 using std::stringstream;
 
+namespace {
+    // rows the reader hands an insertion worker at a time
+    const size_t rowsPerChunk = 1000;
+    // chunks read ahead of the insertion workers
+    const size_t chunkQueueSize = 16;
+
+    // limits on the documents sent in one insert message
+    const size_t insertBatchDocs = 1000;
+    const int insertBatchBytes = 8 * 1024 * 1024;
+}
+
 class Import : public Tool {
 
     enum Type { JSON , CSV , TSV };
@@ -169,11 +186,11 @@ class Import : public Tool {
     }
 
     /*
-     * Parses one object from the input file.  This usually corresponds to one line in the input
-     * file, unless the file is a CSV and contains a newline within a quoted string entry.
-     * Returns a true if a BSONObj was successfully created and false if not.
+     * Reads the text of one object from the input file.  This usually corresponds to one line
+     * in the input file, unless the file is a CSV and contains a newline within a quoted string
+     * entry.  Returns false if the line was empty.
      */
-    bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
+    bool readRow(istream* in, string* row, int& numBytesRead) {
         boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
         char* line = buffer.get();
 
@@ -185,59 +202,68 @@ class Import : public Tool {
         }
         numBytesRead += strlen( line );
 
+        if (_type != CSV) {
+            *row = line;
+            return true;
+        }
+
+        bool inside_quotes = false;
+        size_t last_quote = 0;
+        while (true) {
+            string lineStr(line);
+            // Deal with line breaks in quoted strings
+            last_quote = lineStr.find_first_of('"');
+            while (last_quote != string::npos) {
+                inside_quotes = !inside_quotes;
+                last_quote = lineStr.find_first_of('"', last_quote+1);
+            }
+
+            row->append(lineStr);
+
+            if (inside_quotes) {
+                row->append("\n");
+                int num = getLine(in, line);
+                line += num;
+                numBytesRead += num;
+
+                uassert(15854, "CSV file ends while inside quoted field", line[0] != '\0');
+                numBytesRead += strlen( line );
+            } else {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * Parses the text of one object, as read by readRow(), into o.  Safe to call from several
+     * threads once the header line, if any, has been parsed.
+     */
+    void parseRow(const string& row, BSONObj& o) {
         if (_type == JSON) {
             // Strip out trailing whitespace
-            char * end = ( line + strlen( line ) ) - 1;
-            while ( end >= line && isspace(*end) ) {
-                *end = 0;
-                end--;
-            }
+            size_t end = row.find_last_not_of(" \t\n\v\f\r");
             try {
-                o = fromjson( line );
+                o = fromjson( end == string::npos ? string() : row.substr(0, end + 1) );
             } catch ( MsgAssertionException& e ) {
                 uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
             }
-            return true;
+            return;
         }
 
         vector<string> tokens;
         if (_type == CSV) {
-            string row;
-            bool inside_quotes = false;
-            size_t last_quote = 0;
-            while (true) {
-                string lineStr(line);
-                // Deal with line breaks in quoted strings
-                last_quote = lineStr.find_first_of('"');
-                while (last_quote != string::npos) {
-                    inside_quotes = !inside_quotes;
-                    last_quote = lineStr.find_first_of('"', last_quote+1);
-                }
-
-                row.append(lineStr);
-
-                if (inside_quotes) {
-                    row.append("\n");
-                    int num = getLine(in, line);
-                    line += num;
-                    numBytesRead += num;
-
-                    uassert(15854, "CSV file ends while inside quoted field", line[0] != '\0');
-                    numBytesRead += strlen( line );
-                } else {
-                    break;
-                }
-            }
-            // now 'row' is string corresponding to one row of the CSV file
+            // 'row' is the string corresponding to one row of the CSV file
             // (which may span multiple lines) and represents one BSONObj
             csvTokenizeRow(row, tokens);
         }
         else {  // _type == TSV
-            while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
-                line++;
+            size_t start = 0;
+            while (start < row.size() && row[start] != '\t' && isspace(row[start])) {
+                start++;  // Strip leading whitespace, but not tabs
             }
 
-            boost::split(tokens, line, boost::is_any_of(_sep));
+            boost::split(tokens, row.substr(start), boost::is_any_of(_sep));
         }
 
         // Now that the row is tokenized, create a BSONObj out of it.
@@ -264,11 +290,101 @@ class Import : public Tool {
             }
         }
         o = b.obj();
-        return true;
+    }
+
+    // A run of rows from the input, parsed and inserted together by one insertion worker
+    typedef vector<string> RowChunk;
+
+    BlockingQueue< boost::shared_ptr<RowChunk> > _chunks;
+
+    boost::mutex _statsMutex;
+    int _errors;
+    bool _stopping;
+
+    void countError() {
+        boost::mutex::scoped_lock lk(_statsMutex);
+        _errors++;
+        if (mongoImportGlobalParams.stopOnError)
+            _stopping = true;
+    }
+
+    bool stopping() {
+        boost::mutex::scoped_lock lk(_statsMutex);
+        return _stopping;
+    }
+
+    /**
+     * Parses the rows of chunk and inserts them into ns in batches, over c.  Parse and insert
+     * errors are counted, and stop the import with --stopOnError.
+     */
+    void insertChunk(DBClientBase& c, const string& ns, const RowChunk& chunk) {
+        vector<BSONObj> batch;
+        int batchBytes = 0;
+        for (RowChunk::const_iterator it = chunk.begin(); it != chunk.end(); ++it) {
+            if (stopping())
+                return;
+            try {
+                BSONObj o;
+                parseRow(*it, o);
+                if (!mongoImportGlobalParams.doimport || upsertDocument(c, ns, o))
+                    continue;
+
+                if (batch.size() >= insertBatchDocs || batchBytes + o.objsize() > insertBatchBytes) {
+                    insertBatch(c, ns, &batch);
+                    batchBytes = 0;
+                }
+                batch.push_back(o);
+                batchBytes += o.objsize();
+            }
+            catch ( const std::exception& e ) {
+                log() << "exception:" << e.what() << endl;
+                countError();
+            }
+        }
+
+        try {
+            insertBatch(c, ns, &batch);
+        }
+        catch ( const std::exception& e ) {
+            log() << "exception:" << e.what() << endl;
+            countError();
+        }
+    }
+
+    void insertBatch(DBClientBase& c, const string& ns, vector<BSONObj>* batch) {
+        if (batch->empty())
+            return;
+
+        // unordered, so a duplicate key doesn't stop the rest of the batch
+        c.insert(ns, *batch,
+                 mongoImportGlobalParams.stopOnError ? 0 : InsertOption_ContinueOnError);
+        batch->clear();
+
+        if (!checkLastError(c) && mongoImportGlobalParams.stopOnError) {
+            boost::mutex::scoped_lock lk(_statsMutex);
+            _stopping = true;
+        }
+    }
+
+    // Inserts the chunks on _chunks until it pops an empty one
+    void insertionWorker(DBClientBase* c, const string* ns) {
+        while (true) {
+            boost::shared_ptr<RowChunk> chunk = _chunks.blockingPop();
+            if (!chunk)
+                return;
+            insertChunk(*c, *ns, *chunk);
+        }
+    }
+
+    void dispatchChunk(const boost::shared_ptr<RowChunk>& chunk, const string& ns, int numWorkers) {
+        if (numWorkers == 0)
+            insertChunk(conn(), ns, *chunk);
+        else
+            _chunks.push(chunk);
     }
 
 public:
-    Import() : Tool() {
+    Import() : Tool(), _chunks(chunkQueueSize), _errors(0), _stopping(false) {
         _type = JSON;
     }
 
@@ -279,8 +395,8 @@ public:
     unsigned long long lastErrorFailures;
 
     /** @return true if ok */
-    bool checkLastError() { 
-        string s = conn().getLastError();
+    bool checkLastError( DBClientBase& c ) {
+        string s = c.getLastError();
         if( !s.empty() ) { 
             if( str::contains(s,"uplicate") ) {
                 // we don't want to return an error from the mongoimport process for
@@ -288,6 +404,7 @@ public:
                 log() << s << endl;
             }
             else {
+                boost::mutex::scoped_lock lk(_statsMutex);
                 lastErrorFailures++;
                 log() << "error: " << s << endl;
                 return false;
@@ -297,26 +414,28 @@ public:
     }
 
     void importDocument (const std::string &ns, const BSONObj& o) {
-        bool doUpsert = mongoImportGlobalParams.upsert;
+        if (!upsertDocument(conn(), ns, o)) {
+            conn().insert(ns.c_str(), o);
+        }
+    }
+
+    /** @return true if o was upserted, false if it should be inserted */
+    bool upsertDocument(DBClientBase& c, const std::string& ns, const BSONObj& o) {
+        if (!mongoImportGlobalParams.upsert)
+            return false;
+
         BSONObjBuilder b;
-        if (mongoImportGlobalParams.upsert) {
-            for (vector<string>::const_iterator it = mongoImportGlobalParams.upsertFields.begin(),
-                 end = mongoImportGlobalParams.upsertFields.end(); it != end; ++it) {
-                BSONElement e = o.getFieldDotted(it->c_str());
-                if (e.eoo()) {
-                    doUpsert = false;
-                    break;
-                }
-                b.appendAs(e, *it);
+        for (vector<string>::const_iterator it = mongoImportGlobalParams.upsertFields.begin(),
+             end = mongoImportGlobalParams.upsertFields.end(); it != end; ++it) {
+            BSONElement e = o.getFieldDotted(it->c_str());
+            if (e.eoo()) {
+                return false;
             }
+            b.appendAs(e, *it);
         }
 
-        if (doUpsert) {
-            conn().update(ns, Query(b.obj()), o, true);
-        }
-        else {
-            conn().insert(ns.c_str(), o);
-        }
+        c.update(ns, Query(b.obj()), o, true);
+        return true;
     }
 
     int run() {
@@ -406,7 +525,6 @@ public:
         ProgressMeter pm( fileSize );
         int num = 0;
         int lastNumChecked = num;
-        int errors = 0;
         lastErrorFailures = 0;
         int len = 0;
 
@@ -450,7 +568,7 @@ public:
                         if (num < 10) {
                             // we absolutely want to check the first and last op of the batch. we do
                             // a few more as that won't be too time expensive.
-                            checkLastError();
+                            checkLastError(conn());
                             lastNumChecked = num;
                         }
                     }
@@ -483,7 +601,7 @@ public:
                 catch ( const std::exception& e ) {
                     log() << "exception: " << e.what()
                           << ", current buffer: " << current_buffer << endl;
-                    errors++;
+                    _errors++;
 
                     // Since we only support JSON arrays all on one line, we might as well stop now
                     // because we can't read any more documents
@@ -496,25 +614,37 @@ public:
             }
         }
         else {
-            while (in->rdstate() == 0) {
-                try {
-                    BSONObj o;
+            // The rows are read here and parsed and inserted by numInsertionWorkers threads, each
+            // with its own connection.  A direct client has no other connections to use, so it
+            // parses and inserts each chunk itself.
+            const int numWorkers = toolGlobalParams.useDirectClient ?
+                0 : mongoImportGlobalParams.numInsertionWorkers;
+            OwnedPointerVector<DBClientBase> connections;
+            boost::thread_group workers;
+            for (int i = 0; i < numWorkers; i++) {
+                DBClientBase* c = newConnection();
+                connections.mutableVector().push_back(c);
+                workers.create_thread(boost::bind(&Import::insertionWorker, this, c, &ns));
+            }
 
-                    if (!parseRow(in, o, len)) {
+            boost::shared_ptr<RowChunk> chunk(new RowChunk);
+            while (in->rdstate() == 0 && !stopping()) {
+                try {
+                    string row;
+                    if (!readRow(in, &row, len)) {
                         continue;
                     }
 
                     if (mongoImportGlobalParams.headerLine) {
+                        BSONObj o;
+                        parseRow(row, o);
                         mongoImportGlobalParams.headerLine = false;
                     }
-                    else if (mongoImportGlobalParams.doimport) {
-                        importDocument(ns, o);
-
-                        if (num < 10) {
-                            // we absolutely want to check the first and last op of the batch. we do
-                            // a few more as that won't be too time expensive.
-                            checkLastError();
-                            lastNumChecked = num;
+                    else {
+                        chunk->push_back(row);
+                        if (chunk->size() >= rowsPerChunk) {
+                            dispatchChunk(chunk, ns, numWorkers);
+                            chunk.reset(new RowChunk);
                         }
                     }
 
@@ -522,25 +652,34 @@ public:
                 }
                 catch ( const std::exception& e ) {
                     log() << "exception:" << e.what() << endl;
-                    errors++;
-
-                    if (mongoImportGlobalParams.stopOnError)
-                        break;
+                    countError();
                 }
 
                 if ( pm.hit( len + 1 ) ) {
                     log() << "\t\t\t" << num << "\t" << ( num / ( time(0) - start ) ) << "/second" << endl;
                 }
             }
+
+            if (!chunk->empty()) {
+                dispatchChunk(chunk, ns, numWorkers);
+            }
+            for (int i = 0; i < numWorkers; i++) {
+                _chunks.push(boost::shared_ptr<RowChunk>());
+            }
+            workers.join_all();
+
+            // every batch's last error has been checked
+            lastNumChecked = num - 1;
         }
 
         // this is for two reasons: to wait for all operations to reach the server and be processed, and this will wait until all data reaches the server,
         // and secondly to check if there were an error (on the last op)
         if( lastNumChecked+1 != num ) { // avoid redundant log message if already reported above
             log() << "check " << lastNumChecked << " " << num << endl;
-            checkLastError();
+            checkLastError(conn());
         }
 
+        const int errors = _errors;
         bool hadErrors = lastErrorFailures || errors;
 
         // the message is vague on lastErrorFailures as we don't call it on every single operation. 
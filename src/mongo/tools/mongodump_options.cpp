@@ -77,6 +77,22 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("numParallelCollections", "numParallelCollections,j",
+                    moe::Int, "number of collections to dump in parallel", true, moe::Value(1)));
+        if(!ret.isOK()) {
+            return ret;
+        }
+        ret = options->addOption(OD("archive", "archive", moe::String,
+                    "write the whole dump as one archive to this file, or \"-\" for stdout",
+                    true));
+        if(!ret.isOK()) {
+            return ret;
+        }
+        ret = options->addOption(OD("compress", "compress", moe::Switch,
+                    "snappy compress the blocks of an --archive dump", true));
+        if(!ret.isOK()) {
+            return ret;
+        }
 
         return Status::OK();
     }
@@ -123,6 +139,15 @@ namespace mongo {
             }
         }
         mongoDumpGlobalParams.outputFile = getParam("out");
+        mongoDumpGlobalParams.numParallelCollections = getParam("numParallelCollections", 1);
+        if (mongoDumpGlobalParams.numParallelCollections < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelCollections must be at least 1");
+        }
+        mongoDumpGlobalParams.archive = getParam("archive");
+        mongoDumpGlobalParams.compress = hasParam("compress");
+        if (mongoDumpGlobalParams.compress && !hasParam("archive")) {
+            return Status(ErrorCodes::BadValue, "--compress only works with --archive");
+        }
         mongoDumpGlobalParams.snapShotQuery = false;
         if (!hasParam("query") && !hasParam("dbpath") && !hasParam("forceTableScan")) {
             mongoDumpGlobalParams.snapShotQuery = true;
@@ -31,6 +31,9 @@ namespace mongo {
         bool useOplog;
         bool repair;
         bool snapShotQuery;
+        int numParallelCollections;
+        std::string archive;
+        bool compress;
     };
 
     extern MongoDumpGlobalParams mongoDumpGlobalParams;
@@ -98,6 +98,13 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("numParallelWorkers", "numParallelWorkers,j", moe::Int,
+                    "number of threads formatting the output; with --forceTableScan and no "
+                    "query, skip or limit, also the number of cursors the collection is split "
+                    "across", true, moe::Value(1)));
+        if(!ret.isOK()) {
+            return ret;
+        }
 
         return Status::OK();
     }
@@ -140,6 +147,11 @@ namespace mongo {
         mongoExportGlobalParams.slaveOk = toolsParsedOptions["slaveOk"].as<bool>();
         mongoExportGlobalParams.limit = getParam("limit", 0);
         mongoExportGlobalParams.skip = getParam("skip", 0);
+        mongoExportGlobalParams.forceTableScan = hasParam("forceTableScan");
+        mongoExportGlobalParams.numParallelWorkers = getParam("numParallelWorkers", 1);
+        if (mongoExportGlobalParams.numParallelWorkers < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelWorkers must be at least 1");
+        }
 
         return Status::OK();
     }
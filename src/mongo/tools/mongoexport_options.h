@@ -35,6 +35,8 @@ namespace mongo {
         bool snapShotQuery;
         unsigned int skip;
         unsigned int limit;
+        bool forceTableScan;
+        int numParallelWorkers;
     };
 
     extern MongoExportGlobalParams mongoExportGlobalParams;
@@ -103,6 +103,12 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("numInsertionWorkers", "numInsertionWorkers,j", moe::Int,
+                    "number of threads parsing and inserting the input in parallel", true,
+                    moe::Value(1)));
+        if(!ret.isOK()) {
+            return ret;
+        }
 
         ret = options->addOption(OD("noimport", "noimport", moe::Switch,
                     "don't actually import. useful for benchmarking parser", false));
@@ -171,6 +177,10 @@ namespace mongo {
         mongoImportGlobalParams.jsonArray = hasParam("jsonArray");
         mongoImportGlobalParams.headerLine = hasParam("headerline");
         mongoImportGlobalParams.stopOnError = hasParam("stopOnError");
+        mongoImportGlobalParams.numInsertionWorkers = getParam("numInsertionWorkers", 1);
+        if (mongoImportGlobalParams.numInsertionWorkers < 1) {
+            return Status(ErrorCodes::BadValue, "numInsertionWorkers must be at least 1");
+        }
 
         return Status::OK();
     }
@@ -66,6 +66,12 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("numParallelWorkers", "numParallelWorkers,j", moe::Int,
+                    "number of connections applying each batch of oplog entries in parallel", true,
+                    moe::Value(1)));
+        if(!ret.isOK()) {
+            return ret;
+        }
 
         return Status::OK();
     }
@@ -101,6 +107,10 @@ namespace mongo {
 
         mongoOplogGlobalParams.seconds = getParam("seconds", 86400);
         mongoOplogGlobalParams.ns = getParam("oplogns");
+        mongoOplogGlobalParams.numParallelWorkers = getParam("numParallelWorkers", 1);
+        if (mongoOplogGlobalParams.numParallelWorkers < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelWorkers must be at least 1");
+        }
 
         return Status::OK();
     }
@@ -29,6 +29,7 @@ namespace mongo {
         int seconds;
         std::string from;
         std::string ns;
+        int numParallelWorkers;
     };
 
     extern MongoOplogGlobalParams mongoOplogGlobalParams;
@@ -93,6 +93,16 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("numParallelCollections", "numParallelCollections,j",
+                    moe::Int, "number of collections to restore in parallel", true, moe::Value(1)));
+        if(!ret.isOK()) {
+            return ret;
+        }
+        ret = options->addOption(OD("archive", "archive", moe::String,
+                    "restore a mongodump --archive from this file, or \"-\" for stdin", true));
+        if(!ret.isOK()) {
+            return ret;
+        }
         ret = options->addOption(OD("dir", "dir", moe::String,
                     "directory to restore from" , false, moe::Value(std::string("dump"))));
         if(!ret.isOK()) {
@@ -143,11 +153,16 @@ namespace mongo {
         }
 
         mongoRestoreGlobalParams.restoreDirectory = getParam("dir");
+        mongoRestoreGlobalParams.archive = getParam("archive");
         mongoRestoreGlobalParams.drop = hasParam("drop");
         mongoRestoreGlobalParams.keepIndexVersion = hasParam("keepIndexVersion");
         mongoRestoreGlobalParams.restoreOptions = !hasParam("noOptionsRestore");
         mongoRestoreGlobalParams.restoreIndexes = !hasParam("noIndexRestore");
         mongoRestoreGlobalParams.w = getParam( "w" , 0 );
+        mongoRestoreGlobalParams.numParallelCollections = getParam("numParallelCollections", 1);
+        if (mongoRestoreGlobalParams.numParallelCollections < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelCollections must be at least 1");
+        }
         mongoRestoreGlobalParams.oplogReplay = hasParam("oplogReplay");
         mongoRestoreGlobalParams.oplogLimit = getParam("oplogLimit", "");
 
@@ -33,7 +33,9 @@ namespace mongo {
         bool restoreOptions;
         bool restoreIndexes;
         int w;
+        int numParallelCollections;
         std::string restoreDirectory;
+        std::string archive;
     };
 
     extern MongoRestoreGlobalParams mongoRestoreGlobalParams;
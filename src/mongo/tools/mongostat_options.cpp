@@ -67,6 +67,12 @@ namespace mongo {
         if(!ret.isOK()) {
             return ret;
         }
+        ret = options->addOption(OD("intervalMillis", "intervalMillis", moe::Int,
+                    "milliseconds between rows, overriding the sleep time; below 1000 the "
+                    "time column shows milliseconds", true));
+        if(!ret.isOK()) {
+            return ret;
+        }
 
         ret = options->addPositionalOption(POD( "sleep", moe::Int, 1 ));
         if(!ret.isOK()) {
@@ -145,6 +151,10 @@ namespace mongo {
         mongoStatGlobalParams.showHeaders = !hasParam("noheaders");
         mongoStatGlobalParams.rowCount = getParam("rowcount", 0);
         mongoStatGlobalParams.sleep = getParam("sleep", 1);
+        mongoStatGlobalParams.intervalMillis = getParam("intervalMillis", 0);
+        if (mongoStatGlobalParams.sleep < 1 && mongoStatGlobalParams.intervalMillis < 1) {
+            return Status(ErrorCodes::BadValue, "the sleep time must be at least 1 second");
+        }
         mongoStatGlobalParams.allFields = hasParam("all");
 
         // Make the default db "admin" if it was not explicitly set
@@ -33,6 +33,7 @@ namespace mongo {
         bool many;
         bool allFields;
         int sleep;
+        int intervalMillis;
         std::string url;
     };
 
@@ -16,10 +16,18 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <vector>
 
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/tools/mongooplog_options.h"
 #include "mongo/tools/tool.h"
@@ -27,9 +35,41 @@
 
 using namespace mongo;
 
+namespace {
+
+    // A batch is applied once the cursor has no more entries buffered, or once it reaches
+    // either limit.  The byte limit keeps each worker's applyOps command under the maximum
+    // BSON size.
+    const size_t maxBatchOps = 5000;
+    const int maxBatchBytes = 8 * 1024 * 1024;
+
+    /** @return the _id of the document 'op' writes, or EOO if it doesn't name one */
+    BSONElement getDocumentId(const BSONObj& op) {
+        const char* opType = op.getStringField("op");
+        if (opType[0] == 'i' || opType[0] == 'd') {
+            return op.getObjectField("o")["_id"];
+        }
+        if (opType[0] == 'u') {
+            return op.getObjectField("o2")["_id"];
+        }
+        return BSONElement();
+    }
+
+    /**
+     * @return true if 'op' has to be applied on its own, after everything before it and
+     * before everything after it: commands, and index builds, which later ops may depend on.
+     */
+    bool mustApplyAlone(const BSONObj& op) {
+        if (op.getStringField("op")[0] == 'c')
+            return true;
+        return NamespaceString(op.getStringField("ns")).isSystemDotIndexes();
+    }
+
+}  // namespace
+
 class OplogTool : public Tool {
 public:
-    OplogTool() : Tool() { }
+    OplogTool() : Tool(), _numApplied(0) { }
 
     virtual void printHelp( ostream & out ) {
         printMongoOplogHelp(toolsOptions, &out);
@@ -52,9 +92,19 @@ public:
 
         r.tailingQueryGTE(mongoOplogGlobalParams.ns.c_str(), start);
 
+        // Each batch of entries is split among numParallelWorkers writers the way a secondary
+        // splits its batches among its writer threads, and each writer applies its share with
+        // one applyOps on its own connection.  A direct client has no other connections.
+        if (!toolGlobalParams.useDirectClient) {
+            for (int i = 0; i < mongoOplogGlobalParams.numParallelWorkers; i++)
+                _writers.mutableVector().push_back(newConnection());
+        }
+
+        std::vector<BSONObj> batch;
+        int batchBytes = 0;
         int num = 0;
         while ( r.more() ) {
-            BSONObj o = r.next();
+            BSONObj o = r.next().getOwned();
             LOG(2) << o << endl;
             
             if ( o["$err"].type() ) {
@@ -68,24 +118,155 @@ public:
             if ( print )
                 cout << num << "\t" << o << endl;
             
-            if ( o["op"].String() == "n" )
+            if ( o["op"].String() == "n" ) {
+                if ( !batch.empty() && !r.moreInCurrentBatch() )
+                    applyBatch( &batch, &batchBytes );
                 continue;
+            }
+
+            if ( mustApplyAlone( o ) ) {
+                applyBatch( &batch, &batchBytes );
+                batch.push_back( o );
+                applyBatch( &batch, &batchBytes );
+                // the command or index may have changed which namespaces can be split
+                _splitByDocument.clear();
+                continue;
+            }
 
-            BSONObjBuilder b( o.objsize() + 32 );
-            BSONArrayBuilder updates( b.subarrayStart( "applyOps" ) );
-            updates.append( o );
-            updates.done();
+            if ( batchBytes + o.objsize() > maxBatchBytes )
+                applyBatch( &batch, &batchBytes );
+            batch.push_back( o );
+            batchBytes += o.objsize();
 
-            BSONObj c = b.obj();
-            
-            BSONObj res;
-            bool ok = conn().runCommand( "admin" , c , res );
-            if ( print || ! ok )
-                log() << res << endl;
+            if ( batch.size() >= maxBatchOps || !r.moreInCurrentBatch() )
+                applyBatch( &batch, &batchBytes );
         }
+        applyBatch( &batch, &batchBytes );
 
         return 0;
     }
+
+private:
+    /** Applies and clears 'batch', splitting it among the writers. */
+    void applyBatch( std::vector<BSONObj>* batch, int* batchBytes ) {
+        if ( batch->empty() )
+            return;
+
+        std::vector< std::vector<BSONObj> > writerVectors( std::max<size_t>( _writers.size(), 1 ) );
+        fillWriterVectors( *batch, &writerVectors );
+
+        if ( _writers.size() <= 1 ) {
+            DBClientBase& c = _writers.empty() ? conn() : *_writers.vector()[0];
+            for ( size_t i = 0; i < writerVectors.size(); i++ )
+                applyOps( c, writerVectors[i] );
+        }
+        else {
+            boost::thread_group threads;
+            for ( size_t i = 0; i < writerVectors.size(); i++ ) {
+                if ( writerVectors[i].empty() )
+                    continue;
+                threads.create_thread( boost::bind( &OplogTool::applyOps, this,
+                                                    boost::ref( *_writers.vector()[i] ),
+                                                    boost::cref( writerVectors[i] ) ) );
+            }
+            threads.join_all();
+        }
+
+        _numApplied += batch->size();
+        LOG(1) << "applied " << batch->size() << " oplog entries, " << _numApplied
+               << " in total" << endl;
+        batch->clear();
+        *batchBytes = 0;
+    }
+
+    /**
+     * Partitions 'ops' like SyncTail::fillWriterVectors: by namespace, and by _id as well for
+     * namespaces where ops on different documents commute and every op names its document.
+     * Ops on one document always go to the same writer, in their original order.
+     */
+    void fillWriterVectors( const std::vector<BSONObj>& ops,
+                            std::vector< std::vector<BSONObj> >* writerVectors ) {
+        std::map<std::string, bool> splitNamespaces;
+        if ( writerVectors->size() > 1 ) {
+            for ( size_t i = 0; i < ops.size(); i++ ) {
+                const std::string ns = ops[i].getStringField( "ns" );
+                std::map<std::string, bool>::iterator split = splitNamespaces.find( ns );
+                if ( split == splitNamespaces.end() ) {
+                    split = splitNamespaces.insert(
+                        std::make_pair( ns, canSplitByDocument( ns ) ) ).first;
+                }
+                if ( split->second && getDocumentId( ops[i] ).eoo() )
+                    split->second = false;
+            }
+        }
+
+        for ( size_t i = 0; i < ops.size(); i++ ) {
+            const BSONElement e = ops[i].getField( "ns" );
+            uint32_t hash = 0;
+            MurmurHash3_x86_32( e.valuestr(), e.valuestrsize(), 0, &hash );
+
+            std::map<std::string, bool>::const_iterator split =
+                splitNamespaces.find( e.valuestr() );
+            if ( split != splitNamespaces.end() && split->second ) {
+                long long idHash = BSONElementHasher::hash64(
+                    getDocumentId( ops[i] ), BSONElementHasher::DEFAULT_HASH_SEED );
+                hash ^= static_cast<uint32_t>( idHash ) ^ static_cast<uint32_t>( idHash >> 32 );
+            }
+
+            (*writerVectors)[hash % writerVectors->size()].push_back( ops[i] );
+        }
+    }
+
+    /**
+     * Like the secondary's check, against the destination's catalog: capped collections and
+     * collections with a unique secondary index keep all their ops on one writer.  Cached
+     * until the next command or index build.
+     */
+    bool canSplitByDocument( const std::string& ns ) {
+        std::map<std::string, bool>::const_iterator cached = _splitByDocument.find( ns );
+        if ( cached != _splitByDocument.end() )
+            return cached->second;
+
+        bool split = false;
+        NamespaceString nss( ns );
+        if ( !nss.isSystem() ) {
+            split = true;
+            BSONObj spec = conn().findOne( nss.db().toString() + ".system.namespaces",
+                                           BSON( "name" << ns ) );
+            if ( spec.getObjectField( "options" )["capped"].trueValue() )
+                split = false;
+
+            std::auto_ptr<DBClientCursor> indexes = conn().getIndexes( ns );
+            while ( split && indexes.get() && indexes->more() ) {
+                BSONObj index = indexes->nextSafe();
+                if ( index["unique"].trueValue() && index["name"].String() != "_id_" )
+                    split = false;
+            }
+        }
+
+        _splitByDocument[ns] = split;
+        return split;
+    }
+
+    /** Applies 'ops', in order, with one applyOps command on 'c'. */
+    void applyOps( DBClientBase& c, const std::vector<BSONObj>& ops ) {
+        if ( ops.empty() )
+            return;
+
+        BSONObjBuilder b;
+        BSONArrayBuilder updates( b.subarrayStart( "applyOps" ) );
+        for ( size_t i = 0; i < ops.size(); i++ )
+            updates.append( ops[i] );
+        updates.done();
+
+        BSONObj res;
+        if ( !c.runCommand( "admin", b.obj(), res ) )
+            log() << res << endl;
+    }
+
+    OwnedPointerVector<DBClientBase> _writers;
+    std::map<std::string, bool> _splitByDocument;
+    long long _numApplied;
 };
 
 REGISTER_MONGO_TOOL(OplogTool);
@@ -16,6 +16,7 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
@@ -27,6 +28,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/tools/archive.h"
 #include "mongo/tools/mongorestore_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/mmap.h"
@@ -37,6 +39,10 @@ using namespace mongo;
 
 namespace {
     const char* OPLOG_SENTINEL = "$oplog";  // compare by ptr not strcmp
+
+    // limits on the documents sent in one insert message when loading collections in parallel
+    const size_t insertBatchDocs = 1000;
+    const int insertBatchBytes = 8 * 1024 * 1024;
 }
 
 class Restore : public BSONTool {
@@ -46,10 +52,22 @@ public:
     string _curdb;
     string _curcoll;
     set<string> _users; // For restoring users with --drop
+    string _usersNs; // the namespace _users was read from
     scoped_ptr<Matcher> _opmatcher; // For oplog replay
     scoped_ptr<OpTime> _oplogLimitTS; // for oplog replay (limit)
     int _oplogEntrySkips; // oplog entries skipped
     int _oplogEntryApplies; // oplog entries applied
+
+    // A collection's data file, loaded once drillDown() has prepared every collection
+    struct LoadJob {
+        boost::filesystem::path file;
+        string ns;
+    };
+    vector<LoadJob> _loadJobs;
+
+    // Index specs, with their final namespaces, built once all the data is loaded
+    vector<BSONObj> _indexes;
+
     Restore() : BSONTool() { }
 
     virtual void printHelp(ostream& out) {
@@ -78,7 +96,7 @@ public:
                 return -1;
             }
 
-            if ( ! exists(root / "oplog.bson") ) {
+            if (mongoRestoreGlobalParams.archive.empty() && !exists(root / "oplog.bson")) {
                 log() << "No oplog file to replay. Make sure you run mongodump with --oplog." << endl;
                 return -1;
             }
@@ -157,6 +175,11 @@ public:
             }
         }
 
+        if (!mongoRestoreGlobalParams.archive.empty()) {
+            restoreArchive(mongoRestoreGlobalParams.archive);
+            return EXIT_CLEAN;
+        }
+
         /* If toolGlobalParams.db is not "" then the user specified a db name to restore as.
          *
          * In that case we better be given either a root directory that
@@ -169,6 +192,12 @@ public:
         drillDown(root, toolGlobalParams.db != "", toolGlobalParams.coll != "",
                   !(_oplogLimitTS.get() == NULL), true);
 
+        runInParallel(_loadJobs.size(), mongoRestoreGlobalParams.numParallelCollections, false,
+                      boost::bind(&Restore::loadCollection, this, _1, _2));
+        _loadJobs.clear();
+
+        buildIndexes();
+
         // should this happen for oplog replay as well?
         string err = conn().getLastError(toolGlobalParams.db == "" ? "admin" : toolGlobalParams.db);
         if (!err.empty()) {
@@ -294,34 +323,58 @@ public:
             exit(EXIT_FAILURE);
         }
 
+        BSONObj metadataObject;
+        if (mongoRestoreGlobalParams.restoreOptions || mongoRestoreGlobalParams.restoreIndexes) {
+            boost::filesystem::path metadataFile = (root.branch_path() / (oldCollName + ".metadata.json"));
+            if (!boost::filesystem::exists(metadataFile.string())) {
+                // This is fine because dumps from before 2.1 won't have a metadata file, just print a warning.
+                // System collections shouldn't have metadata so don't warn if that file is missing.
+                if (!startsWith(metadataFile.leaf().string(), "system.")) {
+                    log() << metadataFile.string() << " not found. Skipping." << endl;
+                }
+            } else {
+                metadataObject = parseMetadataFile(metadataFile.string());
+            }
+        }
+
+        prepareCollection(ns, metadataObject, root.leaf() == "system.users.bson");
+
+        if (mongoRestoreGlobalParams.numParallelCollections > 1 &&
+                root.leaf() != "system.users.bson" &&
+                nsToCollectionSubstring(ns) != "system.indexes") {
+            LoadJob job;
+            job.file = root;
+            job.ns = ns;
+            _loadJobs.push_back(job);
+        }
+        else {
+            processFile( root );
+        }
+
+        removeStaleUsers();
+    }
+
+    /**
+     * Readies ns to be loaded: drops it or reads its users as --drop asks, creates it with the
+     * options in metadataObject, queues its indexes and makes it the current namespace.
+     */
+    void prepareCollection(const string& ns, const BSONObj& metadataObject, bool isUsers) {
         log() << "\tgoing into namespace [" << ns << "]" << endl;
 
         if (mongoRestoreGlobalParams.drop) {
-            if (root.leaf() != "system.users.bson" ) {
+            if (!isUsers) {
                 log() << "\t dropping" << endl;
                 conn().dropCollection( ns );
             } else {
                 // Create map of the users currently in the DB
+                removeStaleUsers();
                 BSONObj fields = BSON("name" << 1);
                 scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
                 while (cursor->more()) {
                     BSONObj user = cursor->next();
                     _users.insert(user["name"].String());
                 }
-            }
-        }
-
-        BSONObj metadataObject;
-        if (mongoRestoreGlobalParams.restoreOptions || mongoRestoreGlobalParams.restoreIndexes) {
-            boost::filesystem::path metadataFile = (root.branch_path() / (oldCollName + ".metadata.json"));
-            if (!boost::filesystem::exists(metadataFile.string())) {
-                // This is fine because dumps from before 2.1 won't have a metadata file, just print a warning.
-                // System collections shouldn't have metadata so don't warn if that file is missing.
-                if (!startsWith(metadataFile.leaf().string(), "system.")) {
-                    log() << metadataFile.string() << " not found. Skipping." << endl;
-                }
-            } else {
-                metadataObject = parseMetadataFile(metadataFile.string());
+                _usersNs = ns;
             }
         }
 
@@ -346,16 +399,6 @@ public:
             createCollectionWithOptions(metadataObject["options"].Obj());
         }
 
-        processFile( root );
-        if (mongoRestoreGlobalParams.drop && root.leaf() == "system.users.bson") {
-            // Delete any users that used to exist but weren't in the dump file
-            for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
-                BSONObj userMatch = BSON("name" << *it);
-                conn().remove(ns, Query(userMatch));
-            }
-            _users.clear();
-        }
-
         if (mongoRestoreGlobalParams.restoreIndexes && metadataObject.hasField("indexes")) {
             vector<BSONElement> indexes = metadataObject["indexes"].Array();
             for (vector<BSONElement>::iterator it = indexes.begin(); it != indexes.end(); ++it) {
@@ -364,6 +407,107 @@ public:
         }
     }
 
+    // Deletes any users that used to exist but weren't in the dump
+    void removeStaleUsers() {
+        for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
+            BSONObj userMatch = BSON("name" << *it);
+            conn().remove(_usersNs, Query(userMatch));
+        }
+        _users.clear();
+    }
+
+    /**
+     * Restores a mongodump --archive from path, or from stdin if path is "-".  Collections are
+     * loaded in the order their blocks arrive, and --db and --collection select the namespaces
+     * to restore rather than rename them.
+     */
+    void restoreArchive(const string& path) {
+        FILE* f = stdin;
+        if (path != "-") {
+            f = fopen(path.c_str(), "rb");
+            uassert(17315, errnoWithPrefix("couldn't open archive"), f);
+        }
+
+        ArchiveReader archive(f);
+        ArchiveReader::Block block;
+        set<string> prepared;
+        bool replaying = false;
+        const boost::function<void(const BSONObj&)> sink =
+            boost::bind(&Restore::gotObject, this, _1);
+
+        while (archive.next(&block)) {
+            if (block.type == "oplog") {
+                if (!mongoRestoreGlobalParams.oplogReplay)
+                    continue;
+                if (!replaying) {
+                    // the oplog comes last; its ops apply to the fully loaded and indexed data
+                    buildIndexes();
+                    log() << "\t Replaying oplog" << endl;
+                    _curns = OPLOG_SENTINEL;
+                    replaying = true;
+                }
+                processBuffer(block.data.data(), block.data.size(), sink);
+                continue;
+            }
+
+            if (!shouldRestore(block.ns))
+                continue;
+
+            if (_oplogLimitTS.get()) {
+                error() << "The oplogLimit option cannot be used if "
+                        << "normal databases/collections exist in the archive."
+                        << endl;
+                exit(EXIT_FAILURE);
+            }
+
+            const bool isUsers = nsToCollectionSubstring(block.ns) == "system.users";
+            if (block.type == "metadata") {
+                if (prepared.insert(block.ns).second) {
+                    prepareCollection(block.ns, BSONObj(block.data.data()).getOwned(), isUsers);
+                }
+            }
+            else if (block.type == "data") {
+                if (prepared.insert(block.ns).second) {
+                    prepareCollection(block.ns, BSONObj(), isUsers);
+                }
+                _curns = block.ns;
+                _curdb = nsToDatabase(_curns);
+                _curcoll = nsToCollectionSubstring(_curns).toString();
+                processBuffer(block.data.data(), block.data.size(), sink);
+            }
+            else {
+                warning() << "skipping unknown archive block type " << block.type
+                          << " for " << block.ns << endl;
+            }
+        }
+
+        if (f != stdin)
+            fclose(f);
+
+        removeStaleUsers();
+
+        if (replaying) {
+            log() << "Applied " << _oplogEntryApplies << " oplog entries out of "
+                  << _oplogEntryApplies + _oplogEntrySkips << " (" << _oplogEntrySkips
+                  << " skipped)." << endl;
+        }
+        else {
+            buildIndexes();
+        }
+    }
+
+    // Whether an archived namespace passes --db, --collection and the system.profile skip
+    bool shouldRestore(const string& ns) {
+        NamespaceString nss(ns);
+        if (nss.coll() == "system.profile" || nss.coll() == "system.indexes")
+            return false;
+        if (toolGlobalParams.db != "" && nss.db() != toolGlobalParams.db)
+            return false;
+        if (toolGlobalParams.coll != "" && nss.coll() != toolGlobalParams.coll)
+            return false;
+        return true;
+    }
+
     virtual void gotObject( const BSONObj& obj ) {
         if (_curns == OPLOG_SENTINEL) { // intentional ptr compare
             if (obj["op"].valuestr()[0] == 'n') // skip no-ops
@@ -418,6 +562,86 @@ public:
 
 private:
 
+    /**
+     * Inserts the documents it is handed in batches, for loading a collection on a worker
+     * connection.
+     */
+    class BatchInserter {
+    public:
+        BatchInserter(DBClientBase& c, const string& ns)
+            : _conn(c), _ns(ns), _db(nsToDatabase(ns)), _bytes(0) {}
+
+        void operator()(const BSONObj& obj) {
+            if (_batch.size() >= insertBatchDocs || _bytes + obj.objsize() > insertBatchBytes)
+                flush();
+            _batch.push_back(obj.getOwned());
+            _bytes += obj.objsize();
+        }
+
+        void flush() {
+            if (_batch.empty())
+                return;
+
+            // like single inserts, a failed document doesn't stop the rest
+            _conn.insert(_ns, _batch, InsertOption_ContinueOnError);
+            _batch.clear();
+            _bytes = 0;
+
+            if (mongoRestoreGlobalParams.w > 0) {
+                string err = _conn.getLastError(_db, false, false, mongoRestoreGlobalParams.w);
+                if (!err.empty()) {
+                    error() << err;
+                }
+            }
+        }
+
+    private:
+        DBClientBase& _conn;
+        const string _ns;
+        const string _db;
+        vector<BSONObj> _batch;
+        int _bytes;
+    };
+
+    // Loads the data file of _loadJobs[i]; a job for runInParallel()
+    void loadCollection(DBClientBase& c, size_t i) {
+        const LoadJob& job = _loadJobs[i];
+        log() << "\tloading " << job.file.string() << " into " << job.ns << endl;
+        BatchInserter inserter(c, job.ns);
+        processFile(job.file, boost::ref(inserter));
+        inserter.flush();
+    }
+
+    // Builds the indexes of _indexes[i]'s collection; a job for runInParallel()
+    void buildCollectionIndexes(const vector<vector<BSONObj> >& byCollection,
+                                DBClientBase& c, size_t i) {
+        for (size_t j = 0; j < byCollection[i].size(); j++) {
+            buildIndex(c, byCollection[i][j]);
+        }
+    }
+
+    /**
+     * Builds the deferred indexes, numParallelCollections collections at a time.  A
+     * collection's own indexes are built one after another.
+     */
+    void buildIndexes() {
+        map<string, vector<BSONObj> > byNs;
+        for (vector<BSONObj>::const_iterator it = _indexes.begin(); it != _indexes.end(); ++it) {
+            byNs[(*it)["ns"].String()].push_back(*it);
+        }
+        _indexes.clear();
+
+        vector<vector<BSONObj> > byCollection;
+        for (map<string, vector<BSONObj> >::iterator it = byNs.begin(); it != byNs.end(); ++it) {
+            byCollection.push_back(vector<BSONObj>());
+            byCollection.back().swap(it->second);
+        }
+
+        runInParallel(byCollection.size(), mongoRestoreGlobalParams.numParallelCollections, false,
+                      boost::bind(&Restore::buildCollectionIndexes, this,
+                                  boost::cref(byCollection), _1, _2));
+    }
+
     BSONObj parseMetadataFile(string filePath) {
         long long fileSize = boost::filesystem::file_size(filePath);
         ifstream file(filePath.c_str(), ios_base::in);
@@ -507,6 +731,7 @@ private:
 
     /* We must handle if the dbname or collection name is different at restore time than what was dumped.
        If keepCollName is true, however, we keep the same collection name that's in the index object.
+       The index is built by buildIndexes(), after all the data has been loaded.
      */
     void createIndex(BSONObj indexObj, bool keepCollName) {
         BSONObjBuilder bo;
@@ -523,12 +748,16 @@ private:
                 bo.append(e);
             }
         }
-        BSONObj o = bo.obj();
+        _indexes.push_back(bo.obj());
+    }
+
+    void buildIndex(DBClientBase& c, const BSONObj& o) {
+        const string db = nsToDatabase(o["ns"].String());
         LOG(0) << "\tCreating index: " << o << endl;
-        conn().insert( _curdb + ".system.indexes" ,  o );
+        c.insert( db + ".system.indexes" ,  o );
 
         // We're stricter about errors for indexes than for regular data
-        BSONObj err = conn().getLastErrorDetailed(_curdb, false, false, mongoRestoreGlobalParams.w);
+        BSONObj err = c.getLastErrorDetailed(db, false, false, mongoRestoreGlobalParams.w);
 
         if (err.hasField("err") && !err["err"].isNull()) {
             if (err["err"].str() == "norepl" && mongoRestoreGlobalParams.w > 1) {
@@ -74,7 +74,7 @@ namespace mongo {
                 return e.embeddedObjectUserCheck();
             }
             BSONObj out;
-            if (!conn().simpleCommand(toolGlobalParams.db, &out, "serverStatus")) {
+            if (!conn().runCommand(toolGlobalParams.db, StatUtil::serverStatusCommand(), out)) {
                 cout << "error: " << out << endl;
                 return BSONObj();
             }
@@ -86,8 +86,10 @@ namespace mongo {
         }
 
         int run() {
-            _statUtil.setSeconds(mongoStatGlobalParams.allFields);
-            _statUtil.setAll(mongoStatGlobalParams.sleep);
+            _statUtil.setSeconds(mongoStatGlobalParams.intervalMillis > 0 ?
+                                 mongoStatGlobalParams.intervalMillis / 1000.0 :
+                                 mongoStatGlobalParams.sleep);
+            _statUtil.setAll(mongoStatGlobalParams.allFields);
             if (mongoStatGlobalParams.many)
                 return runMany();
             return runNormal();
@@ -145,7 +147,7 @@ namespace mongo {
 
             while (mongoStatGlobalParams.rowCount == 0 ||
                    rowNum < mongoStatGlobalParams.rowCount) {
-                sleepsecs((int)ceil(_statUtil.getSeconds()));
+                sleepmillis(static_cast<long long>(_statUtil.getSeconds() * 1000));
                 BSONObj now;
                 try {
                     now = stats();
@@ -219,7 +221,7 @@ namespace mongo {
             BSONObj authParams;
         };
 
-        static void serverThread( shared_ptr<ServerState> state , int sleepTime) {
+        static void serverThread( shared_ptr<ServerState> state , long long sleepMillis ) {
             try {
                 DBClientConnection conn( true );
                 conn._logLevel = logger::LogSeverity::Debug(1);
@@ -234,7 +236,7 @@ namespace mongo {
                 while ( ++cycleNumber ) {
                     try {
                         BSONObj out;
-                        if ( conn.simpleCommand( "admin" , &out , "serverStatus" ) ) {
+                        if ( conn.runCommand( "admin" , StatUtil::serverStatusCommand() , out ) ) {
                             scoped_lock lk( state->lock );
                             state->error = "";
                             state->lastUpdate = time(0);
@@ -271,7 +273,7 @@ namespace mongo {
                         state->error = e.what();
                     }
 
-                    sleepsecs( sleepTime );
+                    sleepmillis( sleepMillis );
                 }
 
 
@@ -296,7 +298,7 @@ namespace mongo {
             /* For each new thread, pass in a thread state object and the delta between samples */
             state->thr.reset( new boost::thread( boost::bind( serverThread,
                                                               state,
-                                                              (int)ceil(_statUtil.getSeconds()) ) ) );
+                                                              static_cast<long long>( _statUtil.getSeconds() * 1000 ) ) ) );
             state->authParams = BSON( "user" << toolGlobalParams.username <<
                                       "pwd" << toolGlobalParams.password <<
                                       "userSource" << getAuthenticationDatabase() <<
@@ -388,7 +390,7 @@ namespace mongo {
             int maxLockedDbWidth = 0;
 
             while ( 1 ) {
-                sleepsecs( (int)ceil(_statUtil.getSeconds()) );
+                sleepmillis( static_cast<long long>( _statUtil.getSeconds() * 1000 ) );
 
                 // collect data
                 vector<Row> rows;
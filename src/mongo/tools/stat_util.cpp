@@ -33,6 +33,14 @@ namespace mongo {
 
     }
 
+    BSONObj StatUtil::serverStatusCommand() {
+        return BSON( "serverStatus" << 1 <<
+                     "sections" << BSON_ARRAY( "opcounters" << "opcountersRepl" <<
+                                               "backgroundFlushing" << "mem" << "extra_info" <<
+                                               "locks" << "globalLock" << "indexCounters" <<
+                                               "network" << "connections" << "repl" ) );
+    }
+
     bool StatUtil::_in( const BSONElement& me , const BSONElement& arr ) {
         if ( me.type() != String || arr.type() != Array )
             return false;
@@ -229,7 +237,10 @@ namespace mongo {
                  << setfill('0') << setw(2) << t.tm_min
                  << ":"
                  << setfill('0') << setw(2) << t.tm_sec;
-            _append( result , "time" , 10 , temp.str() );
+            // rows less than a second apart need the milliseconds to tell them apart
+            if ( _seconds < 1 )
+                temp << "." << setfill('0') << setw(3) << curTimeMillis64() % 1000;
+            _append( result , "time" , _seconds < 1 ? 14 : 10 , temp.str() );
         }
         return result.obj();
     }
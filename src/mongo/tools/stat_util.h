@@ -83,6 +83,12 @@ namespace mongo {
         void setSeconds( double seconds ) { _seconds = seconds; }
         void setAll( bool all ) { _all = all; }
 
+        /**
+         * @return a serverStatus command that asks for only the sections doRow() reads.  Servers
+         * which don't know the "sections" field return everything.
+         */
+        static BSONObj serverStatusCommand();
+
         static NamespaceStats parseServerStatusLocks( const BSONObj& serverStatus );
         static vector<NamespaceDiff> computeDiff( const NamespaceStats& prev , const NamespaceStats& current );
     private:
@@ -18,11 +18,15 @@
 
 #include "mongo/tools/tool.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
 #include "mongo/base/initializer.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclient_rs.h"
 #include "mongo/client/sasl_client_authenticate.h"
 #include "mongo/db/auth/authorization_manager.h"
@@ -183,6 +187,101 @@ namespace mongo {
         return *_conn;
     }
 
+    DBClientBase* Tool::newConnection() {
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse(toolGlobalParams.connectionString, errmsg);
+        uassert(17302, "invalid hostname [" + toolGlobalParams.connectionString + "] " + errmsg,
+                cs.isValid());
+
+        DBClientBase* c = cs.connect(errmsg);
+        uassert(17303, "couldn't connect to [" + toolGlobalParams.connectionString + "] " + errmsg,
+                c);
+        try {
+            if (!toolGlobalParams.username.empty())
+                authenticate(c);
+        }
+        catch (...) {
+            delete c;
+            throw;
+        }
+        return c;
+    }
+
+    namespace {
+
+        /** The jobs of one runInParallel() call, handed out to its threads in order. */
+        class ParallelJobs {
+        public:
+            explicit ParallelJobs(size_t numJobs) : _numJobs(numJobs), _next(0) {}
+
+            /** @return false once the jobs are used up or one has failed */
+            bool take(size_t* i) {
+                boost::mutex::scoped_lock lk(_mutex);
+                if (!_error.empty() || _next >= _numJobs)
+                    return false;
+                *i = _next++;
+                return true;
+            }
+
+            void fail(const string& error) {
+                boost::mutex::scoped_lock lk(_mutex);
+                if (_error.empty())
+                    _error = error;
+            }
+
+            string error() {
+                boost::mutex::scoped_lock lk(_mutex);
+                return _error;
+            }
+
+        private:
+            boost::mutex _mutex;
+            const size_t _numJobs;
+            size_t _next;
+            string _error;
+        };
+
+        void runParallelJobs(ParallelJobs* jobs, DBClientBase* c, const Tool::ParallelJob* job) {
+            try {
+                size_t i;
+                while (jobs->take(&i))
+                    (*job)(*c, i);
+            }
+            catch (const DBException& e) {
+                jobs->fail(e.toString());
+            }
+            catch (const std::exception& e) {
+                jobs->fail(e.what());
+            }
+        }
+
+    }  // namespace
+
+    void Tool::runInParallel( size_t numJobs, unsigned numThreads, bool slaveIfPaired,
+                              const ParallelJob& job ) {
+        if (numThreads <= 1 || numJobs <= 1 || toolGlobalParams.useDirectClient) {
+            for (size_t i = 0; i < numJobs; i++)
+                job(conn(slaveIfPaired), i);
+            return;
+        }
+
+        OwnedPointerVector<DBClientBase> connections;
+        ParallelJobs jobs(numJobs);
+        boost::thread_group threads;
+        for (size_t t = 0; t < std::min<size_t>(numThreads, numJobs); t++) {
+            DBClientBase* c = newConnection();
+            connections.mutableVector().push_back(c);
+            if (slaveIfPaired && c->type() == ConnectionString::SET)
+                c = &static_cast<DBClientReplicaSet*>(c)->slaveConn();
+            threads.create_thread(boost::bind(&runParallelJobs, &jobs, c, &job));
+        }
+        threads.join_all();
+
+        string error = jobs.error();
+        if (!error.empty())
+            uasserted(17304, error);
+    }
+
     bool Tool::isMaster() {
         if (toolGlobalParams.useDirectClient) {
             return true;
@@ -236,11 +335,15 @@ namespace mongo {
             return;
         }
 
-        _conn->auth(BSON(saslCommandUserSourceFieldName << getAuthenticationDatabase() <<
-                         saslCommandUserFieldName << toolGlobalParams.username <<
-                         saslCommandPasswordFieldName << toolGlobalParams.password  <<
-                         saslCommandMechanismFieldName <<
-                         toolGlobalParams.authenticationMechanism));
+        authenticate(_conn);
+    }
+
+    void Tool::authenticate(DBClientBase* c) {
+        c->auth(BSON(saslCommandUserSourceFieldName << getAuthenticationDatabase() <<
+                     saslCommandUserFieldName << toolGlobalParams.username <<
+                     saslCommandPasswordFieldName << toolGlobalParams.password  <<
+                     saslCommandMechanismFieldName <<
+                     toolGlobalParams.authenticationMechanism));
     }
 
     BSONTool::BSONTool() : Tool(false/*usesstdout*/) { }
@@ -255,6 +358,11 @@ namespace mongo {
     }
 
     long long BSONTool::processFile( const boost::filesystem::path& root ) {
+        return processFile( root, boost::bind( &BSONTool::gotObject, this, _1 ) );
+    }
+
+    long long BSONTool::processFile( const boost::filesystem::path& root,
+                                     const boost::function<void (const BSONObj&)>& sink ) {
         std::string fileName = root.string();
 
         unsigned long long fileLength = file_size( root );
@@ -304,27 +412,8 @@ namespace mongo {
             verify( amt == (size_t)( size - 4 ) );
 
             BSONObj o( buf );
-            if (bsonToolGlobalParams.objcheck && !o.valid()) {
-                cerr << "INVALID OBJECT - going to try and print out " << endl;
-                cerr << "size: " << size << endl;
-                BSONObjIterator i(o);
-                while ( i.more() ) {
-                    BSONElement e = i.next();
-                    try {
-                        e.validate();
-                    }
-                    catch ( ... ) {
-                        cerr << "\t\t NEXT ONE IS INVALID" << endl;
-                    }
-                    cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
-                    cerr << "\t " << e << endl;
-                }
-            }
-
-            if (!bsonToolGlobalParams.hasFilter || _matcher->matches(o)) {
-                gotObject( o );
+            if ( processObject( o, sink ) )
                 processed++;
-            }
 
             read += o.objsize();
             num++;
@@ -343,6 +432,50 @@ namespace mongo {
         return processed;
     }
 
+    long long BSONTool::processBuffer( const char* data, size_t len,
+                                       const boost::function<void (const BSONObj&)>& sink ) {
+        long long processed = 0;
+        size_t pos = 0;
+        while ( pos < len ) {
+            uassert( 17312, "truncated object in buffer", len - pos >= 4 );
+            int size = *reinterpret_cast<const int*>( data + pos );
+            uassert( 17313, str::stream() << "invalid object size: " << size,
+                     size >= 5 && static_cast<size_t>( size ) <= len - pos );
+
+            BSONObj o( data + pos );
+            if ( processObject( o, sink ) )
+                processed++;
+            pos += size;
+        }
+        return processed;
+    }
+
+    bool BSONTool::processObject( const BSONObj& o,
+                                  const boost::function<void (const BSONObj&)>& sink ) {
+        if (bsonToolGlobalParams.objcheck && !o.valid()) {
+            cerr << "INVALID OBJECT - going to try and print out " << endl;
+            cerr << "size: " << o.objsize() << endl;
+            BSONObjIterator i(o);
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                try {
+                    e.validate();
+                }
+                catch ( ... ) {
+                    cerr << "\t\t NEXT ONE IS INVALID" << endl;
+                }
+                cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
+                cerr << "\t " << e << endl;
+            }
+        }
+
+        if (!bsonToolGlobalParams.hasFilter || _matcher->matches(o)) {
+            sink( o );
+            return true;
+        }
+        return false;
+    }
+
 }
 
 #if defined(_WIN32)
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <boost/function.hpp>
 #include <string>
 
 #if defined(_WIN32)
@@ -69,6 +70,23 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * Opens another connection to the server this tool is connected to, authenticated the
+         * same way, for a worker thread.  The caller owns the result.
+         */
+        mongo::DBClientBase* newConnection();
+
+        typedef boost::function<void (DBClientBase&, size_t)> ParallelJob;
+
+        /**
+         * Calls job(connection, i) for each i in [0, numJobs), on up to numThreads threads at
+         * once, each with its own connection.  With one thread, or a direct client, the jobs run
+         * in order on conn( slaveIfPaired ).  The first exception from a job stops the remaining
+         * jobs and is rethrown, as a UserException, once all threads have finished.
+         */
+        void runInParallel( size_t numJobs, unsigned numThreads, bool slaveIfPaired,
+                            const ParallelJob& job );
+
         bool _usesstdout;
         bool _autoreconnect;
 
@@ -79,6 +97,7 @@ namespace mongo {
 
     private:
         void auth();
+        void authenticate( DBClientBase* c );
     };
 
     class BSONTool : public Tool {
@@ -94,6 +113,23 @@ namespace mongo {
 
         long long processFile( const boost::filesystem::path& file );
 
+        /**
+         * Like processFile( file ), but hands each object that passes the filter to "sink"
+         * instead of gotObject().  The object is only valid during the call.
+         */
+        long long processFile( const boost::filesystem::path& file,
+                               const boost::function<void (const BSONObj&)>& sink );
+
+        /**
+         * Like processFile( file, sink ), for "len" bytes of objects back to back at "data".
+         * @return the number of objects that passed the filter
+         */
+        long long processBuffer( const char* data, size_t len,
+                                 const boost::function<void (const BSONObj&)>& sink );
+
+    private:
+        /** Validates "o" if asked to and hands it to "sink" if it passes the filter. */
+        bool processObject( const BSONObj& o, const boost::function<void (const BSONObj&)>& sink );
     };
 
 }
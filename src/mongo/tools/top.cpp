@@ -47,7 +47,10 @@ namespace mongo {
         NamespaceStats getDataLocks() {
 
             BSONObj out;
-            if (!conn().simpleCommand(toolGlobalParams.db, &out, "serverStatus")) {
+            // only the locks section; the rest of serverStatus isn't shown
+            if (!conn().runCommand(toolGlobalParams.db,
+                                   BSON("serverStatus" << 1 << "sections" << BSON_ARRAY("locks")),
+                                   out)) {
                 cout << "error: " << out << endl;
                 return NamespaceStats();
             }
@@ -0,0 +1,78 @@
+// coarse_clock.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/util/coarse_clock.h"
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // How often the coarse clock is refreshed, which bounds how far behind it can be.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(coarseClockTickMillis, int, 10);
+
+    namespace {
+
+        // 0 until the ticker has run once
+        AtomicUInt64 coarseNowMillis;
+
+        class CoarseClockTicker : public BackgroundJob {
+        public:
+            virtual string name() const { return "CoarseClockTicker"; }
+
+            virtual void run() {
+                const int tickMillis = std::max( coarseClockTickMillis, 1 );
+                while ( !inShutdown() ) {
+                    coarseNowMillis.store( curTimeMillis64() );
+                    sleepmillis( tickMillis );
+                }
+            }
+        };
+
+    }
+
+    unsigned long long coarseTimeMillis64() {
+        unsigned long long now = coarseNowMillis.load();
+        if ( MONGO_unlikely( now == 0 ) )
+            return curTimeMillis64();
+        return now;
+    }
+
+    void startCoarseClock() {
+        coarseNowMillis.store( curTimeMillis64() );
+        CoarseClockTicker* ticker = new CoarseClockTicker();
+        ticker->go();
+    }
+
+}  // namespace mongo
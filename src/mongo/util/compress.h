@@ -44,6 +44,10 @@ namespace mongo {
         char* compressed,
         size_t* compressed_length);
 
+    bool getUncompressedLength(const char* compressed, size_t compressed_length, size_t* result);
+    // 'uncompressed' must have room for getUncompressedLength() bytes
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed);
+
 }
 
 
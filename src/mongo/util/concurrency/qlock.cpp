@@ -0,0 +1,67 @@
+// @file qlock.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/util/concurrency/qlock.h"
+
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    namespace {
+        // slots are handed out round robin, so up to NumReaderSlots threads never share one
+        AtomicUInt32 nextReaderSlot;
+    }
+
+#if defined(__linux__) && defined(__GNUC__)
+    static __thread unsigned myReaderSlot; // slot + 1, 0 until assigned
+#elif defined(_WIN32)
+    static __declspec( thread ) unsigned myReaderSlot;
+#else
+    static ThreadLocalValue<unsigned> myReaderSlotValue;
+#endif
+
+    unsigned QLock::readerSlot() {
+#if defined(__linux__) && defined(__GNUC__) || defined(_WIN32)
+        if ( myReaderSlot == 0 )
+            myReaderSlot = nextReaderSlot.fetchAndAdd(1) % NumReaderSlots + 1;
+        return myReaderSlot - 1;
+#else
+        unsigned slot = myReaderSlotValue.get();
+        if ( slot == 0 ) {
+            slot = nextReaderSlot.fetchAndAdd(1) % NumReaderSlots + 1;
+            myReaderSlotValue.set( slot );
+        }
+        return slot - 1;
+#endif
+    }
+
+}
@@ -35,6 +35,7 @@
 #include <boost/thread/condition.hpp>
 #include "../assert_util.h"
 #include "../time_support.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo { 
 
@@ -72,6 +73,14 @@ namespace mongo {
         transition, all threads in the "w" state must be blocked in w_to_X().  When all threads in
         the "w" state are blocked in w_to_X(), one thread will be released in the X state.  The
         other threads remain blocked in w_to_X() until the thread in the X state calls X_to_w().
+
+        Readers ("r" and "R") aren't counted in one shared word, which every reader on every
+        core would write.  Each thread counts itself in one of NumReaderSlots padded slots, and
+        whoever needs to know how many readers there are sums the slots.  A reader takes the
+        lock without the mutex by incrementing its slot and then checking that nothing blocks
+        its mode (rBlockers/RBlockers); a thread that would block readers publishes that first
+        and then sums the slots, so one of the two always sees the other.  A reader that finds
+        its mode blocked backs out and queues under the mutex as before.
     */
     class QLock : boost::noncopyable {
         struct Z { 
@@ -79,9 +88,23 @@ namespace mongo {
             boost::condition c;
             int n;
         };
+
+        enum { NumReaderSlots = 64 };
+        struct ReaderSlot {
+            AtomicUInt32 n;
+            char pad[64 - sizeof(AtomicUInt32)]; // one slot per cache line
+        };
+        ReaderSlot rSlots[NumReaderSlots];
+        ReaderSlot RSlots[NumReaderSlots];
+
+        // while non-zero readers of the mode must take the mutex
+        AtomicUInt32 rBlockers;
+        AtomicUInt32 RBlockers;
+
         boost::mutex m;
-        Z r,w,R,W,U,X;
+        Z r,w,R,W,U,X;                // r.n and R.n are unused, the slots count the readers
         int numPendingGlobalWrites;  // >0 if someone wants to acquire a write lock
+        int numPendingIntentWrites;  // threads waiting in lock_w()
         long long generationX;
         long long generationXExit;
         void _lock_W();
@@ -90,10 +113,28 @@ namespace mongo {
             return numPendingGlobalWrites > 0;
         }
 
-        bool W_legal() const { return r.n + w.n + R.n + W.n + X.n == 0; }
+        /** @return this thread's slot; a thread always uses the same one */
+        static unsigned readerSlot();
+        static unsigned numReaders(const ReaderSlot* slots);
+        unsigned num_r() const { return numReaders(rSlots); }
+        unsigned num_R() const { return numReaders(RSlots); }
+
+        /**
+         * Call with m held after changing any of the counts that block readers, before looking
+         * at the reader counts.
+         */
+        void publishReaderBlockers() {
+            rBlockers.store( numPendingGlobalWrites + W.n + X.n );
+            RBlockers.store( numPendingGlobalWrites + numPendingIntentWrites + w.n + W.n + X.n );
+        }
+
+        bool fastLockReader(ReaderSlot* slots, AtomicUInt32& blockers, char me);
+        void fastUnlockReader(ReaderSlot* slots, AtomicUInt32& blockers, char me, int assertion);
+
+        bool W_legal() const { return num_r() + w.n + num_R() + W.n + X.n == 0; }
         bool R_legal_ignore_greed() const { return w.n + W.n + X.n == 0; }
         bool r_legal_ignore_greed() const { return W.n + X.n == 0; }
-        bool w_legal_ignore_greed() const { return R.n + W.n + X.n == 0; }
+        bool w_legal_ignore_greed() const { return num_R() + W.n + X.n == 0; }
 
         bool R_legal() const {
             return !_areQueueJumpingGlobalWritesPending() && R_legal_ignore_greed();
@@ -107,13 +148,14 @@ namespace mongo {
             return !_areQueueJumpingGlobalWritesPending() && r_legal_ignore_greed();
         }
 
-        bool X_legal() const { return w.n + r.n + R.n + W.n == 0; }
+        bool X_legal() const { return w.n + num_r() + num_R() + W.n == 0; }
 
         void notifyWeUnlocked(char me);
         static bool i_block(char me, char them);
     public:
         QLock() :
             numPendingGlobalWrites(0),
+            numPendingIntentWrites(0),
             generationX(0),
             generationXExit(0) {
         }
@@ -153,7 +195,7 @@ namespace mongo {
         }
         if( U.n ) {
             // U is highest priority
-            if( (r.n + w.n + W.n + X.n == 0) && (R.n == 1) ) {
+            if( (num_r() + w.n + W.n + X.n == 0) && (num_R() == 1) ) {
                 U.c.notify_one();
                 return;
             }
@@ -177,34 +219,81 @@ namespace mongo {
         }
     }
 
+    inline unsigned QLock::numReaders(const ReaderSlot* slots) {
+        // callers published their blockers with a fenced store, so plain loads suffice
+        unsigned n = 0;
+        for ( int i = 0; i < NumReaderSlots; i++ )
+            n += slots[i].n.loadRelaxed();
+        return n;
+    }
+
+    /** @return true if we got the lock in the "me" mode without the mutex */
+    inline bool QLock::fastLockReader(ReaderSlot* slots, AtomicUInt32& blockers, char me) {
+        ReaderSlot& slot = slots[readerSlot()];
+        // the locked add is a full barrier, so the load below can't move ahead of it
+        slot.n.fetchAndAdd(1);
+        if ( blockers.loadRelaxed() == 0 )
+            return true;
+
+        slot.n.fetchAndSubtract(1);
+        // someone blocking us may have counted us while we were in the slot
+        boost::mutex::scoped_lock lk(m);
+        if ( W.n == 0 )
+            notifyWeUnlocked(me);
+        return false;
+    }
+
+    inline void QLock::fastUnlockReader(ReaderSlot* slots, AtomicUInt32& blockers, char me,
+                                        int assertion) {
+        fassert(assertion, slots[readerSlot()].n.fetchAndSubtract(1) > 0);
+        if ( blockers.loadRelaxed() == 0 )
+            return;
+
+        boost::mutex::scoped_lock lk(m);
+        // a W may already have gotten in after our decrement; it waits for no one
+        if ( W.n == 0 )
+            notifyWeUnlocked(me);
+    }
+
     // "i will be reading. i promise to coordinate my activities with w's as i go with more 
     //  granular locks."
     inline void QLock::lock_r() {
+        if ( fastLockReader(rSlots, rBlockers, 'r') )
+            return;
+
         boost::mutex::scoped_lock lk(m);
         while( !r_legal() ) {
             r.c.wait(m);
         }
-        r.n++;
+        // nothing that blocks r can change while we hold m
+        rSlots[readerSlot()].n.fetchAndAdd(1);
     }
 
     // "i will be writing. i promise to coordinate my activities with w's and r's as i go with more 
     //  granular locks."
     inline void QLock::lock_w() { 
         boost::mutex::scoped_lock lk(m);
+        ++numPendingIntentWrites;
+        publishReaderBlockers();
         while( !w_legal() ) {
             w.c.wait(m);
         }
+        --numPendingIntentWrites;
         w.n++;
+        publishReaderBlockers();
     }
 
     // "i will be reading. i will coordinate with no one. you better stop them if they
     // are writing."
     inline void QLock::lock_R() {
+        if ( fastLockReader(RSlots, RBlockers, 'R') )
+            return;
+
         boost::mutex::scoped_lock lk(m);
         while( ! R_legal() ) {
             R.c.wait(m);
         }
-        R.n++;
+        RSlots[readerSlot()].n.fetchAndAdd(1);
     }
 
     inline bool QLock::lock_R_try(int millis) {
@@ -214,7 +303,7 @@ namespace mongo {
             R.c.timed_wait(m, boost::posix_time::milliseconds(millis));
         }
         if ( R_legal() ) {
-            R.n++;
+            RSlots[readerSlot()].n.fetchAndAdd(1);
             return true;
         }
         return false;
@@ -225,6 +314,7 @@ namespace mongo {
         boost::mutex::scoped_lock lk(m);
 
         ++numPendingGlobalWrites;
+        publishReaderBlockers();
         while (!W_legal() && curTimeMillis64() < end) {
             W.c.timed_wait(m, boost::posix_time::milliseconds(millis));
         }
@@ -232,10 +322,14 @@ namespace mongo {
 
         if (W_legal()) {
             W.n++;
+            publishReaderBlockers();
             fassert( 16202, W.n == 1 );
             return true;
         }
 
+        publishReaderBlockers();
+        if ( W.n == 0 )
+            notifyWeUnlocked('W');
         return false;
     }
 
@@ -244,10 +338,11 @@ namespace mongo {
     inline void QLock::W_to_R() { 
         boost::mutex::scoped_lock lk(m);
         fassert(16203, W.n == 1);
-        fassert(16204, R.n == 0);
+        fassert(16204, num_R() == 0);
         fassert(16205, U.n == 0);
+        RSlots[readerSlot()].n.fetchAndAdd(1);
         W.n = 0;
-        R.n = 1;
+        publishReaderBlockers();
         notifyWeUnlocked('W');
     }
 
@@ -263,26 +358,28 @@ namespace mongo {
     // YOU MAY DEADLOCK WITH THREADS LEAVING THE X STATE.
     inline void QLock::R_to_W() { 
         boost::mutex::scoped_lock lk(m);
-        fassert(16206, R.n > 0);
+        fassert(16206, num_R() > 0);
         fassert(16207, W.n == 0);
         fassert(16208, U.n == 0);
 
         U.n = 1;
 
         ++numPendingGlobalWrites;
+        publishReaderBlockers();
 
-        while( W.n + R.n + w.n + r.n > 1 ) {
+        while( W.n + num_R() + w.n + num_r() > 1 ) {
             U.c.wait(m);
         }
         --numPendingGlobalWrites;
 
-        fassert(16209, R.n == 1);
+        fassert(16209, num_R() == 1);
         fassert(16210, W.n == 0);
         fassert(16211, U.n == 1);
 
-        R.n = 0;
+        RSlots[readerSlot()].n.fetchAndSubtract(1);
         W.n = 1;
         U.n = 0;
+        publishReaderBlockers();
     }
 
     inline bool QLock::w_to_X() {
@@ -292,6 +389,7 @@ namespace mongo {
 
         ++X.n;
         --w.n;
+        publishReaderBlockers();
 
         long long myGeneration = generationX;
 
@@ -309,7 +407,7 @@ namespace mongo {
         while ( myGeneration == generationXExit )
             X.c.wait(m);
 
-        fassert( 16216, R.n == 0 );
+        fassert( 16216, num_R() == 0 );
         fassert( 16217, w.n > 0 );
         return false;
     }
@@ -318,12 +416,13 @@ namespace mongo {
         boost::mutex::scoped_lock lk(m);
 
         fassert( 16219, W.n == 0 );
-        fassert( 16220, R.n == 0 );
+        fassert( 16220, num_R() == 0 );
         fassert( 16221, w.n == 0 );
         fassert( 16222, X.n > 0 );
 
         w.n = X.n;
         X.n = 0;
+        publishReaderBlockers();
         ++generationXExit;
         notifyWeUnlocked('X');
     }
@@ -331,11 +430,13 @@ namespace mongo {
     // "i will be writing. i will coordinate with no one. you better stop them all"
     inline void QLock::_lock_W() {
         ++numPendingGlobalWrites;
+        publishReaderBlockers();
         while( !W_legal() ) {
             W.c.wait(m);
         }
         --numPendingGlobalWrites;
         W.n++;
+        publishReaderBlockers();
     }
     inline void QLock::lock_W() {
         boost::mutex::scoped_lock lk(m);
@@ -343,33 +444,29 @@ namespace mongo {
     }
 
     inline void QLock::unlock_r() {
-        boost::mutex::scoped_lock lk(m);
-        fassert(16137, r.n > 0);
-        --r.n;
-        notifyWeUnlocked('r');
+        fastUnlockReader(rSlots, rBlockers, 'r', 16137);
     }
     inline void QLock::unlock_w() {
         boost::mutex::scoped_lock lk(m);
         fassert(16138, w.n > 0);
         --w.n;
+        publishReaderBlockers();
         notifyWeUnlocked('w');
     }
 
     inline void QLock::unlock_R() {
-        boost::mutex::scoped_lock lk(m);
         _unlock_R();
     }
 
     inline void QLock::_unlock_R() {
-        fassert(16139, R.n > 0);
-        --R.n;
-        notifyWeUnlocked('R');
+        fastUnlockReader(RSlots, RBlockers, 'R', 16139);
     }
 
     inline void QLock::unlock_W() {
         boost::mutex::scoped_lock lk(m);
         fassert(16140, W.n == 1);
         --W.n;
+        publishReaderBlockers();
         notifyWeUnlocked('W');
     }
 
@@ -32,6 +32,7 @@
 
 #include "mutex.h"
 #include "../time_support.h"
+#include "qlock.h"
 #include "rwlockimpl.h"
 #if defined(_DEBUG)
 #include "mutexdebugger.h"
@@ -164,12 +165,21 @@ namespace mongo {
 
     // ----------------------------------------------------------------------------------------
 
-    /** recursive on shared locks is ok for this implementation */
-    class RWLockRecursive : protected RWLockBase {
+    /**
+     * recursive on shared locks is ok for this implementation.
+     * built on the R and W modes of a QLock, whose readers don't share a counter: these locks
+     * are taken shared by every operation.
+     */
+    class RWLockRecursive : boost::noncopyable {
     protected:
+        QLock _q;
         ThreadLocalValue<int> _state;
         void lock(); // not implemented - Lock() should be used; didn't overload this name to avoid mistakes
-        virtual void Lock() { RWLockBase::lock(); }
+        virtual void Lock() { _q.lock_W(); }
+        void unlock() { _q.unlock_W(); }
+        void lock_shared() { _q.lock_R(); }
+        void unlock_shared() { _q.unlock_R(); }
+        bool lock_try( int millis ) { return _q.lock_W_try( millis ); }
     public:
         virtual ~RWLockRecursive() { }
         const char * const _name;
@@ -247,14 +257,14 @@ namespace mongo {
             }
             if ( ! got ) {
                 log() << "couldn't lazily get rwlock" << endl;
-                RWLockBase::lock();
+                _q.lock_W();
             }
         }
 
     public:
         const int lowPriorityWaitMS;
         RWLockRecursiveNongreedy(const char *nm, int lpwaitms) : RWLockRecursive(nm), lowPriorityWaitMS(lpwaitms) { }
-        const char * implType() const { return RWLockRecursive::implType(); }
+        const char * implType() const { return "QLock"; }
 
         //just for testing:
         bool __lock_try( int millis ) { return RWLockRecursive::lock_try(millis); }
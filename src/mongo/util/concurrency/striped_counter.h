@@ -0,0 +1,78 @@
+// striped_counter.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * A counter for statistics that many threads bump at once, such as the operation counters.
+     *
+     * The count is split over padded slots, each on its own cache line, and each thread always
+     * adds to the same slot.  Threads on different cores then rarely write to the same cache
+     * line, at the cost of get() summing all the slots.  A get() racing with add()s may miss
+     * some of them, which is fine for statistics.
+     */
+    class StripedCounter : boost::noncopyable {
+    public:
+        StripedCounter() {}
+
+        void add( long long n ) { _slots[mySlot()].value.fetchAndAdd( n ); }
+        void increment() { add( 1 ); }
+
+        long long get() const {
+            long long total = 0;
+            for ( int i = 0; i < NumSlots; i++ )
+                total += _slots[i].value.load();
+            return total;
+        }
+
+    private:
+        enum {
+            NumSlots = 32, // threads share slots round robin, so about the number of cores
+            CacheLineSize = 64
+        };
+
+        struct Slot {
+            AtomicInt64 value;
+            char pad[CacheLineSize - sizeof(AtomicInt64)];
+        };
+
+        /** the slot this thread adds to, picked the first time it asks */
+        static int mySlot();
+
+        Slot _slots[NumSlots];
+    };
+
+}  // namespace mongo
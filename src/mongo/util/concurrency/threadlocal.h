@@ -94,6 +94,8 @@ namespace mongo {
     public:
         T* get() const;
         void reset(T* v);
+        // detaches the value from this thread without deleting it
+        T* release();
         T* getMake() { 
             T *t = get();
             if( t == 0 )
@@ -112,7 +114,12 @@ namespace mongo {
     void TSP<T>::reset(T* v) { \
         tsp.reset(v); \
         _ ## p = v; \
-    } 
+    } \
+    template<> T* TSP<T>::release() { \
+        T* v = tsp.release(); \
+        _ ## p = 0; \
+        return v; \
+    }
 # else
 
 #  define TSP_DECLARE(T,p) \
@@ -126,6 +133,11 @@ namespace mongo {
         tsp.reset(v); \
         _ ## p = v; \
     } \
+    template<> T* TSP<T>::release() { \
+        T* v = tsp.release(); \
+        _ ## p = 0; \
+        return v; \
+    } \
     TSP<T> p;
 # endif
 
@@ -157,6 +169,12 @@ namespace mongo {
             verify( pthread_setspecific( _key, v ) == 0 ); 
         }
 
+        T* release() {
+            T* v = get();
+            verify( pthread_setspecific( _key, NULL ) == 0 );
+            return v;
+        }
+
         T* getMake() { 
             T *t = get();
             if( t == 0 ) {
@@ -179,6 +197,7 @@ namespace mongo {
     public:
         T* get() const { return tsp.get(); }
         void reset(T* v) { tsp.reset(v); }
+        T* release() { return tsp.release(); }
         T* getMake() { 
             T *t = get();
             if( t == 0 )
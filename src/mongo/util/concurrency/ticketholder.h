@@ -26,6 +26,7 @@ namespace mongo {
         TicketHolder( int num ) : _mutex("TicketHolder") {
             _outof = num;
             _num = num;
+            _waiting = 0;
         }
 
         bool tryAcquire() {
@@ -36,9 +37,14 @@ namespace mongo {
         void waitForTicket() {
             scoped_lock lk( _mutex );
 
+            if ( _tryAcquire() )
+                return;
+
+            _waiting++;
             while( ! _tryAcquire() ) {
                 _newTicket.wait( lk.boost() );
             }
+            _waiting--;
         }
 
         void release() {
@@ -67,6 +73,22 @@ namespace mongo {
             _newTicket.notify_all();
         }
 
+        /**
+         * Like resize(), but shrinking below the number of tickets in use is allowed: no new
+         * tickets are handed out until enough of the outstanding ones have been released.
+         */
+        void resizeAllowingOverCommit( int newSize ) {
+            {
+                scoped_lock lk( _mutex );
+
+                int used = _outof - _num;
+                _outof = newSize;
+                _num = _outof - used;
+            }
+
+            _newTicket.notify_all();
+        }
+
         int available() const {
             return _num;
         }
@@ -77,13 +99,16 @@ namespace mongo {
 
         int outof() const { return _outof; }
 
+        /** @return the number of threads blocked in waitForTicket() */
+        int waiting() const {
+            scoped_lock lk( _mutex );
+            return _waiting;
+        }
+
     private:
 
         bool _tryAcquire(){
             if ( _num <= 0 ) {
-                if ( _num < 0 ) {
-                    std::cerr << "DISASTER! in TicketHolder" << std::endl;
-                }
                 return false;
             }
             _num--;
@@ -92,7 +117,8 @@ namespace mongo {
 
         int _outof;
         int _num;
-        mongo::mutex _mutex;
+        int _waiting;
+        mutable mongo::mutex _mutex;
         boost::condition_variable_any _newTicket;
     };
 
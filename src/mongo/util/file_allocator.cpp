@@ -36,6 +36,7 @@
 #   include <io.h>
 #endif
 
+#include "mongo/db/jsobj.h"
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/mongoutils/str.h"
@@ -79,7 +80,9 @@ namespace mongo {
     }
 
     FileAllocator::FileAllocator()
-        : _pendingMutex("FileAllocator"), _failed() {
+        : _pendingMutex("FileAllocator"), _failed(),
+          _allocations(0), _bytesAllocated(0), _allocationMillis(0),
+          _waits(0), _waitMicros(0), _millisPerMB(0) {
     }
 
 
@@ -120,11 +123,32 @@ namespace mongo {
             _pending.insert( i, name );
         }
         _pendingUpdated.notify_all();
+        if ( !inProgress( name ) )
+            return;
+
+        Timer t;
         while( inProgress( name ) ) {
             checkFailure();
             _pendingUpdated.wait( lk.boost() );
         }
+        _waits++;
+        _waitMicros += t.micros();
+    }
 
+    long long FileAllocator::expectedAllocationMillis( long size ) const {
+        scoped_lock lk( _pendingMutex );
+        return static_cast<long long>( _millisPerMB * size / ( 1024 * 1024 ) );
+    }
+
+    void FileAllocator::appendStats( BSONObjBuilder& b ) const {
+        scoped_lock lk( _pendingMutex );
+        b.appendNumber( "allocations", _allocations );
+        b.appendNumber( "bytesAllocated", _bytesAllocated );
+        b.appendNumber( "allocationMillis", _allocationMillis );
+        b.appendNumber( "pending", static_cast<long long>( _pending.size() ) );
+        b.appendNumber( "waits", _waits );
+        b.appendNumber( "waitMillis", _waitMicros / 1000 );
+        b.appendBool( "failed", _failed );
     }
 
     void FileAllocator::waitUntilFinished() const {
@@ -167,11 +191,39 @@ namespace mongo {
 #endif
 
 #if defined(__linux__)
+        // fallocate reserves the blocks without writing them where the filesystem supports it.
+        // posix_fallocate falls back to writing to each block otherwise.
+        static bool fallocateWorks = true;
+        if ( fallocateWorks ) {
+            if ( fallocate(fd, 0, 0, size) == 0 )
+                return;
+            int e = errno;
+            if ( e == EOPNOTSUPP || e == ENOSYS ) {
+                LOG(1) << "FileAllocator: fallocate not supported, using posix_fallocate" << endl;
+                fallocateWorks = false;
+            }
+            else {
+                log() << "FileAllocator: fallocate failed: " << errnoWithDescription( e ) << " falling back" << endl;
+            }
+        }
+
         int ret = posix_fallocate(fd,0,size);
         if ( ret == 0 )
             return;
 
         log() << "FileAllocator: posix_fallocate failed: " << errnoWithDescription( ret ) << " falling back" << endl;
+#elif defined(__APPLE__)
+        fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0 };
+        int ret = fcntl(fd, F_PREALLOCATE, &store);
+        if ( ret == -1 ) {
+            // not enough contiguous space, take any
+            store.fst_flags = F_ALLOCATEALL;
+            ret = fcntl(fd, F_PREALLOCATE, &store);
+        }
+        if ( ret != -1 && ftruncate(fd, size) == 0 )
+            return;
+
+        log() << "FileAllocator: F_PREALLOCATE failed: " << errnoWithDescription() << " falling back" << endl;
 #endif
 
         off_t filelen = lseek( fd, 0, SEEK_END );
@@ -282,7 +334,7 @@ namespace mongo {
                 string tmp;
                 long fd = 0;
                 try {
-                    log() << "allocating new datafile " << name << ", filling with zeroes..." << endl;
+                    log() << "allocating new datafile " << name << "..." << endl;
                     
                     boost::filesystem::path parent = ensureParentDirCreated(name);
                     tmp = fa->makeTempFileName( parent );
@@ -326,6 +378,15 @@ namespace mongo {
                           << " took " << ((double)t.millis())/1000.0 << " secs"
                           << endl;
 
+                    {
+                        scoped_lock lk( fa->_pendingMutex );
+                        long long millis = t.millis();
+                        fa->_allocations++;
+                        fa->_bytesAllocated += size;
+                        fa->_allocationMillis += millis;
+                        fa->_millisPerMB = static_cast<double>( millis ) * 1024 * 1024 / size;
+                    }
+
                     // no longer in a failed state. allow new writers.
                     fa->_failed = false;
                 }
@@ -56,6 +56,15 @@ namespace mongo {
         
         bool hasFailed() const;
 
+        /**
+         * @return how long allocating a file of this size is expected to take, going by the
+         *  allocations done so far.  0 before the first allocation.
+         */
+        long long expectedAllocationMillis( long size ) const;
+
+        /** for serverStatus */
+        void appendStats( BSONObjBuilder& b ) const;
+
         static void ensureLength(int fd, long size);
 
         /** @return the singleton */
@@ -91,6 +100,14 @@ namespace mongo {
 
         bool _failed;
 
+        // statistics, protected by _pendingMutex
+        long long _allocations;
+        long long _bytesAllocated;
+        long long _allocationMillis;
+        long long _waits;            // allocateAsap() calls which had to wait for the file
+        long long _waitMicros;
+        double _millisPerMB;         // of the last allocation
+
         static FileAllocator* _instance;
 
     };
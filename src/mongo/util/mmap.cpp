@@ -137,6 +137,41 @@ namespace {
         return total;
     }
 
+    /*static*/ unsigned long long MongoFile::writeBackSome( WriteBackCursor* cursor,
+                                                           unsigned long long maxBytes ) {
+        unsigned long long covered = 0;
+        if ( cursor->done )
+            return covered;
+
+        LockMongoFilesShared lk;
+
+        // files are opened and closed between calls, so find our place again by name
+        map<string,MongoFile*>::iterator i = pathToFile.lower_bound( cursor->filename );
+        if ( i != pathToFile.end() && i->first != cursor->filename )
+            cursor->offset = 0;
+
+        while ( i != pathToFile.end() && covered < maxBytes ) {
+            MongoFile* mmf = i->second;
+            unsigned long long len = mmf->length();
+            if ( cursor->offset >= len ) {
+                ++i;
+                cursor->offset = 0;
+                continue;
+            }
+
+            unsigned long long n = std::min( maxBytes - covered, len - cursor->offset );
+            mmf->writeBack( cursor->offset, n );
+            covered += n;
+            cursor->filename = i->first;
+            cursor->offset += n;
+        }
+
+        if ( i == pathToFile.end() )
+            cursor->done = true;
+
+        return covered;
+    }
+
     void nullFunc() { }
 
     // callback notifications
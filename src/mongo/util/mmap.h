@@ -31,6 +31,9 @@ namespace mongo {
         enum Advice { Sequential=1 , Random=2 };
         MAdvise(void *p, unsigned len, Advice a); 
         ~MAdvise(); // destructor resets the range to MADV_NORMAL
+
+        /** asks the OS to start reading the range in (MADV_WILLNEED); not undone by anything */
+        static void willNeed(void *p, unsigned len);
     };
 
     // lock order: lock dbMutex before this if you lock both
@@ -95,6 +98,21 @@ namespace mongo {
 
         static int flushAll( bool sync ); // returns n flushed
         static long long totalMappedLength();
+
+        /** where a writeBackSome() sweep over the open files has got to */
+        struct WriteBackCursor {
+            WriteBackCursor() : offset(0), done(false) { }
+            string filename;
+            unsigned long long offset;
+            bool done; // passed the last file
+        };
+
+        /** starts writeback of the dirty pages in the next maxBytes of mapped data after cursor,
+            going through the files in filename order, and advances cursor past them.  does not
+            wait for the writes, so a flushAll(true) at the end of a sweep has little left to do.
+            @return the number of bytes covered; 0 once the sweep has passed the last file.
+        */
+        static unsigned long long writeBackSome( WriteBackCursor* cursor, unsigned long long maxBytes );
         static void closeAllFiles( stringstream &message );
 
         virtual bool isDurableMappedFile() { return false; }
@@ -114,6 +132,11 @@ namespace mongo {
          */
         virtual Flushable * prepareFlush() = 0;
 
+        /** starts writing back dirty pages in [offset, offset+len) without waiting for them.
+            offset is a multiple of the page size.  a no-op where the platform can't do that.
+        */
+        virtual void writeBack( unsigned long long offset, unsigned long long len ) { }
+
         void created(); /* subclass must call after create */
 
         /* subclass must call in destructor (or at close).
@@ -181,6 +204,7 @@ namespace mongo {
 
         void flush(bool sync);
         virtual Flushable * prepareFlush();
+        virtual void writeBack( unsigned long long offset, unsigned long long len );
 
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
@@ -221,6 +245,13 @@ namespace mongo {
 
         /** close the current private view and open a new replacement */
         void* remapPrivateView(void *oldPrivateAddr);
+
+#if !defined(_WIN32)
+        /** replace [ofs, ofs+len) of the private view with a fresh copy of the file.
+            ofs is a multiple of the page size.
+        */
+        void remapPrivateViewRange(void *privateView, unsigned long long ofs, unsigned long long len);
+#endif
     };
 
     /** p is called from within a mutex that MongoFile uses.  so be careful not to deadlock. */
@@ -70,6 +70,7 @@ namespace mongo {
 #if defined(__sunos__)
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
+    void MAdvise::willNeed(void *, unsigned) { }
 #else
     MAdvise::MAdvise(void *p, unsigned len, Advice a) {
         
@@ -92,6 +93,13 @@ namespace mongo {
     MAdvise::~MAdvise() { 
         madvise(_p,_len,MADV_NORMAL);
     }
+    void MAdvise::willNeed(void *p, unsigned len) {
+        void *start = (void*)((long)p & ~(g_minOSPageSizeBytes-1));
+        len += (unsigned long long)p-(unsigned long long)start;
+        if ( madvise(start,len,MADV_WILLNEED) ) {
+            LOG(1) << "madvise(MADV_WILLNEED) failed: " << errnoWithDescription() << endl;
+        }
+    }
 #endif
 
     void* MemoryMappedFile::map(const char *filename, unsigned long long &length, int options) {
@@ -195,6 +203,21 @@ namespace mongo {
         return x;
     }
 
+    void MemoryMappedFile::remapPrivateViewRange(void *privateView, unsigned long long ofs,
+                                                 unsigned long long len) {
+        // mmap over just that part of the old region; the rest of the view keeps its pages
+        void * start = static_cast<char*>(privateView) + ofs;
+        void * x = mmap( start, len , PROT_READ|PROT_WRITE , MAP_PRIVATE|MAP_NORESERVE|MAP_FIXED , fd , ofs );
+        if( x == MAP_FAILED ) {
+            int err = errno;
+            error()  << "17323 Couldn't remap private view range: " << errnoWithDescription(err) << endl;
+            log() << "aborting" << endl;
+            printMemInfo();
+            abort();
+        }
+        verify( x == start );
+    }
+
     void MemoryMappedFile::flush(bool sync) {
         if ( views.empty() || fd == 0 )
             return;
@@ -202,6 +225,20 @@ namespace mongo {
             problem() << "msync " << errnoWithDescription() << endl;
     }
 
+    void MemoryMappedFile::writeBack( unsigned long long offset, unsigned long long len ) {
+        if ( views.empty() || fd == 0 )
+            return;
+#if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+        // msync(MS_ASYNC) is a no-op on linux, but pages dirtied through a shared mapping are
+        // dirty in the page cache, so ask for the file range to be written out
+        if ( sync_file_range(fd, offset, len, SYNC_FILE_RANGE_WRITE) )
+            problem() << "sync_file_range " << errnoWithDescription() << endl;
+#else
+        if ( msync(static_cast<char*>(viewForFlushing()) + offset, len, MS_ASYNC) )
+            problem() << "msync " << errnoWithDescription() << endl;
+#endif
+    }
+
     class PosixFlushable : public MemoryMappedFile::Flushable {
     public:
         PosixFlushable( void * view , HANDLE fd , long len )
@@ -42,6 +42,7 @@ namespace mongo {
 
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
+    void MAdvise::willNeed(void *, unsigned) { }
 
     static unsigned long long _nextMemoryMappedFileLocation = 256LL * 1024LL * 1024LL * 1024LL;
     static SimpleMutex _nextMemoryMappedFileLocationMutex( "nextMemoryMappedFileLocationMutex" );
@@ -400,6 +401,11 @@ namespace mongo {
         }
     }
 
+    void MemoryMappedFile::writeBack( unsigned long long offset, unsigned long long len ) {
+        // FlushViewOfFile waits for the writes and needs the same care with WRITETODATAFILES()
+        // as WindowsFlushable, so windows leaves all the writing to flush()
+    }
+
     MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlush() {
         return new WindowsFlushable( viewForFlushing() , fd , filename() , _flushMutex );
     }
@@ -40,6 +40,7 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #ifdef __openbsd__
 # include <sys/uio.h>
@@ -55,6 +56,14 @@
 
 namespace mongo {
 
+    namespace {
+        // Connections the kernel may queue before initAndListen() accepts them; it caps
+        // this at net.core.somaxconn.  128 overflowed during reconnect storms.
+        const int listenBacklog = 4096;
+
+        // Most connections taken from one listening socket before checking the others
+        const int maxAcceptsPerWakeup = 256;
+    }
 
     // ----- Listener -------
 
@@ -171,11 +180,19 @@ namespace mongo {
             }
 #endif
             
-            if ( ::listen(sock, 128) != 0 ) {
+            if ( ::listen(sock, listenBacklog) != 0 ) {
                 error() << "listen(): listen() failed " << errnoWithDescription() << endl;
                 return;
             }
 
+#if !defined(_WIN32)
+            // initAndListen() accepts until the queue is empty
+            if (fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK) == -1) {
+                error() << "listen(): couldn't make socket non-blocking " << errnoWithDescription() << endl;
+                return;
+            }
+#endif
+
             ListeningSockets::get()->add( sock );
 
             _socks.push_back(sock);
@@ -254,55 +271,69 @@ namespace mongo {
             for (vector<SOCKET>::iterator it=_socks.begin(), end=_socks.end(); it != end; ++it) {
                 if (! (FD_ISSET(*it, fds)))
                     continue;
-                SockAddr from;
-                int s = accept(*it, from.raw(), &from.addressSize);
-                if ( s < 0 ) {
-                    int x = errno; // so no global issues
-                    if (x == EBADF) {
-                        log() << "Port " << _port << " is no longer valid" << endl;
-                        return;
-                    }
-                    else if (x == ECONNABORTED) {
-                        log() << "Connection on port " << _port << " aborted" << endl;
-                        continue;
-                    }
-                    if ( x == 0 && inShutdown() ) {
-                        return;   // socket closed
-                    }
-                    if( !inShutdown() ) {
-                        log() << "Listener: accept() returns " << s << " " << errnoWithDescription(x) << endl;
-                        if (x == EMFILE || x == ENFILE) {
-                            // Connection still in listen queue but we can't accept it yet
-                            error() << "Out of file descriptors. Waiting one second before trying to accept more connections." << warnings;
-                            sleepsecs(1);
+
+                // The listening sockets are non-blocking, so take everything that is already
+                // queued instead of going back to select() for every connection.
+                for (int n = 0; n < maxAcceptsPerWakeup; n++) {
+                    SockAddr from;
+                    int s = accept(*it, from.raw(), &from.addressSize);
+                    if ( s < 0 ) {
+                        int x = errno; // so no global issues
+                        if (x == EAGAIN || x == EWOULDBLOCK) {
+                            break;
+                        }
+                        if (x == EBADF) {
+                            log() << "Port " << _port << " is no longer valid" << endl;
+                            return;
+                        }
+                        else if (x == ECONNABORTED) {
+                            log() << "Connection on port " << _port << " aborted" << endl;
+                            continue;
+                        }
+                        if ( x == 0 && inShutdown() ) {
+                            return;   // socket closed
                         }
+                        if( !inShutdown() ) {
+                            log() << "Listener: accept() returns " << s << " " << errnoWithDescription(x) << endl;
+                            if (x == EMFILE || x == ENFILE) {
+                                // Connection still in listen queue but we can't accept it yet
+                                error() << "Out of file descriptors. Waiting one second before trying to accept more connections." << warnings;
+                                sleepsecs(1);
+                            }
+                        }
+                        break;
                     }
-                    continue;
-                }
-                if (from.getType() != AF_UNIX)
-                    disableNagle(s);
+
+#if !defined(__linux__)
+                    // other systems hand the listening socket's O_NONBLOCK down to accepted ones
+                    fcntl(s, F_SETFL, fcntl(s, F_GETFL) & ~O_NONBLOCK);
+#endif
+
+                    if (from.getType() != AF_UNIX)
+                        disableNagle(s);
 
 #ifdef SO_NOSIGPIPE
-                // ignore SIGPIPE signals on osx, to avoid process exit
-                const int one = 1;
-                setsockopt( s , SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(int));
+                    // ignore SIGPIPE signals on osx, to avoid process exit
+                    const int one = 1;
+                    setsockopt( s , SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(int));
 #endif
 
-                long long myConnectionNumber = globalConnectionNumber.addAndFetch(1);
+                    long long myConnectionNumber = globalConnectionNumber.addAndFetch(1);
 
-                if (_logConnect && !serverGlobalParams.quiet) {
-                    int conns = globalTicketHolder.used()+1;
-                    const char* word = (conns == 1 ? " connection" : " connections");
-                    log() << "connection accepted from " << from.toString() << " #" << myConnectionNumber << " (" << conns << word << " now open)" << endl;
-                }
-                
-                boost::shared_ptr<Socket> pnewSock( new Socket(s, from) );
+                    if (_logConnect && !serverGlobalParams.quiet) {
+                        int conns = globalTicketHolder.used()+1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "connection accepted from " << from.toString() << " #" << myConnectionNumber << " (" << conns << word << " now open)" << endl;
+                    }
+
+                    boost::shared_ptr<Socket> pnewSock( new Socket(s, from) );
 #ifdef MONGO_SSL
-                if (_ssl) {
-                    pnewSock->secureAccepted(_ssl);
-                }
+                    if (_ssl) {
+                        pnewSock->secureAccepted(_ssl);
+                    }
 #endif
-                accepted( pnewSock , myConnectionNumber );
+                    accepted( pnewSock , myConnectionNumber );
+                }
             }
         }
     }
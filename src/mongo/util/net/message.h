@@ -22,6 +22,7 @@
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/hostandport.h"
+#include "mongo/util/net/message_buffer_pool.h"
 #include "mongo/util/net/sock.h"
 
 namespace mongo {
@@ -46,7 +47,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        dbCompressed = 2012 /* another message, compressed. see message_compression.h */
     };
 
     bool doesOpGetAResponse( int op );
@@ -62,6 +64,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -77,6 +80,7 @@ namespace mongo {
         case dbQuery:
         case dbGetMore:
         case dbKillCursors:
+        case dbCompressed:
             return false;
 
         case dbUpdate:
@@ -153,12 +157,12 @@ namespace mongo {
     class Message {
     public:
         // we assume here that a vector with initial size 0 does no allocation (0 is the default, but wanted to make it explicit).
-        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ) {}
+        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ), _pooledCapacity( 0 ) {}
         Message( void * data , bool freeIt ) :
-            _buf( 0 ), _data( 0 ), _freeIt( false ) {
+            _buf( 0 ), _data( 0 ), _freeIt( false ), _pooledCapacity( 0 ) {
             _setData( reinterpret_cast< MsgData* >( data ), freeIt );
         };
-        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ) {
+        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ), _pooledCapacity( 0 ) {
             *this = r;
         }
         ~Message() {
@@ -225,6 +229,8 @@ namespace mongo {
             verify( r._freeIt );
             _buf = r._buf;
             r._buf = 0;
+            _pooledCapacity = r._pooledCapacity;
+            r._pooledCapacity = 0;
             if ( r._data.size() > 0 ) {
                 _data.swap( r._data );
             }
@@ -235,7 +241,11 @@ namespace mongo {
 
         void reset() {
             if ( _freeIt ) {
-                if ( _buf ) {
+                if ( _buf && _pooledCapacity ) {
+                    MessageBufferPool::release( reinterpret_cast< char* >( _buf ),
+                                                _pooledCapacity );
+                }
+                else if ( _buf ) {
                     free( _buf );
                 }
                 for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
@@ -246,6 +256,7 @@ namespace mongo {
             _buf = 0;
             _data.clear();
             _freeIt = false;
+            _pooledCapacity = 0;
         }
 
         // use to add a buffer
@@ -264,6 +275,7 @@ namespace mongo {
             if ( _buf ) {
                 _data.push_back(std::make_pair((char*)_buf, _buf->len));
                 _buf = 0;
+                _pooledCapacity = 0;
             }
             _data.push_back(std::make_pair(d, size));
             header()->len += size;
@@ -274,6 +286,12 @@ namespace mongo {
             verify( empty() );
             _setData( d, freeIt );
         }
+        // use to set first buffer if empty, with 'd' from MessageBufferPool::allocate
+        void setPooledData(MsgData *d, int capacity) {
+            verify( empty() );
+            _setData( d, true );
+            _pooledCapacity = capacity;
+        }
         void setData(int operation, const char *msgtxt) {
             setData(operation, msgtxt, strlen(msgtxt)+1);
         }
@@ -299,6 +317,7 @@ namespace mongo {
         void _setData( MsgData *d, bool freeIt ) {
             _freeIt = freeIt;
             _buf = d;
+            _pooledCapacity = 0;
         }
         // if just one buffer, keep it in _buf, otherwise keep a sequence of buffers in _data
         MsgData * _buf;
@@ -306,6 +325,8 @@ namespace mongo {
         typedef std::vector< std::pair< char*, int > > MsgVec;
         MsgVec _data;
         bool _freeIt;
+        // if non zero, _buf came from MessageBufferPool and has this many bytes
+        int _pooledCapacity;
     };
 
 
@@ -0,0 +1,113 @@
+// message_buffer_pool.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_buffer_pool.h"
+
+#include <boost/thread/tss.hpp>
+
+namespace mongo {
+
+    namespace {
+
+        // 1KB, 2KB, ... 64KB
+        const int numSizeClasses = 7;
+
+        // Returns the class whose buffers hold 'size' bytes, or -1 if 'size' is not pooled
+        int sizeClassFor( int size ) {
+            int classBytes = MessageBufferPool::minPooledBytes;
+            for ( int i = 0; i < numSizeClasses; i++ ) {
+                if ( size <= classBytes )
+                    return i;
+                classBytes <<= 1;
+            }
+            return -1;
+        }
+
+        class ThreadBuffers {
+        public:
+            ThreadBuffers() {
+                for ( int i = 0; i < numSizeClasses; i++ )
+                    _count[i] = 0;
+            }
+
+            ~ThreadBuffers() {
+                for ( int i = 0; i < numSizeClasses; i++ ) {
+                    for ( int j = 0; j < _count[i]; j++ )
+                        free( _free[i][j] );
+                }
+            }
+
+            char* pop( int sizeClass ) {
+                if ( _count[sizeClass] == 0 )
+                    return NULL;
+                return _free[sizeClass][--_count[sizeClass]];
+            }
+
+            bool push( int sizeClass, char* buf ) {
+                if ( _count[sizeClass] == MessageBufferPool::maxBuffersPerClass )
+                    return false;
+                _free[sizeClass][_count[sizeClass]++] = buf;
+                return true;
+            }
+
+        private:
+            char* _free[numSizeClasses][MessageBufferPool::maxBuffersPerClass];
+            int _count[numSizeClasses];
+        };
+
+        boost::thread_specific_ptr<ThreadBuffers> threadBuffers;
+
+        ThreadBuffers* getThreadBuffers() {
+            ThreadBuffers* buffers = threadBuffers.get();
+            if ( ! buffers ) {
+                buffers = new ThreadBuffers();
+                threadBuffers.reset( buffers );
+            }
+            return buffers;
+        }
+
+    } // namespace
+
+    char* MessageBufferPool::allocate( int size, int* capacity ) {
+        int sizeClass = sizeClassFor( size );
+        if ( sizeClass < 0 ) {
+            // round up to a 1KB multiple like unpooled receive buffers always were
+            *capacity = ( size + 1023 ) & 0xfffffc00;
+            return static_cast<char*>( malloc( *capacity ) );
+        }
+
+        *capacity = minPooledBytes << sizeClass;
+        char* buf = getThreadBuffers()->pop( sizeClass );
+        if ( buf )
+            return buf;
+        return static_cast<char*>( malloc( *capacity ) );
+    }
+
+    void MessageBufferPool::release( char* buf, int capacity ) {
+        if ( ! buf )
+            return;
+
+        int sizeClass = sizeClassFor( capacity );
+        if ( sizeClass < 0 || ( minPooledBytes << sizeClass ) != capacity ||
+             ! getThreadBuffers()->push( sizeClass, buf ) ) {
+            free( buf );
+        }
+    }
+
+} // namespace mongo
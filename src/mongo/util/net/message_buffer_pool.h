@@ -0,0 +1,53 @@
+// message_buffer_pool.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * Per-thread free lists of the buffers MessagingPort::recv reads messages into, so that a
+     * connection thread reuses the same few buffers instead of calling malloc and free for
+     * every request.
+     *
+     * Buffers of up to maxPooledBytes come in power of two size classes starting at
+     * minPooledBytes.  Each thread keeps at most maxBuffersPerClass free buffers of each
+     * class; anything beyond that, and any larger buffer, is freed.  A buffer may be released
+     * on a different thread than the one that allocated it.
+     *
+     * All buffers come from malloc, so a pooled buffer can still be handed to free().
+     */
+    class MessageBufferPool {
+    public:
+        static const int minPooledBytes = 1024;
+        static const int maxPooledBytes = 64 * 1024;
+        static const int maxBuffersPerClass = 8;
+
+        /**
+         * Returns a buffer of at least 'size' bytes and sets '*capacity' to its actual size,
+         * which must be passed back to release().
+         */
+        static char* allocate( int size, int* capacity );
+
+        /**
+         * Keeps 'buf' for reuse by this thread, or frees it if its class is full or it is not
+         * a pooled size.
+         */
+        static void release( char* buf, int capacity );
+    };
+
+} // namespace mongo
@@ -0,0 +1,81 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_buffer_pool.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+
+namespace {
+
+    using namespace mongo;
+
+    TEST(MessageBufferPoolTest, SizeClasses) {
+        int capacity;
+        char* buf = MessageBufferPool::allocate(100, &capacity);
+        ASSERT_EQUALS(1024, capacity);
+        MessageBufferPool::release(buf, capacity);
+
+        buf = MessageBufferPool::allocate(1025, &capacity);
+        ASSERT_EQUALS(2048, capacity);
+        MessageBufferPool::release(buf, capacity);
+
+        buf = MessageBufferPool::allocate(MessageBufferPool::maxPooledBytes + 1, &capacity);
+        ASSERT_EQUALS(MessageBufferPool::maxPooledBytes + 1024, capacity);
+        MessageBufferPool::release(buf, capacity);
+    }
+
+    TEST(MessageBufferPoolTest, ReleasedBufferIsReused) {
+        int capacity;
+        char* buf = MessageBufferPool::allocate(3000, &capacity);
+        MessageBufferPool::release(buf, capacity);
+
+        int again;
+        ASSERT_EQUALS(buf, MessageBufferPool::allocate(4000, &again));
+        ASSERT_EQUALS(capacity, again);
+        MessageBufferPool::release(buf, again);
+    }
+
+    TEST(MessageBufferPoolTest, MessageResetReturnsBuffer) {
+        int capacity;
+        char* buf = MessageBufferPool::allocate(512, &capacity);
+        {
+            Message m;
+            m.setPooledData(reinterpret_cast<MsgData*>(buf), capacity);
+            Message moved(m);
+            ASSERT_TRUE(m.empty());
+        }
+
+        int again;
+        ASSERT_EQUALS(buf, MessageBufferPool::allocate(512, &again));
+        MessageBufferPool::release(buf, again);
+    }
+
+} // namespace
@@ -0,0 +1,162 @@
+// message_compression.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/util/compress.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    namespace {
+        // original opCode, uncompressed size, compressor id
+        const int compressedPrefixBytes = sizeof(int) + sizeof(int) + sizeof(signed char);
+
+        bool wireCompressionEnabled = false;
+    }
+
+    bool isWireCompressionEnabled() {
+        return wireCompressionEnabled;
+    }
+
+    void setWireCompressionEnabled(bool enabled) {
+        wireCompressionEnabled = enabled;
+    }
+
+    bool compressMessage(Message& toSend, Message* compressed) {
+        verify(compressed->empty());
+        if (toSend.size() < minCompressibleMessageBytes || toSend.operation() == dbCompressed) {
+            return false;
+        }
+
+        toSend.concat();
+        const MsgData* original = toSend.singleData();
+        const int bodyLen = original->len - MsgDataHeaderSize;
+
+        const size_t maxLen =
+            MsgDataHeaderSize + compressedPrefixBytes + maxCompressedLength(bodyLen);
+        MsgData* md = static_cast<MsgData*>(malloc(maxLen));
+        verify(md);
+
+        char* prefix = md->_data;
+        *reinterpret_cast<int*>(prefix) = original->operation();
+        *reinterpret_cast<int*>(prefix + sizeof(int)) = bodyLen;
+        prefix[2 * sizeof(int)] = snappyCompressorId;
+
+        size_t compressedLen = 0;
+        rawCompress(original->_data, bodyLen, prefix + compressedPrefixBytes, &compressedLen);
+
+        const size_t totalLen = MsgDataHeaderSize + compressedPrefixBytes + compressedLen;
+        if (totalLen >= static_cast<size_t>(original->len)) {
+            free(md);
+            return false;
+        }
+
+        md->len = totalLen;
+        md->id = original->id;
+        md->responseTo = original->responseTo;
+        md->setOperation(dbCompressed);
+        compressed->setData(md, true);
+        return true;
+    }
+
+    Status decompressMessage(const Message& received, Message* uncompressed) {
+        verify(uncompressed->empty());
+        const MsgData* md = received.singleData();
+        verify(md->operation() == dbCompressed);
+
+        const int payloadLen = md->len - MsgDataHeaderSize - compressedPrefixBytes;
+        if (payloadLen < 0) {
+            return Status(ErrorCodes::BadValue, "compressed message is too short");
+        }
+
+        const char* prefix = md->_data;
+        const int originalOp = *reinterpret_cast<const int*>(prefix);
+        const int bodyLen = *reinterpret_cast<const int*>(prefix + sizeof(int));
+        const signed char compressorId = prefix[2 * sizeof(int)];
+        const char* payload = prefix + compressedPrefixBytes;
+
+        if (compressorId != snappyCompressorId) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "unknown message compressor " << int(compressorId));
+        }
+        if (originalOp == dbCompressed) {
+            return Status(ErrorCodes::BadValue, "nested compressed message");
+        }
+        if (bodyLen < 0 || bodyLen > MaxMessageSizeBytes - MsgDataHeaderSize) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "invalid uncompressed message size " << bodyLen);
+        }
+
+        size_t actualLen = 0;
+        if (!getUncompressedLength(payload, payloadLen, &actualLen) ||
+            actualLen != static_cast<size_t>(bodyLen)) {
+            return Status(ErrorCodes::BadValue, "compressed message size mismatch");
+        }
+
+        MsgData* out = static_cast<MsgData*>(malloc(MsgDataHeaderSize + bodyLen));
+        verify(out);
+        if (!rawUncompress(payload, payloadLen, out->_data)) {
+            free(out);
+            return Status(ErrorCodes::BadValue, "corrupt compressed message");
+        }
+
+        out->len = MsgDataHeaderSize + bodyLen;
+        out->id = md->id;
+        out->responseTo = md->responseTo;
+        out->setOperation(originalOp);
+        uncompressed->setData(out, true);
+        return Status::OK();
+    }
+
+    void appendWireCompressionRequest(BSONObjBuilder* isMasterCmd) {
+        BSONArrayBuilder compressors(isMasterCmd->subarrayStart(wireCompressionFieldName));
+        compressors.append(snappyCompressorName);
+        compressors.doneFast();
+    }
+
+    bool acceptsWireCompression(const BSONObj& isMasterObj) {
+        BSONElement compressors = isMasterObj[wireCompressionFieldName];
+        if (compressors.type() != Array) {
+            return false;
+        }
+
+        BSONObjIterator it(compressors.Obj());
+        while (it.more()) {
+            BSONElement e = it.next();
+            if (e.type() == String && str::equals(e.valuestr(), snappyCompressorName)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void negotiateWireCompression(const BSONObj& isMasterCmd,
+                                  AbstractMessagingPort* port,
+                                  BSONObjBuilder* result) {
+        if (!port || !isWireCompressionEnabled() || !acceptsWireCompression(isMasterCmd)) {
+            return;
+        }
+
+        port->setCompressionEnabled(true);
+        appendWireCompressionRequest(result);
+    }
+
+} // namespace mongo
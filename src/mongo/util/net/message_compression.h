@@ -0,0 +1,92 @@
+// message_compression.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/base/status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    class AbstractMessagingPort;
+
+    /**
+     * Snappy compression of whole messages on the wire.
+     *
+     * A dbCompressed message carries another message whose body has been compressed:
+     *
+     *   MSGHEADER (opCode = dbCompressed)
+     *   int32  original opCode
+     *   int32  uncompressed body size (the original message length minus its MSGHEADER)
+     *   int8   compressor id
+     *   compressed body
+     *
+     * The requestID and responseTo of the original message are kept in the outer header.
+     *
+     * Peers agree to exchange compressed messages via isMaster: the client sends
+     * { isMaster: 1, compression: [ "snappy" ] } and the server answers with the same field if
+     * it accepts.  Any process built with this support can receive dbCompressed messages; it
+     * only sends them on ports where the peer has accepted.
+     */
+
+    const char wireCompressionFieldName[] = "compression";
+    const char snappyCompressorName[] = "snappy";
+    const signed char snappyCompressorId = 1;
+
+    // Messages smaller than this are sent as is
+    const int minCompressibleMessageBytes = 1024;
+
+    /**
+     * If true (the default for mongod and mongos) the process asks for compression when it
+     * opens a DBClientConnection and accepts it in isMaster.
+     */
+    bool isWireCompressionEnabled();
+    void setWireCompressionEnabled(bool enabled);
+
+    /**
+     * Fills 'compressed' with the dbCompressed form of 'toSend', including its header ids.
+     * Returns false, leaving 'compressed' empty, if 'toSend' is too small or does not shrink.
+     * May concatenate the buffers of 'toSend' but does not change its contents.
+     */
+    bool compressMessage(Message& toSend, Message* compressed);
+
+    /**
+     * Fills 'uncompressed' with the message carried by the dbCompressed message 'received'.
+     */
+    Status decompressMessage(const Message& received, Message* uncompressed);
+
+    /**
+     * Appends the compression request to an isMaster command object.
+     */
+    void appendWireCompressionRequest(BSONObjBuilder* isMasterCmd);
+
+    /**
+     * Returns true if the "compression" field of an isMaster command or reply lists snappy.
+     */
+    bool acceptsWireCompression(const BSONObj& isMasterObj);
+
+    /**
+     * Server side of the negotiation.  If compression is enabled and requested in
+     * 'isMasterCmd', turns it on for 'port' and advertises it in 'result'.  'port' may be NULL
+     * for direct clients, in which case nothing is done.
+     */
+    void negotiateWireCompression(const BSONObj& isMasterCmd,
+                                  AbstractMessagingPort* port,
+                                  BSONObjBuilder* result);
+
+} // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    void makeMessage(int operation, const std::string& body, Message* m) {
+        m->setData(operation, body.data(), body.size());
+        m->header()->id = 1234;
+        m->header()->responseTo = 5678;
+    }
+
+    TEST(MessageCompressionTest, RoundTrip) {
+        const std::string body(10 * 1024, 'x');
+        Message original;
+        makeMessage(opReply, body, &original);
+
+        Message compressed;
+        ASSERT_TRUE(compressMessage(original, &compressed));
+        ASSERT_EQUALS(dbCompressed, compressed.operation());
+        ASSERT_LESS_THAN(compressed.size(), original.size());
+        ASSERT_EQUALS(1234, compressed.header()->id);
+        ASSERT_EQUALS(5678, compressed.header()->responseTo);
+
+        Message uncompressed;
+        ASSERT_OK(decompressMessage(compressed, &uncompressed));
+        ASSERT_EQUALS(opReply, uncompressed.operation());
+        ASSERT_EQUALS(original.size(), uncompressed.size());
+        ASSERT_EQUALS(1234, uncompressed.header()->id);
+        ASSERT_EQUALS(5678, uncompressed.header()->responseTo);
+        ASSERT_EQUALS(body, std::string(uncompressed.singleData()->_data, body.size()));
+    }
+
+    TEST(MessageCompressionTest, SmallMessageNotCompressed) {
+        Message original;
+        makeMessage(dbQuery, std::string(100, 'x'), &original);
+        Message compressed;
+        ASSERT_FALSE(compressMessage(original, &compressed));
+        ASSERT_TRUE(compressed.empty());
+    }
+
+    TEST(MessageCompressionTest, IncompressibleMessageNotCompressed) {
+        PseudoRandom random(1);
+        std::string body;
+        for (int i = 0; i < 4096; i++) {
+            body.push_back(static_cast<char>(random.nextInt32()));
+        }
+        Message original;
+        makeMessage(opReply, body, &original);
+        Message compressed;
+        ASSERT_FALSE(compressMessage(original, &compressed));
+        ASSERT_TRUE(compressed.empty());
+    }
+
+    TEST(MessageCompressionTest, BadCompressorRejected) {
+        Message original;
+        makeMessage(opReply, std::string(4096, 'y'), &original);
+        Message compressed;
+        ASSERT_TRUE(compressMessage(original, &compressed));
+
+        // the compressor id follows the original opCode and the uncompressed size
+        compressed.singleData()->_data[2 * sizeof(int)] = 42;
+        Message uncompressed;
+        ASSERT_NOT_OK(decompressMessage(compressed, &uncompressed));
+        ASSERT_TRUE(uncompressed.empty());
+    }
+
+    TEST(MessageCompressionTest, BadSizeRejected) {
+        Message original;
+        makeMessage(opReply, std::string(4096, 'y'), &original);
+        Message compressed;
+        ASSERT_TRUE(compressMessage(original, &compressed));
+
+        reinterpret_cast<int*>(compressed.singleData()->_data)[1] = 4095;
+        Message uncompressed;
+        ASSERT_NOT_OK(decompressMessage(compressed, &uncompressed));
+    }
+
+    TEST(MessageCompressionTest, Negotiation) {
+        BSONObjBuilder cmd;
+        cmd.append("isMaster", 1);
+        appendWireCompressionRequest(&cmd);
+        ASSERT_TRUE(acceptsWireCompression(cmd.obj()));
+
+        ASSERT_FALSE(acceptsWireCompression(BSON("isMaster" << 1)));
+        ASSERT_FALSE(acceptsWireCompression(BSON("compression" << "snappy")));
+        ASSERT_FALSE(acceptsWireCompression(BSON("compression" << BSON_ARRAY("zlib"))));
+        ASSERT_TRUE(acceptsWireCompression(BSON("compression" << BSON_ARRAY("zlib" << "snappy"))));
+    }
+
+} // namespace
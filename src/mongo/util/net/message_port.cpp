@@ -26,6 +26,7 @@
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/time_support.h"
@@ -201,11 +202,12 @@ again:
             }
  
             psock->setHandshakeReceived();
-            int z = (len+1023)&0xfffffc00;
-            verify(z>=len);
-            MsgData *md = (MsgData *) malloc(z);
-            ScopeGuard guard = MakeGuard(free, md);
-            verify(md);
+            int capacity;
+            char *buf = MessageBufferPool::allocate(len, &capacity);
+            verify(buf);
+            verify(capacity>=len);
+            ScopeGuard guard = MakeGuard(MessageBufferPool::release, buf, capacity);
+            MsgData *md = (MsgData *) buf;
 
             memcpy(md, &header, headerLen);
             int left = len - headerLen;
@@ -213,7 +215,19 @@ again:
             psock->recv( (char *)&md->_data, left );
 
             guard.Dismiss();
-            m.setData(md, true);
+            m.setPooledData(md, capacity);
+
+            if ( m.operation() == dbCompressed ) {
+                Message uncompressed;
+                Status status = decompressMessage( m, &uncompressed );
+                m.reset();
+                if ( !status.isOK() ) {
+                    LOG(0) << "recv(): bad compressed message from " << remote() << ": "
+                           << status.toString() << endl;
+                    return false;
+                }
+                m = uncompressed;
+            }
             return true;
 
         }
@@ -284,6 +298,14 @@ again:
             }
         }
 
+        if ( compressionEnabled() ) {
+            Message compressed;
+            if ( compressMessage( toSend, &compressed ) ) {
+                compressed.send( *this, "say" );
+                return;
+            }
+        }
+
         toSend.send( *this, "say" );
     }
 
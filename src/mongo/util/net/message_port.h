@@ -31,7 +31,7 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0), _connectionId(0) {}
+        AbstractMessagingPort() : tag(0), _connectionId(0), _compressionEnabled(false) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
@@ -52,6 +52,13 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * Set once the remote end has agreed to receive dbCompressed messages, after which
+         * large messages sent on this port are compressed.
+         */
+        bool compressionEnabled() const { return _compressionEnabled; }
+        void setCompressionEnabled( bool enabled ) { _compressionEnabled = enabled; }
+
     public:
         // TODO make this private with some helpers
 
@@ -61,6 +68,7 @@ namespace mongo {
     private:
         long long _connectionId;
         std::string _x509SubjectName;
+        bool _compressionEnabled;
     };
 
     class MessagingPort : public AbstractMessagingPort {
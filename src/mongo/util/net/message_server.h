@@ -28,6 +28,19 @@ namespace mongo {
 
     struct LastError;
 
+    /**
+     * The thread-local state of a connection (e.g. its Client) while the connection is not
+     * being served by any thread.  See MessageHandler::park().
+     */
+    class ParkedConnectionState {
+    public:
+        /** Deletes the parked state if it was never resumed (i.e. the connection has closed). */
+        virtual ~ParkedConnectionState() {}
+
+        /** Installs the state on the calling thread, which then owns it again. */
+        virtual void resume() = 0;
+    };
+
     class MessageHandler {
     public:
         virtual ~MessageHandler() {}
@@ -47,6 +60,19 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * true if this handler implements park(), so that its connections can be served by a
+         * pool of threads rather than one thread each
+         */
+        virtual bool supportsParking() const { return false; }
+
+        /**
+         * Called after connected(), process() or disconnected() returns when connections are
+         * served by a pool of threads.  Moves all of this connection's thread-local state off
+         * the calling thread, which may next serve a different connection.
+         */
+        virtual ParkedConnectionState* park( AbstractMessagingPort* p ) { return NULL; }
     };
 
     class MessageServer {
@@ -54,8 +80,10 @@ namespace mongo {
         struct Options {
             int port;                   // port to bind to
             string ipList;             // addresses to bind to
+            bool pooled;               // serve connections on a fixed pool of threads (linux)
+            int poolThreads;           // size of that pool, 0 for a default based on the cores
 
-            Options() : port(0), ipList("") {}
+            Options() : port(0), ipList(""), pooled(false), poolThreads(0) {}
         };
 
         virtual ~MessageServer() {}
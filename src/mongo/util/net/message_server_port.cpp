@@ -17,11 +17,16 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <deque>
 
 #ifndef USE_ASIO
 
 
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/concurrency/ticketholder.h"
@@ -33,6 +38,7 @@
 #include "mongo/util/net/ssl_manager.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
+# include <sys/epoll.h>
 # include <sys/resource.h>
 #endif
 
@@ -244,7 +250,406 @@ namespace mongo {
     };
 
 
+#ifdef __linux__
+    /**
+     * Serves connections on a fixed pool of worker threads instead of one thread each.
+     *
+     * Idle connections are parked: their thread-local state is detached by
+     * MessageHandler::park() and their socket waits in an epoll set, so they cost no thread.
+     * When a socket becomes readable a worker resumes the connection's state, reads and
+     * processes one message, and parks the connection again.
+     *
+     * A worker is busy for the whole of a request, including any time it blocks on locks, a
+     * slow client or write concern.  Connections whose requests wait for data by design
+     * (awaitData tailing such as secondaries reading the oplog, and mongos writebacklisten) are
+     * moved to a thread of their own before such a request is processed, so they can't pin the
+     * pool.
+     */
+    class PooledPortMessageServer : public MessageServer , public Listener {
+    public:
+        PooledPortMessageServer( const MessageServer::Options& opts, MessageHandler * handler ) :
+            Listener( "" , opts.ipList, opts.port ),
+            _handler(handler),
+            _numWorkers(opts.poolThreads),
+            _epollFd(-1) {
+
+            if ( _numWorkers <= 0 ) {
+                _numWorkers = std::max( 8u , 2 * boost::thread::hardware_concurrency() );
+            }
+        }
+
+        virtual void acceptedMP(MessagingPort * p) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << Listener::globalTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            p->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            schedule( new Connection(p) );
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            _epollFd = epoll_create(1024);
+            if ( _epollFd < 0 ) {
+                int x = errno;
+                error() << "epoll_create failed: " << errnoWithDescription(x) << endl;
+                fassertFailed(17185);
+            }
+
+            log() << "serving connections with " << _numWorkers << " worker threads" << endl;
+            for ( int i = 0; i < _numWorkers; i++ ) {
+                boost::thread worker( boost::bind( &PooledPortMessageServer::workerThread, this, i ) );
+            }
+            boost::thread poller( boost::bind( &PooledPortMessageServer::pollerThread, this ) );
+
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        struct Connection {
+            explicit Connection( MessagingPort* p ) :
+                port(p), lastError(new LastError()), parked(NULL), connected(false),
+                registered(false), otherSide(p->psock->remoteString()) {
+            }
+
+            ~Connection() {
+                delete parked;
+                delete lastError;
+                delete port;
+            }
+
+            MessagingPort* port;
+            LastError* lastError;
+            ParkedConnectionState* parked; // NULL while a worker serves the connection
+            bool connected;                // MessageHandler::connected() has been called
+            bool registered;               // the socket has been added to the epoll set
+            std::string otherSide;
+        };
+
+        void schedule( Connection* c ) {
+            boost::unique_lock<boost::mutex> lk( _mutex );
+            _ready.push_back( c );
+            _readyCondition.notify_one();
+        }
+
+        Connection* next() {
+            boost::unique_lock<boost::mutex> lk( _mutex );
+            while ( _ready.empty() ) {
+                if ( inShutdown() ) {
+                    return NULL;
+                }
+                _readyCondition.timed_wait( lk, boost::posix_time::seconds(1) );
+            }
+            Connection* c = _ready.front();
+            _ready.pop_front();
+            return c;
+        }
+
+        /**
+         * Waits for parked connections to become readable and hands them to the workers.
+         * Sockets are registered EPOLLONESHOT, so a connection is handed out once until a
+         * worker re-arms it.
+         */
+        void pollerThread() {
+            setThreadName( "connPoller" );
+            const int maxEvents = 256;
+            epoll_event events[maxEvents];
+            while ( ! inShutdown() ) {
+                int n = epoll_wait( _epollFd, events, maxEvents, 1000 );
+                if ( n < 0 ) {
+                    int x = errno;
+                    if ( x != EINTR ) {
+                        error() << "epoll_wait failed: " << errnoWithDescription(x) << endl;
+                        sleepmillis(10);
+                    }
+                    continue;
+                }
+                for ( int i = 0; i < n; i++ ) {
+                    schedule( static_cast<Connection*>( events[i].data.ptr ) );
+                }
+            }
+        }
+
+        void workerThread( int workerId ) {
+            string threadName = str::stream() << "connWorker" << workerId;
+            setThreadName( threadName.c_str() );
+            while ( Connection* c = next() ) {
+                switch ( serve(c) ) {
+                case SERVE_OPEN:
+                    if ( park(c) ) {
+                        continue;
+                    }
+                    break;
+                case SERVE_CLOSED:
+                    break;
+                case SERVE_DEDICATED:
+                    continue; // the connection's own thread cleans up after it
+                }
+                delete c;
+                Listener::globalTicketHolder.release();
+            }
+        }
+
+        enum ServeResult {
+            SERVE_OPEN,      // wait for the connection's next message
+            SERVE_CLOSED,    // disconnected() has been called
+            SERVE_DEDICATED  // the connection has moved to a thread of its own
+        };
+
+        /**
+         * Runs the connection's next piece of work on this thread: connected() for a new
+         * connection, otherwise one incoming message.  A message that may wait for data
+         * indefinitely is handed to a new thread along with the connection instead.
+         */
+        ServeResult serve( Connection* c ) {
+            MessagingPort* p = c->port;
+            resume(c);
+
+            auto_ptr<Message> m( new Message() );
+            bool blocking = false;
+            bool open = handle( c , m.get() , &blocking );
+
+            if ( open && blocking ) {
+                detach(c);
+                if ( dedicate( c , m.get() ) ) {
+                    m.release();
+                    return SERVE_DEDICATED;
+                }
+                resume(c);
+                open = handle( c , m.get() , NULL );
+            }
+
+            if ( ! open ) {
+                p->shutdown();
+                _handler->disconnected( p );
+            }
+
+            detach(c);
+            return open ? SERVE_OPEN : SERVE_CLOSED;
+        }
+
+        /**
+         * Calls connected() for a new connection.  Otherwise, if 'blocking' is set, receives the
+         * next message into 'm' and, when the message may wait for data indefinitely, sets
+         * *blocking and leaves it unprocessed.  Then processes 'm'.
+         *
+         * Returns false once the connection is to be closed.
+         */
+        bool handle( Connection* c , Message* m , bool* blocking ) {
+            MessagingPort* p = c->port;
+            try {
+                if ( ! c->connected ) {
+                    c->connected = true;
+                    _handler->connected( p );
+                    return true;
+                }
+
+                if ( blocking ) {
+                    m->reset();
+                    p->psock->clearCounters();
+                    if ( ! p->recv(*m) ) {
+                        if (!serverGlobalParams.quiet) {
+                            int conns = Listener::globalTicketHolder.used()-1;
+                            const char* word = (conns == 1 ? " connection" : " connections");
+                            log() << "end connection " << c->otherSide << " (" << conns << word << " now open)" << endl;
+                        }
+                        return false;
+                    }
+                    if ( waitsForData(*m) ) {
+                        *blocking = true;
+                        return true;
+                    }
+                }
+
+                _handler->process( *m , p , c->lastError );
+                networkCounter.hit( p->psock->getBytesIn() , p->psock->getBytesOut() );
+                return true;
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            catch ( ... ) {
+                error() << "Uncaught exception, terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            return false;
+        }
+
+        /**
+         * True for requests that wait for data that may never come: queries for awaitData
+         * cursors (whose getmores then block), getmores on the oplog and writebacklisten.
+         * Once a connection issues one it is likely to keep doing so.
+         */
+        static bool waitsForData( Message& m ) {
+            try {
+                if ( m.operation() == dbGetMore ) {
+                    DbMessage d(m);
+                    return str::startsWith( d.getns() , "local.oplog." );
+                }
+                if ( m.operation() != dbQuery ) {
+                    return false;
+                }
+
+                DbMessage d(m);
+                QueryMessage q(d);
+                if ( q.queryOptions & QueryOption_AwaitData ) {
+                    return true;
+                }
+                return str::endsWith( q.ns , ".$cmd" ) &&
+                       str::equals( q.query.firstElementFieldName() , "writebacklisten" );
+            }
+            catch ( DBException& ) {
+                // malformed; processing the message reports the error
+                return false;
+            }
+        }
+
+        /**
+         * Moves the connection, whose state is detached, to a thread of its own that starts by
+         * processing 'm'.  Returns false if no thread could be started.
+         */
+        bool dedicate( Connection* c , Message* m ) {
+            try {
+                boost::thread thr( boost::bind( &PooledPortMessageServer::dedicatedThread,
+                                                this , c , m ) );
+                return true;
+            }
+            catch ( boost::thread_resource_error& ) {
+                log() << "can't create a thread for " << c->otherSide
+                      << ", serving it from the pool" << endl;
+                return false;
+            }
+        }
+
+        /**
+         * Serves the connection thread-per-connection style until it closes, starting with
+         * 'first'.  Its socket is no longer watched.
+         */
+        void dedicatedThread( Connection* c , Message* first ) {
+            auto_ptr<Message> m( first );
+            resume(c);
+
+            if ( c->registered ) {
+                epoll_event unused; // must be non-NULL before linux 2.6.9
+                epoll_ctl( _epollFd, EPOLL_CTL_DEL, c->port->psock->rawFD(), &unused );
+                c->registered = false;
+            }
+
+            bool open = handle( c , m.get() , NULL );
+            while ( open && ! inShutdown() ) {
+                bool blocking = false;
+                open = handle( c , m.get() , &blocking );
+                if ( open && blocking ) {
+                    open = handle( c , m.get() , NULL );
+                }
+            }
+
+            c->port->shutdown();
+            _handler->disconnected( c->port );
+
+            // c owns the LastError, and this thread's other state goes with the thread
+            lastError.release();
+            delete c;
+            Listener::globalTicketHolder.release();
+        }
+
+        /**
+         * Waits for the connection's next message.  Returns false, after disconnecting the
+         * connection, if its socket cannot be watched.
+         */
+        bool park( Connection* c ) {
+            epoll_event event;
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            event.data.ptr = c;
+
+            // once the socket is armed another worker may pick up the connection
+            const int op = c->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            c->registered = true;
+            if ( epoll_ctl( _epollFd, op, c->port->psock->rawFD(), &event ) == 0 ) {
+                return true;
+            }
+
+            int x = errno;
+            log() << "can't watch connection " << c->otherSide << ", closing it: " << errnoWithDescription(x) << endl;
+            resume(c);
+            c->port->shutdown();
+            _handler->disconnected( c->port );
+            detach(c);
+            return false;
+        }
+
+        void resume( Connection* c ) {
+            lastError.reset( c->lastError );
+            if ( c->parked ) {
+                c->parked->resume();
+                delete c->parked;
+                c->parked = NULL;
+            }
+
+            string threadName = "conn";
+            if ( c->port->connectionId() > 0 )
+                threadName = str::stream() << threadName << c->port->connectionId();
+            setThreadName( threadName.c_str() );
+        }
+
+        void detach( Connection* c ) {
+            c->parked = _handler->park( c->port );
+            lastError.release();
+        }
+
+        MessageHandler* _handler;
+        int _numWorkers;
+        int _epollFd;
+
+        // connections ready for a worker
+        boost::mutex _mutex;
+        boost::condition_variable _readyCondition;
+        std::deque<Connection*> _ready;
+    };
+#endif
+
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#ifdef __linux__
+        if ( opts.pooled ) {
+            if ( ! handler->supportsParking() ) {
+                warning() << "this server can't serve connections on a pool of threads, "
+                          << "using a thread per connection" << endl;
+            }
+#ifdef MONGO_SSL
+            else if ( getSSLManager() ) {
+                // OpenSSL may hold decrypted bytes that epoll cannot see
+                warning() << "a pool of connection threads is not supported with SSL, "
+                          << "using a thread per connection" << endl;
+            }
+#endif
+            else {
+                return new PooledPortMessageServer( opts , handler );
+            }
+        }
+#endif
         return new PortMessageServer( opts , handler );
     }
 
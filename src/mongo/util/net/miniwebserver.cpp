@@ -26,7 +26,7 @@
 namespace mongo {
 
     MiniWebServer::MiniWebServer(const string& name, const string &ip, int port)
-        : Listener(name, ip, port, false)
+        : Listener(name, ip, port, false), _workers(numWorkerThreads)
     {}
 
     string MiniWebServer::parseURL( const char * buf ) {
@@ -111,6 +111,16 @@ namespace mongo {
     }
 
     void MiniWebServer::accepted(boost::shared_ptr<Socket> psock, long long connectionId ) {
+        if ( _workers.tasks_remaining() >= numWorkerThreads + maxQueuedRequests ) {
+            LOG(1) << "too many queued http requests, closing connection from "
+                   << psock->remoteString() << endl;
+            psock->close();
+            return;
+        }
+        _workers.schedule( &MiniWebServer::_serve, this, psock );
+    }
+
+    void MiniWebServer::_serve(boost::shared_ptr<Socket> psock) {
         char buf[4096];
         int len = 0;
         try {
@@ -20,14 +20,25 @@
 #include "mongo/pch.h"
 
 #include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/net/message_port.h"
 
 namespace mongo {
 
+    /**
+     * Accepts connections on the listener thread and serves each request on one of a fixed
+     * number of worker threads, so that a slow client does not hold up the others.  doRequest
+     * may therefore be called from several threads at once.
+     */
     class MiniWebServer : public Listener {
     public:
+        static const int numWorkerThreads = 4;
+
+        // connections waiting for a worker beyond this are closed without a response
+        static const int maxQueuedRequests = 64;
+
         MiniWebServer(const string& name, const string &ip, int _port);
         virtual ~MiniWebServer() {}
 
@@ -55,7 +66,10 @@ namespace mongo {
 
     private:
         void accepted(boost::shared_ptr<Socket> psocket, long long connectionId );
+        void _serve(boost::shared_ptr<Socket> psocket);
         static bool fullReceive( const char *buf );
+
+        ThreadPool _workers;
     };
 
 } // namespace mongo
@@ -19,6 +19,7 @@
 
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -199,6 +200,15 @@ namespace mongo {
         private:
             SSL_CTX* _serverContext;  // SSL context for incoming connections
             SSL_CTX* _clientContext;  // SSL context for outgoing connections
+
+            // Last session negotiated with each remote "ip:port", offered again by connect()
+            // so that new outgoing connections can skip the full handshake
+            typedef std::map<std::string, SSL_SESSION*> SessionMap;
+            SessionMap _clientSessions;
+            mongo::mutex _clientSessionsMutex;
+
+            SSL_SESSION* _getClientSession(const std::string& remote);
+            void _setClientSession(const std::string& remote, SSL_SESSION* session);
             std::string _password;
             bool _validateCertificates;
             bool _weakValidation;
@@ -357,6 +367,7 @@ namespace mongo {
     SSLManagerInterface::~SSLManagerInterface() {}
 
     SSLManager::SSLManager(const Params& params, bool isServer) :
+        _clientSessionsMutex("SSLManager::clientSessions"),
         _validateCertificates(false),
         _weakValidation(params.weakCertificateValidation) {
 
@@ -422,6 +433,9 @@ namespace mongo {
         if (NULL != _clientContext) {
             SSL_CTX_free(_clientContext);
         }
+        for (SessionMap::iterator i = _clientSessions.begin(); i != _clientSessions.end(); ++i) {
+            SSL_SESSION_free(i->second);
+        }
     }
 
     int SSLManager::password_cb(char *buf,int num, int rwflag,void *userdata) {
@@ -511,18 +525,34 @@ namespace mongo {
         // SSL_OP_NO_SSLv2 - Disable SSL v2 support 
         SSL_CTX_set_options(*context, SSL_OP_ALL|SSL_OP_NO_SSLv2);
 
+        // SSL_OP_CIPHER_SERVER_PREFERENCE - Pick the cipher by our order, not the client's
+        SSL_CTX_set_options(*context, SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+        // AESGCM - Prefer AES-GCM, which OpenSSL runs on AES-NI where the CPU has it
         // HIGH - Enable strong ciphers
         // !EXPORT - Disable export ciphers (40/56 bit) 
         // !aNULL - Disable anonymous auth ciphers
-        // @STRENGTH - Sort ciphers based on strength 
-        SSL_CTX_set_cipher_list(*context, "HIGH:!EXPORT:!aNULL@STRENGTH");
+        // @STRENGTH - Sort ciphers based on strength, keeping AES-GCM first within a strength
+        SSL_CTX_set_cipher_list(*context, "AESGCM:HIGH:!EXPORT:!aNULL@STRENGTH");
 
         // If renegotiation is needed, don't return from recv() or send() until it's successful.
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
-        // Disable session caching (see SERVER-10261)
-        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        if (context == &_serverContext) {
+            // Resuming a session requires a session id context when peer certificates are
+            // requested; without one the resumed handshake fails (SERVER-10261).  Sessions
+            // can be resumed from the server cache or from a ticket held by the client.
+            static const unsigned char sessionIdContext[] = "mongodb";
+            SSL_CTX_set_session_id_context(*context,
+                                           sessionIdContext,
+                                           sizeof(sessionIdContext) - 1);
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_SERVER);
+        }
+        else {
+            // Outgoing sessions are kept per remote host by connect() instead
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        }
  
         // Use the clusterfile for internal outgoing SSL connections if specified 
         if (context == &_clientContext && !params.clusterfile.empty()) {
@@ -716,18 +746,56 @@ namespace mongo {
         }
     }
 
+    SSL_SESSION* SSLManager::_getClientSession(const std::string& remote) {
+        scoped_lock lk(_clientSessionsMutex);
+        SessionMap::const_iterator i = _clientSessions.find(remote);
+        if (i == _clientSessions.end())
+            return NULL;
+        // the caller gets its own reference
+        CRYPTO_add(&i->second->references, 1, CRYPTO_LOCK_SSL_SESSION);
+        return i->second;
+    }
+
+    void SSLManager::_setClientSession(const std::string& remote, SSL_SESSION* session) {
+        SSL_SESSION* old = NULL;
+        {
+            scoped_lock lk(_clientSessionsMutex);
+            SSL_SESSION*& stored = _clientSessions[remote];
+            old = stored;
+            stored = session;
+            if (NULL == session)
+                _clientSessions.erase(remote);
+        }
+        if (NULL != old)
+            SSL_SESSION_free(old);
+    }
+
     SSLConnection* SSLManager::connect(Socket* socket) {
         SSLConnection* sslConn = new SSLConnection(_clientContext, socket, NULL, 0);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
+
+        const std::string remote = socket->remoteString();
+        SSL_SESSION* session = _getClientSession(remote);
+        if (NULL != session) {
+            SSL_set_session(sslConn->ssl, session);
+            SSL_SESSION_free(session);
+        }
  
         int ret;
         do {
             ret = ::SSL_connect(sslConn->ssl);
         } while(!_doneWithSSLOp(sslConn, ret));
  
-        if (ret != 1)
+        if (ret != 1) {
+            // don't offer a session again that may be why this failed
+            _setClientSession(remote, NULL);
             _handleSSLError(SSL_get_error(sslConn, ret));
+        }
+
+        if (!SSL_session_reused(sslConn->ssl)) {
+            _setClientSession(remote, SSL_get1_session(sslConn->ssl));
+        }
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
@@ -46,8 +46,11 @@ namespace mongo {
         if ( firstEmpty )
             *firstEmpty = -1;
 
-        for ( unsigned probe = 0; probe < _maxProbe; probe++ ) {
-            unsigned pos = (hash + probe) % _capacity;
+        // only the first position needs a division; later probes just step and wrap
+        unsigned pos = hash % _capacity;
+        for ( unsigned probe = 0; probe < _maxProbe; probe++, pos++ ) {
+            if ( pos == _capacity )
+                pos = 0;
 
             if ( ! _entries[pos].used ) {
                 // space is empty